@@ -639,6 +639,8 @@ struct agent_pvt {
 
 	/*! Caller is waiting in this bridge for agent to join. (Holds ref) */
 	struct ast_bridge *caller_bridge;
+	/*! Pristine caller bridge parked for the next AgentRequest. (Holds ref) */
+	struct ast_bridge *fresh_caller_bridge;
 	/*! Agent is logged in with this channel. (Holds ref) (NULL if not logged in.) */
 	struct ast_channel *logged;
 	/*! Active config values from config file. (Holds ref) */
@@ -765,6 +767,10 @@ static void agent_pvt_destructor(void *vdoomed)
 		ast_bridge_destroy(doomed->caller_bridge, 0);
 		doomed->caller_bridge = NULL;
 	}
+	if (doomed->fresh_caller_bridge) {
+		ast_bridge_destroy(doomed->fresh_caller_bridge, 0);
+		doomed->fresh_caller_bridge = NULL;
+	}
 	if (doomed->logged) {
 		doomed->logged = ast_channel_unref(doomed->logged);
 	}
@@ -1451,6 +1457,79 @@ static void send_agent_logoff(struct ast_channel *chan, const char *agent, long
 	ast_channel_publish_blob(chan, ast_channel_agent_logoff_type(), blob);
 }
 
+/*!
+ * \internal
+ * \brief Take the caller bridge parked on the agent if there is one.
+ *
+ * \param agent Which agent to take the parked bridge from.
+ *
+ * \retval bridge on success.  (Ref transferred to the caller.)
+ * \retval NULL if no bridge is parked.
+ */
+static struct ast_bridge *agent_fresh_bridge_take(struct agent_pvt *agent)
+{
+	struct ast_bridge *bridge;
+
+	agent_lock(agent);
+	bridge = agent->fresh_caller_bridge;
+	agent->fresh_caller_bridge = NULL;
+	agent_unlock(agent);
+	return bridge;
+}
+
+/*!
+ * \internal
+ * \brief Park an unused caller bridge on the agent for the next AgentRequest.
+ *
+ * \param agent Which agent to park the bridge on.
+ * \param bridge The bridge to park.  (Ref transferred.)  It must never
+ * have had a channel join it so the basic bridge personality is still
+ * pristine.
+ *
+ * \note The bridge is destroyed instead if the agent already has a
+ * parked bridge or is no longer logged in.
+ */
+static void agent_fresh_bridge_park(struct agent_pvt *agent, struct ast_bridge *bridge)
+{
+	agent_lock(agent);
+	if (!agent->fresh_caller_bridge && agent->logged) {
+		agent->fresh_caller_bridge = bridge;
+		bridge = NULL;
+	}
+	agent_unlock(agent);
+	if (bridge) {
+		ast_bridge_destroy(bridge, 0);
+	}
+}
+
+/*!
+ * \internal
+ * \brief Pre-create a caller bridge for the agent's next call.
+ *
+ * \param agent Which agent to prime.
+ *
+ * \details
+ * Called off the caller hot path while the agent idles in the holding
+ * bridge so AgentRequest does not have to pay for bridge creation when
+ * a call does show up.
+ */
+static void agent_fresh_bridge_prime(struct agent_pvt *agent)
+{
+	struct ast_bridge *bridge;
+
+	agent_lock(agent);
+	if (agent->fresh_caller_bridge) {
+		agent_unlock(agent);
+		return;
+	}
+	agent_unlock(agent);
+
+	bridge = ast_bridge_basic_new();
+	if (bridge) {
+		agent_fresh_bridge_park(agent, bridge);
+	}
+}
+
 /*!
  * \internal
  * \brief Logout the agent.
@@ -1464,6 +1543,7 @@ static void agent_logout(struct agent_pvt *agent)
 {
 	struct ast_channel *logged;
 	struct ast_bridge *caller_bridge;
+	struct ast_bridge *fresh_bridge;
 	long time_logged_in;
 
 	time_logged_in = time(NULL) - agent->login_start;
@@ -1471,6 +1551,8 @@ static void agent_logout(struct agent_pvt *agent)
 	agent->logged = NULL;
 	caller_bridge = agent->caller_bridge;
 	agent->caller_bridge = NULL;
+	fresh_bridge = agent->fresh_caller_bridge;
+	agent->fresh_caller_bridge = NULL;
 	agent->state = AGENT_STATE_LOGGED_OUT;
 	agent->devstate = AST_DEVICE_UNAVAILABLE;
 	ast_clear_flag(agent, AST_FLAGS_ALL);
@@ -1480,6 +1562,9 @@ static void agent_logout(struct agent_pvt *agent)
 	if (caller_bridge) {
 		ast_bridge_destroy(caller_bridge, 0);
 	}
+	if (fresh_bridge) {
+		ast_bridge_destroy(fresh_bridge, 0);
+	}
 
 	ast_channel_lock(logged);
 	send_agent_logoff(logged, agent->username, time_logged_in);
@@ -1521,6 +1606,9 @@ static void agent_run(struct agent_pvt *agent, struct ast_channel *logged)
 			break;
 		}
 
+		/* Get the next caller bridge ready while the agent is idle. */
+		agent_fresh_bridge_prime(agent);
+
 		/*
 		 * When the agent channel leaves the bridging system we usually
 		 * want to put the agent back into the holding bridge for the
@@ -1901,6 +1989,30 @@ static int agent_request_exec(struct ast_channel *chan, const char *data)
 		return 0;
 	}
 
+	/*
+	 * Fail fast if the agent cannot take the call right now.  The
+	 * status is checked again under lock after the request is set up,
+	 * but high volume dialers probe busy agents constantly and should
+	 * not pay for hooks and a bridge just to find that out.
+	 */
+	agent_lock(agent);
+	switch (agent->state) {
+	case AGENT_STATE_LOGGED_OUT:
+	case AGENT_STATE_LOGGING_OUT:
+		agent_unlock(agent);
+		ast_verb(3, "Agent '%s' not logged in.\n", agent->username);
+		pbx_builtin_setvar_helper(chan, "AGENT_STATUS", "NOT_LOGGED_IN");
+		return 0;
+	case AGENT_STATE_READY_FOR_CALL:
+		break;
+	default:
+		agent_unlock(agent);
+		ast_verb(3, "Agent '%s' is busy.\n", agent->username);
+		pbx_builtin_setvar_helper(chan, "AGENT_STATUS", "BUSY");
+		return 0;
+	}
+	agent_unlock(agent);
+
 	if (ast_bridge_features_init(&caller_features)) {
 		return -1;
 	}
@@ -1923,10 +2035,14 @@ static int agent_request_exec(struct ast_channel *chan, const char *data)
 		return -1;
 	}
 
-	caller_bridge = ast_bridge_basic_new();
+	/* Use the caller bridge primed while the agent idled if we can. */
+	caller_bridge = agent_fresh_bridge_take(agent);
 	if (!caller_bridge) {
-		ast_bridge_features_cleanup(&caller_features);
-		return -1;
+		caller_bridge = ast_bridge_basic_new();
+		if (!caller_bridge) {
+			ast_bridge_features_cleanup(&caller_features);
+			return -1;
+		}
 	}
 
 	agent_lock(agent);
@@ -1934,7 +2050,7 @@ static int agent_request_exec(struct ast_channel *chan, const char *data)
 	case AGENT_STATE_LOGGED_OUT:
 	case AGENT_STATE_LOGGING_OUT:
 		agent_unlock(agent);
-		ast_bridge_destroy(caller_bridge, 0);
+		agent_fresh_bridge_park(agent, caller_bridge);
 		ast_bridge_features_cleanup(&caller_features);
 		ast_verb(3, "Agent '%s' not logged in.\n", agent->username);
 		pbx_builtin_setvar_helper(chan, "AGENT_STATUS", "NOT_LOGGED_IN");
@@ -1947,7 +2063,7 @@ static int agent_request_exec(struct ast_channel *chan, const char *data)
 		break;
 	default:
 		agent_unlock(agent);
-		ast_bridge_destroy(caller_bridge, 0);
+		agent_fresh_bridge_park(agent, caller_bridge);
 		ast_bridge_features_cleanup(&caller_features);
 		ast_verb(3, "Agent '%s' is busy.\n", agent->username);
 		pbx_builtin_setvar_helper(chan, "AGENT_STATUS", "BUSY");
@@ -855,6 +855,85 @@ static int channel_spy(struct ast_channel *chan, struct ast_autochan *spyee_auto
 	return running;
 }
 
+/*!
+ * \brief Index of spyable channel names fed from channel snapshots.
+ *
+ * Scanning for spy targets by channel name prefix used to walk the
+ * whole channel container with per-channel locking.  The rbtree keeps
+ * the names sorted, so a prefix scan only visits the matching range,
+ * which matters when a supervisor attaches to one of thousands of
+ * active calls.
+ */
+static struct ao2_container *spyable_channels;
+
+/*! \brief Subscription feeding spyable_channels from channel snapshots */
+static struct stasis_subscription *channel_snapshot_sub;
+
+struct spyable_channel {
+	char name[0];
+};
+
+static int spyable_channel_sort_fn(const void *obj_left, const void *obj_right, int flags)
+{
+	const struct spyable_channel *left = obj_left;
+	const struct spyable_channel *right = obj_right;
+	const char *right_key = obj_right;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_OBJECT:
+		right_key = right->name;
+		/* Fall through */
+	case OBJ_SEARCH_KEY:
+		return strcmp(left->name, right_key);
+	case OBJ_SEARCH_PARTIAL_KEY:
+		return strncmp(left->name, right_key, strlen(right_key));
+	default:
+		/* Sort can only work on something with a full or partial key. */
+		ast_assert(0);
+		return 0;
+	}
+}
+
+static void spyable_channel_add(const char *name)
+{
+	struct spyable_channel *entry;
+
+	entry = ao2_alloc_options(sizeof(*entry) + strlen(name) + 1, NULL,
+		AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!entry) {
+		return;
+	}
+	strcpy(entry->name, name); /* Safe */
+	ao2_link(spyable_channels, entry);
+	ao2_ref(entry, -1);
+}
+
+static void spyable_channel_remove(const char *name)
+{
+	ao2_find(spyable_channels, name, OBJ_SEARCH_KEY | OBJ_UNLINK | OBJ_NODATA);
+}
+
+static void channel_snapshot_update_cb(void *data, struct stasis_subscription *sub,
+	struct stasis_message *message)
+{
+	struct ast_channel_snapshot_update *update;
+
+	if (stasis_message_type(message) != ast_channel_snapshot_type()) {
+		return;
+	}
+	update = stasis_message_data(message);
+
+	if (ast_test_flag(&update->new_snapshot->flags, AST_FLAG_DEAD)) {
+		spyable_channel_remove(update->new_snapshot->base->name);
+	} else if (!update->old_snapshot) {
+		spyable_channel_add(update->new_snapshot->base->name);
+	} else if (strcmp(update->old_snapshot->base->name, update->new_snapshot->base->name)) {
+		/* Renamed by a masquerade. */
+		spyable_channel_remove(update->old_snapshot->base->name);
+		spyable_channel_add(update->new_snapshot->base->name);
+	}
+}
+
 static struct ast_autochan *next_channel(struct ast_channel_iterator *iter,
 	struct ast_channel *chan)
 {
@@ -880,6 +959,57 @@ static struct ast_autochan *next_channel(struct ast_channel_iterator *iter,
 	return NULL;
 }
 
+/*!
+ * \internal
+ * \brief Fetch the next spy target from an index prefix scan.
+ *
+ * Index entries only carry the channel name; the channel itself is
+ * fetched by name, which is a hash lookup instead of a container walk.
+ */
+static struct ast_autochan *next_indexed_channel(struct ao2_iterator *spy_iter,
+	struct ast_channel *chan)
+{
+	struct spyable_channel *entry;
+	struct ast_autochan *autochan_store;
+	const size_t pseudo_len = strlen("DAHDI/pseudo");
+
+	while ((entry = ao2_iterator_next(spy_iter))) {
+		struct ast_channel *next = ast_channel_get_by_name(entry->name);
+
+		ao2_ref(entry, -1);
+		if (!next) {
+			/* The channel went away since the scan started. */
+			continue;
+		}
+		if (!strncmp(ast_channel_name(next), "DAHDI/pseudo", pseudo_len)
+			|| next == chan) {
+			ast_channel_unref(next);
+			continue;
+		}
+
+		autochan_store = ast_autochan_setup(next);
+		ast_channel_unref(next);
+
+		return autochan_store;
+	}
+	return NULL;
+}
+
+/*!
+ * \internal
+ * \brief Dispose of whichever target scan is active.
+ */
+static void scan_destroy(struct ast_channel_iterator **iter, struct ao2_iterator **spy_iter)
+{
+	if (*iter) {
+		*iter = ast_channel_iterator_destroy(*iter);
+	}
+	if (*spy_iter) {
+		ao2_iterator_destroy(*spy_iter);
+		*spy_iter = NULL;
+	}
+}
+
 static int spy_sayname(struct ast_channel *chan, const char *mailbox, const char *context)
 {
 	char *mailbox_id;
@@ -901,6 +1031,7 @@ static int common_exec(struct ast_channel *chan, struct ast_flags *flags,
 	int res;
 	int num_spied_upon = 1;
 	struct ast_channel_iterator *iter = NULL;
+	struct ao2_iterator *spy_iter = NULL;
 
 	if (ast_test_flag(flags, OPTION_EXIT)) {
 		const char *c;
@@ -957,6 +1088,13 @@ static int common_exec(struct ast_channel *chan, struct ast_flags *flags,
 				}
 				iter = ast_channel_iterator_by_name_new(ast_channel_name(unique_chan), 0);
 				ast_channel_unref(unique_chan);
+			} else if (spyable_channels) {
+				/* Prefix scan over the sorted snapshot index. */
+				spy_iter = ao2_callback(spyable_channels,
+					OBJ_MULTIPLE | OBJ_SEARCH_PARTIAL_KEY, NULL, (char *) spec);
+				if (!spy_iter) {
+					iter = ast_channel_iterator_by_name_new(spec, strlen(spec));
+				}
 			} else {
 				iter = ast_channel_iterator_by_name_new(spec, strlen(spec));
 			}
@@ -966,14 +1104,14 @@ static int common_exec(struct ast_channel *chan, struct ast_flags *flags,
 			iter = ast_channel_iterator_all_new();
 		}
 
-		if (!iter) {
+		if (!iter && !spy_iter) {
 			res = -1;
 			goto exit;
 		}
 
 		res = ast_waitfordigit(chan, waitms);
 		if (res < 0) {
-			iter = ast_channel_iterator_destroy(iter);
+			scan_destroy(&iter, &spy_iter);
 			ast_channel_clear_flag(chan, AST_FLAG_SPYING);
 			break;
 		}
@@ -982,7 +1120,7 @@ static int common_exec(struct ast_channel *chan, struct ast_flags *flags,
 			tmp[0] = res;
 			tmp[1] = '\0';
 			if (!ast_goto_if_exists(chan, exitcontext, tmp, 1)) {
-				iter = ast_channel_iterator_destroy(iter);
+				scan_destroy(&iter, &spy_iter);
 				goto exit;
 			} else {
 				ast_debug(2, "Exit by single digit did not work in chanspy. Extension %s does not exist in context %s\n", tmp, exitcontext);
@@ -993,11 +1131,11 @@ static int common_exec(struct ast_channel *chan, struct ast_flags *flags,
 		waitms = 100;
 		num_spied_upon = 0;
 
-		for (autochan = next_channel(iter, chan);
+		for (autochan = spy_iter ? next_indexed_channel(spy_iter, chan) : next_channel(iter, chan);
 			autochan;
 			prev = autochan->chan,
 				ast_autochan_destroy(autochan),
-				autochan = next_autochan ?: next_channel(iter, chan),
+				autochan = next_autochan ?: (spy_iter ? next_indexed_channel(spy_iter, chan) : next_channel(iter, chan)),
 				next_autochan = NULL) {
 			int igrp = !mygroup;
 			int ienf = !myenforced;
@@ -1150,12 +1288,12 @@ static int common_exec(struct ast_channel *chan, struct ast_flags *flags,
 
 			if (res == -1) {
 				ast_autochan_destroy(autochan);
-				iter = ast_channel_iterator_destroy(iter);
+				scan_destroy(&iter, &spy_iter);
 				goto exit;
 			} else if (res == -2) {
 				res = 0;
 				ast_autochan_destroy(autochan);
-				iter = ast_channel_iterator_destroy(iter);
+				scan_destroy(&iter, &spy_iter);
 				goto exit;
 			} else if (res > 1 && spec && !ast_test_flag(flags, OPTION_UNIQUEID)) {
 				struct ast_channel *next;
@@ -1178,12 +1316,12 @@ static int common_exec(struct ast_channel *chan, struct ast_flags *flags,
 				}
 			} else if (res == 0 && ast_test_flag(flags, OPTION_EXITONHANGUP)) {
 				ast_autochan_destroy(autochan);
-				iter = ast_channel_iterator_destroy(iter);
+				scan_destroy(&iter, &spy_iter);
 				goto exit;
 			}
 		}
 
-		iter = ast_channel_iterator_destroy(iter);
+		scan_destroy(&iter, &spy_iter);
 
 		if (res == -1 || ast_check_hangup(chan))
 			break;
@@ -1487,6 +1625,10 @@ static int unload_module(void)
 	res |= ast_unregister_application(app_ext);
 	res |= ast_unregister_application(app_dahdiscan);
 
+	channel_snapshot_sub = stasis_unsubscribe_and_join(channel_snapshot_sub);
+	ao2_cleanup(spyable_channels);
+	spyable_channels = NULL;
+
 	return res;
 }
 
@@ -1494,6 +1636,38 @@ static int load_module(void)
 {
 	int res = 0;
 
+	/* Build the spy target index.  If any of this fails the prefix
+	 * scans simply fall back to walking the channel container. */
+	spyable_channels = ao2_container_alloc_rbtree(AO2_ALLOC_OPT_LOCK_MUTEX,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, spyable_channel_sort_fn, NULL);
+	if (spyable_channels) {
+		channel_snapshot_sub = stasis_subscribe(ast_channel_topic_all(),
+			channel_snapshot_update_cb, NULL);
+		if (channel_snapshot_sub) {
+			struct ast_channel_iterator *iter;
+
+			stasis_subscription_accept_message_type(channel_snapshot_sub,
+				ast_channel_snapshot_type());
+			stasis_subscription_set_filter(channel_snapshot_sub,
+				STASIS_SUBSCRIPTION_FILTER_SELECTIVE);
+
+			/* Prime the index with channels that predate the subscription. */
+			iter = ast_channel_iterator_all_new();
+			if (iter) {
+				struct ast_channel *chan;
+
+				while ((chan = ast_channel_iterator_next(iter))) {
+					spyable_channel_add(ast_channel_name(chan));
+					ast_channel_unref(chan);
+				}
+				ast_channel_iterator_destroy(iter);
+			}
+		} else {
+			ao2_cleanup(spyable_channels);
+			spyable_channels = NULL;
+		}
+	}
+
 	res |= ast_register_application_xml(app_chan, chanspy_exec);
 	res |= ast_register_application_xml(app_ext, extenspy_exec);
 	res |= ast_register_application_xml(app_dahdiscan, dahdiscan_exec);
@@ -522,9 +522,21 @@ static const char app2[] = "ConfKick";
 /*! Initial recording filename space. */
 #define RECORD_FILENAME_INITIAL_SPACE	128
 
+/*! Number of buckets the cached sound container can have */
+#define SOUND_CACHE_BUCKETS 53
+
+/*! Maximum number of sounds kept in the cache */
+#define SOUND_CACHE_MAX_SOUNDS 64
+
+/*! Sounds longer than this many milliseconds are streamed instead of cached */
+#define SOUND_CACHE_MAX_DURATION 15000
+
 /*! \brief Container to hold all conference bridges in progress */
 struct ao2_container *conference_bridges;
 
+/*! \brief Container of cached announcement sounds, shared by all conferences */
+static struct ao2_container *sound_cache;
+
 static void leave_conference(struct confbridge_user *user);
 static int play_sound_number(struct confbridge_conference *conference, int say_number);
 static int execute_menu_entry(struct confbridge_conference *conference,
@@ -1976,6 +1988,184 @@ static void leave_conference(struct confbridge_user *user)
 	user->conference = NULL;
 }
 
+/*!
+ * \brief A fully buffered announcement sound.
+ *
+ * Short prompts that play over and over (join/leave announcements, menu
+ * beeps) are read from disk once and kept as frames.  Subsequent
+ * playbacks inject those frames straight into the bridge output,
+ * bypassing the filestream and the announcer channel's write path.
+ */
+struct cached_sound {
+	/*! Frames read from the sound file, in the file's native format */
+	AST_VECTOR(, struct ast_frame *) frames;
+	/*! Total number of samples across all frames */
+	unsigned int samples;
+	/*! Sample rate of the frames */
+	unsigned int rate;
+	/*! Language-qualified filename used as the cache key */
+	char name[0];
+};
+
+static void cached_sound_destructor(void *obj)
+{
+	struct cached_sound *sound = obj;
+	size_t idx;
+
+	for (idx = 0; idx < AST_VECTOR_SIZE(&sound->frames); ++idx) {
+		ast_frfree(AST_VECTOR_GET(&sound->frames, idx));
+	}
+	AST_VECTOR_FREE(&sound->frames);
+}
+
+AO2_STRING_FIELD_HASH_FN(cached_sound, name)
+AO2_STRING_FIELD_CMP_FN(cached_sound, name)
+
+/*!
+ * \internal
+ * \brief Read a sound file into a new cached_sound.
+ *
+ * \note Runs in the playback queue taskprocessor with autoservice
+ * stopped on the announcer channel, which this borrows for language
+ * resolution and format negotiation.
+ *
+ * \retval NULL if the file could not be read or is too long to cache.
+ */
+static struct cached_sound *cached_sound_create(struct confbridge_conference *conference,
+	const char *filename, const char *key)
+{
+	struct ast_filestream *fs;
+	struct ast_frame *fr;
+	struct cached_sound *sound;
+	int failed = 0;
+
+	fs = ast_openstream(conference->playback_chan, filename,
+		ast_channel_language(conference->playback_chan));
+	if (!fs) {
+		return NULL;
+	}
+
+	sound = ao2_alloc_options(sizeof(*sound) + strlen(key) + 1,
+		cached_sound_destructor, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!sound || AST_VECTOR_INIT(&sound->frames, 32)) {
+		ast_stopstream(conference->playback_chan);
+		ao2_cleanup(sound);
+		return NULL;
+	}
+	strcpy(sound->name, key); /* Safe */
+
+	while ((fr = ast_readframe(fs))) {
+		struct ast_frame *dup;
+
+		if (fr->frametype != AST_FRAME_VOICE || !fr->samples) {
+			ast_frfree(fr);
+			continue;
+		}
+		sound->rate = ast_format_get_sample_rate(fr->subclass.format);
+		dup = ast_frdup(fr);
+		ast_frfree(fr);
+		if (!dup) {
+			failed = 1;
+			break;
+		}
+		if (AST_VECTOR_APPEND(&sound->frames, dup)) {
+			ast_frfree(dup);
+			failed = 1;
+			break;
+		}
+		sound->samples += dup->samples;
+		if ((unsigned long long) sound->samples * 1000
+			> (unsigned long long) sound->rate * SOUND_CACHE_MAX_DURATION) {
+			/* Too long to be worth buffering; stream it instead. */
+			failed = 1;
+			break;
+		}
+	}
+	ast_stopstream(conference->playback_chan);
+
+	if (failed || !sound->samples) {
+		ao2_ref(sound, -1);
+		return NULL;
+	}
+	return sound;
+}
+
+/*!
+ * \internal
+ * \brief Play a cached sound by injecting its frames into the bridge.
+ *
+ * \note Runs in the playback queue taskprocessor.  Holding the slot in
+ * usleep() for the sound's duration keeps queued announcements
+ * sequential, just as streaming playback does.
+ *
+ * \retval -1 if the bridge refused the injection and the caller should
+ * fall back to streaming the file.
+ */
+static int cached_sound_play(struct confbridge_conference *conference, struct cached_sound *sound)
+{
+	size_t idx;
+
+	for (idx = 0; idx < AST_VECTOR_SIZE(&sound->frames); ++idx) {
+		if (ast_bridge_inject_sound(conference->bridge,
+				AST_VECTOR_GET(&sound->frames, idx))) {
+			if (!idx) {
+				return -1;
+			}
+			/* Part of the sound is already queued up in the mix, so
+			 * falling back to streaming now would double up audio. */
+			break;
+		}
+	}
+	usleep((int64_t) sound->samples * 1000000 / sound->rate);
+	return 0;
+}
+
+/*!
+ * \internal
+ * \brief Play a file into the conference from the sound cache.
+ *
+ * \retval -1 if the sound is not cacheable or not injectable and the
+ * caller should stream the file through the announcer channel instead.
+ */
+static int playback_cached(struct confbridge_conference *conference, const char *filename)
+{
+	struct cached_sound *sound;
+	char *key;
+	int res;
+
+	if (ast_asprintf(&key, "%s/%s",
+			ast_channel_language(conference->playback_chan), filename) < 0) {
+		return -1;
+	}
+
+	sound = ao2_find(sound_cache, key, OBJ_SEARCH_KEY);
+	if (!sound) {
+		sound = cached_sound_create(conference, filename, key);
+		if (sound) {
+			struct cached_sound *existing;
+
+			ao2_lock(sound_cache);
+			existing = ao2_find(sound_cache, key, OBJ_SEARCH_KEY | OBJ_NOLOCK);
+			if (existing) {
+				/* Another conference cached it while we read the file. */
+				ao2_ref(sound, -1);
+				sound = existing;
+			} else if (ao2_container_count(sound_cache) < SOUND_CACHE_MAX_SOUNDS) {
+				ao2_link_flags(sound_cache, sound, OBJ_NOLOCK);
+			}
+			ao2_unlock(sound_cache);
+		}
+	}
+	ast_free(key);
+
+	if (!sound) {
+		return -1;
+	}
+	res = cached_sound_play(conference, sound);
+	ao2_ref(sound, -1);
+	return res;
+}
+
 static void playback_common(struct confbridge_conference *conference, const char *filename, int say_number)
 {
 	/* Don't try to play if the playback channel has been hung up */
@@ -1987,7 +2177,9 @@ static void playback_common(struct confbridge_conference *conference, const char
 
 	/* The channel is all under our control, in goes the prompt */
 	if (!ast_strlen_zero(filename)) {
-		ast_stream_and_wait(conference->playback_chan, filename, "");
+		if (playback_cached(conference, filename)) {
+			ast_stream_and_wait(conference->playback_chan, filename, "");
+		}
 	} else if (say_number >= 0) {
 		ast_say_number(conference->playback_chan, say_number, "",
 			ast_channel_language(conference->playback_chan), NULL);
@@ -4564,6 +4756,9 @@ static int unload_module(void)
 	ao2_cleanup(conference_bridges);
 	conference_bridges = NULL;
 
+	ao2_cleanup(sound_cache);
+	sound_cache = NULL;
+
 	conf_destroy_config();
 
 	unregister_channel_tech(conf_announce_get_tech());
@@ -4606,6 +4801,14 @@ static int load_module(void)
 		return AST_MODULE_LOAD_DECLINE;
 	}
 
+	/* Create a container to hold cached announcement sounds */
+	sound_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0,
+		SOUND_CACHE_BUCKETS, cached_sound_hash_fn, NULL, cached_sound_cmp_fn);
+	if (!sound_cache) {
+		unload_module();
+		return AST_MODULE_LOAD_DECLINE;
+	}
+
 	/* Setup manager stasis subscriptions */
 	res |= manager_confbridge_init();
 
@@ -4638,6 +4841,8 @@ static int load_module(void)
 
 static int reload(void)
 {
+	/* Drop cached sounds so changed files on disk are picked up. */
+	ao2_callback(sound_cache, OBJ_UNLINK | OBJ_NODATA | OBJ_MULTIPLE, NULL, NULL);
 	return conf_reload_config();
 }
 
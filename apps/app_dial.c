@@ -67,6 +67,8 @@
 #include "asterisk/features_config.h"
 #include "asterisk/max_forwards.h"
 #include "asterisk/stream.h"
+#include "asterisk/threadstorage.h"
+#include "asterisk/vector.h"
 
 /*** DOCUMENTATION
 	<application name="Dial" language="en_US">
@@ -849,6 +851,8 @@ struct chanlist {
 	/*! TRUE if an AST_CONTROL_CONNECTED_LINE update was saved to the connected element. */
 	unsigned int pending_connected_update:1;
 	struct ast_aoc_decoded *aoc_s_rate_list;
+	/*! Total size of this allocation, for the per-thread reuse cache. */
+	size_t alloc_size;
 	/*! The interface, tech, and number strings are stuffed here. */
 	char stuff[0];
 };
@@ -857,11 +861,82 @@ AST_LIST_HEAD_NOLOCK(dial_head, chanlist);
 
 static int detect_disconnect(struct ast_channel *chan, char code, struct ast_str **featurecode);
 
+/*! \brief Number of freed chanlist allocations kept per thread for reuse */
+#define CHANLIST_CACHE_MAX 8
+
+struct chanlist_cache {
+	struct chanlist *mem[CHANLIST_CACHE_MAX];
+	size_t size[CHANLIST_CACHE_MAX];
+	unsigned int count;
+};
+
+static void chanlist_cache_destroy(void *data)
+{
+	struct chanlist_cache *cache = data;
+	unsigned int idx;
+
+	for (idx = 0; idx < cache->count; ++idx) {
+		ast_free(cache->mem[idx]);
+	}
+	ast_free(cache);
+}
+
+AST_THREADSTORAGE_CUSTOM(chanlist_cache_storage, NULL, chanlist_cache_destroy);
+
+/*!
+ * \internal
+ * \brief Allocate a chanlist with room for len bytes of stuffed strings.
+ *
+ * Dial allocates and frees one chanlist per destination on every
+ * invocation, so freed entries are parked in a small per-thread cache
+ * and handed back out here instead of hitting the allocator each time.
+ */
+static struct chanlist *chanlist_alloc(size_t len)
+{
+	struct chanlist_cache *cache;
+	struct chanlist *outgoing;
+	size_t size = sizeof(*outgoing) + len;
+	unsigned int idx;
+
+	cache = ast_threadstorage_get(&chanlist_cache_storage, sizeof(*cache));
+	if (cache) {
+		for (idx = 0; idx < cache->count; ++idx) {
+			if (cache->size[idx] < size) {
+				continue;
+			}
+			outgoing = cache->mem[idx];
+			size = cache->size[idx];
+			cache->count--;
+			cache->mem[idx] = cache->mem[cache->count];
+			cache->size[idx] = cache->size[cache->count];
+			memset(outgoing, 0, size);
+			outgoing->alloc_size = size;
+			return outgoing;
+		}
+	}
+
+	outgoing = ast_calloc(1, size);
+	if (outgoing) {
+		outgoing->alloc_size = size;
+	}
+	return outgoing;
+}
+
 static void chanlist_free(struct chanlist *outgoing)
 {
+	struct chanlist_cache *cache;
+
 	ast_party_connected_line_free(&outgoing->connected);
 	ast_aoc_destroy_decoded(outgoing->aoc_s_rate_list);
 	ast_free(outgoing->orig_chan_name);
+
+	cache = ast_threadstorage_get(&chanlist_cache_storage, sizeof(*cache));
+	if (cache && cache->count < CHANLIST_CACHE_MAX) {
+		cache->mem[cache->count] = outgoing;
+		cache->size[cache->count] = outgoing->alloc_size;
+		cache->count++;
+		return;
+	}
 	ast_free(outgoing);
 }
 
@@ -883,6 +958,128 @@ static void hanguptree(struct dial_head *out_chans, struct ast_channel *exceptio
 	}
 }
 
+/*! \brief Completion accounting shared by the parallel destination requests of one Dial */
+struct dial_request_fanin {
+	ast_mutex_t lock;
+	ast_cond_t done;
+	/*! Number of requests still running in worker threads. */
+	int pending;
+};
+
+/*! \brief State for one destination channel request, possibly run in a worker thread */
+struct dial_request {
+	/*! Destination being set up.  Owned by dial_exec_full(). */
+	struct chanlist *tmp;
+	/*! Topology to request the channel with.  Consumed by the request. */
+	struct ast_stream_topology *topology;
+	/*! Calling channel, passed as the requestor. */
+	struct ast_channel *requestor;
+	/*! Channel created by the request, or NULL on failure. */
+	struct ast_channel *chan;
+	/*! Failure cause when chan is NULL. */
+	int cause;
+	/*! Fan-in accounting, set when the request runs in a worker thread. */
+	struct dial_request_fanin *fanin;
+};
+
+AST_VECTOR(dial_requests, struct dial_request);
+
+static void dial_request_run(struct dial_request *req)
+{
+	req->chan = ast_request_with_stream_topology(req->tmp->tech, req->topology,
+		NULL, req->requestor, req->tmp->number, &req->cause);
+	ast_stream_topology_free(req->topology);
+	req->topology = NULL;
+}
+
+static void *dial_request_thread(void *data)
+{
+	struct dial_request *req = data;
+	struct dial_request_fanin *fanin = req->fanin;
+
+	dial_request_run(req);
+
+	ast_mutex_lock(&fanin->lock);
+	if (!--fanin->pending) {
+		ast_cond_signal(&fanin->done);
+	}
+	ast_mutex_unlock(&fanin->lock);
+	return NULL;
+}
+
+/*!
+ * \internal
+ * \brief Create the destination channels for a Dial invocation.
+ *
+ * A single destination is requested inline.  Fanning out to several
+ * destinations runs the requests in parallel worker threads so the
+ * post-dial delay is bounded by the slowest individual request instead
+ * of the sum of all of them.  Channel drivers lock the requestor while
+ * they peek at it, which keeps the concurrent requests safe.
+ */
+static void dial_requests_run(struct dial_requests *requests)
+{
+	struct dial_request_fanin fanin = { .pending = 0, };
+	size_t idx;
+
+	if (AST_VECTOR_SIZE(requests) == 1) {
+		dial_request_run(AST_VECTOR_GET_ADDR(requests, 0));
+		return;
+	}
+
+	ast_mutex_init(&fanin.lock);
+	ast_cond_init(&fanin.done, NULL);
+
+	for (idx = 0; idx < AST_VECTOR_SIZE(requests); ++idx) {
+		struct dial_request *req = AST_VECTOR_GET_ADDR(requests, idx);
+		pthread_t thread;
+
+		req->fanin = &fanin;
+		ast_mutex_lock(&fanin.lock);
+		fanin.pending++;
+		ast_mutex_unlock(&fanin.lock);
+		if (ast_pthread_create_detached(&thread, NULL, dial_request_thread, req)) {
+			/* No thread to be had; run this one ourselves. */
+			ast_mutex_lock(&fanin.lock);
+			fanin.pending--;
+			ast_mutex_unlock(&fanin.lock);
+			dial_request_run(req);
+		}
+	}
+
+	ast_mutex_lock(&fanin.lock);
+	while (fanin.pending) {
+		ast_cond_wait(&fanin.done, &fanin.lock);
+	}
+	ast_mutex_unlock(&fanin.lock);
+
+	ast_mutex_destroy(&fanin.lock);
+	ast_cond_destroy(&fanin.done);
+}
+
+/*!
+ * \internal
+ * \brief Dispose of requests whose destinations never made it into the
+ * outgoing list.
+ */
+static void dial_requests_destroy(struct dial_requests *requests)
+{
+	size_t idx;
+
+	for (idx = 0; idx < AST_VECTOR_SIZE(requests); ++idx) {
+		struct dial_request *req = AST_VECTOR_GET_ADDR(requests, idx);
+
+		ast_stream_topology_free(req->topology);
+		if (req->chan) {
+			ast_hangup(req->chan);
+		}
+		if (req->tmp) {
+			chanlist_free(req->tmp);
+		}
+	}
+	AST_VECTOR_FREE(requests);
+}
+
 #define AST_MAX_WATCHERS 256
 
 /*
@@ -2319,7 +2516,9 @@ static int dial_exec_full(struct ast_channel *chan, const char *data, struct ast
 	struct ast_channel *peer = NULL;
 	int to; /* timeout */
 	struct cause_args num = { chan, 0, 0, 0 };
-	int cause, hanguptreecause = -1;
+	int hanguptreecause = -1;
+	struct dial_requests requests = { NULL, };
+	size_t req_idx;
 
 	struct ast_bridge_config config = { { 0, } };
 	struct timeval calldurationlimit = { 0, };
@@ -2604,8 +2803,8 @@ static int dial_exec_full(struct ast_channel *chan, const char *data, struct ast
 
 	/* loop through the list of dial destinations */
 	rest = args.peers;
+	AST_VECTOR_INIT(&requests, 4);
 	while ((cur = strsep(&rest, "&"))) {
-		struct ast_channel *tc; /* channel for this destination */
 		char *number;
 		char *tech;
 		int i;
@@ -2632,7 +2831,7 @@ static int dial_exec_full(struct ast_channel *chan, const char *data, struct ast
 
 		tech_len = strlen(tech) + 1;
 		number_len = strlen(number) + 1;
-		tmp = ast_calloc(1, sizeof(*tmp) + (2 * tech_len) + number_len);
+		tmp = chanlist_alloc((2 * tech_len) + number_len);
 		if (!tmp) {
 			goto out;
 		}
@@ -2693,16 +2892,44 @@ static int dial_exec_full(struct ast_channel *chan, const char *data, struct ast
 			}
 		}
 
-		tc = ast_request_with_stream_topology(tmp->tech, topology, NULL, chan, tmp->number, &cause);
+		{
+			struct dial_request req = {
+				.tmp = tmp,
+				.topology = topology,
+				.requestor = chan,
+			};
 
-		ast_stream_topology_free(topology);
+			if (AST_VECTOR_APPEND(&requests, req)) {
+				ast_stream_topology_free(topology);
+				chanlist_free(tmp);
+				goto out;
+			}
+		}
+	}
+
+	/*
+	 * Create all of the destination channels.  With several destinations
+	 * the requests run in parallel worker threads so channel driver
+	 * setup latencies do not stack up serially in the post-dial delay.
+	 */
+	dial_requests_run(&requests);
+
+	for (req_idx = 0; req_idx < AST_VECTOR_SIZE(&requests); ++req_idx) {
+		struct dial_request *req = AST_VECTOR_GET_ADDR(&requests, req_idx);
+		struct ast_channel *tc = req->chan; /* channel for this destination */
+		int last_dest = (req_idx == AST_VECTOR_SIZE(&requests) - 1);
+		int cause = req->cause;
+
+		tmp = req->tmp;
+		req->tmp = NULL;
+		req->chan = NULL;
 
 		if (!tc) {
 			/* If we can't, just go on to the next call */
 			ast_log(LOG_WARNING, "Unable to create channel of type '%s' (cause %d - %s)\n",
 				tmp->tech, cause, ast_cause2str(cause));
 			handle_cause(cause, &num);
-			if (!rest) {
+			if (last_dest) {
 				/* we are on the last destination */
 				ast_channel_hangupcause_set(chan, cause);
 			}
@@ -2726,7 +2953,7 @@ static int dial_exec_full(struct ast_channel *chan, const char *data, struct ast
 		pbx_builtin_setvar_helper(tc, "DIALEDPEERNUMBER", tmp->number);
 
 		/* Setup outgoing SDP to match incoming one */
-		if (!AST_LIST_FIRST(&out_chans) && !rest && CAN_EARLY_BRIDGE(peerflags, chan, tc)) {
+		if (!AST_LIST_FIRST(&out_chans) && last_dest && CAN_EARLY_BRIDGE(peerflags, chan, tc)) {
 			/* We are on the only destination. */
 			ast_rtp_instance_early_bridge_make_compatible(tc, chan);
 		}
@@ -2836,6 +3063,7 @@ static int dial_exec_full(struct ast_channel *chan, const char *data, struct ast
 		tmp->chan = tc;
 		AST_LIST_INSERT_TAIL(&out_chans, tmp, node);
 	}
+	AST_VECTOR_FREE(&requests);
 
 	if (AST_LIST_EMPTY(&out_chans)) {
 		ast_verb(3, "No devices or endpoints to dial (technology/resource)\n");
@@ -3463,6 +3691,7 @@ out:
 		else
 			hanguptreecause = AST_CAUSE_NORMAL_CLEARING;
 	}
+	dial_requests_destroy(&requests);
 	hanguptree(&out_chans, NULL, hanguptreecause);
 	pbx_builtin_setvar_helper(chan, "DIALSTATUS", pa.status);
 	ast_debug(1, "Exiting with DIALSTATUS=%s.\n", pa.status);
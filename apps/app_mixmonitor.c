@@ -969,8 +969,11 @@ static int launch_monitor_thread(struct ast_channel *chan, const char *filename,
 		return -1;
 	}
 
-	/* Setup the actual spy before creating our thread */
-	if (ast_audiohook_init(&mixmonitor->audiohook, AST_AUDIOHOOK_TYPE_SPY, mixmonitor_spy_type, 0)) {
+	/* Setup the actual spy before creating our thread.  Translation to
+	 * slin is deferred to our recording thread so the channel's media
+	 * threads only pay for a frame copy. */
+	if (ast_audiohook_init(&mixmonitor->audiohook, AST_AUDIOHOOK_TYPE_SPY, mixmonitor_spy_type,
+			AST_AUDIOHOOK_DEFER_TRANSLATE)) {
 		mixmonitor_free(mixmonitor);
 		return -1;
 	}
@@ -1890,6 +1890,26 @@ struct call_queue {
 	struct queue_ent *head;             /*!< Head of the list of callers */
 	AST_LIST_ENTRY(call_queue) list;    /*!< Next call queue */
 	AST_LIST_HEAD_NOLOCK(, penalty_rule) rules; /*!< The list of penalty rules to invoke */
+
+	/*! \brief Statistics mirror for polling readers.
+	 *
+	 * Copies of the numbers that wallboard style consumers poll, guarded
+	 * by its own lock so QueueSummary and the QUEUE() function do not
+	 * have to take the queue lock the call path holds while ringing
+	 * members.  Updated wherever the source numbers change.
+	 */
+	struct {
+		ast_mutex_t lock;
+		int callers;                /*!< Mirror of count */
+		int holdtime;               /*!< Mirror of the holdtime average */
+		int talktime;               /*!< Mirror of the talktime average */
+		int callscompleted;         /*!< Mirror of callscompleted */
+		int callsabandoned;         /*!< Mirror of callsabandoned */
+		int callscompletedinsl;     /*!< Mirror of callscompletedinsl */
+		int loggedin;               /*!< Members that are neither unavailable nor invalid */
+		int available;              /*!< Logged in members that are free and not paused */
+		time_t longest_start;       /*!< Join time of the longest waiting caller, 0 if none */
+	} stats;
 };
 
 struct rule_list {
@@ -1903,9 +1923,15 @@ static AST_LIST_HEAD_STATIC(rule_lists, rule_list);
 static struct ao2_container *queues;
 
 static void update_realtime_members(struct call_queue *q);
+#define QUEUE_PAUSED_DEVSTATE AST_DEVICE_INUSE
+#define QUEUE_UNPAUSED_DEVSTATE AST_DEVICE_NOT_INUSE
+#define QUEUE_UNKNOWN_PAUSED_DEVSTATE AST_DEVICE_NOT_INUSE
+
 static struct member *interface_exists(struct call_queue *q, const char *interface);
 static int set_member_paused(const char *queuename, const char *interface, const char *reason, int paused);
+static void set_queue_member_pause(struct call_queue *q, struct member *mem, const char *reason, int paused);
 static int update_queue(struct call_queue *q, struct member *member, int callcompletedinsl, time_t starttime);
+static int member_status_available(int status);
 
 static struct member *find_member_by_queuename_and_interface(const char *queuename, const char *interface);
 /*! \brief sets the QUEUESTATUS channel variable */
@@ -2572,6 +2598,58 @@ static void pending_members_remove(struct member *mem)
  * Lock interface list find sc, iterate through each queues queue_member list for member to
  * update state inside queues
 */
+/*!
+ * \internal
+ * \brief Apply a member's contribution to the queue's statistics mirror.
+ *
+ * \param q Queue whose mirror is adjusted
+ * \param mem Member whose current state is tallied
+ * \param delta 1 when the member's state starts counting, -1 when it stops
+ *
+ * Call this with -1 before changing a member's status or paused state and
+ * with 1 afterwards, and whenever a member is linked to or unlinked from
+ * the queue.
+ */
+static void queue_stats_member_delta(struct call_queue *q, struct member *mem, int delta)
+{
+	ast_mutex_lock(&q->stats.lock);
+	if (mem->status != AST_DEVICE_UNAVAILABLE && mem->status != AST_DEVICE_INVALID) {
+		q->stats.loggedin += delta;
+		if (member_status_available(mem->status) && !mem->paused) {
+			q->stats.available += delta;
+		}
+	}
+	ast_mutex_unlock(&q->stats.lock);
+}
+
+/*!
+ * \internal
+ * \brief Refresh the caller side of the queue's statistics mirror.
+ *
+ * \note The queue must be locked when calling this.
+ */
+static void queue_stats_publish(struct call_queue *q)
+{
+	struct queue_ent *qe;
+	time_t longest_start = 0;
+
+	for (qe = q->head; qe; qe = qe->next) {
+		if (!longest_start || qe->start < longest_start) {
+			longest_start = qe->start;
+		}
+	}
+
+	ast_mutex_lock(&q->stats.lock);
+	q->stats.callers = q->count;
+	q->stats.holdtime = q->holdtime;
+	q->stats.talktime = q->talktime;
+	q->stats.callscompleted = q->callscompleted;
+	q->stats.callsabandoned = q->callsabandoned;
+	q->stats.callscompletedinsl = q->callscompletedinsl;
+	q->stats.longest_start = longest_start;
+	ast_mutex_unlock(&q->stats.lock);
+}
+
 static void update_status(struct call_queue *q, struct member *m, const int status)
 {
 	if (m->status != status) {
@@ -2583,7 +2661,9 @@ static void update_status(struct call_queue *q, struct member *m, const int stat
 			update_queue(q, m, m->callcompletedinsl, m->starttime);
 		}
 
+		queue_stats_member_delta(q, m, -1);
 		m->status = status;
+		queue_stats_member_delta(q, m, 1);
 
 		/* Remove the member from the pending members pool only when the status changes.
 		 * This is not done unconditionally because we can occasionally see multiple
@@ -2637,6 +2717,69 @@ static int is_member_available(struct call_queue *q, struct member *mem)
 	return available;
 }
 
+/*!
+ * \internal
+ * \brief Apply a queue pause device state received from another cluster node.
+ *
+ * Queue member pause state is expressed as cachable device states named
+ * "Queue:<queue>_pause_<interface>".  When a module such as res_corosync
+ * relays device state between nodes, those states arrive here with a
+ * remote EID.  Applying them to the matching local member keeps pause
+ * state in sync across a cluster running the same queue definitions.
+ *
+ * The handler is idempotent: applying a remote pause republishes the same
+ * device state from this node, which remote handlers in turn treat as a
+ * no-op, so state converges without looping.
+ */
+static void remote_pause_state_change(const char *device, enum ast_device_state state)
+{
+	struct member *mem;
+	struct call_queue *q;
+	char queuename[256];
+	struct call_queue tmpq = {
+		.name = queuename,
+	};
+	char *interface;
+	int paused;
+
+	if (strncasecmp(device, "Queue:", 6)) {
+		return;
+	}
+
+	if (state == QUEUE_PAUSED_DEVSTATE) {
+		paused = 1;
+	} else if (state == QUEUE_UNPAUSED_DEVSTATE) {
+		paused = 0;
+	} else {
+		return;
+	}
+
+	ast_copy_string(queuename, device + 6, sizeof(queuename));
+	interface = strstr(queuename, "_pause_");
+	if (!interface) {
+		return;
+	}
+	*interface = '\0';
+	interface += strlen("_pause_");
+
+	if (!(q = ao2_t_find(queues, &tmpq, OBJ_POINTER, "Find queue for remote pause state"))) {
+		return;
+	}
+
+	ao2_lock(q);
+	mem = interface_exists(q, interface);
+	if (mem) {
+		if (mem->paused != paused) {
+			ast_debug(1, "%spausing queue member %s:%s to match remote node\n",
+				(paused ? "" : "un"), q->name, interface);
+			set_queue_member_pause(q, mem, NULL, paused);
+		}
+		ao2_ref(mem, -1);
+	}
+	ao2_unlock(q);
+	queue_t_unref(q, "Done with remote pause state");
+}
+
 /*! \brief set a member's status based on device state of that member's interface*/
 static void device_state_cb(void *unused, struct stasis_subscription *sub, struct stasis_message *msg)
 {
@@ -2655,6 +2798,10 @@ static void device_state_cb(void *unused, struct stasis_subscription *sub, struc
 
 	dev_state = stasis_message_data(msg);
 	if (dev_state->eid) {
+		if (ast_eid_cmp(&ast_eid_default, dev_state->eid)) {
+			/* A relayed queue pause state from another cluster node. */
+			remote_pause_state_change(dev_state->device, dev_state->state);
+		}
 		/* ignore non-aggregate states */
 		return;
 	}
@@ -3061,6 +3208,7 @@ static void clear_queue(struct call_queue *q)
 		}
 		ao2_iterator_destroy(&mem_iter);
 	}
+	queue_stats_publish(q);
 }
 
 /*!
@@ -3527,10 +3675,6 @@ static void queue_set_param(struct call_queue *q, const char *param, const char
 }
 
 
-#define QUEUE_PAUSED_DEVSTATE AST_DEVICE_INUSE
-#define QUEUE_UNPAUSED_DEVSTATE AST_DEVICE_NOT_INUSE
-#define QUEUE_UNKNOWN_PAUSED_DEVSTATE AST_DEVICE_NOT_INUSE
-
 /*! \internal
  * \brief If adding a single new member to a queue, use this function instead of ao2_linking.
  *        This adds round robin queue position data for a fresh member as well as links it.
@@ -3544,6 +3688,7 @@ static void member_add_to_queue(struct call_queue *queue, struct member *mem)
 	ao2_link(queue->members, mem);
 	ast_devstate_changed(mem->paused ? QUEUE_PAUSED_DEVSTATE : QUEUE_UNPAUSED_DEVSTATE,
 		AST_DEVSTATE_CACHABLE, "Queue:%s_pause_%s", queue->name, mem->interface);
+	queue_stats_member_delta(queue, mem, 1);
 	ao2_unlock(queue->members);
 }
 
@@ -3558,6 +3703,7 @@ static void member_remove_from_queue(struct call_queue *queue, struct member *me
 	pending_members_remove(mem);
 	ao2_lock(queue->members);
 	ast_devstate_changed(QUEUE_UNKNOWN_PAUSED_DEVSTATE, AST_DEVSTATE_CACHABLE, "Queue:%s_pause_%s", queue->name, mem->interface);
+	queue_stats_member_delta(queue, mem, -1);
 	queue_member_follower_removal(queue, mem);
 	ao2_unlink(queue->members, mem);
 	ao2_unlock(queue->members);
@@ -3640,7 +3786,9 @@ static void rt_handle_member_record(struct call_queue *q, char *category, struct
 			m->dead = 0;	/* Do not delete this one. */
 			ast_copy_string(m->rt_uniqueid, rt_uniqueid, sizeof(m->rt_uniqueid));
 			if (paused_str) {
+				queue_stats_member_delta(q, m, -1);
 				m->paused = paused;
+				queue_stats_member_delta(q, m, 1);
 				if (paused && m->lastpause == 0) {
 					time(&m->lastpause); /* XXX: Should this come from realtime? */
 				}
@@ -3702,6 +3850,7 @@ static void destroy_queue(void *obj)
 	int i;
 
 	free_members(q, 1);
+	ast_mutex_destroy(&q->stats.lock);
 	ast_string_field_free_memory(q);
 	for (i = 0; i < MAX_PERIODIC_ANNOUNCEMENTS; i++) {
 		if (q->sound_periodicannounce[i]) {
@@ -3721,6 +3870,7 @@ static struct call_queue *alloc_queue(const char *queuename)
 			return NULL;
 		}
 		ast_string_field_set(q, name, queuename);
+		ast_mutex_init(&q->stats.lock);
 	}
 	return q;
 }
@@ -4111,6 +4261,7 @@ static int join_queue(char *queuename, struct queue_ent *qe, enum queue_result *
 		if (q->count == 1) {
 			ast_devstate_changed(AST_DEVICE_RINGING, AST_DEVSTATE_CACHABLE, "Queue:%s", q->name);
 		}
+		queue_stats_publish(q);
 
 		res = 0;
 
@@ -4348,6 +4499,7 @@ static void recalc_holdtime(struct queue_ent *qe, int newholdtime)
 		oldvalue = qe->parent->holdtime;
 		qe->parent->holdtime = (((oldvalue << 2) - oldvalue) + newholdtime) >> 2;
 	}
+	queue_stats_publish(qe->parent);
 	ao2_unlock(qe->parent);
 }
 
@@ -4404,6 +4556,7 @@ static void leave_queue(struct queue_ent *qe)
 			prev = current;
 		}
 	}
+	queue_stats_publish(q);
 	ao2_unlock(q);
 
 	/*If the queue is a realtime queue, check to see if it's still defined in real time*/
@@ -4819,20 +4972,79 @@ static int ring_entry(struct queue_ent *qe, struct callattempt *tmp, int *busies
 	return 1;
 }
 
-/*! \brief find the entry with the best metric, or NULL */
+/*!
+ * \brief Merge two callattempt lists that are already sorted by metric.
+ *
+ * The merge is stable so entries with equal metrics keep their relative
+ * order, which preserves the historical tie-breaking of find_best().
+ */
+static struct callattempt *merge_attempts_by_metric(struct callattempt *left, struct callattempt *right)
+{
+	struct callattempt *sorted = NULL;
+	struct callattempt **tail = &sorted;
+
+	while (left && right) {
+		if (left->metric <= right->metric) {
+			*tail = left;
+			left = left->q_next;
+		} else {
+			*tail = right;
+			right = right->q_next;
+		}
+		tail = &(*tail)->q_next;
+	}
+	*tail = left ? left : right;
+
+	return sorted;
+}
+
+/*!
+ * \brief Sort a callattempt list ascending by metric.
+ *
+ * With thousands of members, rescanning the whole attempt list for the
+ * lowest metric on every ring attempt adds up while the queue is locked.
+ * Sorting the list once after the metrics are calculated lets find_best()
+ * stop at the first eligible entry instead.
+ */
+static struct callattempt *sort_attempts_by_metric(struct callattempt *list)
+{
+	struct callattempt *slow, *fast, *right;
+
+	if (!list || !list->q_next) {
+		return list;
+	}
+
+	/* Split the list in half at the slow pointer. */
+	slow = list;
+	fast = list->q_next;
+	while (fast && fast->q_next) {
+		slow = slow->q_next;
+		fast = fast->q_next->q_next;
+	}
+	right = slow->q_next;
+	slow->q_next = NULL;
+
+	return merge_attempts_by_metric(sort_attempts_by_metric(list), sort_attempts_by_metric(right));
+}
+
+/*!
+ * \brief find the entry with the best metric, or NULL
+ *
+ * The list is sorted ascending by metric, so the first entry that is still
+ * eligible to ring is the best one.
+ */
 static struct callattempt *find_best(struct callattempt *outgoing)
 {
-	struct callattempt *best = NULL, *cur;
+	struct callattempt *cur;
 
 	for (cur = outgoing; cur; cur = cur->q_next) {
-		if (cur->stillgoing &&					/* Not already done */
-			!cur->chan &&					/* Isn't already going */
-			(!best || cur->metric < best->metric)) {		/* We haven't found one yet, or it's better */
-			best = cur;
+		if (cur->stillgoing &&	/* Not already done */
+			!cur->chan) {	/* Isn't already going */
+			return cur;
 		}
 	}
 
-	return best;
+	return NULL;
 }
 
 /*!
@@ -4866,9 +5078,10 @@ static int ring_one(struct queue_ent *qe, struct callattempt *outgoing, int *bus
 			break;
 		}
 		if (qe->parent->strategy == QUEUE_STRATEGY_RINGALL) {
-			/* Ring everyone who shares this best metric (for ringall) */
-			for (cur = outgoing; cur; cur = cur->q_next) {
-				if (cur->stillgoing && !cur->chan && cur->metric <= best->metric) {
+			/* Ring everyone who shares this best metric (for ringall).
+			 * The list is sorted so we can stop at the first higher metric. */
+			for (cur = best; cur && cur->metric <= best->metric; cur = cur->q_next) {
+				if (cur->stillgoing && !cur->chan) {
 					ast_debug(1, "(Parallel) Trying '%s' with metric %d\n", cur->interface, cur->metric);
 					ret |= ring_entry(qe, cur, busies);
 					if (qe->predial_callee && cur->chan) {
@@ -5039,6 +5252,7 @@ static void record_abandoned(struct queue_ent *qe)
 	}
 
 	qe->parent->callsabandoned++;
+	queue_stats_publish(qe->parent);
 	ao2_unlock(qe->parent);
 
 	ast_channel_publish_cached_blob(qe->chan, queue_caller_abandon_type(), blob);
@@ -5978,6 +6192,7 @@ static int update_queue(struct call_queue *q, struct member *member, int callcom
 		oldtalktime = q->talktime;
 		q->talktime = (((oldtalktime << 2) - oldtalktime) + newtalktime) >> 2;
 	}
+	queue_stats_publish(q);
 	ao2_unlock(q);
 	return 0;
 }
@@ -7078,6 +7293,10 @@ static int try_calling(struct queue_ent *qe, struct ast_flags opts, char **opt_a
 	}
 	ao2_iterator_destroy(&memi);
 
+	/* Order the attempts by metric up front so each ring attempt picks the
+	 * next member without rescanning the whole list. */
+	outgoing = sort_attempts_by_metric(outgoing);
+
 	if (qe->parent->timeoutpriority == TIMEOUT_PRIORITY_APP) {
 		/* Application arguments have higher timeout priority (behaviour for <=1.6) */
 		if (qe->expire && (!qe->parent->timeout || (qe->expire - now) <= qe->parent->timeout)) {
@@ -7747,7 +7966,9 @@ static void set_queue_member_pause(struct call_queue *q, struct member *mem, con
 		}
 	}
 
+	queue_stats_member_delta(q, mem, -1);
 	mem->paused = paused;
+	queue_stats_member_delta(q, mem, 1);
 	if (paused) {
 		time(&mem->lastpause); /* update last pause field */
 	}
@@ -8857,23 +9078,25 @@ static int queue_function_var(struct ast_channel *chan, const char *cmd, char *d
 	}
 
 	if ((q = find_load_queue_rt_friendly(data))) {
-		ao2_lock(q);
+		/* Read from the statistics mirror rather than taking the queue
+		 * lock.  The configuration scalars only change on reload. */
 		if (q->setqueuevar) {
 			sl = 0;
 			res = 0;
 
-			if (q->callscompleted > 0) {
-				sl = 100 * ((float) q->callscompletedinsl / (float) q->callscompleted);
+			ast_mutex_lock(&q->stats.lock);
+			if (q->stats.callscompleted > 0) {
+				sl = 100 * ((float) q->stats.callscompletedinsl / (float) q->stats.callscompleted);
 			}
 
 			snprintf(interfacevar, sizeof(interfacevar),
 				"QUEUEMAX=%d,QUEUESTRATEGY=%s,QUEUECALLS=%d,QUEUEHOLDTIME=%d,QUEUETALKTIME=%d,QUEUECOMPLETED=%d,QUEUEABANDONED=%d,QUEUESRVLEVEL=%d,QUEUESRVLEVELPERF=%2.1f",
-				q->maxlen, int2strat(q->strategy), q->count, q->holdtime, q->talktime, q->callscompleted, q->callsabandoned,  q->servicelevel, sl);
+				q->maxlen, int2strat(q->strategy), q->stats.callers, q->stats.holdtime, q->stats.talktime, q->stats.callscompleted, q->stats.callsabandoned,  q->servicelevel, sl);
+			ast_mutex_unlock(&q->stats.lock);
 
 			pbx_builtin_setvar_multiple(chan, interfacevar);
 		}
 
-		ao2_unlock(q);
 		queue_t_unref(q, "Done with QUEUE() function");
 	} else {
 		ast_log(LOG_WARNING, "queue %s was not found\n", data);
@@ -9231,9 +9454,9 @@ static int queue_function_queuewaitingcount(struct ast_channel *chan, const char
 	}
 
 	if ((q = ao2_t_find(queues, &tmpq, OBJ_POINTER, "Find for QUEUE_WAITING_COUNT()"))) {
-		ao2_lock(q);
-		count = q->count;
-		ao2_unlock(q);
+		ast_mutex_lock(&q->stats.lock);
+		count = q->stats.callers;
+		ast_mutex_unlock(&q->stats.lock);
 		queue_t_unref(q, "Done with reference in QUEUE_WAITING_COUNT()");
 	} else if ((var = ast_load_realtime("queues", "name", data, SENTINEL))) {
 		/* if the queue is realtime but was not found in memory, this
@@ -10329,15 +10552,14 @@ static int manager_queues_summary(struct mansession *s, const struct message *m)
 	int qmemavail = 0;
 	int qchancount = 0;
 	int qlongestholdtime = 0;
+	int qholdtime = 0;
+	int qtalktime = 0;
 	int qsummaries = 0;
 	const char *id = astman_get_header(m, "ActionID");
 	const char *queuefilter = astman_get_header(m, "Queue");
 	char idText[256];
 	struct call_queue *q;
-	struct queue_ent *qe;
-	struct member *mem;
 	struct ao2_iterator queue_iter;
-	struct ao2_iterator mem_iter;
 
 	if (ast_check_realtime("queues")) {
 		load_realtime_queues(queuefilter);
@@ -10351,34 +10573,19 @@ static int manager_queues_summary(struct mansession *s, const struct message *m)
 	}
 	queue_iter = ao2_iterator_init(queues, 0);
 	while ((q = ao2_t_iterator_next(&queue_iter, "Iterate through queues"))) {
-		ao2_lock(q);
-
 		/* List queue properties */
 		if (ast_strlen_zero(queuefilter) || !strcasecmp(q->name, queuefilter)) {
-			/* Reset the necessary local variables if no queuefilter is set*/
-			qmemcount = 0;
-			qmemavail = 0;
-			qchancount = 0;
-			qlongestholdtime = 0;
+			/* Read from the statistics mirror so wallboard polling does
+			 * not contend with the queue lock held by the call path. */
+			ast_mutex_lock(&q->stats.lock);
+			qmemcount = q->stats.loggedin;
+			qmemavail = q->stats.available;
+			qchancount = q->stats.callers;
+			qlongestholdtime = q->stats.longest_start ? now - q->stats.longest_start : 0;
+			qholdtime = q->stats.holdtime;
+			qtalktime = q->stats.talktime;
+			ast_mutex_unlock(&q->stats.lock);
 
-			/* List Queue Members */
-			mem_iter = ao2_iterator_init(q->members, 0);
-			while ((mem = ao2_iterator_next(&mem_iter))) {
-				if ((mem->status != AST_DEVICE_UNAVAILABLE) && (mem->status != AST_DEVICE_INVALID)) {
-					++qmemcount;
-					if (member_status_available(mem->status) && !mem->paused) {
-						++qmemavail;
-					}
-				}
-				ao2_ref(mem, -1);
-			}
-			ao2_iterator_destroy(&mem_iter);
-			for (qe = q->head; qe; qe = qe->next) {
-				if ((now - qe->start) > qlongestholdtime) {
-					qlongestholdtime = now - qe->start;
-				}
-				++qchancount;
-			}
 			astman_append(s, "Event: QueueSummary\r\n"
 				"Queue: %s\r\n"
 				"LoggedIn: %d\r\n"
@@ -10389,10 +10596,9 @@ static int manager_queues_summary(struct mansession *s, const struct message *m)
 				"LongestHoldTime: %d\r\n"
 				"%s"
 				"\r\n",
-				q->name, qmemcount, qmemavail, qchancount, q->holdtime, q->talktime, qlongestholdtime, idText);
+				q->name, qmemcount, qmemavail, qchancount, qholdtime, qtalktime, qlongestholdtime, idText);
 			++qsummaries;
 		}
-		ao2_unlock(q);
 		queue_t_unref(q, "Done with iterator");
 	}
 	ao2_iterator_destroy(&queue_iter);
@@ -11568,6 +11774,7 @@ static int qupd_exec(struct ast_channel *chan, const char *data)
 		ao2_iterator_destroy(&mem_iter);
 	}
 
+	queue_stats_publish(q);
 	ao2_unlock(q);
 	queue_t_unref(q, "Done with temporary pointer");
 
@@ -701,6 +701,7 @@ static int speech_background(struct ast_channel *chan, const char *data)
 {
 	unsigned int timeout = 0;
 	int res = 0, done = 0, started = 0, quieted = 0, max_dtmf_len = 0;
+	int alert_fd = -1;
 	struct ast_speech *speech = find_speech(chan);
 	struct ast_frame *f = NULL;
 	RAII_VAR(struct ast_format *, oldreadformat, NULL, ao2_cleanup);
@@ -721,6 +722,8 @@ static int speech_background(struct ast_channel *chan, const char *data)
 	if (speech == NULL)
 		return -1;
 
+	alert_fd = ast_speech_get_alert_fd(speech);
+
 	if (!ast_strlen_zero(args.options)) {
 		char *options_buf = ast_strdupa(args.options);
 		ast_app_parse_options(speech_background_options, &options, NULL, options_buf);
@@ -792,7 +795,25 @@ static int speech_background(struct ast_channel *chan, const char *data)
 			res = 1000;
 
 		/* If there is a frame waiting, get it - if not - oh well */
-		if (ast_waitfor(chan, res) > 0) {
+		if (alert_fd >= 0) {
+			struct ast_channel *rchan;
+			int outfd = -1;
+
+			/* Also watch the speech alert pipe so results posted by the
+			 * engine are seen now instead of on the next wakeup */
+			rchan = ast_waitfor_nandfds(&chan, 1, &alert_fd, 1, NULL, &outfd, &res);
+			if (outfd == alert_fd) {
+				ast_speech_clear_alert(speech);
+			}
+			if (rchan) {
+				f = ast_read(chan);
+				if (f == NULL) {
+					/* The channel has hung up most likely */
+					done = 3;
+					break;
+				}
+			}
+		} else if (ast_waitfor(chan, res) > 0) {
 			f = ast_read(chan);
 			if (f == NULL) {
 				/* The channel has hung up most likely */
@@ -838,7 +859,7 @@ static int speech_background(struct ast_channel *chan, const char *data)
 			}
 			/* Write audio frame out to speech engine if no DTMF has been received */
 			if (!strlen(dtmf) && f != NULL && f->frametype == AST_FRAME_VOICE) {
-				ast_speech_write(speech, f->data.ptr, f->datalen);
+				ast_speech_write_frame(speech, f);
 			}
 			break;
 		case AST_SPEECH_STATE_WAIT:
@@ -39,6 +39,7 @@
 #include "asterisk/channel.h"
 #include "asterisk/agi.h"
 #include "asterisk/stasis_channels.h"
+#include "asterisk/threadstorage.h"
 
 /*** DOCUMENTATION
 	<application name="Gosub" language="en_US">
@@ -251,12 +252,43 @@ struct gosub_stack_frame {
 	unsigned int is_special:1;
 	/*! Whether or not we were in a subroutine when this one was created */
 	unsigned int in_subroutine:1;
+	/*! Size of the extension/context buffer, for pooled reuse */
+	unsigned int alloc_size;
 	char *context;
 	char extension[0];
 };
 
 AST_LIST_HEAD(gosub_stack_list, gosub_stack_frame);
 
+/*! \brief Maximum number of released frames kept for reuse per thread */
+#define FRAME_POOL_MAX 10
+
+/*!
+ * \brief Pool of released stack frames.
+ *
+ * Deep flows Gosub/Return constantly and frames are created and
+ * released on the channel's own thread, so a per-thread LIFO gives the
+ * just-released frame straight back to the next Gosub with no
+ * allocation.
+ */
+struct gosub_frame_pool {
+	AST_LIST_HEAD_NOLOCK(, gosub_stack_frame) frames;
+	unsigned int count;
+};
+
+static void gosub_frame_pool_cleanup(void *data)
+{
+	struct gosub_frame_pool *pool = data;
+	struct gosub_stack_frame *frame;
+
+	while ((frame = AST_LIST_REMOVE_HEAD(&pool->frames, entries))) {
+		ast_free(frame);
+	}
+	ast_free(pool);
+}
+
+AST_THREADSTORAGE_CUSTOM(gosub_frame_pool_storage, NULL, gosub_frame_pool_cleanup);
+
 static int frame_set_var(struct ast_channel *chan, struct gosub_stack_frame *frame, const char *var, const char *value)
 {
 	struct ast_var_t *variables;
@@ -294,6 +326,7 @@ static int frame_set_var(struct ast_channel *chan, struct gosub_stack_frame *fra
 static void gosub_release_frame(struct ast_channel *chan, struct gosub_stack_frame *frame)
 {
 	struct ast_var_t *vardata;
+	struct gosub_frame_pool *pool;
 
 	/* If chan is not defined, then we're calling it as part of gosub_free,
 	 * and the channel variables will be deallocated anyway.  Otherwise, we're
@@ -307,16 +340,41 @@ static void gosub_release_frame(struct ast_channel *chan, struct gosub_stack_fra
 		ast_var_delete(vardata);
 	}
 
+	pool = ast_threadstorage_get(&gosub_frame_pool_storage, sizeof(*pool));
+	if (pool && pool->count < FRAME_POOL_MAX) {
+		AST_LIST_INSERT_HEAD(&pool->frames, frame, entries);
+		pool->count++;
+		return;
+	}
+
 	ast_free(frame);
 }
 
 static struct gosub_stack_frame *gosub_allocate_frame(const char *context, const char *extension, int priority, int in_subroutine, unsigned char arguments)
 {
 	struct gosub_stack_frame *new = NULL;
+	struct gosub_frame_pool *pool;
 	int len_extension = strlen(extension) + 1;
 	int len_context = strlen(context) + 1;
 
-	if ((new = ast_calloc(1, sizeof(*new) + len_extension + len_context))) {
+	pool = ast_threadstorage_get(&gosub_frame_pool_storage, sizeof(*pool));
+	if (pool && pool->count) {
+		struct gosub_stack_frame *reuse = AST_LIST_FIRST(&pool->frames);
+
+		if (reuse->alloc_size >= len_extension + len_context) {
+			unsigned int alloc_size = reuse->alloc_size;
+
+			AST_LIST_REMOVE_HEAD(&pool->frames, entries);
+			pool->count--;
+			memset(reuse, 0, sizeof(*reuse));
+			reuse->alloc_size = alloc_size;
+			new = reuse;
+		}
+	}
+	if (!new && (new = ast_calloc(1, sizeof(*new) + len_extension + len_context))) {
+		new->alloc_size = len_extension + len_context;
+	}
+	if (new) {
 		AST_LIST_HEAD_INIT_NOLOCK(&new->varshead);
 		ast_copy_string(new->extension, extension, len_extension);
 		new->context = new->extension + len_extension;
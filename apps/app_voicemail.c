@@ -97,6 +97,7 @@
 #include "asterisk/strings.h"
 #include "asterisk/smdi.h"
 #include "asterisk/astobj2.h"
+#include "asterisk/astdb.h"
 #include "asterisk/taskprocessor.h"
 #include "asterisk/test.h"
 #include "asterisk/format_cache.h"
@@ -947,6 +948,78 @@ static unsigned char poll_thread_run;
 
 static struct ast_taskprocessor *mwi_subscription_tps;
 
+/*! Taskprocessor running email/pager notifications off the channel threads */
+static struct ast_taskprocessor *email_tps;
+
+/*! AstDB family holding the per-folder message count index */
+#define VM_INDEX_FAMILY "VMIndex"
+
+/*!
+ * \brief Look up the cached message count for a folder directory
+ *
+ * The index is keyed by the folder's full directory path and is only a
+ * cache: a missing (or deliberately deleted) entry simply means the caller
+ * must fall back to scanning the directory, after which the count is
+ * stored again.  When 'pollmailboxes' is enabled something external to
+ * app_voicemail is modifying the spool, so the index cannot be trusted and
+ * lookups are disabled entirely.
+ *
+ * \retval -1 no cached count available, scan the directory
+ * \retval count (>= 0) the cached number of messages in the folder
+ */
+static int vm_index_get(const char *dir)
+{
+	char count[13];
+
+	if (poll_mailboxes) {
+		return -1;
+	}
+
+	if (ast_db_get(VM_INDEX_FAMILY, dir, count, sizeof(count))) {
+		return -1;
+	}
+
+	return atoi(count);
+}
+
+/*! \brief Store the message count for a folder directory in the index */
+static void vm_index_put(const char *dir, int count)
+{
+	char buf[13];
+
+	if (poll_mailboxes || count < 0) {
+		return;
+	}
+
+	snprintf(buf, sizeof(buf), "%d", count);
+	ast_db_put(VM_INDEX_FAMILY, dir, buf);
+}
+
+/*!
+ * \brief Drop a folder's cached message count
+ *
+ * Called whenever a message is deposited in, deleted from, or moved
+ * between folders.  The next has_voicemail/inboxcount against the folder
+ * rescans it and repopulates the index.
+ */
+static void vm_index_invalidate(const char *dir)
+{
+	ast_db_del(VM_INDEX_FAMILY, dir);
+}
+
+/*! \brief Drop the cached count for the folder containing the given message file */
+static void vm_index_invalidate_file(const char *file)
+{
+	char dir[PATH_MAX];
+	char *slash;
+
+	ast_copy_string(dir, file, sizeof(dir));
+	if ((slash = strrchr(dir, '/'))) {
+		*slash = '\0';
+		vm_index_invalidate(dir);
+	}
+}
+
 struct alias_mailbox_mapping {
 	char *alias;
 	char *mailbox;
@@ -4520,6 +4593,8 @@ static int count_messages(struct ast_vm_user *vmu, char *dir)
 	}
 	ast_unlock_path(dir);
 
+	vm_index_put(dir, vmcount);
+
 	return vmcount;
 }
 
@@ -4740,6 +4815,7 @@ static int vm_delete(char *file)
 	}
 	snprintf(txt, txtsize, "%s.txt", file);
 	unlink(txt);
+	vm_index_invalidate_file(file);
 	return ast_filedelete(file, NULL);
 }
 
@@ -5565,6 +5641,171 @@ static int sendpage(char *srcemail, char *pager, int msgnum, char *context, char
 	return 0;
 }
 
+/*! \brief Deferred email/pager notification queued to \ref email_tps */
+struct email_notify_task {
+	/*! Private copy of the user, freed with free_user() */
+	struct ast_vm_user *vmu;
+	int msgnum;
+	int duration;
+	int attach_user_voicemail;
+	/*! Dialplan priority of the recording channel, for the mail headers */
+	int priority;
+	/*! Set when attach is a snapshot we made and must delete after sending */
+	int delete_attach;
+	char *srcemail;
+	char *fromfolder;
+	char *cidnum;
+	char *cidname;
+	char *attach;
+	char *fmt;
+	char *category;
+	char *flag;
+	char *msg_id;
+	char buf[0];
+};
+
+/*! \brief Make a private copy of a voicemail user, in the manner of find_user() */
+static struct ast_vm_user *dup_user(struct ast_vm_user *vmu)
+{
+	struct ast_vm_user *dup;
+
+	if (!(dup = ast_calloc(1, sizeof(*dup)))) {
+		return NULL;
+	}
+	*dup = *vmu;
+	dup->email = ast_strdup(vmu->email);
+	dup->emailbody = ast_strdup(vmu->emailbody);
+	dup->emailsubject = ast_strdup(vmu->emailsubject);
+	ast_set_flag(dup, VM_ALLOCED);
+	AST_LIST_NEXT(dup, list) = NULL;
+
+	return dup;
+}
+
+static int email_notify_task_exec(void *data)
+{
+	struct email_notify_task *t = data;
+	struct ast_channel *chan;
+
+	/* make_email_file() only looks at the channel's priority, so a dummy
+	 * channel carrying the recording channel's priority is all we need. */
+	if ((chan = ast_dummy_channel_alloc())) {
+		ast_channel_priority_set(chan, t->priority);
+	}
+
+	if (!ast_strlen_zero(t->vmu->email)) {
+		sendmail(t->srcemail, t->vmu, t->msgnum, t->vmu->context, t->vmu->mailbox,
+			t->fromfolder, t->cidnum, t->cidname, t->attach, NULL, t->fmt, t->duration,
+			t->attach_user_voicemail, chan, t->category, t->flag, t->msg_id);
+	}
+
+	if (!ast_strlen_zero(t->vmu->pager)) {
+		sendpage(t->srcemail, t->vmu->pager, t->msgnum, t->vmu->context, t->vmu->mailbox,
+			t->fromfolder, t->cidnum, t->cidname, t->duration, t->vmu, t->category, t->flag);
+	}
+
+	if (t->delete_attach) {
+		ast_filedelete(t->attach, NULL);
+	}
+	if (chan) {
+		ast_channel_unref(chan);
+	}
+	free_user(t->vmu);
+	ast_free(t);
+	return 0;
+}
+
+/*!
+ * \brief Queue an email/pager notification to the notification taskprocessor
+ *
+ * Snapshots everything the notification needs (including the attachment,
+ * which may be moved or deleted by the time the task runs) so the base64
+ * encoding and the sendmail fork happen off the channel thread.
+ *
+ * \retval 0 the notification was queued
+ * \retval -1 it could not be queued and the caller must notify inline
+ */
+static int queue_email_notification(struct ast_channel *chan, struct ast_vm_user *vmu,
+	int msgnum, char *srcemail, const char *fromfolder, char *cidnum, char *cidname,
+	char *attach, char *fmt, int duration, int attach_user_voicemail,
+	const char *category, const char *flag, const char *msg_id)
+{
+	struct email_notify_task *t;
+	char snapshot[PATH_MAX] = "";
+	size_t len;
+	char *pos;
+
+	if (!email_tps) {
+		return -1;
+	}
+
+	if (attach_user_voicemail) {
+		snprintf(snapshot, sizeof(snapshot), "/tmp/vm-email-%d-%08lx",
+			msgnum, (unsigned long) ast_random());
+		if (ast_filecopy(attach, snapshot, fmt)) {
+			return -1;
+		}
+		attach = snapshot;
+	}
+
+	len = sizeof(*t)
+		+ (srcemail ? strlen(srcemail) + 1 : 0)
+		+ (fromfolder ? strlen(fromfolder) + 1 : 0)
+		+ (cidnum ? strlen(cidnum) + 1 : 0)
+		+ (cidname ? strlen(cidname) + 1 : 0)
+		+ (attach ? strlen(attach) + 1 : 0)
+		+ (fmt ? strlen(fmt) + 1 : 0)
+		+ (category ? strlen(category) + 1 : 0)
+		+ (flag ? strlen(flag) + 1 : 0)
+		+ (msg_id ? strlen(msg_id) + 1 : 0);
+
+	if (!(t = ast_calloc(1, len))) {
+		goto fail;
+	}
+	if (!(t->vmu = dup_user(vmu))) {
+		ast_free(t);
+		goto fail;
+	}
+
+	t->msgnum = msgnum;
+	t->duration = duration;
+	t->attach_user_voicemail = attach_user_voicemail;
+	t->priority = chan ? ast_channel_priority(chan) : 0;
+	t->delete_attach = !ast_strlen_zero(snapshot);
+
+	pos = t->buf;
+#define COPY_FIELD(field) \
+	if (field) { \
+		strcpy(pos, field); /* Safe */ \
+		t->field = pos; \
+		pos += strlen(field) + 1; \
+	}
+	COPY_FIELD(srcemail);
+	COPY_FIELD(fromfolder);
+	COPY_FIELD(cidnum);
+	COPY_FIELD(cidname);
+	COPY_FIELD(attach);
+	COPY_FIELD(fmt);
+	COPY_FIELD(category);
+	COPY_FIELD(flag);
+	COPY_FIELD(msg_id);
+#undef COPY_FIELD
+
+	if (ast_taskprocessor_push(email_tps, email_notify_task_exec, t)) {
+		free_user(t->vmu);
+		ast_free(t);
+		goto fail;
+	}
+
+	return 0;
+
+fail:
+	if (!ast_strlen_zero(snapshot)) {
+		ast_filedelete(snapshot, NULL);
+	}
+	return -1;
+}
+
 /*!
  * \brief Gets the current date and time, as formatted string.
  * \param s The buffer to hold the output formatted date.
@@ -5883,6 +6124,7 @@ static int copy_message(struct ast_channel *chan, struct ast_vm_user *vmu, int i
 		res = -1;
 	}
 	ast_unlock_path(todir);
+	vm_index_invalidate(todir);
 	if (chan) {
 		struct ast_party_caller *caller = ast_channel_caller(chan);
 		notify_new_message(chan, recip, NULL, recipmsgnum, duration, fmt,
@@ -5944,6 +6186,14 @@ static int __has_voicemail(const char *context, const char *mailbox, const char
 
 	snprintf(fn, sizeof(fn), "%s%s/%s/%s", VM_SPOOL_DIR, c, m, folder);
 
+	/* Serve the answer from the index when we have one, saving the
+	 * directory scan.  A miss falls through to the scan below, which
+	 * repairs the index as a side effect. */
+	if ((ret = vm_index_get(fn)) >= 0) {
+		return shortcircuit ? ret > 0 : ret;
+	}
+	ret = 0;
+
 	if (!(dir = opendir(fn)))
 		return 0;
 
@@ -5960,6 +6210,10 @@ static int __has_voicemail(const char *context, const char *mailbox, const char
 
 	closedir(dir);
 
+	if (!shortcircuit) {
+		vm_index_put(fn, ret);
+	}
+
 	return ret;
 }
 
@@ -6406,6 +6660,7 @@ static int msg_create_from_file(struct ast_vm_recording_data *recdata)
 
 
 	ast_unlock_path(dir);
+	vm_index_invalidate(dir);
 	inprocess_count(recipient->mailbox, recipient->context, -1);
 
 	/* If we copied something, we should store it either to ODBC or IMAP if we are using those. The STORE macro allows us
@@ -6943,6 +7198,7 @@ static int leave_voicemail(struct ast_channel *chan, char *ext, struct leave_vm_
 						ast_log(AST_LOG_ERROR, "Couldn't set permissions on voicemail text file %s: %s", txtfile, strerror(errno));
 
 					ast_unlock_path(dir);
+					vm_index_invalidate(dir);
 					if (ast_check_realtime("voicemail_data")) {
 						snprintf(tmpdur, sizeof(tmpdur), "%d", duration);
 						ast_update_realtime("voicemail_data", "filename", tmptxtfile, "filename", fn, "duration", tmpdur, SENTINEL);
@@ -7157,6 +7413,7 @@ static int save_to_folder(struct ast_vm_user *vmu, struct vm_state *vms, int msg
 		COPY(dir, msg, ddir, x, username, context, sfn, dfn);
 	}
 	ast_unlock_path(ddir);
+	vm_index_invalidate(ddir);
 
 	if (newmsg) {
 		*newmsg = x;
@@ -8045,8 +8302,8 @@ static int notify_new_message(struct ast_channel *chan, struct ast_vm_user *vmu,
 	if (!ast_strlen_zero(vmu->serveremail))
 		myserveremail = vmu->serveremail;
 
-	if (!ast_strlen_zero(vmu->email)) {
-		int attach_user_voicemail = ast_test_flag(vmu, VM_ATTACH);
+	if (!ast_strlen_zero(vmu->email) || !ast_strlen_zero(vmu->pager)) {
+		int attach_user_voicemail = ast_test_flag(vmu, VM_ATTACH) && !ast_strlen_zero(vmu->email);
 		char *msg_id = NULL;
 #ifdef IMAP_STORAGE
 		struct ast_config *msg_cfg;
@@ -8064,17 +8321,21 @@ static int notify_new_message(struct ast_channel *chan, struct ast_vm_user *vmu,
 		if (attach_user_voicemail)
 			RETRIEVE(todir, msgnum, vmu->mailbox, vmu->context);
 
-		/* XXX possible imap issue, should category be NULL XXX */
-		sendmail(myserveremail, vmu, msgnum, vmu->context, vmu->mailbox, mbox(vmu, 0), cidnum, cidname, fn, NULL, fmt, duration, attach_user_voicemail, chan, category, flag, msg_id);
+		if (queue_email_notification(chan, vmu, msgnum, myserveremail, mbox(vmu, 0), cidnum, cidname, fn, fmt, duration, attach_user_voicemail, category, flag, msg_id)) {
+			/* Could not defer; encode and send on this thread as before */
+			if (!ast_strlen_zero(vmu->email)) {
+				/* XXX possible imap issue, should category be NULL XXX */
+				sendmail(myserveremail, vmu, msgnum, vmu->context, vmu->mailbox, mbox(vmu, 0), cidnum, cidname, fn, NULL, fmt, duration, attach_user_voicemail, chan, category, flag, msg_id);
+			}
+			if (!ast_strlen_zero(vmu->pager)) {
+				sendpage(myserveremail, vmu->pager, msgnum, vmu->context, vmu->mailbox, mbox(vmu, 0), cidnum, cidname, duration, vmu, category, flag);
+			}
+		}
 
 		if (attach_user_voicemail)
 			DISPOSE(todir, msgnum);
 	}
 
-	if (!ast_strlen_zero(vmu->pager)) {
-		sendpage(myserveremail, vmu->pager, msgnum, vmu->context, vmu->mailbox, mbox(vmu, 0), cidnum, cidname, duration, vmu, category, flag);
-	}
-
 	if (ast_test_flag(vmu, VM_DELETE))
 		DELETE(todir, msgnum, fn, vmu);
 
@@ -9084,6 +9345,7 @@ static int close_mailbox(struct vm_state *vms, struct ast_vm_user *vmu)
 		}
 	}
 	ast_unlock_path(vms->curdir);
+	vm_index_invalidate(vms->curdir);
 #else /* defined(IMAP_STORAGE) */
 	ast_mutex_lock(&vms->lock);
 	if (vms->deleted) {
@@ -14995,6 +15257,7 @@ static int unload_module(void)
 		stop_poll_thread();
 
 	mwi_subscription_tps = ast_taskprocessor_unreference(mwi_subscription_tps);
+	email_tps = ast_taskprocessor_unreference(email_tps);
 	ast_unload_realtime("voicemail");
 	ast_unload_realtime("voicemail_data");
 
@@ -15083,6 +15346,10 @@ static int load_module(void)
 		ast_log(AST_LOG_WARNING, "failed to reference mwi subscription taskprocessor.  MWI will not work\n");
 	}
 
+	if (!(email_tps = ast_taskprocessor_get("vm_email", 0))) {
+		ast_log(AST_LOG_WARNING, "failed to reference email notification taskprocessor.  Notifications will be sent on channel threads\n");
+	}
+
 	if ((res = load_config(0))) {
 		unload_module();
 		return AST_MODULE_LOAD_DECLINE;
@@ -277,6 +277,29 @@ static enum ast_rtp_glue_result rtp_glue_get_current_combined_result(struct ast_
 	return combined_result;
 }
 
+/*!
+ * \internal
+ * \brief Determine if telephone events have to be fed to the core for a channel.
+ *
+ * A channel with DTMF feature hooks can still be natively bridged at the
+ * packet level as long as DTMF is carried out of band and the telephone
+ * event packets are punted out of the local bridge so the hooks see them.
+ *
+ * \param bc Bridge channel to check
+ * \param glue RTP glue data of the bridge channel
+ *
+ * \note The channel must be locked when calling this function.
+ *
+ * \retval 1 The local bridge must feed telephone events to the core.
+ * \retval 0 No DTMF hooks or no suitable DTMF mode for packet level bridging.
+ */
+static int native_rtp_bridge_dtmf_to_core(struct ast_bridge_channel *bc,
+	struct rtp_glue_data *glue)
+{
+	return ao2_container_count(bc->features->dtmf_hooks)
+		&& ast_rtp_instance_dtmf_mode_get(glue->audio.instance) == AST_RTP_DTMF_MODE_RFC2833;
+}
+
 /*!
  * \internal
  * \brief Start native RTP bridging of two channels
@@ -297,6 +320,7 @@ static void native_rtp_bridge_start(struct ast_bridge *bridge, struct ast_channe
 	struct ast_format_cap *cap0;
 	struct ast_format_cap *cap1;
 	enum ast_rtp_glue_result native_type;
+	int dtmf_to_core;
 
 	if (bc0 == bc1) {
 		return;
@@ -336,8 +360,23 @@ static void native_rtp_bridge_start(struct ast_bridge *bridge, struct ast_channe
 
 	native_type = glue0->result;
 
+	dtmf_to_core = native_rtp_bridge_dtmf_to_core(bc0, glue0)
+		|| native_rtp_bridge_dtmf_to_core(bc1, glue1);
+	if (dtmf_to_core && native_type == AST_RTP_GLUE_RESULT_REMOTE) {
+		/* The media has to keep flowing through us at the packet level so
+		 * the telephone events which drive the DTMF hooks are still seen.
+		 */
+		ast_debug(2, "Bridge '%s'.  Forcing local RTP bridge so DTMF hooks keep working\n",
+			bridge->uniqueid);
+		native_type = AST_RTP_GLUE_RESULT_LOCAL;
+		glue0->result = native_type;
+		glue1->result = native_type;
+	}
+
 	switch (native_type) {
 	case AST_RTP_GLUE_RESULT_LOCAL:
+		ast_rtp_instance_set_prop(glue0->audio.instance, AST_RTP_PROPERTY_DTMF_TO_CORE, dtmf_to_core);
+		ast_rtp_instance_set_prop(glue1->audio.instance, AST_RTP_PROPERTY_DTMF_TO_CORE, dtmf_to_core);
 		if (ast_rtp_instance_get_engine(glue0->audio.instance)->local_bridge) {
 			ast_rtp_instance_get_engine(glue0->audio.instance)->local_bridge(glue0->audio.instance, glue1->audio.instance);
 		}
@@ -499,6 +538,8 @@ static void native_rtp_bridge_stop(struct ast_bridge *bridge, struct ast_channel
 		}
 		ast_rtp_instance_set_bridged(glue0->audio.instance, NULL);
 		ast_rtp_instance_set_bridged(glue1->audio.instance, NULL);
+		ast_rtp_instance_set_prop(glue0->audio.instance, AST_RTP_PROPERTY_DTMF_TO_CORE, 0);
+		ast_rtp_instance_set_prop(glue1->audio.instance, AST_RTP_PROPERTY_DTMF_TO_CORE, 0);
 		break;
 	case AST_RTP_GLUE_RESULT_REMOTE:
 		if (target) {
@@ -632,6 +673,7 @@ static int native_rtp_bridge_capable(struct ast_channel *chan)
 static int native_rtp_bridge_compatible_check(struct ast_bridge *bridge, struct ast_bridge_channel *bc0, struct ast_bridge_channel *bc1)
 {
 	enum ast_rtp_glue_result native_type;
+	int dtmf_to_core;
 	int read_ptime0;
 	int read_ptime1;
 	int write_ptime0;
@@ -675,20 +717,36 @@ static int native_rtp_bridge_compatible_check(struct ast_bridge *bridge, struct
 		return 0;
 	}
 
-	if (ao2_container_count(bc0->features->dtmf_hooks)
+	/* DTMF hooks do not necessarily break native bridging.  With out of
+	 * band DTMF we can bridge at the packet level and have the telephone
+	 * events fed to the core, so only refuse when that is not possible.
+	 */
+	dtmf_to_core = native_rtp_bridge_dtmf_to_core(bc0, glue0)
+		|| native_rtp_bridge_dtmf_to_core(bc1, glue1);
+
+	if (!native_rtp_bridge_dtmf_to_core(bc0, glue0)
+		&& ao2_container_count(bc0->features->dtmf_hooks)
 		&& ast_rtp_instance_dtmf_mode_get(glue0->audio.instance)) {
 		ast_debug(1, "Bridge '%s' can not use native RTP bridge as channel '%s' has DTMF hooks\n",
 			bridge->uniqueid, ast_channel_name(bc0->chan));
 		return 0;
 	}
 
-	if (ao2_container_count(bc1->features->dtmf_hooks)
+	if (!native_rtp_bridge_dtmf_to_core(bc1, glue1)
+		&& ao2_container_count(bc1->features->dtmf_hooks)
 		&& ast_rtp_instance_dtmf_mode_get(glue1->audio.instance)) {
 		ast_debug(1, "Bridge '%s' can not use native RTP bridge as channel '%s' has DTMF hooks\n",
 			bridge->uniqueid, ast_channel_name(bc1->chan));
 		return 0;
 	}
 
+	if (dtmf_to_core && native_type == AST_RTP_GLUE_RESULT_REMOTE) {
+		/* The start will downgrade this to a local bridge so the engine
+		 * compatibility of the local bridge path has to be checked here.
+		 */
+		native_type = AST_RTP_GLUE_RESULT_LOCAL;
+	}
+
 	if (native_type == AST_RTP_GLUE_RESULT_LOCAL
 		&& (ast_rtp_instance_get_engine(glue0->audio.instance)->local_bridge
 			!= ast_rtp_instance_get_engine(glue1->audio.instance)->local_bridge
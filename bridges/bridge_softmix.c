@@ -79,6 +79,8 @@ struct softmix_remb_collector {
 	struct ast_rtp_rtcp_feedback feedback;
 	/*! The maximum bitrate (A single precision floating point is big enough) */
 	float bitrate;
+	/*! Smoothed bitrate target actually sent to the source */
+	float target_bitrate;
 };
 
 struct softmix_stats {
@@ -205,13 +207,11 @@ static void softmix_process_write_audio(struct softmix_translate_helper *trans_h
 	struct softmix_channel *sc, unsigned int default_sample_size)
 {
 	struct softmix_translate_helper_entry *entry = NULL;
-	int i;
 
 	/* If we provided any audio then take it out while in slinear format. */
 	if (sc->have_audio && !sc->binaural) {
-		for (i = 0; i < sc->write_frame.samples; i++) {
-			ast_slinear_saturated_subtract(&sc->final_buf[i], &sc->our_buf[i]);
-		}
+		ast_slinear_saturated_subtract_block(sc->final_buf, sc->our_buf,
+			sc->write_frame.samples);
 		/* check to see if any entries exist for the format. if not we'll want
 		   to remove it during cleanup */
 		AST_LIST_TRAVERSE(&trans_helper->entries, entry, entry) {
@@ -603,6 +603,120 @@ static int append_all_streams(struct ast_stream_topology *dest,
 	return 0;
 }
 
+/*!
+ * \internal
+ * \brief Queue a video update to one source, coalescing bursts.
+ *
+ * Requests landing on the same source within the configured discard
+ * interval are merged into the one already forwarded, so a wave of
+ * receivers asking for a keyframe at once (typically several channels
+ * joining together) costs the source a single encode.
+ */
+static void softmix_sfu_queue_video_update(struct ast_bridge *bridge,
+	struct ast_bridge_channel *target, struct ast_frame *frame)
+{
+	struct softmix_channel *sc = target->tech_pvt;
+	unsigned int discard = bridge->softmix.video_mode.video_update_discard;
+	int forward = 0;
+
+	ast_mutex_lock(&sc->lock);
+	if (!discard
+		|| ast_tvzero(sc->last_keyframe_request)
+		|| ast_tvdiff_ms(ast_tvnow(), sc->last_keyframe_request) > discard) {
+		sc->last_keyframe_request = ast_tvnow();
+		forward = 1;
+	}
+	ast_mutex_unlock(&sc->lock);
+
+	if (forward) {
+		ast_bridge_channel_queue_frame(target, frame);
+	}
+}
+
+/*!
+ * \internal
+ * \brief Route an SFU video update to just the source it concerns.
+ *
+ * In SFU mode a video update written by a receiver names exactly one
+ * source: the channel whose video feeds the destination stream the
+ * update arrived on.  Broadcasting it (as the single source modes
+ * must) turns every new joiner into a bridge wide keyframe storm, so
+ * deliver it to the owning source only, rate limited per source.
+ *
+ * \retval 0 The request was routed (or coalesced into an earlier one).
+ * \retval -1 The source could not be determined; caller should broadcast.
+ */
+static int softmix_sfu_route_video_update(struct ast_bridge *bridge,
+	struct ast_bridge_channel *bridge_channel, struct ast_frame *frame)
+{
+	struct ast_stream_topology *topology;
+	const struct ast_stream *stream;
+	char *source_channel_name;
+	char *sep;
+	struct ast_bridge_channel *cur;
+
+	if (frame->stream_num < 0) {
+		return -1;
+	}
+
+	ast_channel_lock(bridge_channel->chan);
+	topology = ao2_bump(ast_channel_get_stream_topology(bridge_channel->chan));
+	ast_channel_unlock(bridge_channel->chan);
+	if (!topology) {
+		return -1;
+	}
+
+	stream = ast_stream_topology_get_stream(topology, frame->stream_num);
+	if (!stream || !is_video_dest(stream, NULL, -1)) {
+		ao2_ref(topology, -1);
+		return -1;
+	}
+
+	/* Destination streams are named softbridge_dest_<source channel>_<position> */
+	source_channel_name = ast_strdupa(ast_stream_get_name(stream)
+		+ SOFTBRIDGE_VIDEO_DEST_LEN + 1);
+	ao2_ref(topology, -1);
+	sep = strrchr(source_channel_name, SOFTBRIDGE_VIDEO_DEST_SEPARATOR);
+	if (sep) {
+		*sep = '\0';
+	}
+
+	AST_LIST_TRAVERSE(&bridge->channels, cur, entry) {
+		if (cur == bridge_channel || !cur->tech_pvt
+			|| strcmp(ast_channel_name(cur->chan), source_channel_name)) {
+			continue;
+		}
+		softmix_sfu_queue_video_update(bridge, cur, frame);
+		return 0;
+	}
+
+	return -1;
+}
+
+/*!
+ * \internal
+ * \brief Ask every video source for a keyframe on behalf of a new joiner.
+ *
+ * Sources that were asked for a keyframe within the discard interval
+ * are skipped; the keyframe already on the wire serves the joiner too.
+ */
+static void softmix_sfu_request_keyframes(struct ast_bridge *bridge,
+	struct ast_bridge_channel *joiner)
+{
+	struct ast_frame frame = {
+		.frametype = AST_FRAME_CONTROL,
+		.subclass.integer = AST_CONTROL_VIDUPDATE,
+	};
+	struct ast_bridge_channel *cur;
+
+	AST_LIST_TRAVERSE(&bridge->channels, cur, entry) {
+		if (cur == joiner || !cur->tech_pvt) {
+			continue;
+		}
+		softmix_sfu_queue_video_update(bridge, cur, &frame);
+	}
+}
+
 /*!
  * \brief Issue channel stream topology change requests.
  *
@@ -759,6 +873,9 @@ static int softmix_bridge_join(struct ast_bridge *bridge, struct ast_bridge_chan
 
 	if (bridge->softmix.video_mode.mode == AST_BRIDGE_VIDEO_MODE_SFU) {
 		sfu_topologies_on_join(bridge, bridge_channel);
+		/* Get keyframes flowing for the joiner without waiting for its
+		 * decoder to notice and raise a storm of its own requests. */
+		softmix_sfu_request_keyframes(bridge, bridge_channel);
 	}
 
 	/* Complete any active hold before entering, or transitioning to softmix. */
@@ -950,6 +1067,17 @@ static void softmix_bridge_write_voice(struct ast_bridge *bridge, struct ast_bri
 	 */
 	char update_talking = -1;
 
+	/*
+	 * Run talker detection before taking the channel lock.  The DSP is
+	 * only ever touched by this channel's own thread (it is created at
+	 * join before the channel is linked and freed at leave after the
+	 * channel stops writing), so the mixing thread never has to wait
+	 * behind it when grabbing the lock for the read pass.
+	 */
+	if (sc->dsp) {
+		silent = ast_dsp_silence_with_energy(sc->dsp, frame, &totalsilence, &cur_energy);
+	}
+
 	/* Write the frame into the conference */
 	ast_mutex_lock(&sc->lock);
 
@@ -974,11 +1102,6 @@ static void softmix_bridge_write_voice(struct ast_bridge *bridge, struct ast_bri
 		ast_channel_unlock(bridge_channel->chan);
 	}
 
-	/* The channel will be leaving soon if there is no dsp. */
-	if (sc->dsp) {
-		silent = ast_dsp_silence_with_energy(sc->dsp, frame, &totalsilence, &cur_energy);
-	}
-
 	if (bridge->softmix.video_mode.mode == AST_BRIDGE_VIDEO_MODE_TALKER_SRC) {
 		int cur_slot = sc->video_talker.energy_history_cur_slot;
 
@@ -1009,6 +1132,10 @@ static void softmix_bridge_write_voice(struct ast_bridge *bridge, struct ast_bri
 	 * behind 4 times the amount of samples mixed on every iteration of the mixer, Re-sync
 	 * the audio by flushing the buffer before adding new audio in. */
 	if (ast_slinfactory_available(&sc->factory) > (4 * SOFTMIX_SAMPLES(softmix_data->internal_rate, softmix_data->internal_mixing_interval))) {
+		/* Count the flushed audio as dropped frames, one per mixing interval. */
+		ast_channel_drop_account(bridge_channel->chan, AST_FRAME_DROP_MIXING,
+			ast_slinfactory_available(&sc->factory)
+				/ SOFTMIX_SAMPLES(softmix_data->internal_rate, softmix_data->internal_mixing_interval));
 		ast_slinfactory_flush(&sc->factory);
 	}
 
@@ -1241,6 +1368,10 @@ static int softmix_bridge_write_control(struct ast_bridge *bridge, struct ast_br
 		clear_talking(bridge_channel);
 		break;
 	case AST_CONTROL_VIDUPDATE:
+		if (bridge->softmix.video_mode.mode == AST_BRIDGE_VIDEO_MODE_SFU
+			&& !softmix_sfu_route_video_update(bridge, bridge_channel, frame)) {
+			break;
+		}
 		if (!bridge->softmix.video_mode.video_update_discard ||
 			ast_tvdiff_ms(ast_tvnow(), softmix_data->last_video_update) > bridge->softmix.video_mode.video_update_discard) {
 			ast_bridge_queue_everyone_else(bridge, NULL, frame);
@@ -1306,6 +1437,96 @@ static void softmix_bridge_write_rtcp(struct ast_bridge *bridge, struct ast_brid
  *
  * \note On entry, bridge is already locked.
  */
+/*! \brief Function called when unattributed audio is injected into the bridge output */
+static int softmix_bridge_inject_sound(struct ast_bridge *bridge, struct ast_frame *frame)
+{
+	struct softmix_bridge_data *softmix_data = bridge->tech_pvt;
+
+	if (!softmix_data || frame->frametype != AST_FRAME_VOICE) {
+		return -1;
+	}
+
+	/* The factory translates to the internal slin rate as needed.  The
+	 * bridge lock held by our caller serializes feeding against the
+	 * mixing thread's drain and any rate change. */
+	if (!ast_slinfactory_feed(&softmix_data->announce_factory, frame)) {
+		return -1;
+	}
+	return 0;
+}
+
+/*! \brief Function called to attach a tap to the final mixed output */
+static int softmix_bridge_mix_tap_attach(struct ast_bridge *bridge, struct ast_bridge_mix_tap *tap)
+{
+	struct softmix_bridge_data *softmix_data = bridge->tech_pvt;
+
+	if (!softmix_data || !tap || !tap->deliver) {
+		return -1;
+	}
+
+	AST_LIST_INSERT_TAIL(&softmix_data->mix_taps, tap, entry);
+	return 0;
+}
+
+/*! \brief Function called to detach a tap from the final mixed output */
+static int softmix_bridge_mix_tap_detach(struct ast_bridge *bridge, struct ast_bridge_mix_tap *tap)
+{
+	struct softmix_bridge_data *softmix_data = bridge->tech_pvt;
+	struct ast_bridge_mix_tap *cur;
+
+	if (!softmix_data) {
+		return -1;
+	}
+
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&softmix_data->mix_taps, cur, entry) {
+		if (cur == tap) {
+			AST_LIST_REMOVE_CURRENT(entry);
+			if (tap->destroy) {
+				tap->destroy(tap);
+			}
+			return 0;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+
+	/* Not found; the tap detached itself from its deliver callback. */
+	return -1;
+}
+
+/*!
+ * \internal
+ * \brief Hand the final mixed buffer to any attached taps.
+ *
+ * Runs in the mixing loop's output stage with the bridge locked.  The
+ * frame wraps the loop's own mixing buffer, so a recording sink costs
+ * one write per interval instead of a full bridge member.
+ */
+static void softmix_pass_mix_taps(struct softmix_bridge_data *softmix_data,
+	struct ast_bridge *bridge, int16_t *buf, unsigned int datalen,
+	unsigned int samples, struct ast_format *slin_format)
+{
+	struct ast_bridge_mix_tap *tap;
+	struct ast_frame mix_frame = {
+		.frametype = AST_FRAME_VOICE,
+		.data.ptr = buf,
+		.datalen = datalen,
+		.samples = samples,
+		.src = "softmix_mix_tap",
+	};
+
+	mix_frame.subclass.format = slin_format;
+
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&softmix_data->mix_taps, tap, entry) {
+		if (tap->deliver(tap, bridge, &mix_frame)) {
+			AST_LIST_REMOVE_CURRENT(entry);
+			if (tap->destroy) {
+				tap->destroy(tap);
+			}
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+}
+
 static int softmix_bridge_write(struct ast_bridge *bridge, struct ast_bridge_channel *bridge_channel, struct ast_frame *frame)
 {
 	int res = 0;
@@ -1360,6 +1581,48 @@ static int softmix_bridge_write(struct ast_bridge *bridge, struct ast_bridge_cha
 	return res;
 }
 
+/*! Weight divisor for folding a new REMB estimate into the smoothed target. */
+#define SOFTMIX_REMB_EWMA_WEIGHT 8
+/*! Largest fraction of the target that may be shed in one send interval. */
+#define SOFTMIX_REMB_MAX_DECAY 4
+/*! Additive upward probe divisor applied when receivers report headroom. */
+#define SOFTMIX_REMB_PROBE_DIVISOR 32
+
+/*!
+ * \internal
+ * \brief Fold one interval's collected estimate into a smoothed bitrate target.
+ *
+ * Handing the collected estimate straight to the sources lets a single
+ * congested receiver collapse the target for the whole conference in
+ * one interval, and lets the target leap back up just as quickly, so
+ * encoders reconfigure constantly.  The target instead follows an EWMA
+ * of the estimates, may shed at most 1/4 of its value per interval no
+ * matter how bad the worst report is, and climbs by a bounded additive
+ * probe when receivers report headroom.
+ */
+static float softmix_controlled_bitrate(float target, float estimate)
+{
+	if (!target) {
+		return estimate;
+	}
+
+	if (estimate < target) {
+		float floor_rate = target - target / SOFTMIX_REMB_MAX_DECAY;
+
+		target += (estimate - target) / SOFTMIX_REMB_EWMA_WEIGHT;
+		if (target < floor_rate) {
+			target = floor_rate;
+		}
+	} else {
+		float step = (estimate - target) / SOFTMIX_REMB_EWMA_WEIGHT;
+		float probe = target / SOFTMIX_REMB_PROBE_DIVISOR;
+
+		target += MIN(step, probe);
+	}
+
+	return target;
+}
+
 static void remb_collect_report_all(struct ast_bridge *bridge, struct softmix_bridge_data *softmix_data,
 	float bitrate)
 {
@@ -1474,7 +1737,7 @@ static void remb_collect_report(struct ast_bridge *bridge, struct ast_bridge_cha
 static void remb_send_report(struct ast_bridge_channel *bridge_channel, struct softmix_bridge_data *softmix_data,
 	struct softmix_channel *sc)
 {
-	float bitrate = softmix_data->bitrate;
+	float bitrate;
 	int i;
 	int exp;
 
@@ -1482,10 +1745,18 @@ static void remb_send_report(struct ast_bridge_channel *bridge_channel, struct s
 		return;
 	}
 
-	/* If there is no bridge level bitrate fall back to collector level */
-	if (!bitrate) {
-		bitrate = sc->remb_collector->bitrate;
-		sc->remb_collector->bitrate = 0;
+	if (softmix_data->bitrate) {
+		/* Bridge level estimates are smoothed once per interval by the
+		 * mixing loop before reports go out. */
+		bitrate = softmix_data->target_bitrate;
+	} else {
+		/* Fall back to the collector level, smoothing per source. */
+		if (sc->remb_collector->bitrate) {
+			sc->remb_collector->target_bitrate = softmix_controlled_bitrate(
+				sc->remb_collector->target_bitrate, sc->remb_collector->bitrate);
+			sc->remb_collector->bitrate = 0;
+		}
+		bitrate = sc->remb_collector->target_bitrate;
 	}
 
 	/* We always do this calculation as even when the bitrate is zero the browser
@@ -1743,6 +2014,267 @@ static int softmix_mixing_array_grow(struct softmix_mixing_array *mixing_array,
 	return 0;
 }
 
+/*!
+ * \name Parallel mixing pool
+ *
+ * Large mixes spend almost all of their interval in the per-participant
+ * write pass (removing the participant's own audio, translating to the
+ * channel's write format, and queueing the frame), which the mixing
+ * thread used to walk serially.  Once a bridge reaches
+ * SOFTMIX_POOL_MIN_CHANNELS participants, that pass is sharded across a
+ * small pool of worker threads owned by the bridge.  Each worker has a
+ * private translate helper so cached translation paths are never shared
+ * between threads.
+ *
+ * The dispatching mixing thread holds the bridge lock for the duration
+ * of a job, so the channel list cannot change underneath the workers.
+ *
+ * @{
+ */
+
+/*! Bridges below this many participants keep the serial write pass. */
+#define SOFTMIX_POOL_MIN_CHANNELS 8
+
+/*! Upper bound on mixing workers per bridge. */
+#define SOFTMIX_POOL_MAX_THREADS 8
+
+struct softmix_mixing_pool {
+	pthread_t threads[SOFTMIX_POOL_MAX_THREADS];
+	/*! One translate helper per worker; cached paths are not thread safe. */
+	struct softmix_translate_helper helpers[SOFTMIX_POOL_MAX_THREADS];
+	/*! Sample rate each worker's helper was last configured for. */
+	unsigned int helper_rates[SOFTMIX_POOL_MAX_THREADS];
+	ast_mutex_t lock;
+	/*! Signaled to hand the workers a new job. */
+	ast_cond_t work;
+	/*! Signaled by the last worker to finish a job. */
+	ast_cond_t done;
+	unsigned int num_threads;
+	/*! Incremented per dispatched job so workers can spot new work. */
+	unsigned int generation;
+	/*! Workers still busy on the current job. */
+	unsigned int pending;
+	unsigned int stop:1;
+	/*! Current job; only valid between dispatch and completion. */
+	struct {
+		struct ast_bridge_channel **channels;
+		unsigned int num_channels;
+		int16_t *buf;
+		unsigned int datalen;
+		unsigned int samples;
+		unsigned int rate;
+		struct ast_format *slin;
+		unsigned int default_sample_size;
+	} job;
+	/*! Reusable scratch array the job's channel list is built in. */
+	struct ast_bridge_channel **channels;
+	unsigned int channels_len;
+};
+
+struct softmix_pool_worker_arg {
+	struct softmix_mixing_pool *pool;
+	unsigned int idx;
+};
+
+/*! \brief Run the write pass for a single channel of the current job. */
+static void softmix_pool_write_channel(struct softmix_mixing_pool *pool,
+	unsigned int worker, struct ast_bridge_channel *bridge_channel)
+{
+	struct softmix_channel *sc = bridge_channel->tech_pvt;
+
+	ast_mutex_lock(&sc->lock);
+	ao2_t_replace(sc->write_frame.subclass.format, pool->job.slin,
+		"Replace softmix channel slin format");
+	sc->write_frame.datalen = pool->job.datalen;
+	sc->write_frame.samples = pool->job.samples;
+	memcpy(sc->final_buf, pool->job.buf, pool->job.datalen);
+
+	softmix_process_write_audio(&pool->helpers[worker],
+		ast_channel_rawwriteformat(bridge_channel->chan), sc,
+		pool->job.default_sample_size);
+	ast_mutex_unlock(&sc->lock);
+
+	/* A frame is now ready for the channel. */
+	ast_bridge_channel_queue_frame(bridge_channel, &sc->write_frame);
+}
+
+static void *softmix_pool_worker(void *data)
+{
+	struct softmix_pool_worker_arg *arg = data;
+	struct softmix_mixing_pool *pool = arg->pool;
+	unsigned int worker = arg->idx;
+	unsigned int generation = 0;
+	unsigned int idx;
+
+	ast_free(arg);
+
+	ast_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->stop && pool->generation == generation) {
+			ast_cond_wait(&pool->work, &pool->lock);
+		}
+		if (pool->stop) {
+			break;
+		}
+		generation = pool->generation;
+		ast_mutex_unlock(&pool->lock);
+
+		if (pool->helper_rates[worker] != pool->job.rate) {
+			softmix_translate_helper_change_rate(&pool->helpers[worker],
+				pool->job.rate);
+			pool->helper_rates[worker] = pool->job.rate;
+		}
+		for (idx = worker; idx < pool->job.num_channels; idx += pool->num_threads) {
+			softmix_pool_write_channel(pool, worker, pool->job.channels[idx]);
+		}
+		softmix_translate_helper_cleanup(&pool->helpers[worker]);
+
+		ast_mutex_lock(&pool->lock);
+		if (!--pool->pending) {
+			ast_cond_signal(&pool->done);
+		}
+	}
+	ast_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+static void softmix_mixing_pool_destroy(struct softmix_mixing_pool *pool)
+{
+	unsigned int idx;
+
+	if (!pool) {
+		return;
+	}
+
+	ast_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	ast_cond_broadcast(&pool->work);
+	ast_mutex_unlock(&pool->lock);
+
+	for (idx = 0; idx < pool->num_threads; idx++) {
+		pthread_join(pool->threads[idx], NULL);
+		softmix_translate_helper_destroy(&pool->helpers[idx]);
+	}
+
+	ast_mutex_destroy(&pool->lock);
+	ast_cond_destroy(&pool->work);
+	ast_cond_destroy(&pool->done);
+	ast_free(pool->channels);
+	ast_free(pool);
+}
+
+static struct softmix_mixing_pool *softmix_mixing_pool_create(unsigned int rate)
+{
+	struct softmix_mixing_pool *pool;
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int num_threads;
+	unsigned int idx;
+
+	if (ncpus < 2) {
+		/* No point sharding on a single core. */
+		return NULL;
+	}
+	num_threads = MIN(ncpus, SOFTMIX_POOL_MAX_THREADS);
+
+	pool = ast_calloc(1, sizeof(*pool));
+	if (!pool) {
+		return NULL;
+	}
+	ast_mutex_init(&pool->lock);
+	ast_cond_init(&pool->work, NULL);
+	ast_cond_init(&pool->done, NULL);
+
+	for (idx = 0; idx < num_threads; idx++) {
+		struct softmix_pool_worker_arg *arg;
+
+		arg = ast_malloc(sizeof(*arg));
+		if (!arg) {
+			break;
+		}
+		arg->pool = pool;
+		arg->idx = idx;
+		softmix_translate_helper_init(&pool->helpers[idx], rate);
+		pool->helper_rates[idx] = rate;
+		if (ast_pthread_create_background(&pool->threads[idx], NULL,
+				softmix_pool_worker, arg)) {
+			softmix_translate_helper_destroy(&pool->helpers[idx]);
+			ast_free(arg);
+			break;
+		}
+		pool->num_threads = idx + 1;
+	}
+	if (!pool->num_threads) {
+		softmix_mixing_pool_destroy(pool);
+		return NULL;
+	}
+
+	return pool;
+}
+
+/*!
+ * \brief Run the write pass of one mixing interval across the pool.
+ *
+ * Must be called with the bridge locked.
+ *
+ * \retval 0 the pass was fully handled by the workers.
+ * \retval -1 the caller must fall back to the serial write pass.
+ */
+static int softmix_mixing_pool_write(struct softmix_mixing_pool *pool,
+	struct ast_bridge *bridge, int16_t *buf, unsigned int datalen,
+	unsigned int samples, struct ast_format *slin, unsigned int rate,
+	unsigned int default_sample_size)
+{
+	struct ast_bridge_channel *bridge_channel;
+	unsigned int num = 0;
+
+	if (pool->channels_len < bridge->num_channels) {
+		struct ast_bridge_channel **tmp;
+
+		tmp = ast_realloc(pool->channels,
+			(bridge->num_channels + 5) * sizeof(*tmp));
+		if (!tmp) {
+			return -1;
+		}
+		pool->channels = tmp;
+		pool->channels_len = bridge->num_channels + 5;
+	}
+
+	AST_LIST_TRAVERSE(&bridge->channels, bridge_channel, entry) {
+		struct softmix_channel *sc = bridge_channel->tech_pvt;
+
+		if (!sc || bridge_channel->suspended) {
+			/* This channel failed to join successfully or is suspended. */
+			continue;
+		}
+		pool->channels[num++] = bridge_channel;
+	}
+	if (!num) {
+		return 0;
+	}
+
+	ast_mutex_lock(&pool->lock);
+	pool->job.channels = pool->channels;
+	pool->job.num_channels = num;
+	pool->job.buf = buf;
+	pool->job.datalen = datalen;
+	pool->job.samples = samples;
+	pool->job.rate = rate;
+	pool->job.slin = slin;
+	pool->job.default_sample_size = default_sample_size;
+	pool->pending = pool->num_threads;
+	pool->generation++;
+	ast_cond_broadcast(&pool->work);
+	while (pool->pending) {
+		ast_cond_wait(&pool->done, &pool->lock);
+	}
+	ast_mutex_unlock(&pool->lock);
+
+	return 0;
+}
+
+/*! @} */
+
 /*!
  * \brief Mixing loop.
  *
@@ -1757,6 +2289,7 @@ static int softmix_mixing_loop(struct ast_bridge *bridge)
 	struct ast_timer *timer;
 	struct softmix_translate_helper trans_helper;
 	int16_t buf[MAX_DATALEN];
+	int16_t announce_buf[MAX_DATALEN];
 #ifdef BINAURAL_RENDERING
 	int16_t bin_buf[MAX_DATALEN];
 	int16_t ann_buf[MAX_DATALEN];
@@ -1765,7 +2298,6 @@ static int softmix_mixing_loop(struct ast_bridge *bridge)
 	int timingfd;
 	int update_all_rates = 0; /* set this when the internal sample rate has changed */
 	unsigned int idx;
-	unsigned int x;
 	int res = -1;
 
 	timer = softmix_data->timer;
@@ -1823,6 +2355,11 @@ static int softmix_mixing_loop(struct ast_bridge *bridge)
 		/* If the sample rate has changed, update the translator helper */
 		if (update_all_rates) {
 			softmix_translate_helper_change_rate(&trans_helper, softmix_data->internal_rate);
+			/* Restart the announcement factory at the new rate.  Any
+			 * buffered injected audio is dropped rather than played at
+			 * the wrong pitch. */
+			ast_slinfactory_destroy(&softmix_data->announce_factory);
+			ast_slinfactory_init_with_format(&softmix_data->announce_factory, cur_slin);
 		}
 
 #ifdef BINAURAL_RENDERING
@@ -1835,6 +2372,18 @@ static int softmix_mixing_loop(struct ast_bridge *bridge)
 			ast_tvdiff_ms(ast_tvnow(), softmix_data->last_remb_update) > bridge->softmix.video_mode.mode_data.sfu_data.remb_send_interval) {
 			remb_update = 1;
 			softmix_data->last_remb_update = ast_tvnow();
+			if (softmix_data->bitrate) {
+				/* Fold this interval's collected estimate into the smoothed
+				 * bridge level target before any reports go out.  A forced
+				 * bitrate is authoritative and bypasses the controller. */
+				if (bridge->softmix.video_mode.mode_data.sfu_data.remb_behavior
+					== AST_BRIDGE_VIDEO_SFU_REMB_FORCE) {
+					softmix_data->target_bitrate = softmix_data->bitrate;
+				} else {
+					softmix_data->target_bitrate = softmix_controlled_bitrate(
+						softmix_data->target_bitrate, softmix_data->bitrate);
+				}
+			}
 		}
 
 		/* Go through pulling audio from each factory that has it available */
@@ -1880,15 +2429,52 @@ static int softmix_mixing_loop(struct ast_bridge *bridge)
 		/* mix it like crazy (non binaural channels)*/
 		memset(buf, 0, softmix_datalen);
 		for (idx = 0; idx < mixing_array.used_entries; ++idx) {
-			for (x = 0; x < softmix_samples; ++x) {
-				ast_slinear_saturated_add(buf + x, mixing_array.buffers[idx] + x);
+			ast_slinear_saturated_add_block(buf, mixing_array.buffers[idx],
+				softmix_samples);
+		}
+
+		/* Mix in any injected announcement audio.  It is not attributed
+		 * to a channel, so every participant hears it in full. */
+		if (ast_slinfactory_available(&softmix_data->announce_factory)) {
+			int announce_samples;
+
+			announce_samples = ast_slinfactory_read(&softmix_data->announce_factory,
+				announce_buf, softmix_samples);
+			if (announce_samples > 0) {
+				ast_slinear_saturated_add_block(buf, announce_buf, announce_samples);
 			}
 		}
 
+		/* Hand the completed mix to any attached taps before the write
+		 * pass subtracts each participant's own audio. */
+		if (!AST_LIST_EMPTY(&softmix_data->mix_taps)) {
+			softmix_pass_mix_taps(softmix_data, bridge, buf, softmix_datalen,
+				softmix_samples, cur_slin);
+		}
+
 #ifdef BINAURAL_RENDERING
 		binaural_mixing(bridge, softmix_data, &mixing_array, bin_buf, ann_buf);
 #endif
 
+		/*
+		 * Shard the write pass across the mixing pool when the bridge
+		 * is big enough.  REMB updates and binaural rendering keep the
+		 * serial pass since they touch shared per-interval state.
+		 */
+		if (!remb_update && !bridge->softmix.binaural_active
+			&& bridge->num_channels >= SOFTMIX_POOL_MIN_CHANNELS
+			&& !softmix_data->mixing_pool) {
+			softmix_data->mixing_pool =
+				softmix_mixing_pool_create(softmix_data->internal_rate);
+		}
+		if (!remb_update && !bridge->softmix.binaural_active
+			&& bridge->num_channels >= SOFTMIX_POOL_MIN_CHANNELS
+			&& softmix_data->mixing_pool
+			&& !softmix_mixing_pool_write(softmix_data->mixing_pool, bridge,
+				buf, softmix_datalen, softmix_samples, cur_slin,
+				softmix_data->internal_rate, softmix_data->default_sample_size)) {
+			/* The write pass was fully handled by the pool workers. */
+		} else
 		/* Next step go through removing the channel's own audio and creating a good frame... */
 		AST_LIST_TRAVERSE(&bridge->channels, bridge_channel, entry) {
 			struct softmix_channel *sc = bridge_channel->tech_pvt;
@@ -2046,17 +2632,185 @@ static void *softmix_mixing_thread(void *data)
 
 	ast_bridge_unlock(bridge);
 
+	/* The worker thread outlives this bridge, so drop its callid. */
+	ast_callid_threadassoc_remove();
+
 	ast_debug(1, "Bridge %s: stopping mixing thread\n", bridge->uniqueid);
 
 	return NULL;
 }
 
+/*!
+ * \name Softmix mixing worker pool
+ *
+ * Short lived bridges pay dearly for opening a timer and spawning a
+ * mixing thread on every create and joining it on every destroy.  A
+ * small cache of parked workers, each owning a thread and a timer,
+ * lets those resources be reused across bridge lifecycles.
+ *
+ * @{
+ */
+
+/*! \brief Maximum number of parked workers kept for reuse */
+#define SOFTMIX_WORKER_CACHE_MAX 8
+
+/*! \brief A mixing thread and timer reused across bridge lifecycles */
+struct softmix_mixing_worker {
+	/*! Thread running the mixing loops */
+	pthread_t thread;
+	/*! Lock for signaling the parked worker */
+	ast_mutex_t lock;
+	/*! Condition the parked worker waits on */
+	ast_cond_t cond;
+	/*! Timer reused by every bridge served by this worker */
+	struct ast_timer *timer;
+	/*! Bridge data currently being mixed, NULL while parked */
+	struct softmix_bridge_data *softmix_data;
+	/*! TRUE if the worker thread should exit */
+	unsigned int shutdown:1;
+	AST_LIST_ENTRY(softmix_mixing_worker) entry;
+};
+
+/*! \brief Parked workers available for reuse */
+static AST_LIST_HEAD_STATIC(softmix_workers, softmix_mixing_worker);
+
+/*! \brief Number of parked workers */
+static unsigned int softmix_workers_size;
+
+static void *softmix_worker_thread(void *data)
+{
+	struct softmix_mixing_worker *worker = data;
+
+	ast_mutex_lock(&worker->lock);
+	while (!worker->shutdown) {
+		struct softmix_bridge_data *softmix_data = worker->softmix_data;
+
+		if (!softmix_data) {
+			ast_cond_wait(&worker->cond, &worker->lock);
+			continue;
+		}
+		ast_mutex_unlock(&worker->lock);
+
+		softmix_mixing_thread(softmix_data);
+
+		ast_mutex_lock(&worker->lock);
+		worker->softmix_data = NULL;
+		ast_mutex_unlock(&worker->lock);
+
+		/* Tell the destroyer the mixing loop has fully wound down. */
+		ast_mutex_lock(&softmix_data->lock);
+		softmix_data->mixing_done = 1;
+		ast_cond_signal(&softmix_data->cond);
+		ast_mutex_unlock(&softmix_data->lock);
+
+		ast_mutex_lock(&worker->lock);
+	}
+	ast_mutex_unlock(&worker->lock);
+
+	return NULL;
+}
+
+static void softmix_worker_destroy(struct softmix_mixing_worker *worker)
+{
+	ast_mutex_lock(&worker->lock);
+	worker->shutdown = 1;
+	ast_cond_signal(&worker->cond);
+	ast_mutex_unlock(&worker->lock);
+	pthread_join(worker->thread, NULL);
+	ast_timer_close(worker->timer);
+	ast_mutex_destroy(&worker->lock);
+	ast_cond_destroy(&worker->cond);
+	ast_free(worker);
+}
+
+/*!
+ * \internal
+ * \brief Get a parked worker, or create one if the cache is empty.
+ */
+static struct softmix_mixing_worker *softmix_worker_get(void)
+{
+	struct softmix_mixing_worker *worker;
+
+	AST_LIST_LOCK(&softmix_workers);
+	worker = AST_LIST_REMOVE_HEAD(&softmix_workers, entry);
+	if (worker) {
+		softmix_workers_size--;
+	}
+	AST_LIST_UNLOCK(&softmix_workers);
+	if (worker) {
+		return worker;
+	}
+
+	worker = ast_calloc(1, sizeof(*worker));
+	if (!worker) {
+		return NULL;
+	}
+	worker->timer = ast_timer_open();
+	if (!worker->timer) {
+		ast_free(worker);
+		return NULL;
+	}
+	ast_mutex_init(&worker->lock);
+	ast_cond_init(&worker->cond, NULL);
+	if (ast_pthread_create(&worker->thread, NULL, softmix_worker_thread, worker)) {
+		ast_timer_close(worker->timer);
+		ast_mutex_destroy(&worker->lock);
+		ast_cond_destroy(&worker->cond);
+		ast_free(worker);
+		return NULL;
+	}
+
+	return worker;
+}
+
+/*!
+ * \internal
+ * \brief Park a worker for reuse, or tear it down if the cache is full.
+ */
+static void softmix_worker_release(struct softmix_mixing_worker *worker)
+{
+	AST_LIST_LOCK(&softmix_workers);
+	if (softmix_workers_size < SOFTMIX_WORKER_CACHE_MAX) {
+		AST_LIST_INSERT_HEAD(&softmix_workers, worker, entry);
+		softmix_workers_size++;
+		worker = NULL;
+	}
+	AST_LIST_UNLOCK(&softmix_workers);
+	if (worker) {
+		softmix_worker_destroy(worker);
+	}
+}
+
+/*! \brief Tear down all parked workers on shutdown */
+static void softmix_workers_shutdown(void)
+{
+	struct softmix_mixing_worker *worker;
+
+	AST_LIST_LOCK(&softmix_workers);
+	while ((worker = AST_LIST_REMOVE_HEAD(&softmix_workers, entry))) {
+		softmix_workers_size--;
+		AST_LIST_UNLOCK(&softmix_workers);
+		softmix_worker_destroy(worker);
+		AST_LIST_LOCK(&softmix_workers);
+	}
+	AST_LIST_UNLOCK(&softmix_workers);
+}
+
+/*! @} */
+
 static void softmix_bridge_data_destroy(struct softmix_bridge_data *softmix_data)
 {
-	if (softmix_data->timer) {
-		ast_timer_close(softmix_data->timer);
-		softmix_data->timer = NULL;
+	struct ast_bridge_mix_tap *tap;
+
+	while ((tap = AST_LIST_REMOVE_HEAD(&softmix_data->mix_taps, entry))) {
+		if (tap->destroy) {
+			tap->destroy(tap);
+		}
 	}
+	/* The timer, if still set, is owned by the mixing worker. */
+	softmix_data->timer = NULL;
+	softmix_mixing_pool_destroy(softmix_data->mixing_pool);
+	ast_slinfactory_destroy(&softmix_data->announce_factory);
 	ast_mutex_destroy(&softmix_data->lock);
 	ast_cond_destroy(&softmix_data->cond);
 	AST_VECTOR_RESET(&softmix_data->remb_collectors, ao2_cleanup);
@@ -2076,15 +2830,18 @@ static int softmix_bridge_create(struct ast_bridge *bridge)
 	softmix_data->bridge = bridge;
 	ast_mutex_init(&softmix_data->lock);
 	ast_cond_init(&softmix_data->cond, NULL);
-	softmix_data->timer = ast_timer_open();
-	if (!softmix_data->timer) {
-		ast_log(AST_LOG_WARNING, "Failed to open timer for softmix bridge\n");
+	softmix_data->worker = softmix_worker_get();
+	if (!softmix_data->worker) {
+		ast_log(AST_LOG_WARNING, "Failed to get a mixing worker for softmix bridge\n");
 		softmix_bridge_data_destroy(softmix_data);
 		return -1;
 	}
+	softmix_data->timer = softmix_data->worker->timer;
 	/* start at minimum rate, let it grow from there */
 	softmix_data->internal_rate = SOFTMIX_MIN_SAMPLE_RATE;
 	softmix_data->internal_mixing_interval = DEFAULT_SOFTMIX_INTERVAL;
+	ast_slinfactory_init_with_format(&softmix_data->announce_factory,
+		ast_format_cache_get_slin_by_rate(softmix_data->internal_rate));
 
 #ifdef BINAURAL_RENDERING
 	softmix_data->default_sample_size = SOFTMIX_SAMPLES(softmix_data->internal_rate,
@@ -2095,14 +2852,11 @@ static int softmix_bridge_create(struct ast_bridge *bridge)
 
 	bridge->tech_pvt = softmix_data;
 
-	/* Start the mixing thread. */
-	if (ast_pthread_create(&softmix_data->thread, NULL, softmix_mixing_thread,
-		softmix_data)) {
-		softmix_data->thread = AST_PTHREADT_NULL;
-		softmix_bridge_data_destroy(softmix_data);
-		bridge->tech_pvt = NULL;
-		return -1;
-	}
+	/* Hand the bridge to the mixing worker. */
+	ast_mutex_lock(&softmix_data->worker->lock);
+	softmix_data->worker->softmix_data = softmix_data;
+	ast_cond_signal(&softmix_data->worker->cond);
+	ast_mutex_unlock(&softmix_data->worker->lock);
 
 	return 0;
 }
@@ -2132,24 +2886,25 @@ static void softmix_bridge_stop(struct ast_bridge *bridge)
 static void softmix_bridge_destroy(struct ast_bridge *bridge)
 {
 	struct softmix_bridge_data *softmix_data;
-	pthread_t thread;
 
 	softmix_data = bridge->tech_pvt;
 	if (!softmix_data) {
 		return;
 	}
 
-	/* Stop the mixing thread. */
+	/* Stop the mixing loop and wait for the worker to wind it down. */
 	ast_mutex_lock(&softmix_data->lock);
 	softmix_data->stop = 1;
 	ast_cond_signal(&softmix_data->cond);
-	thread = softmix_data->thread;
-	softmix_data->thread = AST_PTHREADT_NULL;
-	ast_mutex_unlock(&softmix_data->lock);
-	if (thread != AST_PTHREADT_NULL) {
-		ast_debug(1, "Bridge %s: Waiting for mixing thread to die.\n", bridge->uniqueid);
-		pthread_join(thread, NULL);
+	while (!softmix_data->mixing_done) {
+		ast_cond_wait(&softmix_data->cond, &softmix_data->lock);
 	}
+	ast_mutex_unlock(&softmix_data->lock);
+
+	/* The timer belongs to the worker and goes back with it. */
+	softmix_data->timer = NULL;
+	softmix_worker_release(softmix_data->worker);
+	softmix_data->worker = NULL;
 #ifdef BINAURAL_RENDERING
 	free_convolve_data(&softmix_data->convolve);
 #endif
@@ -2587,6 +3342,9 @@ static struct ast_bridge_technology softmix_bridge = {
 	.leave = softmix_bridge_leave,
 	.unsuspend = softmix_bridge_unsuspend,
 	.write = softmix_bridge_write,
+	.inject_sound = softmix_bridge_inject_sound,
+	.mix_tap_attach = softmix_bridge_mix_tap_attach,
+	.mix_tap_detach = softmix_bridge_mix_tap_detach,
 	.stream_topology_changed = softmix_bridge_stream_topology_changed,
 };
 
@@ -2875,6 +3633,7 @@ end:
 static int unload_module(void)
 {
 	ast_bridge_technology_unregister(&softmix_bridge);
+	softmix_workers_shutdown();
 	AST_TEST_UNREGISTER(sfu_append_source_streams);
 	AST_TEST_UNREGISTER(sfu_remove_destination_streams);
 	return 0;
@@ -127,6 +127,8 @@ struct video_follow_talker_data {
 };
 
 struct softmix_remb_collector;
+struct softmix_mixing_pool;
+struct softmix_mixing_worker;
 
 /*! \brief Structure which contains per-channel mixing information */
 struct softmix_channel {
@@ -179,6 +181,8 @@ struct softmix_channel {
 	struct softmix_remb_collector *remb_collector;
 	/*! The bridge streams which are feeding us video sources */
 	AST_VECTOR(, int) video_sources;
+	/*! Last time a keyframe request was forwarded to this video source (SFU mode) */
+	struct timeval last_keyframe_request;
 };
 
 struct softmix_bridge_data {
@@ -195,12 +199,14 @@ struct softmix_bridge_data {
 	ast_mutex_t lock;
 	/*! Condition, used if we need to wake up the mixing thread. */
 	ast_cond_t cond;
-	/*! Thread handling the mixing */
-	pthread_t thread;
+	/*! Mixing worker serving this bridge, owns the thread and timer */
+	struct softmix_mixing_worker *worker;
 	unsigned int internal_rate;
 	unsigned int internal_mixing_interval;
 	/*! TRUE if the mixing thread should stop */
 	unsigned int stop:1;
+	/*! TRUE once the worker has wound down the mixing loop */
+	unsigned int mixing_done:1;
 	/*! The default sample size (e.g. using Opus at 48khz and 20 ms mixing
 	 * interval, sample size is 960) */
 	unsigned int default_sample_size;
@@ -218,6 +224,18 @@ struct softmix_bridge_data {
 	AST_VECTOR(, struct softmix_remb_collector *) remb_collectors;
 	/*! Per-bridge REMB bitrate */
 	float bitrate;
+	/*! Smoothed per-bridge bitrate target actually sent to sources */
+	float target_bitrate;
+	/*! Worker pool sharding the write pass of large mixes, lazily
+	 *  created once the bridge is big enough to benefit. */
+	struct softmix_mixing_pool *mixing_pool;
+	/*! Unattributed audio injected into the mix (announcements, beeps).
+	 *  Fed by the inject_sound callback and drained by the mixing
+	 *  thread; both run with the bridge locked. */
+	struct ast_slinfactory announce_factory;
+	/*! Taps receiving the final mixed output each interval.  Attach,
+	 *  detach, and delivery all run with the bridge locked. */
+	AST_LIST_HEAD_NOLOCK(, ast_bridge_mix_tap) mix_taps;
 };
 
 struct softmix_mixing_array {
@@ -11660,8 +11660,9 @@ static void *do_monitor(void *data)
 			if ((i->subs[SUB_REAL].dfd > -1) && i->sig) {
 				if (i->radio && !i->owner)
 				{
-					res = dahdi_get_event(i->subs[SUB_REAL].dfd);
-					if (res)
+					/* Drain every pending event in this wakeup instead of taking
+					   one pass through the whole interface list per event */
+					while (!doomed && !i->owner && (res = dahdi_get_event(i->subs[SUB_REAL].dfd)) > 0)
 					{
 						ast_debug(1, "Monitor doohicky got event %s on radio channel %d\n", event2str(res), i->channel);
 						/* Don't hold iflock while handling init events */
@@ -11772,17 +11773,23 @@ static void *do_monitor(void *data)
 							ast_log(LOG_WARNING, "Whoa....  I'm owned but found (%d)...\n", i->subs[SUB_REAL].dfd);
 						continue;
 					}
-					res = dahdi_get_event(i->subs[SUB_REAL].dfd);
-					ast_debug(1, "Monitor doohicky got event %s on channel %d\n", event2str(res), i->channel);
-					/* Don't hold iflock while handling init events */
-					ast_mutex_unlock(&iflock);
-					if (0 == i->mwisendactive || 0 == mwi_send_process_event(i, res)) {
-						if (dahdi_analog_lib_handles(i->sig, i->radio, i->oprmode))
-							doomed = (struct dahdi_pvt *) analog_handle_init_event(i->sig_pvt, dahdievent_to_analogevent(res));
-						else
-							doomed = handle_init_event(i, res);
+					/* Drain every pending event in this wakeup instead of taking
+					   one poll round trip per event.  Stop as soon as the channel
+					   gains an owner or is doomed; any remaining events belong to
+					   the new owner thread or die with the channel. */
+					while (!doomed && !i->owner && !i->subs[SUB_REAL].owner
+						&& (res = dahdi_get_event(i->subs[SUB_REAL].dfd)) > 0) {
+						ast_debug(1, "Monitor doohicky got event %s on channel %d\n", event2str(res), i->channel);
+						/* Don't hold iflock while handling init events */
+						ast_mutex_unlock(&iflock);
+						if (0 == i->mwisendactive || 0 == mwi_send_process_event(i, res)) {
+							if (dahdi_analog_lib_handles(i->sig, i->radio, i->oprmode))
+								doomed = (struct dahdi_pvt *) analog_handle_init_event(i->sig_pvt, dahdievent_to_analogevent(res));
+							else
+								doomed = handle_init_event(i, res);
+						}
+						ast_mutex_lock(&iflock);
 					}
-					ast_mutex_lock(&iflock);
 				}
 			}
 		}
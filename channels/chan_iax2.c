@@ -10530,29 +10530,29 @@ static int socket_process_helper(struct iax2_thread *thread)
 				x = iaxs[fr->callno]->oseqno;
 			if ((x != iaxs[fr->callno]->oseqno) || (iaxs[fr->callno]->oseqno == fr->iseqno)) {
 				/* The acknowledgement is within our window.  Time to acknowledge everything
-				   that it says to */
-				for (x=iaxs[fr->callno]->rseqno; x != fr->iseqno; x++) {
-					/* Ack the packet with the given timestamp */
-					if (iaxdebug)
-						ast_debug(1, "Cancelling transmission of packet %d\n", x);
-					call_to_destroy = 0;
-					AST_LIST_TRAVERSE(&frame_queue[fr->callno], cur, list) {
-						/* If it's our call, and our timestamp, mark -1 retries */
-						if (x == cur->oseqno) {
-							cur->retries = -1;
-							/* Destroy call if this is the end */
-							if (cur->final)
-								call_to_destroy = fr->callno;
-						}
-					}
-					if (call_to_destroy) {
+				   that it says to.  A single pass over the frame queue with wrap-safe
+				   window arithmetic replaces one scan per acknowledged sequence number. */
+				unsigned char acked = (unsigned char) (fr->iseqno - iaxs[fr->callno]->rseqno);
+
+				call_to_destroy = 0;
+				AST_LIST_TRAVERSE(&frame_queue[fr->callno], cur, list) {
+					/* If it's our call, and within the acknowledged window, mark -1 retries */
+					if ((unsigned char) (cur->oseqno - iaxs[fr->callno]->rseqno) < acked) {
 						if (iaxdebug)
-							ast_debug(1, "Really destroying %d, having been acked on final message\n", call_to_destroy);
-						ast_mutex_lock(&iaxsl[call_to_destroy]);
-						iax2_destroy(call_to_destroy);
-						ast_mutex_unlock(&iaxsl[call_to_destroy]);
+							ast_debug(1, "Cancelling transmission of packet %d\n", cur->oseqno);
+						cur->retries = -1;
+						/* Destroy call if this is the end */
+						if (cur->final)
+							call_to_destroy = fr->callno;
 					}
 				}
+				if (call_to_destroy) {
+					if (iaxdebug)
+						ast_debug(1, "Really destroying %d, having been acked on final message\n", call_to_destroy);
+					ast_mutex_lock(&iaxsl[call_to_destroy]);
+					iax2_destroy(call_to_destroy);
+					ast_mutex_unlock(&iaxsl[call_to_destroy]);
+				}
 				/* Note how much we've received acknowledgement for */
 				if (iaxs[fr->callno])
 					iaxs[fr->callno]->rseqno = fr->iseqno;
@@ -51,8 +51,7 @@ static int alawtolin_framein(struct ast_trans_pvt *pvt, struct ast_frame *f)
 	pvt->samples += i;
 	pvt->datalen += i * 2;	/* 2 bytes/sample */
 
-	while (i--)
-		*dst++ = AST_ALAW(*src++);
+	ast_alaw_expand_block(dst, src, f->samples);
 
 	return 0;
 }
@@ -67,8 +66,7 @@ static int lintoalaw_framein(struct ast_trans_pvt *pvt, struct ast_frame *f)
 	pvt->samples += i;
 	pvt->datalen += i;	/* 1 byte/sample */
 
-	while (i--)
-		*dst++ = AST_LIN2A(*src++);
+	ast_alaw_compress_block((unsigned char *) dst, src, f->samples);
 
 	return 0;
 }
@@ -35,11 +35,244 @@
 #include "asterisk/module.h"
 #include "asterisk/translate.h"
 #include "asterisk/slin.h"
+#include "asterisk/linkedlists.h"
 
 #define OUTBUF_SAMPLES   11520
 
+/*! Speex resampler quality used for every pooled state */
+#define RESAMP_QUALITY   5
+
+/*! Idle resampler states kept per (src_rate, dst_rate, quality) pool */
+#define POOL_MAX_IDLE    8
+
 static struct ast_translator *translators;
 static int trans_size;
+
+/*!
+ * \internal
+ * \brief Pool of idle speex resampler states for one rate pair.
+ *
+ * Creating a speex resampler computes its filter tables from scratch,
+ * which shows up when conference bridges churn through translation
+ * paths.  Instead of destroying states we park up to POOL_MAX_IDLE of
+ * them per (src_rate, dst_rate, quality) key and hand them back out
+ * after a cheap speex_resampler_reset_mem().
+ */
+struct state_pool {
+	unsigned int src_rate;
+	unsigned int dst_rate;
+	unsigned int quality;
+	unsigned int idle;
+	AST_LIST_HEAD_NOLOCK(, cached_state) states;
+};
+
+struct cached_state {
+	SpeexResamplerState *state;
+	AST_LIST_ENTRY(cached_state) list;
+};
+
+static struct state_pool *pools;
+AST_MUTEX_DEFINE_STATIC(pool_lock);
+
+static struct state_pool *pool_find(unsigned int src_rate, unsigned int dst_rate, unsigned int quality)
+{
+	int idx;
+
+	for (idx = 0; idx < trans_size; idx++) {
+		if (pools[idx].src_rate == src_rate && pools[idx].dst_rate == dst_rate
+			&& pools[idx].quality == quality) {
+			return &pools[idx];
+		}
+	}
+
+	return NULL;
+}
+
+static SpeexResamplerState *pool_get(unsigned int src_rate, unsigned int dst_rate, unsigned int quality)
+{
+	struct state_pool *pool = pool_find(src_rate, dst_rate, quality);
+	struct cached_state *cached = NULL;
+	SpeexResamplerState *state;
+	int err;
+
+	if (pool) {
+		ast_mutex_lock(&pool_lock);
+		cached = AST_LIST_REMOVE_HEAD(&pool->states, list);
+		if (cached) {
+			pool->idle--;
+		}
+		ast_mutex_unlock(&pool_lock);
+	}
+
+	if (cached) {
+		state = cached->state;
+		ast_free(cached);
+		speex_resampler_reset_mem(state);
+		return state;
+	}
+
+	return speex_resampler_init(1, src_rate, dst_rate, quality, &err);
+}
+
+static void pool_put(unsigned int src_rate, unsigned int dst_rate, unsigned int quality,
+	SpeexResamplerState *state)
+{
+	struct state_pool *pool = pool_find(src_rate, dst_rate, quality);
+	struct cached_state *cached;
+
+	if (pool && pool->idle < POOL_MAX_IDLE && (cached = ast_malloc(sizeof(*cached)))) {
+		cached->state = state;
+		ast_mutex_lock(&pool_lock);
+		AST_LIST_INSERT_HEAD(&pool->states, cached, list);
+		pool->idle++;
+		ast_mutex_unlock(&pool_lock);
+		return;
+	}
+
+	speex_resampler_destroy(state);
+}
+
+static void pool_drain(void)
+{
+	struct cached_state *cached;
+	int idx;
+
+	ast_mutex_lock(&pool_lock);
+	for (idx = 0; idx < trans_size; idx++) {
+		while ((cached = AST_LIST_REMOVE_HEAD(&pools[idx].states, list))) {
+			speex_resampler_destroy(cached->state);
+			ast_free(cached);
+		}
+		pools[idx].idle = 0;
+	}
+	ast_mutex_unlock(&pool_lock);
+}
+
+/*!
+ * \name Fixed halfband path for 8 kHz <-> 16 kHz
+ *
+ * Mixed-rate conference bridges make slin 8k<->16k our most
+ * instantiated translator, and a rate factor of exactly two does not
+ * need a general-purpose resampler at all.  These paths run a fixed
+ * 43-tap polyphase halfband FIR (Kaiser-windowed sinc, Q15): upsampling
+ * emits the symmetric-phase output plus a pure delay, downsampling
+ * folds the center tap with the even history taps.  Stopband rejection
+ * is about 36 dB from 4.6 kHz up, under 0.25 dB ripple across the
+ * telephony passband.
+ *
+ * @{
+ */
+
+/*! Delay-line ring size; must cover the 43-tap span at 16 kHz */
+#define HB_HIST_MASK     63
+
+/*! Symmetric odd taps, scaled by two for the interpolator (Q15) */
+static const int32_t hb_up_taps[] = {
+	6, -31, 90, -205, 405, -731, 1244, -2059, 3464, -6507, 20708,
+	20708, -6507, 3464, -2059, 1244, -731, 405, -205, 90, -31, 6,
+};
+
+/*! Symmetric odd taps for the decimator (Q15); the center tap is 16384 */
+static const int32_t hb_down_taps[] = {
+	3, -16, 45, -103, 203, -366, 622, -1030, 1732, -3253, 10355,
+	10355, -3253, 1732, -1030, 622, -366, 203, -103, 45, -16, 3,
+};
+
+struct resamp_pvt {
+	/*! NULL on the fixed halfband paths */
+	SpeexResamplerState *speex;
+	/*! Next write position in the halfband delay line */
+	unsigned int pos;
+	/*! Halfband delay line */
+	int16_t hist[HB_HIST_MASK + 1];
+};
+
+static int16_t hb_saturate(int32_t acc)
+{
+	acc >>= 15;
+	if (acc > 32767) {
+		return 32767;
+	}
+	if (acc < -32768) {
+		return -32768;
+	}
+	return acc;
+}
+
+static int hb_up_framein(struct ast_trans_pvt *pvt, struct ast_frame *f)
+{
+	struct resamp_pvt *resamp = pvt->pvt;
+	const int16_t *src = f->data.ptr;
+	int16_t *dst = pvt->outbuf.i16 + pvt->samples;
+	unsigned int in_samples;
+	unsigned int i, m;
+
+	if (!f->datalen) {
+		return -1;
+	}
+	in_samples = f->datalen / 2;
+
+	for (i = 0; i < in_samples; i++) {
+		int32_t acc = 1 << 14;
+
+		resamp->hist[resamp->pos & HB_HIST_MASK] = src[i];
+		for (m = 0; m < ARRAY_LEN(hb_up_taps); m++) {
+			acc += hb_up_taps[m] * resamp->hist[(resamp->pos - m) & HB_HIST_MASK];
+		}
+		*dst++ = hb_saturate(acc);
+		*dst++ = resamp->hist[(resamp->pos - 10) & HB_HIST_MASK];
+		resamp->pos++;
+	}
+
+	pvt->samples += in_samples * 2;
+	pvt->datalen += in_samples * 4;
+
+	return 0;
+}
+
+static int hb_down_framein(struct ast_trans_pvt *pvt, struct ast_frame *f)
+{
+	struct resamp_pvt *resamp = pvt->pvt;
+	const int16_t *src = f->data.ptr;
+	int16_t *dst = pvt->outbuf.i16 + pvt->samples;
+	unsigned int in_samples;
+	unsigned int out_samples = 0;
+	unsigned int i, m;
+
+	if (!f->datalen) {
+		return -1;
+	}
+	in_samples = f->datalen / 2;
+
+	for (i = 0; i < in_samples; i++) {
+		resamp->hist[resamp->pos & HB_HIST_MASK] = src[i];
+		/* Decimate: produce one output per even-indexed input sample. */
+		if (!(resamp->pos & 1)) {
+			int32_t acc = 1 << 14;
+
+			acc += 16384 * resamp->hist[(resamp->pos - 21) & HB_HIST_MASK];
+			for (m = 0; m < ARRAY_LEN(hb_down_taps); m++) {
+				acc += hb_down_taps[m] * resamp->hist[(resamp->pos - 2 * m) & HB_HIST_MASK];
+			}
+			*dst++ = hb_saturate(acc);
+			out_samples++;
+		}
+		resamp->pos++;
+	}
+
+	pvt->samples += out_samples;
+	pvt->datalen += out_samples * 2;
+
+	return 0;
+}
+
+/*! @} */
+
+static int rate_pair_is_halfband(unsigned int src_rate, unsigned int dst_rate)
+{
+	return (src_rate == 8000 && dst_rate == 16000)
+		|| (src_rate == 16000 && dst_rate == 8000);
+}
 static struct ast_codec codec_list[] = {
 	{
 		.name = "slin",
@@ -90,28 +323,34 @@ static struct ast_codec codec_list[] = {
 
 static int resamp_new(struct ast_trans_pvt *pvt)
 {
-	int err;
+	struct resamp_pvt *resamp = pvt->pvt;
+	unsigned int src_rate = pvt->t->src_codec.sample_rate;
+	unsigned int dst_rate = pvt->t->dst_codec.sample_rate;
 
-	if (!(pvt->pvt = speex_resampler_init(1, pvt->t->src_codec.sample_rate, pvt->t->dst_codec.sample_rate, 5, &err))) {
+	if (!rate_pair_is_halfband(src_rate, dst_rate)
+		&& !(resamp->speex = pool_get(src_rate, dst_rate, RESAMP_QUALITY))) {
 		return -1;
 	}
 
 	ast_assert(pvt->f.subclass.format == NULL);
-	pvt->f.subclass.format = ao2_bump(ast_format_cache_get_slin_by_rate(pvt->t->dst_codec.sample_rate));
+	pvt->f.subclass.format = ao2_bump(ast_format_cache_get_slin_by_rate(dst_rate));
 
 	return 0;
 }
 
 static void resamp_destroy(struct ast_trans_pvt *pvt)
 {
-	SpeexResamplerState *resamp_pvt = pvt->pvt;
+	struct resamp_pvt *resamp = pvt->pvt;
 
-	speex_resampler_destroy(resamp_pvt);
+	if (resamp->speex) {
+		pool_put(pvt->t->src_codec.sample_rate, pvt->t->dst_codec.sample_rate,
+			RESAMP_QUALITY, resamp->speex);
+	}
 }
 
 static int resamp_framein(struct ast_trans_pvt *pvt, struct ast_frame *f)
 {
-	SpeexResamplerState *resamp_pvt = pvt->pvt;
+	struct resamp_pvt *resamp = pvt->pvt;
 	unsigned int out_samples = OUTBUF_SAMPLES - pvt->samples;
 	unsigned int in_samples;
 
@@ -120,7 +359,7 @@ static int resamp_framein(struct ast_trans_pvt *pvt, struct ast_frame *f)
 	}
 	in_samples = f->datalen / 2;
 
-	speex_resampler_process_int(resamp_pvt,
+	speex_resampler_process_int(resamp->speex,
 		0,
 		f->data.ptr,
 		&in_samples,
@@ -141,6 +380,8 @@ static int unload_module(void)
 	for (idx = 0; idx < trans_size; idx++) {
 		res |= ast_unregister_translator(&translators[idx]);
 	}
+	pool_drain();
+	ast_free(pools);
 	ast_free(translators);
 
 	return res;
@@ -155,16 +396,27 @@ static int load_module(void)
 	if (!(translators = ast_calloc(1, sizeof(struct ast_translator) * trans_size))) {
 		return AST_MODULE_LOAD_DECLINE;
 	}
+	if (!(pools = ast_calloc(1, sizeof(struct state_pool) * trans_size))) {
+		ast_free(translators);
+		return AST_MODULE_LOAD_DECLINE;
+	}
 
 	for (x = 0; x < ARRAY_LEN(codec_list); x++) {
 		for (y = 0; y < ARRAY_LEN(codec_list); y++) {
 			if (x == y) {
 				continue;
 			}
+			pools[idx].src_rate = codec_list[x].sample_rate;
+			pools[idx].dst_rate = codec_list[y].sample_rate;
+			pools[idx].quality = RESAMP_QUALITY;
 			translators[idx].newpvt = resamp_new;
 			translators[idx].destroy = resamp_destroy;
-			translators[idx].framein = resamp_framein;
-			translators[idx].desc_size = 0;
+			translators[idx].framein = rate_pair_is_halfband(codec_list[x].sample_rate,
+				codec_list[y].sample_rate)
+				? (codec_list[x].sample_rate < codec_list[y].sample_rate
+					? hb_up_framein : hb_down_framein)
+				: resamp_framein;
+			translators[idx].desc_size = sizeof(struct resamp_pvt);
 			translators[idx].buffer_samples = OUTBUF_SAMPLES;
 			translators[idx].buf_size = (OUTBUF_SAMPLES * sizeof(int16_t));
 			memcpy(&translators[idx].src_codec, &codec_list[x], sizeof(struct ast_codec));
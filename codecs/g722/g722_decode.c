@@ -37,6 +37,10 @@
 
 #include "g722.h"
 
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
 #if !defined(FALSE)
 #define FALSE 0
 #endif
@@ -44,6 +48,104 @@
 #define TRUE (!FALSE)
 #endif
 
+/*! Output samples handled per receive QMF block */
+#define G722_QMF_CHUNK 320
+
+#if defined(__x86_64__)
+/* Compute both receive QMF outputs for a block of band sample pairs.  The
+   filter is laid out with sum/difference coefficient pairs so that one
+   pmaddwd pass yields (xout1 + xout2) and a second (xout1 - xout2), from
+   which both outputs are recovered exactly. */
+static void qmf_synthesis_block(const int16_t hist[], int pairs, int16_t amp[])
+{
+    static const int16_t coef_sum[24] =
+    {
+          3,  -11,  -11,   53,   12, -156,   32,  362,
+       -210, -805,  951, 3876, 3876,  951, -805, -210,
+        362,   32, -156,   12,   53,  -11,  -11,    3
+    };
+    static const int16_t coef_diff[24] =
+    {
+         -3,  -11,   11,   53,  -12, -156,  -32,  362,
+        210, -805, -951, 3876,-3876,  951,  805, -210,
+       -362,   32,  156,   12,  -53,  -11,   11,    3
+    };
+    const __m128i cs0 = _mm_loadu_si128((const __m128i *) &coef_sum[0]);
+    const __m128i cs1 = _mm_loadu_si128((const __m128i *) &coef_sum[8]);
+    const __m128i cs2 = _mm_loadu_si128((const __m128i *) &coef_sum[16]);
+    const __m128i cd0 = _mm_loadu_si128((const __m128i *) &coef_diff[0]);
+    const __m128i cd1 = _mm_loadu_si128((const __m128i *) &coef_diff[8]);
+    const __m128i cd2 = _mm_loadu_si128((const __m128i *) &coef_diff[16]);
+    int k;
+
+    for (k = 0;  k < pairs;  k++)
+    {
+        const int16_t *w = hist + 2*k;
+        __m128i w0 = _mm_loadu_si128((const __m128i *) w);
+        __m128i w1 = _mm_loadu_si128((const __m128i *) (w + 8));
+        __m128i w2 = _mm_loadu_si128((const __m128i *) (w + 16));
+        __m128i ss = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(w0, cs0),
+            _mm_madd_epi16(w1, cs1)), _mm_madd_epi16(w2, cs2));
+        __m128i dd = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(w0, cd0),
+            _mm_madd_epi16(w1, cd1)), _mm_madd_epi16(w2, cd2));
+        /* Horizontal reduction of both accumulators at once */
+        __m128i t = _mm_add_epi32(_mm_unpacklo_epi32(ss, dd),
+            _mm_unpackhi_epi32(ss, dd));
+        int xsum;
+        int xdiff;
+
+        t = _mm_add_epi32(t, _mm_shuffle_epi32(t, _MM_SHUFFLE(1, 0, 3, 2)));
+        xsum = _mm_cvtsi128_si32(t);
+        xdiff = _mm_cvtsi128_si32(_mm_shuffle_epi32(t, _MM_SHUFFLE(0, 0, 0, 1)));
+        /* (xsum + xdiff) is exactly 2*xout1, so the extra shift folds the
+           halving into the output scaling */
+        amp[2*k] = (int16_t) ((xsum + xdiff) >> 12);
+        amp[2*k + 1] = (int16_t) ((xsum - xdiff) >> 12);
+    }
+}
+#else
+static void qmf_synthesis_block(const int16_t hist[], int pairs, int16_t amp[])
+{
+    static const int qmf_coeffs[12] =
+    {
+           3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
+    };
+    int xout1;
+    int xout2;
+    int i;
+    int k;
+
+    for (k = 0;  k < pairs;  k++)
+    {
+        const int16_t *w = hist + 2*k;
+
+        xout1 = 0;
+        xout2 = 0;
+        for (i = 0;  i < 12;  i++)
+        {
+            xout2 += w[2*i]*qmf_coeffs[i];
+            xout1 += w[2*i + 1]*qmf_coeffs[11 - i];
+        }
+        amp[2*k] = (int16_t) (xout1 >> 11);
+        amp[2*k + 1] = (int16_t) (xout2 >> 11);
+    }
+}
+#endif
+/*- End of function --------------------------------------------------------*/
+
+/* Flush queued band sample pairs through the receive QMF and roll the
+   filter history forward */
+static int qmf_synthesis_flush(g722_decode_state_t *s, const int16_t hist[], int pairs, int16_t amp[])
+{
+    int i;
+
+    qmf_synthesis_block(hist, pairs, amp);
+    for (i = 0;  i < 24;  i++)
+        s->x[i] = hist[2*pairs - 2 + i];
+    return 2*pairs;
+}
+/*- End of function --------------------------------------------------------*/
+
 static __inline__ int16_t saturate(int32_t amp)
 {
     int16_t amp16;
@@ -235,18 +337,11 @@ int g722_decode(g722_decode_state_t *s, int16_t amp[], const uint8_t g722_data[]
            1688,   1360,   1040,    728,
             432,    136,   -432,   -136
     };
-    static const int qmf_coeffs[12] =
-    {
-           3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
-    };
-
     int dlowt;
     int rlow;
     int ihigh;
     int dhigh;
     int rhigh;
-    int xout1;
-    int xout2;
     int wd1;
     int wd2;
     int wd3;
@@ -254,9 +349,13 @@ int g722_decode(g722_decode_state_t *s, int16_t amp[], const uint8_t g722_data[]
     int outlen;
     int i;
     int j;
+    int pairs;
+    /* QMF history plus one block of queued band sample pairs */
+    int16_t hist[22 + G722_QMF_CHUNK];
 
     outlen = 0;
     rhigh = 0;
+    pairs = 0;
     for (j = 0;  j < len;  )
     {
         if (s->packed)
@@ -374,24 +473,26 @@ int g722_decode(g722_decode_state_t *s, int16_t amp[], const uint8_t g722_data[]
             }
             else
             {
-                /* Apply the receive QMF */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                s->x[22] = rlow + rhigh;
-                s->x[23] = rlow - rhigh;
-
-                xout1 = 0;
-                xout2 = 0;
-                for (i = 0;  i < 12;  i++)
+                /* Queue for the receive QMF, which runs across whole
+                   blocks instead of shuffling the filter history down
+                   for every sample pair */
+                if (pairs == 0)
+                {
+                    for (i = 0;  i < 22;  i++)
+                        hist[i] = (int16_t) s->x[i + 2];
+                }
+                hist[22 + 2*pairs] = (int16_t) (rlow + rhigh);
+                hist[23 + 2*pairs] = (int16_t) (rlow - rhigh);
+                if (++pairs == G722_QMF_CHUNK/2)
                 {
-                    xout2 += s->x[2*i]*qmf_coeffs[i];
-                    xout1 += s->x[2*i + 1]*qmf_coeffs[11 - i];
+                    outlen += qmf_synthesis_flush(s, hist, pairs, amp + outlen);
+                    pairs = 0;
                 }
-                amp[outlen++] = (int16_t) (xout1 >> 11);
-                amp[outlen++] = (int16_t) (xout2 >> 11);
             }
         }
     }
+    if (pairs)
+        outlen += qmf_synthesis_flush(s, hist, pairs, amp + outlen);
     return outlen;
 }
 /*- End of function --------------------------------------------------------*/
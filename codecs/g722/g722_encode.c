@@ -39,6 +39,10 @@
 
 #include "g722.h"
 
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
 #if !defined(FALSE)
 #define FALSE 0
 #endif
@@ -46,6 +50,85 @@
 #define TRUE (!FALSE)
 #endif
 
+/*! Input samples handled per transmit QMF block */
+#define G722_QMF_CHUNK 320
+
+#if defined(__x86_64__)
+/* Compute both QMF branch sums for a block of sample pairs.  The filter is
+   laid out with sum/difference coefficient pairs so that one pmaddwd pass
+   yields (sumeven + sumodd) and a second yields (sumeven - sumodd), which
+   are exactly the low and high band outputs before the final shift. */
+static void qmf_analysis_block(const int16_t hist[], int pairs, int xlow[], int xhigh[])
+{
+    static const int16_t coef_sum[24] =
+    {
+          3,  -11,  -11,   53,   12, -156,   32,  362,
+       -210, -805,  951, 3876, 3876,  951, -805, -210,
+        362,   32, -156,   12,   53,  -11,  -11,    3
+    };
+    static const int16_t coef_diff[24] =
+    {
+         -3,  -11,   11,   53,  -12, -156,  -32,  362,
+        210, -805, -951, 3876,-3876,  951,  805, -210,
+       -362,   32,  156,   12,  -53,  -11,   11,    3
+    };
+    const __m128i cs0 = _mm_loadu_si128((const __m128i *) &coef_sum[0]);
+    const __m128i cs1 = _mm_loadu_si128((const __m128i *) &coef_sum[8]);
+    const __m128i cs2 = _mm_loadu_si128((const __m128i *) &coef_sum[16]);
+    const __m128i cd0 = _mm_loadu_si128((const __m128i *) &coef_diff[0]);
+    const __m128i cd1 = _mm_loadu_si128((const __m128i *) &coef_diff[8]);
+    const __m128i cd2 = _mm_loadu_si128((const __m128i *) &coef_diff[16]);
+    int k;
+
+    for (k = 0;  k < pairs;  k++)
+    {
+        const int16_t *w = hist + 2*k;
+        __m128i w0 = _mm_loadu_si128((const __m128i *) w);
+        __m128i w1 = _mm_loadu_si128((const __m128i *) (w + 8));
+        __m128i w2 = _mm_loadu_si128((const __m128i *) (w + 16));
+        __m128i ss = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(w0, cs0),
+            _mm_madd_epi16(w1, cs1)), _mm_madd_epi16(w2, cs2));
+        __m128i dd = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(w0, cd0),
+            _mm_madd_epi16(w1, cd1)), _mm_madd_epi16(w2, cd2));
+        /* Horizontal reduction of both accumulators at once */
+        __m128i t = _mm_add_epi32(_mm_unpacklo_epi32(ss, dd),
+            _mm_unpackhi_epi32(ss, dd));
+
+        t = _mm_add_epi32(t, _mm_shuffle_epi32(t, _MM_SHUFFLE(1, 0, 3, 2)));
+        xlow[k] = _mm_cvtsi128_si32(t) >> 14;
+        xhigh[k] = _mm_cvtsi128_si32(_mm_shuffle_epi32(t, _MM_SHUFFLE(0, 0, 0, 1))) >> 14;
+    }
+}
+#else
+static void qmf_analysis_block(const int16_t hist[], int pairs, int xlow[], int xhigh[])
+{
+    static const int qmf_coeffs[12] =
+    {
+           3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
+    };
+    int sumeven;
+    int sumodd;
+    int i;
+    int k;
+
+    for (k = 0;  k < pairs;  k++)
+    {
+        const int16_t *w = hist + 2*k;
+
+        sumeven = 0;
+        sumodd = 0;
+        for (i = 0;  i < 12;  i++)
+        {
+            sumodd += w[2*i]*qmf_coeffs[i];
+            sumeven += w[2*i + 1]*qmf_coeffs[11 - i];
+        }
+        xlow[k] = (sumeven + sumodd) >> 14;
+        xhigh[k] = (sumeven - sumodd) >> 14;
+    }
+}
+#endif
+/*- End of function --------------------------------------------------------*/
+
 static __inline__ int16_t saturate(int32_t amp)
 {
     int16_t amp16;
@@ -232,10 +315,6 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[], const int16_t amp[]
     {
         -7408,  -1616,   7408,   1616
     };
-    static const int qmf_coeffs[12] =
-    {
-           3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
-    };
     static const int ihn[3] = {0, 1, 0};
     static const int ihp[3] = {0, 3, 2};
     static const int wh[3] = {0, -214, 798};
@@ -255,19 +334,24 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[], const int16_t amp[]
     int mih;
     int i;
     int j;
+    int k;
     /* Low and high band PCM from the QMF */
     int xlow;
     int xhigh;
     int g722_bytes;
-    /* Even and odd tap accumulators */
-    int sumeven;
-    int sumodd;
     int ihigh;
     int ilow;
     int code;
+    int pairs;
+    /* QMF history plus one block of input */
+    int16_t hist[22 + G722_QMF_CHUNK];
+    int xlowbuf[G722_QMF_CHUNK/2];
+    int xhighbuf[G722_QMF_CHUNK/2];
 
     g722_bytes = 0;
     xhigh = 0;
+    pairs = 0;
+    k = 0;
     for (j = 0;  j < len;  )
     {
         if (s->itu_test_mode)
@@ -283,23 +367,29 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[], const int16_t amp[]
             }
             else
             {
-                /* Apply the transmit QMF */
-                /* Shuffle the buffer down */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                s->x[22] = amp[j++];
-                s->x[23] = amp[j++];
-
-                /* Discard every other QMF output */
-                sumeven = 0;
-                sumodd = 0;
-                for (i = 0;  i < 12;  i++)
+                if (k == pairs)
                 {
-                    sumodd += s->x[2*i]*qmf_coeffs[i];
-                    sumeven += s->x[2*i + 1]*qmf_coeffs[11 - i];
+                    /* Apply the transmit QMF across a whole block ahead
+                       of the serial quantizer, instead of shuffling the
+                       filter history down for every sample pair. */
+                    pairs = (len - j) >> 1;
+                    if (pairs > G722_QMF_CHUNK/2)
+                        pairs = G722_QMF_CHUNK/2;
+                    if (pairs == 0)
+                        break;
+                    for (i = 0;  i < 22;  i++)
+                        hist[i] = (int16_t) s->x[i + 2];
+                    memcpy(&hist[22], &amp[j], 2*pairs*sizeof(int16_t));
+                    qmf_analysis_block(hist, pairs, xlowbuf, xhighbuf);
+                    for (i = 0;  i < 24;  i++)
+                        s->x[i] = hist[2*pairs - 2 + i];
+                    k = 0;
                 }
-                xlow = (sumeven + sumodd) >> 14;
-                xhigh = (sumeven - sumodd) >> 14;
+                /* Discard every other QMF output */
+                xlow = xlowbuf[k];
+                xhigh = xhighbuf[k];
+                k++;
+                j += 2;
             }
         }
         /* Block 1L, SUBTRA */
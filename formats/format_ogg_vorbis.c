@@ -55,6 +55,17 @@
 
 #define BLOCK_SIZE 4096		/* used internally in the vorbis routines */
 
+/*! Aim for one seek index entry per second of audio */
+#define OGG_INDEX_INTERVAL DEFAULT_SAMPLE_RATE
+/*! Upper bound on index entries per stream (larger files stay coarser) */
+#define OGG_INDEX_MAX_ENTRIES 4096
+
+/*! \brief One lazily recorded mapping of pcm position to raw byte offset */
+struct ogg_index_entry {
+	ogg_int64_t pcm;
+	ogg_int64_t raw;
+};
+
 struct ogg_vorbis_desc {	/* format specific parameters */
 	/* OggVorbis_File structure for libvorbisfile interface */
 	OggVorbis_File ov_f;
@@ -78,6 +89,13 @@ struct ogg_vorbis_desc {	/* format specific parameters */
 
 	/*! \brief Indicates whether an End of Stream condition has been detected. */
 	int eos;
+
+	/*! \brief Seek index built lazily while reading, sorted by pcm position.
+	 * Lets repeated seeks land near their target with ov_raw_seek() instead
+	 * of bisecting and decoding through the file every time. */
+	struct ogg_index_entry *index;
+	int index_len;
+	int index_alloc;
 };
 
 #if !defined(HAVE_VORBIS_OPEN_CALLBACKS)
@@ -285,9 +303,128 @@ static void ogg_vorbis_close(struct ast_filestream *fs)
 	} else {
 		/* clear OggVorbis_File handle */
 		ov_clear(&s->ov_f);
+		ast_free(s->index);
+		s->index = NULL;
 	}
 }
 
+/*!
+ * \brief Record the decoder's current pcm/raw position pair in the seek index.
+ * \param desc The private description of the filestream being read.
+ *
+ * Entries are kept sorted by pcm position and only added when no neighbour
+ * already covers the same stretch of audio, so scrubbing back and forth
+ * densifies the index without letting it grow past OGG_INDEX_MAX_ENTRIES.
+ */
+static void ogg_vorbis_index_record(struct ogg_vorbis_desc *desc)
+{
+	ogg_int64_t pcm = ov_pcm_tell(&desc->ov_f);
+	ogg_int64_t raw = ov_raw_tell(&desc->ov_f);
+	int lo = 0, hi = desc->index_len;
+
+	if (pcm < 0 || raw < 0 || desc->index_len >= OGG_INDEX_MAX_ENTRIES) {
+		return;
+	}
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (desc->index[mid].pcm < pcm) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if ((lo < desc->index_len && desc->index[lo].pcm - pcm < OGG_INDEX_INTERVAL)
+		|| (lo > 0 && pcm - desc->index[lo - 1].pcm < OGG_INDEX_INTERVAL)) {
+		return;
+	}
+
+	if (desc->index_len == desc->index_alloc) {
+		int new_alloc = desc->index_alloc ? desc->index_alloc * 2 : 64;
+		struct ogg_index_entry *new_index;
+
+		new_index = ast_realloc(desc->index, new_alloc * sizeof(*new_index));
+		if (!new_index) {
+			return;
+		}
+		desc->index = new_index;
+		desc->index_alloc = new_alloc;
+	}
+
+	memmove(desc->index + lo + 1, desc->index + lo,
+		(desc->index_len - lo) * sizeof(*desc->index));
+	desc->index[lo].pcm = pcm;
+	desc->index[lo].raw = raw;
+	desc->index_len++;
+}
+
+/*!
+ * \brief Decode and throw away up to \c samples samples.
+ * \return 0 when the target was reached, -1 on decode error or end of stream.
+ */
+static int ogg_vorbis_discard(struct ogg_vorbis_desc *desc, ogg_int64_t samples)
+{
+	char scratch[BUF_SIZE];
+	int current_bitstream = -10;
+
+	while (samples > 0) {
+		long bytes_read = ov_read(
+			&desc->ov_f,
+			scratch,
+			samples * 2 < BUF_SIZE ? samples * 2 : BUF_SIZE,
+			(__BYTE_ORDER == __BIG_ENDIAN),
+			2,
+			1,
+			&current_bitstream
+		);
+
+		if (bytes_read <= 0) {
+			return -1;
+		}
+		samples -= bytes_read / 2;
+	}
+
+	return 0;
+}
+
+/*!
+ * \brief Position the decoder at an absolute pcm offset.
+ *
+ * When the seek index already knows a raw byte offset shortly before the
+ * target we jump there with ov_raw_seek() (a page resync, no bisection)
+ * and decode the small remainder; otherwise fall back to ov_pcm_seek().
+ */
+static int ogg_vorbis_pcm_seek(struct ogg_vorbis_desc *desc, ogg_int64_t target)
+{
+	int lo = 0, hi = desc->index_len;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (desc->index[mid].pcm <= target) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo > 0 && target - desc->index[lo - 1].pcm < 2 * OGG_INDEX_INTERVAL
+		&& ov_raw_seek(&desc->ov_f, desc->index[lo - 1].raw) == 0) {
+		ogg_int64_t actual = ov_pcm_tell(&desc->ov_f);
+
+		if (actual >= 0 && actual <= target
+			&& !ogg_vorbis_discard(desc, target - actual)) {
+			return 0;
+		}
+		/* The shortcut missed (mid-page entry or decode error);
+		 * recover with a full seek */
+	}
+
+	return ov_pcm_seek(&desc->ov_f, target);
+}
+
 /*!
  * \brief Read a frame full of audio data from the filestream.
  * \param fs The filestream.
@@ -307,6 +444,9 @@ static struct ast_frame *ogg_vorbis_read(struct ast_filestream *fs,
 		return NULL;
 	}
 
+	/* remember where this stretch of audio lives for later seeks */
+	ogg_vorbis_index_record(desc);
+
 	/* initialize frame */
 	AST_FRAME_SET_BUFFER(&fs->fr, fs->buf, AST_FRIENDLY_OFFSET, BUF_SIZE);
 	out_buf = (char *) (fs->fr.data.ptr);	/* SLIN data buffer */
@@ -388,21 +528,21 @@ static int ogg_vorbis_seek(struct ast_filestream *fs, off_t sample_offset, int w
 	/* ov_pcm_seek support seeking only from begining (SEEK_SET), the rest must be emulated */
 	switch (whence) {
 	case SEEK_SET:
-		seek_result = ov_pcm_seek(&desc->ov_f, sample_offset);
+		seek_result = ogg_vorbis_pcm_seek(desc, sample_offset);
 		break;
 	case SEEK_CUR:
 		if ((relative_pcm_pos = ogg_vorbis_tell(fs)) < 0) {
 			seek_result = -1;
 			break;
 		}
-		seek_result = ov_pcm_seek(&desc->ov_f, relative_pcm_pos + sample_offset);
+		seek_result = ogg_vorbis_pcm_seek(desc, relative_pcm_pos + sample_offset);
 		break;
 	case SEEK_END:
 		if ((relative_pcm_pos = ov_pcm_total(&desc->ov_f, -1)) < 0) {
 			seek_result = -1;
 			break;
 		}
-		seek_result = ov_pcm_seek(&desc->ov_f, relative_pcm_pos - sample_offset);
+		seek_result = ogg_vorbis_pcm_seek(desc, relative_pcm_pos - sample_offset);
 		break;
 	default:
 		ast_log(LOG_WARNING, "Unknown *whence* to seek on OGG/Vorbis streams!\n");
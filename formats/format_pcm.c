@@ -30,6 +30,10 @@
 
 #include "asterisk.h"
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "asterisk/mod_format.h"
 #include "asterisk/module.h"
 #include "asterisk/endian.h"
@@ -44,11 +48,20 @@ static char alaw_silence[BUF_SIZE];
 
 /* #define REALTIME_WRITE */	/* XXX does it work at all ? */
 
-#ifdef REALTIME_WRITE
+/*! \brief How far ahead of the read cursor to page in mapped file data */
+#define MAP_PREFETCH_BYTES 65536
+
 struct pcm_desc {
+#ifdef REALTIME_WRITE
 	unsigned long start_time;
+#endif
+	char *map;	/*!< private mapping of the file, NULL when reading through stdio */
+	off_t map_len;	/*!< total length of the mapping */
+	off_t map_pos;	/*!< read cursor within the mapping */
+	off_t map_advised;	/*!< how far we have already asked the kernel to read ahead */
 };
 
+#ifdef REALTIME_WRITE
 /* Returns time in msec since system boot. */
 static unsigned long get_time(void)
 {
@@ -63,22 +76,98 @@ static unsigned long get_time(void)
 	return cur * 1000 / sysconf( _SC_CLK_TCK );
 }
 
-static int pcma_open(struct ast_filestream *s)
+static int pcma_rewrite(struct ast_filestream *s, const char *comment)
 {
+	struct pcm_desc *pd = s->_private;
+
 	if (ast_format_cmp(s->fmt->format, ast_format_alaw) == AST_FORMAT_CMP_EQUAL)
-		pd->starttime = get_time();
+		pd->start_time = get_time();
 	return 0;
 }
+#endif
 
-static int pcma_rewrite(struct ast_filestream *s, const char *comment)
+static int pcm_open(struct ast_filestream *s)
 {
-	return pcma_open(s);
-}
+	struct pcm_desc *pd = s->_private;
+	struct stat st;
+	char *map;
+
+#ifdef REALTIME_WRITE
+	if (ast_format_cmp(s->fmt->format, ast_format_alaw) == AST_FORMAT_CMP_EQUAL)
+		pd->start_time = get_time();
 #endif
 
+	if (fstat(fileno(s->f), &st) || !S_ISREG(st.st_mode) || !st.st_size) {
+		return 0;
+	}
+
+	/* Map the file privately so that consumers which rewrite voice frames
+	 * in place (volume adjustment, PLC) fault a private copy of the page
+	 * rather than crashing on a read only mapping.  Failure is not fatal;
+	 * we simply keep reading through stdio. */
+	map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(s->f), 0);
+	if (map == MAP_FAILED) {
+		return 0;
+	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	pd->map = map;
+	pd->map_len = st.st_size;
+
+	return 0;
+}
+
+static void pcm_close(struct ast_filestream *s)
+{
+	struct pcm_desc *pd = s->_private;
+
+	if (pd->map) {
+		munmap(pd->map, pd->map_len);
+		pd->map = NULL;
+	}
+}
+
+/*! \brief Ask the kernel to page in the data we are about to play */
+static void pcm_map_prefetch(struct pcm_desc *pd)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	off_t want = pd->map_pos + MAP_PREFETCH_BYTES;
+	off_t from;
+
+	if (want > pd->map_len) {
+		want = pd->map_len;
+	}
+	if (pd->map_advised < pd->map_pos) {
+		pd->map_advised = pd->map_pos;
+	}
+	if (want <= pd->map_advised) {
+		return;
+	}
+	from = pd->map_advised - (pd->map_advised % page);
+	madvise(pd->map + from, want - from, MADV_WILLNEED);
+	pd->map_advised = want;
+}
+
 static struct ast_frame *pcm_read(struct ast_filestream *s, int *whennext)
 {
 	size_t res;
+	struct pcm_desc *pd = s->_private;
+
+	if (pd && pd->map) {
+		off_t avail = pd->map_len - pd->map_pos;
+
+		if (avail <= 0) {
+			return NULL;
+		}
+		res = MIN(avail, BUF_SIZE);
+		pcm_map_prefetch(pd);
+		/* Point the frame straight into the mapping; no copy and no
+		 * syscall.  Paths that need frame headroom duplicate the frame
+		 * themselves when offset is too small. */
+		AST_FRAME_SET_BUFFER(&s->fr, pd->map + pd->map_pos, 0, res);
+		pd->map_pos += res;
+		*whennext = s->fr.samples = res;
+		return &s->fr;
+	}
 
 	/* Send a frame from the file to the appropriate channel */
 	AST_FRAME_SET_BUFFER(&s->fr, s->buf, AST_FRIENDLY_OFFSET, BUF_SIZE);
@@ -97,9 +186,39 @@ static struct ast_frame *pcm_read(struct ast_filestream *s, int *whennext)
 
 static int pcm_seek(struct ast_filestream *fs, off_t sample_offset, int whence)
 {
+	struct pcm_desc *pd = fs->_private;
 	off_t cur, max, offset = 0;
  	int ret = -1;	/* assume error */
 
+	if (pd && pd->map) {
+		switch (whence) {
+		case SEEK_SET:
+			offset = sample_offset;
+			break;
+		case SEEK_END:
+			offset = pd->map_len - sample_offset;
+			break;
+		case SEEK_CUR:
+		case SEEK_FORCECUR:
+			offset = pd->map_pos + sample_offset;
+			break;
+		default:
+			ast_log(LOG_WARNING, "invalid whence %d, assuming SEEK_SET\n", whence);
+			offset = sample_offset;
+		}
+		/* Mapped streams are read only, so there is no file to extend
+		 * with silence for SEEK_FORCECUR; just stay within bounds. */
+		if (offset < 0) {
+			ast_log(LOG_WARNING, "negative offset %ld, resetting to 0\n", (long) offset);
+			offset = 0;
+		}
+		if (offset > pd->map_len) {
+			offset = pd->map_len;
+		}
+		pd->map_pos = offset;
+		return 0;
+	}
+
 	if ((cur = ftello(fs->f)) < 0) {
 		ast_log(AST_LOG_WARNING, "Unable to determine current position in pcm filestream %p: %s\n", fs, strerror(errno));
 		return -1;
@@ -174,6 +293,11 @@ static int pcm_trunc(struct ast_filestream *fs)
 
 static off_t pcm_tell(struct ast_filestream *fs)
 {
+	struct pcm_desc *pd = fs->_private;
+
+	if (pd && pd->map) {
+		return pd->map_pos;
+	}
 	return ftello(fs->f);
 }
 
@@ -270,6 +394,7 @@ static int pcm_write(struct ast_filestream *fs, struct ast_frame *f)
 #endif
 
 struct au_desc {
+	struct pcm_desc pcm;	/*!< must be first: au shares pcm_read(), which expects it */
 	uint32_t hdr_size;
 };
 
@@ -491,16 +616,17 @@ static off_t g722_tell(struct ast_filestream *fs)
 static struct ast_format_def alaw_f = {
 	.name = "alaw",
 	.exts = "alaw|al|alw",
+	.open = pcm_open,
 	.write = pcm_write,
 	.seek = pcm_seek,
 	.trunc = pcm_trunc,
 	.tell = pcm_tell,
 	.read = pcm_read,
+	.close = pcm_close,
 	.buf_size = BUF_SIZE + AST_FRIENDLY_OFFSET,
+	.desc_size = sizeof(struct pcm_desc),
 #ifdef REALTIME_WRITE
-	.open = pcma_open,
 	.rewrite = pcma_rewrite,
-	.desc_size = sizeof(struct pcm_desc),
 #endif
 };
 
@@ -508,23 +634,29 @@ static struct ast_format_def pcm_f = {
 	.name = "pcm",
 	.exts = "pcm|ulaw|ul|mu|ulw",
 	.mime_types = "audio/basic",
+	.open = pcm_open,
 	.write = pcm_write,
 	.seek = pcm_seek,
 	.trunc = pcm_trunc,
 	.tell = pcm_tell,
 	.read = pcm_read,
+	.close = pcm_close,
 	.buf_size = BUF_SIZE + AST_FRIENDLY_OFFSET,
+	.desc_size = sizeof(struct pcm_desc),
 };
 
 static struct ast_format_def g722_f = {
 	.name = "g722",
 	.exts = "g722",
+	.open = pcm_open,
 	.write = pcm_write,
 	.seek = g722_seek,
 	.trunc = pcm_trunc,
 	.tell = g722_tell,
 	.read = g722_read,
+	.close = pcm_close,
 	.buf_size = (BUF_SIZE * 2) + AST_FRIENDLY_OFFSET,
+	.desc_size = sizeof(struct pcm_desc),
 };
 
 static struct ast_format_def au_f = {
@@ -30,6 +30,10 @@
 
 #include "asterisk.h"
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "asterisk/mod_format.h"
 #include "asterisk/module.h"
 #include "asterisk/endian.h"
@@ -45,12 +49,19 @@
 
 #define WAV_HEADER_SIZE 44
 
+/*! \brief How much mapped file data to page in ahead of the read cursor */
+#define MAP_PREFETCH_BYTES 65536
+
 struct wav_desc {	/* format-specific parameters */
 	int hz;
 	int bytes;
 	int lasttimeout;
 	int maxlen;
 	struct timeval last;
+	char *map;	/*!< private mapping of the file, NULL when reading through stdio */
+	off_t map_len;	/*!< total length of the mapping */
+	off_t map_pos;	/*!< read cursor, as an absolute file offset to match ftello() */
+	off_t map_advised;	/*!< offset we have already asked the kernel to read ahead to */
 };
 
 #define BLOCKSIZE 160
@@ -330,9 +341,55 @@ static int wav_open(struct ast_filestream *s)
 	}
 
 	tmp->hz = sample_rate;
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+	{
+		/* Samples are stored little endian, so only a little endian host
+		 * can serve frames directly out of a mapping; big endian hosts
+		 * keep the fread() path, which swaps into the stream buffer.
+		 * The mapping is private so consumers which rewrite voice frames
+		 * in place (volume adjustment, PLC) fault a private copy of the
+		 * page instead of crashing on a read only mapping. */
+		struct stat st;
+		char *map;
+
+		if (!fstat(fileno(s->f), &st) && S_ISREG(st.st_mode) && st.st_size) {
+			map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(s->f), 0);
+			if (map != MAP_FAILED) {
+				madvise(map, st.st_size, MADV_SEQUENTIAL);
+				tmp->map = map;
+				tmp->map_len = st.st_size;
+				/* check_header() left the FILE at the start of the data chunk */
+				tmp->map_pos = ftello(s->f);
+			}
+		}
+	}
+#endif
+
 	return 0;
 }
 
+/*! \brief Ask the kernel to page in the data we are about to play */
+static void wav_map_prefetch(struct wav_desc *fs)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	off_t want = fs->map_pos + MAP_PREFETCH_BYTES;
+	off_t from;
+
+	if (want > fs->map_len) {
+		want = fs->map_len;
+	}
+	if (fs->map_advised < fs->map_pos) {
+		fs->map_advised = fs->map_pos;
+	}
+	if (want <= fs->map_advised) {
+		return;
+	}
+	from = fs->map_advised - (fs->map_advised % page);
+	madvise(fs->map + from, want - from, MADV_WILLNEED);
+	fs->map_advised = want;
+}
+
 static int wav_rewrite(struct ast_filestream *s, const char *comment)
 {
 	/* We don't have any header to read or anything really, but
@@ -351,6 +408,11 @@ static void wav_close(struct ast_filestream *s)
 	char zero = 0;
 	struct wav_desc *fs = (struct wav_desc *)s->_private;
 
+	if (fs->map) {
+		munmap(fs->map, fs->map_len);
+		fs->map = NULL;
+	}
+
 	if (s->mode == O_RDONLY) {
 		return;
 	}
@@ -382,13 +444,31 @@ static struct ast_frame *wav_read(struct ast_filestream *s, int *whennext)
 
 	bytes = (fs->hz == 16000 ? (WAV_BUF_SIZE * 2) : WAV_BUF_SIZE);
 
-	here = ftello(s->f);
+	here = fs->map ? fs->map_pos : ftello(s->f);
 	if (fs->maxlen - here < bytes)		/* truncate if necessary */
 		bytes = fs->maxlen - here;
 	if (bytes <= 0) {
 		return NULL;
 	}
 /* 	ast_debug(1, "here: %d, maxlen: %d, bytes: %d\n", here, s->maxlen, bytes); */
+
+	if (fs->map) {
+		if (fs->map_len - here < bytes)	/* never run off the end of the file */
+			bytes = fs->map_len - here;
+		if (bytes <= 0) {
+			return NULL;
+		}
+		wav_map_prefetch(fs);
+		/* Point the frame straight into the mapping; no copy and no
+		 * syscall.  Paths that need frame headroom duplicate the frame
+		 * themselves when offset is too small. */
+		AST_FRAME_SET_BUFFER(&s->fr, fs->map + here, 0, bytes);
+		fs->map_pos = here + bytes;
+		s->fr.samples = samples = bytes / 2;
+		*whennext = samples;
+		return &s->fr;
+	}
+
 	AST_FRAME_SET_BUFFER(&s->fr, s->buf, AST_FRIENDLY_OFFSET, bytes);
 
 	if ((res = fread(s->fr.data.ptr, 1, s->fr.datalen, s->f)) == 0) {
@@ -452,10 +532,31 @@ static int wav_write(struct ast_filestream *fs, struct ast_frame *f)
 
 static int wav_seek(struct ast_filestream *fs, off_t sample_offset, int whence)
 {
+	struct wav_desc *s = (struct wav_desc *)fs->_private;
 	off_t min = WAV_HEADER_SIZE, max, cur, offset = 0, samples;
 
 	samples = sample_offset * 2; /* SLINEAR is 16 bits mono, so sample_offset * 2 = bytes */
 
+	if (s->map) {
+		cur = s->map_pos;
+		max = s->map_len;
+
+		if (whence == SEEK_SET) {
+			offset = samples + min;
+		} else if (whence == SEEK_CUR || whence == SEEK_FORCECUR) {
+			offset = samples + cur;
+		} else if (whence == SEEK_END) {
+			offset = max - samples;
+		}
+		/* mapped streams are read only, so even SEEK_FORCECUR cannot
+		 * reach past the end of the file */
+		offset = (offset > max) ? max : offset;
+		/* always protect the header space. */
+		offset = (offset < min) ? min : offset;
+		s->map_pos = offset;
+		return 0;
+	}
+
 	if ((cur = ftello(fs->f)) < 0) {
 		ast_log(AST_LOG_WARNING, "Unable to determine current position in wav filestream %p: %s\n", fs, strerror(errno));
 		return -1;
@@ -508,8 +609,9 @@ static int wav_trunc(struct ast_filestream *fs)
 
 static off_t wav_tell(struct ast_filestream *fs)
 {
+	struct wav_desc *s = (struct wav_desc *)fs->_private;
 	off_t offset;
-	offset = ftello(fs->f);
+	offset = s->map ? s->map_pos : ftello(fs->f);
 	/* subtract header size to get samples, then divide by 2 for 16 bit samples */
 	return (offset - 44)/2;
 }
@@ -254,6 +254,11 @@
 					<enum name="linkedid">
 						<para>R/O returns the linkedid if available, otherwise returns the uniqueid.</para>
 					</enum>
+					<enum name="drops">
+						<para>R/O returns the media frames the core has dropped on this
+						channel by cause, e.g.
+						<literal>readq=0,jitterbuffer=2,mixing=0,total=2</literal>.</para>
+					</enum>
 					<enum name="max_forwards">
 						<para>R/W The maximum number of forwards allowed.</para>
 					</enum>
@@ -409,6 +414,20 @@ static int func_channel_read(struct ast_channel *chan, const char *function,
 		locked_copy_string(chan, buf, ast_channel_accountcode(chan), len);
 	else if (!strcasecmp(data, "checkhangup")) {
 		locked_copy_string(chan, buf, ast_check_hangup(chan) ? "1" : "0", len);
+	} else if (!strcasecmp(data, "drops")) {
+		char *pos = buf;
+		size_t remaining = len;
+		unsigned int total = 0;
+		int i;
+
+		for (i = 0; i < AST_FRAME_DROP_CAUSE_COUNT; i++) {
+			unsigned int drops = ast_channel_drops(chan, i);
+
+			total += drops;
+			ast_build_string(&pos, &remaining, "%s=%u,",
+				ast_frame_drop_cause_name(i), drops);
+		}
+		ast_build_string(&pos, &remaining, "total=%u", total);
 	} else if (!strcasecmp(data, "peeraccount"))
 		locked_copy_string(chan, buf, ast_channel_peeraccount(chan), len);
 	else if (!strcasecmp(data, "hangupsource"))
@@ -600,6 +600,59 @@ static size_t WriteMemoryCallback(void *ptr, size_t size, size_t nmemb, void *da
 	return realsize;
 }
 
+/*!
+ * \internal
+ * \brief Share handle pooling DNS, TLS session, and connection caches.
+ *
+ * Each thread keeps its own easy handle, so without this every PBX thread
+ * pays its own DNS lookup, TCP handshake, and full TLS negotiation the first
+ * time it dips a given server, adding those round trips to post-dial delay.
+ * A CURLSH attached to every easy handle lets the whole process draw on one
+ * warm pool instead.
+ *
+ * The share is created once and deliberately never destroyed: easy handles
+ * live in thread storage and are cleaned up whenever their threads exit,
+ * which can be long after this module unloads, and curl requires the share
+ * to outlive every handle attached to it.
+ */
+static CURLSH *shared_handle_caches;
+
+static ast_mutex_t shared_cache_locks[CURL_LOCK_DATA_LAST];
+
+static void shared_cache_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+	ast_mutex_lock(&shared_cache_locks[data]);
+}
+
+static void shared_cache_unlock(CURL *handle, curl_lock_data data, void *userptr)
+{
+	ast_mutex_unlock(&shared_cache_locks[data]);
+}
+
+static void shared_handle_caches_init(void)
+{
+	int i;
+
+	for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+		ast_mutex_init(&shared_cache_locks[i]);
+	}
+
+	/* CURL() still works without the share; transfers just start cold */
+	if (!(shared_handle_caches = curl_share_init())) {
+		return;
+	}
+
+	curl_share_setopt(shared_handle_caches, CURLSHOPT_LOCKFUNC, shared_cache_lock);
+	curl_share_setopt(shared_handle_caches, CURLSHOPT_UNLOCKFUNC, shared_cache_unlock);
+	curl_share_setopt(shared_handle_caches, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(shared_handle_caches, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900 /* 7.57.0 */
+	/* Sharing live connections between easy handles is only safe on
+	 * releases where the connection cache takes the share locks. */
+	curl_share_setopt(shared_handle_caches, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+}
+
 static int curl_instance_init(void *data)
 {
 	CURL **curl = data;
@@ -611,6 +664,9 @@ static int curl_instance_init(void *data)
 	curl_easy_setopt(*curl, CURLOPT_TIMEOUT, 180);
 	curl_easy_setopt(*curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
 	curl_easy_setopt(*curl, CURLOPT_USERAGENT, AST_CURL_USER_AGENT);
+	if (shared_handle_caches) {
+		curl_easy_setopt(*curl, CURLOPT_SHARE, shared_handle_caches);
+	}
 
 	return 0;
 }
@@ -992,6 +1048,10 @@ static int load_module(void)
 {
 	int res;
 
+	if (!shared_handle_caches) {
+		shared_handle_caches_init();
+	}
+
 	res = ast_custom_function_register_escalating(&acf_curl, AST_CFE_WRITE);
 	res |= ast_custom_function_register(&acf_curlopt);
 
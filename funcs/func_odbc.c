@@ -44,6 +44,7 @@
 #include "asterisk/res_odbc_transaction.h"
 #include "asterisk/app.h"
 #include "asterisk/cli.h"
+#include "asterisk/manager.h"
 #include "asterisk/strings.h"
 
 /*** DOCUMENTATION
@@ -113,6 +114,25 @@
 			</example>
 		</description>
 	</function>
+	<manager name="ODBCCacheFlush" language="en_US">
+		<synopsis>
+			Flush cached func_odbc read results.
+		</synopsis>
+		<syntax>
+			<xi:include xpointer="xpointer(/docs/manager[@name='Login']/syntax/parameter[@name='ActionID'])" />
+			<parameter name="Function">
+				<para>If specified, only results cached for this dialplan function
+				(for example <literal>ODBC_RATE</literal>) are flushed.  Otherwise
+				the entire cache is cleared.</para>
+			</parameter>
+		</syntax>
+		<description>
+			<para>Discards results cached for functions configured with
+			<literal>cachettl</literal> in <filename>func_odbc.conf</filename>,
+			forcing the next evaluation to query the database again.  Use this
+			after changing the underlying tables outside of Asterisk.</para>
+		</description>
+	</manager>
  ***/
 
 static char *config = "func_odbc.conf";
@@ -135,9 +155,11 @@ struct acf_odbc_query {
 	char *sql_read;
 	char *sql_write;
 	char *sql_insert;
+	char *sql_cachekey;
 	unsigned int flags;
 	int rowlimit;
 	int minargs;
+	int cachettl;
 	struct ast_custom_function *acf;
 };
 
@@ -438,6 +460,130 @@ AST_THREADSTORAGE(sql_buf);
 AST_THREADSTORAGE(sql2_buf);
 AST_THREADSTORAGE(coldata_buf);
 AST_THREADSTORAGE(colnames_buf);
+AST_THREADSTORAGE(cachekey_buf);
+
+/*!
+ * \internal
+ * \brief Cached result of a single-row read.
+ *
+ * Identical lookups (rate tables, user preferences) repeat many times within
+ * one call.  Functions configured with a <literal>cachettl</literal> keep
+ * their single-row read results here, so repeat evaluations skip the database
+ * until the TTL lapses, the function is written through, or an ODBCCacheFlush
+ * manager action clears them.  Multirow resultsets are never cached.
+ */
+struct acf_odbc_cache_entry {
+	time_t expires;
+	int rows;
+	const char *status;   /*!< Status literal; not allocated */
+	char *value;
+	char *colnames;
+	/*! "<function>\x01<key>" so one function's entries can be flushed together */
+	char key[0];
+};
+
+#define CACHE_BUCKETS 53
+#define CACHE_MAXSIZE 1024
+#define CACHE_KEY_SEP '\x01'
+
+static struct ao2_container *query_cache;
+
+static void cache_entry_destructor(void *obj)
+{
+	struct acf_odbc_cache_entry *entry = obj;
+
+	ast_free(entry->value);
+	ast_free(entry->colnames);
+}
+
+AO2_STRING_FIELD_HASH_FN(acf_odbc_cache_entry, key)
+AO2_STRING_FIELD_SORT_FN(acf_odbc_cache_entry, key)
+
+static int cache_entry_flush_cb(void *obj, void *arg, int flags)
+{
+	struct acf_odbc_cache_entry *entry = obj;
+	const char *func = arg;
+	size_t len;
+
+	if (!func) {
+		return CMP_MATCH;
+	}
+	len = strlen(func);
+	if (!strncasecmp(entry->key, func, len) && entry->key[len] == CACHE_KEY_SEP) {
+		return CMP_MATCH;
+	}
+	return 0;
+}
+
+/*! \brief Drop cached results for one function, or all of them if \a func is NULL */
+static void cache_flush(const char *func)
+{
+	if (!query_cache) {
+		return;
+	}
+	ao2_callback(query_cache, OBJ_UNLINK | OBJ_NODATA | OBJ_MULTIPLE,
+		cache_entry_flush_cb, (void *) func);
+}
+
+static int cache_entry_expired_cb(void *obj, void *arg, int flags)
+{
+	struct acf_odbc_cache_entry *entry = obj;
+	time_t *now = arg;
+
+	return entry->expires < *now ? CMP_MATCH : 0;
+}
+
+static struct acf_odbc_cache_entry *cache_get(const char *key)
+{
+	struct acf_odbc_cache_entry *entry;
+	time_t now;
+
+	if (!query_cache || !(entry = ao2_find(query_cache, key, OBJ_SEARCH_KEY))) {
+		return NULL;
+	}
+	time(&now);
+	if (entry->expires < now) {
+		ao2_unlink(query_cache, entry);
+		ao2_ref(entry, -1);
+		return NULL;
+	}
+	return entry;
+}
+
+static void cache_put(const char *key, int ttl, const char *value, const char *colnames, const char *status, int rows)
+{
+	struct acf_odbc_cache_entry *entry;
+	time_t now;
+
+	if (!query_cache) {
+		return;
+	}
+	time(&now);
+	if (ao2_container_count(query_cache) >= CACHE_MAXSIZE) {
+		/* Push out whatever has expired; if the cache is still full,
+		 * simply decline to grow it further. */
+		ao2_callback(query_cache, OBJ_UNLINK | OBJ_NODATA | OBJ_MULTIPLE,
+			cache_entry_expired_cb, &now);
+		if (ao2_container_count(query_cache) >= CACHE_MAXSIZE) {
+			return;
+		}
+	}
+	if (!(entry = ao2_alloc(sizeof(*entry) + strlen(key) + 1, cache_entry_destructor))) {
+		return;
+	}
+	strcpy(entry->key, key); /* Safe */
+	entry->value = ast_strdup(value);
+	entry->colnames = ast_strdup(S_OR(colnames, ""));
+	if (!entry->value || !entry->colnames) {
+		ao2_ref(entry, -1);
+		return;
+	}
+	entry->status = status;
+	entry->rows = rows;
+	entry->expires = now + ttl;
+	ao2_link(query_cache, entry);
+	ao2_ref(entry, -1);
+}
 
 static int acf_fetch(struct ast_channel *chan, const char *cmd, char *data, char *buf, size_t len);
 
@@ -718,6 +864,9 @@ static int acf_odbc_write(struct ast_channel *chan, const char *cmd, char *s, co
 
 	AST_RWLIST_UNLOCK(&queries);
 
+	/* Anything written through this function may change what its reads return */
+	cache_flush(cmd);
+
 	/* Output the affected rows, for all cases.  In the event of failure, we
 	 * flag this as -1 rows.  Note that this is different from 0 affected rows
 	 * which would be the case if we succeeded in our query, but the values did
@@ -756,6 +905,8 @@ static int acf_odbc_read(struct ast_channel *chan, const char *cmd, char *s, cha
 	struct odbc_datastore *resultset = NULL;
 	struct odbc_datastore_row *row = NULL;
 	struct ast_str *sql = ast_str_thread_get(&sql_buf, 16);
+	struct ast_str *cachekey = NULL;
+	int cachettl = 0;
 	const char *status = "FAILURE";
 	struct dsn *dsn = NULL;
 
@@ -814,6 +965,24 @@ static int acf_odbc_read(struct ast_channel *chan, const char *cmd, char *s, cha
 
 	ast_str_substitute_variables(&sql, 0, chan, query->sql_read);
 
+	if (query->cachettl > 0) {
+		/* The ARGn variables are still pushed, so the key template expands
+		 * in the same environment as the SQL itself.  Without a template,
+		 * the expanded SQL is its own perfectly unique key. */
+		struct ast_str *keyexp = ast_str_thread_get(&sql2_buf, 16);
+
+		cachekey = ast_str_thread_get(&cachekey_buf, 16);
+		if (cachekey && keyexp) {
+			cachettl = query->cachettl;
+			if (query->sql_cachekey) {
+				ast_str_substitute_variables(&keyexp, 0, chan, query->sql_cachekey);
+			} else {
+				ast_str_set(&keyexp, 0, "%s", ast_str_buffer(sql));
+			}
+			ast_str_set(&cachekey, 0, "%s%c%s", cmd, CACHE_KEY_SEP, ast_str_buffer(keyexp));
+		}
+	}
+
 	if (bogus_chan) {
 		chan = ast_channel_unref(chan);
 	} else {
@@ -858,6 +1027,23 @@ static int acf_odbc_read(struct ast_channel *chan, const char *cmd, char *s, cha
 	}
 	AST_RWLIST_UNLOCK(&queries);
 
+	if (cachettl > 0 && cachekey && !resultset) {
+		struct acf_odbc_cache_entry *cached = cache_get(ast_str_buffer(cachekey));
+
+		if (cached) {
+			ast_copy_string(buf, cached->value, len);
+			if (!bogus_chan) {
+				snprintf(rowcount, sizeof(rowcount), "%d", cached->rows);
+				pbx_builtin_setvar_helper(chan, "ODBCROWS", rowcount);
+				pbx_builtin_setvar_helper(chan, "ODBCSTATUS", cached->status);
+				pbx_builtin_setvar_helper(chan, "~ODBCFIELDS~", cached->colnames);
+				ast_autoservice_stop(chan);
+			}
+			ao2_ref(cached, -1);
+			return 0;
+		}
+	}
+
 	for (dsn_num = 0; dsn_num < 5; dsn_num++) {
 		if (!ast_strlen_zero(query->readhandle[dsn_num])) {
 			obj = get_odbc_obj(query->readhandle[dsn_num], &dsn);
@@ -921,6 +1107,10 @@ static int acf_odbc_read(struct ast_channel *chan, const char *cmd, char *s, cha
 			buf[0] = '\0';
 			ast_copy_string(rowcount, "0", sizeof(rowcount));
 			status = "NODATA";
+			if (cachettl > 0 && cachekey && !resultset) {
+				/* Cache the empty result too; misses are often the hot path */
+				cache_put(ast_str_buffer(cachekey), cachettl, "", "", status, 0);
+			}
 		} else {
 			ast_log(LOG_WARNING, "Error %d in FETCH [%s]\n", res, ast_str_buffer(sql));
 			status = "FETCHERROR";
@@ -1064,6 +1254,9 @@ static int acf_odbc_read(struct ast_channel *chan, const char *cmd, char *s, cha
 	}
 
 end_acf_read:
+	if (cachettl > 0 && cachekey && !resultset && y > 0 && !strcmp(status, "SUCCESS")) {
+		cache_put(ast_str_buffer(cachekey), cachettl, buf, ast_str_buffer(colnames), status, y);
+	}
 	if (!bogus_chan) {
 		snprintf(rowcount, sizeof(rowcount), "%d", y);
 		pbx_builtin_setvar_helper(chan, "ODBCROWS", rowcount);
@@ -1217,6 +1410,20 @@ static int exec_odbcfinish(struct ast_channel *chan, const char *data)
 	return 0;
 }
 
+static int manager_odbc_cache_flush(struct mansession *s, const struct message *m)
+{
+	const char *func = astman_get_header(m, "Function");
+
+	if (!query_cache) {
+		astman_send_error(s, m, "No cache is active");
+		return 0;
+	}
+
+	cache_flush(ast_strlen_zero(func) ? NULL : func);
+	astman_send_ack(s, m, "Cache flushed");
+	return 0;
+}
+
 static int free_acf_query(struct acf_odbc_query *query)
 {
 	if (query) {
@@ -1229,6 +1436,7 @@ static int free_acf_query(struct acf_odbc_query *query)
 		ast_free(query->sql_read);
 		ast_free(query->sql_write);
 		ast_free(query->sql_insert);
+		ast_free(query->sql_cachekey);
 		ast_free(query);
 	}
 	return 0;
@@ -1350,6 +1558,22 @@ static int init_acf_query(struct ast_config *cfg, char *catg, struct acf_odbc_qu
 		sscanf(tmp, "%30d", &((*query)->minargs));
 	}
 
+	if ((tmp = ast_variable_retrieve(cfg, catg, "cachettl"))) {
+		sscanf(tmp, "%30d", &((*query)->cachettl));
+		if ((*query)->cachettl > 0 && ast_test_flag((*query), OPT_MULTIROW)) {
+			ast_log(LOG_WARNING, "Multirow resultsets cannot be cached; ignoring cachettl for category %s\n", catg);
+			(*query)->cachettl = 0;
+		}
+	}
+
+	if ((tmp = ast_variable_retrieve(cfg, catg, "cachekey")) && *tmp != '\0') {
+		if (!((*query)->sql_cachekey = ast_strdup(tmp))) {
+			free_acf_query(*query);
+			*query = NULL;
+			return ENOMEM;
+		}
+	}
+
 	(*query)->acf = ast_calloc(1, sizeof(struct ast_custom_function));
 	if (!(*query)->acf) {
 		free_acf_query(*query);
@@ -1839,6 +2063,12 @@ static int load_module(void)
 	res |= ast_custom_function_register(&fetch_function);
 	res |= ast_register_application_xml(app_odbcfinish, exec_odbcfinish);
 
+	/* Reads work without the cache; the database just gets hit every time */
+	query_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, CACHE_BUCKETS,
+		acf_odbc_cache_entry_hash_fn, acf_odbc_cache_entry_sort_fn, NULL);
+	res |= ast_manager_register_xml("ODBCCacheFlush", EVENT_FLAG_SYSTEM, manager_odbc_cache_flush);
+
 	cfg = ast_config_load(config, config_flags);
 	if (!cfg || cfg == CONFIG_STATUS_FILEINVALID) {
 		ast_log(LOG_NOTICE, "Unable to load config for func_odbc: %s\n", config);
@@ -1914,6 +2144,7 @@ static int unload_module(void)
 	res |= ast_custom_function_unregister(&escape_backslashes_function);
 	res |= ast_custom_function_unregister(&fetch_function);
 	res |= ast_unregister_application(app_odbcfinish);
+	res |= ast_manager_unregister("ODBCCacheFlush");
 	ast_cli_unregister_multiple(cli_func_odbc, ARRAY_LEN(cli_func_odbc));
 
 	/* Allow any threads waiting for this lock to pass (avoids a race) */
@@ -1926,6 +2157,8 @@ static int unload_module(void)
 	if (dsns) {
 		ao2_ref(dsns, -1);
 	}
+	ao2_cleanup(query_cache);
+	query_cache = NULL;
 	return res;
 }
 
@@ -1942,6 +2175,9 @@ static int reload(void)
 	if (cfg == CONFIG_STATUS_FILEUNCHANGED || cfg == CONFIG_STATUS_FILEINVALID)
 		return 0;
 
+	/* The SQL behind any function may have changed */
+	cache_flush(NULL);
+
 	ast_rwlock_wrlock(&single_db_connection_lock);
 
 	if (dsns) {
@@ -102,6 +102,41 @@ int ast_set_priority(int);			/*!< Provided by asterisk.c */
 int ast_fd_init(void);				/*!< Provided by astfd.c */
 int ast_pbx_init(void);				/*!< Provided by pbx.c */
 
+/*!
+ * \brief Register a file descriptor to be preserved across a restart.
+ *
+ * The descriptor is left open across the restart exec and handed to the
+ * new instance, which can adopt it with ast_restart_preserved_fd()
+ * instead of rebinding the socket.  Registering another descriptor
+ * under the same name replaces the earlier registration.
+ *
+ * \param name Unique name the new instance will claim the descriptor by.
+ *             Must not contain ':' or ','.
+ * \param fd The descriptor to preserve.  The caller retains ownership
+ *           until the restart happens.
+ *
+ * \retval 0 on success.
+ * \retval -1 on error.
+ */
+int ast_restart_preserve_fd(const char *name, int fd);	/*!< Provided by asterisk.c */
+
+/*!
+ * \brief Remove a descriptor registered with ast_restart_preserve_fd().
+ */
+void ast_restart_preserve_remove(const char *name);	/*!< Provided by asterisk.c */
+
+/*!
+ * \brief Claim a descriptor preserved by the previous instance.
+ *
+ * \param name The name the descriptor was registered under.
+ *
+ * \return The inherited descriptor, now owned by the caller.
+ * \retval -1 if the previous instance preserved nothing by that name.
+ *
+ * \note Descriptors left unclaimed when startup completes are closed.
+ */
+int ast_restart_preserved_fd(const char *name);	/*!< Provided by asterisk.c */
+
 /*!
  * \brief Register a function to be executed before Asterisk exits.
  * \param func The callback function to use.
@@ -48,6 +48,8 @@ int ast_file_init(void);		/*!< Provided by file.c */
 void ast_autoservice_init(void);	/*!< Provided by autoservice.c */
 int ast_tps_init(void); 		/*!< Provided by taskprocessor.c */
 int ast_timing_init(void);		/*!< Provided by timing.c */
+int ast_latency_trace_init(void);	/*!< Provided by latency_trace.c */
+int ast_lock_contention_init(void);	/*!< Provided by lock.c */
 void ast_stun_init(void);               /*!< Provided by stun.c */
 int ast_ssl_init(void);                 /*!< Provided by ssl.c */
 int ast_pj_init(void);                 /*!< Provided by libasteriskpj.c */
@@ -66,6 +66,7 @@ struct ast_ha {
  */
 struct ast_acl {
 	struct ast_ha *acl;             /*!< Rules contained by the ACL */
+	struct ast_ha_index *index;     /*!< Compiled form of the rules for binary-search matching, or NULL */
 	int is_realtime;                /*!< If raised, this named ACL was retrieved from realtime storage */
 	int is_invalid;                 /*!< If raised, this is an invalid ACL which will automatically reject everything. */
 	char name[ACL_NAME_LENGTH];     /*!< If this was retrieved from the named ACL subsystem, this is the name of the ACL. */
@@ -215,6 +216,47 @@ int ast_acl_list_is_empty(struct ast_acl_list *acl_list);
  */
 enum ast_acl_sense ast_apply_ha(const struct ast_ha *ha, const struct ast_sockaddr *addr);
 
+/*!
+ * \brief Compile a list of host access rules into a binary-searchable index
+ *
+ * \details
+ * The rule list is flattened into disjoint address ranges, each labelled with
+ * the sense of the rule that would win the linear last-match walk, so a check
+ * is a binary search over the ranges instead of a walk of every rule.  The
+ * index is a snapshot: it must be recompiled whenever the rule list changes.
+ *
+ * Only lists whose rules all use contiguous (CIDR) netmasks and carry no port
+ * can be compiled; for anything else this function returns NULL and the
+ * caller should keep using ast_apply_ha().
+ *
+ * \param ha The head of the list of host access rules to compile
+ *
+ * \return The compiled index, to be freed with ast_ha_index_free()
+ * \retval NULL if the list is empty, cannot be represented, or on allocation failure
+ */
+struct ast_ha_index *ast_ha_index_compile(const struct ast_ha *ha);
+
+/*!
+ * \brief Free an index created by ast_ha_index_compile()
+ *
+ * \param index The index to free.  NULL is tolerated.
+ */
+void ast_ha_index_free(struct ast_ha_index *index);
+
+/*!
+ * \brief Apply a compiled rule index to a given IP address
+ *
+ * \details
+ * Gives the same verdict as running ast_apply_ha() over the rule list the
+ * index was compiled from, in logarithmic rather than linear time.
+ *
+ * \param index The compiled index to search
+ * \param addr An ast_sockaddr whose address is considered when matching rules
+ * \retval AST_SENSE_ALLOW The IP address passes the ACL
+ * \retval AST_SENSE_DENY The IP address fails the ACL
+ */
+enum ast_acl_sense ast_ha_index_apply(const struct ast_ha_index *index, const struct ast_sockaddr *addr);
+
 /*!
  * \brief Apply a set of rules to a given IP address
  *
@@ -83,4 +83,28 @@ static inline unsigned char AST_LIN2A(short sample)
 
 #define AST_ALAW(a) (__ast_alaw[(int)(a)])
 
+/*!
+ * \brief Convert a block of A-Law samples to signed linear
+ *
+ * Equivalent to applying AST_ALAW() per sample, but may use a SIMD
+ * kernel selected at startup for whole-frame conversion.
+ *
+ * \param dst Destination buffer with room for \a samples entries
+ * \param src A-Law encoded samples
+ * \param samples Number of samples to convert
+ */
+void ast_alaw_expand_block(short *dst, const unsigned char *src, unsigned int samples);
+
+/*!
+ * \brief Convert a block of signed linear samples to A-Law
+ *
+ * Equivalent to applying AST_LIN2A() per sample, but may use a SIMD
+ * kernel selected at startup for whole-frame conversion.
+ *
+ * \param dst Destination buffer with room for \a samples bytes
+ * \param src Signed linear samples
+ * \param samples Number of samples to convert
+ */
+void ast_alaw_compress_block(unsigned char *dst, const short *src, unsigned int samples);
+
 #endif /* _ASTERISK_ALAW_H */
@@ -71,6 +71,22 @@ ast_alert_status_t ast_alertpipe_read(int alert_pipe[2]);
  */
 ssize_t ast_alertpipe_write(int alert_pipe[2]);
 
+/*!
+ * \brief Write multiple events to an alert pipe in one operation
+ *
+ * On an eventfd backed alert pipe all of the events are signaled with a
+ * single write() and readers still consume them one at a time, so queuing
+ * a burst of N frames costs one syscall instead of N.  The pipe fallback
+ * loops internally.
+ *
+ * \param alert_pipe a two-element array containing the alert pipe's file descriptors
+ * \param count the number of events to signal
+ *
+ * \retval 0 Success
+ * \retval 1 Failure
+ */
+ssize_t ast_alertpipe_write_count(int alert_pipe[2], size_t count);
+
 /*!
  * \brief Consume all alerts written to the alert pipe
  * \since 13.16.0
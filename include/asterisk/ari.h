@@ -193,6 +193,23 @@ struct ast_json *ast_ari_websocket_session_read(
 int ast_ari_websocket_session_write(struct ast_ari_websocket_session *session,
 	struct ast_json *message);
 
+/*!
+ * \brief Send an already serialized message to an ARI WebSocket.
+ *
+ * Callers that have encoded \c message themselves (for example to log it)
+ * can pass the encoding in \c str so the session does not serialize the
+ * message a second time.
+ *
+ * \param session Session to write to.
+ * \param message Message being sent; used for validation in dev mode.
+ * \param str The serialized form of \c message.
+ * \retval 0 on success.
+ * \retval Non-zero on error.
+ */
+int ast_ari_websocket_session_write_serialized(
+	struct ast_ari_websocket_session *session, struct ast_json *message,
+	const char *str);
+
 /*!
  * \brief Get the Session ID for an ARI WebSocket.
  *
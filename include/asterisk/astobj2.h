@@ -376,6 +376,15 @@ enum ao2_alloc_opts {
 	AO2_ALLOC_OPT_LOCK_OBJ = AO2_ALLOC_OPT_LOCK_MASK,
 	/*! The ao2 object will not record any REF_DEBUG entries */
 	AO2_ALLOC_OPT_NO_REF_DEBUG = (1 << 2),
+	/*!
+	 * \brief The ao2 object is allocated with a compact header.
+	 *
+	 * Intended for small objects allocated in large numbers.  Requires
+	 * AO2_ALLOC_OPT_LOCK_NOLOCK and the object cannot be the target of
+	 * an ao2_weakproxy.  Ignored when AO2_DEBUG object statistics are
+	 * compiled in.
+	 */
+	AO2_ALLOC_OPT_COMPACT = (1 << 3),
 };
 
 /*!
@@ -73,6 +73,11 @@ enum ast_audiohook_init_flags {
 	 * Without enabling this flag on initialization the manipulation callback is guaranteed
 	 * 8khz audio only. */
 	AST_AUDIOHOOK_MANIPULATE_ALL_RATES = (1 << 0),
+	/*! Queue raw frames on the channel thread and translate them to signed
+	 * linear on the consuming thread when the audiohook is read.  Only
+	 * useful for spy type audiohooks whose consumer runs in its own
+	 * thread, such as MixMonitor. */
+	AST_AUDIOHOOK_DEFER_TRANSLATE = (1 << 1),
 };
 
 struct ast_audiohook;
@@ -113,6 +118,10 @@ struct ast_audiohook {
 	struct ast_slinfactory write_factory;                  /*!< Factory where frames written to the channel will go through */
 	struct timeval read_time;                              /*!< Last time read factory was fed */
 	struct timeval write_time;                             /*!< Last time write factory was fed */
+	AST_LIST_HEAD_NOLOCK(, ast_frame) deferred_read_frames;  /*!< Raw read frames awaiting consumer-side translation */
+	AST_LIST_HEAD_NOLOCK(, ast_frame) deferred_write_frames; /*!< Raw write frames awaiting consumer-side translation */
+	unsigned int deferred_read_samples;                    /*!< Estimated slin samples queued on deferred_read_frames */
+	unsigned int deferred_write_samples;                   /*!< Estimated slin samples queued on deferred_write_frames */
 	struct ast_format *format;                             /*!< Format translation path is setup as */
 	struct ast_trans_pvt *trans_pvt;                       /*!< Translation path for reading frames */
 	ast_audiohook_manipulate_callback manipulate_callback; /*!< Manipulation callback */
@@ -921,6 +921,91 @@ enum ast_bridge_optimization ast_bridges_allow_optimization(struct ast_bridge *c
  */
 int ast_bridge_queue_action(struct ast_bridge *bridge, struct ast_frame *action);
 
+/*!
+ * \brief Inject an audio frame directly into a bridge's output.
+ * \since 18.0.0
+ *
+ * \param bridge What to mix the frame into.
+ * \param frame Audio frame to mix into the bridge output.
+ *
+ * \details
+ * The frame's audio is heard by every participant without being
+ * attributed to any channel in the bridge.  The frame is not consumed
+ * and remains owned by the caller.
+ *
+ * \retval 0 on success.
+ * \retval -1 if the bridge technology does not support sound injection.
+ */
+int ast_bridge_inject_sound(struct ast_bridge *bridge, struct ast_frame *frame);
+
+struct ast_filestream;
+
+/*!
+ * \brief A tap receiving a bridge's final mixed audio.
+ *
+ * Attached to a bridge whose technology mixes all participants into a
+ * single output, the tap is handed that mix once per mixing interval
+ * without a pseudo channel joining the bridge.
+ */
+struct ast_bridge_mix_tap {
+	/*!
+	 * \brief Receive one mixing interval of mixed audio.
+	 *
+	 * Runs on the bridge's mixing thread with the bridge locked, so it
+	 * must not block or try to lock the bridge.  The frame's buffer is
+	 * owned by the mixing loop and is only valid for the duration of
+	 * the call.
+	 *
+	 * \retval 0 on success.
+	 * \retval -1 to detach and destroy the tap.
+	 */
+	int (*deliver)(struct ast_bridge_mix_tap *tap, struct ast_bridge *bridge,
+		struct ast_frame *frame);
+	/*! \brief Destroy the tap.  Called on detach. */
+	void (*destroy)(struct ast_bridge_mix_tap *tap);
+	/*! \brief Linked list information. */
+	AST_LIST_ENTRY(ast_bridge_mix_tap) entry;
+};
+
+/*!
+ * \brief Attach a mixed-output tap to a bridge.
+ *
+ * \param bridge What to tap.
+ * \param tap Tap to attach.  The bridge takes ownership on success.
+ *
+ * \retval 0 on success.
+ * \retval -1 if the bridge technology does not expose its mixed output.
+ */
+int ast_bridge_mix_tap_attach(struct ast_bridge *bridge, struct ast_bridge_mix_tap *tap);
+
+/*!
+ * \brief Detach and destroy a previously attached mixed-output tap.
+ *
+ * \param bridge What the tap is attached to.
+ * \param tap Tap to detach.
+ *
+ * \retval 0 on success.
+ * \retval -1 if the tap was not attached; it may have already detached
+ *         itself by returning -1 from its deliver callback.
+ */
+int ast_bridge_mix_tap_detach(struct ast_bridge *bridge, struct ast_bridge_mix_tap *tap);
+
+/*!
+ * \brief Create a mixed-output tap recording to a file.
+ *
+ * \param fs Open filestream to write the mix to.  The tap takes
+ *        ownership and closes it when destroyed.
+ *
+ * \details
+ * Each mixing interval is written to the filestream as it is produced,
+ * so recording a conference costs one write per interval instead of a
+ * recording channel joined to the bridge.
+ *
+ * \return tap to attach with ast_bridge_mix_tap_attach().
+ * \retval NULL on error.
+ */
+struct ast_bridge_mix_tap *ast_bridge_mix_tap_file_new(struct ast_filestream *fs);
+
 /*!
  * \brief Queue the given frame to everyone else.
  * \since 12.0.0
@@ -78,6 +78,52 @@ enum bridge_channel_thread_state {
 struct ast_bridge;
 struct ast_bridge_tech_optimizations;
 
+/*! \brief Media directions observable by a bridge channel media tap */
+enum ast_bridge_channel_tap_direction {
+	/*! Frames read from the participant. (What the participant says.) */
+	AST_BRIDGE_CHANNEL_TAP_READ = (1 << 0),
+	/*! Frames written to the participant. (What the participant hears.) */
+	AST_BRIDGE_CHANNEL_TAP_WRITE = (1 << 1),
+};
+
+/*!
+ * \brief Lightweight one-way media tap on a bridge channel.
+ *
+ * \details
+ * A media tap receives a copy of the voice frames flowing through a
+ * bridge channel without the cost of a snoop channel: no ast_channel
+ * is allocated, no servicing thread is spawned and no audiohook is
+ * attached.  It is intended for one-way feeds, such as speech
+ * recognition or external call monitoring, where the sink only
+ * consumes audio and never injects any.
+ *
+ * Frames are delivered in the channel's native bridge formats; a sink
+ * that needs a specific format must translate on its own time.
+ */
+struct ast_bridge_channel_tap {
+	/*!
+	 * \brief Deliver one voice frame observed on a tapped direction.
+	 *
+	 * \note Runs on the bridge channel's media thread with the
+	 * bridge_channel locked, so the callback must not block and must
+	 * not acquire the bridge or bridge_channel locks.  Sinks that can
+	 * stall (sockets) should drop the frame instead of waiting.
+	 *
+	 * \note The frame remains owned by the bridging core and must not
+	 * be modified or freed.
+	 *
+	 * \retval 0 on success.
+	 * \retval -1 to detach the tap.  (The sink is gone.)
+	 */
+	int (*deliver)(struct ast_bridge_channel_tap *tap, struct ast_bridge_channel *bridge_channel, struct ast_frame *frame, enum ast_bridge_channel_tap_direction direction);
+	/*! Release the tap.  Called once when the tap is detached. */
+	void (*destroy)(struct ast_bridge_channel_tap *tap);
+	/*! Bitmask of ast_bridge_channel_tap_direction values to observe. */
+	unsigned int directions;
+	/*! Linked list information */
+	AST_LIST_ENTRY(ast_bridge_channel_tap) entry;
+};
+
  /*!
  * \brief Structure that contains information regarding a channel in a bridge
  */
@@ -147,6 +193,8 @@ struct ast_bridge_channel {
 	AST_LIST_HEAD_NOLOCK(, ast_frame) wr_queue;
 	/*! Queue of deferred frames, queued onto channel when other party joins. */
 	AST_LIST_HEAD_NOLOCK(, ast_frame) deferred_queue;
+	/*! Attached media taps fed from the channel's media paths. */
+	AST_LIST_HEAD_NOLOCK(, ast_bridge_channel_tap) media_taps;
 	/*! Pipe to alert thread when frames are put into the wr_queue. */
 	int alert_pipe[2];
 	/*!
@@ -707,6 +755,51 @@ void ast_bridge_channel_feature_digit_add(struct ast_bridge_channel *bridge_chan
  */
 void ast_bridge_channel_feature_digit(struct ast_bridge_channel *bridge_channel, int digit);
 
+/*!
+ * \brief Attach a media tap to a bridge channel.
+ *
+ * \param bridge_channel Channel whose media should be tapped.
+ * \param tap Tap to attach.  On success the bridge channel takes
+ * ownership; the tap's destroy callback runs when it is detached or
+ * when the bridge channel is destroyed.
+ *
+ * \note Unlike a snoop channel, a tap does not hold the channel in
+ * a bridge; when the channel leaves its bridge the tap is destroyed
+ * along with the bridge_channel.
+ *
+ * \retval 0 on success.
+ * \retval -1 on error.
+ */
+int ast_bridge_channel_tap_attach(struct ast_bridge_channel *bridge_channel, struct ast_bridge_channel_tap *tap);
+
+/*!
+ * \brief Detach and destroy a previously attached media tap.
+ *
+ * \param bridge_channel Channel the tap was attached to.
+ * \param tap Tap to detach.  Destroyed if found; a no-op if the tap
+ * was already detached by a delivery failure.
+ */
+void ast_bridge_channel_tap_detach(struct ast_bridge_channel *bridge_channel, struct ast_bridge_channel_tap *tap);
+
+/*!
+ * \brief Allocate a media tap which writes frame payloads to a file descriptor.
+ *
+ * \details
+ * The sink writes each tapped frame's raw payload to the descriptor
+ * and detaches itself on write error, so a recognition or monitoring
+ * feed costs one descriptor rather than a full snoop channel.  The
+ * descriptor should be a connected, non-blocking socket; frames that
+ * would block are dropped rather than stalling the media thread.
+ *
+ * \param fd Descriptor to write payloads to.  The tap takes ownership
+ * and closes it when destroyed.
+ * \param directions Bitmask of ast_bridge_channel_tap_direction values to observe.
+ *
+ * \retval tap ready to attach on success.
+ * \retval NULL on error.
+ */
+struct ast_bridge_channel_tap *ast_bridge_channel_tap_fd_new(int fd, unsigned int directions);
+
 /*!
  * \brief Maps a channel's stream topology to and from the bridge
  * \since 15.0.0
@@ -254,6 +254,8 @@ struct ast_bridge_hook_timer {
 	struct ast_bridge_hook_timer_parms timer;
 };
 
+struct ast_bridge_dtmf_trie;
+
 /*!
  * \brief Structure that contains features information
  */
@@ -264,6 +266,14 @@ struct ast_bridge_features {
 	struct ao2_container *other_hooks;
 	/*! Attached interval hooks */
 	struct ast_heap *interval_hooks;
+	/*!
+	 * \brief Compiled prefix index of the attached DTMF hook codes.
+	 *
+	 * \note Rebuilt lazily under the dtmf_hooks container lock when
+	 * the hook set has changed so per digit matching does not have to
+	 * compare collected digits against every hook code.
+	 */
+	struct ast_bridge_dtmf_trie *dtmf_trie;
 	/*! Feature flags that are enabled */
 	struct ast_flags feature_flags;
 	/*! Used to assign the sequence number to the next interval hook added. */
@@ -278,6 +288,8 @@ struct ast_bridge_features {
 	unsigned int inhibit_colp:1;
 	/*! TRUE if text messaging is permitted. */
 	unsigned int text_messaging:1;
+	/*! TRUE if dtmf_trie no longer reflects the dtmf_hooks container. */
+	unsigned int dtmf_trie_dirty:1;
 };
 
 /*!
@@ -579,6 +591,35 @@ int ast_bridge_dtmf_hook(struct ast_bridge_features *features,
 	ast_bridge_hook_pvt_destructor destructor,
 	enum ast_bridge_hook_remove_flags remove_flags);
 
+/*! \brief How collected digits relate to the attached DTMF hook codes */
+enum ast_bridge_dtmf_match {
+	/*! The collected digits cannot match any DTMF hook code. */
+	AST_BRIDGE_DTMF_MATCH_NONE = 0,
+	/*! The collected digits are a prefix of at least one longer hook code. */
+	AST_BRIDGE_DTMF_MATCH_PARTIAL,
+	/*! A hook code exactly matches the collected digits. */
+	AST_BRIDGE_DTMF_MATCH_EXACT,
+};
+
+/*!
+ * \brief Match collected DTMF digits against the attached DTMF hook codes.
+ *
+ * \details
+ * Walks the compiled feature code trie for the features structure,
+ * recompiling it first if the hook set changed since the last match.
+ * One trie branch is taken per collected digit instead of comparing
+ * the collected string against every hook code.
+ *
+ * \param features Bridge features structure to match against.
+ * \param collected Digits collected so far.
+ *
+ * \note An exact match is reported even if the collected digits are
+ * also a prefix of a longer hook code.
+ *
+ * \return How the collected digits relate to the attached hook codes.
+ */
+enum ast_bridge_dtmf_match ast_bridge_features_dtmf_match(struct ast_bridge_features *features, const char *collected);
+
 /*!
  * \brief Attach an interval hook to a bridge features structure
  *
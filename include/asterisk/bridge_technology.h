@@ -45,6 +45,8 @@ enum ast_bridge_preference {
  * \brief Structure specific to bridge technologies capable of
  * performing talking optimizations.
  */
+struct ast_bridge_mix_tap;
+
 struct ast_bridge_tech_optimizations {
 	/*! Minimum average magnitude threshold to determine talking by the DSP. */
 	unsigned int talking_threshold;
@@ -161,6 +163,46 @@ struct ast_bridge_technology {
 	 * channel joins the bridge.
 	 */
 	int (*write)(struct ast_bridge *bridge, struct ast_bridge_channel *bridge_channel, struct ast_frame *frame);
+	/*!
+	 * \brief Inject an audio frame directly into the bridge output.
+	 *
+	 * \details
+	 * The frame's audio is mixed into what every participant hears
+	 * without being attributed to any channel in the bridge.  A bridge
+	 * technology only needs to define a handler for this callback if
+	 * it can mix unattributed audio; callers must be prepared for the
+	 * callback to be absent.
+	 *
+	 * \retval 0 Frame accepted into the bridge output.
+	 * \retval -1 Frame could not be accepted.
+	 *
+	 * \note On entry, bridge is already locked.
+	 */
+	int (*inject_sound)(struct ast_bridge *bridge, struct ast_frame *frame);
+	/*!
+	 * \brief Attach a tap to the bridge's final mixed output.
+	 *
+	 * \details
+	 * A bridge technology only needs to define handlers for the mix
+	 * tap callbacks if it produces a single mixed output it can share;
+	 * callers must be prepared for the callbacks to be absent.  The
+	 * technology takes ownership of the tap on success.
+	 *
+	 * \retval 0 Tap attached.
+	 * \retval -1 Tap could not be attached.
+	 *
+	 * \note On entry, bridge is already locked.
+	 */
+	int (*mix_tap_attach)(struct ast_bridge *bridge, struct ast_bridge_mix_tap *tap);
+	/*!
+	 * \brief Detach and destroy a tap on the bridge's final mixed output.
+	 *
+	 * \retval 0 Tap detached and destroyed.
+	 * \retval -1 Tap was not attached.
+	 *
+	 * \note On entry, bridge is already locked.
+	 */
+	int (*mix_tap_detach)(struct ast_bridge *bridge, struct ast_bridge_mix_tap *tap);
 	/*!
 	 * \brief Callback for when a request has been made to change a stream topology on a channel
 	 *
@@ -458,6 +458,17 @@ int ast_cdr_serialize_variables(const char *channel_name, struct ast_str **buf,
  */
 typedef int (*ast_cdrbe)(struct ast_cdr *cdr);
 
+/*!
+ * \brief CDR backend batch callback
+ *
+ * Invoked once per batch flush with every record in the batch that passed
+ * posting filters, letting a backend write them in a single transaction
+ * instead of record by record.
+ *
+ * \warning The same restrictions as \ref ast_cdrbe apply to each record.
+ */
+typedef int (*ast_cdrbe_batch)(struct ast_cdr * const *records, size_t count);
+
 /*! \brief Return TRUE if CDR subsystem is enabled */
 int ast_cdr_is_enabled(void);
 
@@ -509,6 +520,24 @@ void ast_cdr_free(struct ast_cdr *cdr);
  */
 int ast_cdr_register(const char *name, const char *desc, ast_cdrbe be);
 
+/*!
+ * \brief Register a CDR handling engine that can post records in batches
+ * \param name name associated with the particular CDR handler
+ * \param desc description of the CDR handler
+ * \param be function pointer to a CDR handler, used when no batch is available
+ * \param batch_be function pointer to a batch CDR handler
+ *
+ * Works like \ref ast_cdr_register, but when a batch of finalized records is
+ * flushed the backend is handed the whole batch through \a batch_be rather
+ * than one \a be call per record. The single-record handler is still
+ * required and is used as a fallback.
+ *
+ * \retval 0 on success.
+ * \retval -1 on error
+ */
+int ast_cdr_register_batch(const char *name, const char *desc, ast_cdrbe be,
+	ast_cdrbe_batch batch_be);
+
 /*!
  * \brief Unregister a CDR handling engine
  * \param name name of CDR handler to unregister
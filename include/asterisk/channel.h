@@ -2049,6 +2049,35 @@ struct ast_frame *ast_read(struct ast_channel *chan);
  */
 struct ast_frame *ast_read_stream(struct ast_channel *chan);
 
+/*!
+ * \brief Read a batch of frames in a single channel lock hold
+ *
+ * \param chan channel to read frames from
+ * \param batch array the read frames are placed in
+ * \param max_frames number of entries available in \a batch
+ *
+ * Reads one frame exactly as ast_read() would and then opportunistically
+ * drains further queued media frames from the read queue while the
+ * channel lock is held once, instead of paying one lock round trip per
+ * frame.  Only frames that would pass through the read path untouched
+ * are drained; the first frame needing translation, DTMF emulation,
+ * audiohooks, or an active generator ends the batch and is left queued.
+ *
+ * \return the number of frames placed in \a batch, each of which the
+ * caller owns and must free with ast_frfree().
+ * \retval -1 if the channel has been disconnected; as with ast_read()
+ * returning NULL, you best just stop reading frames.
+ */
+int ast_read_batch(struct ast_channel *chan, struct ast_frame **batch, unsigned int max_frames);
+
+/*!
+ * \brief Batch variant of ast_read_stream()
+ *
+ * As ast_read_batch(), but the leading frame is read without filtering
+ * to just the default streams, like ast_read_stream().
+ */
+int ast_read_stream_batch(struct ast_channel *chan, struct ast_frame **batch, unsigned int max_frames);
+
 /*!
  * \brief Reads a frame, returning AST_FRAME_NULL frame if audio.
  * \param chan channel to read a frame from
@@ -4221,6 +4250,44 @@ unsigned long ast_channel_insmpl(const struct ast_channel *chan);
 void ast_channel_insmpl_set(struct ast_channel *chan, unsigned long value);
 unsigned long ast_channel_outsmpl(const struct ast_channel *chan);
 void ast_channel_outsmpl_set(struct ast_channel *chan, unsigned long value);
+
+/*!
+ * \brief Causes the core counts dropped media frames by.
+ *
+ * When overloaded the core silently discards media in several places.
+ * Each discard is counted against the channel it happened on and
+ * against a global counter so drops can be diagnosed without a packet
+ * capture.
+ */
+enum ast_frame_drop_cause {
+	/*! The channel read queue overflowed. */
+	AST_FRAME_DROP_READQ = 0,
+	/*! The jitterbuffer discarded or refused the frame. */
+	AST_FRAME_DROP_JITTERBUFFER,
+	/*! Bridge mixing fell behind and flushed buffered audio. */
+	AST_FRAME_DROP_MIXING,
+	/*! \brief Number of drop causes.  Must remain last. */
+	AST_FRAME_DROP_CAUSE_COUNT,
+};
+
+/*!
+ * \brief Count media frames dropped on a channel.
+ *
+ * \param chan Channel the frames were dropped on.  Need not be locked;
+ *             the counters are updated atomically.
+ * \param cause Why the frames were dropped.
+ * \param count Number of frames dropped.
+ */
+void ast_channel_drop_account(struct ast_channel *chan, enum ast_frame_drop_cause cause, unsigned int count);
+
+/*! \brief Number of media frames dropped on the channel for the given cause. */
+unsigned int ast_channel_drops(const struct ast_channel *chan, enum ast_frame_drop_cause cause);
+
+/*! \brief Stable name for a drop cause. ("readq", "jitterbuffer", ...) */
+const char *ast_frame_drop_cause_name(enum ast_frame_drop_cause cause);
+
+/*! \brief Number of media frames dropped across all channels for the given cause. */
+unsigned int ast_frame_drops_global(enum ast_frame_drop_cause cause);
 void *ast_channel_generatordata(const struct ast_channel *chan);
 void ast_channel_generatordata_set(struct ast_channel *chan, void *value);
 void *ast_channel_music_state(const struct ast_channel *chan);
@@ -4272,6 +4339,8 @@ ast_callid ast_channel_callid(const struct ast_channel *chan);
 struct ast_channel_snapshot *ast_channel_snapshot(const struct ast_channel *chan);
 void ast_channel_snapshot_set(struct ast_channel *chan, struct ast_channel_snapshot *snapshot);
 struct ast_flags *ast_channel_snapshot_segment_flags(struct ast_channel *chan);
+struct timeval ast_channel_snapshot_publish_time(const struct ast_channel *chan);
+void ast_channel_snapshot_publish_time_set(struct ast_channel *chan, struct timeval value);
 
 /*!
  * \pre chan is locked
@@ -4358,6 +4427,7 @@ void ast_channel_named_pickupgroups_set(struct ast_channel *chan, struct ast_nam
 
 /* Alertpipe accessors--the "internal" functions for channel.c use only */
 int ast_channel_alert_write(struct ast_channel *chan);
+int ast_channel_alert_write_count(struct ast_channel *chan, size_t count);
 int ast_channel_alert_writable(struct ast_channel *chan);
 ast_alert_status_t ast_channel_internal_alert_flush(struct ast_channel *chan);
 ast_alert_status_t ast_channel_internal_alert_read(struct ast_channel *chan);
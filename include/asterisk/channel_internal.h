@@ -28,6 +28,55 @@ int ast_channel_internal_is_finalized(struct ast_channel *chan);
 void ast_channel_internal_cleanup(struct ast_channel *chan);
 int ast_channel_internal_setup_topics(struct ast_channel *chan);
 
+/*! Drop staged frames beyond this to mirror the readq overflow guard. */
+#define AST_CHANNEL_MAX_QUEUED_FRAMES 128
+
+void ast_channel_internal_fastq_init(struct ast_channel *chan);
+/*!
+ * \brief Stage a frame on the lock-free readq feeder.
+ *
+ * Takes ownership of \a f, which must be a malloc'd (duplicated or
+ * isolated) frame.  May be called from any thread without holding the
+ * channel lock.
+ *
+ * \retval 0 on success.
+ * \retval -1 if the staging queue is over its depth limit; the caller
+ * keeps ownership of the frame.
+ */
+int ast_channel_internal_fastq_push(struct ast_channel *chan, struct ast_frame *f);
+/*!
+ * \brief Move all staged frames onto the tail of the readq.
+ *
+ * Must be called with the channel locked (or otherwise single
+ * threaded, as during destruction).
+ *
+ * \return the number of frames moved.
+ */
+int ast_channel_internal_fastq_collect(struct ast_channel *chan);
+
+/*!
+ * \brief Pre-construct channel shells for the warm channel pool.
+ *
+ * Builds ast_option_channel_pool_size empty channel shells up front so
+ * that ast_channel_alloc() can skip the shell construction allocations
+ * during call setup bursts.  A no-op when the pool size option is zero.
+ *
+ * \param destructor Destructor the pooled shells are constructed with;
+ * only allocations requesting the same destructor are served from the
+ * pool.
+ */
+void ast_channel_internal_pool_prime(void (*destructor)(void *obj));
+/*!
+ * \brief Replace one consumed shell in the warm channel pool.
+ *
+ * Called from the channel destructor so the construction cost is paid
+ * on the teardown path rather than during call setup.  A no-op when the
+ * pool is full, disabled, or shut down.
+ */
+void ast_channel_internal_pool_refill(void (*destructor)(void *obj));
+/*! \brief Release all shells held by the warm channel pool. */
+void ast_channel_internal_pool_shutdown(void);
+
 void ast_channel_internal_errno_set(enum ast_channel_error error);
 enum ast_channel_error ast_channel_internal_errno(void);
 void ast_channel_internal_set_stream_topology(struct ast_channel *chan,
@@ -44,6 +44,19 @@ const char *ast_var_name(const struct ast_var_t *var);
 const char *ast_var_full_name(const struct ast_var_t *var);
 const char *ast_var_value(const struct ast_var_t *var);
 char *ast_var_find(const struct varshead *head, const char *name);
+
+/*!
+ * \brief Find a variable in a list, promoting frequently read entries.
+ *
+ * Behaves like a linear search for the first entry whose name matches,
+ * but a hit found deep in the list is moved to the front so later reads
+ * of the same variable are cheap.  The caller must hold whatever lock
+ * protects \a head (for channel variable lists, the channel lock).
+ *
+ * \retval The matching variable
+ * \retval NULL if the variable is not in the list
+ */
+struct ast_var_t *ast_var_list_find(struct varshead *head, const char *name);
 struct varshead *ast_var_list_clone(struct varshead *head);
 
 #define AST_VAR_LIST_TRAVERSE(head, var) AST_LIST_TRAVERSE(head, var, entries)
@@ -145,10 +145,16 @@ struct ast_dns_query {
 	void *resolver_data;
 	/*! \brief Result of the DNS query */
 	struct ast_dns_result *result;
+	/*! \brief Raw record data staged for the shared DNS cache */
+	struct dns_cache_staging *cache_staging;
+	/*! \brief Scheduler id of a pending cache hit completion, or -1 */
+	int cache_sched_id;
 	/*! \brief Resource record type */
 	int rr_type;
 	/*! \brief Resource record class */
 	int rr_class;
+	/*! \brief TRUE if the query was answered from the shared DNS cache */
+	unsigned int from_cache:1;
 	/*! \brief The name of what is being resolved */
 	char name[0];
 };
@@ -36,6 +36,16 @@ struct ast_dns_resolver {
     /*! \brief Priority for this resolver if multiple exist, lower being higher priority */
     unsigned int priority;
 
+    /*!
+     * \brief TRUE if answers from this resolver may be held in the shared DNS cache
+     *
+     * \note Production resolvers should set this so repeated lookups are
+     *       served without a query.  Leave unset when answers for the same
+     *       name can legitimately differ between back to back queries, such
+     *       as in unit tests.
+     */
+    unsigned int cacheable:1;
+
     /*!
      * \brief Perform resolution of a DNS query
      *
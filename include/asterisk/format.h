@@ -192,6 +192,16 @@ struct ast_format *ast_format_clone(const struct ast_format *format);
  */
 enum ast_format_cmp_res ast_format_cmp(const struct ast_format *format1, const struct ast_format *format2);
 
+/*!
+ * \brief Determine if comparing against a format requires attribute negotiation
+ *
+ * \param format The media format
+ *
+ * \retval 0 The format compares by codec identity alone
+ * \retval 1 Comparisons must consult the format's attribute interface
+ */
+int ast_format_attribute_cmp_required(const struct ast_format *format);
+
 /*!
  * \brief Get a common joint capability between two formats
  *
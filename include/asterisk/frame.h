@@ -235,6 +235,10 @@ extern struct ast_frame ast_null_frame;
 #define AST_MALLOCD_DATA	(1 << 1)
 /*! Need the source be free'd? (haha!) */
 #define AST_MALLOCD_SRC		(1 << 2)
+/*! The data buffer is a shared reference counted block.  Shared data is
+ *  immutable; a consumer that wants to modify it must ast_frisolate()
+ *  the frame first. */
+#define AST_MALLOCD_DATA_SHARED	(1 << 3)
 
 /* MODEM subclasses */
 /*! T.38 Fax-over-IP */
@@ -585,6 +589,22 @@ struct ast_frame *__ast_frisolate(struct ast_frame *fr, const char *file, int li
 #define ast_frdup(fr) __ast_frdup(fr, __FILE__, __LINE__, __PRETTY_FUNCTION__)
 struct ast_frame *__ast_frdup(const struct ast_frame *fr, const char *file, int line, const char *func);
 
+/*!
+ * \brief Duplicates a frame, sharing its data buffer by reference
+ *
+ * Duplicating an unshared frame copies its data once into a reference
+ * counted block; duplicating a frame returned here only bumps the
+ * block reference.  This lets a bridge fan one media buffer out to N
+ * receivers with a single copy.
+ *
+ * The shared buffer is immutable.  Use ast_frisolate() to obtain a
+ * private, writable copy.
+ *
+ * \return Returns a frame on success, NULL on error
+ */
+#define ast_frdup_shared(fr) __ast_frdup_shared(fr, __FILE__, __LINE__, __PRETTY_FUNCTION__)
+struct ast_frame *__ast_frdup_shared(const struct ast_frame *fr, const char *file, int line, const char *func);
+
 void ast_swapcopy_samples(void *dst, const void *src, int samples);
 
 /* Helpers for byteswapping native samples to/from
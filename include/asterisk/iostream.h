@@ -34,6 +34,7 @@
 struct ssl_st;                  /* forward declaration */
 struct ssl_ctx_st;              /* forward declaration */
 struct timeval;                 /* forward declaration */
+struct iovec;                   /* forward declaration */
 typedef struct ssl_st SSL;
 typedef struct ssl_ctx_st SSL_CTX;
 
@@ -163,6 +164,34 @@ SSL *ast_iostream_get_ssl(struct ast_iostream *stream);
  */
 ssize_t ast_iostream_read(struct ast_iostream *stream, void *buffer, size_t count);
 
+/*!
+ * \brief Peek at data buffered in an iostream without consuming it.
+ *
+ * Fills the stream's internal read-ahead buffer with a single read if it
+ * is empty and returns a pointer to the buffered data.  The data remains
+ * available until it is removed with ast_iostream_consume(), so several
+ * small protocol elements can be parsed from one read.
+ *
+ * \param stream A pointer to an iostream
+ * \param buffer Set to the start of the buffered data on return.
+ *
+ * \return The number of bytes available at \a buffer.  Returns \c 0 on
+ *         EOF or timeout and \c -1 on error with \c errno possibly set.
+ *
+ * \note The returned pointer is only valid until the next operation on
+ *       the stream.
+ */
+ssize_t ast_iostream_peek(struct ast_iostream *stream, char **buffer);
+
+/*!
+ * \brief Consume data previously returned by ast_iostream_peek().
+ *
+ * \param stream A pointer to an iostream
+ * \param count The number of bytes to remove from the read-ahead buffer.
+ *        Must not exceed the length returned by ast_iostream_peek().
+ */
+void ast_iostream_consume(struct ast_iostream *stream, size_t count);
+
 /*!
  * \brief Read a LF-terminated string from an iostream.
  *
@@ -206,6 +235,27 @@ ssize_t ast_iostream_discard(struct ast_iostream *stream, size_t count);
  */
 ssize_t ast_iostream_write(struct ast_iostream *stream, const void *buffer, size_t count);
 
+/*!
+ * \brief Write the buffers described by an I/O vector to an iostream.
+ *
+ * Writes the buffers as a single unit (a single \c writev() call on
+ * plain sockets), which avoids both a coalescing copy and per-buffer
+ * write syscalls for callers that assemble messages from separate
+ * header and payload buffers.
+ *
+ * \param stream A pointer to an iostream
+ * \param iov Array of buffers to write, in order.
+ * \param iovcnt The number of elements in \a iov.
+ *
+ * \return Upon successful completion, returns the number of bytes actually
+ *         written to the iostream. Otherwise, returns \c -1 and may set
+ *         \c errno to indicate the error.
+ *
+ * \note On TLS streams the buffers are written sequentially, as OpenSSL
+ *       has no vectored write.
+ */
+ssize_t ast_iostream_writev(struct ast_iostream *stream, const struct iovec *iov, int iovcnt);
+
 /*!
  * \brief Write a formatted string to an iostream.
  *
@@ -0,0 +1,117 @@
+/*
+ * Asterisk -- An open source telephony toolkit.
+ *
+ * See http://www.asterisk.org for more information about
+ * the Asterisk project. Please do not directly contact
+ * any of the maintainers of this project for assistance;
+ * the project provides a web site, mailing lists and IRC
+ * channels for your use.
+ *
+ * This program is free software, distributed under the terms of
+ * the GNU General Public License Version 2. See the LICENSE file
+ * at the top of the source tree.
+ */
+
+/*! \file
+ * \brief Media pipeline latency tracepoints
+ *
+ * Static tracepoints at the media pipeline stages (channel frame
+ * read, translation, bridge dispatch, channel write and RTP socket
+ * I/O).  Each sample is pushed into a lock-free ring consumed by the
+ * 'core trace latency' CLI command and, when the toolchain provides
+ * <sys/sdt.h>, also fired as a USDT probe so external tools
+ * (perf/bpftrace/systemtap) can attach without symbol guesswork.
+ *
+ * The tracepoints cost a single flag test while disabled, so they
+ * are compiled in unconditionally.
+ */
+
+#ifndef _ASTERISK_LATENCY_TRACE_H
+#define _ASTERISK_LATENCY_TRACE_H
+
+#include <time.h>
+
+#include "asterisk/time.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*! \brief Instrumented media pipeline stages */
+enum ast_latency_stage {
+	/*! Channel frame read (ast_read and friends). */
+	AST_LATENCY_STAGE_READ = 0,
+	/*! Codec translation (ast_translate). */
+	AST_LATENCY_STAGE_TRANSLATE,
+	/*! Bridge outgoing frame dispatch to a channel. */
+	AST_LATENCY_STAGE_BRIDGE,
+	/*! Channel frame write (ast_write). */
+	AST_LATENCY_STAGE_WRITE,
+	/*! RTP socket read and depacketization. */
+	AST_LATENCY_STAGE_RTP_READ,
+	/*! RTP packetization and socket write. */
+	AST_LATENCY_STAGE_RTP_WRITE,
+	/*! \internal Number of stages.  Must be last. */
+	AST_LATENCY_STAGE_MAX,
+};
+
+/*!
+ * \brief Nonzero while latency tracing is enabled.
+ *
+ * \note Toggled by the 'core trace latency {on|off}' CLI command.
+ * Treat as read only everywhere else.
+ */
+extern int ast_latency_trace_enabled;
+
+/*!
+ * \internal
+ * \brief Record one stage latency sample.
+ *
+ * \param stage Pipeline stage the sample belongs to.
+ * \param usec Stage duration in microseconds.
+ *
+ * \note Called via ast_latency_trace_end().  Lock free and safe from
+ * any thread.
+ */
+void __ast_latency_trace_record(enum ast_latency_stage stage, int64_t usec);
+
+/*!
+ * \brief Begin timing a pipeline stage.
+ *
+ * \return Stage start time, or the zero timeval when tracing is
+ * disabled.
+ *
+ * \note Pass the result to ast_latency_trace_end() at the end of the
+ * stage.  Costs only a flag test while tracing is disabled.
+ */
+static inline struct timeval ast_latency_trace_start(void)
+{
+	if (!ast_latency_trace_enabled) {
+		struct timeval zero = { 0, 0 };
+
+		return zero;
+	}
+	return ast_tvnow();
+}
+
+/*!
+ * \brief Finish timing a pipeline stage and record the sample.
+ *
+ * \param stage Pipeline stage being timed.
+ * \param start Start time from ast_latency_trace_start().
+ *
+ * \note Does nothing if tracing was disabled when the stage started.
+ */
+static inline void ast_latency_trace_end(enum ast_latency_stage stage, const struct timeval *start)
+{
+	if (!start->tv_sec && !start->tv_usec) {
+		return;
+	}
+	__ast_latency_trace_record(stage, ast_tvdiff_us(ast_tvnow(), *start));
+}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif /* _ASTERISK_LATENCY_TRACE_H */
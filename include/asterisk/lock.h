@@ -683,6 +683,18 @@ static void  __attribute__((destructor)) fini_##rwlock(void) \
 #define ast_atomic_fetch_xor(ptr, val, memorder)  __atomic_fetch_xor((ptr), (val), (memorder))
 #define ast_atomic_xor_fetch(ptr, val, memorder)  __atomic_xor_fetch((ptr), (val), (memorder))
 
+/*! Atomic exchange, returns the previous value of *ptr */
+#define ast_atomic_exchange_n(ptr, val, memorder) __atomic_exchange_n((ptr), (val), (memorder))
+
+/*! Atomic load */
+#define ast_atomic_load_n(ptr, memorder)          __atomic_load_n((ptr), (memorder))
+
+/*! Atomic store */
+#define ast_atomic_store_n(ptr, val, memorder)    __atomic_store_n((ptr), (val), (memorder))
+
+/*! Atomic thread fence */
+#define ast_atomic_thread_fence(memorder)         __atomic_thread_fence(memorder)
+
 #if 0
 /* Atomic compare and swap
  *
@@ -716,6 +728,18 @@ static void  __attribute__((destructor)) fini_##rwlock(void) \
 #define ast_atomic_fetch_xor(ptr, val, memorder)  __sync_fetch_and_xor((ptr), (val))
 #define ast_atomic_xor_fetch(ptr, val, memorder)  __sync_xor_and_fetch((ptr), (val))
 
+/*! Atomic exchange, returns the previous value of *ptr */
+#define ast_atomic_exchange_n(ptr, val, memorder) __sync_lock_test_and_set((ptr), (val))
+
+/*! Atomic load */
+#define ast_atomic_load_n(ptr, memorder)          __sync_fetch_and_add((ptr), 0)
+
+/*! Atomic store */
+#define ast_atomic_store_n(ptr, val, memorder)    ((void) __sync_lock_test_and_set((ptr), (val)))
+
+/*! Atomic thread fence */
+#define ast_atomic_thread_fence(memorder)         __sync_synchronize()
+
 #if 0
 /* Atomic compare and swap
  *
@@ -74,6 +74,11 @@ int ast_media_cache_exists(const char *uri);
  * it will be used as the destination file for the retrieval. When retrieval
  * of the media from the backend is complete, \c file_path is then populated
  * as before.
+ *
+ * If the item is in the cache but the backend reports it as stale, the
+ * cached copy is returned immediately and a refresh from the backend is
+ * performed in the background, so callers on the media path never wait
+ * for a re-download of media they have played before.
  */
 int ast_media_cache_retrieve(const char *uri, const char *preferred_file_name,
 	char *file_path, size_t len);
@@ -31,6 +31,8 @@
 extern "C" {
 #endif
 
+struct ast_taskprocessor;
+
 /*! \brief
  * Each supported file format is described by the following structure.
  *
@@ -124,6 +126,15 @@ struct ast_filestream {
 	void *_private;	/*!< pointer to private buffer */
 	const char *orig_chan_name;
 	char *write_buffer;
+	/*! Frames waiting to be written by the async recording writer,
+	 * guarded by the filestream's ao2 lock. */
+	AST_LIST_HEAD_NOLOCK(, ast_frame) write_q;
+	/*! Serializer draining write_q on the recording writer pool, or NULL
+	 * when writes are performed inline on the caller's thread. */
+	struct ast_taskprocessor *write_tps;
+	/*! When the stream was opened through the shared sound cache, the
+	 * reference keeping the in-memory file contents alive (owned by file.c). */
+	void *cached;
 };
 
 /*!
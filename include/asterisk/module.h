@@ -221,6 +221,21 @@ int ast_update_module_list_data(int (*modentry)(const char *module, const char *
                                                 void *data),
                                 const char *like, void *data);
 
+/*!
+ * \brief Ask for a list of modules and the time each took to initialize.
+ * \param modentry A callback to an updater function
+ * \param like
+ *
+ * For each of the modules loaded, modentry will be executed with the resource,
+ * the duration of the module's most recent load() callback in microseconds,
+ * and the running status of each particular module.
+ *
+ * \return the number of modules loaded
+ */
+int ast_update_module_list_times(int (*modentry)(const char *module, int64_t load_time_us,
+                                                 const char *status, const char *like),
+                                 const char *like);
+
 /*!
  * \brief Ask for a list of modules, descriptions, use counts and status.
  * \param modentry A callback to an updater function
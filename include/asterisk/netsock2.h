@@ -195,6 +195,55 @@ int ast_sockaddr_cmp(const struct ast_sockaddr *a, const struct ast_sockaddr *b)
  */
 int ast_sockaddr_cmp_addr(const struct ast_sockaddr *a, const struct ast_sockaddr *b);
 
+/*!
+ * \brief
+ * A canonical fixed-size comparison key for an ast_sockaddr.
+ *
+ * \details
+ * Extracting a key once with ast_sockaddr_to_key() turns repeated equality
+ * checks against the same address into a few word comparisons, which is
+ * cheaper than ast_sockaddr_cmp() on hot per-packet paths.  IPv4 addresses
+ * are stored in their IPv4-mapped IPv6 form, so a mapped address and its
+ * plain IPv4 equivalent produce the same key just as ast_sockaddr_cmp()
+ * considers them equal.
+ *
+ * \note The key is a snapshot; it must be re-extracted when the address
+ * it was taken from changes.
+ */
+struct ast_sockaddr_key {
+	uint64_t addr[2];	/*!< The 128 bit address, IPv4 in IPv4-mapped form */
+	uint32_t scope_id;	/*!< IPv6 scope, always 0 for IPv4 */
+	uint16_t port;		/*!< Port in network byte order */
+};
+
+/*!
+ * \brief
+ * Extract the canonical comparison key of an address.
+ *
+ * \param addr The address to extract the key from
+ * \param[out] key The extracted key
+ *
+ * \retval 0 Success
+ * \retval -1 The address is not IPv4 or IPv6; the key is zeroed
+ */
+int ast_sockaddr_to_key(const struct ast_sockaddr *addr, struct ast_sockaddr_key *key);
+
+/*!
+ * \brief
+ * Compare two address keys for equality.
+ *
+ * \note Unlike ast_sockaddr_cmp() this provides no ordering, only equality.
+ *
+ * \retval 0 \a a is equal to \a b
+ * \retval non-zero \a a is not equal to \a b
+ */
+static inline int ast_sockaddr_key_cmp(const struct ast_sockaddr_key *a,
+		const struct ast_sockaddr_key *b)
+{
+	return a->addr[0] != b->addr[0] || a->addr[1] != b->addr[1]
+		|| a->port != b->port || a->scope_id != b->scope_id;
+}
+
 #define AST_SOCKADDR_STR_ADDR		(1 << 0)
 #define AST_SOCKADDR_STR_PORT		(1 << 1)
 #define AST_SOCKADDR_STR_BRACKETS	(1 << 2)
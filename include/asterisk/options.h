@@ -189,6 +189,11 @@ extern int ast_option_maxfiles;		/*!< Max number of open file handles (files, so
 extern int option_debug;		/*!< Debugging */
 extern int option_trace;		/*!< Debugging */
 extern int ast_option_maxcalls;		/*!< Maximum number of simultaneous channels */
+extern int ast_option_channel_pool_size;	/*!< Number of pre-constructed channel shells to keep warm (channel.c) */
+extern int ast_option_soundscachesize;	/*!< Megabytes of sound files to share between streams (file.c), 0 disables the cache */
+extern int ast_option_recordasyncthreads;	/*!< Max threads flushing recordings off the media threads (file.c), 0 writes inline */
+extern int ast_option_recordfsync;	/*!< fsync() recorded files before closing them (file.c) */
+extern int ast_option_snapshotcoalesce;	/*!< Minimum ms between insignificant channel snapshot publishes (stasis_channels.c), 0 publishes every change */
 extern unsigned int option_dtmfminduration;	/*!< Minimum duration of DTMF (channel.c) in ms */
 extern double ast_option_maxload;
 #if defined(HAVE_SYSINFO)
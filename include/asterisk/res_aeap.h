@@ -236,6 +236,38 @@ int ast_aeap_connect(struct ast_aeap *aeap, const char *url, const char *protoco
 struct ast_aeap *ast_aeap_create_and_connect_by_id(const char *id,
 	const struct ast_aeap_params *params, int timeout);
 
+/*!
+ * \brief Acquire a connected Asterisk external application object by sorcery id
+ *
+ * Reuses an idle pooled connection previously released for the same id and
+ * parameters if one is available, otherwise creates and connects a new one.
+ * Release the returned object with ast_aeap_release_by_id when done with it
+ * so the connection can be parked for reuse instead of torn down.
+ *
+ * \param id The sorcery id to lookup
+ * \param params Callbacks and other parameters to use
+ * \param timeout How long (in milliseconds) to attempt to connect (-1 equals infinite)
+ *
+ * \returns An ao2 reference counted aeap object, or NULL on error
+ */
+struct ast_aeap *ast_aeap_acquire_by_id(const char *id,
+	const struct ast_aeap_params *params, int timeout);
+
+/*!
+ * \brief Release an Asterisk external application object acquired by sorcery id
+ *
+ * Parks the connection for reuse by a later acquire if it is still connected
+ * and the idle pool is not full, otherwise the reference is simply dropped.
+ * Any user data objects registered on the object must be un-registered before
+ * releasing it.
+ *
+ * \param id The sorcery id the object was acquired with
+ * \param params The parameters the object was acquired with
+ * \param aeap The object to release (Ref is consumed.)
+ */
+void ast_aeap_release_by_id(const char *id, const struct ast_aeap_params *params,
+	struct ast_aeap *aeap);
+
 /*!
  * \brief Create and connect to an Asterisk external application
  *
@@ -261,6 +293,15 @@ struct ast_aeap *ast_aeap_create_and_connect(const char *type,
  */
 int ast_aeap_disconnect(struct ast_aeap *aeap);
 
+/*!
+ * \brief Whether or not the Asterisk external application object is connected
+ *
+ * \param aeap An Asterisk external application object
+ *
+ * \returns True if connected, false otherwise
+ */
+int ast_aeap_is_connected(struct ast_aeap *aeap);
+
 /*!
  * \brief Register a user data object
  *
@@ -52,6 +52,10 @@ struct odbc_obj {
 	int lineno;
 #endif
 	char *sql_text;					/*!< The SQL text currently executing */
+	/*! Prepared statements cached on this connection, most recently used first */
+	AST_LIST_HEAD_NOLOCK(, odbc_cached_stmt) cached_stmts;
+	/*! The number of statements in the cache */
+	size_t cached_stmt_cnt;
 	AST_LIST_ENTRY(odbc_obj) list;
 };
 
@@ -170,6 +174,41 @@ SQLHSTMT ast_odbc_prepare_and_execute(struct odbc_obj *obj, SQLHSTMT (*prepare_c
  */
 int ast_odbc_prepare(struct odbc_obj *obj, SQLHSTMT *stmt, const char *sql);
 
+/*!
+ * \brief Retrieve a prepared statement from the connection's cache, preparing
+ * and caching it first if the SQL text has not been seen on this connection.
+ *
+ * \param obj The ODBC object
+ * \param sql The SQL query, with '?' placeholders for any parameters
+ *
+ * Realtime lookups prepare the same small set of statement shapes over and
+ * over, paying a server round trip for each prepare.  Statements returned by
+ * this function are owned by the connection and stay prepared until the
+ * connection is disconnected, so repeating a lookup with the same SQL text
+ * skips the prepare entirely.  The returned statement is reset and ready for
+ * parameter binding.
+ *
+ * \note A statement obtained here must be released with ast_odbc_release_stmt()
+ * instead of SQLFreeHandle(), and only one cached statement may be in use on a
+ * connection at any one time.
+ *
+ * \return a prepared statement handle
+ * \retval NULL on error
+ */
+SQLHSTMT ast_odbc_prepare_cached(struct odbc_obj *obj, const char *sql);
+
+/*!
+ * \brief Release a statement handle obtained from ast_odbc_prepare_cached()
+ *
+ * \param obj The ODBC object the statement was prepared on
+ * \param stmt The statement handle
+ *
+ * If the statement is cached on the connection its cursor is closed and the
+ * prepared statement is retained for the next use; otherwise the handle is
+ * freed.
+ */
+void ast_odbc_release_stmt(struct odbc_obj *obj, SQLHSTMT stmt);
+
 /*! \brief Execute a unprepared SQL query.
  * \param obj The ODBC object
  * \param stmt The statement
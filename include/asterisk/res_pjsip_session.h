@@ -125,6 +125,14 @@ struct ast_sip_session_media {
 	char *remote_label;
 	/*! \brief Stream name */
 	char *stream_name;
+	/*! \brief Pool backing the cached outgoing SDP stream */
+	pj_pool_t *cached_media_pool;
+	/*! \brief Cached copy of the last outgoing SDP stream this handler produced */
+	struct pjmedia_sdp_media *cached_media;
+	/*! \brief Hash of the stream the cached SDP stream was produced from */
+	unsigned int cached_media_stream_hash;
+	/*! \brief Non-stream state the cached SDP stream depends upon */
+	unsigned int cached_media_flags;
 };
 
 /*!
@@ -70,6 +70,9 @@ struct prometheus_general_config {
 	unsigned int enabled;
 	/*! \brief Whether or not core metrics are enabled */
 	unsigned int core_metrics_enabled;
+	/*! \brief How long (ms) a formatted scrape may be served from cache.
+	 * 0 disables caching. */
+	unsigned int scrape_cache_ms;
 	AST_DECLARE_STRING_FIELDS(
 		/*! \brief The HTTP URI we register ourselves to */
 		AST_STRING_FIELD(uri);
@@ -46,8 +46,12 @@ struct ast_srtp_res {
 	void (*set_cb)(struct ast_srtp *srtp, const struct ast_srtp_cb *cb, void *data);
 	/* Unprotect SRTP data */
 	int (*unprotect)(struct ast_srtp *srtp, void *buf, int *size, int rtcp);
-	/* Protect RTP data */
-	int (*protect)(struct ast_srtp *srtp, void **buf, int *size, int rtcp);
+	/* Protect RTP data.  avail is the total usable space at *buf; when it
+	 * leaves enough tail room past the packet for the authentication
+	 * trailer the data is encrypted in place, otherwise it is bounced
+	 * through an internal buffer and *buf is updated to point there.
+	 * Pass an avail of zero when the buffer capacity is unknown. */
+	int (*protect)(struct ast_srtp *srtp, void **buf, int *size, int rtcp, size_t avail);
 	/* Obtain a random cryptographic key */
 	int (*get_random)(unsigned char *key, size_t len);
 };
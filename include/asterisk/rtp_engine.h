@@ -129,6 +129,8 @@ enum ast_rtp_property {
 	AST_RTP_PROPERTY_RETRANS_SEND,
 	/*! Enable REMB sending and receiving passthrough support */
 	AST_RTP_PROPERTY_REMB,
+	/*! Send telephone events to the core instead of passing them through a local bridge */
+	AST_RTP_PROPERTY_DTMF_TO_CORE,
 
 	/*!
 	 * \brief Maximum number of RTP properties supported
@@ -649,6 +651,14 @@ struct ast_rtp_engine {
 	enum ast_rtp_dtmf_mode (*dtmf_mode_get)(struct ast_rtp_instance *instance);
 	/*! Callback for retrieving statistics */
 	int (*get_stat)(struct ast_rtp_instance *instance, struct ast_rtp_instance_stats *stats, enum ast_rtp_instance_stat stat);
+	/*!
+	 * Optional callback for retrieving statistics without holding the
+	 * instance lock.  Engines maintaining a lock-free statistics snapshot
+	 * implement this so monitoring consumers never contend with the media
+	 * path.  Return -1 when no snapshot is available yet; the core then
+	 * falls back to the locked get_stat callback.
+	 */
+	int (*get_stat_nolock)(struct ast_rtp_instance *instance, struct ast_rtp_instance_stats *stats, enum ast_rtp_instance_stat stat);
 	/*! Callback for setting QoS values */
 	int (*qos)(struct ast_rtp_instance *instance, int tos, int cos, const char *desc);
 	/*! Callback for retrieving a file descriptor to poll on, not always required */
@@ -204,6 +204,21 @@ struct ast_cb_names {
  */
 void ast_sched_report(struct ast_sched_context *con, struct ast_str **buf, struct ast_cb_names *cbnames);
 
+/*!
+ * \brief Append callback execution statistics for a context
+ *
+ * Reports how many callbacks the context has executed along with the
+ * callback duration and late-fire delta distributions (average, p50,
+ * p99, max).  The late-fire delta is how far past its scheduled expiry
+ * a callback actually started; a growing delta is an early warning
+ * that the context is overloaded.  The percentiles come from power of
+ * two millisecond histogram buckets and are therefore upper bounds.
+ *
+ * \param con Schedule context to report on
+ * \param buf dynamic string to append the report to
+ */
+void ast_sched_exec_report(struct ast_sched_context *con, struct ast_str **buf);
+
 /*!
  * \brief Adds a scheduled event
  *
@@ -30,14 +30,10 @@
 extern "C" {
 #endif
 
-#define AST_SLINFACTORY_MAX_HOLD 1280
-
 struct ast_slinfactory {
 	AST_LIST_HEAD_NOLOCK(, ast_frame) queue; /*!< A list of unaltered frames */
 	struct ast_trans_pvt *trans;             /*!< Translation path that converts fed frames into signed linear */
-	short hold[AST_SLINFACTORY_MAX_HOLD];    /*!< Hold for audio that no longer belongs to a frame (ie: if only some samples were taken from a frame) */
-	short *offset;                           /*!< Offset into the hold where audio begins */
-	size_t holdlen;                          /*!< Number of samples currently in the hold */
+	size_t head_used;                        /*!< Number of samples already consumed from the frame at the head of the queue */
 	unsigned int size;                       /*!< Number of samples currently in the factory */
 	struct ast_format *format;               /*!< Current format the translation path is converting from */
 	struct ast_format *output_format;        /*!< The output format desired */
@@ -341,6 +341,23 @@ struct ast_sorcery_observer {
 
 	/*! \brief Callback for when an object type is loaded/reloaded */
 	void (*loaded)(const char *object_type);
+
+	/*!
+	 * \brief Optional callback for when an object is updated, with the fields that changed
+	 *
+	 * \param object The updated object
+	 * \param changes The fields of the updated object which differ from the previous
+	 * version, as produced by ast_sorcery_diff(). May be NULL if nothing relevant
+	 * changed or if the previous version of the object could not be retrieved for
+	 * comparison.
+	 *
+	 * When provided this is invoked in addition to \c updated and allows observers
+	 * to skip work entirely when only fields they do not care about have changed.
+	 * Registering an observer with this callback causes sorcery to retrieve the
+	 * previous version of each updated object in order to compute the change set,
+	 * so it should only be used by observers which actually consult the changes.
+	 */
+	void (*updated_with_changes)(const void *object, const struct ast_variable *changes);
 };
 
 /*! \brief Opaque structure for internal sorcery object */
@@ -27,6 +27,10 @@
 extern "C" {
 #endif
 
+struct ast_frame;
+struct ast_trans_pvt;
+struct ast_trans_ring;
+
 /* Speech structure flags */
 enum ast_speech_flags {
 	AST_SPEECH_QUIET = (1 << 0),        /* Quiet down output... they are talking */
@@ -70,6 +74,14 @@ struct ast_speech {
 	enum ast_speech_results_type results_type;
 	/*! Pointer to the engine used by this speech structure */
 	struct ast_speech_engine *engine;
+	/*! Alert pipe written when the engine changes state or posts results */
+	int alert_pipe[2];
+	/*! Translation path used when written frames do not match the engine format */
+	struct ast_trans_pvt *translator;
+	/*! Source format the translator currently accepts */
+	struct ast_format *translator_src;
+	/*! Ring translated audio is pulled through on its way to the engine */
+	struct ast_trans_ring *trans_ring;
 };
 
 /* Speech recognition engine structure */
@@ -90,6 +102,12 @@ struct ast_speech_engine {
 	int (*deactivate)(struct ast_speech *speech, const char *grammar_name);
 	/*! Write audio to the speech engine */
 	int (*write)(struct ast_speech *speech, void *data, int len);
+	/*! Write a whole frame of audio to the speech engine (optional).
+	 * Preferred over \ref write when available since the engine gets the
+	 * frame without an intermediate copy and can use the timing
+	 * information it carries to batch delivery.  The frame remains owned
+	 * by the caller. */
+	int (*write_frame)(struct ast_speech *speech, struct ast_frame *frame);
 	/*! Signal DTMF was received */
 	int (*dtmf)(struct ast_speech *speech, const char *dtmf);
 	/*! Prepare engine to accept audio */
@@ -141,6 +159,14 @@ struct ast_speech *ast_speech_new(const char *engine_name, const struct ast_form
 int ast_speech_destroy(struct ast_speech *speech);
 /*! \brief Write audio to the speech engine */
 int ast_speech_write(struct ast_speech *speech, void *data, int len);
+/*!
+ * \brief Write a frame of audio to the speech engine
+ *
+ * Uses the engine's frame handoff if it provides one so the audio is
+ * not copied on the way in, and falls back to the byte based write
+ * otherwise.  The frame is not consumed; the caller still owns it.
+ */
+int ast_speech_write_frame(struct ast_speech *speech, struct ast_frame *frame);
 /*! \brief Signal to the engine that DTMF was received */
 int ast_speech_dtmf(struct ast_speech *speech, const char *dtmf);
 /*! \brief Change an engine specific attribute */
@@ -151,6 +177,20 @@ int ast_speech_get_setting(struct ast_speech *speech, const char *name, char *bu
 int ast_speech_change_results_type(struct ast_speech *speech, enum ast_speech_results_type results_type);
 /*! \brief Change state of a speech structure */
 int ast_speech_change_state(struct ast_speech *speech, int state);
+/*!
+ * \brief Retrieve a pollable speech state alert file descriptor
+ *
+ * The descriptor becomes readable when the engine transitions the
+ * structure into the wait or done states, letting an application block
+ * in ast_waitfor_nandfds() and react to results the moment they are
+ * posted instead of on its next scheduled wakeup.
+ *
+ * \retval fd to poll on success.
+ * \retval -1 if no alert pipe is available.
+ */
+int ast_speech_get_alert_fd(struct ast_speech *speech);
+/*! \brief Acknowledge a state alert after waking on the alert file descriptor */
+void ast_speech_clear_alert(struct ast_speech *speech);
 /*! \brief Register a speech recognition engine */
 int ast_speech_register(struct ast_speech_engine *engine);
 /*! \brief Unregister a speech recognition engine */
@@ -1268,6 +1268,23 @@ struct stasis_message *stasis_cache_clear_create(struct stasis_message *message)
  */
 struct stasis_message *stasis_cache_get(struct stasis_cache *cache, struct stasis_message_type *type, const char *id);
 
+/*!
+ * \brief Get the current generation of a cache.
+ *
+ * The generation is incremented every time a snapshot is inserted into,
+ * updated in, or removed from the cache.  A consumer that re-queries the
+ * cache periodically can remember the generation along with its last
+ * result and skip the re-query (and any derived work) when the generation
+ * has not moved.
+ *
+ * The counter may wrap; compare generations only for equality.
+ *
+ * \param cache The cache to query.
+ *
+ * \return Current cache generation.
+ */
+int stasis_cache_generation(struct stasis_cache *cache);
+
 /*!
  * \brief Retrieve an item from the cache for a specific entity.
  *
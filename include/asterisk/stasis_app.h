@@ -979,6 +979,37 @@ int stasis_app_get_debug_by_name(const char *app_name);
  */
 void stasis_app_set_global_debug(int debug);
 
+/*!
+ * \brief Set the talk detection coalescing window on an application
+ *
+ * While the window is non-zero, ChannelTalkingStarted/ChannelTalkingFinished
+ * events are debounced per channel: a transition is only delivered once the
+ * previously reported state is at least a window old, so rapid flapping from
+ * noisy audio collapses into the stable transitions.
+ *
+ * \param app The app to configure
+ * \param window_ms Coalescing window in milliseconds.  Zero delivers every
+ *        transition.
+ */
+void stasis_app_set_talk_coalesce(struct stasis_app *app, unsigned int window_ms);
+
+/*!
+ * \brief Set the talk detection coalescing window on an application
+ *
+ * \param app_name The app name to configure
+ * \param window_ms Coalescing window in milliseconds.  Zero delivers every
+ *        transition.
+ */
+void stasis_app_set_talk_coalesce_by_name(const char *app_name, unsigned int window_ms);
+
+/*!
+ * \brief Get the talk detection coalescing window of an application
+ *
+ * \param app The app to check
+ * \return The coalescing window in milliseconds
+ */
+unsigned int stasis_app_get_talk_coalesce(struct stasis_app *app);
+
 struct ast_cli_args;
 
 /*!
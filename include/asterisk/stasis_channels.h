@@ -76,16 +76,14 @@ struct ast_channel_snapshot_dialplan {
  * \brief Structure containing caller information for a channel snapshot.
  */
 struct ast_channel_snapshot_caller {
-	AST_DECLARE_STRING_FIELDS(
-		AST_STRING_FIELD(name);           /*!< Caller ID Name */
-		AST_STRING_FIELD(number);         /*!< Caller ID Number */
-		AST_STRING_FIELD(dnid);           /*!< Dialed ID Number */
-		AST_STRING_FIELD(dialed_subaddr); /*!< Dialed subaddress */
-		AST_STRING_FIELD(ani);            /*!< Caller ID ANI Number */
-		AST_STRING_FIELD(rdnis);          /*!< Caller ID RDNIS Number */
-		AST_STRING_FIELD(subaddr);        /*!< Caller subaddress */
-	);
-	int pres; /*!< Caller ID presentation. */
+	char *number;         /*!< Caller ID Number */
+	char *dnid;           /*!< Dialed ID Number */
+	char *dialed_subaddr; /*!< Dialed subaddress */
+	char *ani;            /*!< Caller ID ANI Number */
+	char *rdnis;          /*!< Caller ID RDNIS Number */
+	char *subaddr;        /*!< Caller subaddress */
+	int pres;             /*!< Caller ID presentation. */
+	char name[0];         /*!< Caller ID Name */
 };
 
 /*!
@@ -212,6 +210,20 @@ struct stasis_topic *ast_channel_topic_all(void);
  */
 struct ao2_container *ast_channel_cache_by_name(void);
 
+/*!
+ * \brief Get the current generation of the channel snapshot cache.
+ *
+ * The generation is incremented every time a snapshot is inserted into,
+ * updated in, or removed from the cache.  A consumer that dumps the
+ * cache periodically can remember the generation along with its last
+ * result and skip the re-dump when the generation has not changed.
+ *
+ * \note The counter may wrap; compare generations only for equality.
+ *
+ * \return Current channel cache generation.
+ */
+int ast_channel_cache_generation(void);
+
 /*!
  * \since 12
  * \brief Message type for \ref ast_channel_snapshot_update.
@@ -60,6 +60,26 @@ struct stasis_message_type *ast_network_change_type(void);
  */
 struct stasis_message_type *ast_system_registry_type(void);
 
+/*!
+ * \brief A \ref stasis_message_type for task processor queue wait overload alerts.
+ *
+ * \note Messages of this type should always be issued on and expected from
+ *       the \ref ast_system_topic \ref stasis topic
+ */
+struct stasis_message_type *ast_taskprocessor_overload_type(void);
+
+/*!
+ * \brief Publish a \ref ast_taskprocessor_overload_type message
+ *
+ * \param name The name of the overloaded task processor
+ * \param subsystem The subsystem the task processor belongs to
+ * \param p99_wait_ms The measured p99 queue wait in milliseconds
+ * \param threshold_ms The configured alert level in milliseconds
+ * \param queue_size The queue depth when the alert fired
+ */
+void ast_system_publish_taskprocessor_overload(const char *name, const char *subsystem,
+	long p99_wait_ms, long threshold_ms, long queue_size);
+
 /*!
  * \brief A \ref stasis_message_type for CCSS Available messages.
  * \since 12
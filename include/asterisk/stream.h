@@ -698,6 +698,37 @@ struct ast_stream_topology *ast_stream_topology_clone(
 int ast_stream_topology_equal(const struct ast_stream_topology *left,
 	const struct ast_stream_topology *right);
 
+/*!
+ * \brief Compute a hash of a single stream
+ *
+ * \param stream The media stream
+ *
+ * \return A hash covering the type, state, name, and formats of the stream
+ *
+ * \note Streams whose negotiated properties are identical hash to the same
+ * value, so callers can detect that a stream is unchanged between
+ * renegotiations without retaining a clone for comparison.
+ *
+ * \since 18
+ */
+unsigned int ast_stream_hash(const struct ast_stream *stream);
+
+/*!
+ * \brief Compute an order-sensitive hash of a stream topology
+ *
+ * \param topology The topology of streams
+ *
+ * \return A hash covering the type, state, name, and formats of each stream
+ *
+ * \note Topologies which compare equal with ast_stream_topology_equal hash
+ * to the same value, so callers can cache the hash of the last negotiated
+ * topology and skip renegotiation entirely when a new topology matches it,
+ * without retaining a clone for comparison.
+ *
+ * \since 18
+ */
+unsigned int ast_stream_topology_hash(const struct ast_stream_topology *topology);
+
 /*!
  * \brief Unreference and destroy a stream topology
  *
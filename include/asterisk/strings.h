@@ -909,6 +909,36 @@ struct ast_str *__ast_str_thread_get(struct ast_threadstorage *ts,
 #define ast_str_thread_get(ts, init_len) __ast_str_thread_get(ts, init_len, __FILE__, __PRETTY_FUNCTION__, __LINE__)
 #endif /* defined(DEBUG_THREADLOCALS) */
 
+/*!
+ * \brief Retrieve a scratch dynamic string from the per-thread scratch pool
+ *
+ * \param init_len Initial space to allocate if no pooled buffer is available
+ *
+ * Unlike ast_str_thread_get(), which dedicates one buffer to a single use
+ * site, the scratch pool is shared by every use site on the thread and
+ * supports nested or recursive acquisition.  Released buffers keep their
+ * grown size, so hot paths converge on a few appropriately sized buffers
+ * instead of repeatedly growing fresh allocations.
+ *
+ * \note The returned buffer must be released with ast_str_scratch_release()
+ * and must not be held across a return to the caller.
+ *
+ * \return A dynamic string with no contents
+ * \retval NULL on error
+ */
+struct ast_str *ast_str_scratch_get(size_t init_len);
+
+/*!
+ * \brief Release a scratch string back to the per-thread scratch pool
+ *
+ * \param buf Address of the pointer returned by ast_str_scratch_get(),
+ * which is set to NULL
+ *
+ * The buffer is retained for reuse by the thread if the pool has room,
+ * otherwise it is freed.  Passing a NULL string is allowed.
+ */
+void ast_str_scratch_release(struct ast_str **buf);
+
 /*!
  * \brief Error codes from __ast_str_helper()
  * The underlying processing to manipulate dynamic string is done
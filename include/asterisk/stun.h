@@ -91,6 +91,23 @@ struct stun_attr;
  */
 int ast_stun_request(int s, struct sockaddr_in *dst, const char *username, struct sockaddr_in *answer);
 
+/*!
+ * \brief Send a STUN binding indication.
+ *
+ * \param s The socket used to send the indication.
+ * \param dst The address of the STUN server.
+ *
+ * \details
+ * A binding indication (RFC 5389) elicits no response from the server,
+ * so this is a single cheap send with no retries and no waiting.  Its
+ * only purpose is to refresh the NAT binding of the socket, which makes
+ * it suitable for keeping many idle sockets alive from one thread.
+ *
+ * \retval 0 on success.
+ * \retval -1 on error.
+ */
+int ast_stun_send_indication(int s, struct sockaddr_in *dst);
+
 /*! \brief callback type to be invoked on stun responses. */
 typedef int (stun_cb_f)(struct stun_attr *attr, void *arg);
 
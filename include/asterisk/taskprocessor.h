@@ -340,6 +340,26 @@ const char *ast_taskprocessor_name(struct ast_taskprocessor *tps);
  */
 long ast_taskprocessor_size(struct ast_taskprocessor *tps);
 
+/*!
+ * \brief Return a decaying average of queue wait time in milliseconds
+ *
+ * This is how long recently executed tasks sat in the queue before a
+ * thread picked them up.  It is a smoothed value, suitable for making
+ * scaling decisions without reacting to a single slow task.
+ */
+long ast_taskprocessor_avg_wait_ms(struct ast_taskprocessor *tps);
+
+/*!
+ * \brief Return how long the oldest queued task has been waiting, in milliseconds
+ *
+ * Unlike ast_taskprocessor_avg_wait_ms(), this reflects the task at the
+ * head of the queue right now, so it rises even when no tasks are being
+ * completed at all.
+ *
+ * \retval 0 if the queue is empty.
+ */
+long ast_taskprocessor_oldest_wait_ms(struct ast_taskprocessor *tps);
+
 /*!
  * \brief Get the current taskprocessor high water alert count.
  * \since 13.10.0
@@ -375,4 +395,20 @@ unsigned int ast_taskprocessor_get_subsystem_alert(const char *subsystem);
  */
 int ast_taskprocessor_alert_set_levels(struct ast_taskprocessor *tps, long low_water, long high_water);
 
+/*!
+ * \brief Set the p99 queue wait alert level of the given taskprocessor.
+ *
+ * An alert is raised, and a \ref ast_taskprocessor_overload_type message is
+ * published, when the p99 queue wait of the taskprocessor's most recent
+ * measurement window exceeds \a wait_ms.  The alert clears when the p99
+ * wait drops back to 90% of the level.
+ *
+ * \param tps Taskprocessor to update.
+ * \param wait_ms New alert level in milliseconds. (0 to disable)
+ *
+ * \retval 0 on success.
+ * \retval -1 on error (level not changed).
+ */
+int ast_taskprocessor_alert_set_wait_level(struct ast_taskprocessor *tps, long wait_ms);
+
 #endif /* __AST_TASKPROCESSOR_H__ */
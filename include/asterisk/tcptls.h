@@ -140,6 +140,15 @@ struct ast_tcptls_session_args {
 	void *(*accept_fn)(void *); /*!< the function in charge of doing the accept */
 	void (*periodic_fn)(void *);/*!< something we may want to run before after select on the accept socket */
 	void *(*worker_fn)(void *); /*!< the function in charge of doing the actual work */
+	/*!
+	 * Optional hook to run an accepted session on caller managed threads
+	 * (e.g. a threadpool) instead of spawning a dedicated thread for it.
+	 * The hook must arrange for ast_tcptls_server_process() to be called
+	 * with the session, taking over the session reference.  Return
+	 * non-zero to decline; the accept thread then falls back to spawning
+	 * a dedicated thread.
+	 */
+	int (*dispatch_fn)(void *);
 	const char *name;
 	struct ast_tls_config *old_tls_cfg; /*!< copy of the SSL configuration to determine whether changes have been made */
 };
@@ -196,6 +205,21 @@ struct ast_tcptls_session_instance *ast_tcptls_client_create(struct ast_tcptls_s
 
 void *ast_tcptls_server_root(void *);
 
+/*!
+ * \brief Run an accepted TCP/TLS session to completion.
+ *
+ * Performs the (potentially expensive) TLS negotiation and then runs the
+ * session's worker_fn.  This is the body of the threads spawned by
+ * ast_tcptls_server_root() and is public so that dispatch_fn hooks can run
+ * sessions on their own threads.
+ *
+ * \note Consumes the reference to the session instance.
+ *
+ * \param data The ast_tcptls_session_instance to run
+ * \return The result of the session's worker_fn, or NULL on setup failure.
+ */
+void *ast_tcptls_server_process(void *data);
+
 /*!
  * \brief Closes a tcptls session instance's file and/or file descriptor.
  * The tcptls_session will be set to NULL and it's file descriptor will be set to -1
@@ -325,14 +325,97 @@ void ast_translator_free_path(struct ast_trans_pvt *tr);
  * determines whether the original frame should be freed.  In case the frame type is
  * AST_FRAME_RTCP, the frame is not translated but passed to the translator codecs
  * via the feedback callback, and a pointer to ast_null_frame is returned after that.
+ *
+ * \a f may also be a frame_list chain of contiguous media frames; every frame in
+ * the chain is applied to each translation step before its output is collected,
+ * so a batch of N queued frames is transcoded with a single pass over the path
+ * and a single output drain per step instead of N.  Timing is predicted from the
+ * head frame, so only chain frames without delivery or timing info should be
+ * batched.  With consume set the entire input chain is freed.
+ *
  * \param path tr translator structure to use for translation
- * \param f frame to translate
+ * \param f frame (or frame_list chain) to translate
  * \param consume Whether or not to free the original frame
- * \return an ast_frame of the new translation format on success
+ * \return an ast_frame (possibly a frame_list chain) of the new translation format on success
  * \retval NULL on failure
  */
 struct ast_frame *ast_translate(struct ast_trans_pvt *tr, struct ast_frame *f, int consume);
 
+/*!
+ * \brief Byte ring a translator path can deliver its terminal output into.
+ *
+ * \details
+ * Storage is provided by the caller and never reallocated.  The ring
+ * exists so byte stream consumers (speech engines, external media
+ * sinks) can pull translated audio out of a path without an isolated
+ * ast_frame being allocated and copied for every output chunk; the
+ * terminal translator's output buffer is appended straight into the
+ * ring and the consumer reads contiguous segments in place with
+ * ast_trans_ring_peek()/ast_trans_ring_consume().
+ */
+struct ast_trans_ring {
+	/*! Ring storage provided by the caller. */
+	unsigned char *buf;
+	/*! Size of buf in bytes. */
+	size_t size;
+	/*! Offset the next byte is written at. */
+	size_t head;
+	/*! Offset the next byte is read from. */
+	size_t tail;
+	/*! Bytes currently stored. */
+	size_t used;
+	/*! Bytes dropped because the ring was full. */
+	size_t overruns;
+};
+
+/*!
+ * \brief Set up a translator output ring over caller provided storage.
+ *
+ * \param ring Ring to initialize.
+ * \param buf Storage the ring should use.
+ * \param size Size of buf in bytes.
+ */
+void ast_trans_ring_init(struct ast_trans_ring *ring, void *buf, size_t size);
+
+/*!
+ * \brief Peek at the longest contiguous readable segment of a translator output ring.
+ *
+ * \param ring Ring to read from.
+ * \param data Set to the start of the readable segment.
+ *
+ * \return Number of contiguous bytes readable at *data.  (Zero if the ring is empty.)
+ */
+size_t ast_trans_ring_peek(struct ast_trans_ring *ring, unsigned char **data);
+
+/*!
+ * \brief Mark bytes previously peeked from a translator output ring as consumed.
+ *
+ * \param ring Ring the bytes were peeked from.
+ * \param len Number of bytes to consume.  Clamped to the bytes stored.
+ */
+void ast_trans_ring_consume(struct ast_trans_ring *ring, size_t len);
+
+/*!
+ * \brief Translate a frame and append the terminal output to a ring.
+ *
+ * \details
+ * Runs \a f through the path like ast_translate(), but the final
+ * step's output bytes are appended to \a ring instead of being
+ * isolated into a malloc'd frame, removing an allocation and a copy
+ * per frame.  Frame timing metadata is not propagated; the ring is a
+ * continuous byte stream.  Output that does not fit in the ring is
+ * dropped and counted in the ring's overruns member.
+ *
+ * \param path Translator path to run the frame through.
+ * \param f Frame (or frame_list chain) to translate.
+ * \param consume Whether or not to free the original frame.
+ * \param ring Ring to append translated audio to.
+ *
+ * \return Number of bytes appended to the ring (zero if the path is buffering).
+ * \retval -1 on error.
+ */
+int ast_translate_ring(struct ast_trans_pvt *path, struct ast_frame *f, int consume, struct ast_trans_ring *ring);
+
 /*!
  * \brief Returns the number of steps required to convert from 'src' to 'dest'.
  * \param dest destination format
@@ -84,4 +84,28 @@ static inline unsigned char AST_LIN2MU(short sample)
 
 #define AST_MULAW(a) (__ast_mulaw[(a)])
 
+/*!
+ * \brief Convert a block of u-Law samples to signed linear
+ *
+ * Equivalent to applying AST_MULAW() per sample, but may use a SIMD
+ * kernel selected at startup for whole-frame conversion.
+ *
+ * \param dst Destination buffer with room for \a samples entries
+ * \param src u-Law encoded samples
+ * \param samples Number of samples to convert
+ */
+void ast_ulaw_expand_block(short *dst, const unsigned char *src, unsigned int samples);
+
+/*!
+ * \brief Convert a block of signed linear samples to u-Law
+ *
+ * Equivalent to applying AST_LIN2MU() per sample, but may use a SIMD
+ * kernel selected at startup for whole-frame conversion.
+ *
+ * \param dst Destination buffer with room for \a samples bytes
+ * \param src Signed linear samples
+ * \param samples Number of samples to convert
+ */
+void ast_ulaw_compress_block(unsigned char *dst, const short *src, unsigned int samples);
+
 #endif /* _ASTERISK_ULAW_H */
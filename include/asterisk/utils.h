@@ -468,6 +468,25 @@ static force_inline void ast_slinear_saturated_subtract(short *input, short *val
 		*input = (short) res;
 }
 
+/*!
+ * \brief Saturated addition of a block of signed linear samples
+ *
+ * Equivalent to applying ast_slinear_saturated_add() to each sample of
+ * \a input and \a value, but dispatched at runtime to a vectorized
+ * kernel (SSE2/AVX2 on x86-64, NEON on ARM) when the CPU has one.
+ * This is the mixing inner loop of large conferences; use it anywhere
+ * whole buffers are mixed.
+ */
+void ast_slinear_saturated_add_block(short *input, const short *value, unsigned int samples);
+
+/*!
+ * \brief Saturated subtraction of a block of signed linear samples
+ *
+ * Block form of ast_slinear_saturated_subtract(), subtracting \a value
+ * from \a input in place.  See ast_slinear_saturated_add_block().
+ */
+void ast_slinear_saturated_subtract_block(short *input, const short *value, unsigned int samples);
+
 static force_inline void ast_slinear_saturated_multiply(short *input, short *value)
 {
 	int res;
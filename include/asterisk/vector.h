@@ -48,6 +48,31 @@
 		size_t current;			\
 	}
 
+/*!
+ * \brief Define a vector structure with inline storage for small sizes
+ *
+ * The first \a size elements live in a buffer embedded in the structure
+ * itself, so a vector that never outgrows them costs no heap allocation.
+ * Once it does outgrow them, the elements silently move to the heap and
+ * the vector behaves like a plain AST_VECTOR from then on.
+ *
+ * Initialize with AST_VECTOR_SMALL_INIT(), append with
+ * AST_VECTOR_SMALL_APPEND() and clean up with AST_VECTOR_SMALL_FREE().
+ * All of the non-growing macros (AST_VECTOR_GET, AST_VECTOR_SIZE, the
+ * remove and traversal families, etc.) work on it unchanged.
+ *
+ * \param name Optional vector struct name.
+ * \param type Vector element type.
+ * \param size Number of elements stored inline.
+ */
+#define AST_VECTOR_SMALL(name, type, size)	\
+	struct name {				\
+		type *elems;			\
+		size_t max;			\
+		size_t current;			\
+		type inline_elems[size];	\
+	}
+
 /*! \brief Integer vector definition */
 AST_VECTOR(ast_vector_int, int);
 
@@ -123,6 +148,21 @@ int ast_vector_string_split(struct ast_vector_string *dest,
 	(alloc_size == 0 || (vec)->elems != NULL) ? 0 : -1;		\
 })
 
+/*!
+ * \brief Initialize a small vector to use its inline storage
+ *
+ * \param vec Vector to initialize.
+ *
+ * \retval 0 always, for symmetry with AST_VECTOR_INIT.
+ */
+#define AST_VECTOR_SMALL_INIT(vec) ({					\
+	memset((vec)->inline_elems, 0, sizeof((vec)->inline_elems));	\
+	(vec)->elems = (vec)->inline_elems;				\
+	(vec)->max = (sizeof((vec)->inline_elems) / sizeof((vec)->inline_elems[0]));			\
+	(vec)->current = 0;						\
+	0;								\
+})
+
 /*!
  * \brief Steal the elements from a vector and reinitialize.
  *
@@ -178,6 +218,24 @@ int ast_vector_string_split(struct ast_vector_string *dest,
 	(vec)->current = 0;			\
 } while (0)
 
+/*!
+ * \brief Deallocates a small vector's heap storage, if it grew any.
+ *
+ * If any code to free the elements of this vector needs to be run, that
+ * should be done prior to this call.  The vector is left reinitialized
+ * on its inline storage.
+ *
+ * \param vec Small vector to deallocate.
+ */
+#define AST_VECTOR_SMALL_FREE(vec) do {		\
+	if ((void *) (vec)->elems != (void *) (vec)->inline_elems) {	\
+		ast_free((vec)->elems);		\
+	}					\
+	(vec)->elems = (vec)->inline_elems;	\
+	(vec)->max = (sizeof((vec)->inline_elems) / sizeof((vec)->inline_elems[0]));	\
+	(vec)->current = 0;			\
+} while (0)
+
 /*!
  * \brief Deallocates this vector pointer.
  *
@@ -219,8 +277,12 @@ int ast_vector_string_split(struct ast_vector_string *dest,
 
 /*!
  * \internal
+ *
+ * Grow the element storage to cover idx, doubling from the needed size.
+ * \a inline_buf is the vector's embedded buffer for AST_VECTOR_SMALL
+ * (which must never be passed to ast_free()) or NULL for plain vectors.
  */
-#define __make_room(idx, vec) ({ \
+#define __make_room_inline(idx, vec, inline_buf) ({ \
 	int res = 0;								\
 	do {														\
 		if ((idx) >= (vec)->max) {								\
@@ -231,7 +293,9 @@ int ast_vector_string_split(struct ast_vector_string *dest,
 				if ((vec)->elems) {								\
 					memcpy(new_elems, (vec)->elems,				\
 						(vec)->current * sizeof(*new_elems)); 	\
-					ast_free((vec)->elems);						\
+					if ((void *) (vec)->elems != (void *) (inline_buf)) {	\
+						ast_free((vec)->elems);					\
+					}											\
 				}												\
 				(vec)->elems = new_elems;						\
 				(vec)->max = new_max;							\
@@ -244,6 +308,11 @@ int ast_vector_string_split(struct ast_vector_string *dest,
 	res;														\
 })
 
+/*!
+ * \internal
+ */
+#define __make_room(idx, vec) __make_room_inline(idx, vec, NULL)
+
 /*!
  * \brief Append an element to a vector, growing the vector if needed.
  *
@@ -265,6 +334,27 @@ int ast_vector_string_split(struct ast_vector_string *dest,
 	res;													\
 })
 
+/*!
+ * \brief Append an element to a small vector, spilling to the heap if needed.
+ *
+ * \param vec Small vector to append to.
+ * \param elem Element to append.
+ *
+ * \retval 0 on success.
+ * \retval Non-zero on failure.
+ */
+#define AST_VECTOR_SMALL_APPEND(vec, elem) ({				\
+	int res = 0;											\
+	do {													\
+		if (__make_room_inline((vec)->current, vec, (vec)->inline_elems) != 0) {	\
+			res = -1;										\
+			break;											\
+		} 													\
+		(vec)->elems[(vec)->current++] = (elem);			\
+	} while (0);											\
+	res;													\
+})
+
 /*!
  * \brief Replace an element at a specific position in a vector, growing the vector if needed.
  *
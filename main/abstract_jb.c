@@ -46,6 +46,7 @@
 
 #include "asterisk/abstract_jb.h"
 #include "fixedjitterbuf.h"
+#include "ringjitterbuf.h"
 #include "jitterbuf.h"
 
 /*! Internal jb flags */
@@ -82,6 +83,17 @@ static int jb_remove_adaptive(void *jb, struct ast_frame **fout);
 static void jb_force_resynch_adaptive(void *jb);
 static void jb_empty_and_reset_adaptive(void *jb);
 static int jb_is_late_adaptive(void *jb, long ts);
+/* ring */
+static void *jb_create_ring(struct ast_jb_conf *general_config);
+static void jb_destroy_ring(void *jb);
+static int jb_put_first_ring(void *jb, struct ast_frame *fin, long now);
+static int jb_put_ring(void *jb, struct ast_frame *fin, long now);
+static int jb_get_ring(void *jb, struct ast_frame **fout, long now, long interpl);
+static long jb_next_ring(void *jb);
+static int jb_remove_ring(void *jb, struct ast_frame **fout);
+static void jb_force_resynch_ring(void *jb);
+static void jb_empty_and_reset_ring(void *jb);
+static int jb_is_late_ring(void *jb, long ts);
 
 /* Available jb implementations */
 static const struct ast_jb_impl avail_impl[] = {
@@ -112,6 +124,20 @@ static const struct ast_jb_impl avail_impl[] = {
 		.force_resync = jb_force_resynch_adaptive,
 		.empty_and_reset = jb_empty_and_reset_adaptive,
 		.is_late = jb_is_late_adaptive,
+	},
+	{
+		.name = "ring",
+		.type = AST_JB_RING,
+		.create = jb_create_ring,
+		.destroy = jb_destroy_ring,
+		.put_first = jb_put_first_ring,
+		.put = jb_put_ring,
+		.get = jb_get_ring,
+		.next = jb_next_ring,
+		.remove = jb_remove_ring,
+		.force_resync = jb_force_resynch_ring,
+		.empty_and_reset = jb_empty_and_reset_ring,
+		.is_late = jb_is_late_ring,
 	}
 };
 
@@ -122,6 +148,8 @@ static const int fixed_to_abstract_code[] =
 	{AST_JB_IMPL_OK, AST_JB_IMPL_DROP, AST_JB_IMPL_INTERP, AST_JB_IMPL_NOFRAME};
 static const int adaptive_to_abstract_code[] =
 	{AST_JB_IMPL_OK, AST_JB_IMPL_NOFRAME, AST_JB_IMPL_NOFRAME, AST_JB_IMPL_INTERP, AST_JB_IMPL_DROP, AST_JB_IMPL_OK};
+static const int ring_to_abstract_code[] =
+	{AST_JB_IMPL_OK, AST_JB_IMPL_DROP, AST_JB_IMPL_INTERP, AST_JB_IMPL_NOFRAME};
 
 /* JB_GET actions (used only for the frames log) */
 static const char * const jb_get_actions[] = {"Delivered", "Dropped", "Interpolated", "No"};
@@ -317,6 +345,7 @@ int ast_jb_put(struct ast_channel *chan, struct ast_frame *f)
 		now = get_now(jb, NULL);
 		if (jbimpl->put(jbobj, frr, now) != AST_JB_IMPL_OK) {
 			jb_framelog("JB_PUT {now=%ld}: Dropped frame with ts=%ld and len=%ld\n", now, frr->ts, frr->len);
+			ast_channel_drop_account(chan, AST_FRAME_DROP_JITTERBUFFER, 1);
 			ast_frfree(frr);
 			/*return -1;*/
 			/* TODO: Check this fix - should return 0 here, because the dropped frame shouldn't
@@ -378,6 +407,9 @@ static void jb_get_and_deliver(struct ast_channel *chan)
 		case AST_JB_IMPL_DROP:
 			jb_framelog("\tJB_GET {now=%ld}: %s frame with ts=%ld and len=%ld\n",
 				now, jb_get_actions[res], f->ts, f->len);
+			if (res == AST_JB_IMPL_DROP) {
+				ast_channel_drop_account(chan, AST_FRAME_DROP_JITTERBUFFER, 1);
+			}
 			ao2_replace(jb->last_format, f->subclass.format);
 			ast_frfree(f);
 			break;
@@ -434,6 +466,7 @@ static int create_jb(struct ast_channel *chan, struct ast_frame *frr)
 	   some implementations (i.e. adaptive's when resynch_threshold is specified) to drop it. */
 	if (res != AST_JB_IMPL_OK) {
 		ast_log(LOG_WARNING, "Failed to put first frame in the jitterbuffer on channel '%s'\n", ast_channel_name(chan));
+		ast_channel_drop_account(chan, AST_FRAME_DROP_JITTERBUFFER, 1);
 		/*
 		jbimpl->destroy(jbobj);
 		return -1;
@@ -833,6 +866,114 @@ static int jb_is_late_adaptive(void *jb, long ts)
 	return jb_is_late(jb, ts);
 }
 
+/* ring */
+
+/*! Frame sequence number to hand the ring, or -1 when the frame has none */
+static int jb_frame_seqno(struct ast_frame *fin)
+{
+	return ast_test_flag(fin, AST_FRFLAG_HAS_SEQUENCE_NUMBER) ? fin->seqno : -1;
+}
+
+static void *jb_create_ring(struct ast_jb_conf *general_config)
+{
+	struct ring_jb_conf conf;
+
+	conf.jbsize = general_config->max_size;
+	conf.resync_threshold = general_config->resync_threshold;
+
+	return ring_jb_new(&conf);
+}
+
+static void jb_destroy_ring(void *jb)
+{
+	struct ring_jb *ringjb = (struct ring_jb *) jb;
+
+	/* Ensure the ring jb is empty - otherwise it will raise an ASSERT */
+	jb_empty_and_reset_ring(jb);
+
+	/* destroy the jb */
+	ring_jb_destroy(ringjb);
+}
+
+
+static int jb_put_first_ring(void *jb, struct ast_frame *fin, long now)
+{
+	struct ring_jb *ringjb = (struct ring_jb *) jb;
+	int res;
+
+	res = ring_jb_put_first(ringjb, fin, fin->len, fin->ts, now, jb_frame_seqno(fin));
+
+	return ring_to_abstract_code[res];
+}
+
+
+static int jb_put_ring(void *jb, struct ast_frame *fin, long now)
+{
+	struct ring_jb *ringjb = (struct ring_jb *) jb;
+	int res;
+
+	res = ring_jb_put(ringjb, fin, fin->len, fin->ts, now, jb_frame_seqno(fin));
+
+	return ring_to_abstract_code[res];
+}
+
+
+static int jb_get_ring(void *jb, struct ast_frame **fout, long now, long interpl)
+{
+	struct ring_jb *ringjb = (struct ring_jb *) jb;
+	struct ring_jb_frame frame = { .data = &ast_null_frame };
+	int res;
+
+	res = ring_jb_get(ringjb, &frame, now, interpl);
+	*fout = frame.data;
+
+	return ring_to_abstract_code[res];
+}
+
+
+static long jb_next_ring(void *jb)
+{
+	struct ring_jb *ringjb = (struct ring_jb *) jb;
+
+	return ring_jb_next(ringjb);
+}
+
+
+static int jb_remove_ring(void *jb, struct ast_frame **fout)
+{
+	struct ring_jb *ringjb = (struct ring_jb *) jb;
+	struct ring_jb_frame frame;
+	int res;
+
+	res = ring_jb_remove(ringjb, &frame);
+	*fout = frame.data;
+
+	return ring_to_abstract_code[res];
+}
+
+
+static void jb_force_resynch_ring(void *jb)
+{
+	struct ring_jb *ringjb = (struct ring_jb *) jb;
+
+	ring_jb_set_force_resynch(ringjb);
+}
+
+static void jb_empty_and_reset_ring(void *jb)
+{
+	struct ring_jb *ringjb = jb;
+	struct ring_jb_frame f;
+
+	while (ring_jb_remove(ringjb, &f) == RING_JB_OK) {
+		ast_frfree(f.data);
+	}
+}
+
+static int jb_is_late_ring(void *jb, long ts)
+{
+	return ring_jb_is_late(jb, ts);
+}
+
 #define DEFAULT_TIMER_INTERVAL 20
 #define DEFAULT_SIZE  200
 #define DEFAULT_TARGET_EXTRA  40
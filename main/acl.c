@@ -241,6 +241,7 @@ struct ast_acl_list *ast_free_acl_list(struct ast_acl_list *acl_list)
 	AST_LIST_LOCK(acl_list);
 	while ((current = AST_LIST_REMOVE_HEAD(acl_list, list))) {
 		ast_free_ha(current->acl);
+		ast_ha_index_free(current->index);
 		ast_free(current);
 	}
 	AST_LIST_UNLOCK(acl_list);
@@ -342,6 +343,7 @@ struct ast_acl_list *ast_duplicate_acl_list(struct ast_acl_list *original)
 
 		/* Copy data from original ACL to clone ACL */
 		current_clone->acl = ast_duplicate_ha_list(current_cursor->acl);
+		current_clone->index = ast_ha_index_compile(current_clone->acl);
 
 		current_clone->is_invalid = current_cursor->is_invalid;
 		current_clone->is_realtime = current_cursor->is_realtime;
@@ -479,6 +481,10 @@ void ast_append_acl(const char *sense, const char *stuff, struct ast_acl_list **
 		/* With the proper ACL set for modification, we can just pass this off to the ast_ha append function. */
 		acl->acl = ast_append_ha(sense, stuff, acl->acl, error);
 
+		/* Recompile the binary-search index to match the modified rule list. */
+		ast_ha_index_free(acl->index);
+		acl->index = ast_ha_index_compile(acl->acl);
+
 		AST_LIST_UNLOCK(working_list);
 		return;
 	}
@@ -525,6 +531,7 @@ void ast_append_acl(const char *sense, const char *stuff, struct ast_acl_list **
 
 		/* Set the ACL's ast_ha to the duplicated named ACL retrieved above. */
 		acl->acl = named_ha;
+		acl->index = ast_ha_index_compile(named_ha);
 
 		/* Raise the named_acl_flag since we are adding a named ACL to the ACL container. */
 		if (named_acl_flag) {
@@ -779,7 +786,13 @@ static enum ast_acl_sense ast_apply_acl_internal(struct ast_acl_list *acl_list,
 		}
 
 		if (acl->acl) {
-			if (ast_apply_ha(acl->acl, addr) == AST_SENSE_DENY) {
+			/* Prefer the compiled index when one could be built; lists with
+			 * rules it cannot represent fall back to the linear walk. */
+			enum ast_acl_sense sense = acl->index
+				? ast_ha_index_apply(acl->index, addr)
+				: ast_apply_ha(acl->acl, addr);
+
+			if (sense == AST_SENSE_DENY) {
 				if (log_prefix) {
 					ast_log(LOG_NOTICE, "%sRejecting '%s' due to a failure to pass ACL '%s'\n",
 							log_prefix, ast_sockaddr_stringify_addr(addr),
@@ -873,6 +886,381 @@ enum ast_acl_sense ast_apply_ha(const struct ast_ha *ha, const struct ast_sockad
 	return res;
 }
 
+/*! Addresses are compared as 16 byte big endian keys. IPv4 rules and
+ * IPv6 rules live in separate key spaces, with IPv4 addresses occupying
+ * the low four bytes of their keys. */
+#define HA_INDEX_KEY_SIZE 16
+
+/*! \brief One disjoint address range and the sense that wins within it */
+struct ha_index_segment {
+	unsigned char lo[HA_INDEX_KEY_SIZE];
+	unsigned char hi[HA_INDEX_KEY_SIZE];
+	enum ast_acl_sense sense;
+};
+
+struct ast_ha_index {
+	/*! Sorted, disjoint ranges covering the IPv4 rules */
+	struct ha_index_segment *v4;
+	/*! Sorted, disjoint ranges covering the IPv6 rules */
+	struct ha_index_segment *v6;
+	size_t v4_count;
+	size_t v6_count;
+};
+
+/*! \brief A single rule extracted for compilation */
+struct ha_index_rule {
+	unsigned char lo[HA_INDEX_KEY_SIZE];
+	unsigned char hi[HA_INDEX_KEY_SIZE];
+	/*! Position in the original list; later rules win overlaps */
+	int order;
+	enum ast_acl_sense sense;
+};
+
+/*! \brief A range still open during the flattening sweep */
+struct ha_index_sweep_entry {
+	unsigned char hi[HA_INDEX_KEY_SIZE];
+	/*! First key of the range not yet emitted or covered by a nested rule */
+	unsigned char next[HA_INDEX_KEY_SIZE];
+	/*! Set when next has wrapped past the end of the key space */
+	int exhausted;
+	/*! Winning rule position for the parts no nested rule covers */
+	int order;
+	/*! Winning sense for the parts no nested rule covers */
+	enum ast_acl_sense sense;
+};
+
+static int ha_index_key_cmp(const unsigned char *a, const unsigned char *b)
+{
+	return memcmp(a, b, HA_INDEX_KEY_SIZE);
+}
+
+/*! \brief Increment a key in place, returning non-zero if it wrapped around */
+static int ha_index_key_inc(unsigned char *key)
+{
+	int i;
+
+	for (i = HA_INDEX_KEY_SIZE - 1; i >= 0; i--) {
+		if (++key[i]) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void ha_index_key_dec(unsigned char *key)
+{
+	int i;
+
+	for (i = HA_INDEX_KEY_SIZE - 1; i >= 0; i--) {
+		if (key[i]--) {
+			return;
+		}
+	}
+}
+
+/*!
+ * \internal
+ * \brief Extract the address range a single rule covers
+ *
+ * \retval 4 or 6 The address family of the rule
+ * \retval -1 The rule cannot be represented as a plain address range
+ *            (it carries a port or a non-contiguous netmask)
+ */
+static int ha_index_extract_rule(const struct ast_ha *ha, struct ha_index_rule *rule)
+{
+	const unsigned char *addr_bytes;
+	const unsigned char *mask_bytes;
+	size_t len;
+	size_t offset;
+	size_t i;
+	int seen_hole = 0;
+	int family;
+
+	if (ast_sockaddr_port(&ha->addr)) {
+		/* Rules from ast_append_ha_with_port() also match on the port,
+		 * which a pure address range cannot express. */
+		return -1;
+	}
+
+	if (ast_sockaddr_is_ipv4(&ha->addr) && ast_sockaddr_is_ipv4(&ha->netmask)) {
+		addr_bytes = (const unsigned char *) &((const struct sockaddr_in *) &ha->addr.ss)->sin_addr;
+		mask_bytes = (const unsigned char *) &((const struct sockaddr_in *) &ha->netmask.ss)->sin_addr;
+		len = 4;
+		family = 4;
+	} else if (ast_sockaddr_is_ipv6(&ha->addr) && ast_sockaddr_is_ipv6(&ha->netmask)) {
+		addr_bytes = (const unsigned char *) &((const struct sockaddr_in6 *) &ha->addr.ss)->sin6_addr;
+		mask_bytes = (const unsigned char *) &((const struct sockaddr_in6 *) &ha->netmask.ss)->sin6_addr;
+		len = 16;
+		family = 6;
+	} else {
+		return -1;
+	}
+
+	memset(rule->lo, 0, sizeof(rule->lo));
+	memset(rule->hi, 0, sizeof(rule->hi));
+	offset = HA_INDEX_KEY_SIZE - len;
+
+	for (i = 0; i < len; i++) {
+		unsigned char mask = mask_bytes[i];
+
+		if (seen_hole && mask) {
+			/* One bits below a zero bit: not a CIDR prefix */
+			return -1;
+		}
+		if (mask != 0xff) {
+			/* A partial byte must be a contiguous run of one bits
+			 * from the top */
+			if (mask && (unsigned char) (mask | (mask - 1)) != 0xff) {
+				return -1;
+			}
+			seen_hole = 1;
+		}
+		rule->lo[offset + i] = addr_bytes[i] & mask;
+		rule->hi[offset + i] = addr_bytes[i] | (unsigned char) ~mask;
+	}
+
+	rule->sense = ha->sense;
+
+	return family;
+}
+
+static int ha_index_rule_cmp(const void *a, const void *b)
+{
+	const struct ha_index_rule *left = a;
+	const struct ha_index_rule *right = b;
+	int cmp;
+
+	cmp = ha_index_key_cmp(left->lo, right->lo);
+	if (cmp) {
+		return cmp;
+	}
+
+	/* Wider ranges sort first so enclosing rules precede the rules they nest */
+	cmp = ha_index_key_cmp(right->hi, left->hi);
+	if (cmp) {
+		return cmp;
+	}
+
+	return left->order - right->order;
+}
+
+/*!
+ * \internal
+ * \brief Flatten sorted rules into disjoint, sorted segments
+ *
+ * CIDR ranges are either disjoint or fully nested, so a single sweep with a
+ * stack of the currently enclosing rules suffices.  Whenever part of a rule's
+ * range is not covered by a nested rule, a segment is emitted carrying the
+ * sense of the latest rule (in original list order) enclosing that part,
+ * which is exactly the verdict the last-match walk of ast_apply_ha() gives.
+ *
+ * \note stack must have room for count entries and segments for 2 * count.
+ *
+ * \return The number of segments emitted
+ */
+static size_t ha_index_flatten(const struct ha_index_rule *rules, size_t count,
+	struct ha_index_sweep_entry *stack, struct ha_index_segment *segments)
+{
+	size_t seg_count = 0;
+	size_t depth = 0;
+	size_t i;
+
+	for (i = 0; i <= count; i++) {
+		/* Close every range the next rule (or the end of input) lies beyond */
+		while (depth
+			&& (i == count || ha_index_key_cmp(rules[i].lo, stack[depth - 1].hi) > 0)) {
+			struct ha_index_sweep_entry *entry = &stack[depth - 1];
+
+			if (!entry->exhausted && ha_index_key_cmp(entry->next, entry->hi) <= 0) {
+				memcpy(segments[seg_count].lo, entry->next, HA_INDEX_KEY_SIZE);
+				memcpy(segments[seg_count].hi, entry->hi, HA_INDEX_KEY_SIZE);
+				segments[seg_count].sense = entry->sense;
+				seg_count++;
+			}
+
+			depth--;
+			if (depth) {
+				struct ha_index_sweep_entry *parent = &stack[depth - 1];
+
+				memcpy(parent->next, entry->hi, HA_INDEX_KEY_SIZE);
+				parent->exhausted = ha_index_key_inc(parent->next);
+			}
+		}
+
+		if (i == count) {
+			break;
+		}
+
+		if (depth) {
+			struct ha_index_sweep_entry *parent = &stack[depth - 1];
+
+			if (!parent->exhausted && ha_index_key_cmp(parent->next, rules[i].lo) < 0) {
+				/* Emit the enclosing rule's uncovered gap before this rule */
+				memcpy(segments[seg_count].lo, parent->next, HA_INDEX_KEY_SIZE);
+				memcpy(segments[seg_count].hi, rules[i].lo, HA_INDEX_KEY_SIZE);
+				ha_index_key_dec(segments[seg_count].hi);
+				segments[seg_count].sense = parent->sense;
+				seg_count++;
+			}
+		}
+
+		memcpy(stack[depth].hi, rules[i].hi, HA_INDEX_KEY_SIZE);
+		memcpy(stack[depth].next, rules[i].lo, HA_INDEX_KEY_SIZE);
+		stack[depth].exhausted = 0;
+		if (depth && stack[depth - 1].order > rules[i].order) {
+			/* An enclosing rule appears later in the list and wins here */
+			stack[depth].order = stack[depth - 1].order;
+			stack[depth].sense = stack[depth - 1].sense;
+		} else {
+			stack[depth].order = rules[i].order;
+			stack[depth].sense = rules[i].sense;
+		}
+		depth++;
+	}
+
+	return seg_count;
+}
+
+struct ast_ha_index *ast_ha_index_compile(const struct ast_ha *ha)
+{
+	struct ast_ha_index *index = NULL;
+	struct ha_index_rule *v4_rules = NULL;
+	struct ha_index_rule *v6_rules = NULL;
+	struct ha_index_sweep_entry *stack = NULL;
+	const struct ast_ha *current;
+	size_t count = 0;
+	size_t v4_count = 0;
+	size_t v6_count = 0;
+	int order = 0;
+
+	for (current = ha; current; current = current->next) {
+		count++;
+	}
+
+	if (!count) {
+		return NULL;
+	}
+
+	v4_rules = ast_malloc(count * sizeof(*v4_rules));
+	v6_rules = ast_malloc(count * sizeof(*v6_rules));
+	stack = ast_malloc(count * sizeof(*stack));
+	index = ast_calloc(1, sizeof(*index));
+	if (!v4_rules || !v6_rules || !stack || !index) {
+		goto cleanup;
+	}
+
+	for (current = ha; current; current = current->next) {
+		struct ha_index_rule rule;
+		int family = ha_index_extract_rule(current, &rule);
+
+		rule.order = order++;
+		if (family == 4) {
+			v4_rules[v4_count++] = rule;
+		} else if (family == 6) {
+			v6_rules[v6_count++] = rule;
+		} else {
+			/* A rule the index cannot represent; the caller keeps the
+			 * linear walk for the whole list. */
+			goto cleanup;
+		}
+	}
+
+	if (v4_count) {
+		qsort(v4_rules, v4_count, sizeof(*v4_rules), ha_index_rule_cmp);
+		index->v4 = ast_malloc(2 * v4_count * sizeof(*index->v4));
+		if (!index->v4) {
+			goto cleanup;
+		}
+		index->v4_count = ha_index_flatten(v4_rules, v4_count, stack, index->v4);
+	}
+
+	if (v6_count) {
+		qsort(v6_rules, v6_count, sizeof(*v6_rules), ha_index_rule_cmp);
+		index->v6 = ast_malloc(2 * v6_count * sizeof(*index->v6));
+		if (!index->v6) {
+			goto cleanup;
+		}
+		index->v6_count = ha_index_flatten(v6_rules, v6_count, stack, index->v6);
+	}
+
+	ast_free(v4_rules);
+	ast_free(v6_rules);
+	ast_free(stack);
+
+	return index;
+
+cleanup:
+	ast_free(v4_rules);
+	ast_free(v6_rules);
+	ast_free(stack);
+	ast_ha_index_free(index);
+
+	return NULL;
+}
+
+void ast_ha_index_free(struct ast_ha_index *index)
+{
+	if (!index) {
+		return;
+	}
+
+	ast_free(index->v4);
+	ast_free(index->v6);
+	ast_free(index);
+}
+
+enum ast_acl_sense ast_ha_index_apply(const struct ast_ha_index *index, const struct ast_sockaddr *addr)
+{
+	unsigned char key[HA_INDEX_KEY_SIZE] = { 0, };
+	struct ast_sockaddr mapped_addr;
+	const struct ast_sockaddr *addr_to_use = addr;
+	const struct ha_index_segment *segments;
+	size_t count;
+	size_t low;
+	size_t high;
+
+	if (ast_sockaddr_is_ipv6(addr) && ast_sockaddr_is_ipv4_mapped(addr)) {
+		/* IPv4 rules apply to IPv4-mapped addresses, just as in ast_apply_ha() */
+		if (!ast_sockaddr_ipv4_mapped(addr, &mapped_addr)) {
+			ast_log(LOG_ERROR, "%s provided to ast_sockaddr_ipv4_mapped could not be converted. That shouldn't be possible.\n",
+				ast_sockaddr_stringify(addr));
+			return AST_SENSE_ALLOW;
+		}
+		addr_to_use = &mapped_addr;
+	}
+
+	if (ast_sockaddr_is_ipv4(addr_to_use)) {
+		memcpy(key + HA_INDEX_KEY_SIZE - 4,
+			&((const struct sockaddr_in *) &addr_to_use->ss)->sin_addr, 4);
+		segments = index->v4;
+		count = index->v4_count;
+	} else if (ast_sockaddr_is_ipv6(addr_to_use)) {
+		memcpy(key, &((const struct sockaddr_in6 *) &addr_to_use->ss)->sin6_addr, 16);
+		segments = index->v6;
+		count = index->v6_count;
+	} else {
+		return AST_SENSE_ALLOW;
+	}
+
+	low = 0;
+	high = count;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+
+		if (ha_index_key_cmp(key, segments[mid].lo) < 0) {
+			high = mid;
+		} else if (ha_index_key_cmp(key, segments[mid].hi) > 0) {
+			low = mid + 1;
+		} else {
+			return segments[mid].sense;
+		}
+	}
+
+	/* No rule covers the address; start optimistic, like ast_apply_ha() */
+	return AST_SENSE_ALLOW;
+}
+
 static int resolve_first(struct ast_sockaddr *addr, const char *name, int flag,
 			 int family)
 {
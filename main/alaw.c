@@ -149,6 +149,181 @@ unsigned char __ast_lin2a[AST_ALAW_TAB_SIZE];
 #endif
 short __ast_alaw[256];
 
+/*!
+ * \name Block conversion kernels
+ *
+ * Whole-frame A-Law conversion, mirroring the u-Law kernels in ulaw.c.
+ * The C versions walk the lookup tables; on x86-64 an SSSE3 kernel
+ * computes the transform arithmetically, eight samples at a time.  The
+ * SIMD kernels are only selected after being verified bit-exact against
+ * the tables over the full input domain, so table variants
+ * (G711_NEW_ALGORITHM) safely fall back to C.
+ *
+ * @{
+ */
+
+static void alaw_expand_block_c(short *dst, const unsigned char *src, unsigned int samples)
+{
+	while (samples--) {
+		*dst++ = AST_ALAW(*src++);
+	}
+}
+
+static void alaw_compress_block_c(unsigned char *dst, const short *src, unsigned int samples)
+{
+	while (samples--) {
+		*dst++ = AST_LIN2A(*src++);
+	}
+}
+
+#if defined(__x86_64__)
+/* mm_malloc.h, pulled in by immintrin.h, calls malloc() and free() directly,
+ * which astmm.h rejects.  Restore the real functions around the include. */
+#pragma push_macro("malloc")
+#pragma push_macro("free")
+#undef malloc
+#undef free
+#include <immintrin.h>
+#pragma pop_macro("free")
+#pragma pop_macro("malloc")
+
+static __attribute__((target("ssse3"))) void alaw_expand_block_ssse3(short *dst, const unsigned char *src, unsigned int samples)
+{
+	/* (1 << (seg - 1)) with segment 0 mapping to 1, selected with pshufb */
+	const __m128i pow2 = _mm_setr_epi8(1, 1, 2, 4, 8, 16, 32, 64,
+		0, 0, 0, 0, 0, 0, 0, 0);
+	/* Setting the high byte of each pshufb index to 0x80 zeroes the
+	 * high byte of the looked up 16 bit multiplier. */
+	const __m128i hi_zero = _mm_set1_epi16((short) 0x8000);
+	unsigned int i = 0;
+
+	for (; i + 8 <= samples; i += 8) {
+		__m128i a = _mm_xor_si128(_mm_unpacklo_epi8(
+			_mm_loadl_epi64((const __m128i *) (src + i)), _mm_setzero_si128()),
+			_mm_set1_epi16(AST_ALAW_AMI_MASK));
+		/* t = ((a & 0x0F) << 4) + 8; seg = (a >> 4) & 7;
+		 * y = (t + (seg ? 0x100 : 0)) << (seg ? seg - 1 : 0),
+		 * negated when the (inverted) sign bit is clear. */
+		__m128i seg = _mm_and_si128(_mm_srli_epi16(a, 4), _mm_set1_epi16(7));
+		__m128i t = _mm_add_epi16(
+			_mm_slli_epi16(_mm_and_si128(a, _mm_set1_epi16(0x0F)), 4),
+			_mm_set1_epi16(8));
+		__m128i has_seg = _mm_cmpgt_epi16(seg, _mm_setzero_si128());
+		__m128i mult = _mm_shuffle_epi8(pow2, _mm_or_si128(seg, hi_zero));
+		__m128i y = _mm_mullo_epi16(
+			_mm_add_epi16(t, _mm_and_si128(has_seg, _mm_set1_epi16(0x100))),
+			mult);
+		__m128i neg = _mm_cmpeq_epi16(_mm_and_si128(a, _mm_set1_epi16(0x80)),
+			_mm_setzero_si128());
+
+		y = _mm_sub_epi16(_mm_xor_si128(y, neg), neg);
+		_mm_storeu_si128((__m128i *) (dst + i), y);
+	}
+	alaw_expand_block_c(dst + i, src + i, samples - i);
+}
+
+static __attribute__((target("ssse3"))) void alaw_compress_block_ssse3(unsigned char *dst, const short *src, unsigned int samples)
+{
+	/* 2^(16 - shift) with shift = seg ? seg + 3 : 4, split into low/high
+	 * bytes and selected by segment; multiplying with mulhi yields
+	 * mag >> shift. */
+	const __m128i mult_lo = _mm_setr_epi8(0, 0, 0, 0, 0, 0, -128, 64,
+		0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mult_hi = _mm_setr_epi8(16, 16, 8, 4, 2, 1, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i hi_zero = _mm_set1_epi16((short) 0x8000);
+	unsigned int i = 0;
+
+	for (; i + 8 <= samples; i += 8) {
+		/* The table is indexed by (unsigned short) sample >> 3, and each
+		 * eight-sample bucket holds the encoding of its highest member, so
+		 * OR in the low bits to match AST_LIN2A exactly. */
+		__m128i s = _mm_or_si128(
+			_mm_loadu_si128((const __m128i *) (src + i)), _mm_set1_epi16(7));
+		__m128i neg = _mm_srai_epi16(s, 15);
+		__m128i mag = _mm_sub_epi16(_mm_xor_si128(s, neg), neg);
+		__m128i seg = _mm_setzero_si128();
+		__m128i idx, mult, mant, mask, alaw;
+
+		/* seg = how many of the thresholds (256 << k) - 1 the magnitude
+		 * exceeds */
+		seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x00FF)));
+		seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x01FF)));
+		seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x03FF)));
+		seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x07FF)));
+		seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x0FFF)));
+		seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x1FFF)));
+		seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x3FFF)));
+
+		idx = _mm_or_si128(seg, hi_zero);
+		mult = _mm_or_si128(_mm_shuffle_epi8(mult_lo, idx),
+			_mm_slli_epi16(_mm_shuffle_epi8(mult_hi, idx), 8));
+		mant = _mm_and_si128(_mm_mulhi_epu16(mag, mult), _mm_set1_epi16(0x0F));
+
+		mask = _mm_or_si128(_mm_set1_epi16(AST_ALAW_AMI_MASK),
+			_mm_andnot_si128(neg, _mm_set1_epi16(0x80)));
+		alaw = _mm_xor_si128(_mm_or_si128(_mm_slli_epi16(seg, 4), mant), mask);
+		_mm_storel_epi64((__m128i *) (dst + i), _mm_packus_epi16(alaw, alaw));
+	}
+	alaw_compress_block_c(dst + i, src + i, samples - i);
+}
+
+/*!
+ * \internal
+ * \brief Verify the SIMD kernels against the tables over every input.
+ *
+ * \retval non-zero when bit-exact, zero when the kernels must not be used
+ */
+static int alaw_simd_kernels_match(void)
+{
+	unsigned char codes[256];
+	unsigned char back[256];
+	short lin[256];
+	int i;
+	int block;
+
+	for (i = 0; i < 256; i++) {
+		codes[i] = i;
+	}
+	alaw_expand_block_ssse3(lin, codes, 256);
+	for (i = 0; i < 256; i++) {
+		if (lin[i] != AST_ALAW(i)) {
+			return 0;
+		}
+	}
+
+	for (block = -32768; block < 32768; block += 256) {
+		for (i = 0; i < 256; i++) {
+			lin[i] = block + i;
+		}
+		alaw_compress_block_ssse3(back, lin, 256);
+		for (i = 0; i < 256; i++) {
+			if (back[i] != AST_LIN2A((short) (block + i))) {
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+#endif /* __x86_64__ */
+
+/*! Selected in ast_alaw_init(). */
+static void (*alaw_expand_block_impl)(short *, const unsigned char *, unsigned int) = alaw_expand_block_c;
+static void (*alaw_compress_block_impl)(unsigned char *, const short *, unsigned int) = alaw_compress_block_c;
+
+void ast_alaw_expand_block(short *dst, const unsigned char *src, unsigned int samples)
+{
+	alaw_expand_block_impl(dst, src, samples);
+}
+
+void ast_alaw_compress_block(unsigned char *dst, const short *src, unsigned int samples)
+{
+	alaw_compress_block_impl(dst, src, samples);
+}
+
+/*! @} */
+
 void ast_alaw_init(void)
 {
 	int i;
@@ -211,4 +386,10 @@ void ast_alaw_init(void)
 	ast_log(LOG_NOTICE, "a-Law tandem transcoding test complete.\n");
 #endif /* TEST_TANDEM_TRANSCODING */
 
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("ssse3") && alaw_simd_kernels_match()) {
+		alaw_expand_block_impl = alaw_expand_block_ssse3;
+		alaw_compress_block_impl = alaw_compress_block_ssse3;
+	}
+#endif
 }
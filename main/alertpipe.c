@@ -131,6 +131,47 @@ ssize_t ast_alertpipe_write(int alert_pipe[2])
 	return write(alert_pipe[1], &tmp, sizeof(tmp)) != sizeof(tmp);
 }
 
+ssize_t ast_alertpipe_write_count(int alert_pipe[2], size_t count)
+{
+	if (!ast_alertpipe_writable(alert_pipe)) {
+		errno = EBADF;
+		return 0;
+	}
+
+	if (!count) {
+		return 0;
+	}
+
+#ifdef HAVE_EVENTFD
+
+	if (alert_pipe[0] == alert_pipe[1]) {
+		/* A single write adds 'count' to the eventfd's counter.  With
+		 * EFD_SEMAPHORE each subsequent read still consumes one event,
+		 * so the coalesced write is invisible to readers. */
+		uint64_t tmp = count;
+
+		errno = EPIPE;
+		return write(alert_pipe[1], &tmp, sizeof(tmp)) != sizeof(tmp);
+	}
+
+#endif
+
+	/* Pipe backend: one event per write, but batch them through a
+	 * stack buffer so a burst is signaled in a few syscalls. */
+	while (count) {
+		uint64_t tmp[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+		size_t chunk = MIN(count, ARRAY_LEN(tmp));
+
+		errno = EPIPE;
+		if (write(alert_pipe[1], tmp, chunk * sizeof(tmp[0])) != (ssize_t) (chunk * sizeof(tmp[0]))) {
+			return 1;
+		}
+		count -= chunk;
+	}
+
+	return 0;
+}
+
 ast_alert_status_t ast_alertpipe_flush(int alert_pipe[2])
 {
 	int bytes_read;
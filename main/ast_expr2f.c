@@ -556,6 +556,7 @@ static yyconst flex_int16_t yy_chk[159] =
 #ifndef STANDALONE
 #include "asterisk/strings.h"
 #include "asterisk/channel.h"
+#include "asterisk/threadstorage.h"
 #endif
 
 /* Conditionally redefine the macro from flex 2.5.35, in case someone uses flex <2.5.35 to regenerate this file. */
@@ -2402,18 +2403,81 @@ void ast_yyfree(void *ptr, yyscan_t yyscanner)
 	free( (char *) ptr );
 }
 
+#ifndef STANDALONE
+static void expr_scanner_cleanup(void *data)
+{
+	yyscan_t *scanner = data;
+
+	if (*scanner) {
+		ast_yylex_destroy(*scanner);
+	}
+	ast_free(data);
+}
+
+AST_THREADSTORAGE_CUSTOM(expr_scanner_storage, NULL, expr_scanner_cleanup);
+
+/*!
+ * \internal
+ * \brief Get this thread's reusable expression scanner, creating it on first use.
+ */
+static yyscan_t expr_scanner_get(void)
+{
+	yyscan_t *scanner = ast_threadstorage_get(&expr_scanner_storage, sizeof(*scanner));
+
+	if (!scanner) {
+		return NULL;
+	}
+	if (!*scanner && ast_yylex_init(scanner)) {
+		*scanner = NULL;
+		return NULL;
+	}
+	return *scanner;
+}
+#endif /* !STANDALONE */
+
+/*!
+ * \internal
+ * \brief Attach a scanner to \a io for one evaluation.
+ *
+ * Creating and destroying a scanner for every evaluated expression is
+ * measurable on expression heavy dialplans, so the thread's scanner is
+ * reused when available.
+ *
+ * \retval non-zero if the scanner is the reusable per-thread one.
+ */
+static int expr_scanner_start(struct parse_io *io)
+{
+#ifndef STANDALONE
+	io->scanner = expr_scanner_get();
+	if (io->scanner) {
+		struct yyguts_t *yyg = (struct yyguts_t *) io->scanner;
+
+		/* A prior parse error may have left the scanner mid-token. */
+		BEGIN(INITIAL);
+		return 1;
+	}
+#endif
+	ast_yylex_init(&io->scanner);
+	return 0;
+}
+
 int ast_expr(char *expr, char *buf, int length, struct ast_channel *chan)
 {
 	struct parse_io io = { .string = expr, .chan = chan };
 	int return_value = 0;
+	int scanner_reused;
+	YY_BUFFER_STATE buffer;
 
-	ast_yylex_init(&io.scanner);
+	scanner_reused = expr_scanner_start(&io);
 
-	ast_yy_scan_string(expr, io.scanner);
+	buffer = ast_yy_scan_string(expr, io.scanner);
 
 	ast_yyparse ((void *) &io);
 
-	ast_yylex_destroy(io.scanner);
+	ast_yy_delete_buffer(buffer, io.scanner);
+	if (!scanner_reused) {
+		ast_yylex_destroy(io.scanner);
+	}
 
 	if (!io.val) {
 		if (length > 1) {
@@ -2447,11 +2511,16 @@ int ast_expr(char *expr, char *buf, int length, struct ast_channel *chan)
 int ast_str_expr(struct ast_str **str, ssize_t maxlen, struct ast_channel *chan, char *expr)
 {
 	struct parse_io io = { .string = expr, .chan = chan };
+	int scanner_reused;
+	YY_BUFFER_STATE buffer;
 
-	ast_yylex_init(&io.scanner);
-	ast_yy_scan_string(expr, io.scanner);
+	scanner_reused = expr_scanner_start(&io);
+	buffer = ast_yy_scan_string(expr, io.scanner);
 	ast_yyparse ((void *) &io);
-	ast_yylex_destroy(io.scanner);
+	ast_yy_delete_buffer(buffer, io.scanner);
+	if (!scanner_reused) {
+		ast_yylex_destroy(io.scanner);
+	}
 
 	if (!io.val) {
 		ast_str_set(str, maxlen, "0");
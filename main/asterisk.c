@@ -381,6 +381,207 @@ static shutdown_nice_t shuttingdown = NOT_SHUTTING_DOWN;
 static int shutdown_pending;
 
 static int restartnow;
+
+/*!
+ * \brief A file descriptor registered to survive a restart exec.
+ *
+ * A full restart normally forces every endpoint to re-register and
+ * rebinds every socket.  Modules can instead register the descriptors
+ * they want the next instance to adopt with ast_restart_preserve_fd().
+ * When the restart exec happens those descriptors have close-on-exec
+ * cleared and their names and numbers are handed to the new binary in
+ * the ASTERISK_WARM_FDS environment variable, where the new instance's
+ * modules reclaim them with ast_restart_preserved_fd().  Descriptors
+ * nobody claims are closed once startup completes.
+ */
+struct preserved_fd {
+	int fd;
+	AST_LIST_ENTRY(preserved_fd) list;
+	char name[0];
+};
+
+/*! \brief Descriptors registered for handoff to the next instance. */
+static AST_LIST_HEAD_STATIC(restart_preserve_fds, preserved_fd);
+
+/*! \brief Descriptors inherited from the previous instance and not yet claimed. */
+static AST_LIST_HEAD_STATIC(restart_inherited_fds, preserved_fd);
+
+/*! \brief Environment variable naming the descriptors handed across the exec. */
+#define RESTART_PRESERVE_ENV "ASTERISK_WARM_FDS"
+
+static struct preserved_fd *preserved_fd_alloc(const char *name, int fd)
+{
+	struct preserved_fd *pfd;
+
+	pfd = ast_calloc(1, sizeof(*pfd) + strlen(name) + 1);
+	if (!pfd) {
+		return NULL;
+	}
+	pfd->fd = fd;
+	strcpy(pfd->name, name); /* Safe */
+
+	return pfd;
+}
+
+int ast_restart_preserve_fd(const char *name, int fd)
+{
+	struct preserved_fd *pfd;
+	struct preserved_fd *cur;
+
+	if (ast_strlen_zero(name) || fd < 0 || strchr(name, ':') || strchr(name, ',')) {
+		return -1;
+	}
+
+	pfd = preserved_fd_alloc(name, fd);
+	if (!pfd) {
+		return -1;
+	}
+
+	AST_LIST_LOCK(&restart_preserve_fds);
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&restart_preserve_fds, cur, list) {
+		if (!strcmp(cur->name, name)) {
+			AST_LIST_REMOVE_CURRENT(list);
+			ast_free(cur);
+			break;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+	AST_LIST_INSERT_TAIL(&restart_preserve_fds, pfd, list);
+	AST_LIST_UNLOCK(&restart_preserve_fds);
+
+	return 0;
+}
+
+void ast_restart_preserve_remove(const char *name)
+{
+	struct preserved_fd *cur;
+
+	AST_LIST_LOCK(&restart_preserve_fds);
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&restart_preserve_fds, cur, list) {
+		if (!strcmp(cur->name, name)) {
+			AST_LIST_REMOVE_CURRENT(list);
+			ast_free(cur);
+			break;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+	AST_LIST_UNLOCK(&restart_preserve_fds);
+}
+
+int ast_restart_preserved_fd(const char *name)
+{
+	struct preserved_fd *cur;
+	int fd = -1;
+
+	AST_LIST_LOCK(&restart_inherited_fds);
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&restart_inherited_fds, cur, list) {
+		if (!strcmp(cur->name, name)) {
+			AST_LIST_REMOVE_CURRENT(list);
+			fd = cur->fd;
+			ast_free(cur);
+			break;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+	AST_LIST_UNLOCK(&restart_inherited_fds);
+
+	return fd;
+}
+
+/*!
+ * \internal
+ * \brief Hand the registered descriptors to the binary we are about to exec.
+ *
+ * Must run after the restart path has marked descriptors close-on-exec;
+ * this clears the flag again on just the registered ones.
+ */
+static void restart_preserve_export(void)
+{
+	struct preserved_fd *cur;
+	struct ast_str *buf;
+
+	buf = ast_str_create(128);
+	if (!buf) {
+		return;
+	}
+
+	AST_LIST_LOCK(&restart_preserve_fds);
+	AST_LIST_TRAVERSE(&restart_preserve_fds, cur, list) {
+		if (fcntl(cur->fd, F_SETFD, 0)) {
+			continue;
+		}
+		ast_str_append(&buf, 0, "%s%s:%d",
+			ast_str_strlen(buf) ? "," : "", cur->name, cur->fd);
+	}
+	AST_LIST_UNLOCK(&restart_preserve_fds);
+
+	if (ast_str_strlen(buf)) {
+		setenv(RESTART_PRESERVE_ENV, ast_str_buffer(buf), 1);
+	}
+	ast_free(buf);
+}
+
+/*!
+ * \internal
+ * \brief Collect descriptors handed to us by the instance that exec'ed us.
+ */
+static void restart_preserve_recover(void)
+{
+	char *tokens;
+	char *token;
+	const char *env = getenv(RESTART_PRESERVE_ENV);
+
+	if (!env) {
+		return;
+	}
+
+	tokens = ast_strdupa(env);
+	while ((token = strsep(&tokens, ","))) {
+		struct preserved_fd *pfd;
+		char *fdstr;
+		int fd;
+
+		fdstr = strchr(token, ':');
+		if (!fdstr) {
+			continue;
+		}
+		*fdstr++ = '\0';
+		if (sscanf(fdstr, "%30d", &fd) != 1 || fd < 0
+			|| fcntl(fd, F_GETFD) < 0) {
+			continue;
+		}
+
+		/* Restore close-on-exec; a second restart re-exports explicitly. */
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+		pfd = preserved_fd_alloc(token, fd);
+		if (!pfd) {
+			close(fd);
+			continue;
+		}
+		AST_LIST_INSERT_TAIL(&restart_inherited_fds, pfd, list);
+	}
+	unsetenv(RESTART_PRESERVE_ENV);
+}
+
+/*!
+ * \internal
+ * \brief Close inherited descriptors that no module claimed during startup.
+ */
+static void restart_preserve_flush_unclaimed(void)
+{
+	struct preserved_fd *cur;
+
+	AST_LIST_LOCK(&restart_inherited_fds);
+	while ((cur = AST_LIST_REMOVE_HEAD(&restart_inherited_fds, list))) {
+		ast_log(LOG_NOTICE, "Closing preserved descriptor '%s' (%d): nothing claimed it\n",
+			cur->name, cur->fd);
+		close(cur->fd);
+		ast_free(cur);
+	}
+	AST_LIST_UNLOCK(&restart_inherited_fds);
+}
+
 static pthread_t consolethread = AST_PTHREADT_NULL;
 static pthread_t mon_sig_flags;
 static int canary_pid = 0;
@@ -2108,6 +2309,8 @@ static void really_quit(int num, shutdown_nice_t niceness, int restart)
 		for (i = 3; i < 32768; i++) {
 			fcntl(i, F_SETFD, FD_CLOEXEC);
 		}
+		/* Except the ones registered to survive into the new instance. */
+		restart_preserve_export();
 		ast_verb(0, "Asterisk is now restarting...\n");
 		restartnow = 1;
 
@@ -4063,6 +4266,9 @@ static void asterisk_daemon(int isroot, const char *runuser, const char *rungrou
 
 	load_astmm_phase_1();
 
+	/* Adopt any descriptors a restarting instance handed across the exec. */
+	restart_preserve_recover();
+
 	/* Check whether high prio was succesfully set by us or some
 	 * other incantation. */
 	if (has_priority()) {
@@ -4210,6 +4416,8 @@ static void asterisk_daemon(int isroot, const char *runuser, const char *rungrou
 	ast_autoservice_init();
 
 	check_init(ast_timing_init(), "Timing");
+	check_init(ast_latency_trace_init(), "Latency Tracing");
+	check_init(ast_lock_contention_init(), "Lock Contention Profiling");
 	check_init(ast_ssl_init(), "SSL");
 	read_pjproject_startup_options();
 	check_init(ast_pj_init(), "Embedded PJProject");
@@ -4279,6 +4487,8 @@ static void asterisk_daemon(int isroot, const char *runuser, const char *rungrou
 
 	ast_verb(0, COLORIZE_FMT "\n", COLORIZE(COLOR_BRGREEN, 0, "Asterisk Ready."));
 
+	restart_preserve_flush_unclaimed();
+
 	logger_queue_start();
 
 	if (ast_opt_console) {
@@ -70,6 +70,306 @@
 #define MALLOC_FAILURE_MSG \
 	ast_log_safe(LOG_ERROR, "Memory Allocation Failure in function %s at line %d of %s\n", func, lineno, file)
 
+#if !defined(STANDALONE) && !defined(STANDALONE2)
+#define __AST_MEMPROF
+#endif
+
+#if defined(__AST_MEMPROF)
+
+#include "asterisk/cli.h"
+#include "asterisk/lock.h"
+
+/*! Number of allocations between samples. */
+#define MEMPROF_INTERVAL	1024
+
+/*! Number of call site slots in the sample table. */
+#define MEMPROF_SITES_MAX	509
+
+/*! Number of slots probed before a sample is dropped. */
+#define MEMPROF_MAX_PROBES	16
+
+/*! Number of power-of-four histogram buckets: <=16, <=64, ..., <=16k, larger. */
+#define MEMPROF_HIST_BUCKETS	7
+
+enum memprof_site_state {
+	/*! Slot has never been used. */
+	MEMPROF_SITE_EMPTY = 0,
+	/*! A thread is filling in the call site keys. */
+	MEMPROF_SITE_CLAIMED,
+	/*! Keys are published and counters may be charged. */
+	MEMPROF_SITE_READY,
+};
+
+struct memprof_site {
+	/*! Claim/publish state of the slot.  See memprof_record(). */
+	volatile int state;
+	/*!
+	 * \brief Allocation site file name.
+	 *
+	 * \note Compared by pointer identity.  The file/func strings are
+	 * compile time literals so every sample from a given call site
+	 * passes the same pointer.  Equal strings with different
+	 * addresses merely produce separate rows.
+	 */
+	const char *file;
+	const char *func;
+	unsigned int lineno;
+	/*! Number of sampled allocations charged to the site. */
+	volatile int count;
+	/*! Total bytes in the sampled allocations. */
+	size_t len;
+	/*! Sampled allocation counts by size bucket. */
+	volatile int hist[MEMPROF_HIST_BUCKETS];
+};
+
+/*! Fixed table of sampled allocation call sites. */
+static struct memprof_site memprof_sites[MEMPROF_SITES_MAX];
+
+/*! Nonzero when allocation sampling is active. */
+static volatile int memprof_enabled;
+
+/*! Allocations remaining until the next sample is taken. */
+static volatile int memprof_countdown;
+
+/*! Samples dropped because the site table was full. */
+static volatile int memprof_dropped;
+
+/*!
+ * \internal
+ * \brief Charge a sampled allocation to its call site.
+ *
+ * \note Runs inside the allocator so it must not allocate and must
+ * not block.  The site table is maintained lock free: an empty slot
+ * is claimed by atomically exchanging its state, the keys are filled
+ * in, and only then is the slot published as ready.  Concurrent
+ * samplers that catch a slot mid-publish simply probe onward; at
+ * worst a rare sample lands in a duplicate row or is dropped, which
+ * does not matter to a sampling profiler.
+ */
+static void memprof_record(size_t size, const char *file, int lineno, const char *func)
+{
+	int bucket = 0;
+	size_t edge = 16;
+	int probe;
+	int state;
+	struct memprof_site *site;
+	unsigned int idx;
+
+	while (bucket < MEMPROF_HIST_BUCKETS - 1 && edge < size) {
+		edge <<= 2;
+		++bucket;
+	}
+
+	idx = ((unsigned int) (((unsigned long) file) >> 4) + lineno) % ARRAY_LEN(memprof_sites);
+	for (probe = 0; probe < MEMPROF_MAX_PROBES; ++probe) {
+		site = &memprof_sites[(idx + probe) % ARRAY_LEN(memprof_sites)];
+		state = ast_atomic_load_n(&site->state, __ATOMIC_ACQUIRE);
+		if (state == MEMPROF_SITE_EMPTY) {
+			state = ast_atomic_exchange_n(&site->state, MEMPROF_SITE_CLAIMED, __ATOMIC_ACQ_REL);
+			if (state == MEMPROF_SITE_EMPTY) {
+				/* We own the slot.  Publish the keys. */
+				site->file = file;
+				site->func = func;
+				site->lineno = lineno;
+				ast_atomic_store_n(&site->state, MEMPROF_SITE_READY, __ATOMIC_RELEASE);
+			} else if (state == MEMPROF_SITE_READY) {
+				/*
+				 * We grabbed a slot another thread had already published.
+				 * Put it back and examine it like any other occupied slot.
+				 */
+				ast_atomic_store_n(&site->state, MEMPROF_SITE_READY, __ATOMIC_RELEASE);
+			} else {
+				/* The claimer is still publishing.  Treat as a miss. */
+				continue;
+			}
+		} else if (state != MEMPROF_SITE_READY) {
+			continue;
+		}
+		if (site->file != file || site->lineno != (unsigned int) lineno) {
+			continue;
+		}
+		ast_atomic_fetchadd_int(&site->count, 1);
+		ast_atomic_fetch_add(&site->len, size, __ATOMIC_RELAXED);
+		ast_atomic_fetchadd_int(&site->hist[bucket], 1);
+		return;
+	}
+	ast_atomic_fetchadd_int(&memprof_dropped, 1);
+}
+
+/*!
+ * \internal
+ * \brief Take one allocation sample when the countdown expires.
+ *
+ * \note Exactly one thread sees the countdown hit zero for each
+ * sample period and restores it, so the steady state cost of an
+ * unsampled allocation is a single atomic decrement.
+ */
+static void memprof_sample_take(size_t size, const char *file, int lineno, const char *func)
+{
+	if (ast_atomic_fetchadd_int(&memprof_countdown, -1) != 1) {
+		return;
+	}
+	ast_atomic_fetchadd_int(&memprof_countdown, MEMPROF_INTERVAL);
+	memprof_record(size, file, lineno, func);
+}
+
+/*!
+ * \brief Sample an allocation if the profiler is enabled.
+ *
+ * \note A macro so the size expression (e.g. a strlen()) is only
+ * evaluated when sampling is active.
+ */
+#define memprof_sample(size, file, lineno, func)				\
+	do {														\
+		if (memprof_enabled) {									\
+			memprof_sample_take((size), (file), (lineno), (func)); \
+		}														\
+	} while (0)
+
+static char *handle_memory_profiler(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "memory profiler {on|off}";
+		e->usage =
+			"Usage: memory profiler {on|off}\n"
+			"       Enable sampling one in 1024 allocations into per-call-site\n"
+			"       size histograms.  Enabling clears previously collected\n"
+			"       samples.  Sampling is cheap enough to leave on in\n"
+			"       production.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != 3) {
+		return CLI_SHOWUSAGE;
+	}
+
+	if (ast_true(a->argv[2])) {
+		/*
+		 * Disable sampling before clearing.  A sampler still in flight
+		 * can at worst smear one slot's counters, which a sampling
+		 * profiler can live with.
+		 */
+		memprof_enabled = 0;
+		memset((void *) memprof_sites, 0, sizeof(memprof_sites));
+		memprof_dropped = 0;
+		memprof_countdown = MEMPROF_INTERVAL;
+		ast_atomic_thread_fence(__ATOMIC_SEQ_CST);
+		memprof_enabled = 1;
+	} else if (ast_false(a->argv[2])) {
+		memprof_enabled = 0;
+	} else {
+		return CLI_SHOWUSAGE;
+	}
+
+	ast_cli(a->fd, "The memory profiler is: %s\n", memprof_enabled ? "On" : "Off");
+
+	return CLI_SUCCESS;
+}
+
+static char *handle_memory_show_sampled(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	struct memprof_site *sorted[MEMPROF_SITES_MAX];
+	unsigned int idx;
+	unsigned int pos;
+	unsigned int used = 0;
+	unsigned long long total_len = 0;
+	unsigned int total_count = 0;
+	int bucket;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "memory show sampled allocations";
+		e->usage =
+			"Usage: memory show sampled allocations\n"
+			"       Dumps the call sites seen by the sampling allocation\n"
+			"       profiler, largest sampled byte volume first, with a\n"
+			"       size histogram per call site.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != 4) {
+		return CLI_SHOWUSAGE;
+	}
+
+	/* Insertion sort the ready sites by sampled bytes descending. */
+	for (idx = 0; idx < ARRAY_LEN(memprof_sites); ++idx) {
+		struct memprof_site *site = &memprof_sites[idx];
+
+		if (ast_atomic_load_n(&site->state, __ATOMIC_ACQUIRE) != MEMPROF_SITE_READY
+			|| !site->file) {
+			continue;
+		}
+		for (pos = used; pos; --pos) {
+			if (sorted[pos - 1]->len >= site->len) {
+				break;
+			}
+			sorted[pos] = sorted[pos - 1];
+		}
+		sorted[pos] = site;
+		++used;
+	}
+
+	ast_cli(a->fd, "%12s %8s %6s %6s %6s %6s %6s %6s %6s  %s\n",
+		"bytes", "samples", "<=16", "<=64", "<=256", "<=1k", "<=4k", "<=16k", ">16k",
+		"call site");
+	for (idx = 0; idx < used; ++idx) {
+		struct memprof_site *site = sorted[idx];
+
+		ast_cli(a->fd, "%12llu %8u", (unsigned long long) site->len, (unsigned int) site->count);
+		for (bucket = 0; bucket < MEMPROF_HIST_BUCKETS; ++bucket) {
+			ast_cli(a->fd, " %6u", (unsigned int) site->hist[bucket]);
+		}
+		ast_cli(a->fd, "  %s() line %u of %s\n", site->func, site->lineno, site->file);
+
+		total_len += site->len;
+		total_count += site->count;
+	}
+
+	ast_cli(a->fd, "\n%llu bytes in %u sampled allocations (~%llu allocations) at %u call sites\n",
+		total_len, total_count,
+		(unsigned long long) total_count * MEMPROF_INTERVAL, used);
+	if (memprof_dropped) {
+		ast_cli(a->fd, "%u samples dropped because the call site table was full\n",
+			(unsigned int) memprof_dropped);
+	}
+	ast_cli(a->fd, "The memory profiler is: %s\n", memprof_enabled ? "On" : "Off");
+
+	return CLI_SUCCESS;
+}
+
+static struct ast_cli_entry cli_memprof[] = {
+	AST_CLI_DEFINE(handle_memory_profiler, "Enable the sampling allocation profiler"),
+	AST_CLI_DEFINE(handle_memory_show_sampled, "Display sampled allocation call sites"),
+};
+
+/*!
+ * \internal
+ */
+static void memprof_cli_shutdown(void)
+{
+	ast_cli_unregister_multiple(cli_memprof, ARRAY_LEN(cli_memprof));
+}
+
+/*!
+ * \internal
+ */
+static void memprof_cli_init(void)
+{
+	ast_cli_register_multiple(cli_memprof, ARRAY_LEN(cli_memprof));
+	ast_register_cleanup(memprof_cli_shutdown);
+}
+
+#else	/* !defined(__AST_MEMPROF) */
+
+#define memprof_sample(size, file, lineno, func)
+
+#endif	/* defined(__AST_MEMPROF) */
+
 #if defined(__AST_DEBUG_MALLOC)
 
 #include "asterisk/paths.h"	/* use ast_config_AST_LOG_DIR */
@@ -1518,6 +1818,8 @@ void load_astmm_phase_2(void)
 	}
 
 	ast_register_cleanup(mm_atexit_ast);
+
+	memprof_cli_init();
 }
 
 #else	/* !defined(__AST_DEBUG_MALLOC) */
@@ -1528,6 +1830,9 @@ void load_astmm_phase_1(void)
 
 void load_astmm_phase_2(void)
 {
+#if defined(__AST_MEMPROF)
+	memprof_cli_init();
+#endif
 }
 
 void *__ast_repl_calloc(size_t nmemb, size_t size, const char *file, int lineno, const char *func)
@@ -1607,6 +1912,8 @@ void *__ast_calloc(size_t nmemb, size_t size, const char *file, int lineno, cons
 	p = __ast_repl_calloc(nmemb, size, file, lineno, func);
 	if (!p) {
 		MALLOC_FAILURE_MSG;
+	} else {
+		memprof_sample(nmemb * size, file, lineno, func);
 	}
 
 	return p;
@@ -1619,6 +1926,8 @@ void *__ast_calloc_cache(size_t nmemb, size_t size, const char *file, int lineno
 	p = __ast_repl_calloc_cache(nmemb, size, file, lineno, func);
 	if (!p) {
 		MALLOC_FAILURE_MSG;
+	} else {
+		memprof_sample(nmemb * size, file, lineno, func);
 	}
 
 	return p;
@@ -1632,6 +1941,8 @@ void *__ast_malloc(size_t size, const char *file, int lineno, const char *func)
 	p = __ast_repl_malloc(size, file, lineno, func);
 	if (!p) {
 		MALLOC_FAILURE_MSG;
+	} else {
+		memprof_sample(size, file, lineno, func);
 	}
 
 	return p;
@@ -1644,6 +1955,8 @@ void *__ast_realloc(void *ptr, size_t size, const char *file, int lineno, const
 	newp = __ast_repl_realloc(ptr, size, file, lineno, func);
 	if (!newp) {
 		MALLOC_FAILURE_MSG;
+	} else {
+		memprof_sample(size, file, lineno, func);
 	}
 
 	return newp;
@@ -1657,6 +1970,8 @@ char *__ast_strdup(const char *s, const char *file, int lineno, const char *func
 		newstr = __ast_repl_strdup(s, file, lineno, func);
 		if (!newstr) {
 			MALLOC_FAILURE_MSG;
+		} else {
+			memprof_sample(strlen(newstr) + 1, file, lineno, func);
 		}
 	}
 
@@ -1671,6 +1986,8 @@ char *__ast_strndup(const char *s, size_t n, const char *file, int lineno, const
 		newstr = __ast_repl_strndup(s, n, file, lineno, func);
 		if (!newstr) {
 			MALLOC_FAILURE_MSG;
+		} else {
+			memprof_sample(strlen(newstr) + 1, file, lineno, func);
 		}
 	}
 
@@ -1692,6 +2009,8 @@ int __ast_asprintf(const char *file, int lineno, const char *func, char **strp,
 		*strp = NULL;
 
 		MALLOC_FAILURE_MSG;
+	} else {
+		memprof_sample(res + 1, file, lineno, func);
 	}
 	va_end(ap);
 
@@ -1711,6 +2030,8 @@ int __ast_vasprintf(char **strp, const char *format, va_list ap, const char *fil
 		*strp = NULL;
 
 		MALLOC_FAILURE_MSG;
+	} else {
+		memprof_sample(res + 1, file, lineno, func);
 	}
 
 	return res;
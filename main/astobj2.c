@@ -50,15 +50,12 @@ static FILE *ref_log;
  * The refcount is used to decide when it is time to
  * invoke the destructor.
  * The magic number is used for consistency check.
+ *
+ * This is the complete header of a compact object.  Full objects are
+ * additionally preceded by \ref __priv_data_full.
  */
 struct __priv_data {
 	ao2_destructor_fn destructor_fn;
-	/*! This field is used for astobj2 and ao2_weakproxy objects to reference each other */
-	void *weakptr;
-#if defined(AO2_DEBUG)
-	/*! User data size for stats */
-	size_t data_size;
-#endif
 	/*! Number of references held for this object */
 	int32_t ref_counter;
 	/*!
@@ -93,12 +90,29 @@ struct __priv_data {
 	uint32_t magic:28;
 };
 
+/*!
+ * Header fields that compact objects do without, placed immediately
+ * before \ref __priv_data so that the latter always directly precedes
+ * the user data regardless of the object flavor.
+ */
+struct __priv_data_full {
+	/*! This field is used for astobj2 and ao2_weakproxy objects to reference each other */
+	void *weakptr;
+#if defined(AO2_DEBUG)
+	/*! User data size for stats */
+	size_t data_size;
+#endif
+	struct __priv_data priv_data;
+};
+
 #define	AO2_MAGIC	0xa70b123
 #define	AO2_WEAK	0xa70b122
-#define IS_AO2_MAGIC_BAD(p) (AO2_MAGIC != (p->priv_data.magic | 1))
+#define	AO2_COMPACT	0xa70b121
+/* The '| 3' folds all three magic values (0xa70b120 is unused) into one compare. */
+#define IS_AO2_MAGIC_BAD(p) (AO2_MAGIC != (p->priv_data.magic | 3))
 
 /*!
- * What an astobj2 object looks like: fixed-size private data
+ * What a compact astobj2 object looks like: fixed-size private data
  * followed by variable-size user data.
  */
 struct astobj2 {
@@ -106,6 +120,12 @@ struct astobj2 {
 	void *user_data[0];
 };
 
+/* Full AstObj2 with no lock. */
+struct astobj2_nolock {
+	struct __priv_data_full full;
+	void *user_data[0];
+};
+
 struct ao2_weakproxy_notification {
 	ao2_weakproxy_notification_cb cb;
 	void *data;
@@ -119,7 +139,7 @@ struct ao2_lock_priv {
 /* AstObj2 with recursive lock. */
 struct astobj2_lock {
 	struct ao2_lock_priv mutex;
-	struct __priv_data priv_data;
+	struct __priv_data_full full;
 	void *user_data[0];
 };
 
@@ -132,7 +152,7 @@ struct ao2_rwlock_priv {
 /* AstObj2 with RW lock. */
 struct astobj2_rwlock {
 	struct ao2_rwlock_priv rwlock;
-	struct __priv_data priv_data;
+	struct __priv_data_full full;
 	void *user_data[0];
 };
 
@@ -143,7 +163,7 @@ struct ao2_lockobj_priv {
 /* AstObj2 with locking provided by a separate object. */
 struct astobj2_lockobj {
 	struct ao2_lockobj_priv lockobj;
-	struct __priv_data priv_data;
+	struct __priv_data_full full;
 	void *user_data[0];
 };
 
@@ -163,6 +183,15 @@ struct ao2_stats ao2;
 #define INTERNAL_OBJ(user_data) \
 	(struct astobj2 *) ((char *) user_data - sizeof(struct astobj2))
 
+/*!
+ * \brief Get the full header from internal object data.
+ *
+ * \warning Only valid for objects whose magic is not AO2_COMPACT;
+ *          compact objects do not carry these fields at all.
+ */
+#define INTERNAL_OBJ_FULL(iobj) \
+	((struct __priv_data_full *) (((char *) (iobj)) - offsetof(struct __priv_data_full, priv_data)))
+
 /*!
  * \brief convert from a pointer _p to a user-defined object
  *
@@ -507,6 +536,7 @@ int __ao2_ref(void *user_data, int delta,
 	uint32_t privdataoptions;
 	struct ao2_weakproxy *weakproxy = NULL;
 	const char *lock_state;
+	int is_compact;
 
 	if (obj == NULL) {
 		if (ref_log && user_data) {
@@ -522,7 +552,7 @@ int __ao2_ref(void *user_data, int delta,
 		return obj->priv_data.ref_counter;
 	}
 
-	if (delta < 0 && obj->priv_data.magic == AO2_MAGIC && (weakproxy = obj->priv_data.weakptr)) {
+	if (delta < 0 && obj->priv_data.magic == AO2_MAGIC && (weakproxy = INTERNAL_OBJ_FULL(obj)->weakptr)) {
 		ao2_lock(weakproxy);
 	}
 
@@ -544,8 +574,8 @@ int __ao2_ref(void *user_data, int delta,
 			internal_weakproxy = INTERNAL_OBJ_CHECK(weakproxy);
 
 			/* Unlink the obj from the weak proxy */
-			internal_weakproxy->priv_data.weakptr = NULL;
-			obj->priv_data.weakptr = NULL;
+			INTERNAL_OBJ_FULL(internal_weakproxy)->weakptr = NULL;
+			INTERNAL_OBJ_FULL(obj)->weakptr = NULL;
 
 			/* transfer list to local copy so callbacks are run with weakproxy unlocked. */
 			cbs.destroyed_cb = weakproxy->destroyed_cb;
@@ -616,11 +646,12 @@ int __ao2_ref(void *user_data, int delta,
 	}
 
 #ifdef AO2_DEBUG
-	ast_atomic_fetchadd_int(&ao2.total_mem, - obj->priv_data.data_size);
+	ast_atomic_fetchadd_int(&ao2.total_mem, - INTERNAL_OBJ_FULL(obj)->data_size);
 	ast_atomic_fetchadd_int(&ao2.total_objects, -1);
 #endif
 
 	/* In case someone uses an object after it's been freed */
+	is_compact = obj->priv_data.magic == AO2_COMPACT;
 	obj->priv_data.magic = 0;
 	/* Save the options locally so the ref_log print at the end doesn't access freed data */
 	privdataoptions = obj->priv_data.options;
@@ -642,7 +673,9 @@ int __ao2_ref(void *user_data, int delta,
 		break;
 	case AO2_ALLOC_OPT_LOCK_NOLOCK:
 		lock_state = "none";
-		ast_free(obj);
+		/* Compact objects start at the common header; full objects
+		 * start at the full header in front of it. */
+		ast_free(is_compact ? (void *) obj : (void *) INTERNAL_OBJ_FULL(obj));
 		break;
 	case AO2_ALLOC_OPT_LOCK_OBJ:
 		obj_lockobj = INTERNAL_OBJ_LOCKOBJ(user_data);
@@ -688,9 +721,21 @@ static void *internal_ao2_alloc(size_t data_size, ao2_destructor_fn destructor_f
 	struct astobj2 *obj;
 	struct astobj2_lock *obj_mutex;
 	struct astobj2_rwlock *obj_rwlock;
+	struct astobj2_nolock *obj_nolock;
 	struct astobj2_lockobj *obj_lockobj;
 	size_t overhead;
 
+#if defined(AO2_DEBUG)
+	/* Object statistics need the full header. */
+	options &= ~AO2_ALLOC_OPT_COMPACT;
+#endif
+	if ((options & AO2_ALLOC_OPT_COMPACT)
+		&& (options & AO2_ALLOC_OPT_LOCK_MASK) != AO2_ALLOC_OPT_LOCK_NOLOCK) {
+		ast_log(__LOG_ERROR, file, line, func,
+			"AO2_ALLOC_OPT_COMPACT requires AO2_ALLOC_OPT_LOCK_NOLOCK.\n");
+		options &= ~AO2_ALLOC_OPT_COMPACT;
+	}
+
 	switch (options & AO2_ALLOC_OPT_LOCK_MASK) {
 	case AO2_ALLOC_OPT_LOCK_MUTEX:
 		overhead = sizeof(*obj_mutex);
@@ -700,7 +745,7 @@ static void *internal_ao2_alloc(size_t data_size, ao2_destructor_fn destructor_f
 		}
 
 		ast_mutex_init(&obj_mutex->mutex.lock);
-		obj = (struct astobj2 *) &obj_mutex->priv_data;
+		obj = (struct astobj2 *) &obj_mutex->full.priv_data;
 		break;
 	case AO2_ALLOC_OPT_LOCK_RWLOCK:
 		overhead = sizeof(*obj_rwlock);
@@ -710,14 +755,24 @@ static void *internal_ao2_alloc(size_t data_size, ao2_destructor_fn destructor_f
 		}
 
 		ast_rwlock_init(&obj_rwlock->rwlock.lock);
-		obj = (struct astobj2 *) &obj_rwlock->priv_data;
+		obj = (struct astobj2 *) &obj_rwlock->full.priv_data;
 		break;
 	case AO2_ALLOC_OPT_LOCK_NOLOCK:
-		overhead = sizeof(*obj);
-		obj = __ast_calloc(1, overhead + data_size, file, line, func);
-		if (obj == NULL) {
+		if (options & AO2_ALLOC_OPT_COMPACT) {
+			overhead = sizeof(*obj);
+			obj = __ast_calloc(1, overhead + data_size, file, line, func);
+			if (obj == NULL) {
+				return NULL;
+			}
+			break;
+		}
+		overhead = sizeof(*obj_nolock);
+		obj_nolock = __ast_calloc(1, overhead + data_size, file, line, func);
+		if (obj_nolock == NULL) {
 			return NULL;
 		}
+
+		obj = (struct astobj2 *) &obj_nolock->full.priv_data;
 		break;
 	case AO2_ALLOC_OPT_LOCK_OBJ:
 		lockobj = ao2_t_bump(lockobj, "set lockobj");
@@ -734,7 +789,7 @@ static void *internal_ao2_alloc(size_t data_size, ao2_destructor_fn destructor_f
 		}
 
 		obj_lockobj->lockobj.lock = lockobj;
-		obj = (struct astobj2 *) &obj_lockobj->priv_data;
+		obj = (struct astobj2 *) &obj_lockobj->full.priv_data;
 		break;
 	default:
 		/* Invalid option value. */
@@ -746,10 +801,10 @@ static void *internal_ao2_alloc(size_t data_size, ao2_destructor_fn destructor_f
 	obj->priv_data.destructor_fn = destructor_fn;	/* can be NULL */
 	obj->priv_data.ref_counter = 1;
 	obj->priv_data.options = options;
-	obj->priv_data.magic = AO2_MAGIC;
+	obj->priv_data.magic = (options & AO2_ALLOC_OPT_COMPACT) ? AO2_COMPACT : AO2_MAGIC;
 
 #ifdef AO2_DEBUG
-	obj->priv_data.data_size = data_size;
+	INTERNAL_OBJ_FULL(obj)->data_size = data_size;
 	ast_atomic_fetchadd_int(&ao2.total_objects, 1);
 	ast_atomic_fetchadd_int(&ao2.total_mem, data_size);
 	ast_atomic_fetchadd_int(&ao2.total_refs, 1);
@@ -828,8 +883,10 @@ int __ao2_weakproxy_set_object(void *weakproxy, void *obj, int flags,
 	}
 
 	if (!obj_internal
-		|| obj_internal->priv_data.weakptr
-		|| obj_internal->priv_data.magic != AO2_MAGIC) {
+		|| obj_internal->priv_data.magic != AO2_MAGIC
+		|| INTERNAL_OBJ_FULL(obj_internal)->weakptr) {
+		/* Compact objects have nowhere to store the backpointer and
+		 * fail the magic check above. */
 		return -1;
 	}
 
@@ -837,12 +894,12 @@ int __ao2_weakproxy_set_object(void *weakproxy, void *obj, int flags,
 		ao2_lock(weakproxy);
 	}
 
-	if (!weakproxy_internal->priv_data.weakptr) {
+	if (!INTERNAL_OBJ_FULL(weakproxy_internal)->weakptr) {
 		__ao2_ref(obj, +1, tag, file, line, func);
 		__ao2_ref(weakproxy, +1, tag, file, line, func);
 
-		weakproxy_internal->priv_data.weakptr = obj;
-		obj_internal->priv_data.weakptr = weakproxy;
+		INTERNAL_OBJ_FULL(weakproxy_internal)->weakptr = obj;
+		INTERNAL_OBJ_FULL(obj_internal)->weakptr = weakproxy;
 
 		ret = 0;
 	}
@@ -875,8 +932,8 @@ int __ao2_weakproxy_ref_object(void *weakproxy, int delta, int flags,
 		ao2_lock(weakproxy);
 	}
 
-	if (internal->priv_data.weakptr) {
-		ret = __ao2_ref(internal->priv_data.weakptr, delta, tag, file, line, func);
+	if (INTERNAL_OBJ_FULL(internal)->weakptr) {
+		ret = __ao2_ref(INTERNAL_OBJ_FULL(internal)->weakptr, delta, tag, file, line, func);
 	}
 
 	if (!(flags & OBJ_NOLOCK)) {
@@ -902,7 +959,7 @@ void *__ao2_weakproxy_get_object(void *weakproxy, int flags,
 		ao2_lock(weakproxy);
 	}
 
-	obj = internal->priv_data.weakptr;
+	obj = INTERNAL_OBJ_FULL(internal)->weakptr;
 	if (obj) {
 		__ao2_ref(obj, +1, tag, file, line, func);
 	}
@@ -923,12 +980,12 @@ void *__ao2_get_weakproxy(void *obj, const char *tag, const char *file, int line
 		return NULL;
 	}
 
-	if (!obj_internal->priv_data.weakptr) {
+	if (!INTERNAL_OBJ_FULL(obj_internal)->weakptr) {
 		return NULL;
 	}
 
-	__ao2_ref(obj_internal->priv_data.weakptr, +1, tag, file, line, func);
-	return obj_internal->priv_data.weakptr;
+	__ao2_ref(INTERNAL_OBJ_FULL(obj_internal)->weakptr, +1, tag, file, line, func);
+	return INTERNAL_OBJ_FULL(obj_internal)->weakptr;
 }
 
 int ao2_weakproxy_subscribe(void *weakproxy, ao2_weakproxy_notification_cb cb, void *data, int flags)
@@ -945,7 +1002,7 @@ int ao2_weakproxy_subscribe(void *weakproxy, ao2_weakproxy_notification_cb cb, v
 		ao2_lock(weakproxy);
 	}
 
-	hasobj = weakproxy_internal->priv_data.weakptr != NULL;
+	hasobj = INTERNAL_OBJ_FULL(weakproxy_internal)->weakptr != NULL;
 	if (hasobj) {
 		struct ao2_weakproxy *weak = weakproxy;
 		struct ao2_weakproxy_notification *sub = ast_calloc(1, sizeof(*sub));
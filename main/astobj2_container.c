@@ -130,6 +130,11 @@ int __ao2_link(struct ao2_container *self, void *obj_new, int flags,
 		case AO2_CONTAINER_INSERT_NODE_INSERTED:
 			node->is_linked = 1;
 			ast_atomic_fetchadd_int(&self->elements, 1);
+			ast_atomic_fetchadd_int(&self->total_inserts, 1);
+			if (self->peak_elements < self->elements) {
+				/* Updated while holding the container wrlock. */
+				self->peak_elements = self->elements;
+			}
 #if defined(AO2_DEBUG)
 			AO2_DEVMODE_STAT(++self->nodes);
 			if (self->v_table->link_stat) {
@@ -831,6 +836,8 @@ void ao2_container_stats(struct ao2_container *self, enum search_flags flags, co
 		prnt(where, "Container name: %s\n", name);
 	}
 	prnt(where, "Number of objects: %d\n", self->elements);
+	prnt(where, "Peak objects: %d\n", self->peak_elements);
+	prnt(where, "Total inserts: %d\n", self->total_inserts);
 #if defined(AO2_DEBUG)
 	prnt(where, "Number of nodes: %d\n", self->nodes);
 	prnt(where, "Number of empty nodes: %d\n", self->nodes - self->elements);
@@ -879,7 +886,6 @@ int ao2_container_check(struct ao2_container *self, enum search_flags flags)
 	return res;
 }
 
-#if defined(AO2_DEBUG)
 static struct ao2_container *reg_containers;
 
 struct ao2_reg_container {
@@ -887,6 +893,10 @@ struct ao2_reg_container {
 	struct ao2_container *registered;
 	/*! Callback function to print the given object's key. (NULL if not available) */
 	ao2_prnt_obj_fn *prnt_obj;
+	/*! Live object count when the growth report last sampled this container. */
+	int last_count;
+	/*! When the growth report last sampled this container.  Zero if never. */
+	struct timeval last_sample;
 	/*! Name container registered under. */
 	char name[1];
 };
@@ -904,9 +914,7 @@ struct ao2_reg_match {
 	/*! Count of the matches already found. */
 	int count;
 };
-#endif	/* defined(AO2_DEBUG) */
 
-#if defined(AO2_DEBUG)
 static int ao2_reg_sort_cb(const void *obj_left, const void *obj_right, int flags)
 {
 	const struct ao2_reg_container *reg_left = obj_left;
@@ -942,9 +950,7 @@ static int ao2_reg_sort_cb(const void *obj_left, const void *obj_right, int flag
 	}
 	return cmp;
 }
-#endif	/* defined(AO2_DEBUG) */
 
-#if defined(AO2_DEBUG)
 static void ao2_reg_destructor(void *v_doomed)
 {
 	struct ao2_reg_container *doomed = v_doomed;
@@ -953,12 +959,10 @@ static void ao2_reg_destructor(void *v_doomed)
 		ao2_t_ref(doomed->registered, -1, "Releasing registered container.");
 	}
 }
-#endif	/* defined(AO2_DEBUG) */
 
 int ao2_container_register(const char *name, struct ao2_container *self, ao2_prnt_obj_fn *prnt_obj)
 {
 	int res = 0;
-#if defined(AO2_DEBUG)
 	struct ao2_reg_container *reg;
 
 	reg = ao2_t_alloc_options(sizeof(*reg) + strlen(name), ao2_reg_destructor,
@@ -978,16 +982,13 @@ int ao2_container_register(const char *name, struct ao2_container *self, ao2_prn
 	}
 
 	ao2_t_ref(reg, -1, "Done registering container.");
-#endif	/* defined(AO2_DEBUG) */
 	return res;
 }
 
 void ao2_container_unregister(const char *name)
 {
-#if defined(AO2_DEBUG)
 	ao2_t_find(reg_containers, name, OBJ_UNLINK | OBJ_NODATA | OBJ_SEARCH_KEY,
 		"Unregister container");
-#endif	/* defined(AO2_DEBUG) */
 }
 
 #if defined(AO2_DEBUG)
@@ -1001,9 +1002,7 @@ static int ao2_complete_reg_cb(void *obj, void *arg, int flags)
 
 	return 0;
 }
-#endif	/* defined(AO2_DEBUG) */
 
-#if defined(AO2_DEBUG)
 static char *complete_container_names(struct ast_cli_args *a)
 {
 	struct ao2_reg_partial_key partial_key;
@@ -1160,15 +1159,73 @@ static char *handle_cli_astobj2_container_check(struct ast_cli_entry *e, int cmd
 }
 #endif	/* defined(AO2_DEBUG) */
 
-#if defined(AO2_DEBUG)
+/*! \brief Show registered containers and growth accounting - CLI command */
+static char *handle_cli_astobj2_show_containers(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	struct ao2_reg_container *reg;
+	struct ao2_iterator iter;
+	struct timeval now;
+	int total = 0;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "astobj2 show containers";
+		e->usage =
+			"Usage: astobj2 show containers\n"
+			"	Show live object count, peak, total inserts, and growth per\n"
+			"	minute since this command last sampled each registered\n"
+			"	container.  A persistently positive growth rate on a\n"
+			"	container expected to be steady is the signature of an\n"
+			"	object leak.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != e->args) {
+		return CLI_SHOWUSAGE;
+	}
+
+	now = ast_tvnow();
+	ast_cli(a->fd, "%-40s %10s %10s %12s %14s\n",
+		"Container", "Objects", "Peak", "Inserts", "Growth/min");
+	iter = ao2_iterator_init(reg_containers, 0);
+	for (; (reg = ao2_iterator_next(&iter));
+		ao2_t_ref(reg, -1, "Done with iterator entry")) {
+		int count = ao2_container_count(reg->registered);
+		char growth[32] = "-";
+
+		if (!ast_tvzero(reg->last_sample)) {
+			int64_t elapsed_ms = ast_tvdiff_ms(now, reg->last_sample);
+
+			if (elapsed_ms > 0) {
+				snprintf(growth, sizeof(growth), "%+.1f",
+					(count - reg->last_count) * 60000.0 / elapsed_ms);
+			}
+		}
+		reg->last_count = count;
+		reg->last_sample = now;
+
+		ast_cli(a->fd, "%-40s %10d %10d %12d %14s\n", reg->name, count,
+			reg->registered->peak_elements, reg->registered->total_inserts,
+			growth);
+		total++;
+	}
+	ao2_iterator_destroy(&iter);
+	ast_cli(a->fd, "%d registered container%s\n", total, ESS(total));
+
+	return CLI_SUCCESS;
+}
+
 static struct ast_cli_entry cli_astobj2[] = {
+#if defined(AO2_DEBUG)
 	AST_CLI_DEFINE(handle_cli_astobj2_container_dump, "Show container contents"),
 	AST_CLI_DEFINE(handle_cli_astobj2_container_stats, "Show container statistics"),
 	AST_CLI_DEFINE(handle_cli_astobj2_container_check, "Perform a container integrity check"),
-};
 #endif	/* defined(AO2_DEBUG) */
+	AST_CLI_DEFINE(handle_cli_astobj2_show_containers, "Show registered containers and growth counters"),
+};
 
-#if defined(AO2_DEBUG)
 static void container_cleanup(void)
 {
 	ao2_t_ref(reg_containers, -1, "Releasing container registration container");
@@ -1176,11 +1233,9 @@ static void container_cleanup(void)
 
 	ast_cli_unregister_multiple(cli_astobj2, ARRAY_LEN(cli_astobj2));
 }
-#endif	/* defined(AO2_DEBUG) */
 
 int container_init(void)
 {
-#if defined(AO2_DEBUG)
 	reg_containers = ao2_t_container_alloc_list(AO2_ALLOC_OPT_LOCK_RWLOCK,
 		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, ao2_reg_sort_cb, NULL,
 		"Container registration container.");
@@ -1190,7 +1245,6 @@ int container_init(void)
 
 	ast_cli_register_multiple(cli_astobj2, ARRAY_LEN(cli_astobj2));
 	ast_register_cleanup(container_cleanup);
-#endif	/* defined(AO2_DEBUG) */
 
 	return 0;
 }
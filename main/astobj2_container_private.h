@@ -278,6 +278,10 @@ struct ao2_container {
 	uint32_t options;
 	/*! Number of elements in the container. */
 	int elements;
+	/*! Peak number of elements ever in the container. */
+	int peak_elements;
+	/*! Total number of objects ever linked into the container. */
+	int total_inserts;
 #if defined(AO2_DEBUG)
 	/*! Number of nodes in the container. */
 	int nodes;
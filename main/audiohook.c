@@ -97,12 +97,61 @@ static int audiohook_set_internal_rate(struct ast_audiohook *audiohook, int rate
 	return 0;
 }
 
+/*!
+ * \internal
+ * \brief Release all raw frames queued for deferred translation.
+ *
+ * \note The audiohook must be locked.
+ */
+static void audiohook_deferred_flush(struct ast_audiohook *audiohook)
+{
+	struct ast_frame *frame;
+
+	while ((frame = AST_LIST_REMOVE_HEAD(&audiohook->deferred_read_frames, frame_list))) {
+		ast_frfree(frame);
+	}
+	while ((frame = AST_LIST_REMOVE_HEAD(&audiohook->deferred_write_frames, frame_list))) {
+		ast_frfree(frame);
+	}
+	audiohook->deferred_read_samples = 0;
+	audiohook->deferred_write_samples = 0;
+}
+
+/*!
+ * \internal
+ * \brief Translate queued raw frames into the factories.
+ *
+ * This is the deferred half of ast_audiohook_write_frame(): it runs on
+ * the consuming thread when the audiohook is read, so the translation
+ * cost is not paid by the channel's media threads.
+ *
+ * \note The audiohook must be locked.
+ */
+static void audiohook_deferred_drain(struct ast_audiohook *audiohook)
+{
+	struct ast_frame *frame;
+
+	while ((frame = AST_LIST_REMOVE_HEAD(&audiohook->deferred_read_frames, frame_list))) {
+		ast_slinfactory_feed(&audiohook->read_factory, frame);
+		ast_frfree(frame);
+	}
+	while ((frame = AST_LIST_REMOVE_HEAD(&audiohook->deferred_write_frames, frame_list))) {
+		ast_slinfactory_feed(&audiohook->write_factory, frame);
+		ast_frfree(frame);
+	}
+	audiohook->deferred_read_samples = 0;
+	audiohook->deferred_write_samples = 0;
+}
+
 int ast_audiohook_init(struct ast_audiohook *audiohook, enum ast_audiohook_type type, const char *source, enum ast_audiohook_init_flags init_flags)
 {
 	/* Need to keep the type and source */
 	audiohook->type = type;
 	audiohook->source = source;
 
+	AST_LIST_HEAD_INIT_NOLOCK(&audiohook->deferred_read_frames);
+	AST_LIST_HEAD_INIT_NOLOCK(&audiohook->deferred_write_frames);
+
 	/* Initialize lock that protects our audiohook */
 	ast_mutex_init(&audiohook->lock);
 	ast_cond_init(&audiohook->trigger, NULL);
@@ -120,6 +169,8 @@ int ast_audiohook_init(struct ast_audiohook *audiohook, enum ast_audiohook_type
 
 int ast_audiohook_destroy(struct ast_audiohook *audiohook)
 {
+	audiohook_deferred_flush(audiohook);
+
 	/* Drop the factories used by this audiohook type */
 	switch (audiohook->type) {
 	case AST_AUDIOHOOK_TYPE_SPY:
@@ -162,29 +213,59 @@ int ast_audiohook_write_frame(struct ast_audiohook *audiohook, enum ast_audiohoo
 	/* Update last feeding time to be current */
 	*rwtime = ast_tvnow();
 
-	our_factory_samples = ast_slinfactory_available(factory);
+	our_factory_samples = ast_slinfactory_available(factory)
+		+ (direction == AST_AUDIOHOOK_DIRECTION_READ
+			? audiohook->deferred_read_samples : audiohook->deferred_write_samples);
 	our_factory_ms = ast_tvdiff_ms(*rwtime, previous_time) + (our_factory_samples / (audiohook->hook_internal_samp_rate / 1000));
-	other_factory_samples = ast_slinfactory_available(other_factory);
+	other_factory_samples = ast_slinfactory_available(other_factory)
+		+ (direction == AST_AUDIOHOOK_DIRECTION_READ
+			? audiohook->deferred_write_samples : audiohook->deferred_read_samples);
 	other_factory_ms = other_factory_samples / (audiohook->hook_internal_samp_rate / 1000);
 
 	if (ast_test_flag(audiohook, AST_AUDIOHOOK_TRIGGER_SYNC) && (our_factory_ms - other_factory_ms > AST_AUDIOHOOK_SYNC_TOLERANCE)) {
 		ast_debug(4, "Flushing audiohook %p so it remains in sync\n", audiohook);
 		ast_slinfactory_flush(factory);
 		ast_slinfactory_flush(other_factory);
+		audiohook_deferred_flush(audiohook);
 	}
 
 	if (ast_test_flag(audiohook, AST_AUDIOHOOK_SMALL_QUEUE) && ((our_factory_ms > AST_AUDIOHOOK_SMALL_QUEUE_TOLERANCE) || (other_factory_ms > AST_AUDIOHOOK_SMALL_QUEUE_TOLERANCE))) {
 		ast_debug(4, "Audiohook %p has stale audio in its factories. Flushing them both\n", audiohook);
 		ast_slinfactory_flush(factory);
 		ast_slinfactory_flush(other_factory);
+		audiohook_deferred_flush(audiohook);
 	} else if ((our_factory_ms > AST_AUDIOHOOK_LONG_QUEUE_TOLERANCE) || (other_factory_ms > AST_AUDIOHOOK_LONG_QUEUE_TOLERANCE)) {
 		ast_debug(4, "Audiohook %p has stale audio in its factories. Flushing them both\n", audiohook);
 		ast_slinfactory_flush(factory);
 		ast_slinfactory_flush(other_factory);
+		audiohook_deferred_flush(audiohook);
 	}
 
 	/* Write frame out to respective factory */
-	ast_slinfactory_feed(factory, frame);
+	if ((audiohook->init_flags & AST_AUDIOHOOK_DEFER_TRANSLATE)
+		&& frame->frametype == AST_FRAME_VOICE) {
+		/* Park a copy of the raw frame instead; the consumer pays for
+		 * the translation to slin when it drains the queue. */
+		struct ast_frame *dup = ast_frdup(frame);
+
+		if (dup) {
+			unsigned int est = dup->samples;
+			unsigned int in_rate = ast_format_get_sample_rate(dup->subclass.format);
+
+			if (in_rate != audiohook->hook_internal_samp_rate) {
+				est = est * audiohook->hook_internal_samp_rate / in_rate;
+			}
+			if (direction == AST_AUDIOHOOK_DIRECTION_READ) {
+				AST_LIST_INSERT_TAIL(&audiohook->deferred_read_frames, dup, frame_list);
+				audiohook->deferred_read_samples += est;
+			} else {
+				AST_LIST_INSERT_TAIL(&audiohook->deferred_write_frames, dup, frame_list);
+				audiohook->deferred_write_samples += est;
+			}
+		}
+	} else {
+		ast_slinfactory_feed(factory, frame);
+	}
 
 	/* If we need to notify the respective handler of this audiohook, do so */
 	if ((ast_test_flag(audiohook, AST_AUDIOHOOK_TRIGGER_MODE) == AST_AUDIOHOOK_TRIGGER_READ) && (direction == AST_AUDIOHOOK_DIRECTION_READ)) {
@@ -211,6 +292,10 @@ static struct ast_frame *audiohook_read_frame_single(struct ast_audiohook *audio
 		.samples = samples,
 	};
 
+	/* Translate anything the channel thread queued raw before looking
+	 * at what is available. */
+	audiohook_deferred_drain(audiohook);
+
 	/* Ensure the factory is able to give us the samples we want */
 	if (samples > ast_slinfactory_available(factory)) {
 		return NULL;
@@ -248,6 +333,10 @@ static struct ast_frame *audiohook_read_frame_both(struct ast_audiohook *audioho
 		.samples = samples,
 	};
 
+	/* Translate anything the channel threads queued raw before looking
+	 * at what is available. */
+	audiohook_deferred_drain(audiohook);
+
 	/* Make sure both factories have the required samples */
 	usable_read = (ast_slinfactory_available(&audiohook->read_factory) >= samples ? 1 : 0);
 	usable_write = (ast_slinfactory_available(&audiohook->write_factory) >= samples ? 1 : 0);
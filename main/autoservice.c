@@ -51,6 +51,9 @@
 
 #define MAX_AUTOMONS 1500
 
+/*! Frames drained from a channel in one lock hold per wakeup. */
+#define AUTOSERVICE_READ_BATCH 8
+
 struct asent {
 	struct ast_channel *chan;
 	/*! This gets incremented each time autoservice gets started on the same
@@ -88,9 +91,10 @@ static void *autoservice_run(void *ign)
 		struct asent *ents[MAX_AUTOMONS];
 		struct ast_channel *chan;
 		struct asent *as;
-		int i, x = 0, ms = 50;
+		int i, n, x = 0, ms = 50;
+		int fcount;
+		struct ast_frame *batch[AUTOSERVICE_READ_BATCH];
 		struct ast_frame *f = NULL;
-		struct ast_frame *defer_frame = NULL;
 
 		AST_LIST_LOCK(&aslist);
 
@@ -132,63 +136,63 @@ static void *autoservice_run(void *ign)
 		callid = ast_channel_callid(chan);
 		ast_callid_threadassoc_change(callid);
 
-		f = ast_read(chan);
+		fcount = ast_read_batch(chan, batch, ARRAY_LEN(batch));
 
-		if (!f) {
-			/* No frame means the channel has been hung up.
+		/* The ast_waitfor_n() call will only read frames from
+		 * the channels' file descriptors. If ast_waitfor_n()
+		 * returns non-NULL, then one of the channels in the
+		 * mons array must have triggered the return, so the
+		 * lookup below cannot fail. */
+		for (i = 0; i < x; i++) {
+			if (mons[i] == chan) {
+				break;
+			}
+		}
+
+		if (fcount < 0) {
+			struct ast_frame *dup_f;
+
+			/* No frames means the channel has been hung up.
 			 * A hangup frame needs to be queued here as ast_waitfor() may
 			 * never return again for the condition to be detected outside
 			 * of autoservice.  So, we'll leave a HANGUP queued up so the
 			 * thread in charge of this channel will know. */
 
-			defer_frame = &hangup_frame;
-		} else if (ast_is_deferrable_frame(f)) {
-			defer_frame = f;
-		} else {
-			/* Can't defer. Discard and continue with next. */
-			ast_frfree(f);
+			if ((dup_f = ast_frdup(&hangup_frame))) {
+				AST_LIST_INSERT_HEAD(&ents[i]->deferred_frames, dup_f, frame_list);
+			}
 			continue;
 		}
 
-		for (i = 0; i < x; i++) {
+		for (n = 0; n < fcount; n++) {
 			struct ast_frame *dup_f;
 
-			if (mons[i] != chan) {
+			f = batch[n];
+
+			if (!ast_is_deferrable_frame(f)) {
+				/* Can't defer. Discard and continue with next. */
+				ast_frfree(f);
 				continue;
 			}
 
-			if (!f) { /* defer_frame == &hangup_frame */
-				if ((dup_f = ast_frdup(defer_frame))) {
-					AST_LIST_INSERT_HEAD(&ents[i]->deferred_frames, dup_f, frame_list);
-				}
-			} else {
-				if (defer_frame->frametype == AST_FRAME_CONTROL &&
-					defer_frame->subclass.integer == AST_CONTROL_VIDUPDATE) {
-
-					/* If a video update is already queued don't needlessly queue another */
-					if (ents[i]->video_update) {
-						ast_frfree(defer_frame);
-						break;
-					}
+			if (f->frametype == AST_FRAME_CONTROL &&
+				f->subclass.integer == AST_CONTROL_VIDUPDATE) {
 
-					ents[i]->video_update = 1;
-				}
-				if ((dup_f = ast_frisolate(defer_frame))) {
-					AST_LIST_INSERT_HEAD(&ents[i]->deferred_frames, dup_f, frame_list);
+				/* If a video update is already queued don't needlessly queue another */
+				if (ents[i]->video_update) {
+					ast_frfree(f);
+					continue;
 				}
-				if (dup_f != defer_frame) {
-					ast_frfree(defer_frame);
-				}
-			}
 
-			break;
+				ents[i]->video_update = 1;
+			}
+			if ((dup_f = ast_frisolate(f))) {
+				AST_LIST_INSERT_HEAD(&ents[i]->deferred_frames, dup_f, frame_list);
+			}
+			if (dup_f != f) {
+				ast_frfree(f);
+			}
 		}
-		/* The ast_waitfor_n() call will only read frames from
-		 * the channels' file descriptors. If ast_waitfor_n()
-		 * returns non-NULL, then one of the channels in the
-		 * mons array must have triggered the return. It's
-		 * therefore impossible that we got here while (i >= x).
-		 * If we did, we'd need to ast_frfree(f) if (f). */
 	}
 
 	ast_callid_threadassoc_change(0);
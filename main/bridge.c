@@ -312,6 +312,93 @@ int ast_bridge_queue_action(struct ast_bridge *bridge, struct ast_frame *action)
 	return 0;
 }
 
+int ast_bridge_inject_sound(struct ast_bridge *bridge, struct ast_frame *frame)
+{
+	int res = -1;
+
+	ast_bridge_lock(bridge);
+	if (bridge->technology->inject_sound) {
+		res = bridge->technology->inject_sound(bridge, frame);
+	}
+	ast_bridge_unlock(bridge);
+	return res;
+}
+
+int ast_bridge_mix_tap_attach(struct ast_bridge *bridge, struct ast_bridge_mix_tap *tap)
+{
+	int res = -1;
+
+	if (!tap || !tap->deliver) {
+		return -1;
+	}
+
+	ast_bridge_lock(bridge);
+	if (bridge->technology->mix_tap_attach) {
+		res = bridge->technology->mix_tap_attach(bridge, tap);
+	}
+	ast_bridge_unlock(bridge);
+	return res;
+}
+
+int ast_bridge_mix_tap_detach(struct ast_bridge *bridge, struct ast_bridge_mix_tap *tap)
+{
+	int res = -1;
+
+	ast_bridge_lock(bridge);
+	if (bridge->technology->mix_tap_detach) {
+		res = bridge->technology->mix_tap_detach(bridge, tap);
+	}
+	ast_bridge_unlock(bridge);
+	return res;
+}
+
+struct mix_tap_file_sink {
+	/*! Tap interface.  Must remain first. */
+	struct ast_bridge_mix_tap tap;
+	/*! Where the mix is recorded. */
+	struct ast_filestream *fs;
+};
+
+static int mix_tap_file_deliver(struct ast_bridge_mix_tap *tap, struct ast_bridge *bridge,
+	struct ast_frame *frame)
+{
+	struct mix_tap_file_sink *sink = (struct mix_tap_file_sink *) tap;
+
+	if (ast_writestream(sink->fs, frame)) {
+		ast_log(LOG_WARNING, "Bridge %s: recording tap write failed; stopping recording\n",
+			bridge->uniqueid);
+		return -1;
+	}
+	return 0;
+}
+
+static void mix_tap_file_destroy(struct ast_bridge_mix_tap *tap)
+{
+	struct mix_tap_file_sink *sink = (struct mix_tap_file_sink *) tap;
+
+	ast_closestream(sink->fs);
+	ast_free(sink);
+}
+
+struct ast_bridge_mix_tap *ast_bridge_mix_tap_file_new(struct ast_filestream *fs)
+{
+	struct mix_tap_file_sink *sink;
+
+	if (!fs) {
+		return NULL;
+	}
+
+	sink = ast_calloc(1, sizeof(*sink));
+	if (!sink) {
+		return NULL;
+	}
+	sink->tap.deliver = mix_tap_file_deliver;
+	sink->tap.destroy = mix_tap_file_destroy;
+	sink->fs = fs;
+
+	return &sink->tap;
+}
+
 void bridge_dissolve(struct ast_bridge *bridge, int cause)
 {
 	struct ast_bridge_channel *bridge_channel;
@@ -3179,6 +3266,194 @@ static struct ast_bridge_hook *bridge_hook_generic(size_t size,
 	return hook;
 }
 
+/*! Branches per compiled DTMF trie node: digits 0-9, '*', '#' and A-D. */
+#define BRIDGE_DTMF_TRIE_BRANCHES 16
+
+/*! \brief One node of the compiled DTMF feature code trie. */
+struct ast_bridge_dtmf_trie {
+	/*! Child node per possible next digit. */
+	struct ast_bridge_dtmf_trie *branch[BRIDGE_DTMF_TRIE_BRANCHES];
+	/*! TRUE if a hook code ends on this node. */
+	unsigned int terminal:1;
+};
+
+/*!
+ * \internal
+ * \brief Map a DTMF digit to its trie branch index.
+ *
+ * \param digit DTMF digit to map.
+ *
+ * \retval index of the branch for the digit.
+ * \retval -1 if the character is not a DTMF digit.
+ */
+static int bridge_dtmf_trie_index(char digit)
+{
+	if ('0' <= digit && digit <= '9') {
+		return digit - '0';
+	}
+	if (digit == '*') {
+		return 10;
+	}
+	if (digit == '#') {
+		return 11;
+	}
+	/* Hook codes are matched case insensitively. */
+	if ('A' <= digit && digit <= 'D') {
+		return 12 + digit - 'A';
+	}
+	if ('a' <= digit && digit <= 'd') {
+		return 12 + digit - 'a';
+	}
+	return -1;
+}
+
+/*!
+ * \internal
+ * \brief Destroy a DTMF feature code trie.
+ *
+ * \param node Root of the (sub)trie to destroy.  NULL tolerant.
+ */
+static void bridge_dtmf_trie_destroy(struct ast_bridge_dtmf_trie *node)
+{
+	int idx;
+
+	if (!node) {
+		return;
+	}
+	for (idx = 0; idx < BRIDGE_DTMF_TRIE_BRANCHES; ++idx) {
+		bridge_dtmf_trie_destroy(node->branch[idx]);
+	}
+	ast_free(node);
+}
+
+/*!
+ * \internal
+ * \brief Insert one hook code into the DTMF feature code trie.
+ *
+ * \param root Root node of the trie.
+ * \param code Hook code to insert.
+ *
+ * \retval 0 on success.  (Undialable codes are skipped, not errors.)
+ * \retval -1 on allocation failure.
+ */
+static int bridge_dtmf_trie_insert(struct ast_bridge_dtmf_trie *root, const char *code)
+{
+	struct ast_bridge_dtmf_trie *node = root;
+	const char *cur;
+	int idx;
+
+	/*
+	 * Validate the whole code before creating any nodes so a code
+	 * containing a non-DTMF character cannot leave behind a prefix
+	 * path without a reachable terminal.
+	 */
+	if (ast_strlen_zero(code)) {
+		return 0;
+	}
+	for (cur = code; *cur; ++cur) {
+		if (bridge_dtmf_trie_index(*cur) < 0) {
+			return 0;
+		}
+	}
+
+	for (cur = code; *cur; ++cur) {
+		idx = bridge_dtmf_trie_index(*cur);
+		if (!node->branch[idx]
+			&& !(node->branch[idx] = ast_calloc(1, sizeof(*node)))) {
+			return -1;
+		}
+		node = node->branch[idx];
+	}
+	node->terminal = 1;
+
+	return 0;
+}
+
+/*!
+ * \internal
+ * \brief Recompile the DTMF feature code trie from the hook container.
+ *
+ * \param features Features structure whose trie is stale.
+ *
+ * \note The features->dtmf_hooks container must be locked.
+ *
+ * \retval 0 on success.
+ * \retval -1 on error.
+ */
+static int bridge_dtmf_trie_rebuild(struct ast_bridge_features *features)
+{
+	struct ast_bridge_dtmf_trie *root;
+	struct ast_bridge_hook_dtmf *hook;
+	struct ao2_iterator iter;
+
+	root = ast_calloc(1, sizeof(*root));
+	if (!root) {
+		return -1;
+	}
+
+	iter = ao2_iterator_init(features->dtmf_hooks, AO2_ITERATOR_DONTLOCK);
+	for (; (hook = ao2_iterator_next(&iter)); ao2_ref(hook, -1)) {
+		if (bridge_dtmf_trie_insert(root, hook->dtmf.code)) {
+			ao2_ref(hook, -1);
+			ao2_iterator_destroy(&iter);
+			bridge_dtmf_trie_destroy(root);
+			return -1;
+		}
+	}
+	ao2_iterator_destroy(&iter);
+
+	bridge_dtmf_trie_destroy(features->dtmf_trie);
+	features->dtmf_trie = root;
+	features->dtmf_trie_dirty = 0;
+
+	return 0;
+}
+
+enum ast_bridge_dtmf_match ast_bridge_features_dtmf_match(struct ast_bridge_features *features, const char *collected)
+{
+	struct ast_bridge_dtmf_trie *node;
+	enum ast_bridge_dtmf_match match = AST_BRIDGE_DTMF_MATCH_NONE;
+	int idx;
+
+	ao2_lock(features->dtmf_hooks);
+	if ((features->dtmf_trie_dirty || !features->dtmf_trie)
+		&& bridge_dtmf_trie_rebuild(features)) {
+		ao2_unlock(features->dtmf_hooks);
+		return AST_BRIDGE_DTMF_MATCH_NONE;
+	}
+
+	node = features->dtmf_trie;
+	for (; node && *collected; ++collected) {
+		idx = bridge_dtmf_trie_index(*collected);
+		node = idx < 0 ? NULL : node->branch[idx];
+	}
+	if (node) {
+		/*
+		 * Every node is on the path to at least one terminal, so a
+		 * surviving non-terminal node means some longer code can
+		 * still match.
+		 */
+		match = node->terminal
+			? AST_BRIDGE_DTMF_MATCH_EXACT : AST_BRIDGE_DTMF_MATCH_PARTIAL;
+	}
+	ao2_unlock(features->dtmf_hooks);
+
+	return match;
+}
+
+/*!
+ * \internal
+ * \brief Mark the compiled DTMF feature code trie as stale.
+ *
+ * \param features Features structure whose hook set changed.
+ */
+static void bridge_dtmf_trie_invalidate(struct ast_bridge_features *features)
+{
+	ao2_lock(features->dtmf_hooks);
+	features->dtmf_trie_dirty = 1;
+	ao2_unlock(features->dtmf_hooks);
+}
+
 int ast_bridge_dtmf_hook(struct ast_bridge_features *features,
 	const char *dtmf,
 	ast_bridge_hook_callback callback,
@@ -3200,6 +3475,9 @@ int ast_bridge_dtmf_hook(struct ast_bridge_features *features,
 
 	/* Once done we put it in the container. */
 	res = ao2_link(features->dtmf_hooks, hook) ? 0 : -1;
+	if (!res) {
+		bridge_dtmf_trie_invalidate(features);
+	}
 	if (res) {
 		/*
 		 * Could not link the hook into the container.
@@ -3501,6 +3779,7 @@ static void hooks_remove_heap(struct ast_heap *hooks, enum ast_bridge_hook_remov
 void ast_bridge_features_remove(struct ast_bridge_features *features, enum ast_bridge_hook_remove_flags remove_flags)
 {
 	hooks_remove_container(features->dtmf_hooks, remove_flags);
+	bridge_dtmf_trie_invalidate(features);
 	hooks_remove_container(features->other_hooks, remove_flags);
 	hooks_remove_heap(features->interval_hooks, remove_flags);
 }
@@ -3599,6 +3878,7 @@ void ast_bridge_features_merge(struct ast_bridge_features *into, const struct as
 
 	/* Merge hook containers */
 	ao2_callback(from->dtmf_hooks, 0, merge_container_cb, into->dtmf_hooks);
+	bridge_dtmf_trie_invalidate(into);
 	ao2_callback(from->other_hooks, 0, merge_container_cb, into->other_hooks);
 
 	/* Merge hook heaps */
@@ -3666,6 +3946,10 @@ void ast_bridge_features_cleanup(struct ast_bridge_features *features)
 	ao2_cleanup(features->other_hooks);
 	features->other_hooks = NULL;
 
+	/* Destroy the compiled DTMF feature code trie. */
+	bridge_dtmf_trie_destroy(features->dtmf_trie);
+	features->dtmf_trie = NULL;
+
 	/* Destroy the DTMF hooks container. */
 	ao2_cleanup(features->dtmf_hooks);
 	features->dtmf_hooks = NULL;
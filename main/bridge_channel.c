@@ -33,6 +33,7 @@
 #include "asterisk.h"
 
 #include <signal.h>
+#include <errno.h>
 
 #include "asterisk/heap.h"
 #include "asterisk/alertpipe.h"
@@ -42,6 +43,7 @@
 #include "asterisk/pbx.h"
 #include "asterisk/channel.h"
 #include "asterisk/timing.h"
+#include "asterisk/latency_trace.h"
 #include "asterisk/bridge.h"
 #include "asterisk/bridge_channel.h"
 #include "asterisk/bridge_after.h"
@@ -1036,7 +1038,12 @@ int ast_bridge_channel_queue_frame(struct ast_bridge_channel *bridge_channel, st
 		}
 	}
 
-	dup = ast_frdup(fr);
+	if (fr->mallocd & AST_MALLOCD_DATA_SHARED) {
+		/* Zero-copy fan-out: just take a reference on the shared data. */
+		dup = ast_frdup_shared(fr);
+	} else {
+		dup = ast_frdup(fr);
+	}
 	if (!dup) {
 		return -1;
 	}
@@ -1083,6 +1090,7 @@ int ast_bridge_channel_queue_frame(struct ast_bridge_channel *bridge_channel, st
 int ast_bridge_queue_everyone_else(struct ast_bridge *bridge, struct ast_bridge_channel *bridge_channel, struct ast_frame *frame)
 {
 	struct ast_bridge_channel *cur;
+	struct ast_frame *shared = NULL;
 	int not_written = -1;
 
 	if (frame->frametype == AST_FRAME_NULL) {
@@ -1090,14 +1098,25 @@ int ast_bridge_queue_everyone_else(struct ast_bridge *bridge, struct ast_bridge_
 		return 0;
 	}
 
+	if ((frame->frametype == AST_FRAME_VOICE || frame->frametype == AST_FRAME_VIDEO)
+		&& frame->datalen) {
+		/* Copy the media payload into a shared reference counted
+		 * block once so each receiver only takes a reference on it
+		 * instead of duplicating the data. */
+		shared = ast_frdup_shared(frame);
+	}
+
 	AST_LIST_TRAVERSE(&bridge->channels, cur, entry) {
 		if (cur == bridge_channel) {
 			continue;
 		}
-		if (!ast_bridge_channel_queue_frame(cur, frame)) {
+		if (!ast_bridge_channel_queue_frame(cur, shared ?: frame)) {
 			not_written = 0;
 		}
 	}
+	if (shared) {
+		ast_frfree(shared);
+	}
 	return not_written;
 }
 
@@ -1733,22 +1752,30 @@ void ast_bridge_channel_feature_digit(struct ast_bridge_channel *bridge_channel,
 	}
 
 	while (digit) {
+		enum ast_bridge_dtmf_match match;
+
 		/* See if a DTMF feature hook matches or can match */
-		hook = ao2_find(features->dtmf_hooks, bridge_channel->dtmf_hook_state.collected,
-			OBJ_SEARCH_PARTIAL_KEY);
-		if (!hook) {
+		match = ast_bridge_features_dtmf_match(features,
+			bridge_channel->dtmf_hook_state.collected);
+		if (match == AST_BRIDGE_DTMF_MATCH_NONE) {
 			ast_debug(1, "No DTMF feature hooks on %p(%s) match '%s'\n",
 				bridge_channel, ast_channel_name(bridge_channel->chan),
 				bridge_channel->dtmf_hook_state.collected);
 			break;
-		} else if (dtmf_len != strlen(hook->dtmf.code)) {
+		} else if (match == AST_BRIDGE_DTMF_MATCH_PARTIAL) {
 			unsigned int digit_timeout;
 			/* Need more digits to match */
-			ao2_ref(hook, -1);
 			digit_timeout = bridge_channel_feature_digit_timeout(bridge_channel);
 			bridge_channel->dtmf_hook_state.interdigit_timeout =
 				ast_tvadd(ast_tvnow(), ast_samp2tv(digit_timeout, 1000));
 			return;
+		} else if (!(hook = ao2_find(features->dtmf_hooks,
+			bridge_channel->dtmf_hook_state.collected, OBJ_SEARCH_KEY))) {
+			/* The matched hook was removed since the trie was compiled. */
+			ast_debug(1, "DTMF feature hook for '%s' on %p(%s) disappeared before it could run\n",
+				bridge_channel->dtmf_hook_state.collected, bridge_channel,
+				ast_channel_name(bridge_channel->chan));
+			break;
 		} else {
 			int remove_me;
 			int already_suspended;
@@ -1777,6 +1804,9 @@ void ast_bridge_channel_feature_digit(struct ast_bridge_channel *bridge_channel,
 				ast_debug(1, "DTMF hook %p is being removed from %p(%s)\n",
 					hook, bridge_channel, ast_channel_name(bridge_channel->chan));
 				ao2_unlink(features->dtmf_hooks, hook);
+				ao2_lock(features->dtmf_hooks);
+				features->dtmf_trie_dirty = 1;
+				ao2_unlock(features->dtmf_hooks);
 			}
 			testsuite_notify_feature_success(bridge_channel->chan, hook->dtmf.code);
 			ao2_ref(hook, -1);
@@ -2380,59 +2410,154 @@ static void sendtext_safe(struct ast_channel *chan, const struct ast_frame *f)
 
 /*!
  * \internal
- * \brief Handle bridge channel write frame to channel.
- * \since 12.0.0
+ * \brief Fan a voice frame out to any attached media taps.
  *
- * \param bridge_channel Channel to write outgoing frame.
+ * \param bridge_channel Channel the frame was observed on.
+ * \param frame Frame to deliver.  Remains owned by the caller.
+ * \param direction Which media path the frame was observed on.
+ *
+ * \note On entry, the bridge_channel is not locked.
  */
-static void bridge_channel_handle_write(struct ast_bridge_channel *bridge_channel)
+static void bridge_channel_feed_taps(struct ast_bridge_channel *bridge_channel, struct ast_frame *frame, enum ast_bridge_channel_tap_direction direction)
 {
-	struct ast_frame *fr;
-	struct sync_payload *sync_payload;
-	int num;
-	struct ast_msg_data *msg;
-
-	ast_bridge_channel_lock(bridge_channel);
+	struct ast_bridge_channel_tap *tap;
+	AST_LIST_HEAD_NOLOCK(, ast_bridge_channel_tap) detached = AST_LIST_HEAD_NOLOCK_INIT_VALUE;
 
-	/* It's not good to have unbalanced frames and alert_pipe alerts. */
-	ast_assert(!AST_LIST_EMPTY(&bridge_channel->wr_queue));
-	if (AST_LIST_EMPTY(&bridge_channel->wr_queue)) {
-		/* No frame, flush the alert pipe of excess alerts. */
-		ast_log(LOG_WARNING, "Weird.  No frame from bridge for %s to process?\n",
-			ast_channel_name(bridge_channel->chan));
-		ast_alertpipe_read(bridge_channel->alert_pipe);
-		ast_bridge_channel_unlock(bridge_channel);
+	/*
+	 * Checking emptiness unlocked is a benign race: taps are attached
+	 * before media is expected and this keeps the common untapped case
+	 * free of a lock operation per frame.
+	 */
+	if (frame->frametype != AST_FRAME_VOICE
+		|| AST_LIST_EMPTY(&bridge_channel->media_taps)) {
 		return;
 	}
 
-	AST_LIST_TRAVERSE_SAFE_BEGIN(&bridge_channel->wr_queue, fr, frame_list) {
-		if (bridge_channel->dtmf_hook_state.collected[0]) {
-			switch (fr->frametype) {
-			case AST_FRAME_BRIDGE_ACTION:
-			case AST_FRAME_BRIDGE_ACTION_SYNC:
-				/* Defer processing these frames while DTMF is collected. */
-				continue;
-			default:
-				break;
-			}
+	ast_bridge_channel_lock(bridge_channel);
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&bridge_channel->media_taps, tap, entry) {
+		if (!(tap->directions & direction)) {
+			continue;
+		}
+		if (tap->deliver(tap, bridge_channel, frame, direction)) {
+			/* The sink is gone so the tap detaches itself. */
+			AST_LIST_REMOVE_CURRENT(entry);
+			AST_LIST_INSERT_TAIL(&detached, tap, entry);
 		}
-		ast_alertpipe_read(bridge_channel->alert_pipe);
-		AST_LIST_REMOVE_CURRENT(frame_list);
-		break;
 	}
 	AST_LIST_TRAVERSE_SAFE_END;
+	ast_bridge_channel_unlock(bridge_channel);
 
+	/* Destroy failed taps outside of the bridge_channel lock. */
+	while ((tap = AST_LIST_REMOVE_HEAD(&detached, entry))) {
+		if (tap->destroy) {
+			tap->destroy(tap);
+		}
+	}
+}
+
+int ast_bridge_channel_tap_attach(struct ast_bridge_channel *bridge_channel, struct ast_bridge_channel_tap *tap)
+{
+	if (!tap->deliver
+		|| !(tap->directions
+			& (AST_BRIDGE_CHANNEL_TAP_READ | AST_BRIDGE_CHANNEL_TAP_WRITE))) {
+		return -1;
+	}
+
+	ast_bridge_channel_lock(bridge_channel);
+	AST_LIST_INSERT_TAIL(&bridge_channel->media_taps, tap, entry);
 	ast_bridge_channel_unlock(bridge_channel);
 
-	if (!fr) {
-		/*
-		 * Wait some to reduce CPU usage from a tight loop
-		 * without any wait because we only have deferred
-		 * frames in the wr_queue.
-		 */
-		usleep(1);
-		return;
+	return 0;
+}
+
+void ast_bridge_channel_tap_detach(struct ast_bridge_channel *bridge_channel, struct ast_bridge_channel_tap *tap)
+{
+	struct ast_bridge_channel_tap *cur;
+
+	ast_bridge_channel_lock(bridge_channel);
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&bridge_channel->media_taps, cur, entry) {
+		if (cur == tap) {
+			AST_LIST_REMOVE_CURRENT(entry);
+			break;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+	ast_bridge_channel_unlock(bridge_channel);
+
+	if (cur && cur->destroy) {
+		cur->destroy(cur);
+	}
+}
+
+/*! \brief Media tap sink which writes frame payloads to a descriptor. */
+struct tap_fd_sink {
+	/*! Tap interface.  Must remain the first member. */
+	struct ast_bridge_channel_tap tap;
+	/*! Descriptor payloads are written to.  Owned by the sink. */
+	int fd;
+};
+
+static int tap_fd_deliver(struct ast_bridge_channel_tap *tap, struct ast_bridge_channel *bridge_channel, struct ast_frame *frame, enum ast_bridge_channel_tap_direction direction)
+{
+	struct tap_fd_sink *sink = (struct tap_fd_sink *) tap;
+
+	if (!frame->datalen) {
+		return 0;
+	}
+	if (write(sink->fd, frame->data.ptr, frame->datalen) < 0) {
+		if (errno == EAGAIN || errno == EINTR) {
+			/* Never stall the media thread for a slow sink. */
+			return 0;
+		}
+		ast_log(LOG_WARNING, "Media tap on %s failed to write to sink: %s\n",
+			ast_channel_name(bridge_channel->chan), strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+static void tap_fd_destroy(struct ast_bridge_channel_tap *tap)
+{
+	struct tap_fd_sink *sink = (struct tap_fd_sink *) tap;
+
+	close(sink->fd);
+	ast_free(sink);
+}
+
+struct ast_bridge_channel_tap *ast_bridge_channel_tap_fd_new(int fd, unsigned int directions)
+{
+	struct tap_fd_sink *sink;
+
+	if (fd < 0) {
+		return NULL;
+	}
+
+	sink = ast_calloc(1, sizeof(*sink));
+	if (!sink) {
+		return NULL;
 	}
+	sink->fd = fd;
+	sink->tap.deliver = tap_fd_deliver;
+	sink->tap.destroy = tap_fd_destroy;
+	sink->tap.directions = directions;
+
+	return &sink->tap;
+}
+
+/*!
+ * \internal
+ * \brief Dispatch one frame dequeued from the bridge channel write queue.
+ * \since 12.0.0
+ *
+ * \param bridge_channel Channel to write outgoing frame.
+ * \param fr Frame to dispatch.  Consumed by this function.
+ */
+static void bridge_channel_dispatch_write(struct ast_bridge_channel *bridge_channel, struct ast_frame *fr)
+{
+	struct sync_payload *sync_payload;
+	int num;
+	struct ast_msg_data *msg;
 
 	switch (fr->frametype) {
 	case AST_FRAME_BRIDGE_ACTION:
@@ -2480,6 +2605,23 @@ static void bridge_channel_handle_write(struct ast_bridge_channel *bridge_channe
 			}
 		}
 
+		if (fr->mallocd & AST_MALLOCD_DATA_SHARED) {
+			struct ast_frame *writable;
+
+			/* The payload block is shared with every other receiver of the
+			 * fan-out, but from here on the frame is written into in place:
+			 * channel drivers build their wire header in the frame headroom
+			 * and audiohooks may adjust the payload.  Give the frame a
+			 * private copy before it reaches them. */
+			writable = ast_frisolate(fr);
+			if (!writable) {
+				break;
+			}
+			fr = writable;
+		}
+
+		bridge_channel_feed_taps(bridge_channel, fr, AST_BRIDGE_CHANNEL_TAP_WRITE);
+
 		/* Write the frame to the channel. */
 		bridge_channel->activity = BRIDGE_CHANNEL_THREAD_SIMPLE;
 		ast_write_stream(bridge_channel->chan, num, fr);
@@ -2488,6 +2630,88 @@ static void bridge_channel_handle_write(struct ast_bridge_channel *bridge_channe
 	bridge_frame_free(fr);
 }
 
+/*! Maximum number of queued frames to dispatch per write queue wakeup. */
+#define BRIDGE_CHANNEL_WRITE_BATCH 8
+
+/*!
+ * \internal
+ * \brief Handle bridge channel write frames to channel.
+ * \since 12.0.0
+ *
+ * Dequeues up to \ref BRIDGE_CHANNEL_WRITE_BATCH frames from the write
+ * queue under a single lock acquisition and dispatches them in order.
+ * Coalescing the dequeue this way avoids a lock/unlock round trip and a
+ * poll wakeup per queued frame when a bridge is pushing frames faster
+ * than this channel's thread is draining them.
+ *
+ * \param bridge_channel Channel to write outgoing frames.
+ */
+static void bridge_channel_handle_write(struct ast_bridge_channel *bridge_channel)
+{
+	struct ast_frame *fr;
+	AST_LIST_HEAD_NOLOCK(, ast_frame) batch = AST_LIST_HEAD_NOLOCK_INIT_VALUE;
+	int dequeued = 0;
+
+	ast_bridge_channel_lock(bridge_channel);
+
+	/* It's not good to have unbalanced frames and alert_pipe alerts. */
+	ast_assert(!AST_LIST_EMPTY(&bridge_channel->wr_queue));
+	if (AST_LIST_EMPTY(&bridge_channel->wr_queue)) {
+		/* No frame, flush the alert pipe of excess alerts. */
+		ast_log(LOG_WARNING, "Weird.  No frame from bridge for %s to process?\n",
+			ast_channel_name(bridge_channel->chan));
+		ast_alertpipe_read(bridge_channel->alert_pipe);
+		ast_bridge_channel_unlock(bridge_channel);
+		return;
+	}
+
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&bridge_channel->wr_queue, fr, frame_list) {
+		if (bridge_channel->dtmf_hook_state.collected[0]) {
+			switch (fr->frametype) {
+			case AST_FRAME_BRIDGE_ACTION:
+			case AST_FRAME_BRIDGE_ACTION_SYNC:
+				/* Defer processing these frames while DTMF is collected. */
+				continue;
+			default:
+				break;
+			}
+		}
+		ast_alertpipe_read(bridge_channel->alert_pipe);
+		AST_LIST_REMOVE_CURRENT(frame_list);
+		AST_LIST_INSERT_TAIL(&batch, fr, frame_list);
+		if (++dequeued == BRIDGE_CHANNEL_WRITE_BATCH) {
+			break;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+
+	ast_bridge_channel_unlock(bridge_channel);
+
+	if (!dequeued) {
+		/*
+		 * Wait some to reduce CPU usage from a tight loop
+		 * without any wait because we only have deferred
+		 * frames in the wr_queue.
+		 */
+		usleep(1);
+		return;
+	}
+
+	while ((fr = AST_LIST_REMOVE_HEAD(&batch, frame_list))) {
+		if (bridge_channel->state == BRIDGE_CHANNEL_STATE_WAIT) {
+			bridge_channel_dispatch_write(bridge_channel, fr);
+		} else {
+			/*
+			 * An earlier frame in the batch took the channel out of the
+			 * bridge.  Free the remainder the same way the wr_queue flush
+			 * on leave would have, which still signals any waiters on
+			 * synchronous bridge actions.
+			 */
+			bridge_frame_free(fr);
+		}
+	}
+}
+
 /*!
  * \internal
  * \brief Handle DTMF from a channel
@@ -2495,7 +2719,6 @@ static void bridge_channel_handle_write(struct ast_bridge_channel *bridge_channe
 static struct ast_frame *bridge_handle_dtmf(struct ast_bridge_channel *bridge_channel, struct ast_frame *frame)
 {
 	struct ast_bridge_features *features = bridge_channel->features;
-	struct ast_bridge_hook_dtmf *hook = NULL;
 	char dtmf[2];
 
 	/*
@@ -2505,14 +2728,12 @@ static struct ast_frame *bridge_handle_dtmf(struct ast_bridge_channel *bridge_ch
 	dtmf[0] = frame->subclass.integer;
 	dtmf[1] = '\0';
 	if (bridge_channel->dtmf_hook_state.collected[0]
-		|| (hook = ao2_find(features->dtmf_hooks, dtmf, OBJ_SEARCH_PARTIAL_KEY))) {
+		|| ast_bridge_features_dtmf_match(features, dtmf) != AST_BRIDGE_DTMF_MATCH_NONE) {
 		enum ast_frame_type frametype = frame->frametype;
 
 		bridge_frame_free(frame);
 		frame = NULL;
 
-		ao2_cleanup(hook);
-
 		switch (frametype) {
 		case AST_FRAME_DTMF_BEGIN:
 			/* Just eat the frame. */
@@ -2552,33 +2773,17 @@ static const char *controls[] = {
  *
  * \param bridge_channel Bridge channel the notification was received on
  */
-static void bridge_handle_trip(struct ast_bridge_channel *bridge_channel)
+/*!
+ * \internal
+ * \brief Process one frame read from a bridge channel's channel.
+ *
+ * \param bridge_channel Bridge channel the frame was read from
+ * \param frame Frame to process; ownership is taken.
+ */
+static void bridge_handle_read_frame(struct ast_bridge_channel *bridge_channel, struct ast_frame *frame)
 {
-	struct ast_frame *frame;
 	int blocked;
 
-	if (!ast_strlen_zero(ast_channel_call_forward(bridge_channel->chan))) {
-		/* TODO If early bridging is ever used by anything other than ARI,
-		 * it's important that we actually attempt to handle the call forward
-		 * attempt, as well as expand features on a bridge channel to allow/disallow
-		 * call forwarding. For now, all we do is raise an event, showing that
-		 * a call forward is being attempted.
-		 */
-		ast_channel_publish_dial_forward(NULL, bridge_channel->chan, NULL, NULL, "CANCEL",
-			ast_channel_call_forward(bridge_channel->chan));
-	}
-
-	if (bridge_channel->features->mute) {
-		frame = ast_read_stream_noaudio(bridge_channel->chan);
-	} else {
-		frame = ast_read_stream(bridge_channel->chan);
-	}
-
-	if (!frame) {
-		ast_bridge_channel_kick(bridge_channel, 0);
-		return;
-	}
-
 	if (!ast_channel_is_multistream(bridge_channel->chan)) {
 		/* This may not be initialized by non-multistream channel drivers */
 		frame->stream_num = -1;
@@ -2649,11 +2854,60 @@ static void bridge_handle_trip(struct ast_bridge_channel *bridge_channel)
 		break;
 	}
 
+	bridge_channel_feed_taps(bridge_channel, frame, AST_BRIDGE_CHANNEL_TAP_READ);
+
 	/* Simply write the frame out to the bridge technology. */
 	bridge_channel_write_frame(bridge_channel, frame);
 	bridge_frame_free(frame);
 }
 
+/*! Frames drained from the channel in one lock hold when tripped. */
+#define BRIDGE_READ_BATCH_SIZE 8
+
+/*!
+ * \internal
+ * \brief Feed notification that a frame is waiting on a channel into the bridging core
+ *
+ * \param bridge_channel Bridge channel the notification was received on
+ */
+static void bridge_handle_trip(struct ast_bridge_channel *bridge_channel)
+{
+	struct ast_frame *batch[BRIDGE_READ_BATCH_SIZE];
+	int count;
+	int idx;
+
+	if (!ast_strlen_zero(ast_channel_call_forward(bridge_channel->chan))) {
+		/* TODO If early bridging is ever used by anything other than ARI,
+		 * it's important that we actually attempt to handle the call forward
+		 * attempt, as well as expand features on a bridge channel to allow/disallow
+		 * call forwarding. For now, all we do is raise an event, showing that
+		 * a call forward is being attempted.
+		 */
+		ast_channel_publish_dial_forward(NULL, bridge_channel->chan, NULL, NULL, "CANCEL",
+			ast_channel_call_forward(bridge_channel->chan));
+	}
+
+	if (bridge_channel->features->mute) {
+		struct ast_frame *frame = ast_read_stream_noaudio(bridge_channel->chan);
+
+		if (!frame) {
+			ast_bridge_channel_kick(bridge_channel, 0);
+			return;
+		}
+		bridge_handle_read_frame(bridge_channel, frame);
+		return;
+	}
+
+	count = ast_read_stream_batch(bridge_channel->chan, batch, ARRAY_LEN(batch));
+	if (count < 0) {
+		ast_bridge_channel_kick(bridge_channel, 0);
+		return;
+	}
+	for (idx = 0; idx < count; ++idx) {
+		bridge_handle_read_frame(bridge_channel, batch[idx]);
+	}
+}
+
 /*!
  * \internal
  * \brief Determine how long till the next timer interval.
@@ -2790,12 +3044,15 @@ static void bridge_channel_wait(struct ast_bridge_channel *bridge_channel)
 				bridge_channel_handle_feature_timeout(bridge_channel);
 				bridge_channel_handle_interval(bridge_channel);
 			} else if (-1 < outfd) {
+				struct timeval trace_start = ast_latency_trace_start();
+
 				/*
 				 * Must do this after checking timeouts or may have
 				 * an infinite loop due to deferring write queue
 				 * actions while trying to match DTMF feature hooks.
 				 */
 				bridge_channel_handle_write(bridge_channel);
+				ast_latency_trace_end(AST_LATENCY_STAGE_BRIDGE, &trace_start);
 			}
 		}
 		bridge_channel->activity = BRIDGE_CHANNEL_THREAD_IDLE;
@@ -3087,6 +3344,7 @@ int bridge_channel_internal_allows_optimization(struct ast_bridge_channel *bridg
 static void bridge_channel_destroy(void *obj)
 {
 	struct ast_bridge_channel *bridge_channel = obj;
+	struct ast_bridge_channel_tap *tap;
 	struct ast_frame *fr;
 
 	if (bridge_channel->callid) {
@@ -3109,6 +3367,13 @@ static void bridge_channel_destroy(void *obj)
 		ast_frfree(fr);
 	}
 
+	/* Destroy any media taps still attached. */
+	while ((tap = AST_LIST_REMOVE_HEAD(&bridge_channel->media_taps, entry))) {
+		if (tap->destroy) {
+			tap->destroy(tap);
+		}
+	}
+
 	ast_cond_destroy(&bridge_channel->cond);
 
 	ao2_cleanup(bridge_channel->write_format);
@@ -70,6 +70,7 @@
 #include "asterisk/stasis_message_router.h"
 #include "asterisk/astobj2.h"
 #include "asterisk/taskprocessor.h"
+#include "asterisk/vector.h"
 
 /*** DOCUMENTATION
 	<configInfo name="cdr" language="en_US">
@@ -231,6 +232,7 @@ static int cdr_debug_enabled;
 	} while (0)
 
 static void cdr_detach(struct ast_cdr *cdr);
+static void cdr_post_shards_drain(void);
 static void cdr_submit_batch(int shutdown);
 static int cdr_toggle_runtime_options(void);
 
@@ -338,6 +340,7 @@ struct cdr_beitem {
 	char name[20];
 	char desc[80];
 	ast_cdrbe be;
+	ast_cdrbe_batch batch_be;
 	AST_RWLIST_ENTRY(cdr_beitem) list;
 	int suspended:1;
 };
@@ -386,6 +389,20 @@ static struct ao2_container *active_cdrs_all;
 /*! \brief Message router for stasis messages regarding channel state */
 static struct stasis_message_router *stasis_router;
 
+/*! \brief Number of taskprocessors that finalized CDR posting is sharded over */
+#define CDR_POST_SHARDS 8
+
+/*!
+ * \brief Taskprocessors that run the registered backends for finalized CDRs.
+ *
+ * In simple (non-batch) mode the backends used to run directly on the
+ * message router's thread, serializing every backend's I/O behind the CDR
+ * state machine. Finalized records are instead pushed to one of these
+ * taskprocessors, selected by hashing the Party A uniqueid so a channel's
+ * records always post in order.
+ */
+static struct ast_taskprocessor *cdr_post_shards[CDR_POST_SHARDS];
+
 /*! \brief Our subscription for bridges */
 static struct stasis_forward *bridge_subscription;
 
@@ -2842,7 +2859,12 @@ static void handle_parked_call_message(void *data, struct stasis_subscription *s
 static void handle_cdr_sync_message(void *data, struct stasis_subscription *sub,
 		struct stasis_message *message)
 {
-	return;
+	/* The router is serialized, so by the time we run every message
+	 * published ahead of the synchronization request has been handled.
+	 * Posting to the backends is sharded, however, so wait for those
+	 * queues to empty as well.
+	 */
+	cdr_post_shards_drain();
 }
 
 struct ast_cdr_config *ast_cdr_get_config(void)
@@ -2921,7 +2943,7 @@ int ast_cdr_backend_unsuspend(const char *name)
 	return success;
 }
 
-static int cdr_generic_register(struct be_list *generic_list, const char *name, const char *desc, ast_cdrbe be)
+static int cdr_generic_register(struct be_list *generic_list, const char *name, const char *desc, ast_cdrbe be, ast_cdrbe_batch batch_be)
 {
 	struct cdr_beitem *i;
 	struct cdr_beitem *cur;
@@ -2942,6 +2964,7 @@ static int cdr_generic_register(struct be_list *generic_list, const char *name,
 	}
 
 	i->be = be;
+	i->batch_be = batch_be;
 	ast_copy_string(i->name, name, sizeof(i->name));
 	ast_copy_string(i->desc, desc, sizeof(i->desc));
 
@@ -2964,12 +2987,24 @@ static int cdr_generic_register(struct be_list *generic_list, const char *name,
 
 int ast_cdr_register(const char *name, const char *desc, ast_cdrbe be)
 {
-	return cdr_generic_register(&be_list, name, desc, be);
+	return cdr_generic_register(&be_list, name, desc, be, NULL);
+}
+
+int ast_cdr_register_batch(const char *name, const char *desc, ast_cdrbe be,
+	ast_cdrbe_batch batch_be)
+{
+	if (!batch_be) {
+		ast_log(LOG_WARNING, "CDR engine '%s' lacks batch backend\n", name);
+
+		return -1;
+	}
+
+	return cdr_generic_register(&be_list, name, desc, be, batch_be);
 }
 
 int ast_cdr_modifier_register(const char *name, const char *desc, ast_cdrbe be)
 {
-	return cdr_generic_register((struct be_list *)&mo_list, name, desc, be);
+	return cdr_generic_register((struct be_list *)&mo_list, name, desc, be, NULL);
 }
 
 static int ast_cdr_generic_unregister(struct be_list *generic_list, const char *name)
@@ -3527,46 +3562,161 @@ void ast_cdr_setuserfield(const char *channel_name, const char *userfield)
 	ao2_cleanup(cdr);
 }
 
+/*! \brief Determine if posting a record should be skipped entirely */
+static int post_skip_unanswered(struct module_config *mod_cfg, struct ast_cdr *cdr)
+{
+	/* For people, who don't want to see unanswered single-channel events */
+	return !ast_test_flag(&mod_cfg->general->settings, CDR_UNANSWERED) &&
+			cdr->disposition < AST_CDR_ANSWERED &&
+			(ast_strlen_zero(cdr->channel) || ast_strlen_zero(cdr->dstchannel));
+}
+
 static void post_cdr(struct ast_cdr *cdr)
 {
 	struct module_config *mod_cfg;
 	struct cdr_beitem *i;
+	struct ast_cdr *rec;
+	AST_VECTOR(, struct ast_cdr *) postable;
+	int have_vector;
 
 	mod_cfg = ao2_global_obj_ref(module_configs);
 	if (!mod_cfg) {
 		return;
 	}
 
-	for (; cdr ; cdr = cdr->next) {
-		/* For people, who don't want to see unanswered single-channel events */
-		if (!ast_test_flag(&mod_cfg->general->settings, CDR_UNANSWERED) &&
-				cdr->disposition < AST_CDR_ANSWERED &&
-				(ast_strlen_zero(cdr->channel) || ast_strlen_zero(cdr->dstchannel))) {
-			ast_debug(1, "Skipping CDR for %s since we weren't answered\n", cdr->channel);
+	have_vector = !AST_VECTOR_INIT(&postable, 16);
+
+	for (rec = cdr; rec; rec = rec->next) {
+		if (post_skip_unanswered(mod_cfg, rec)) {
+			ast_debug(1, "Skipping CDR for %s since we weren't answered\n", rec->channel);
 			continue;
 		}
 
 		/* Modify CDR's */
 		AST_RWLIST_RDLOCK(&mo_list);
 		AST_RWLIST_TRAVERSE(&mo_list, i, list) {
-			i->be(cdr);
+			i->be(rec);
 		}
 		AST_RWLIST_UNLOCK(&mo_list);
 
-		if (ast_test_flag(cdr, AST_CDR_FLAG_DISABLE)) {
+		if (ast_test_flag(rec, AST_CDR_FLAG_DISABLE)) {
 			continue;
 		}
-		AST_RWLIST_RDLOCK(&be_list);
-		AST_RWLIST_TRAVERSE(&be_list, i, list) {
-			if (!i->suspended) {
-				i->be(cdr);
+
+		if (have_vector && AST_VECTOR_APPEND(&postable, rec)) {
+			AST_VECTOR_FREE(&postable);
+			have_vector = 0;
+		}
+	}
+
+	AST_RWLIST_RDLOCK(&be_list);
+	AST_RWLIST_TRAVERSE(&be_list, i, list) {
+		size_t idx;
+
+		if (i->suspended) {
+			continue;
+		}
+		if (have_vector && i->batch_be) {
+			if (AST_VECTOR_SIZE(&postable)) {
+				i->batch_be(AST_VECTOR_GET_ADDR(&postable, 0), AST_VECTOR_SIZE(&postable));
+			}
+		} else if (have_vector) {
+			for (idx = 0; idx < AST_VECTOR_SIZE(&postable); idx++) {
+				i->be(AST_VECTOR_GET(&postable, idx));
+			}
+		} else {
+			/* Couldn't track the postable records; re-walk the chain */
+			for (rec = cdr; rec; rec = rec->next) {
+				if (post_skip_unanswered(mod_cfg, rec)
+					|| ast_test_flag(rec, AST_CDR_FLAG_DISABLE)) {
+					continue;
+				}
+				i->be(rec);
 			}
 		}
-		AST_RWLIST_UNLOCK(&be_list);
+	}
+	AST_RWLIST_UNLOCK(&be_list);
+
+	if (have_vector) {
+		AST_VECTOR_FREE(&postable);
 	}
 	ao2_cleanup(mod_cfg);
 }
 
+/*! \brief Taskprocessor task that posts a detached CDR chain to the backends */
+static int post_detached_cdr(void *data)
+{
+	struct ast_cdr *cdr = data;
+
+	post_cdr(cdr);
+	ast_cdr_free(cdr);
+	return 0;
+}
+
+/*!
+ * \internal
+ * \brief Hand a detached CDR chain to a posting shard
+ *
+ * \retval 0 the shard took ownership of the records
+ * \retval -1 no shard available; the caller must post inline
+ */
+static int cdr_post_detached(struct ast_cdr *cdr)
+{
+	struct ast_taskprocessor *shard;
+
+	shard = cdr_post_shards[ast_str_hash(cdr->uniqueid) % CDR_POST_SHARDS];
+	if (!shard) {
+		return -1;
+	}
+	return ast_taskprocessor_push(shard, post_detached_cdr, cdr);
+}
+
+/*! \brief State for waiting on the posting shards to empty */
+struct cdr_post_barrier {
+	ast_mutex_t lock;
+	ast_cond_t cond;
+	int remaining;
+};
+
+static int cdr_post_barrier_cb(void *data)
+{
+	struct cdr_post_barrier *barrier = data;
+
+	ast_mutex_lock(&barrier->lock);
+	--barrier->remaining;
+	ast_cond_signal(&barrier->cond);
+	ast_mutex_unlock(&barrier->lock);
+	return 0;
+}
+
+/*!
+ * \internal
+ * \brief Block until every posting shard has run its queued records
+ */
+static void cdr_post_shards_drain(void)
+{
+	struct cdr_post_barrier barrier = { .remaining = 0, };
+	int i;
+
+	ast_mutex_init(&barrier.lock);
+	ast_cond_init(&barrier.cond, NULL);
+
+	ast_mutex_lock(&barrier.lock);
+	for (i = 0; i < CDR_POST_SHARDS; i++) {
+		if (cdr_post_shards[i]
+			&& !ast_taskprocessor_push(cdr_post_shards[i], cdr_post_barrier_cb, &barrier)) {
+			++barrier.remaining;
+		}
+	}
+	while (barrier.remaining) {
+		ast_cond_wait(&barrier.cond, &barrier.lock);
+	}
+	ast_mutex_unlock(&barrier.lock);
+
+	ast_cond_destroy(&barrier.cond);
+	ast_mutex_destroy(&barrier.lock);
+}
+
 int ast_cdr_set_property(const char *channel_name, enum ast_cdr_options option)
 {
 	struct cdr_object *cdr;
@@ -3772,16 +3922,27 @@ static void *do_batch_backend_process(void *data)
 {
 	struct cdr_batch_item *processeditem;
 	struct cdr_batch_item *batchitem = data;
+	struct ast_cdr *spliced = NULL;
+	struct ast_cdr **tail = &spliced;
 
-	/* Push each CDR into storage mechanism(s) and free all the memory */
+	/* Splice the queued records into one chain so batch-capable backends
+	 * get the entire flush in a single call */
 	while (batchitem) {
-		post_cdr(batchitem->cdr);
-		ast_cdr_free(batchitem->cdr);
+		*tail = batchitem->cdr;
+		while (*tail) {
+			tail = &(*tail)->next;
+		}
 		processeditem = batchitem;
 		batchitem = batchitem->next;
 		ast_free(processeditem);
 	}
 
+	/* Push the CDRs into storage mechanism(s) and free all the memory */
+	if (spliced) {
+		post_cdr(spliced);
+		ast_cdr_free(spliced);
+	}
+
 	return NULL;
 }
 
@@ -3880,8 +4041,10 @@ static void cdr_detach(struct ast_cdr *cdr)
 
 	/* post stuff immediately if we are not in batch mode, this is legacy behaviour */
 	if (!ast_test_flag(&mod_cfg->general->settings, CDR_BATCHMODE)) {
-		post_cdr(cdr);
-		ast_cdr_free(cdr);
+		if (cdr_post_detached(cdr)) {
+			post_cdr(cdr);
+			ast_cdr_free(cdr);
+		}
 		return;
 	}
 
@@ -4408,6 +4571,8 @@ static int process_config(int reload)
 
 static void cdr_engine_shutdown(void)
 {
+	int i;
+
 	stasis_message_router_unsubscribe_and_join(stasis_router);
 	stasis_router = NULL;
 
@@ -4418,6 +4583,11 @@ static void cdr_engine_shutdown(void)
 
 	ao2_callback(active_cdrs_master, OBJ_NODATA | OBJ_MULTIPLE | OBJ_UNLINK,
 		cdr_object_dispatch_all_cb, NULL);
+	cdr_post_shards_drain();
+	for (i = 0; i < CDR_POST_SHARDS; i++) {
+		ast_taskprocessor_unreference(cdr_post_shards[i]);
+		cdr_post_shards[i] = NULL;
+	}
 	finalize_batch_mode();
 	ast_cli_unregister_multiple(cli_commands, ARRAY_LEN(cli_commands));
 	ast_sched_context_destroy(sched);
@@ -4541,6 +4711,8 @@ static int unload_module(void)
 
 static int load_module(void)
 {
+	int i;
+
 	if (process_config(0)) {
 		return AST_MODULE_LOAD_FAILURE;
 	}
@@ -4582,6 +4754,17 @@ static int load_module(void)
 	}
 	ao2_container_register("cdrs_all", active_cdrs_all, cdr_all_print_fn);
 
+	for (i = 0; i < CDR_POST_SHARDS; i++) {
+		char name[AST_TASKPROCESSOR_MAX_NAME + 1];
+
+		snprintf(name, sizeof(name), "cdr/post/%d", i);
+		cdr_post_shards[i] = ast_taskprocessor_get(name, TPS_REF_DEFAULT);
+		if (!cdr_post_shards[i]) {
+			ast_log(AST_LOG_WARNING, "Failed to create CDR posting shard '%s'; records will post on the processing thread\n",
+				name);
+		}
+	}
+
 	sched = ast_sched_context_create();
 	if (!sched) {
 		ast_log(LOG_ERROR, "Unable to create schedule context.\n");
@@ -350,6 +350,17 @@ unsigned int ast_cel_check_enabled(void)
 	return enabled;
 }
 
+/*! \brief Retrieve the configured mask of tracked event types */
+static int64_t cel_tracked_events(void)
+{
+	int64_t events;
+	struct cel_config *cfg = ao2_global_obj_ref(cel_configs);
+
+	events = (!cfg || !cfg->general) ? 0 : cfg->general->events;
+	ao2_cleanup(cfg);
+	return events;
+}
+
 static char *handle_cli_status(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
 {
 	unsigned int i;
@@ -1496,9 +1507,18 @@ static int create_subscriptions(void)
 
 /*!
  * \brief Create the Stasis message router and routes for CEL
+ *
+ * Routes whose only purpose is reporting a single event type are only
+ * added when that type is being tracked, so messages for untracked
+ * types are dropped by the router's type dispatch instead of being
+ * formatted and then discarded. The channel snapshot and dial routes
+ * are always present: the snapshot route drives the CEL state
+ * machine, and the dial route records the dial status reported with
+ * hangup events in addition to publishing forward events.
  */
 static int create_routes(void)
 {
+	int64_t events = cel_tracked_events();
 	int ret = 0;
 
 	cel_state_router = stasis_message_router_create(cel_aggregation_topic);
@@ -1518,45 +1538,61 @@ static int create_routes(void)
 		cel_dial_cb,
 		NULL);
 
-	ret |= stasis_message_router_add(cel_state_router,
-		ast_channel_entered_bridge_type(),
-		cel_bridge_enter_cb,
-		NULL);
+	if (events & ((int64_t) 1 << AST_CEL_BRIDGE_ENTER)) {
+		ret |= stasis_message_router_add(cel_state_router,
+			ast_channel_entered_bridge_type(),
+			cel_bridge_enter_cb,
+			NULL);
+	}
 
-	ret |= stasis_message_router_add(cel_state_router,
-		ast_channel_left_bridge_type(),
-		cel_bridge_leave_cb,
-		NULL);
+	if (events & ((int64_t) 1 << AST_CEL_BRIDGE_EXIT)) {
+		ret |= stasis_message_router_add(cel_state_router,
+			ast_channel_left_bridge_type(),
+			cel_bridge_leave_cb,
+			NULL);
+	}
 
-	ret |= stasis_message_router_add(cel_state_router,
-		ast_parked_call_type(),
-		cel_parking_cb,
-		NULL);
+	if (events & (((int64_t) 1 << AST_CEL_PARK_START) | ((int64_t) 1 << AST_CEL_PARK_END))) {
+		ret |= stasis_message_router_add(cel_state_router,
+			ast_parked_call_type(),
+			cel_parking_cb,
+			NULL);
+	}
 
-	ret |= stasis_message_router_add(cel_state_router,
-		cel_generic_type(),
-		cel_generic_cb,
-		NULL);
+	if (events & ((int64_t) 1 << AST_CEL_USER_DEFINED)) {
+		ret |= stasis_message_router_add(cel_state_router,
+			cel_generic_type(),
+			cel_generic_cb,
+			NULL);
+	}
 
-	ret |= stasis_message_router_add(cel_state_router,
-		ast_blind_transfer_type(),
-		cel_blind_transfer_cb,
-		NULL);
+	if (events & ((int64_t) 1 << AST_CEL_BLINDTRANSFER)) {
+		ret |= stasis_message_router_add(cel_state_router,
+			ast_blind_transfer_type(),
+			cel_blind_transfer_cb,
+			NULL);
+	}
 
-	ret |= stasis_message_router_add(cel_state_router,
-		ast_attended_transfer_type(),
-		cel_attended_transfer_cb,
-		NULL);
+	if (events & ((int64_t) 1 << AST_CEL_ATTENDEDTRANSFER)) {
+		ret |= stasis_message_router_add(cel_state_router,
+			ast_attended_transfer_type(),
+			cel_attended_transfer_cb,
+			NULL);
+	}
 
-	ret |= stasis_message_router_add(cel_state_router,
-		ast_call_pickup_type(),
-		cel_pickup_cb,
-		NULL);
+	if (events & ((int64_t) 1 << AST_CEL_PICKUP)) {
+		ret |= stasis_message_router_add(cel_state_router,
+			ast_call_pickup_type(),
+			cel_pickup_cb,
+			NULL);
+	}
 
-	ret |= stasis_message_router_add(cel_state_router,
-		ast_local_optimization_end_type(),
-		cel_local_cb,
-		NULL);
+	if (events & ((int64_t) 1 << AST_CEL_LOCAL_OPTIMIZE)) {
+		ret |= stasis_message_router_add(cel_state_router,
+			ast_local_optimization_end_type(),
+			cel_local_cb,
+			NULL);
+	}
 
 	if (ret) {
 		ast_log(AST_LOG_ERROR, "Failed to register for Stasis messages\n");
@@ -1642,6 +1678,7 @@ static int load_module(void)
 static int reload_module(void)
 {
 	unsigned int was_enabled = ast_cel_check_enabled();
+	int64_t was_events = cel_tracked_events();
 	unsigned int is_enabled;
 
 	if (aco_process_config(&cel_cfg_info, 1) == ACO_PROCESS_ERROR) {
@@ -1656,6 +1693,13 @@ static int reload_module(void)
 		}
 	} else if (was_enabled && !is_enabled) {
 		destroy_routes();
+	} else if (is_enabled && was_events != cel_tracked_events()) {
+		/* The tracked events changed; rebuild the routes so untracked
+		 * types are no longer subscribed to at all. */
+		destroy_routes();
+		if (create_routes()) {
+			return -1;
+		}
 	}
 
 	ast_verb(3, "CEL logging %sabled.\n", is_enabled ? "en" : "dis");
@@ -1707,7 +1751,10 @@ void ast_cel_set_config(struct ast_cel_general_config *config)
 	struct cel_config *mod_cfg = ao2_global_obj_ref(cel_configs);
 
 	if (mod_cfg) {
+		int64_t was_events;
+
 		was_enabled = ast_cel_check_enabled();
+		was_events = cel_tracked_events();
 
 		cleanup_config = mod_cfg->general;
 		ao2_bump(config);
@@ -1719,6 +1766,9 @@ void ast_cel_set_config(struct ast_cel_general_config *config)
 			create_routes();
 		} else if (was_enabled && !is_enabled) {
 			destroy_routes();
+		} else if (is_enabled && was_events != cel_tracked_events()) {
+			destroy_routes();
+			create_routes();
 		}
 
 		ao2_ref(mod_cfg, -1);
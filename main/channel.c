@@ -34,6 +34,9 @@
 #include <sys/time.h>
 #include <signal.h>
 #include <math.h>
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #include "asterisk/paths.h"	/* use ast_config_AST_SYSTEM_NAME */
 
@@ -63,6 +66,7 @@
 #include "asterisk/audiohook.h"
 #include "asterisk/framehook.h"
 #include "asterisk/timing.h"
+#include "asterisk/latency_trace.h"
 #include "asterisk/autochan.h"
 #include "asterisk/stringfields.h"
 #include "asterisk/global_datastores.h"
@@ -123,6 +127,17 @@ static AST_RWLIST_HEAD_STATIC(backends, chanlist);
 /*! \brief All active channels on the system */
 static struct ao2_container *channels;
 
+/*!
+ * \brief Read-mostly index of active channels hashed by uniqueid.
+ *
+ * The main channels container hashes on name, so exact uniqueid lookups
+ * used to traverse every channel under the container lock.  This second
+ * container uses a read-write lock so concurrent lookups (AMI Status,
+ * CLI, dialplan CHANNEL()) never serialize against each other, and only
+ * channel creation/destruction takes the write lock briefly.
+ */
+static struct ao2_container *channels_by_uniqueid;
+
 /*! \brief map AST_CAUSE's to readable string representations
  *
  * \ref causes.h
@@ -711,13 +726,12 @@ static int ast_channel_by_uniqueid_cb(void *obj, void *arg, void *data, int flag
 static int does_id_conflict(const char *uniqueid)
 {
 	struct ast_channel *conflict;
-	size_t length = 0;
 
 	if (ast_strlen_zero(uniqueid)) {
 		return 0;
 	}
 
-	conflict = ast_channel_callback(ast_channel_by_uniqueid_cb, (char *) uniqueid, &length, OBJ_NOLOCK);
+	conflict = ao2_find(channels_by_uniqueid, uniqueid, OBJ_SEARCH_KEY);
 	if (conflict) {
 		ast_log(LOG_ERROR, "Channel Unique ID '%s' already in use by channel %s(%p)\n",
 			uniqueid, ast_channel_name(conflict), conflict);
@@ -933,6 +947,7 @@ __ast_channel_alloc_ap(int needqueue, int state, const char *cid_num, const char
 	ast_channel_internal_finalize(tmp);
 	ast_atomic_fetchadd_int(&chancount, +1);
 	ao2_link_flags(channels, tmp, OBJ_NOLOCK);
+	ao2_link(channels_by_uniqueid, tmp);
 
 	ao2_unlock(channels);
 
@@ -1018,6 +1033,13 @@ static int __ast_queue_frame(struct ast_channel *chan, struct ast_frame *fin, in
 
 	ast_channel_lock(chan);
 
+	/*
+	 * Collect any frames staged on the lock-free feeder first so the
+	 * readq stays ordered with respect to frames queued while we were
+	 * waiting for the lock.
+	 */
+	ast_channel_internal_fastq_collect(chan);
+
 	/*
 	 * Check the last frame on the queue if we are queuing the new
 	 * frames after it.
@@ -1098,6 +1120,9 @@ static int __ast_queue_frame(struct ast_channel *chan, struct ast_frame *fin, in
 			}
 		}
 		AST_LIST_TRAVERSE_SAFE_END;
+		if (count) {
+			ast_channel_drop_account(chan, AST_FRAME_DROP_READQ, count);
+		}
 	}
 
 	if (after) {
@@ -1111,13 +1136,10 @@ static int __ast_queue_frame(struct ast_channel *chan, struct ast_frame *fin, in
 	}
 
 	if (ast_channel_alert_writable(chan)) {
-		/* Write to the alert pipe for each added frame */
-		while (new_frames--) {
-			if (ast_channel_alert_write(chan)) {
-				ast_log(LOG_WARNING, "Unable to write to alert pipe on %s (qlen = %u): %s!\n",
-					ast_channel_name(chan), queued_frames, strerror(errno));
-				break;
-			}
+		/* Signal the alert pipe once for all added frames */
+		if (ast_channel_alert_write_count(chan, new_frames)) {
+			ast_log(LOG_WARNING, "Unable to write to alert pipe on %s (qlen = %u): %s!\n",
+				ast_channel_name(chan), queued_frames, strerror(errno));
 		}
 	} else if (ast_channel_timingfd(chan) > -1) {
 		ast_timer_enable_continuous(ast_channel_timer(chan));
@@ -1132,6 +1154,34 @@ static int __ast_queue_frame(struct ast_channel *chan, struct ast_frame *fin, in
 
 int ast_queue_frame(struct ast_channel *chan, struct ast_frame *fin)
 {
+	struct ast_frame *f;
+
+	/*
+	 * Single media frames take a lock-free shortcut onto the readq
+	 * staging queue so writers (typically RTP driver threads) never
+	 * contend with the channel thread draining the readq.  Control
+	 * frames, frame lists, and channels without an alert pipe keep
+	 * the fully ordered locked path.
+	 */
+	if ((fin->frametype == AST_FRAME_VOICE || fin->frametype == AST_FRAME_VIDEO)
+		&& !AST_LIST_NEXT(fin, frame_list)
+		&& ast_channel_alert_writable(chan)) {
+		if (!(f = ast_frdup(fin))) {
+			return -1;
+		}
+		if (ast_channel_internal_fastq_push(chan, f)) {
+			/* Staging queue is backed up; drop the frame just as
+			 * the locked path flushes excess media. */
+			ast_frfree(f);
+			return 0;
+		}
+		if (ast_channel_alert_write(chan)) {
+			ast_log(LOG_WARNING, "Unable to write to alert pipe on %s: %s!\n",
+				ast_channel_name(chan), strerror(errno));
+		}
+		return 0;
+	}
+
 	return __ast_queue_frame(chan, fin, 0, NULL);
 }
 
@@ -1425,6 +1475,29 @@ static int ast_channel_cmp_cb(void *obj, void *arg, int flags)
 	return CMP_STOP;
 }
 
+/*! \brief Hash function for the uniqueid channel index */
+static int ast_channel_uniqueid_hash_cb(const void *obj, const int flags)
+{
+	const char *uniqueid = (flags & OBJ_KEY)
+		? obj : ast_channel_uniqueid((struct ast_channel *) obj);
+
+	if (ast_strlen_zero(uniqueid)) {
+		return 0;
+	}
+
+	return ast_str_case_hash(uniqueid);
+}
+
+/*! \brief Comparison function for the uniqueid channel index */
+static int ast_channel_uniqueid_cmp_cb(void *obj, void *arg, int flags)
+{
+	struct ast_channel *chan = obj;
+	const char *uniqueid = (flags & OBJ_KEY)
+		? arg : ast_channel_uniqueid((struct ast_channel *) arg);
+
+	return strcasecmp(ast_channel_uniqueid(chan), uniqueid) ? 0 : CMP_MATCH;
+}
+
 struct ast_channel *ast_channel_get_by_name_prefix(const char *name, size_t name_len)
 {
 	struct ast_channel *chan;
@@ -1442,6 +1515,10 @@ struct ast_channel *ast_channel_get_by_name_prefix(const char *name, size_t name
 	}
 
 	/* Now try a search for uniqueid. */
+	if (!name_len) {
+		/* A complete uniqueid match is served by the index in O(1). */
+		return ao2_find(channels_by_uniqueid, l_name, OBJ_SEARCH_KEY);
+	}
 	return ast_channel_callback(ast_channel_by_uniqueid_cb, l_name, &name_len, 0);
 }
 
@@ -1579,6 +1656,7 @@ struct ast_channel *ast_channel_release(struct ast_channel *chan)
 {
 	/* Safe, even if already unlinked. */
 	ao2_unlink(channels, chan);
+	ao2_unlink(channels_by_uniqueid, chan);
 	return ast_channel_unref(chan);
 }
 
@@ -2284,6 +2362,7 @@ static void ast_channel_destructor(void *obj)
 		ast_timer_close(ast_channel_timer(chan));
 		ast_channel_timer_set(chan, NULL);
 	}
+	ast_channel_internal_fastq_collect(chan);
 	while ((f = AST_LIST_REMOVE_HEAD(ast_channel_readq(chan), frame_list)))
 		ast_frfree(f);
 
@@ -2326,6 +2405,15 @@ static void ast_channel_destructor(void *obj)
 	ast_channel_named_pickupgroups_set(chan, NULL);
 
 	ast_atomic_fetchadd_int(&chancount, -1);
+
+	/*
+	 * Replace this channel's shell in the warm pool while we are on the
+	 * teardown path.  Only do so for finalized channels; construction
+	 * error paths also land here and must not recurse into the pool.
+	 */
+	if (ast_channel_internal_is_finalized(chan)) {
+		ast_channel_internal_pool_refill(ast_channel_destructor);
+	}
 }
 
 /*! \brief Free a dummy channel structure */
@@ -2573,6 +2661,7 @@ void ast_hangup(struct ast_channel *chan)
 	 */
 	ast_pbx_hangup_handler_run(chan);
 	ao2_unlink(channels, chan);
+	ao2_unlink(channels_by_uniqueid, chan);
 	ast_channel_lock(chan);
 
 	destroy_hooks(chan);
@@ -2985,6 +3074,141 @@ int ast_waitfor_n_fd(int *fds, int n, int *ms, int *exception)
 	return winner;
 }
 
+#ifdef HAVE_EPOLL
+/*! Largest fd set serviced by the persistent epoll backend. */
+#define WAITFOR_EPOLL_MAX_FDS	32
+
+/*!
+ * \brief Per-thread persistent epoll state for waitfor_backend().
+ *
+ * A channel thread calls ast_waitfor_nandfds() every frame interval
+ * with an fd set that is nearly always identical to the previous call,
+ * so the registrations are kept between calls and only adjusted when
+ * the requested set changes.  An fd that is closed and reused with the
+ * same number between two calls with an otherwise unchanged set would
+ * go unnoticed; channel fd changes always alter the set (or are
+ * re-registered on the next composition change), so in practice the
+ * registrations only churn on channel setup/teardown.
+ */
+struct waitfor_epoll_state {
+	int epfd;
+	int nfds;				/*!< Number of fds currently registered */
+	int fds[WAITFOR_EPOLL_MAX_FDS];		/*!< Registered fd set, in request order */
+	unsigned int initialized:1;
+};
+
+static void waitfor_epoll_cleanup(void *data)
+{
+	struct waitfor_epoll_state *state = data;
+
+	if (state->initialized) {
+		close(state->epfd);
+	}
+	ast_free(state);
+}
+
+AST_THREADSTORAGE_CUSTOM(waitfor_epoll_storage, NULL, waitfor_epoll_cleanup);
+
+/*! \brief Drop all registrations from the persistent epoll set. */
+static void waitfor_epoll_flush(struct waitfor_epoll_state *state)
+{
+	int idx;
+
+	for (idx = 0; idx < state->nfds; idx++) {
+		/* ENOENT for duplicates or already closed fds is fine. */
+		epoll_ctl(state->epfd, EPOLL_CTL_DEL, state->fds[idx], NULL);
+	}
+	state->nfds = 0;
+}
+
+static int waitfor_epoll(struct pollfd *pfds, int nfds, int timeout)
+{
+	struct waitfor_epoll_state *state;
+	struct epoll_event events[WAITFOR_EPOLL_MAX_FDS];
+	int res;
+	int idx;
+	int x;
+	int changed;
+
+	state = ast_threadstorage_get(&waitfor_epoll_storage, sizeof(*state));
+	if (!state) {
+		return ast_poll(pfds, nfds, timeout);
+	}
+	if (!state->initialized) {
+		state->epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (state->epfd < 0) {
+			return ast_poll(pfds, nfds, timeout);
+		}
+		state->initialized = 1;
+	}
+
+	/* Adjust registrations only when the requested set changed. */
+	changed = state->nfds != nfds;
+	for (idx = 0; !changed && idx < nfds; idx++) {
+		changed = state->fds[idx] != pfds[idx].fd;
+	}
+	if (changed) {
+		waitfor_epoll_flush(state);
+		for (idx = 0; idx < nfds; idx++) {
+			struct epoll_event ev = {
+				.events = EPOLLIN | EPOLLPRI,
+				.data.fd = pfds[idx].fd,
+			};
+
+			if (epoll_ctl(state->epfd, EPOLL_CTL_ADD, pfds[idx].fd, &ev)
+				&& errno != EEXIST) {
+				/* Unpollable fd; hand the whole set to poll(). */
+				waitfor_epoll_flush(state);
+				return ast_poll(pfds, nfds, timeout);
+			}
+			state->fds[state->nfds++] = pfds[idx].fd;
+		}
+	}
+
+	/* Unlike poll(), epoll_wait() will not touch entries with no event. */
+	for (idx = 0; idx < nfds; idx++) {
+		pfds[idx].revents = 0;
+	}
+
+	res = epoll_wait(state->epfd, events, nfds, timeout);
+	if (res <= 0) {
+		return res;
+	}
+
+	/* Translate the results back into the pollfd array. */
+	for (idx = 0; idx < res; idx++) {
+		for (x = 0; x < nfds; x++) {
+			if (pfds[x].fd != events[idx].data.fd) {
+				continue;
+			}
+			pfds[x].revents =
+				((events[idx].events & EPOLLIN) ? POLLIN : 0)
+				| ((events[idx].events & EPOLLPRI) ? POLLPRI : 0)
+				| ((events[idx].events & EPOLLERR) ? POLLERR : 0)
+				| ((events[idx].events & EPOLLHUP) ? POLLHUP : 0);
+			break;
+		}
+	}
+
+	return res;
+}
+#endif	/* HAVE_EPOLL */
+
+/*!
+ * \internal
+ * \brief Wait on a built pollfd set, using the persistent epoll backend
+ * when available and the set is small enough to qualify.
+ */
+static int waitfor_backend(struct pollfd *pfds, int nfds, int timeout)
+{
+#ifdef HAVE_EPOLL
+	if (0 < nfds && nfds <= WAITFOR_EPOLL_MAX_FDS) {
+		return waitfor_epoll(pfds, nfds, timeout);
+	}
+#endif
+	return ast_poll(pfds, nfds, timeout);
+}
+
 /*! \brief Wait for x amount of time on a file descriptor to have input.  */
 struct ast_channel *ast_waitfor_nandfds(struct ast_channel **c, int n, int *fds, int nfds,
 					int *exception, int *outfd, int *ms)
@@ -3081,13 +3305,13 @@ struct ast_channel *ast_waitfor_nandfds(struct ast_channel **c, int n, int *fds,
 			if (kbrms > 600000) {
 				kbrms = 600000;
 			}
-			res = ast_poll(pfds, max, kbrms);
+			res = waitfor_backend(pfds, max, kbrms);
 			if (!res) {
 				rms -= kbrms;
 			}
 		} while (!res && (rms > 0));
 	} else {
-		res = ast_poll(pfds, max, rms);
+		res = waitfor_backend(pfds, max, rms);
 	}
 	for (x = 0; x < n; x++) {
 		ast_channel_lock(c[x]);
@@ -3534,6 +3758,9 @@ static struct ast_frame *__ast_read(struct ast_channel *chan, int dropaudio, int
 	 */
 	ast_channel_lock(chan);
 
+	/* Pull in anything staged on the lock-free readq feeder. */
+	ast_channel_internal_fastq_collect(chan);
+
 	/* Stop if we're a zombie or need a soft hangup */
 	if (ast_test_flag(ast_channel_flags(chan), AST_FLAG_ZOMBIE) || ast_check_hangup(chan)) {
 		if (ast_channel_generator(chan))
@@ -4291,12 +4518,141 @@ done:
 
 struct ast_frame *ast_read(struct ast_channel *chan)
 {
-	return __ast_read(chan, 0, 1);
+	struct ast_frame *f;
+	struct timeval trace_start = ast_latency_trace_start();
+
+	f = __ast_read(chan, 0, 1);
+	ast_latency_trace_end(AST_LATENCY_STAGE_READ, &trace_start);
+	return f;
 }
 
 struct ast_frame *ast_read_stream(struct ast_channel *chan)
 {
-	return __ast_read(chan, 0, 0);
+	struct ast_frame *f;
+	struct timeval trace_start = ast_latency_trace_start();
+
+	f = __ast_read(chan, 0, 0);
+	ast_latency_trace_end(AST_LATENCY_STAGE_READ, &trace_start);
+	return f;
+}
+
+static int __ast_read_batch(struct ast_channel *chan, struct ast_frame **batch, unsigned int max_frames, int dropnondefault)
+{
+	unsigned int count = 0;
+	struct ast_frame *f;
+
+	if (!max_frames) {
+		return 0;
+	}
+
+	f = __ast_read(chan, 0, dropnondefault);
+	if (!f) {
+		return -1;
+	}
+	batch[count++] = f;
+
+	/*
+	 * Opportunistically drain further queued media frames while the
+	 * lock is held once.  Only frames the read path would hand back
+	 * untouched qualify; anything needing the full machinery ends the
+	 * batch and is handled by the next read.  Queued frames from
+	 * multistream channel drivers already carry a valid stream_num.
+	 */
+	ast_channel_lock(chan);
+	ast_channel_internal_fastq_collect(chan);
+	if (!ast_channel_audiohooks(chan)
+		&& !ast_channel_generator(chan)
+		&& ast_framehook_list_is_empty(ast_channel_framehooks(chan))
+		&& !ast_test_flag(ast_channel_flags(chan), AST_FLAG_EMULATE_DTMF | AST_FLAG_IN_DTMF)) {
+		if (!ast_channel_readtrans(chan)) {
+			while (count < max_frames) {
+				f = AST_LIST_FIRST(ast_channel_readq(chan));
+				if (!f
+					|| f->frametype != AST_FRAME_VOICE
+					|| ast_format_cmp(f->subclass.format, ast_channel_readformat(chan)) != AST_FORMAT_CMP_EQUAL) {
+					break;
+				}
+				AST_LIST_REMOVE_HEAD(ast_channel_readq(chan), frame_list);
+
+				/* Keep the alert pipe balanced with the readq. */
+				ast_channel_internal_alert_read(chan);
+
+				ast_channel_fin_set(chan, FRAMECOUNT_INC(ast_channel_fin(chan)));
+				batch[count++] = f;
+			}
+		} else {
+			/*
+			 * Transcoded channel.  Pull a run of contiguous raw media
+			 * frames off the readq and push them through the translation
+			 * path as one chain, so the batch pays for a single pass over
+			 * the path instead of one per frame.  Frames carrying their
+			 * own timing are left for the regular read path since chain
+			 * translation predicts timing from the head frame only.
+			 */
+			struct ast_frame *chain = NULL, *tail = NULL;
+			unsigned int pulled = 0;
+
+			while (count + pulled < max_frames) {
+				f = AST_LIST_FIRST(ast_channel_readq(chan));
+				if (!f
+					|| f->frametype != AST_FRAME_VOICE
+					|| !f->datalen
+					|| !ast_tvzero(f->delivery)
+					|| ast_test_flag(f, AST_FRFLAG_HAS_TIMING_INFO)
+					|| ast_format_cmp(f->subclass.format, ast_channel_rawreadformat(chan)) != AST_FORMAT_CMP_EQUAL) {
+					break;
+				}
+				AST_LIST_REMOVE_HEAD(ast_channel_readq(chan), frame_list);
+
+				/* Keep the alert pipe balanced with the readq. */
+				ast_channel_internal_alert_read(chan);
+
+				ast_channel_fin_set(chan, FRAMECOUNT_INC(ast_channel_fin(chan)));
+				AST_LIST_NEXT(f, frame_list) = NULL;
+				if (tail) {
+					AST_LIST_NEXT(tail, frame_list) = f;
+				} else {
+					chain = f;
+				}
+				tail = f;
+				pulled++;
+			}
+			if (chain) {
+				f = ast_translate(ast_channel_readtrans(chan), chain, 1);
+				while (f && count < max_frames) {
+					struct ast_frame *next = AST_LIST_NEXT(f, frame_list);
+
+					AST_LIST_NEXT(f, frame_list) = NULL;
+					batch[count++] = f;
+					f = next;
+				}
+				if (f) {
+					/* The path produced more frames than we have room
+					 * for; put the leftovers back for the next read. */
+					struct ast_frame *cur;
+
+					for (cur = f; cur; cur = AST_LIST_NEXT(cur, frame_list)) {
+						ast_set_flag(cur, AST_FRFLAG_REQUEUED);
+					}
+					ast_queue_frame_head(chan, f);
+					ast_frfree(f);
+				}
+			}
+		}
+	}
+	ast_channel_unlock(chan);
+
+	return count;
+}
+
+int ast_read_batch(struct ast_channel *chan, struct ast_frame **batch, unsigned int max_frames)
+{
+	return __ast_read_batch(chan, batch, max_frames, 1);
+}
+
+int ast_read_stream_batch(struct ast_channel *chan, struct ast_frame **batch, unsigned int max_frames)
+{
+	return __ast_read_batch(chan, batch, max_frames, 0);
 }
 
 struct ast_frame *ast_read_noaudio(struct ast_channel *chan)
@@ -5178,7 +5534,12 @@ static int tech_write(struct ast_channel *chan, struct ast_stream *stream,
 
 int ast_write(struct ast_channel *chan, struct ast_frame *fr)
 {
-	return ast_write_stream(chan, -1, fr);
+	int res;
+	struct timeval trace_start = ast_latency_trace_start();
+
+	res = ast_write_stream(chan, -1, fr);
+	ast_latency_trace_end(AST_LATENCY_STAGE_WRITE, &trace_start);
+	return res;
 }
 
 int ast_write_stream(struct ast_channel *chan, int stream_num, struct ast_frame *fr)
@@ -6989,9 +7350,13 @@ static void channel_do_masquerade(struct ast_channel *original, struct ast_chann
 	ast_channel_ref(original);
 	ast_channel_ref(clonechan);
 
-	/* unlink from channels container as name (which is the hash value) will change */
+	/* unlink from channels container as name (which is the hash value) will change.
+	 * The uniqueids are swapped during the masquerade, so take both channels out
+	 * of the uniqueid index as well and re-add them when done. */
 	ao2_unlink(channels, original);
 	ao2_unlink(channels, clonechan);
+	ao2_unlink(channels_by_uniqueid, original);
+	ao2_unlink(channels_by_uniqueid, clonechan);
 
 	moh_is_playing = ast_test_flag(ast_channel_flags(original), AST_FLAG_MOH);
 	if (moh_is_playing) {
@@ -7068,6 +7433,16 @@ static void channel_do_masquerade(struct ast_channel *original, struct ast_chann
 	ast_channel_tech_pvt_set(original, ast_channel_tech_pvt(clonechan));
 	ast_channel_tech_pvt_set(clonechan, t_pvt);
 
+	/*
+	 * Flush both lock-free staging queues into their readqs before the
+	 * alert pipes and readqs are swapped.  Anything staged on the clone
+	 * during the masquerade window would otherwise be stranded there and
+	 * freed with it, while the matching alert pipe writes followed the
+	 * pipe to the surviving channel.
+	 */
+	ast_channel_internal_fastq_collect(original);
+	ast_channel_internal_fastq_collect(clonechan);
+
 	/* Swap the alertpipes */
 	ast_channel_internal_alertpipe_swap(original, clonechan);
 
@@ -7084,6 +7459,7 @@ static void channel_do_masquerade(struct ast_channel *original, struct ast_chann
 	 */
 	{
 		AST_LIST_HEAD_NOLOCK(, ast_frame) tmp_readq;
+		size_t poked = 0;
 
 		AST_LIST_HEAD_INIT_NOLOCK(&tmp_readq);
 		AST_LIST_APPEND_LIST(&tmp_readq, ast_channel_readq(original), frame_list);
@@ -7091,9 +7467,10 @@ static void channel_do_masquerade(struct ast_channel *original, struct ast_chann
 
 		while ((current = AST_LIST_REMOVE_HEAD(&tmp_readq, frame_list))) {
 			AST_LIST_INSERT_TAIL(ast_channel_readq(original), current, frame_list);
-			if (ast_channel_alert_write(original)) {
-				ast_log(LOG_WARNING, "write() failed: %s\n", strerror(errno));
-			}
+			poked++;
+		}
+		if (ast_channel_alert_write_count(original, poked)) {
+			ast_log(LOG_WARNING, "write() failed: %s\n", strerror(errno));
 		}
 	}
 
@@ -7404,6 +7781,8 @@ static void channel_do_masquerade(struct ast_channel *original, struct ast_chann
 
 	ao2_link(channels, clonechan);
 	ao2_link(channels, original);
+	ao2_link(channels_by_uniqueid, clonechan);
+	ao2_link(channels_by_uniqueid, original);
 	ao2_unlock(channels);
 
 	/* Release our held safety references. */
@@ -8075,6 +8454,8 @@ struct varshead *ast_channel_get_ari_vars(struct ast_channel *chan)
 
 static void channels_shutdown(void)
 {
+	ast_channel_internal_pool_shutdown();
+
 	free_external_channelvars(&ami_vars);
 	free_external_channelvars(&ari_vars);
 
@@ -8084,6 +8465,8 @@ static void channels_shutdown(void)
 		ao2_ref(channels, -1);
 		channels = NULL;
 	}
+	ao2_cleanup(channels_by_uniqueid);
+	channels_by_uniqueid = NULL;
 	ast_channel_unregister(&surrogate_tech);
 }
 
@@ -8096,10 +8479,19 @@ int ast_channels_init(void)
 	}
 	ao2_container_register("channels", channels, prnt_channel_key);
 
+	channels_by_uniqueid = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0,
+		AST_NUM_CHANNEL_BUCKETS, ast_channel_uniqueid_hash_cb, NULL,
+		ast_channel_uniqueid_cmp_cb);
+	if (!channels_by_uniqueid) {
+		return -1;
+	}
+
 	ast_channel_register(&surrogate_tech);
 
 	ast_stasis_channels_init();
 
+	ast_channel_internal_pool_prime(ast_channel_destructor);
+
 	ast_cli_register_multiple(cli_channel, ARRAY_LEN(cli_channel));
 
 	ast_register_cleanup(channels_shutdown);
@@ -10715,6 +11107,7 @@ int ast_channel_get_cc_agent_type(struct ast_channel *chan, char *agent_type, si
 void ast_channel_unlink(struct ast_channel *chan)
 {
 	ao2_unlink(channels, chan);
+	ao2_unlink(channels_by_uniqueid, chan);
 }
 
 struct ast_bridge *ast_channel_get_bridge(const struct ast_channel *chan)
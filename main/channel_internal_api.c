@@ -42,6 +42,7 @@
 #include "asterisk/channel_internal.h"
 #include "asterisk/endpoints.h"
 #include "asterisk/indications.h"
+#include "asterisk/options.h"
 #include "asterisk/stasis_channels.h"
 #include "asterisk/stasis_endpoints.h"
 #include "asterisk/stringfields.h"
@@ -156,6 +157,12 @@ struct ast_channel {
 	struct timeval creationtime;			/*!< The time of channel creation */
 	struct timeval answertime;				/*!< The time the channel was answered */
 	struct ast_readq_list readq;
+	struct {
+		struct ast_frame *head;		/*!< Consumer end; only touched by the channel thread */
+		struct ast_frame *tail;		/*!< Producer end; only ever swapped atomically */
+		struct ast_frame stub;		/*!< Sentinel node; never carries data */
+		int depth;			/*!< Approximate number of staged frames */
+	} fastq;				/*!< Lock-free MPSC staging queue feeding readq */
 	struct ast_jb jb;				/*!< The jitterbuffer state */
 	struct timeval dtmf_tv;				/*!< The time that an in process digit began, or the last digit ended */
 	struct ast_hangup_handler_list hangup_handlers;/*!< Hangup handlers on the channel. */
@@ -185,6 +192,7 @@ struct ast_channel {
 							 *   the counter is only in the remaining bits */
 	unsigned int fout;				/*!< Frames out counters. The high bit is a debug mask, so
 							 *   the counter is only in the remaining bits */
+	int frame_drops[AST_FRAME_DROP_CAUSE_COUNT];	/*!< Media frames dropped by the core, by cause */
 	int hangupcause;				/*!< Why is the channel hanged up. See causes.h */
 	unsigned int finalized:1;       /*!< Whether or not the channel has been successfully allocated */
 	struct ast_flags flags;				/*!< channel flags of AST_FLAG_ type */
@@ -224,6 +232,7 @@ struct ast_channel {
 	struct ast_stream *default_streams[AST_MEDIA_TYPE_END]; /*!< Default streams indexed by media type */
 	struct ast_channel_snapshot *snapshot; /*!< The current up to date snapshot of the channel */
 	struct ast_flags snapshot_segment_flags; /*!< Flags regarding the segments of the snapshot */
+	struct timeval snapshot_publish_time; /*!< The time the snapshot was last published */
 };
 
 /*! \brief The monotonically increasing integer counter for channel uniqueids */
@@ -548,6 +557,39 @@ void ast_channel_fout_set(struct ast_channel *chan, unsigned int value)
 {
 	chan->fout = value;
 }
+
+/*! Media frames dropped across all channels, by cause. */
+static int global_frame_drops[AST_FRAME_DROP_CAUSE_COUNT];
+
+void ast_channel_drop_account(struct ast_channel *chan, enum ast_frame_drop_cause cause, unsigned int count)
+{
+	/* Updated atomically since some accounting sites (bridge mixing
+	 * threads) run without the channel lock. */
+	ast_atomic_fetchadd_int(&chan->frame_drops[cause], count);
+	ast_atomic_fetchadd_int(&global_frame_drops[cause], count);
+}
+unsigned int ast_channel_drops(const struct ast_channel *chan, enum ast_frame_drop_cause cause)
+{
+	return chan->frame_drops[cause];
+}
+unsigned int ast_frame_drops_global(enum ast_frame_drop_cause cause)
+{
+	return ast_atomic_fetchadd_int(&global_frame_drops[cause], 0);
+}
+const char *ast_frame_drop_cause_name(enum ast_frame_drop_cause cause)
+{
+	switch (cause) {
+	case AST_FRAME_DROP_READQ:
+		return "readq";
+	case AST_FRAME_DROP_JITTERBUFFER:
+		return "jitterbuffer";
+	case AST_FRAME_DROP_MIXING:
+		return "mixing";
+	case AST_FRAME_DROP_CAUSE_COUNT:
+		break;
+	}
+	return "unknown";
+}
 unsigned long ast_channel_insmpl(const struct ast_channel *chan)
 {
 	return chan->insmpl;
@@ -898,6 +940,104 @@ struct ast_readq_list *ast_channel_readq(struct ast_channel *chan)
 {
 	return &chan->readq;
 }
+void ast_channel_internal_fastq_init(struct ast_channel *chan)
+{
+	chan->fastq.stub.frame_list.next = NULL;
+	chan->fastq.head = &chan->fastq.stub;
+	chan->fastq.tail = &chan->fastq.stub;
+	chan->fastq.depth = 0;
+}
+int ast_channel_internal_fastq_push(struct ast_channel *chan, struct ast_frame *f)
+{
+	struct ast_frame *prev;
+
+	if (ast_atomic_fetch_add(&chan->fastq.depth, 1, __ATOMIC_RELAXED) >= AST_CHANNEL_MAX_QUEUED_FRAMES) {
+		ast_atomic_fetch_sub(&chan->fastq.depth, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+
+	f->frame_list.next = NULL;
+	prev = ast_atomic_exchange_n(&chan->fastq.tail, f, __ATOMIC_ACQ_REL);
+	ast_atomic_store_n(&prev->frame_list.next, f, __ATOMIC_RELEASE);
+	return 0;
+}
+/*!
+ * \internal
+ * \brief Dequeue a single staged frame (Vyukov MPSC pop).
+ *
+ * Must only ever be called from the queue's single consumer.  Returns
+ * NULL when the queue is empty or a producer has swapped the tail but
+ * not yet linked its node; in the latter case the frame is simply
+ * picked up on the next collect.
+ */
+static struct ast_frame *fastq_pop(struct ast_channel *chan)
+{
+	struct ast_frame *head = chan->fastq.head;
+	struct ast_frame *next = ast_atomic_load_n(&head->frame_list.next, __ATOMIC_ACQUIRE);
+	struct ast_frame *prev;
+
+	if (head == &chan->fastq.stub) {
+		if (!next) {
+			return NULL;
+		}
+		chan->fastq.head = next;
+		head = next;
+		next = ast_atomic_load_n(&head->frame_list.next, __ATOMIC_ACQUIRE);
+	}
+	if (next) {
+		chan->fastq.head = next;
+		head->frame_list.next = NULL;
+		return head;
+	}
+	if (head != ast_atomic_load_n(&chan->fastq.tail, __ATOMIC_ACQUIRE)) {
+		/* Producer in flight between the exchange and the link. */
+		return NULL;
+	}
+
+	/* Re-insert the stub so the queue is never fully empty. */
+	chan->fastq.stub.frame_list.next = NULL;
+	prev = ast_atomic_exchange_n(&chan->fastq.tail, &chan->fastq.stub, __ATOMIC_ACQ_REL);
+	ast_atomic_store_n(&prev->frame_list.next, &chan->fastq.stub, __ATOMIC_RELEASE);
+
+	next = ast_atomic_load_n(&head->frame_list.next, __ATOMIC_ACQUIRE);
+	if (next) {
+		chan->fastq.head = next;
+		head->frame_list.next = NULL;
+		return head;
+	}
+	return NULL;
+}
+int ast_channel_internal_fastq_collect(struct ast_channel *chan)
+{
+	struct ast_frame *f;
+	struct ast_frame *tail;
+	int refuse;
+	int collected = 0;
+
+	/*
+	 * Once a hangup or end-of-Q marker is the last frame on the readq
+	 * the locked queueing path refuses to append anything after it.
+	 * Media staged by producers that raced the hangup must get the
+	 * same treatment instead of landing past the marker.
+	 */
+	tail = AST_LIST_LAST(&chan->readq);
+	refuse = tail && tail->frametype == AST_FRAME_CONTROL
+		&& (tail->subclass.integer == AST_CONTROL_END_OF_Q
+			|| tail->subclass.integer == AST_CONTROL_HANGUP);
+
+	while ((f = fastq_pop(chan))) {
+		ast_atomic_fetch_sub(&chan->fastq.depth, 1, __ATOMIC_RELAXED);
+		if (refuse) {
+			/* Balance the alert pipe write made when the frame was staged. */
+			ast_channel_internal_alert_read(chan);
+			ast_frfree(f);
+			continue;
+		}
+		AST_LIST_INSERT_TAIL(&chan->readq, f, frame_list);
+		++collected;
+	}
+	return collected;
+}
 struct ast_frame *ast_channel_dtmff(struct ast_channel *chan)
 {
 	return &chan->dtmff;
@@ -1133,6 +1273,11 @@ int ast_channel_alert_write(struct ast_channel *chan)
 	return ast_alertpipe_write(chan->alertpipe);
 }
 
+int ast_channel_alert_write_count(struct ast_channel *chan, size_t count)
+{
+	return ast_alertpipe_write_count(chan->alertpipe, count);
+}
+
 ast_alert_status_t ast_channel_internal_alert_flush(struct ast_channel *chan)
 {
 	return ast_alertpipe_flush(chan->alertpipe);
@@ -1349,7 +1494,15 @@ static int pvt_cause_cmp_fn(void *obj, void *vstr, int flags)
 
 #define DIALED_CAUSES_BUCKETS 37
 
-struct ast_channel *__ast_channel_internal_alloc(void (*destructor)(void *obj), const struct ast_assigned_ids *assignedids, const struct ast_channel *requestor, const char *file, int line, const char *function)
+/*!
+ * \internal
+ * \brief Construct an empty channel shell.
+ *
+ * A shell is a channel with every per-channel allocation made
+ * (astobj2 object, stringfields, dialed causes container, fd vector,
+ * frame staging queue) but no per-call identity yet.
+ */
+static struct ast_channel *channel_shell_alloc(void (*destructor)(void *obj), const char *file, int line, const char *function)
 {
 	struct ast_channel *tmp;
 
@@ -1370,6 +1523,131 @@ struct ast_channel *__ast_channel_internal_alloc(void (*destructor)(void *obj),
 		return ast_channel_unref(tmp);
 	}
 
+	AST_VECTOR_INIT(&tmp->fds, AST_MAX_FDS);
+
+	ast_channel_internal_fastq_init(tmp);
+
+	return tmp;
+}
+
+/*!
+ * Warm pool of pre-constructed channel shells.  Shells are built ahead
+ * of time (at startup and on the teardown path of dying channels) so
+ * that call setup bursts do not hit the allocator a dozen times per
+ * channel.  All pooled shells share one destructor; allocations with a
+ * different destructor (e.g. dummy channels) bypass the pool.
+ */
+AST_MUTEX_DEFINE_STATIC(channel_shell_pool_lock);
+static struct ast_channel **channel_shell_pool;
+static int channel_shell_pool_count;
+static void (*channel_shell_pool_destructor)(void *obj);
+
+static struct ast_channel *channel_shell_pool_get(void (*destructor)(void *obj))
+{
+	struct ast_channel *tmp = NULL;
+
+	ast_mutex_lock(&channel_shell_pool_lock);
+	if (channel_shell_pool_count && channel_shell_pool_destructor == destructor) {
+		tmp = channel_shell_pool[--channel_shell_pool_count];
+	}
+	ast_mutex_unlock(&channel_shell_pool_lock);
+
+	return tmp;
+}
+
+void ast_channel_internal_pool_prime(void (*destructor)(void *obj))
+{
+	int idx;
+
+	if (ast_option_channel_pool_size <= 0) {
+		return;
+	}
+
+	ast_mutex_lock(&channel_shell_pool_lock);
+	channel_shell_pool = ast_calloc(ast_option_channel_pool_size,
+		sizeof(*channel_shell_pool));
+	if (!channel_shell_pool) {
+		ast_mutex_unlock(&channel_shell_pool_lock);
+		return;
+	}
+	channel_shell_pool_destructor = destructor;
+	for (idx = 0; idx < ast_option_channel_pool_size; ++idx) {
+		struct ast_channel *tmp;
+
+		tmp = channel_shell_alloc(destructor, __FILE__, __LINE__, __PRETTY_FUNCTION__);
+		if (!tmp) {
+			break;
+		}
+		channel_shell_pool[channel_shell_pool_count++] = tmp;
+	}
+	ast_mutex_unlock(&channel_shell_pool_lock);
+}
+
+void ast_channel_internal_pool_refill(void (*destructor)(void *obj))
+{
+	struct ast_channel *tmp;
+	int wanted;
+
+	ast_mutex_lock(&channel_shell_pool_lock);
+	wanted = channel_shell_pool
+		&& channel_shell_pool_destructor == destructor
+		&& channel_shell_pool_count < ast_option_channel_pool_size;
+	ast_mutex_unlock(&channel_shell_pool_lock);
+	if (!wanted) {
+		return;
+	}
+
+	tmp = channel_shell_alloc(destructor, __FILE__, __LINE__, __PRETTY_FUNCTION__);
+	if (!tmp) {
+		return;
+	}
+
+	ast_mutex_lock(&channel_shell_pool_lock);
+	if (channel_shell_pool
+		&& channel_shell_pool_count < ast_option_channel_pool_size) {
+		channel_shell_pool[channel_shell_pool_count++] = tmp;
+		tmp = NULL;
+	}
+	ast_mutex_unlock(&channel_shell_pool_lock);
+	if (tmp) {
+		/* The pool filled up (or shut down) while we were constructing. */
+		ast_channel_unref(tmp);
+	}
+}
+
+void ast_channel_internal_pool_shutdown(void)
+{
+	struct ast_channel **pool;
+	int count;
+
+	ast_mutex_lock(&channel_shell_pool_lock);
+	pool = channel_shell_pool;
+	count = channel_shell_pool_count;
+	channel_shell_pool = NULL;
+	channel_shell_pool_count = 0;
+	ast_mutex_unlock(&channel_shell_pool_lock);
+
+	if (!pool) {
+		return;
+	}
+	while (count) {
+		ast_channel_unref(pool[--count]);
+	}
+	ast_free(pool);
+}
+
+struct ast_channel *__ast_channel_internal_alloc(void (*destructor)(void *obj), const struct ast_assigned_ids *assignedids, const struct ast_channel *requestor, const char *file, int line, const char *function)
+{
+	struct ast_channel *tmp;
+
+	tmp = channel_shell_pool_get(destructor);
+	if (!tmp) {
+		tmp = channel_shell_alloc(destructor, file, line, function);
+		if (!tmp) {
+			return NULL;
+		}
+	}
+
 	/* set the creation time in the uniqueid */
 	tmp->uniqueid.creation_time = time(NULL);
 	tmp->uniqueid.creation_unique = ast_atomic_fetchadd_int(&uniqueint, 1);
@@ -1395,8 +1673,6 @@ struct ast_channel *__ast_channel_internal_alloc(void (*destructor)(void *obj),
 		tmp->linkedid = tmp->uniqueid;
 	}
 
-	AST_VECTOR_INIT(&tmp->fds, AST_MAX_FDS);
-
 	/* Force all channel snapshot segments to be created on first use, so we don't have to check if
 	 * an old snapshot exists.
 	 */
@@ -1681,3 +1957,13 @@ struct ast_flags *ast_channel_snapshot_segment_flags(struct ast_channel *chan)
 {
 	return &chan->snapshot_segment_flags;
 }
+
+struct timeval ast_channel_snapshot_publish_time(const struct ast_channel *chan)
+{
+	return chan->snapshot_publish_time;
+}
+
+void ast_channel_snapshot_publish_time_set(struct ast_channel *chan, struct timeval value)
+{
+	chan->snapshot_publish_time = value;
+}
@@ -94,6 +94,34 @@ char *ast_var_find(const struct varshead *head, const char *name)
 	return NULL;
 }
 
+/*! \brief How deep a hit has to sit in the list before it gets promoted */
+#define VAR_FIND_PROMOTE_DEPTH 8
+
+struct ast_var_t *ast_var_list_find(struct varshead *head, const char *name)
+{
+	struct ast_var_t *var;
+	int depth = 0;
+
+	AST_LIST_TRAVERSE_SAFE_BEGIN(head, var, entries) {
+		if (!strcmp(ast_var_name(var), name)) {
+			if (depth >= VAR_FIND_PROMOTE_DEPTH) {
+				/* Move hot variables to the front so repeated reads
+				 * on long lists stop paying the full scan.  Only the
+				 * first match moves, so it stays ahead of any entry
+				 * it was already shadowing.
+				 */
+				AST_LIST_REMOVE_CURRENT(entries);
+				AST_LIST_INSERT_HEAD(head, var, entries);
+			}
+			break;
+		}
+		++depth;
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+
+	return var;
+}
+
 struct varshead *ast_var_list_create(void)
 {
 	struct varshead *head;
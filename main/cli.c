@@ -905,6 +905,24 @@ static int modlist_modentry(const char *module, const char *description,
 	return 0;
 }
 
+#define MODTIMES_FORMAT  "%-40s %15.1f %-11s\n"
+#define MODTIMES_FORMAT2 "%-40s %15s %-11s\n"
+
+/*! \brief Running total of load times, protected by climodentrylock */
+static int64_t climodtimetotal;
+
+static int modtimes_modentry(const char *module, int64_t load_time_us,
+		const char *status, const char *like)
+{
+	/* Comparing the like with the module */
+	if (strcasestr(module, like)) {
+		ast_cli(climodentryfd, MODTIMES_FORMAT, module, load_time_us / 1000.0, status);
+		climodtimetotal += load_time_us;
+		return 1;
+	}
+	return 0;
+}
+
 static void print_uptimestr(int fd, struct timeval timeval, const char *prefix, int printsec)
 {
 	int x; /* the main part - years, weeks, etc. */
@@ -1040,6 +1058,50 @@ static char *handle_modlist(struct ast_cli_entry *e, int cmd, struct ast_cli_arg
 #undef MODLIST_FORMAT
 #undef MODLIST_FORMAT2
 
+static char *handle_modtimes(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	const char *like;
+	int mods;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "module show load-times [like]";
+		e->usage =
+			"Usage: module show load-times [like keyword]\n"
+			"       Shows how long each module's load function took during its most\n"
+			"       recent load, so slow initializers dominating startup time can be\n"
+			"       identified.\n";
+		return NULL;
+
+	case CLI_GENERATE:
+		if (a->pos == e->args) {
+			return ast_module_helper(a->line, a->word, a->pos, a->n, a->pos, AST_MODULE_HELPER_LOADED);
+		} else {
+			return NULL;
+		}
+	}
+
+	if (a->argc == e->args - 1)
+		like = "";
+	else if (a->argc == e->args + 1 && !strcasecmp(a->argv[e->args-1], "like") )
+		like = a->argv[e->args];
+	else
+		return CLI_SHOWUSAGE;
+
+	ast_mutex_lock(&climodentrylock);
+	climodentryfd = a->fd; /* global, protected by climodentrylock */
+	climodtimetotal = 0;
+	ast_cli(a->fd, MODTIMES_FORMAT2, "Module", "Load Time (ms)", "Status");
+	mods = ast_update_module_list_times(modtimes_modentry, like);
+	ast_cli(a->fd, "%d modules loaded, %.1f ms total load time\n", mods,
+		climodtimetotal / 1000.0);
+	climodentryfd = -1;
+	ast_mutex_unlock(&climodentrylock);
+	return CLI_SUCCESS;
+}
+#undef MODTIMES_FORMAT
+#undef MODTIMES_FORMAT2
+
 static char *handle_showcalls(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
 {
 	static const char * const completions[] = { "seconds", NULL };
@@ -1139,21 +1201,27 @@ static char *handle_chanlist(struct ast_cli_entry *e, int cmd, struct ast_cli_ar
 	} else if (a->argc != e->args - 1)
 		return CLI_SHOWUSAGE;
 
-	channels = ast_channel_cache_by_name();
-
 	if (!count) {
+		/* Clone the cache so slow console writes while formatting do
+		 * not contend with snapshot publishing on the live container. */
+		struct ao2_container *cached = ast_channel_cache_by_name();
+
+		channels = ao2_container_clone(cached, 0);
+		ao2_ref(cached, -1);
+		if (!channels) {
+			ast_cli(a->fd, "Failed to retrieve the channel list\n");
+			return CLI_SUCCESS;
+		}
+
 		if (!concise && !verbose)
 			ast_cli(a->fd, FORMAT_STRING2, "Channel", "Location", "State", "Application(Data)");
 		else if (verbose)
 			ast_cli(a->fd, VERBOSE_FORMAT_STRING2, "Channel", "Context", "Extension", "Priority", "State", "Application", "Data",
 				"CallerID", "Duration", "Accountcode", "PeerAccount", "BridgeID");
-	}
+		it_chans = ao2_iterator_init(channels, 0);
+		for (; (cs = ao2_iterator_next(&it_chans)); ao2_ref(cs, -1)) {
+			char durbuf[16] = "-";
 
-	it_chans = ao2_iterator_init(channels, 0);
-	for (; (cs = ao2_iterator_next(&it_chans)); ao2_ref(cs, -1)) {
-		char durbuf[16] = "-";
-
-		if (!count) {
 			if ((concise || verbose)  && !ast_tvzero(cs->base->creationtime)) {
 				int duration = (int)(ast_tvdiff_ms(ast_tvnow(), cs->base->creationtime) / 1000);
 				if (verbose) {
@@ -1198,8 +1266,9 @@ static char *handle_chanlist(struct ast_cli_entry *e, int cmd, struct ast_cli_ar
 				ast_cli(a->fd, FORMAT_STRING, cs->base->name, locbuf, ast_state2str(cs->state), appdata);
 			}
 		}
+		ao2_iterator_destroy(&it_chans);
+		ao2_ref(channels, -1);
 	}
-	ao2_iterator_destroy(&it_chans);
 
 	if (!concise) {
 		numchans = ast_active_channels();
@@ -1213,7 +1282,6 @@ static char *handle_chanlist(struct ast_cli_entry *e, int cmd, struct ast_cli_ar
 
 		ast_cli(a->fd, "%d call%s processed\n", ast_processed_calls(), ESS(ast_processed_calls()));
 	}
-	ao2_ref(channels, -1);
 
 	return CLI_SUCCESS;
 
@@ -2040,6 +2108,8 @@ static struct ast_cli_entry cli_cli[] = {
 
 	AST_CLI_DEFINE(handle_modlist, "List modules and info"),
 
+	AST_CLI_DEFINE(handle_modtimes, "List modules and their load times"),
+
 	AST_CLI_DEFINE(handle_load, "Load a module by name"),
 
 	AST_CLI_DEFINE(handle_reload, "Reload configuration for a module"),
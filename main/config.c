@@ -1729,6 +1729,44 @@ static void config_cache_destroy_entry(struct cache_file_mtime *cfmtime)
 	ast_free(cfmtime);
 }
 
+/*!
+ * \internal
+ * \brief Find the config cache entry for the filename and who_asked.
+ *
+ * \param filename Config filename.
+ * \param who_asked Which module asked.
+ *
+ * \note cfmtime_head must be locked.
+ *
+ * \note The cache list is kept sorted by filename (AST_LIST_INSERT_SORTALPHA)
+ * so the scan can stop as soon as it has passed where the entry would have to
+ * be.  With a config tree made of hundreds of include fragments each probed
+ * on every reload, scanning the whole cache per fragment adds up quickly.
+ *
+ * \retval cache-entry on success.
+ * \retval NULL on error.
+ */
+static struct cache_file_mtime *config_cache_find(const char *filename, const char *who_asked)
+{
+	struct cache_file_mtime *cfmtime;
+
+	AST_LIST_TRAVERSE(&cfmtime_head, cfmtime, list) {
+		int cmp = strcmp(cfmtime->filename, filename);
+
+		if (cmp < 0) {
+			continue;
+		}
+		if (cmp > 0) {
+			/* Past the sorted position so the entry cannot exist. */
+			return NULL;
+		}
+		if (!strcmp(cfmtime->who_asked, who_asked)) {
+			return cfmtime;
+		}
+	}
+	return NULL;
+}
+
 /*!
  * \internal
  * \brief Remove and destroy the config cache entry for the filename and who_asked.
@@ -1760,10 +1798,7 @@ static void config_cache_attribute(const char *configfile, enum config_cache_att
 
 	/* Find our cached entry for this configuration file */
 	AST_LIST_LOCK(&cfmtime_head);
-	AST_LIST_TRAVERSE(&cfmtime_head, cfmtime, list) {
-		if (!strcmp(cfmtime->filename, configfile) && !strcmp(cfmtime->who_asked, who_asked))
-			break;
-	}
+	cfmtime = config_cache_find(configfile, who_asked);
 	if (!cfmtime) {
 		cfmtime = cfmtime_new(configfile, who_asked);
 		if (!cfmtime) {
@@ -2204,11 +2239,7 @@ static struct ast_config *config_text_file_load(const char *database, const char
 				if (!ast_test_flag(&flags, CONFIG_FLAG_NOCACHE)) {
 					/* Find our cached entry for this configuration file */
 					AST_LIST_LOCK(&cfmtime_head);
-					AST_LIST_TRAVERSE(&cfmtime_head, cfmtime, list) {
-						if (!strcmp(cfmtime->filename, fn) && !strcmp(cfmtime->who_asked, who_asked)) {
-							break;
-						}
-					}
+					cfmtime = config_cache_find(fn, who_asked);
 					if (!cfmtime) {
 						cfmtime = cfmtime_new(fn, who_asked);
 						if (!cfmtime) {
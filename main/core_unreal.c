@@ -251,33 +251,6 @@ static int unreal_queue_frame(struct ast_unreal_pvt *p, int isoutbound, struct a
 	return 0;
 }
 
-int ast_unreal_answer(struct ast_channel *ast)
-{
-	struct ast_unreal_pvt *p = ast_channel_tech_pvt(ast);
-	int isoutbound;
-	int res = -1;
-
-	if (!p) {
-		return -1;
-	}
-
-	ao2_ref(p, 1);
-	ao2_lock(p);
-	isoutbound = AST_UNREAL_IS_OUTBOUND(ast, p);
-	if (isoutbound) {
-		/* Pass along answer since somebody answered us */
-		struct ast_frame answer = { AST_FRAME_CONTROL, { AST_CONTROL_ANSWER } };
-
-		res = unreal_queue_frame(p, isoutbound, &answer, ast, 1);
-	} else {
-		ast_log(LOG_WARNING, "Huh?  %s is being asked to answer?\n",
-			ast_channel_name(ast));
-	}
-	ao2_unlock(p);
-	ao2_ref(p, -1);
-	return res;
-}
-
 /*!
  * \internal
  * \brief Check and optimize out the unreal channels between bridges.
@@ -310,6 +283,41 @@ static int got_optimized_out(struct ast_channel *ast, struct ast_unreal_pvt *p)
 	return res;
 }
 
+int ast_unreal_answer(struct ast_channel *ast)
+{
+	struct ast_unreal_pvt *p = ast_channel_tech_pvt(ast);
+	int isoutbound;
+	int res = -1;
+
+	if (!p) {
+		return -1;
+	}
+
+	ao2_ref(p, 1);
+	ao2_lock(p);
+	isoutbound = AST_UNREAL_IS_OUTBOUND(ast, p);
+	if (isoutbound) {
+		/* Pass along answer since somebody answered us */
+		struct ast_frame answer = { AST_FRAME_CONTROL, { AST_CONTROL_ANSWER } };
+
+		res = unreal_queue_frame(p, isoutbound, &answer, ast, 1);
+		if (!res) {
+			/*
+			 * If both halves are already in bridges, collapse the
+			 * pair right away instead of shadowing media frames
+			 * until the write path notices.
+			 */
+			got_optimized_out(ast, p);
+		}
+	} else {
+		ast_log(LOG_WARNING, "Huh?  %s is being asked to answer?\n",
+			ast_channel_name(ast));
+	}
+	ao2_unlock(p);
+	ao2_ref(p, -1);
+	return res;
+}
+
 struct ast_frame  *ast_unreal_read(struct ast_channel *ast)
 {
 	return &ast_null_frame;
@@ -675,6 +683,22 @@ int ast_unreal_indicate(struct ast_channel *ast, int condition, const void *data
 		unreal_queue_indicate(p, ast, condition, data, datalen);
 		res = -1;
 		break;
+	case AST_CONTROL_SRCUPDATE:
+	case AST_CONTROL_SRCCHANGE:
+		/*
+		 * The bridge sends a source update when a channel joins, which
+		 * is the earliest point both halves of the pair can be in
+		 * bridges.  Try to optimize out now so media never has to be
+		 * shadowed through the pair at all.
+		 */
+		ao2_lock(p);
+		if (got_optimized_out(ast, p)) {
+			ao2_unlock(p);
+			break;
+		}
+		ao2_unlock(p);
+		res = unreal_queue_indicate(p, ast, condition, data, datalen);
+		break;
 	case AST_CONTROL_STREAM_TOPOLOGY_REQUEST_CHANGE:
 		if (ast_channel_is_multistream(ast)) {
 			res = unreal_colp_stream_topology_request_change(p, ast, data);
@@ -48,6 +48,7 @@
 #include "asterisk/app.h"
 #include "asterisk/dsp.h"
 #include "asterisk/astdb.h"
+#include "asterisk/astobj2.h"
 #include "asterisk/cli.h"
 #include "asterisk/utils.h"
 #include "asterisk/manager.h"
@@ -113,6 +114,72 @@ static int doexit;
 static int dosync;
 
 static void db_sync(void);
+static int db_execute_sql(const char *sql, int (*callback)(void *, int, char **, char **), void *arg);
+
+/*! \brief Number of hash buckets for the in-memory key cache */
+#define DB_CACHE_BUCKETS 563
+
+/*!
+ * \brief In-memory read-through cache of database values.
+ *
+ * Entries are keyed by the full database key and added on both reads and
+ * writes, so hot keys (device state, registrations) are answered without
+ * touching SQLite.  Every path that mutates the database runs in this file
+ * with \ref dblock held and keeps the cache coherent, which is also why the
+ * container itself needs no lock of its own.
+ */
+static struct ao2_container *db_cache;
+
+struct db_cache_entry {
+	/*! Cached value; points into the same allocation as the key */
+	char *value;
+	/*! Full database key */
+	char key[0];
+};
+
+AO2_STRING_FIELD_HASH_FN(db_cache_entry, key)
+AO2_STRING_FIELD_CMP_FN(db_cache_entry, key)
+
+/*! \note dblock must be held */
+static void db_cache_remove(const char *fullkey)
+{
+	if (db_cache) {
+		ao2_find(db_cache, fullkey, OBJ_SEARCH_KEY | OBJ_UNLINK | OBJ_NODATA);
+	}
+}
+
+/*! \note dblock must be held */
+static void db_cache_update(const char *fullkey, size_t fullkey_len, const char *value)
+{
+	struct db_cache_entry *entry;
+	size_t value_len;
+
+	if (!db_cache) {
+		return;
+	}
+
+	db_cache_remove(fullkey);
+
+	value_len = strlen(value) + 1;
+	entry = ao2_alloc_options(sizeof(*entry) + fullkey_len + 1 + value_len,
+		NULL, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!entry) {
+		return;
+	}
+	memcpy(entry->key, fullkey, fullkey_len + 1);
+	entry->value = entry->key + fullkey_len + 1;
+	memcpy(entry->value, value, value_len);
+	ao2_link(db_cache, entry);
+	ao2_ref(entry, -1);
+}
+
+/*! \note dblock must be held */
+static void db_cache_flush(void)
+{
+	if (db_cache) {
+		ao2_callback(db_cache, OBJ_UNLINK | OBJ_NODATA | OBJ_MULTIPLE, NULL, NULL);
+	}
+}
 
 #define DEFINE_SQL_STATEMENT(stmt,sql) static sqlite3_stmt *stmt; \
 	const char stmt##_sql[] = sql;
@@ -274,6 +341,17 @@ static int db_open(void)
 		return -1;
 	}
 
+	/* Use write-ahead logging so the sync thread's grouped commits are a
+	 * single sequential append instead of rollback journal churn, and relax
+	 * synchronous to NORMAL which WAL guarantees is corruption safe.  A
+	 * failure here (e.g. the database living on a filesystem that cannot
+	 * support WAL) is not fatal; we just keep the default journal mode. */
+	if (db_execute_sql("PRAGMA journal_mode = WAL", NULL, NULL)) {
+		ast_log(LOG_NOTICE, "Unable to enable WAL journaling on Asterisk database '%s'\n", dbname);
+	} else if (db_execute_sql("PRAGMA synchronous = NORMAL", NULL, NULL)) {
+		ast_log(LOG_NOTICE, "Unable to relax synchronous mode on Asterisk database '%s'\n", dbname);
+	}
+
 	ast_mutex_unlock(&dblock);
 
 	return 0;
@@ -289,6 +367,11 @@ static int db_init(void)
 		return -1;
 	}
 
+	/* A failed cache allocation is not fatal; reads simply all go to
+	 * SQLite. */
+	db_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_NOLOCK, 0,
+		DB_CACHE_BUCKETS, db_cache_entry_hash_fn, NULL, db_cache_entry_cmp_fn);
+
 	return 0;
 }
 
@@ -349,6 +432,10 @@ int ast_db_put(const char *family, const char *key, const char *value)
 		res = -1;
 	}
 
+	if (!res) {
+		db_cache_update(fullkey, fullkey_len, value);
+	}
+
 	sqlite3_reset(put_stmt);
 	db_sync();
 	ast_mutex_unlock(&dblock);
@@ -385,6 +472,21 @@ static int db_get_common(const char *family, const char *key, char **buffer, int
 	fullkey_len = snprintf(fullkey, sizeof(fullkey), "/%s/%s", family, key);
 
 	ast_mutex_lock(&dblock);
+	if (db_cache) {
+		struct db_cache_entry *entry;
+
+		entry = ao2_find(db_cache, fullkey, OBJ_SEARCH_KEY);
+		if (entry) {
+			if (bufferlen == -1) {
+				*buffer = ast_strdup(entry->value);
+			} else {
+				ast_copy_string(*buffer, entry->value, bufferlen);
+			}
+			ao2_ref(entry, -1);
+			ast_mutex_unlock(&dblock);
+			return 0;
+		}
+	}
 	if (sqlite3_bind_text(get_stmt, 1, fullkey, fullkey_len, SQLITE_STATIC) != SQLITE_OK) {
 		ast_log(LOG_WARNING, "Couldn't bind key to stmt: %s\n", sqlite3_errmsg(astdb));
 		res = -1;
@@ -402,6 +504,7 @@ static int db_get_common(const char *family, const char *key, char **buffer, int
 		} else {
 			ast_copy_string(*buffer, value, bufferlen);
 		}
+		db_cache_update(fullkey, fullkey_len, value);
 	}
 	sqlite3_reset(get_stmt);
 	ast_mutex_unlock(&dblock);
@@ -447,6 +550,7 @@ int ast_db_del(const char *family, const char *key)
 		ast_debug(1, "Unable to find key '%s' in family '%s'\n", key, family);
 		res = -1;
 	}
+	db_cache_remove(fullkey);
 	sqlite3_reset(del_stmt);
 	db_sync();
 	ast_mutex_unlock(&dblock);
@@ -482,6 +586,9 @@ int ast_db_deltree(const char *family, const char *keytree)
 		res = -1;
 	}
 	res = sqlite3_changes(astdb);
+	/* Prefix-matching the cache is not worth the traversal for an
+	 * operation this rare; just start it over. */
+	db_cache_flush();
 	sqlite3_reset(stmt);
 	db_sync();
 	ast_mutex_unlock(&dblock);
@@ -1008,8 +1115,13 @@ static int manager_dbdeltree(struct mansession *s, const struct message *m)
  */
 static void db_sync(void)
 {
-	dosync = 1;
-	ast_cond_signal(&dbcond);
+	if (!dosync) {
+		/* The sync thread commits everything accumulated since it last
+		 * cleared dosync, so only the first write of a commit window
+		 * needs to wake it. */
+		dosync = 1;
+		ast_cond_signal(&dbcond);
+	}
 }
 
 /*!
@@ -1072,6 +1184,8 @@ static void astdb_atexit(void)
 
 	pthread_join(syncthread, NULL);
 	ast_mutex_lock(&dblock);
+	ao2_cleanup(db_cache);
+	db_cache = NULL;
 	clean_statements();
 	if (sqlite3_close(astdb) == SQLITE_OK) {
 		astdb = NULL;
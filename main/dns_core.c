@@ -49,6 +49,343 @@ AST_RWLIST_HEAD_STATIC(resolvers, ast_dns_resolver);
 
 static struct ast_sched_context *sched;
 
+/*! \brief Number of buckets in the shared DNS cache */
+#define DNS_CACHE_BUCKETS 61
+
+/*! \brief Longest time, in seconds, a positive answer is served from the cache */
+#define DNS_CACHE_MAX_TTL 3600
+
+/*! \brief How long, in seconds, a negative answer is served from the cache */
+#define DNS_CACHE_NEGATIVE_TTL 5
+
+/*!
+ * \brief Shared positive and negative answer cache.
+ *
+ * Keyed by name, resource record type, and class.  Consulted before a
+ * query is handed to any resolver so repeated lookups of the same name,
+ * such as trunk failover storms re-resolving SRV targets, do not tie up
+ * resolver threads.
+ */
+static struct ao2_container *dns_cache;
+
+/*! \brief A raw resource record staged for, or held by, a cache entry */
+struct dns_cache_raw_record {
+	/*! \brief Resource record type */
+	int rr_type;
+	/*! \brief Resource record class */
+	int rr_class;
+	/*! \brief Time-to-live at the moment the record was received */
+	int ttl;
+	/*! \brief Size of the raw DNS record */
+	size_t size;
+	/*! \brief Linked list information */
+	AST_LIST_ENTRY(dns_cache_raw_record) list;
+	/*! \brief The raw DNS record */
+	char data[0];
+};
+
+/*! \brief Raw wire data captured while a query resolves */
+struct dns_cache_staging {
+	/*! \brief TRUE if a record could not be captured, disqualifying the answer */
+	unsigned int invalid:1;
+	/*! \brief Raw records in received order */
+	AST_LIST_HEAD_NOLOCK(, dns_cache_raw_record) records;
+};
+
+/*! \brief A cached DNS answer */
+struct dns_cache_entry {
+	/*! \brief Resource record type */
+	int rr_type;
+	/*! \brief Resource record class */
+	int rr_class;
+	/*! \brief Whether the answer was secure */
+	unsigned int secure;
+	/*! \brief Whether the answer was bogus */
+	unsigned int bogus;
+	/*! \brief Response code of the answer */
+	unsigned int rcode;
+	/*! \brief When the answer was received */
+	struct timeval added;
+	/*! \brief When the answer lapses */
+	struct timeval expiry;
+	/*! \brief The canonical name, pointing into buf */
+	const char *canonical;
+	/*! \brief The raw DNS answer, pointing into buf */
+	const char *answer;
+	/*! \brief The size of the raw DNS answer */
+	size_t answer_size;
+	/*! \brief Raw records of the answer */
+	AST_LIST_HEAD_NOLOCK(, dns_cache_raw_record) records;
+	/*! \brief The name that was resolved, pointing into buf */
+	const char *name;
+	/*! \brief Buffer for dynamic data */
+	char buf[0];
+};
+
+/*! \brief Search key for cache lookups */
+struct dns_cache_key {
+	/*! \brief The name being resolved */
+	const char *name;
+	/*! \brief Resource record type */
+	int rr_type;
+	/*! \brief Resource record class */
+	int rr_class;
+};
+
+static void dns_cache_raw_records_free(struct dns_cache_staging *staging)
+{
+	struct dns_cache_raw_record *raw;
+
+	while ((raw = AST_LIST_REMOVE_HEAD(&staging->records, list))) {
+		ast_free(raw);
+	}
+}
+
+static void dns_cache_staging_free(struct dns_cache_staging *staging)
+{
+	if (!staging) {
+		return;
+	}
+
+	dns_cache_raw_records_free(staging);
+	ast_free(staging);
+}
+
+/*! \brief Destructor for a cached DNS answer */
+static void dns_cache_entry_destroy(void *obj)
+{
+	struct dns_cache_entry *entry = obj;
+	struct dns_cache_raw_record *raw;
+
+	while ((raw = AST_LIST_REMOVE_HEAD(&entry->records, list))) {
+		ast_free(raw);
+	}
+}
+
+static int dns_cache_hash(const void *obj, int flags)
+{
+	const struct dns_cache_entry *entry = obj;
+	const struct dns_cache_key *key = obj;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_KEY:
+		return ast_str_hash(key->name);
+	case OBJ_SEARCH_OBJECT:
+		return ast_str_hash(entry->name);
+	default:
+		ast_assert(0);
+		return 0;
+	}
+}
+
+static int dns_cache_sort(const void *obj_left, const void *obj_right, int flags)
+{
+	const struct dns_cache_entry *left = obj_left;
+	const struct dns_cache_entry *right = obj_right;
+	const struct dns_cache_key *key = obj_right;
+	struct dns_cache_key right_key;
+	int cmp;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_OBJECT:
+		right_key.name = right->name;
+		right_key.rr_type = right->rr_type;
+		right_key.rr_class = right->rr_class;
+		key = &right_key;
+		/* Fall through */
+	case OBJ_SEARCH_KEY:
+		cmp = strcmp(left->name, key->name);
+		if (!cmp) {
+			cmp = left->rr_type - key->rr_type;
+		}
+		if (!cmp) {
+			cmp = left->rr_class - key->rr_class;
+		}
+		break;
+	default:
+		/* Sort can only work on something with a full key. */
+		ast_assert(0);
+		cmp = 0;
+		break;
+	}
+	return cmp;
+}
+
+/*! \brief Stage a copy of a raw record so the answer can be cached on completion */
+static void dns_cache_stage_record(struct ast_dns_query *query, int rr_type, int rr_class,
+	int ttl, const char *data, const size_t size)
+{
+	struct dns_cache_raw_record *raw;
+
+	if (!query->cache_staging || query->cache_staging->invalid) {
+		return;
+	}
+
+	raw = ast_malloc(sizeof(*raw) + size);
+	if (!raw) {
+		/* A partial answer must not be cached */
+		query->cache_staging->invalid = 1;
+		return;
+	}
+
+	raw->rr_type = rr_type;
+	raw->rr_class = rr_class;
+	raw->ttl = ttl;
+	raw->size = size;
+	memcpy(raw->data, data, size);
+	AST_LIST_INSERT_TAIL(&query->cache_staging->records, raw, list);
+}
+
+/*! \brief Insert a completed query's answer into the shared cache */
+static void dns_cache_store(struct ast_dns_query *query)
+{
+	struct ast_dns_result *result = query->result;
+	struct dns_cache_entry *entry;
+	size_t name_len;
+	size_t canonical_len;
+	char *buf_ptr;
+	int ttl;
+
+	if (!dns_cache || !result || !query->cache_staging || query->cache_staging->invalid) {
+		return;
+	}
+
+	if (result->rcode || AST_LIST_EMPTY(&result->records)) {
+		/* A negative answer is cached briefly to absorb retry storms */
+		ttl = DNS_CACHE_NEGATIVE_TTL;
+	} else {
+		ttl = ast_dns_result_get_lowest_ttl(result);
+		if (ttl <= 0) {
+			/* A zero TTL forbids caching */
+			return;
+		}
+		if (ttl > DNS_CACHE_MAX_TTL) {
+			ttl = DNS_CACHE_MAX_TTL;
+		}
+	}
+
+	name_len = strlen(query->name) + 1;
+	canonical_len = strlen(result->canonical) + 1;
+
+	entry = ao2_alloc_options(sizeof(*entry) + name_len + canonical_len + result->answer_size,
+		dns_cache_entry_destroy, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!entry) {
+		return;
+	}
+
+	entry->rr_type = query->rr_type;
+	entry->rr_class = query->rr_class;
+	entry->secure = result->secure;
+	entry->bogus = result->bogus;
+	entry->rcode = result->rcode;
+	entry->added = ast_tvnow();
+	entry->expiry = ast_tvadd(entry->added, ast_samp2tv(ttl, 1));
+
+	buf_ptr = entry->buf;
+	strcpy(buf_ptr, query->name); /* SAFE */
+	entry->name = buf_ptr;
+	buf_ptr += name_len;
+	strcpy(buf_ptr, result->canonical); /* SAFE */
+	entry->canonical = buf_ptr;
+	buf_ptr += canonical_len;
+	memcpy(buf_ptr, result->answer, result->answer_size);
+	entry->answer = buf_ptr;
+	entry->answer_size = result->answer_size;
+
+	/* Negative entries keep no records; positive entries take the staged copies */
+	if (!result->rcode && !AST_LIST_EMPTY(&result->records)) {
+		AST_LIST_APPEND_LIST(&entry->records, &query->cache_staging->records, list);
+	}
+
+	ao2_link(dns_cache, entry);
+	ao2_ref(entry, -1);
+}
+
+/*!
+ * \internal
+ * \brief Answer a query from the shared cache if a live entry exists.
+ *
+ * A hit replays the cached raw answer through the same resolver-facing
+ * functions a backend would use, so record parsing and sorting behave
+ * identically to a fresh resolution.  Remaining time-to-live is reported
+ * on each record.
+ *
+ * \retval 1 The query was answered from the cache.
+ * \retval 0 No usable entry; the query must be resolved.
+ */
+static int dns_cache_serve(struct ast_dns_query *query)
+{
+	struct dns_cache_key key = {
+		.name = query->name,
+		.rr_type = query->rr_type,
+		.rr_class = query->rr_class,
+	};
+	struct dns_cache_entry *entry;
+	struct dns_cache_raw_record *raw;
+	struct timeval now;
+	int64_t elapsed;
+
+	if (!dns_cache || !query->resolver->cacheable) {
+		return 0;
+	}
+
+	entry = ao2_find(dns_cache, &key, OBJ_SEARCH_KEY);
+	if (!entry) {
+		return 0;
+	}
+
+	now = ast_tvnow();
+	if (ast_tvcmp(entry->expiry, now) <= 0) {
+		/* Lapsed; evict so the slot does not linger */
+		ao2_unlink(dns_cache, entry);
+		ao2_ref(entry, -1);
+		return 0;
+	}
+	elapsed = ast_tvdiff_ms(now, entry->added) / 1000;
+
+	query->from_cache = 1;
+	if (ast_dns_resolver_set_result(query, entry->secure, entry->bogus, entry->rcode,
+			entry->canonical, entry->answer, entry->answer_size)) {
+		query->from_cache = 0;
+		ao2_ref(entry, -1);
+		return 0;
+	}
+
+	AST_LIST_TRAVERSE(&entry->records, raw, list) {
+		int ttl = raw->ttl - (int) elapsed;
+
+		if (ttl < 1) {
+			ttl = 1;
+		}
+		if (ast_dns_resolver_add_record(query, raw->rr_type, raw->rr_class, ttl,
+				raw->data, raw->size)) {
+			ast_dns_result_free(query->result);
+			query->result = NULL;
+			query->from_cache = 0;
+			ao2_ref(entry, -1);
+			return 0;
+		}
+	}
+	ao2_ref(entry, -1);
+
+	return 1;
+}
+
+/*! \brief Scheduler callback completing a query answered from the cache */
+static int dns_cache_hit_dispatch(const void *data)
+{
+	struct ast_dns_query *query = (struct ast_dns_query *) data;
+
+	ao2_lock(dns_cache);
+	query->cache_sched_id = -1;
+	ao2_unlock(dns_cache);
+
+	ast_dns_resolver_completed(query);
+	ao2_ref(query, -1);
+
+	return 0;
+}
+
 struct ast_sched_context *ast_dns_get_sched(void)
 {
 	return sched;
@@ -188,6 +525,7 @@ static void dns_query_destroy(void *data)
 	ao2_cleanup(query->user_data);
 	ao2_cleanup(query->resolver_data);
 	ast_dns_result_free(query->result);
+	dns_cache_staging_free(query->cache_staging);
 }
 
 struct ast_dns_query *dns_query_alloc(const char *name, int rr_type, int rr_class, ast_dns_resolve_callback callback, void *data)
@@ -228,6 +566,7 @@ struct ast_dns_query *dns_query_alloc(const char *name, int rr_type, int rr_clas
 	query->user_data = ao2_bump(data);
 	query->rr_type = rr_type;
 	query->rr_class = rr_class;
+	query->cache_sched_id = -1;
 	strcpy(query->name, name); /* SAFE */
 
 	AST_RWLIST_RDLOCK(&resolvers);
@@ -259,6 +598,21 @@ struct ast_dns_query_active *ast_dns_resolve_async(const char *name, int rr_type
 		return NULL;
 	}
 
+	if (dns_cache_serve(active->query)) {
+		/* Complete on the DNS scheduler thread so the caller never sees
+		 * its callback run before this function returns. */
+		ao2_ref(active->query, +1);
+		ao2_lock(dns_cache);
+		active->query->cache_sched_id = ast_sched_add(sched, 1, dns_cache_hit_dispatch,
+			active->query);
+		ao2_unlock(dns_cache);
+		if (active->query->cache_sched_id < 0) {
+			ao2_ref(active->query, -1);
+			ast_dns_resolver_completed(active->query);
+		}
+		return active;
+	}
+
 	if (active->query->resolver->resolve(active->query)) {
 		ast_log(LOG_ERROR, "Resolver '%s' returned an error when resolving '%s' of class '%d' and type '%d'\n",
 			active->query->resolver->name, name, rr_class, rr_type);
@@ -271,6 +625,22 @@ struct ast_dns_query_active *ast_dns_resolve_async(const char *name, int rr_type
 
 int ast_dns_resolve_cancel(struct ast_dns_query_active *active)
 {
+	if (active->query->from_cache) {
+		int res = -1;
+
+		/* The resolver never saw this query; cancellation is a race
+		 * against the scheduled completion. */
+		ao2_lock(dns_cache);
+		if (active->query->cache_sched_id > -1
+			&& !ast_sched_del(sched, active->query->cache_sched_id)) {
+			active->query->cache_sched_id = -1;
+			ao2_ref(active->query, -1);
+			res = 0;
+		}
+		ao2_unlock(dns_cache);
+		return res;
+	}
+
 	return active->query->resolver->cancel(active->query);
 }
 
@@ -496,6 +866,16 @@ int ast_dns_resolver_set_result(struct ast_dns_query *query, unsigned int secure
 	query->result->answer = buf_ptr;
 	query->result->answer_size = answer_size;
 
+	/* A new result restarts the raw record capture for the cache */
+	if (!query->from_cache && query->resolver && query->resolver->cacheable) {
+		if (query->cache_staging) {
+			dns_cache_raw_records_free(query->cache_staging);
+			query->cache_staging->invalid = 0;
+		} else {
+			query->cache_staging = ast_calloc(1, sizeof(*query->cache_staging));
+		}
+	}
+
 	return 0;
 }
 
@@ -579,6 +959,10 @@ int ast_dns_resolver_add_record(struct ast_dns_query *query, int rr_type, int rr
 
 	AST_LIST_INSERT_TAIL(&query->result->records, record, list);
 
+	if (!query->from_cache) {
+		dns_cache_stage_record(query, rr_type, rr_class, ttl, data, size);
+	}
+
 	return 0;
 }
 
@@ -600,6 +984,10 @@ void ast_dns_resolver_completed(struct ast_dns_query *query)
 {
 	sort_result(ast_dns_query_get_rr_type(query), query->result);
 
+	if (!query->from_cache) {
+		dns_cache_store(query);
+	}
+
 	query->callback(query);
 }
 
@@ -609,6 +997,8 @@ static void dns_shutdown(void)
 		ast_sched_context_destroy(sched);
 		sched = NULL;
 	}
+	ao2_cleanup(dns_cache);
+	dns_cache = NULL;
 }
 
 int dns_core_init(void)
@@ -622,6 +1012,13 @@ int dns_core_init(void)
 		return -1;
 	}
 
+	dns_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, DNS_CACHE_BUCKETS,
+		dns_cache_hash, dns_cache_sort, NULL);
+	if (!dns_cache) {
+		return -1;
+	}
+
 	ast_register_cleanup(dns_shutdown);
 
 	return 0;
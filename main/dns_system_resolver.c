@@ -61,6 +61,7 @@ static struct ast_taskprocessor *dns_system_resolver_tp;
 struct ast_dns_resolver dns_system_resolver_base = {
 	.name = "system",
 	.priority = DNS_SYSTEM_RESOLVER_PRIORITY,
+	.cacheable = 1,
 	.resolve = dns_system_resolver_resolve,
 	.cancel = dns_system_resolver_cancel,
 };
@@ -76,6 +76,8 @@ struct ast_dnsmgr_entry {
 	void *data;
 	/*! The callback function to execute on address update */
 	dns_update_func update_func;
+	/*! Scheduled jittered refresh for this entry, or -1 */
+	int sched_id;
 	ast_mutex_t lock;
 	AST_RWLIST_ENTRY(ast_dnsmgr_entry) list;
 	/*! just 1 here, but we use calloc to allocate the correct size */
@@ -95,12 +97,15 @@ struct refresh_info {
 	struct entry_list *entries;
 	int verbose;
 	unsigned int regex_present:1;
+	/*! Spread lookups over the interval instead of refreshing in one burst */
+	unsigned int jitter:1;
 	regex_t filter;
 };
 
 static struct refresh_info master_refresh_info = {
 	.entries = &entry_list,
 	.verbose = 0,
+	.jitter = 1,
 };
 
 struct ast_dnsmgr_entry *ast_dnsmgr_get_family(const char *name, struct ast_sockaddr *result, const char *service, unsigned int family)
@@ -113,6 +118,7 @@ struct ast_dnsmgr_entry *ast_dnsmgr_get_family(const char *name, struct ast_sock
 	}
 
 	entry->result = result;
+	entry->sched_id = -1;
 	ast_mutex_init(&entry->lock);
 	strcpy(entry->name, name);
 	if (service) {
@@ -142,6 +148,7 @@ void ast_dnsmgr_release(struct ast_dnsmgr_entry *entry)
 	AST_RWLIST_WRLOCK(&entry_list);
 	AST_RWLIST_REMOVE(&entry_list, entry, list);
 	AST_RWLIST_UNLOCK(&entry_list);
+	AST_SCHED_DEL(sched, entry->sched_id);
 	ast_debug(6, "removing dns manager for '%s'\n", entry->name);
 
 	ast_mutex_destroy(&entry->lock);
@@ -199,41 +206,124 @@ int ast_dnsmgr_lookup_cb(const char *name, struct ast_sockaddr *result, struct a
 }
 
 /*
- * Refresh a dnsmgr entry
+ * Apply a fresh lookup result to a dnsmgr entry, updating the consumer
+ * only if the answer actually differs from what it already has
  */
-static int dnsmgr_refresh(struct ast_dnsmgr_entry *entry, int verbose)
+static int dnsmgr_apply_lookup(struct ast_dnsmgr_entry *entry, const struct ast_sockaddr *lookup)
 {
-	struct ast_sockaddr tmp = { .len = 0, };
+	struct ast_sockaddr tmp;
 	int changed = 0;
 
 	ast_mutex_lock(&entry->lock);
 
+	ast_sockaddr_copy(&tmp, lookup);
+	if (!ast_sockaddr_port(&tmp)) {
+		ast_sockaddr_set_port(&tmp, ast_sockaddr_port(entry->result));
+	}
+	if (ast_sockaddr_cmp(&tmp, entry->result)) {
+		const char *old_addr = ast_strdupa(ast_sockaddr_stringify(entry->result));
+		const char *new_addr = ast_strdupa(ast_sockaddr_stringify(&tmp));
+
+		if (entry->update_func) {
+			entry->update_func(entry->result, &tmp, entry->data);
+		} else {
+			ast_log(LOG_NOTICE, "dnssrv: host '%s' changed from %s to %s\n",
+					entry->name, old_addr, new_addr);
+
+			ast_sockaddr_copy(entry->result, &tmp);
+			changed = entry->changed = 1;
+		}
+	}
+
+	ast_mutex_unlock(&entry->lock);
+
+	return changed;
+}
+
+/*
+ * Refresh a dnsmgr entry
+ */
+static int dnsmgr_refresh(struct ast_dnsmgr_entry *entry, int verbose)
+{
+	struct ast_sockaddr tmp = { .len = 0, };
+
 	ast_debug(6, "refreshing '%s'\n", entry->name);
 
 	tmp.ss.ss_family = entry->family;
-	if (!ast_get_ip_or_srv(&tmp, entry->name, entry->service)) {
-		if (!ast_sockaddr_port(&tmp)) {
-			ast_sockaddr_set_port(&tmp, ast_sockaddr_port(entry->result));
+	if (ast_get_ip_or_srv(&tmp, entry->name, entry->service)) {
+		return 0;
+	}
+
+	return dnsmgr_apply_lookup(entry, &tmp);
+}
+
+/*
+ * Check if two entries would perform the identical DNS lookup
+ */
+static int entry_same_lookup(const struct ast_dnsmgr_entry *a, const struct ast_dnsmgr_entry *b)
+{
+	return a->family == b->family
+		&& !strcasecmp(a->name, b->name)
+		&& !strcmp(S_OR(a->service, ""), S_OR(b->service, ""));
+}
+
+/*!
+ * \internal
+ * \brief Jittered refresh of an entry and every other entry wanting the same lookup.
+ *
+ * The entry may have been released between being scheduled and the callback
+ * running, so it is only dereferenced once found in the list.  A single
+ * lookup is performed and the answer applied to all entries sharing the
+ * same name, service, and family so duplicates do not query separately.
+ */
+static int dnsmgr_refresh_entry_cb(const void *data)
+{
+	struct ast_dnsmgr_entry *leader = (struct ast_dnsmgr_entry *) data;
+	struct ast_dnsmgr_entry *entry;
+	struct ast_sockaddr lookup = { .len = 0, };
+
+	AST_RWLIST_RDLOCK(&entry_list);
+	AST_RWLIST_TRAVERSE(&entry_list, entry, list) {
+		if (entry == leader) {
+			break;
 		}
-		if (ast_sockaddr_cmp(&tmp, entry->result)) {
-			const char *old_addr = ast_strdupa(ast_sockaddr_stringify(entry->result));
-			const char *new_addr = ast_strdupa(ast_sockaddr_stringify(&tmp));
+	}
+	if (!entry) {
+		AST_RWLIST_UNLOCK(&entry_list);
+		return 0;
+	}
+	leader->sched_id = -1;
 
-			if (entry->update_func) {
-				entry->update_func(entry->result, &tmp, entry->data);
-			} else {
-				ast_log(LOG_NOTICE, "dnssrv: host '%s' changed from %s to %s\n",
-						entry->name, old_addr, new_addr);
+	ast_debug(6, "refreshing '%s'\n", leader->name);
 
-				ast_sockaddr_copy(entry->result, &tmp);
-				changed = entry->changed = 1;
+	lookup.ss.ss_family = leader->family;
+	if (!ast_get_ip_or_srv(&lookup, leader->name, leader->service)) {
+		AST_RWLIST_TRAVERSE(&entry_list, entry, list) {
+			if (entry_same_lookup(entry, leader)) {
+				dnsmgr_apply_lookup(entry, &lookup);
 			}
 		}
 	}
+	AST_RWLIST_UNLOCK(&entry_list);
 
-	ast_mutex_unlock(&entry->lock);
+	return 0;
+}
 
-	return changed;
+/*
+ * Check whether another entry with the same lookup already has a refresh
+ * scheduled this cycle.  Must be called with the entry list locked.
+ */
+static int dnsmgr_lookup_pending(struct ast_dnsmgr_entry *target)
+{
+	struct ast_dnsmgr_entry *entry;
+
+	AST_RWLIST_TRAVERSE(&entry_list, entry, list) {
+		if (entry != target && entry->sched_id > -1 && entry_same_lookup(entry, target)) {
+			return 1;
+		}
+	}
+
+	return 0;
 }
 
 int ast_dnsmgr_refresh(struct ast_dnsmgr_entry *entry)
@@ -289,7 +379,20 @@ static int refresh_list(const void *data)
 			continue;
 		}
 
-		dnsmgr_refresh(entry, info->verbose);
+		if (!info->jitter || refresh_interval < 2) {
+			dnsmgr_refresh(entry, info->verbose);
+			continue;
+		}
+
+		/* Spread the lookups over the interval rather than querying in one
+		 * burst.  Entries wanting the identical lookup piggyback on the one
+		 * already scheduled, so only a single query is made for them. */
+		if (entry->sched_id > -1 || dnsmgr_lookup_pending(entry)) {
+			continue;
+		}
+
+		entry->sched_id = ast_sched_add(sched, 1 + (ast_random() % (refresh_interval * 1000 - 1)),
+			dnsmgr_refresh_entry_cb, entry);
 	}
 	AST_RWLIST_UNLOCK(info->entries);
 
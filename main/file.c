@@ -33,6 +33,9 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <math.h>
+#ifdef HAVE_INOTIFY
+#include <sys/inotify.h>
+#endif
 
 #include "asterisk/_private.h"	/* declare ast_file_init() */
 #include "asterisk/paths.h"	/* use ast_config_AST_DATA_DIR */
@@ -53,6 +56,8 @@
 #include "asterisk/json.h"
 #include "asterisk/stasis_system.h"
 #include "asterisk/media_cache.h"
+#include "asterisk/taskprocessor.h"
+#include "asterisk/threadpool.h"
 
 /*! \brief
  * The following variable controls the layout of localized sound files.
@@ -71,6 +76,230 @@ static AST_RWLIST_HEAD_STATIC(formats, ast_format_def);
 STASIS_MESSAGE_TYPE_DEFN(ast_format_register_type);
 STASIS_MESSAGE_TYPE_DEFN(ast_format_unregister_type);
 
+/*! \brief Pool of writer threads recordings are flushed on, NULL when record_async_threads is 0 */
+static struct ast_threadpool *record_pool;
+
+/*! \brief Hash bucket count for the shared sound cache */
+#define SOUND_CACHE_BUCKETS 61
+
+/*!
+ * \brief One in-memory copy of a sound file, shared by every stream playing it.
+ *
+ * Entries are keyed by the resolved file name (which includes the format
+ * extension, so each (path, format) pair caches separately).  Streams hold a
+ * reference for as long as they play, so eviction only releases the memory
+ * once the last stream using the old copy has closed.
+ */
+struct sound_cache_entry {
+	AST_LIST_ENTRY(sound_cache_entry) list;	/*!< LRU order, most recently used first */
+	size_t len;		/*!< length of the file contents */
+	time_t mtime;		/*!< modification time when loaded, to spot changed files */
+	char *data;		/*!< the raw file contents */
+	char fn[0];		/*!< file name, including extension */
+};
+
+/*! \brief Cached sound files by name.  All operations are protected by the LRU list lock. */
+static struct ao2_container *sound_cache;
+static AST_LIST_HEAD_STATIC(sound_cache_lru, sound_cache_entry);
+/*! \brief Bytes of file contents currently held by the cache */
+static size_t sound_cache_bytes;
+
+static void sound_cache_entry_destructor(void *obj)
+{
+	struct sound_cache_entry *entry = obj;
+
+	ast_free(entry->data);
+}
+
+AO2_STRING_FIELD_HASH_FN(sound_cache_entry, fn)
+AO2_STRING_FIELD_CMP_FN(sound_cache_entry, fn)
+
+static struct sound_cache_entry *sound_cache_entry_load(const char *fn, const struct stat *st)
+{
+	struct sound_cache_entry *entry;
+	FILE *f;
+
+	entry = ao2_alloc_options(sizeof(*entry) + strlen(fn) + 1,
+		sound_cache_entry_destructor, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!entry) {
+		return NULL;
+	}
+	strcpy(entry->fn, fn); /* Safe */
+	entry->len = st->st_size;
+	entry->mtime = st->st_mtime;
+
+	entry->data = ast_malloc(entry->len);
+	if (!entry->data) {
+		ao2_ref(entry, -1);
+		return NULL;
+	}
+
+	if (!(f = fopen(fn, "r"))) {
+		ao2_ref(entry, -1);
+		return NULL;
+	}
+	if (fread(entry->data, 1, entry->len, f) != entry->len) {
+		fclose(f);
+		ao2_ref(entry, -1);
+		return NULL;
+	}
+	fclose(f);
+
+	return entry;
+}
+
+/*!
+ * \internal
+ * \brief Open \a fn for reading through the shared sound cache.
+ *
+ * On success a memory stream over the cached file contents is returned and
+ * \a cached is set to the reference the stream must hold while playing.
+ * Returns NULL when the file cannot be served from the cache (cache disabled,
+ * file too large, load failure) and the caller should fall back to fopen().
+ */
+static FILE *sound_cache_fopen(const char *fn, const struct stat *st, struct sound_cache_entry **cached)
+{
+	size_t max_bytes = (size_t) ast_option_soundscachesize * 1024 * 1024;
+	struct sound_cache_entry *entry;
+	FILE *f;
+
+	if (!max_bytes || !sound_cache || !S_ISREG(st->st_mode)
+		|| !st->st_size || st->st_size > max_bytes / 2) {
+		return NULL;
+	}
+
+	AST_LIST_LOCK(&sound_cache_lru);
+	entry = ao2_find(sound_cache, fn, OBJ_SEARCH_KEY);
+	if (entry && (entry->mtime != st->st_mtime || entry->len != (size_t) st->st_size)) {
+		/* The file changed on disk since we loaded it.  Streams still
+		 * playing the old copy keep their references; we just stop
+		 * handing it out. */
+		AST_LIST_REMOVE(&sound_cache_lru, entry, list);
+		sound_cache_bytes -= entry->len;
+		ao2_unlink(sound_cache, entry);
+		ao2_ref(entry, -1);
+		entry = NULL;
+	}
+	if (entry) {
+		/* Move to the front of the LRU list */
+		AST_LIST_REMOVE(&sound_cache_lru, entry, list);
+		AST_LIST_INSERT_HEAD(&sound_cache_lru, entry, list);
+	} else {
+		struct sound_cache_entry *existing;
+
+		/* Load outside the lock so a slow disk does not stall every
+		 * other stream open. */
+		AST_LIST_UNLOCK(&sound_cache_lru);
+		entry = sound_cache_entry_load(fn, st);
+		if (!entry) {
+			return NULL;
+		}
+		AST_LIST_LOCK(&sound_cache_lru);
+		existing = ao2_find(sound_cache, fn, OBJ_SEARCH_KEY);
+		if (existing) {
+			/* Lost the race to another stream loading the same file */
+			ao2_ref(entry, -1);
+			entry = existing;
+			AST_LIST_REMOVE(&sound_cache_lru, entry, list);
+			AST_LIST_INSERT_HEAD(&sound_cache_lru, entry, list);
+		} else {
+			ao2_link(sound_cache, entry);
+			AST_LIST_INSERT_HEAD(&sound_cache_lru, entry, list);
+			sound_cache_bytes += entry->len;
+
+			/* Evict the least recently used files until we fit again */
+			while (sound_cache_bytes > max_bytes) {
+				struct sound_cache_entry *old = AST_LIST_LAST(&sound_cache_lru);
+
+				if (old == entry) {
+					break;
+				}
+				AST_LIST_REMOVE(&sound_cache_lru, old, list);
+				sound_cache_bytes -= old->len;
+				ao2_unlink(sound_cache, old);
+			}
+		}
+	}
+	AST_LIST_UNLOCK(&sound_cache_lru);
+
+	f = fmemopen(entry->data, entry->len, "rb");
+	if (!f) {
+		ao2_ref(entry, -1);
+		return NULL;
+	}
+	*cached = entry;
+	return f;
+}
+
+#ifdef HAVE_INOTIFY
+/*! \brief Hash bucket count for the file resolution cache */
+#define FILEEXISTS_CACHE_BUCKETS 521
+/*! \brief Stop caching new resolutions once this many are held */
+#define FILEEXISTS_CACHE_MAX_ENTRIES 2048
+
+/*!
+ * \brief Cached result of a successful file/format/language resolution.
+ *
+ * Avoids re-running the extension and language scan (a stat() per format
+ * extension per candidate language) on every playback of the same prompt.
+ * Entries are validated against a global generation counter which is bumped
+ * whenever inotify reports a change in any directory we resolved files from,
+ * or when the format list changes.  Negative results are never cached, so
+ * newly installed files are picked up immediately.
+ */
+struct fileexists_cache_entry {
+	unsigned int generation;	/*!< fileexists_cache_generation when computed */
+	struct ast_format_cap *cap;	/*!< formats the file was found in */
+	char *resolved;			/*!< file name the scan resolved to */
+	char key[0];			/*!< requested name, format and language */
+};
+
+static struct ao2_container *fileexists_cache;
+/*! \brief Bumped whenever a watched directory or the format list changes */
+static int fileexists_cache_generation;
+/*! \brief inotify descriptor watching the resolved directories, -1 when unavailable */
+static int fileexists_inotify_fd = -1;
+
+static void fileexists_cache_entry_destructor(void *obj)
+{
+	struct fileexists_cache_entry *entry = obj;
+
+	ao2_cleanup(entry->cap);
+	ast_free(entry->resolved);
+}
+
+AO2_STRING_FIELD_HASH_FN(fileexists_cache_entry, key)
+AO2_STRING_FIELD_CMP_FN(fileexists_cache_entry, key)
+
+static void *fileexists_cache_thread(void *data)
+{
+	char buf[4096] __attribute__((aligned (sizeof(int))));
+
+	for (;;) {
+		ssize_t res = read(fileexists_inotify_fd, buf, sizeof(buf));
+
+		if (res < 0 && errno != EINTR) {
+			break;
+		}
+		if (res > 0) {
+			/* Something changed in a directory we resolved files from.
+			 * Mapping events back to individual entries is not worth it;
+			 * sounds change rarely, so invalidate everything. */
+			ast_atomic_fetchadd_int(&fileexists_cache_generation, +1);
+		}
+	}
+	return NULL;
+}
+#endif
+
+/*! \brief Forget every cached file resolution result */
+static void fileexists_cache_invalidate(void)
+{
+#ifdef HAVE_INOTIFY
+	ast_atomic_fetchadd_int(&fileexists_cache_generation, +1);
+#endif
+}
+
 static struct ast_json *json_array_from_list(const char *list, const char *sep)
 {
 	RAII_VAR(struct ast_json *, array, ast_json_array_create(), ast_json_unref);
@@ -155,6 +384,7 @@ int __ast_format_def_register(const struct ast_format_def *f, struct ast_module
 	AST_RWLIST_UNLOCK(&formats);
 	ast_verb(2, "Registered file format %s, extension(s) %s\n", f->name, f->exts);
 	publish_format_update(f, ast_format_register_type());
+	fileexists_cache_invalidate();
 
 	return 0;
 }
@@ -176,10 +406,12 @@ int ast_format_def_unregister(const char *name)
 	AST_RWLIST_TRAVERSE_SAFE_END;
 	AST_RWLIST_UNLOCK(&formats);
 
-	if (!res)
+	if (!res) {
 		ast_verb(2, "Unregistered format %s\n", name);
-	else
+		fileexists_cache_invalidate();
+	} else {
 		ast_log(LOG_WARNING, "Tried to unregister format %s, already unregistered\n", name);
+	}
 
 	return res;
 }
@@ -241,26 +473,11 @@ int ast_stopstream(struct ast_channel *tmp)
 	return 0;
 }
 
-int ast_writestream(struct ast_filestream *fs, struct ast_frame *f)
+/*! \brief Translate (if needed) and write one frame to the stream's format handler */
+static int writestream_write(struct ast_filestream *fs, struct ast_frame *f)
 {
 	int res = -1;
-	if (f->frametype == AST_FRAME_VIDEO) {
-		if (ast_format_get_type(fs->fmt->format) == AST_MEDIA_TYPE_AUDIO) {
-			/* This is the audio portion.  Call the video one... */
-			if (!fs->vfs && fs->filename) {
-				const char *type = ast_format_get_name(f->subclass.format);
-				fs->vfs = ast_writefile(fs->filename, type, NULL, fs->flags, 0, fs->mode);
-				ast_debug(1, "Opened video output file\n");
-			}
-			if (fs->vfs)
-				return ast_writestream(fs->vfs, f);
-			/* else ignore */
-			return 0;
-		}
-	} else if (f->frametype != AST_FRAME_VOICE) {
-		ast_log(LOG_WARNING, "Tried to write non-voice frame\n");
-		return -1;
-	}
+
 	if (ast_format_cmp(f->subclass.format, fs->fmt->format) != AST_FORMAT_CMP_NOT_EQUAL) {
 		res =  fs->fmt->write(fs, f);
 		if (res < 0)
@@ -303,6 +520,83 @@ int ast_writestream(struct ast_filestream *fs, struct ast_frame *f)
 	return res;
 }
 
+/*! \brief Drain every frame queued on a recording stream, in order */
+static int writestream_flush_task(void *data)
+{
+	struct ast_filestream *fs = data;
+	struct ast_frame *f;
+
+	for (;;) {
+		ao2_lock(fs);
+		f = AST_LIST_REMOVE_HEAD(&fs->write_q, frame_list);
+		ao2_unlock(fs);
+		if (!f) {
+			break;
+		}
+		/* Failures are logged by writestream_write(); there is nobody
+		 * left to report them to on this thread, so keep draining. */
+		writestream_write(fs, f);
+		ast_frfree(f);
+	}
+	ao2_ref(fs, -1);
+	return 0;
+}
+
+/*!
+ * \brief Hand a frame off to the stream's writer serializer
+ *
+ * The caller only pays for duplicating the frame; translation and the
+ * actual write happen on the recording writer pool.  A flush task is
+ * only pushed when the queue was empty, so a busy writer naturally
+ * coalesces several frames into one drain.
+ */
+static int writestream_queue(struct ast_filestream *fs, struct ast_frame *f)
+{
+	struct ast_frame *dup;
+	int was_empty;
+
+	if (!(dup = ast_frdup(f))) {
+		return -1;
+	}
+
+	ao2_lock(fs);
+	was_empty = !AST_LIST_FIRST(&fs->write_q);
+	AST_LIST_INSERT_TAIL(&fs->write_q, dup, frame_list);
+	ao2_unlock(fs);
+
+	if (was_empty && ast_taskprocessor_push(fs->write_tps, writestream_flush_task, ao2_bump(fs))) {
+		ao2_ref(fs, -1);
+		return -1;
+	}
+
+	return 0;
+}
+
+int ast_writestream(struct ast_filestream *fs, struct ast_frame *f)
+{
+	if (f->frametype == AST_FRAME_VIDEO) {
+		if (ast_format_get_type(fs->fmt->format) == AST_MEDIA_TYPE_AUDIO) {
+			/* This is the audio portion.  Call the video one... */
+			if (!fs->vfs && fs->filename) {
+				const char *type = ast_format_get_name(f->subclass.format);
+				fs->vfs = ast_writefile(fs->filename, type, NULL, fs->flags, 0, fs->mode);
+				ast_debug(1, "Opened video output file\n");
+			}
+			if (fs->vfs)
+				return ast_writestream(fs->vfs, f);
+			/* else ignore */
+			return 0;
+		}
+	} else if (f->frametype != AST_FRAME_VOICE) {
+		ast_log(LOG_WARNING, "Tried to write non-voice frame\n");
+		return -1;
+	}
+	if (fs->write_tps) {
+		return writestream_queue(fs, f);
+	}
+	return writestream_write(fs, f);
+}
+
 static int copy(const char *infile, const char *outfile)
 {
 	int ifd, ofd, len;
@@ -418,12 +712,24 @@ static void filestream_close(struct ast_filestream *f)
 static void filestream_destructor(void *arg)
 {
 	struct ast_filestream *f = arg;
+	struct ast_frame *fr;
 	int status;
 	int pid = -1;
 
 	/* Stop a running stream if there is one */
 	filestream_close(f);
 
+	if (f->write_tps) {
+		/* The tasks that drain write_q each hold a stream reference, so by
+		 * the time the destructor runs the queue has normally been fully
+		 * flushed; anything still here was stranded by a failed push. */
+		while ((fr = AST_LIST_REMOVE_HEAD(&f->write_q, frame_list))) {
+			writestream_write(f, fr);
+			ast_frfree(fr);
+		}
+		ast_taskprocessor_unreference(f->write_tps);
+	}
+
 	/* destroy the translator on exit */
 	if (f->trans)
 		ast_translator_free_path(f->trans);
@@ -434,6 +740,14 @@ static void filestream_destructor(void *arg)
 	}
 
 	if (f->f) {
+		/* write_buffer is only allocated for streams opened by ast_writefile() */
+		if (ast_option_recordfsync && f->write_buffer) {
+			fflush(f->f);
+			if (fsync(fileno(f->f))) {
+				ast_log(LOG_WARNING, "Unable to fsync '%s': %s\n",
+					f->filename ? f->filename : "(null)", strerror(errno));
+			}
+		}
 		fclose(f->f);
 	}
 
@@ -457,6 +771,7 @@ static void filestream_destructor(void *arg)
 	ast_free((void *)f->orig_chan_name);
 	ao2_cleanup(f->lastwriteformat);
 	ao2_cleanup(f->fr.subclass.format);
+	ao2_cleanup(f->cached);
 	ast_module_unref(f->fmt->module);
 }
 
@@ -585,6 +900,7 @@ static int filehelper(const char *filename, const void *arg2, const char *fmt, c
 				struct ast_channel *chan = (struct ast_channel *)arg2;
 				FILE *bfile;
 				struct ast_filestream *s;
+				struct sound_cache_entry *cached = NULL;
 
 				if ((ast_format_cmp(ast_channel_writeformat(chan), f->format) == AST_FORMAT_CMP_NOT_EQUAL) &&
 				     !(((ast_format_get_type(f->format) == AST_MEDIA_TYPE_AUDIO) && fmt) ||
@@ -592,16 +908,19 @@ static int filehelper(const char *filename, const void *arg2, const char *fmt, c
 					ast_free(fn);
 					continue;	/* not a supported format */
 				}
-				if ( (bfile = fopen(fn, "r")) == NULL) {
+				bfile = sound_cache_fopen(fn, &st, &cached);
+				if (!bfile && (bfile = fopen(fn, "r")) == NULL) {
 					ast_free(fn);
 					continue;	/* cannot open file */
 				}
 				s = get_filestream(f, bfile);
 				if (!s) {
 					fclose(bfile);
+					ao2_cleanup(cached);
 					ast_free(fn);	/* cannot allocate descriptor */
 					continue;
 				}
+				s->cached = cached;
 				if (open_wrapper(s)) {
 					ast_free(fn);
 					ast_closestream(s);
@@ -738,7 +1057,7 @@ static int fileexists_test(const char *filename, const char *fmt, const char *la
  * \retval 1 true. file exists and result format is set
  * \retval 0 false. file does not exist.
  */
-static int fileexists_core(const char *filename, const char *fmt, const char *preflang,
+static int fileexists_scan(const char *filename, const char *fmt, const char *preflang,
 			   char *buf, int buflen, struct ast_format_cap *result_cap)
 {
 	char *lang;
@@ -787,6 +1106,127 @@ static int fileexists_core(const char *filename, const char *fmt, const char *pr
 	return 0;
 }
 
+#ifdef HAVE_INOTIFY
+/*!
+ * \internal
+ * \brief Remember a successful resolution and watch its directory for changes.
+ */
+static void fileexists_cache_store(const char *key, const char *resolved,
+	struct ast_format_cap *cap, unsigned int generation)
+{
+	struct fileexists_cache_entry *entry;
+	char *dir, *sep;
+	char dirbuf[PATH_MAX];
+
+	entry = ao2_alloc_options(sizeof(*entry) + strlen(key) + 1,
+		fileexists_cache_entry_destructor, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!entry) {
+		return;
+	}
+	strcpy(entry->key, key); /* Safe */
+	entry->generation = generation;
+	entry->cap = ao2_bump(cap);
+	entry->resolved = ast_strdup(resolved);
+	if (!entry->resolved) {
+		ao2_ref(entry, -1);
+		return;
+	}
+
+	/* The resolved name is relative to the sounds directory unless
+	 * absolute; watch the directory actually holding the file.  Adding a
+	 * watch for an already watched directory just returns the existing
+	 * watch, so this stays cheap for popular directories. */
+	if (is_absolute_path(resolved)) {
+		ast_copy_string(dirbuf, resolved, sizeof(dirbuf));
+	} else {
+		snprintf(dirbuf, sizeof(dirbuf), "%s/sounds/%s", ast_config_AST_DATA_DIR, resolved);
+	}
+	dir = dirbuf;
+	if ((sep = strrchr(dir, '/'))) {
+		*sep = '\0';
+	} else {
+		dir = ".";
+	}
+	if (inotify_add_watch(fileexists_inotify_fd, dir,
+		IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM
+		| IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+		/* We would not notice the file changing, so do not cache it */
+		ao2_ref(entry, -1);
+		return;
+	}
+
+	ao2_link(fileexists_cache, entry);
+	ao2_ref(entry, -1);
+}
+#endif
+
+/*!
+ * \internal
+ * \brief Resolve a file through the cache, falling back to a full scan.
+ *
+ * Same contract as fileexists_scan().  Successful resolutions are cached
+ * and served without touching the filesystem until something changes in
+ * one of the directories we resolved files from.
+ */
+static int fileexists_core(const char *filename, const char *fmt, const char *preflang,
+			   char *buf, int buflen, struct ast_format_cap *result_cap)
+{
+#ifdef HAVE_INOTIFY
+	struct fileexists_cache_entry *entry;
+	struct ast_format_cap *cache_cap;
+	unsigned int generation;
+	int res;
+
+	if (fileexists_inotify_fd < 0 || !buf || is_remote_path(filename)) {
+		return fileexists_scan(filename, fmt, preflang, buf, buflen, result_cap);
+	}
+
+	{
+		/* '\n' cannot appear in any of the three parts */
+		char key[strlen(filename) + strlen(S_OR(fmt, "")) + strlen(S_OR(preflang, "")) + 3];
+
+		snprintf(key, sizeof(key), "%s\n%s\n%s", filename, S_OR(fmt, ""), S_OR(preflang, ""));
+
+		entry = ao2_find(fileexists_cache, key, OBJ_SEARCH_KEY);
+		if (entry) {
+			if (entry->generation == (unsigned int) fileexists_cache_generation) {
+				ast_copy_string(buf, entry->resolved, buflen);
+				if (result_cap) {
+					ast_format_cap_append_from_cap(result_cap, entry->cap, AST_MEDIA_TYPE_UNKNOWN);
+				}
+				ao2_ref(entry, -1);
+				return 1;
+			}
+			/* A watched directory changed since this was computed */
+			ao2_unlink(fileexists_cache, entry);
+			ao2_ref(entry, -1);
+		}
+
+		cache_cap = ast_format_cap_alloc(AST_FORMAT_CAP_FLAG_DEFAULT);
+		if (!cache_cap) {
+			return fileexists_scan(filename, fmt, preflang, buf, buflen, result_cap);
+		}
+
+		/* Snapshot the generation first so a racing change marks us stale */
+		generation = (unsigned int) fileexists_cache_generation;
+		res = fileexists_scan(filename, fmt, preflang, buf, buflen, cache_cap);
+		if (res) {
+			if (result_cap) {
+				ast_format_cap_append_from_cap(result_cap, cache_cap, AST_MEDIA_TYPE_UNKNOWN);
+			}
+			if (ao2_container_count(fileexists_cache) < FILEEXISTS_CACHE_MAX_ENTRIES) {
+				fileexists_cache_store(key, buf, cache_cap, generation);
+			}
+		}
+		ao2_ref(cache_cap, -1);
+	}
+
+	return res;
+#else
+	return fileexists_scan(filename, fmt, preflang, buf, buflen, result_cap);
+#endif
+}
+
 struct ast_filestream *ast_openstream(struct ast_channel *chan, const char *filename, const char *preflang)
 {
 	return ast_openstream_full(chan, filename, preflang, 0);
@@ -1488,6 +1928,15 @@ struct ast_filestream *ast_writefile(const char *filename, const char *type, con
 				if ((fs->write_buffer = ast_malloc(32768))) {
 					setvbuf(fs->f, fs->write_buffer, _IOFBF, 32768);
 				}
+				if (record_pool) {
+					char tps_name[AST_TASKPROCESSOR_MAX_NAME + 1];
+
+					/* Create name with seq number appended. */
+					ast_taskprocessor_build_name(tps_name, sizeof(tps_name), "recwriter");
+
+					/* If this fails the stream simply writes inline */
+					fs->write_tps = ast_threadpool_serializer(tps_name, record_pool);
+				}
 			}
 			if (!fs || rewrite_wrapper(fs, comment)) {
 				ast_log(LOG_WARNING, "Unable to rewrite %s\n", fn);
@@ -2016,13 +2465,74 @@ static struct ast_cli_entry cli_file[] = {
 
 static void file_shutdown(void)
 {
+	if (record_pool) {
+		ast_threadpool_shutdown(record_pool);
+		record_pool = NULL;
+	}
+
 	ast_cli_unregister_multiple(cli_file, ARRAY_LEN(cli_file));
 	STASIS_MESSAGE_TYPE_CLEANUP(ast_format_register_type);
 	STASIS_MESSAGE_TYPE_CLEANUP(ast_format_unregister_type);
+
+	if (sound_cache) {
+		AST_LIST_LOCK(&sound_cache_lru);
+		while (AST_LIST_REMOVE_HEAD(&sound_cache_lru, list)) {
+		}
+		sound_cache_bytes = 0;
+		AST_LIST_UNLOCK(&sound_cache_lru);
+		ao2_cleanup(sound_cache);
+		sound_cache = NULL;
+	}
+
+#ifdef HAVE_INOTIFY
+	if (fileexists_inotify_fd > -1) {
+		int fd = fileexists_inotify_fd;
+
+		/* Makes the watcher thread's read() fail and the thread exit */
+		fileexists_inotify_fd = -1;
+		close(fd);
+	}
+	ao2_cleanup(fileexists_cache);
+	fileexists_cache = NULL;
+#endif
 }
 
 int ast_file_init(void)
 {
+	/* If allocation fails the cache simply stays disabled */
+	sound_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_NOLOCK, 0,
+		SOUND_CACHE_BUCKETS, sound_cache_entry_hash_fn, NULL, sound_cache_entry_cmp_fn);
+
+	if (ast_option_recordasyncthreads > 0) {
+		struct ast_threadpool_options pool_opts = {
+			.version = AST_THREADPOOL_OPTIONS_VERSION,
+			.idle_timeout = 20,
+			.auto_increment = 1,
+			.initial_size = 0,
+			.max_size = ast_option_recordasyncthreads,
+		};
+
+		/* If creation fails recordings are simply written inline */
+		record_pool = ast_threadpool_create("recwriter", NULL, &pool_opts);
+	}
+
+#ifdef HAVE_INOTIFY
+	fileexists_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0,
+		FILEEXISTS_CACHE_BUCKETS, fileexists_cache_entry_hash_fn, NULL,
+		fileexists_cache_entry_cmp_fn);
+	if (fileexists_cache) {
+		pthread_t dont_care;
+
+		fileexists_inotify_fd = inotify_init();
+		if (fileexists_inotify_fd > -1
+			&& ast_pthread_create_detached_background(&dont_care, NULL,
+				fileexists_cache_thread, NULL)) {
+			close(fileexists_inotify_fd);
+			fileexists_inotify_fd = -1;
+		}
+	}
+#endif
+
 	STASIS_MESSAGE_TYPE_INIT(ast_format_register_type);
 	STASIS_MESSAGE_TYPE_INIT(ast_format_unregister_type);
 	ast_cli_register_multiple(cli_file, ARRAY_LEN(cli_file));
@@ -39,6 +39,12 @@
 /*! \brief Number of buckets to use for format interfaces (should be prime for performance reasons) */
 #define FORMAT_INTERFACE_BUCKETS 53
 
+/*! \brief Number of buckets to use for the SDP fmtp parse cache (should be prime for performance reasons) */
+#define FMTP_CACHE_BUCKETS 53
+
+/*! \brief Maximum number of interned fmtp parse results kept */
+#define FMTP_CACHE_MAX_ENTRIES 256
+
 /*! \brief Definition of a media format */
 struct ast_format {
 	/*! Name of the format */
@@ -64,14 +70,85 @@ struct format_interface {
 /*! \brief Container for registered format interfaces */
 static struct ao2_container *interfaces;
 
+/*! \brief An interned SDP fmtp parse result */
+struct fmtp_cache_entry {
+	/*! \brief The format the fmtp line was parsed against */
+	struct ast_format *base;
+	/*! \brief The format produced by the parse */
+	struct ast_format *result;
+	/*! \brief The raw fmtp attribute line */
+	char fmtp[0];
+};
+
+/*! \brief Search key for the fmtp parse cache */
+struct fmtp_cache_key {
+	/*! \brief The format the fmtp line is being parsed against */
+	const struct ast_format *base;
+	/*! \brief The raw fmtp attribute line */
+	const char *fmtp;
+};
+
+/*! \brief Container of interned SDP fmtp parse results */
+static struct ao2_container *fmtp_cache;
+
 AO2_STRING_FIELD_HASH_FN(format_interface, codec)
 AO2_STRING_FIELD_CMP_FN(format_interface, codec)
 
+static void fmtp_cache_entry_destroy(void *obj)
+{
+	struct fmtp_cache_entry *entry = obj;
+
+	ao2_cleanup(entry->base);
+	ao2_cleanup(entry->result);
+}
+
+static int fmtp_cache_entry_hash_fn(const void *obj, int flags)
+{
+	const char *key;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_KEY:
+		key = ((const struct fmtp_cache_key *) obj)->fmtp;
+		break;
+	case OBJ_SEARCH_OBJECT:
+		key = ((const struct fmtp_cache_entry *) obj)->fmtp;
+		break;
+	default:
+		ast_assert(0);
+		return 0;
+	}
+	return ast_str_hash(key);
+}
+
+static int fmtp_cache_entry_cmp_fn(void *obj, void *arg, int flags)
+{
+	const struct fmtp_cache_entry *entry = obj;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_KEY: {
+		const struct fmtp_cache_key *key = arg;
+
+		return (entry->base == key->base && !strcmp(entry->fmtp, key->fmtp))
+			? CMP_MATCH : 0;
+	}
+	case OBJ_SEARCH_OBJECT: {
+		const struct fmtp_cache_entry *right = arg;
+
+		return (entry->base == right->base && !strcmp(entry->fmtp, right->fmtp))
+			? CMP_MATCH : 0;
+	}
+	default:
+		return 0;
+	}
+}
+
 /*! \brief Function called when the process is shutting down */
 static void format_shutdown(void)
 {
 	ao2_cleanup(interfaces);
 	interfaces = NULL;
+	ao2_cleanup(fmtp_cache);
+	fmtp_cache = NULL;
 }
 
 int ast_format_init(void)
@@ -82,6 +159,14 @@ int ast_format_init(void)
 		return -1;
 	}
 
+	fmtp_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0,
+		FMTP_CACHE_BUCKETS, fmtp_cache_entry_hash_fn, NULL, fmtp_cache_entry_cmp_fn);
+	if (!fmtp_cache) {
+		ao2_cleanup(interfaces);
+		interfaces = NULL;
+		return -1;
+	}
+
 	ast_register_cleanup(format_shutdown);
 
 	return 0;
@@ -223,6 +308,11 @@ enum ast_format_cmp_res ast_format_cmp(const struct ast_format *format1, const s
 	return AST_FORMAT_CMP_EQUAL;
 }
 
+int ast_format_attribute_cmp_required(const struct ast_format *format)
+{
+	return format->interface && format->interface->format_cmp ? 1 : 0;
+}
+
 struct ast_format *ast_format_joint(const struct ast_format *format1, const struct ast_format *format2)
 {
 	const struct ast_format_interface *interface;
@@ -283,6 +373,32 @@ const void *ast_format_attribute_get(const struct ast_format *format, const char
 	return interface->format_attribute_get(format, name);
 }
 
+/*!
+ * \internal
+ * \brief Intern a parsed fmtp result for later reuse.
+ */
+static void fmtp_cache_store(const struct ast_format *base, const char *attributes,
+	struct ast_format *result)
+{
+	struct fmtp_cache_entry *entry;
+
+	if (ao2_container_count(fmtp_cache) >= FMTP_CACHE_MAX_ENTRIES) {
+		return;
+	}
+
+	entry = ao2_alloc_options(sizeof(*entry) + strlen(attributes) + 1,
+		fmtp_cache_entry_destroy, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!entry) {
+		return;
+	}
+	entry->base = ao2_bump((struct ast_format *) base);
+	entry->result = ao2_bump(result);
+	strcpy(entry->fmtp, attributes); /* Safe */
+
+	ao2_link(fmtp_cache, entry);
+	ao2_ref(entry, -1);
+}
+
 struct ast_format *ast_format_parse_sdp_fmtp(const struct ast_format *format, const char *attributes)
 {
 	const struct ast_format_interface *interface = format->interface;
@@ -299,6 +415,32 @@ struct ast_format *ast_format_parse_sdp_fmtp(const struct ast_format *format, co
 		return ao2_bump((struct ast_format*)format);
 	}
 
+	/*
+	 * Homogeneous device fleets send the same fmtp line over and over, so
+	 * intern the parse results.  Formats are immutable once created and the
+	 * parse callbacks are pure functions of the format and attribute line,
+	 * making a cached result safe to share.  Only formats permanently bound
+	 * to their interface are cached so an interface registered later cannot
+	 * change what a cached key would have produced.
+	 */
+	if (format->interface && attributes) {
+		struct fmtp_cache_key key = { format, attributes };
+		struct fmtp_cache_entry *entry = ao2_find(fmtp_cache, &key, OBJ_SEARCH_KEY);
+		struct ast_format *result;
+
+		if (entry) {
+			result = ao2_bump(entry->result);
+			ao2_ref(entry, -1);
+			return result;
+		}
+
+		result = interface->format_parse_sdp_fmtp(format, attributes);
+		if (result) {
+			fmtp_cache_store(format, attributes, result);
+		}
+		return result;
+	}
+
 	return interface->format_parse_sdp_fmtp(format, attributes);
 }
 
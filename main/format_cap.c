@@ -54,12 +54,62 @@ struct format_cap_framed {
 struct ast_format_cap {
 	/*! \brief Vector of formats, indexed using the codec identifier */
 	AST_VECTOR(, struct format_cap_framed_list) formats;
-	/*! \brief Vector of formats, added in preference order */
-	AST_VECTOR(, struct format_cap_framed *) preference_order;
+	/*!
+	 * \brief Vector of formats, added in preference order
+	 *
+	 * Most caps hold only a handful of formats, so the first several
+	 * entries are stored inline to avoid a heap allocation per cap.
+	 */
+	AST_VECTOR_SMALL(, struct format_cap_framed *, 8) preference_order;
+	/*! \brief Bitmask of codec identifiers present in the cap (ids below CAP_MASK_BITS) */
+	uint64_t codec_ids[2];
+	/*! \brief As \c codec_ids, restricted to formats that need no attribute negotiation */
+	uint64_t plain_ids[2];
+	/*! \brief Number of formats whose codec identifier does not fit the masks */
+	unsigned int unmapped;
 	/*! \brief Global framing size, applies to all formats if no framing present on format */
 	unsigned int framing;
 };
 
+/*! \brief Number of codec identifiers the cap bitmasks can describe */
+#define CAP_MASK_BITS (8 * sizeof(((struct ast_format_cap *) 0)->codec_ids))
+
+/*!
+ * \internal
+ * \brief Record a format's codec identifier in the cap bitmasks
+ *
+ * Codec identifiers are the small integers codec.c hands out at
+ * registration, and a cap never holds two formats with the same one, so
+ * set/clear can be unconditional.  Identifiers beyond the masks are only
+ * counted; any such format disables the cap-vs-cap fast paths.
+ */
+static void format_cap_mask_set(struct ast_format_cap *cap, const struct ast_format *format)
+{
+	unsigned int id = ast_format_get_codec_id(format);
+
+	if (id >= CAP_MASK_BITS) {
+		cap->unmapped++;
+		return;
+	}
+	cap->codec_ids[id / 64] |= (uint64_t) 1 << (id % 64);
+	if (!ast_format_attribute_cmp_required(format)) {
+		cap->plain_ids[id / 64] |= (uint64_t) 1 << (id % 64);
+	}
+}
+
+/*! \internal \brief Drop a format's codec identifier from the cap bitmasks */
+static void format_cap_mask_clear(struct ast_format_cap *cap, const struct ast_format *format)
+{
+	unsigned int id = ast_format_get_codec_id(format);
+
+	if (id >= CAP_MASK_BITS) {
+		cap->unmapped--;
+		return;
+	}
+	cap->codec_ids[id / 64] &= ~((uint64_t) 1 << (id % 64));
+	cap->plain_ids[id / 64] &= ~((uint64_t) 1 << (id % 64));
+}
+
 /*! \brief Linked list for formats */
 AST_LIST_HEAD_NOLOCK(format_cap_framed_list, format_cap_framed);
 
@@ -88,7 +138,7 @@ static void format_cap_destroy(void *obj)
 		/* This will always be non-null, unlike formats */
 		ao2_ref(framed, -1);
 	}
-	AST_VECTOR_FREE(&cap->preference_order);
+	AST_VECTOR_SMALL_FREE(&cap->preference_order);
 }
 
 /*!
@@ -105,11 +155,13 @@ static inline int format_cap_init(struct ast_format_cap *cap, enum ast_format_ca
 		return -1;
 	}
 
-	/* TODO: Look at common usage of this and determine a good starting point */
-	if (AST_VECTOR_INIT(&cap->preference_order, 5)) {
+	if (AST_VECTOR_SMALL_INIT(&cap->preference_order)) {
 		return -1;
 	}
 
+	cap->codec_ids[0] = cap->codec_ids[1] = 0;
+	cap->plain_ids[0] = cap->plain_ids[1] = 0;
+	cap->unmapped = 0;
 	cap->framing = UINT_MAX;
 	return 0;
 }
@@ -161,7 +213,7 @@ static inline int format_cap_framed_init(struct format_cap_framed *framed, struc
 	list = AST_VECTOR_GET_ADDR(&cap->formats, ast_format_get_codec_id(format));
 
 	/* This takes the allocation reference */
-	if (AST_VECTOR_APPEND(&cap->preference_order, framed)) {
+	if (AST_VECTOR_SMALL_APPEND(&cap->preference_order, framed)) {
 		ao2_ref(framed, -1);
 		return -1;
 	}
@@ -170,6 +222,7 @@ static inline int format_cap_framed_init(struct format_cap_framed *framed, struc
 	ao2_ref(framed, +1);
 	AST_LIST_INSERT_HEAD(list, framed, entry);
 
+	format_cap_mask_set(cap, format);
 	cap->framing = MIN(cap->framing, framing ? framing : ast_format_get_default_ms(format));
 
 	return 0;
@@ -516,8 +569,13 @@ int ast_format_cap_remove(struct ast_format_cap *cap, struct ast_format *format)
 	}
 	AST_LIST_TRAVERSE_SAFE_END;
 
-	return AST_VECTOR_REMOVE_CMP_ORDERED(&cap->preference_order, format,
-		FORMAT_CAP_FRAMED_ELEM_CMP, FORMAT_CAP_FRAMED_ELEM_CLEANUP);
+	if (AST_VECTOR_REMOVE_CMP_ORDERED(&cap->preference_order, format,
+		FORMAT_CAP_FRAMED_ELEM_CMP, FORMAT_CAP_FRAMED_ELEM_CLEANUP)) {
+		return -1;
+	}
+
+	format_cap_mask_clear(cap, format);
+	return 0;
 }
 
 void ast_format_cap_remove_by_type(struct ast_format_cap *cap, enum ast_media_type type)
@@ -537,6 +595,7 @@ void ast_format_cap_remove_by_type(struct ast_format_cap *cap, enum ast_media_ty
 			AST_LIST_REMOVE_CURRENT(entry);
 			AST_VECTOR_REMOVE_CMP_ORDERED(&cap->preference_order, framed->format,
 				FORMAT_CAP_FRAMED_ELEM_CMP, FORMAT_CAP_FRAMED_ELEM_CLEANUP);
+			format_cap_mask_clear(cap, framed->format);
 			ao2_ref(framed, -1);
 		}
 		AST_LIST_TRAVERSE_SAFE_END;
@@ -584,10 +643,23 @@ enum ast_format_cmp_res ast_format_cap_iscompatible_format(const struct ast_form
 	enum ast_format_cmp_res res = AST_FORMAT_CMP_NOT_EQUAL;
 	struct format_cap_framed_list *list;
 	struct format_cap_framed *framed;
+	unsigned int id;
 
 	ast_assert(format != NULL);
 
-	if (ast_format_get_codec_id(format) >= AST_VECTOR_SIZE(&cap->formats)) {
+	id = ast_format_get_codec_id(format);
+	if (id < CAP_MASK_BITS) {
+		uint64_t bit = (uint64_t) 1 << (id % 64);
+
+		if (!(cap->codec_ids[id / 64] & bit)) {
+			return AST_FORMAT_CMP_NOT_EQUAL;
+		}
+		if ((cap->plain_ids[id / 64] & bit) && !ast_format_attribute_cmp_required(format)) {
+			return AST_FORMAT_CMP_EQUAL;
+		}
+	}
+
+	if (id >= AST_VECTOR_SIZE(&cap->formats)) {
 		return AST_FORMAT_CMP_NOT_EQUAL;
 	}
 
@@ -625,11 +697,33 @@ int ast_format_cap_has_type(const struct ast_format_cap *cap, enum ast_media_typ
 	return 0;
 }
 
+/*!
+ * \internal
+ * \brief Determine whether the cap bitmasks can answer a cap-vs-cap question
+ *
+ * \retval 1 when both caps are fully described by their masks
+ */
+static int format_cap_masks_usable(const struct ast_format_cap *cap1, const struct ast_format_cap *cap2)
+{
+	return !cap1->unmapped && !cap2->unmapped;
+}
+
+/*! \internal \brief Check two cap bitmask pairs for any shared codec identifier */
+static int format_cap_masks_overlap(const uint64_t *ids1, const uint64_t *ids2)
+{
+	return (ids1[0] & ids2[0]) || (ids1[1] & ids2[1]);
+}
+
 int ast_format_cap_get_compatible(const struct ast_format_cap *cap1, const struct ast_format_cap *cap2,
 	struct ast_format_cap *result)
 {
 	int idx, res = 0;
 
+	if (format_cap_masks_usable(cap1, cap2)
+		&& !format_cap_masks_overlap(cap1->codec_ids, cap2->codec_ids)) {
+		return 0;
+	}
+
 	for (idx = 0; idx < AST_VECTOR_SIZE(&cap1->preference_order); ++idx) {
 		struct format_cap_framed *framed = AST_VECTOR_GET(&cap1->preference_order, idx);
 		struct ast_format *format;
@@ -654,6 +748,17 @@ int ast_format_cap_iscompatible(const struct ast_format_cap *cap1, const struct
 {
 	int idx;
 
+	if (format_cap_masks_usable(cap1, cap2)) {
+		if (!format_cap_masks_overlap(cap1->codec_ids, cap2->codec_ids)) {
+			return 0;
+		}
+		/* A shared format needing no attribute negotiation on either
+		 * side settles the question without touching the formats. */
+		if (format_cap_masks_overlap(cap1->plain_ids, cap2->plain_ids)) {
+			return 1;
+		}
+	}
+
 	for (idx = 0; idx < AST_VECTOR_SIZE(&cap1->preference_order); ++idx) {
 		struct format_cap_framed *framed = AST_VECTOR_GET(&cap1->preference_order, idx);
 
@@ -690,6 +795,13 @@ int ast_format_cap_identical(const struct ast_format_cap *cap1, const struct ast
 		return 0; /* if they are not the same size, they are not identical */
 	}
 
+	/* Identical caps must cover identical codec identifiers */
+	if (format_cap_masks_usable(cap1, cap2)
+		&& (cap1->codec_ids[0] != cap2->codec_ids[0]
+			|| cap1->codec_ids[1] != cap2->codec_ids[1])) {
+		return 0;
+	}
+
 	if (!internal_format_cap_identical(cap1, cap2)) {
 		return 0;
 	}
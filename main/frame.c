@@ -56,7 +56,7 @@ static void frame_cache_cleanup(void *data);
 AST_THREADSTORAGE_CUSTOM(frame_cache, NULL, frame_cache_cleanup);
 
 /*!
- * \brief Maximum ast_frame cache size
+ * \brief Maximum number of cached frames per size class
  *
  * In most cases where the frame header cache will be useful, the size
  * of the cache will stay very small.  However, it is not always the case that
@@ -64,16 +64,60 @@ AST_THREADSTORAGE_CUSTOM(frame_cache, NULL, frame_cache_cleanup);
  * sometimes a thread will never have any frames in its cache, or the cache
  * will never be pulled from.  For the latter case, we limit the maximum size.
  */
-#define FRAME_CACHE_MAX_SIZE	10
+#define FRAME_CACHE_MAX_SIZE	32
+
+/*!
+ * \brief Size classes for cached frame allocations
+ *
+ * Combined header+data allocations made by ast_frdup() are rounded up to
+ * the nearest class so the steady state media path (20ms of slin at
+ * 8/16/48kHz is 160/320/960 data bytes) recycles buffers without touching
+ * the heap.  Class 0 holds bare headers for ast_frame_header_new().
+ * Oversize allocations are not cached.
+ */
+#define FRAME_CACHE_CLASS_COUNT	4
+
+static const size_t frame_cache_class_len[FRAME_CACHE_CLASS_COUNT] = {
+	sizeof(struct ast_frame),
+	sizeof(struct ast_frame) + AST_FRIENDLY_OFFSET + 160,
+	sizeof(struct ast_frame) + AST_FRIENDLY_OFFSET + 320,
+	sizeof(struct ast_frame) + AST_FRIENDLY_OFFSET + 960,
+};
 
 /*! \brief This is just so ast_frames, a list head struct for holding a list of
  *  ast_frame structures, is defined. */
 AST_LIST_HEAD_NOLOCK(ast_frames, ast_frame);
 
 struct ast_frame_cache {
-	struct ast_frames list;
-	size_t size;
+	struct ast_frames list[FRAME_CACHE_CLASS_COUNT];
+	size_t size[FRAME_CACHE_CLASS_COUNT];
 };
+
+/*! \brief Smallest class able to hold an allocation of len bytes, or -1 */
+static int frame_cache_class_for_alloc(size_t len)
+{
+	int idx;
+
+	for (idx = 0; idx < FRAME_CACHE_CLASS_COUNT; idx++) {
+		if (len <= frame_cache_class_len[idx]) {
+			return idx;
+		}
+	}
+	return -1;
+}
+
+/*! \brief Class a freed allocation belongs to, or -1 if it is not cacheable */
+static int frame_cache_class_for_free(size_t mallocd_hdr_len)
+{
+	int idx;
+
+	for (idx = 0; idx < FRAME_CACHE_CLASS_COUNT; idx++) {
+		if (mallocd_hdr_len == frame_cache_class_len[idx]) {
+			return idx;
+		}
+	}
+	return -1;
+}
 #endif
 
 struct ast_frame ast_null_frame = { AST_FRAME_NULL, };
@@ -86,12 +130,12 @@ static struct ast_frame *ast_frame_header_new(const char *file, int line, const
 	struct ast_frame_cache *frames;
 
 	if ((frames = ast_threadstorage_get(&frame_cache, sizeof(*frames)))) {
-		if ((f = AST_LIST_REMOVE_HEAD(&frames->list, frame_list))) {
+		if ((f = AST_LIST_REMOVE_HEAD(&frames->list[0], frame_list))) {
 			size_t mallocd_len = f->mallocd_hdr_len;
 
 			memset(f, 0, sizeof(*f));
 			f->mallocd_hdr_len = mallocd_len;
-			frames->size--;
+			frames->size[0]--;
 			return f;
 		}
 	}
@@ -111,9 +155,12 @@ static void frame_cache_cleanup(void *data)
 {
 	struct ast_frame_cache *frames = data;
 	struct ast_frame *f;
+	int idx;
 
-	while ((f = AST_LIST_REMOVE_HEAD(&frames->list, frame_list)))
-		ast_free(f);
+	for (idx = 0; idx < FRAME_CACHE_CLASS_COUNT; idx++) {
+		while ((f = AST_LIST_REMOVE_HEAD(&frames->list[idx], frame_list)))
+			ast_free(f);
+	}
 
 	ast_free(frames);
 }
@@ -124,6 +171,20 @@ static void __frame_free(struct ast_frame *fr, int cache)
 	if (!fr->mallocd)
 		return;
 
+	if (fr->mallocd & AST_MALLOCD_DATA_SHARED) {
+		/* Drop our reference on the shared data block.  Doing this
+		 * first leaves a plain malloc'd header eligible for the
+		 * cache below. */
+		if (fr->data.ptr) {
+			ao2_ref(fr->data.ptr - fr->offset, -1);
+			fr->data.ptr = NULL;
+		}
+		fr->mallocd &= ~AST_MALLOCD_DATA_SHARED;
+		if (!fr->mallocd) {
+			return;
+		}
+	}
+
 #if !defined(NO_FRAME_CACHE)
 	if (fr->mallocd == AST_MALLOCD_HDR
 		&& cache
@@ -131,9 +192,10 @@ static void __frame_free(struct ast_frame *fr, int cache)
 		/* Cool, only the header is malloc'd, let's just cache those for now
 		 * to keep things simple... */
 		struct ast_frame_cache *frames;
+		int class_idx = frame_cache_class_for_free(fr->mallocd_hdr_len);
 
 		frames = ast_threadstorage_get(&frame_cache, sizeof(*frames));
-		if (frames && frames->size < FRAME_CACHE_MAX_SIZE) {
+		if (frames && class_idx >= 0 && frames->size[class_idx] < FRAME_CACHE_MAX_SIZE) {
 			if (fr->frametype == AST_FRAME_VOICE
 				|| fr->frametype == AST_FRAME_VIDEO
 				|| fr->frametype == AST_FRAME_IMAGE) {
@@ -142,8 +204,8 @@ static void __frame_free(struct ast_frame *fr, int cache)
 				ao2_cleanup(fr->subclass.topology);
 			}
 
-			AST_LIST_INSERT_HEAD(&frames->list, fr, frame_list);
-			frames->size++;
+			AST_LIST_INSERT_HEAD(&frames->list[class_idx], fr, frame_list);
+			frames->size[class_idx]++;
 			return;
 		}
 	}
@@ -269,12 +331,20 @@ struct ast_frame *__ast_frisolate(struct ast_frame *fr, const char *file, int li
 	}
 
 	if (!(fr->mallocd & AST_MALLOCD_DATA))  {
-		/* The original frame has a non-malloced data buffer. */
+		/* The original frame has a non-malloced or shared data buffer. */
+		void *shared_block = NULL;
+
 		if (!fr->datalen && fr->frametype != AST_FRAME_TEXT) {
 			/* Actually it's just an int so we can simply copy it. */
 			out->data.uint32 = fr->data.uint32;
 			return out;
 		}
+		if ((fr->mallocd & AST_MALLOCD_DATA_SHARED) && out == fr) {
+			/* We are giving the frame a private copy below, so our
+			 * reference on the shared block must be dropped once the
+			 * data has been copied out of it. */
+			shared_block = fr->data.ptr - fr->offset;
+		}
 		/*
 		 * Duplicate the data buffer and put it into the isolated frame
 		 * which may also be the original frame.
@@ -290,7 +360,11 @@ struct ast_frame *__ast_frisolate(struct ast_frame *fr, const char *file, int li
 		out->offset = AST_FRIENDLY_OFFSET;
 		memcpy(newdata, fr->data.ptr, fr->datalen);
 		out->data.ptr = newdata;
+		out->mallocd &= ~AST_MALLOCD_DATA_SHARED;
 		out->mallocd |= AST_MALLOCD_DATA;
+		if (shared_block) {
+			ao2_ref(shared_block, -1);
+		}
 	} else if (out != fr) {
 		/* Steal the data buffer from the original frame. */
 		out->data = fr->data;
@@ -325,20 +399,22 @@ struct ast_frame *__ast_frdup(const struct ast_frame *f, const char *file, int l
 		len += srclen + 1;
 
 #if !defined(NO_FRAME_CACHE)
-	if ((frames = ast_threadstorage_get(&frame_cache, sizeof(*frames)))) {
-		AST_LIST_TRAVERSE_SAFE_BEGIN(&frames->list, out, frame_list) {
-			if (out->mallocd_hdr_len >= len) {
+	{
+		int class_idx = frame_cache_class_for_alloc(len);
+
+		if (class_idx >= 0) {
+			/* Round the allocation up to its class so it can be recycled. */
+			len = frame_cache_class_len[class_idx];
+			if ((frames = ast_threadstorage_get(&frame_cache, sizeof(*frames)))
+				&& (out = AST_LIST_REMOVE_HEAD(&frames->list[class_idx], frame_list))) {
 				size_t mallocd_len = out->mallocd_hdr_len;
 
-				AST_LIST_REMOVE_CURRENT(frame_list);
 				memset(out, 0, sizeof(*out));
 				out->mallocd_hdr_len = mallocd_len;
 				buf = out;
-				frames->size--;
-				break;
+				frames->size[class_idx]--;
 			}
 		}
-		AST_LIST_TRAVERSE_SAFE_END;
 	}
 #endif
 
@@ -393,6 +469,65 @@ struct ast_frame *__ast_frdup(const struct ast_frame *f, const char *file, int l
 	return out;
 }
 
+struct ast_frame *__ast_frdup_shared(const struct ast_frame *f, const char *file, int line, const char *func)
+{
+	struct ast_frame *out;
+	void *block;
+
+	if (!(out = ast_frame_header_new(file, line, func))) {
+		return NULL;
+	}
+
+	out->frametype = f->frametype;
+	out->subclass = f->subclass;
+	if ((f->frametype == AST_FRAME_VOICE) || (f->frametype == AST_FRAME_VIDEO) ||
+		(f->frametype == AST_FRAME_IMAGE)) {
+		ao2_bump(out->subclass.format);
+	} else if (f->frametype == AST_FRAME_CONTROL && f->subclass.integer == AST_CONTROL_ANSWER) {
+		ao2_bump(out->subclass.topology);
+	}
+	out->datalen = f->datalen;
+	out->samples = f->samples;
+	out->delivery = f->delivery;
+	out->mallocd = AST_MALLOCD_HDR;
+	if (!f->datalen) {
+		out->data = f->data;
+	} else if (f->mallocd & AST_MALLOCD_DATA_SHARED) {
+		/* The source data is already in a shared block; just take a
+		 * reference on it. */
+		ao2_ref(f->data.ptr - f->offset, +1);
+		out->data.ptr = f->data.ptr;
+		out->offset = f->offset;
+		out->mallocd |= AST_MALLOCD_DATA_SHARED;
+	} else {
+		/* Migrate the data into a shared reference counted block.
+		 * This is the one and only copy; every subsequent shared
+		 * duplicate just bumps the block reference. */
+		block = ao2_alloc_options(AST_FRIENDLY_OFFSET + f->datalen, NULL,
+			AO2_ALLOC_OPT_LOCK_NOLOCK);
+		if (!block) {
+			ast_frame_free(out, 0);
+			return NULL;
+		}
+		memcpy(block + AST_FRIENDLY_OFFSET, f->data.ptr, f->datalen);
+		out->data.ptr = block + AST_FRIENDLY_OFFSET;
+		out->offset = AST_FRIENDLY_OFFSET;
+		out->mallocd |= AST_MALLOCD_DATA_SHARED;
+	}
+	if (f->src) {
+		out->src = ast_strdup(f->src);
+		if (out->src) {
+			out->mallocd |= AST_MALLOCD_SRC;
+		}
+	}
+	ast_copy_flags(out, f, AST_FLAGS_ALL);
+	out->ts = f->ts;
+	out->len = f->len;
+	out->seqno = f->seqno;
+	out->stream_num = f->stream_num;
+	return out;
+}
+
 void ast_swapcopy_samples(void *dst, const void *src, int samples)
 {
 	int i;
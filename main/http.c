@@ -47,6 +47,7 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <signal.h>
 #include <fcntl.h>
 
@@ -64,6 +65,7 @@
 #include "asterisk/astobj2.h"
 #include "asterisk/netsock2.h"
 #include "asterisk/json.h"
+#include "asterisk/threadpool.h"
 
 #define MAX_PREFIX 80
 #define DEFAULT_PORT 8088
@@ -79,6 +81,10 @@
 #define	MAX_SERVER_NAME_LENGTH 128
 /*! Max size for the http response header */
 #define	DEFAULT_RESPONSE_HEADER_LENGTH 512
+/*! (s) Idle time before an HTTP connection worker thread exits. */
+#define HTTP_POOL_IDLE_TIMEOUT 60
+/*! Number of worker threads to add when the HTTP pool needs to grow. */
+#define HTTP_POOL_AUTO_INCREMENT 5
 
 /*! Maximum application/json or application/x-www-form-urlencoded body content length. */
 #if !defined(LOW_MEMORY)
@@ -110,8 +116,37 @@ static int session_count = 0;
 
 static struct ast_tls_config http_tls_cfg;
 
+/*!
+ * Pool of worker threads for serving HTTP connections.  Reusing idle
+ * workers avoids a thread create/destroy cycle per connection, which
+ * matters when REST clients open many short lived connections in bursts.
+ */
+static struct ast_threadpool *http_pool;
+
 static void *httpd_helper_thread(void *arg);
 
+/*! \brief Threadpool task running a single HTTP connection to completion. */
+static int http_connection_task(void *data)
+{
+	ast_tcptls_server_process(data);
+	return 0;
+}
+
+/*!
+ * \brief Dispatch an accepted connection to the HTTP worker pool.
+ *
+ * Used as the dispatch_fn of our tcptls servers.  A non-zero return
+ * makes the accept thread fall back to a dedicated connection thread,
+ * so failure here never drops the connection.
+ */
+static int http_dispatch_connection(void *data)
+{
+	if (!http_pool) {
+		return -1;
+	}
+	return ast_threadpool_push(http_pool, http_connection_task, data);
+}
+
 /*!
  * For standard configuration we have up to two accepting threads,
  * one for http, one for https. If TEST_FRAMEWORK is enabled it's
@@ -136,6 +171,7 @@ static struct ast_tcptls_session_args https_desc = {
 	.name = "https server",
 	.accept_fn = ast_tcptls_server_root,
 	.worker_fn = httpd_helper_thread,
+	.dispatch_fn = http_dispatch_connection,
 };
 
 static AST_RWLIST_HEAD_STATIC(uris, ast_http_uri);	/*!< list of supported handlers */
@@ -464,18 +500,23 @@ void ast_http_send(struct ast_tcptls_session_instance *ser,
 	struct timeval now = ast_tvnow();
 	struct ast_tm tm;
 	char timebuf[80];
-	char buf[256];
+	char buf[8192];
 	int len;
 	int content_length = 0;
 	int close_connection;
 	struct ast_str *server_header_field = ast_str_create(MAX_SERVER_NAME_LENGTH);
+	struct ast_str *header = ast_str_create(256);
+	struct iovec iov[2];
+	int iovcnt;
+	ssize_t total;
 	int send_content;
 
-	if (!ser || !server_header_field) {
+	if (!ser || !server_header_field || !header) {
 		/* The connection is not open. */
 		ast_free(http_header);
 		ast_free(out);
 		ast_free(server_header_field);
+		ast_free(header);
 		return;
 	}
 
@@ -522,8 +563,10 @@ void ast_http_send(struct ast_tcptls_session_instance *ser,
 
 	send_content = method != AST_HTTP_HEAD || status_code >= 400;
 
-	/* send http header */
-	if (ast_iostream_printf(ser->stream,
+	/* send http header and any string content in one vectored write so the
+	 * content is not copied and header plus content leave in a single
+	 * syscall/TLS record */
+	ast_str_set(&header, 0,
 		"HTTP/1.1 %d %s\r\n"
 		"%s"
 		"Date: %s\r\n"
@@ -531,18 +574,28 @@ void ast_http_send(struct ast_tcptls_session_instance *ser,
 		"%s"
 		"%s"
 		"Content-Length: %d\r\n"
-		"\r\n"
-		"%s",
+		"\r\n",
 		status_code, status_title ? status_title : "OK",
 		ast_str_buffer(server_header_field),
 		timebuf,
 		close_connection ? "Connection: close\r\n" : "",
 		static_content ? "" : "Cache-Control: no-cache, no-store\r\n",
 		http_header ? ast_str_buffer(http_header) : "",
-		content_length,
-		send_content && out && ast_str_strlen(out) ? ast_str_buffer(out) : ""
-		) <= 0) {
-		ast_debug(1, "ast_iostream_printf() failed: %s\n", strerror(errno));
+		content_length);
+
+	iov[0].iov_base = ast_str_buffer(header);
+	iov[0].iov_len = ast_str_strlen(header);
+	total = iov[0].iov_len;
+	iovcnt = 1;
+	if (send_content && out && ast_str_strlen(out)) {
+		iov[iovcnt].iov_base = ast_str_buffer(out);
+		iov[iovcnt].iov_len = ast_str_strlen(out);
+		total += iov[iovcnt].iov_len;
+		iovcnt++;
+	}
+
+	if (ast_iostream_writev(ser->stream, iov, iovcnt) != total) {
+		ast_debug(1, "ast_iostream_writev() failed: %s\n", strerror(errno));
 		close_connection = 1;
 	} else if (send_content && fd) {
 		/* send file content */
@@ -558,6 +611,7 @@ void ast_http_send(struct ast_tcptls_session_instance *ser,
 	ast_free(http_header);
 	ast_free(out);
 	ast_free(server_header_field);
+	ast_free(header);
 
 	if (close_connection) {
 		ast_debug(1, "HTTP closing session.  status_code:%d\n", status_code);
@@ -1070,15 +1124,27 @@ static int http_body_get_chunk_length(struct ast_tcptls_session_instance *ser)
  */
 static int http_body_check_chunk_sync(struct ast_tcptls_session_instance *ser)
 {
-	int res;
+	ssize_t res;
 	char chunk_sync[2];
-
-	/* Stay in fread until get the expected CRLF or timeout. */
-	res = ast_iostream_read(ser->stream, chunk_sync, sizeof(chunk_sync));
-	if (res < sizeof(chunk_sync)) {
-		ast_log(LOG_WARNING, "Short HTTP chunk sync read (Wanted %zu)\n",
-			sizeof(chunk_sync));
-		return -1;
+	size_t needed = sizeof(chunk_sync);
+	char *peeked;
+
+	/* Pull the CRLF from the stream's read-ahead buffer so it does not
+	 * cost a dedicated two byte read; the following chunk header usually
+	 * arrives in the same read. */
+	while (needed) {
+		res = ast_iostream_peek(ser->stream, &peeked);
+		if (res <= 0) {
+			ast_log(LOG_WARNING, "Short HTTP chunk sync read (Wanted %zu)\n",
+				sizeof(chunk_sync));
+			return -1;
+		}
+		if ((size_t) res > needed) {
+			res = needed;
+		}
+		memcpy(chunk_sync + sizeof(chunk_sync) - needed, peeked, res);
+		ast_iostream_consume(ser->stream, res);
+		needed -= res;
 	}
 	if (chunk_sync[0] != 0x0D || chunk_sync[1] != 0x0A) {
 		ast_log(LOG_WARNING, "HTTP chunk sync bytes wrong (0x%02hhX, 0x%02hhX)\n",
@@ -2123,6 +2189,7 @@ static struct ast_http_server *http_server_create(const char *name, const char *
 	server->args.name = server->name;
 	server->args.accept_fn = ast_tcptls_server_root;
 	server->args.worker_fn = httpd_helper_thread;
+	server->args.dispatch_fn = http_dispatch_connection;
 
 	ast_sockaddr_copy(&server->args.local_address, addr);
 
@@ -2650,13 +2717,32 @@ static int unload_module(void)
 	}
 	AST_RWLIST_UNLOCK(&uri_redirects);
 
+	if (http_pool) {
+		ast_threadpool_shutdown(http_pool);
+		http_pool = NULL;
+	}
+
 	return 0;
 }
 
 static int load_module(void)
 {
+	struct ast_threadpool_options pool_opts = {
+		.version = AST_THREADPOOL_OPTIONS_VERSION,
+		.idle_timeout = HTTP_POOL_IDLE_TIMEOUT,
+		.auto_increment = HTTP_POOL_AUTO_INCREMENT,
+		.initial_size = 0,
+		.max_size = 0,
+	};
+
 	ast_cli_register_multiple(cli_http, ARRAY_LEN(cli_http));
 
+	http_pool = ast_threadpool_create("http", NULL, &pool_opts);
+	if (!http_pool) {
+		/* Not fatal; connections fall back to dedicated threads. */
+		ast_log(LOG_WARNING, "Failed to create HTTP threadpool\n");
+	}
+
 	http_servers = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0,
 		HTTP_SERVER_BUCKETS, ast_http_server_hash_fn, NULL, ast_http_server_cmp_fn);
 	if (!http_servers) {
@@ -2666,6 +2752,10 @@ static int load_module(void)
 	if (__ast_http_load(0)) {
 		ao2_cleanup(http_servers);
 		http_servers = NULL;
+		if (http_pool) {
+			ast_threadpool_shutdown(http_pool);
+			http_pool = NULL;
+		}
 		return AST_MODULE_LOAD_FAILURE;
 	}
 
@@ -28,6 +28,7 @@
 #endif
 #include <sys/socket.h>                 /* for shutdown, SHUT_RDWR */
 #include <sys/time.h>                   /* for timeval */
+#include <sys/uio.h>                    /* for writev, iovec */
 
 #include "asterisk/astobj2.h"           /* for ao2_alloc_options, ao2_alloc_... */
 #include "asterisk/logger.h"            /* for ast_debug, ast_log, LOG_ERROR */
@@ -88,6 +89,11 @@ int ast_iostream_get_fd(struct ast_iostream *stream)
 
 int ast_iostream_wait_for_input(struct ast_iostream *stream, int timeout)
 {
+	/* Data may already be sitting in the read-ahead buffer, in which case
+	   waiting on the fd could block even though a read would succeed. */
+	if (stream->rbuflen) {
+		return 1;
+	}
 #if defined(DO_SSL)
 	/* Because SSL is read in blocks, it's possible that the last time we read we
 	   got more than we asked for and it is now buffered inside OpenSSL. If that
@@ -297,6 +303,39 @@ ssize_t ast_iostream_read(struct ast_iostream *stream, void *buffer, size_t coun
 	return iostream_read(stream, buffer, count);
 }
 
+ssize_t ast_iostream_peek(struct ast_iostream *stream, char **buffer)
+{
+	ssize_t len;
+
+	if (!stream || stream->fd == -1) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (!stream->rbuflen) {
+		stream->rbufhead = stream->rbuf;
+		len = iostream_read(stream, stream->rbuf, sizeof(stream->rbuf));
+		if (len <= 0) {
+			return len;
+		}
+		stream->rbuflen = len;
+	}
+
+	*buffer = stream->rbufhead;
+	return stream->rbuflen;
+}
+
+void ast_iostream_consume(struct ast_iostream *stream, size_t size)
+{
+	ast_assert(size <= (size_t) stream->rbuflen);
+
+	if (size > (size_t) stream->rbuflen) {
+		size = stream->rbuflen;
+	}
+	stream->rbuflen -= size;
+	stream->rbufhead += size;
+}
+
 ssize_t ast_iostream_gets(struct ast_iostream *stream, char *buffer, size_t size)
 {
 	size_t remaining = size;
@@ -488,6 +527,107 @@ ssize_t ast_iostream_write(struct ast_iostream *stream, const void *buffer, size
 	}
 }
 
+ssize_t ast_iostream_writev(struct ast_iostream *stream, const struct iovec *iov, int iovcnt)
+{
+	struct timeval start;
+	struct iovec *cur;
+	ssize_t res;
+	ssize_t written;
+	ssize_t total;
+	int ms;
+	int idx;
+
+	if (iovcnt <= 0) {
+		return 0;
+	}
+
+	if (!stream || stream->fd == -1) {
+		errno = EBADF;
+		return -1;
+	}
+
+	total = 0;
+	for (idx = 0; idx < iovcnt; idx++) {
+		total += iov[idx].iov_len;
+	}
+	if (!total) {
+		/* You asked to write no data you wrote no data. */
+		return 0;
+	}
+
+#if defined(DO_SSL)
+	if (stream->ssl) {
+		/* OpenSSL has no vectored write; send each buffer in turn. */
+		written = 0;
+		for (idx = 0; idx < iovcnt; idx++) {
+			if (!iov[idx].iov_len) {
+				continue;
+			}
+			res = ast_iostream_write(stream, iov[idx].iov_base, iov[idx].iov_len);
+			if (res < 0) {
+				return written ? written : -1;
+			}
+			written += res;
+			if ((size_t) res < iov[idx].iov_len) {
+				/* Report partial write. */
+				return written;
+			}
+		}
+		return written;
+	}
+#endif	/* defined(DO_SSL) */
+
+	if (stream->start.tv_sec) {
+		start = stream->start;
+	} else {
+		start = ast_tvnow();
+	}
+
+	/* writev() does not modify the vector but we need our own copy to
+	 * advance through on partial writes. */
+	cur = ast_alloca(iovcnt * sizeof(*cur));
+	memcpy(cur, iov, iovcnt * sizeof(*cur));
+
+	written = 0;
+	idx = 0;
+	for (;;) {
+		res = writev(stream->fd, &cur[idx], iovcnt - idx);
+		if (0 < res) {
+			written += res;
+			if (written == total) {
+				/* Yay everything was written. */
+				return total;
+			}
+			/* Successfully wrote part of the vector.  Advance past the
+			 * buffers that completed and try to write the rest. */
+			while ((size_t) res >= cur[idx].iov_len) {
+				res -= cur[idx].iov_len;
+				idx++;
+			}
+			if (res) {
+				cur[idx].iov_base = (char *) cur[idx].iov_base + res;
+				cur[idx].iov_len -= res;
+			}
+			continue;
+		}
+		if (errno != EINTR && errno != EAGAIN) {
+			/* Not a retryable error. */
+			ast_debug(1, "TCP socket error writing: %s\n", strerror(errno));
+			if (written) {
+				return written;
+			}
+			return -1;
+		}
+		ms = ast_remaining_ms(start, stream->timeout);
+		if (!ms) {
+			/* Report partial write. */
+			ast_debug(1, "TCP timeout writing data\n");
+			return written;
+		}
+		ast_wait_for_output(stream->fd, ms);
+	}
+}
+
 ssize_t ast_iostream_printf(struct ast_iostream *stream, const char *format, ...)
 {
 	char sbuf[512], *buf = sbuf;
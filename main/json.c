@@ -44,14 +44,135 @@
 #include <jansson.h>
 #include <time.h>
 
+#if (defined(LOW_MEMORY) || defined(MALLOC_DEBUG)) && !defined(NO_JSON_CACHE)
+#define NO_JSON_CACHE
+#endif
+
+#if !defined(NO_JSON_CACHE)
+static void json_cache_cleanup(void *data);
+
+AST_THREADSTORAGE_CUSTOM(json_cache_ts, NULL, json_cache_cleanup);
+
+/*!
+ * \brief Size classes for recycled JSON allocations.
+ *
+ * Jansson's allocations are dominated by small fixed-size json_t values,
+ * short strings, and hash table buckets; everything bigger goes straight
+ * to the heap.
+ */
+static const size_t json_cache_class_len[] = { 32, 64, 128 };
+
+#define JSON_CACHE_CLASS_COUNT ARRAY_LEN(json_cache_class_len)
+
+/*! Maximum number of cached blocks per size class per thread */
+#define JSON_CACHE_MAX_BLOCKS 64
+
+/*!
+ * \brief Header prefixed to every JSON allocation.
+ *
+ * Records which size class the block belongs to (0 for none) so
+ * ast_json_free() can recycle it.  Sized to preserve malloc alignment
+ * for the block handed to jansson.
+ */
+struct json_alloc_header {
+	size_t class_len;
+	size_t pad;
+};
+
+struct json_cache_block {
+	struct json_cache_block *next;
+};
+
+struct json_cache {
+	struct json_cache_block *list[JSON_CACHE_CLASS_COUNT];
+	size_t count[JSON_CACHE_CLASS_COUNT];
+};
+
+static void json_cache_cleanup(void *data)
+{
+	struct json_cache *cache = data;
+	int idx;
+
+	for (idx = 0; idx < JSON_CACHE_CLASS_COUNT; idx++) {
+		struct json_cache_block *block;
+
+		while ((block = cache->list[idx])) {
+			cache->list[idx] = block->next;
+			ast_free((char *) block - sizeof(struct json_alloc_header));
+		}
+	}
+	ast_free(cache);
+}
+#endif
+
 void *ast_json_malloc(size_t size)
 {
+#if !defined(NO_JSON_CACHE)
+	struct json_cache *cache;
+	struct json_alloc_header *hdr;
+	size_t class_len = 0;
+	int idx;
+
+	for (idx = 0; idx < JSON_CACHE_CLASS_COUNT; idx++) {
+		if (size <= json_cache_class_len[idx]) {
+			class_len = json_cache_class_len[idx];
+			break;
+		}
+	}
+
+	if (class_len
+		&& (cache = ast_threadstorage_get(&json_cache_ts, sizeof(*cache)))
+		&& cache->list[idx]) {
+		struct json_cache_block *block = cache->list[idx];
+
+		cache->list[idx] = block->next;
+		cache->count[idx]--;
+		return block;
+	}
+
+	hdr = ast_malloc(sizeof(*hdr) + (class_len ? class_len : size));
+	if (!hdr) {
+		return NULL;
+	}
+	hdr->class_len = class_len;
+	return hdr + 1;
+#else
 	return ast_malloc(size);
+#endif
 }
 
 void ast_json_free(void *p)
 {
+#if !defined(NO_JSON_CACHE)
+	struct json_alloc_header *hdr;
+	struct json_cache *cache;
+	int idx;
+
+	if (!p) {
+		return;
+	}
+
+	hdr = (struct json_alloc_header *) p - 1;
+	if (hdr->class_len
+		&& (cache = ast_threadstorage_get(&json_cache_ts, sizeof(*cache)))) {
+		for (idx = 0; idx < JSON_CACHE_CLASS_COUNT; idx++) {
+			if (hdr->class_len == json_cache_class_len[idx]) {
+				if (cache->count[idx] < JSON_CACHE_MAX_BLOCKS) {
+					struct json_cache_block *block = p;
+
+					block->next = cache->list[idx];
+					cache->list[idx] = block;
+					cache->count[idx]++;
+					return;
+				}
+				break;
+			}
+		}
+	}
+	ast_free(hdr);
+#else
 	ast_free(p);
+#endif
 }
 
 void ast_json_set_alloc_funcs(void *(*malloc_fn)(size_t), void (*free_fn)(void*))
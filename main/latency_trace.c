@@ -0,0 +1,260 @@
+/*
+ * Asterisk -- An open source telephony toolkit.
+ *
+ * See http://www.asterisk.org for more information about
+ * the Asterisk project. Please do not directly contact
+ * any of the maintainers of this project for assistance;
+ * the project provides a web site, mailing lists and IRC
+ * channels for your use.
+ *
+ * This program is free software, distributed under the terms of
+ * the GNU General Public License Version 2. See the LICENSE file
+ * at the top of the source tree.
+ */
+
+/*! \file
+ *
+ * \brief Media pipeline latency tracing
+ *
+ * Collects the stage latency samples fired by the tracepoints in
+ * channel.c, translate.c, bridge_channel.c and res_rtp_asterisk.c
+ * into a lock-free ring and summarizes them as per-stage percentiles
+ * for the 'core trace latency' CLI command.
+ */
+
+/*** MODULEINFO
+	<support_level>core</support_level>
+ ***/
+
+#include "asterisk.h"
+
+#include "asterisk/_private.h"
+#include "asterisk/latency_trace.h"
+#include "asterisk/cli.h"
+#include "asterisk/lock.h"
+#include "asterisk/utils.h"
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define LATENCY_TRACE_SDT 1
+#endif
+#endif
+
+/*! Number of samples retained in the ring.  Must be a power of two. */
+#define LATENCY_RING_SIZE 8192
+
+struct latency_sample {
+	/*! Stage the sample belongs to, or -1 while the slot is unused. */
+	int stage;
+	/*! Stage duration in microseconds. */
+	int usec;
+};
+
+/*!
+ * \brief Ring of the most recent latency samples.
+ *
+ * Producers reserve a slot with an atomic increment of \ref
+ * latency_ring_pos and then fill it in without further
+ * synchronization.  A reader racing a producer can observe a torn
+ * sample; for a diagnostic percentile summary that is an acceptable
+ * trade for keeping the media threads lock free.
+ */
+static struct latency_sample latency_ring[LATENCY_RING_SIZE];
+
+/*! Next ring slot to reserve.  Grows without bound; slot is pos modulo size. */
+static volatile int latency_ring_pos;
+
+/*! Lifetime sample count per stage. */
+static volatile int latency_counts[AST_LATENCY_STAGE_MAX];
+
+/*! Lifetime sampled microseconds per stage. */
+static uint64_t latency_totals[AST_LATENCY_STAGE_MAX];
+
+int ast_latency_trace_enabled;
+
+/*! Stage names indexed by enum ast_latency_stage. */
+static const char * const latency_stage_names[AST_LATENCY_STAGE_MAX] = {
+	[AST_LATENCY_STAGE_READ] = "channel read",
+	[AST_LATENCY_STAGE_TRANSLATE] = "translate",
+	[AST_LATENCY_STAGE_BRIDGE] = "bridge dispatch",
+	[AST_LATENCY_STAGE_WRITE] = "channel write",
+	[AST_LATENCY_STAGE_RTP_READ] = "rtp read",
+	[AST_LATENCY_STAGE_RTP_WRITE] = "rtp write",
+};
+
+void __ast_latency_trace_record(enum ast_latency_stage stage, int64_t usec)
+{
+	struct latency_sample *sample;
+	unsigned int pos;
+
+	if (stage < 0 || AST_LATENCY_STAGE_MAX <= stage) {
+		return;
+	}
+	if (usec < 0) {
+		/* The clock stepped backwards under us. */
+		usec = 0;
+	} else if (INT_MAX < usec) {
+		usec = INT_MAX;
+	}
+
+#if defined(LATENCY_TRACE_SDT)
+	/* USDT probe: asterisk:stage_latency(stage, usec) */
+	DTRACE_PROBE2(asterisk, stage_latency, stage, usec);
+#endif
+
+	pos = (unsigned int) ast_atomic_fetchadd_int(&latency_ring_pos, 1)
+		% LATENCY_RING_SIZE;
+	sample = &latency_ring[pos];
+	sample->usec = (int) usec;
+	sample->stage = stage;
+
+	ast_atomic_fetchadd_int(&latency_counts[stage], 1);
+	ast_atomic_fetch_add(&latency_totals[stage], (uint64_t) usec, __ATOMIC_RELAXED);
+}
+
+/*!
+ * \internal
+ * \brief Mark every ring slot unused and zero the lifetime counters.
+ */
+static void latency_trace_reset(void)
+{
+	int idx;
+
+	for (idx = 0; idx < ARRAY_LEN(latency_ring); ++idx) {
+		latency_ring[idx].stage = -1;
+		latency_ring[idx].usec = 0;
+	}
+	for (idx = 0; idx < AST_LATENCY_STAGE_MAX; ++idx) {
+		latency_counts[idx] = 0;
+		latency_totals[idx] = 0;
+	}
+	latency_ring_pos = 0;
+}
+
+/*!
+ * \internal
+ * \brief qsort comparison of microsecond samples.
+ */
+static int latency_usec_cmp(const void *a, const void *b)
+{
+	return *(const int *) a - *(const int *) b;
+}
+
+static char *handle_trace_latency(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	int *sorted[AST_LATENCY_STAGE_MAX];
+	int window[AST_LATENCY_STAGE_MAX];
+	int stage;
+	int idx;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "core trace latency";
+		e->usage =
+			"Usage: core trace latency [on|off]\n"
+			"       Without arguments, summarizes media pipeline stage latency\n"
+			"       percentiles over the most recent samples.\n"
+			"       on - Enable the pipeline tracepoints.  Clears previously\n"
+			"            collected samples.\n"
+			"       off - Disable the tracepoints.  Collected samples are kept.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc == 4) {
+		if (ast_true(a->argv[3])) {
+			ast_latency_trace_enabled = 0;
+			latency_trace_reset();
+			ast_atomic_thread_fence(__ATOMIC_SEQ_CST);
+			ast_latency_trace_enabled = 1;
+		} else if (ast_false(a->argv[3])) {
+			ast_latency_trace_enabled = 0;
+		} else {
+			return CLI_SHOWUSAGE;
+		}
+		ast_cli(a->fd, "Latency tracing is: %s\n",
+			ast_latency_trace_enabled ? "On" : "Off");
+		return CLI_SUCCESS;
+	}
+	if (a->argc != 3) {
+		return CLI_SHOWUSAGE;
+	}
+
+	/* Bucket a snapshot of the ring by stage. */
+	for (stage = 0; stage < AST_LATENCY_STAGE_MAX; ++stage) {
+		sorted[stage] = ast_malloc(LATENCY_RING_SIZE * sizeof(int));
+		if (!sorted[stage]) {
+			while (stage--) {
+				ast_free(sorted[stage]);
+			}
+			return CLI_FAILURE;
+		}
+		window[stage] = 0;
+	}
+	for (idx = 0; idx < ARRAY_LEN(latency_ring); ++idx) {
+		struct latency_sample sample = latency_ring[idx];
+
+		if (sample.stage < 0 || AST_LATENCY_STAGE_MAX <= sample.stage) {
+			continue;
+		}
+		sorted[sample.stage][window[sample.stage]++] = sample.usec;
+	}
+
+	ast_cli(a->fd, "Latency tracing is: %s\n\n",
+		ast_latency_trace_enabled ? "On" : "Off");
+	ast_cli(a->fd, "%-16s %7s %8s %8s %8s %8s %12s %8s\n",
+		"Stage", "window", "p50(us)", "p90(us)", "p99(us)", "max(us)",
+		"lifetime", "avg(us)");
+	for (stage = 0; stage < AST_LATENCY_STAGE_MAX; ++stage) {
+		int count = window[stage];
+		unsigned int lifetime = (unsigned int) latency_counts[stage];
+
+		if (!count && !lifetime) {
+			continue;
+		}
+		if (count) {
+			qsort(sorted[stage], count, sizeof(int), latency_usec_cmp);
+			ast_cli(a->fd, "%-16s %7d %8d %8d %8d %8d %12u %8llu\n",
+				latency_stage_names[stage], count,
+				sorted[stage][count * 50 / 100],
+				sorted[stage][count * 90 / 100],
+				sorted[stage][count * 99 / 100],
+				sorted[stage][count - 1],
+				lifetime,
+				lifetime ? (unsigned long long) latency_totals[stage] / lifetime : 0);
+		} else {
+			ast_cli(a->fd, "%-16s %7d %8s %8s %8s %8s %12u %8llu\n",
+				latency_stage_names[stage], count, "-", "-", "-", "-",
+				lifetime,
+				(unsigned long long) latency_totals[stage] / lifetime);
+		}
+	}
+
+	for (stage = 0; stage < AST_LATENCY_STAGE_MAX; ++stage) {
+		ast_free(sorted[stage]);
+	}
+
+	return CLI_SUCCESS;
+}
+
+static struct ast_cli_entry cli_latency_trace[] = {
+	AST_CLI_DEFINE(handle_trace_latency, "Control and summarize media pipeline latency tracing"),
+};
+
+/*!
+ * \internal
+ */
+static void latency_trace_shutdown(void)
+{
+	ast_cli_unregister_multiple(cli_latency_trace, ARRAY_LEN(cli_latency_trace));
+}
+
+int ast_latency_trace_init(void)
+{
+	latency_trace_reset();
+	ast_cli_register_multiple(cli_latency_trace, ARRAY_LEN(cli_latency_trace));
+	ast_register_cleanup(latency_trace_shutdown);
+	return 0;
+}
@@ -298,6 +298,8 @@ struct ast_module {
 	void *lib;
 	/*! Number of 'users' and other references currently holding the module. */
 	int usecount;
+	/*! Time the module's most recent load() callback took, in microseconds. */
+	int64_t load_time_us;
 	/*! List of users holding the module. */
 	struct module_user_list users;
 
@@ -1684,6 +1686,7 @@ static enum ast_module_load_result start_resource(struct ast_module *mod)
 {
 	char tmp[256];
 	enum ast_module_load_result res;
+	struct timeval load_start;
 
 	if (mod->flags.running) {
 		return AST_MODULE_LOAD_SUCCESS;
@@ -1715,7 +1718,9 @@ static enum ast_module_load_result start_resource(struct ast_module *mod)
 	if (!ast_fully_booted) {
 		ast_verb(1, "Loading %s.\n", mod->resource);
 	}
+	load_start = ast_tvnow();
 	res = mod->info->load();
+	mod->load_time_us = ast_tvdiff_us(ast_tvnow(), load_start);
 
 	switch (res) {
 	case AST_MODULE_LOAD_SUCCESS:
@@ -2624,6 +2629,32 @@ int ast_update_module_list_data(int (*modentry)(const char *module, const char *
 	return total_mod_loaded;
 }
 
+int ast_update_module_list_times(int (*modentry)(const char *module, int64_t load_time_us,
+                                                 const char *status, const char *like),
+                                 const char *like)
+{
+	int total_mod_loaded = 0;
+	struct module_vector alpha_module_list;
+
+	AST_DLLIST_LOCK(&module_list);
+
+	if (!alpha_module_list_create(&alpha_module_list)) {
+		int idx;
+
+		for (idx = 0; idx < AST_VECTOR_SIZE(&alpha_module_list); idx++) {
+			struct ast_module *cur = AST_VECTOR_GET(&alpha_module_list, idx);
+
+			total_mod_loaded += modentry(cur->resource, cur->load_time_us,
+				cur->flags.running ? "Running" : "Not Running", like);
+		}
+	}
+
+	AST_DLLIST_UNLOCK(&module_list);
+	AST_VECTOR_FREE(&alpha_module_list);
+
+	return total_mod_loaded;
+}
+
 int ast_update_module_list_condition(int (*modentry)(const char *module, const char *description,
                                                      int usecnt, const char *status,
                                                      const char *like,
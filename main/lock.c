@@ -39,6 +39,16 @@ static void __attribute__((constructor)) __mtx_init(void)
 #include "asterisk/utils.h"
 #include "asterisk/lock.h"
 
+#if !defined(STANDALONE) && !defined(STANDALONE2)
+#define __AST_LOCK_PROF
+#endif
+
+#if defined(__AST_LOCK_PROF)
+#include "asterisk/_private.h"
+#include "asterisk/cli.h"
+#include "asterisk/time.h"
+#endif
+
 /* Allow direct use of pthread_mutex_* / pthread_cond_* */
 #undef pthread_mutex_init
 #undef pthread_mutex_destroy
@@ -53,6 +63,334 @@ static void __attribute__((constructor)) __mtx_init(void)
 #undef pthread_cond_wait
 #undef pthread_cond_timedwait
 
+#if defined(__AST_LOCK_PROF)
+
+/*!
+ * \internal
+ * \brief Sampled lock contention profiler.
+ *
+ * DEBUG_THREADS lock tracking is far too expensive to leave enabled in
+ * production, so contended acquisitions are instead sampled here in all
+ * builds.  One in every LOCK_PROF_INTERVAL blocking acquisitions is
+ * probed with a trylock; when the probe fails, the time spent waiting
+ * for the lock is measured and, if it exceeds LOCK_PROF_THRESHOLD_US,
+ * charged to the acquiring call site in a small lock-free table.  The
+ * table is ranked by total wait with 'core show lock contention'.
+ *
+ * Call sites are keyed by the __FILE__ pointer and line number the
+ * lock wrappers already receive, so the hot path never hashes strings
+ * and never takes a lock of its own.
+ */
+
+/*! \brief One in this many blocking acquisitions is probed for contention. */
+#define LOCK_PROF_INTERVAL 256
+
+/*! \brief Contended waits shorter than this many microseconds are not recorded. */
+#define LOCK_PROF_THRESHOLD_US 1000
+
+/*! \brief Prime number of call site slots in the contention table. */
+#define LOCK_PROF_SITES_MAX 509
+
+/*! \brief Give up probing for a free slot after this many attempts. */
+#define LOCK_PROF_MAX_PROBES 16
+
+enum lock_prof_site_state {
+	LOCK_PROF_EMPTY = 0,
+	LOCK_PROF_CLAIMED,
+	LOCK_PROF_READY,
+};
+
+struct lock_prof_site {
+	/*! \brief One of enum lock_prof_site_state */
+	volatile int state;
+	/*! \brief Call site file.  Keyed by pointer identity, not contents. */
+	const char *file;
+	/*! \brief Call site function */
+	const char *func;
+	/*! \brief Call site line number */
+	unsigned int lineno;
+	/*! \brief Kind of lock acquired at this site: "mutex", "rdlock" or "wrlock" */
+	const char *type;
+	/*! \brief Number of contended acquisitions recorded */
+	volatile int count;
+	/*! \brief Total microseconds spent waiting at this site */
+	volatile int64_t wait_us;
+	/*! \brief Longest single wait in microseconds.  Updated racily. */
+	volatile int max_wait_us;
+};
+
+static struct lock_prof_site lock_prof_sites[LOCK_PROF_SITES_MAX];
+
+/*! \brief Blocking acquisitions until the next contention probe. */
+static volatile int lock_prof_countdown = LOCK_PROF_INTERVAL;
+
+/*! \brief Contended samples lost because the table probe limit was hit. */
+static volatile int lock_prof_dropped;
+
+/*!
+ * \internal
+ * \brief Determine if this blocking acquisition should be probed.
+ */
+static int lock_prof_sample_take(void)
+{
+	if (ast_atomic_fetchadd_int(&lock_prof_countdown, -1) != 1) {
+		return 0;
+	}
+	ast_atomic_fetchadd_int(&lock_prof_countdown, LOCK_PROF_INTERVAL);
+	return 1;
+}
+
+/*!
+ * \internal
+ * \brief Charge a contended wait to its call site.
+ *
+ * Slots are claimed with an atomic exchange.  The loser of a claim race
+ * restores the state it displaced and either finds the site on a later
+ * probe or drops the sample; both outcomes are benign for a profiler.
+ */
+static void lock_prof_record(const char *type, const char *file, int lineno,
+	const char *func, int64_t wait_us)
+{
+	unsigned int slot = ((unsigned int) (((unsigned long) file) >> 4) + lineno)
+		% ARRAY_LEN(lock_prof_sites);
+	int probes;
+
+	if (wait_us < LOCK_PROF_THRESHOLD_US) {
+		return;
+	}
+
+	for (probes = 0; probes < LOCK_PROF_MAX_PROBES; ++probes) {
+		struct lock_prof_site *site = &lock_prof_sites[slot];
+		int state = ast_atomic_load_n(&site->state, __ATOMIC_ACQUIRE);
+
+		if (state == LOCK_PROF_EMPTY) {
+			state = ast_atomic_exchange_n(&site->state, LOCK_PROF_CLAIMED,
+				__ATOMIC_ACQUIRE);
+			if (state == LOCK_PROF_EMPTY) {
+				site->file = file;
+				site->lineno = lineno;
+				site->func = func;
+				site->type = type;
+				ast_atomic_store_n(&site->state, LOCK_PROF_READY, __ATOMIC_RELEASE);
+				state = LOCK_PROF_READY;
+			} else if (state == LOCK_PROF_READY) {
+				ast_atomic_store_n(&site->state, LOCK_PROF_READY, __ATOMIC_RELEASE);
+			}
+		}
+
+		if (state == LOCK_PROF_READY && site->file == file && site->lineno == lineno) {
+			ast_atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED);
+			ast_atomic_fetch_add(&site->wait_us, wait_us, __ATOMIC_RELAXED);
+			if (site->max_wait_us < wait_us) {
+				site->max_wait_us = wait_us;
+			}
+			return;
+		}
+
+		slot = (slot + 1) % ARRAY_LEN(lock_prof_sites);
+	}
+
+	ast_atomic_fetchadd_int(&lock_prof_dropped, +1);
+}
+
+/*!
+ * \internal
+ * \brief Acquire a mutex, measuring the wait when this acquisition is sampled.
+ */
+static int lock_prof_mutex_lock(ast_mutex_t *t, const char *filename, int lineno,
+	const char *func)
+{
+	struct timeval wait_start;
+	int res;
+
+	if (!lock_prof_sample_take()) {
+		return pthread_mutex_lock(&t->mutex);
+	}
+	if (!pthread_mutex_trylock(&t->mutex)) {
+		/* Uncontended; nothing worth recording. */
+		return 0;
+	}
+	wait_start = ast_tvnow();
+	res = pthread_mutex_lock(&t->mutex);
+	if (!res) {
+		lock_prof_record("mutex", filename, lineno, func,
+			ast_tvdiff_us(ast_tvnow(), wait_start));
+	}
+	return res;
+}
+
+/*!
+ * \internal
+ * \brief Acquire a read lock, measuring the wait when this acquisition is sampled.
+ */
+static int lock_prof_rwlock_rdlock(ast_rwlock_t *t, const char *filename, int lineno,
+	const char *func)
+{
+	struct timeval wait_start;
+	int res;
+
+	if (!lock_prof_sample_take()) {
+		return pthread_rwlock_rdlock(&t->lock);
+	}
+	if (!pthread_rwlock_tryrdlock(&t->lock)) {
+		return 0;
+	}
+	wait_start = ast_tvnow();
+	res = pthread_rwlock_rdlock(&t->lock);
+	if (!res) {
+		lock_prof_record("rdlock", filename, lineno, func,
+			ast_tvdiff_us(ast_tvnow(), wait_start));
+	}
+	return res;
+}
+
+/*!
+ * \internal
+ * \brief Acquire a write lock, measuring the wait when this acquisition is sampled.
+ */
+static int lock_prof_rwlock_wrlock(ast_rwlock_t *t, const char *filename, int lineno,
+	const char *func)
+{
+	struct timeval wait_start;
+	int res;
+
+	if (!lock_prof_sample_take()) {
+		return pthread_rwlock_wrlock(&t->lock);
+	}
+	if (!pthread_rwlock_trywrlock(&t->lock)) {
+		return 0;
+	}
+	wait_start = ast_tvnow();
+	res = pthread_rwlock_wrlock(&t->lock);
+	if (!res) {
+		lock_prof_record("wrlock", filename, lineno, func,
+			ast_tvdiff_us(ast_tvnow(), wait_start));
+	}
+	return res;
+}
+
+static char *handle_show_lock_contention(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	int sorted[LOCK_PROF_SITES_MAX];
+	int site_count = 0;
+	int64_t total_wait = 0;
+	int total_count = 0;
+	int idx;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "core show lock contention";
+		e->usage =
+			"Usage: core show lock contention\n"
+			"       Displays call sites of sampled contended lock acquisitions,\n"
+			"       ranked by total time spent waiting.  One in 256 blocking\n"
+			"       acquisitions is probed; waits shorter than one millisecond\n"
+			"       are not recorded.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != e->args) {
+		return CLI_SHOWUSAGE;
+	}
+
+	for (idx = 0; idx < ARRAY_LEN(lock_prof_sites); ++idx) {
+		int pos;
+
+		if (ast_atomic_load_n(&lock_prof_sites[idx].state, __ATOMIC_ACQUIRE)
+			!= LOCK_PROF_READY) {
+			continue;
+		}
+
+		/* Insertion sort by total wait, largest first. */
+		for (pos = site_count; pos > 0; --pos) {
+			if (lock_prof_sites[sorted[pos - 1]].wait_us
+				>= lock_prof_sites[idx].wait_us) {
+				break;
+			}
+			sorted[pos] = sorted[pos - 1];
+		}
+		sorted[pos] = idx;
+		++site_count;
+	}
+
+	ast_cli(a->fd, "%12s %10s %8s %7s  %s\n",
+		"Wait (us)", "Max (us)", "Samples", "Type", "Call Site");
+	for (idx = 0; idx < site_count; ++idx) {
+		struct lock_prof_site *site = &lock_prof_sites[sorted[idx]];
+
+		ast_cli(a->fd, "%12" PRId64 " %10d %8d %7s  %s() line %u of %s\n",
+			site->wait_us, site->max_wait_us, site->count,
+			site->type, site->func, site->lineno, site->file);
+		total_wait += site->wait_us;
+		total_count += site->count;
+	}
+	ast_cli(a->fd, "\n%d call site%s, %d sampled contended acquisition%s, %" PRId64 " us total wait\n",
+		site_count, ESS(site_count), total_count, ESS(total_count), total_wait);
+	if (lock_prof_dropped) {
+		ast_cli(a->fd, "%d sample%s dropped (contention table full)\n",
+			lock_prof_dropped, ESS(lock_prof_dropped));
+	}
+
+	return CLI_SUCCESS;
+}
+
+static char *handle_clear_lock_contention(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "core clear lock contention";
+		e->usage =
+			"Usage: core clear lock contention\n"
+			"       Clears the sampled lock contention call site table.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != e->args) {
+		return CLI_SHOWUSAGE;
+	}
+
+	/*
+	 * Best effort: samples recorded while the table is being cleared
+	 * may be partially lost, which is harmless for a profiler.
+	 */
+	memset((void *) lock_prof_sites, 0, sizeof(lock_prof_sites));
+	lock_prof_dropped = 0;
+	ast_cli(a->fd, "Lock contention table cleared\n");
+
+	return CLI_SUCCESS;
+}
+
+static struct ast_cli_entry cli_lock_prof[] = {
+	AST_CLI_DEFINE(handle_show_lock_contention, "Display sampled lock contention call sites"),
+	AST_CLI_DEFINE(handle_clear_lock_contention, "Clear sampled lock contention call sites"),
+};
+
+static void lock_prof_shutdown(void)
+{
+	ast_cli_unregister_multiple(cli_lock_prof, ARRAY_LEN(cli_lock_prof));
+}
+
+int ast_lock_contention_init(void)
+{
+	ast_cli_register_multiple(cli_lock_prof, ARRAY_LEN(cli_lock_prof));
+	ast_register_cleanup(lock_prof_shutdown);
+
+	return 0;
+}
+
+#else
+
+/* Standalone utilities take locks uninstrumented. */
+#define lock_prof_mutex_lock(t, filename, lineno, func) pthread_mutex_lock(&(t)->mutex)
+#define lock_prof_rwlock_rdlock(t, filename, lineno, func) pthread_rwlock_rdlock(&(t)->lock)
+#define lock_prof_rwlock_wrlock(t, filename, lineno, func) pthread_rwlock_wrlock(&(t)->lock)
+
+#endif /* __AST_LOCK_PROF */
+
 #if defined(DEBUG_THREADS)
 #define log_mutex_error(canlog, ...) \
 	do { \
@@ -323,7 +661,7 @@ int __ast_pthread_mutex_lock(const char *filename, int lineno, const char *func,
 	ast_mark(mtx_prof, 0);
 	if (res)
 #endif
-	res = pthread_mutex_lock(&t->mutex);
+	res = lock_prof_mutex_lock(t, filename, lineno, func);
 #endif /* !DETECT_DEADLOCKS || !DEBUG_THREADS */
 
 #ifdef DEBUG_THREADS
@@ -876,7 +1214,7 @@ int __ast_rwlock_rdlock(const char *filename, int line, const char *func, ast_rw
 		} while (res == EBUSY);
 	}
 #else /* !DETECT_DEADLOCKS || !DEBUG_THREADS */
-	res = pthread_rwlock_rdlock(&t->lock);
+	res = lock_prof_rwlock_rdlock(t, filename, line, func);
 #endif /* !DETECT_DEADLOCKS || !DEBUG_THREADS */
 
 #ifdef DEBUG_THREADS
@@ -974,7 +1312,7 @@ int __ast_rwlock_wrlock(const char *filename, int line, const char *func, ast_rw
 		} while (res == EBUSY);
 	}
 #else /* !DETECT_DEADLOCKS || !DEBUG_THREADS */
-	res = pthread_rwlock_wrlock(&t->lock);
+	res = lock_prof_rwlock_wrlock(t, filename, line, func);
 #endif /* !DETECT_DEADLOCKS || !DEBUG_THREADS */
 
 #ifdef DEBUG_THREADS
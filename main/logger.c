@@ -2146,20 +2146,39 @@ static void __attribute__((format(printf, 7, 0))) ast_log_full(int level, int su
 		return;
 	}
 
-	AST_LIST_LOCK(&logmsgs);
-	if (logger_queue_size >= logger_queue_limit && !close_logger_thread) {
-		logger_messages_discarded++;
-		if (!high_water_alert && !close_logger_thread) {
-			logmsg = format_log_message(__LOG_WARNING, 0, "logger", 0, "***", 0,
-				"Log queue threshold (%d) exceeded.  Discarding new messages.\n", logger_queue_limit);
-			AST_LIST_INSERT_TAIL(&logmsgs, logmsg, list);
-			high_water_alert = 1;
-			ast_cond_signal(&logcond);
+	/* If no channel is interested in this level, don't spend cycles
+	 * formatting and queueing a message that nothing will print.  The
+	 * mask is kept current by channel configuration changes, and it
+	 * starts fully open so early startup messages are never lost.
+	 */
+	if (!(global_logmask & (1 << level))) {
+		return;
+	}
+
+	/* Check the queue limit before formatting.  Reading the size without
+	 * the lock is benign here: the limit can only be overshot by the few
+	 * messages in flight, and the check is repeated under the lock before
+	 * anything is discarded.
+	 */
+	if (logthread != AST_PTHREADT_NULL
+		&& logger_queue_size >= logger_queue_limit && !close_logger_thread) {
+		AST_LIST_LOCK(&logmsgs);
+		if (logger_queue_size >= logger_queue_limit && !close_logger_thread) {
+			logger_messages_discarded++;
+			if (!high_water_alert) {
+				logmsg = format_log_message(__LOG_WARNING, 0, "logger", 0, "***", 0,
+					"Log queue threshold (%d) exceeded.  Discarding new messages.\n", logger_queue_limit);
+				if (logmsg) {
+					AST_LIST_INSERT_TAIL(&logmsgs, logmsg, list);
+				}
+				high_water_alert = 1;
+				ast_cond_signal(&logcond);
+			}
+			AST_LIST_UNLOCK(&logmsgs);
+			return;
 		}
 		AST_LIST_UNLOCK(&logmsgs);
-		return;
 	}
-	AST_LIST_UNLOCK(&logmsgs);
 
 	logmsg = format_log_message_ap(level, sublevel, file, line, function, callid, fmt, ap);
 	if (!logmsg) {
@@ -2173,9 +2192,16 @@ static void __attribute__((format(printf, 7, 0))) ast_log_full(int level, int su
 			/* Logger is either closing or closed.  We cannot log this message. */
 			logmsg_free(logmsg);
 		} else {
+			int was_empty = AST_LIST_EMPTY(&logmsgs);
+
 			AST_LIST_INSERT_TAIL(&logmsgs, logmsg, list);
 			logger_queue_size++;
-			ast_cond_signal(&logcond);
+			if (was_empty) {
+				/* The logger thread drains the entire queue on each pass,
+				 * so it only needs waking on the empty -> non-empty edge.
+				 */
+				ast_cond_signal(&logcond);
+			}
 		}
 		AST_LIST_UNLOCK(&logmsgs);
 	} else {
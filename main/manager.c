@@ -100,6 +100,7 @@
 #include "asterisk/format_cache.h"
 #include "asterisk/translate.h"
 #include "asterisk/taskprocessor.h"
+#include "asterisk/threadpool.h"
 #include "asterisk/message.h"
 
 /*** DOCUMENTATION
@@ -1030,9 +1031,18 @@
 		</synopsis>
 		<syntax>
 			<xi:include xpointer="xpointer(/docs/manager[@name='Login']/syntax/parameter[@name='ActionID'])" />
+			<parameter name="Generation">
+				<para>A channel cache generation from a previous response.
+				If the cache has not changed since, the channel list is
+				omitted and only the completion event is sent.</para>
+			</parameter>
 		</syntax>
 		<description>
 			<para>List currently defined channels and some information about them.</para>
+			<para>The completion event carries a <literal>Generation</literal>
+			header identifying the state of the channel cache.  Pollers may
+			pass it back in the next request to skip the list when nothing
+			has changed.</para>
 		</description>
 		<responses>
 			<list-elements>
@@ -1467,10 +1477,31 @@ struct eventqent {
 	int category;
 	unsigned int seq;	/*!< sequence number */
 	struct timeval tv;  /*!< When event was allocated */
+	char event_name[64];	/*!< event name parsed out once, for compiled session filters */
 	AST_RWLIST_ENTRY(eventqent) eq_next;
 	char eventdata[1];	/*!< really variable size, allocated by append_event() */
 };
 
+/*!
+ * \brief An event filter for a manager session
+ *
+ * Filters that only constrain the event name (patterns like
+ * <literal>Event: Newchannel</literal>) are compiled down to a literal
+ * comparison against \ref eventqent event_name so the common case never
+ * runs a regex over the formatted event.  Anything else keeps the
+ * compiled regex.
+ */
+struct event_filter {
+	/*! Compiled regex; only valid when regex_compiled is set */
+	regex_t regex;
+	/*! Set when regex holds a compiled pattern that must be freed */
+	int regex_compiled;
+	/*! Pattern ended in $, so the event name must match exactly */
+	int exact;
+	/*! Literal event name to match; empty string means use the regex */
+	char event_name[0];
+};
+
 static AST_RWLIST_HEAD_STATIC(all_events, eventqent);
 
 static int displayconnects = 1;
@@ -1493,6 +1524,17 @@ static char global_realm[MAXHOSTNAMELEN];	/*!< Default realm */
 static int unauth_sessions = 0;
 static struct stasis_subscription *acl_change_sub;
 
+/*! (s) Idle time before an action pool worker thread exits. */
+#define ACTION_POOL_IDLE_TIMEOUT 60
+/*! Number of worker threads to add when the action pool needs to grow. */
+#define ACTION_POOL_AUTO_INCREMENT 5
+
+/*! \brief Pool of worker threads executing AMI actions off the session
+ * reader threads.  Each session runs its actions through a serializer on
+ * this pool so responses complete in order, while the reader thread stays
+ * free to deliver events and accept further commands. */
+static struct ast_threadpool *actions_threadpool;
+
 /*! \brief A \ref stasis_topic that all topics AMI cares about will be forwarded to */
 static struct stasis_topic *manager_topic;
 
@@ -1585,6 +1627,21 @@ static void acl_change_stasis_unsubscribe(void)
  * is session-specific data. The structure that it is wrapped in, called a 'mansession' really contains action-specific
  * data.
  */
+
+/*! \brief The response of an asynchronously executed action awaiting delivery.
+ *
+ * Queued actions buffer their response while running off the session's
+ * reader thread; the reader drains completed responses in order so that
+ * response blocks and event frames never interleave on the wire.
+ */
+struct action_completion {
+	AST_LIST_ENTRY(action_completion) list;
+	/*! Non-zero if the session must be disconnected after delivery. */
+	int destroy;
+	/*! Formatted response to send to the client. May be NULL on allocation failure. */
+	struct ast_str *buf;
+};
+
 struct mansession_session {
 				/*! \todo XXX need to document which fields it is protecting */
 	struct ast_sockaddr addr;	/*!< address we are connecting from */
@@ -1615,6 +1672,8 @@ struct mansession_session {
 	unsigned long oldnonce;	/*!< Stale nonce value */
 	unsigned long nc;	/*!< incremental  nonce counter */
 	ast_mutex_t notify_lock; /*!< Lock for notifying this session of events */
+	struct ast_taskprocessor *action_tps; /*!< Serializer for asynchronously executed actions */
+	AST_LIST_HEAD_NOLOCK(, action_completion) completions; /*!< Async action responses awaiting delivery */
 	AST_LIST_HEAD_NOLOCK(mansession_datastores, ast_datastore) datastores; /*!< Data stores on the session */
 	AST_LIST_ENTRY(mansession_session) list;
 };
@@ -1636,9 +1695,15 @@ struct mansession {
 	enum mansession_message_parsing parsing;
 	unsigned int write_error:1;
 	struct manager_custom_hook *hook;
+	/*! When set, output is captured here instead of written to the stream.
+	 * Used by asynchronously executed actions. */
+	struct ast_str *response_buf;
 	ast_mutex_t lock;
 };
 
+/*! \brief Number of buckets in the active session registry */
+#define MANSESSION_BUCKETS 53
+
 /*! Active manager connection sessions container. */
 static AO2_GLOBAL_OBJ_STATIC(mgr_sessions);
 
@@ -1671,6 +1736,21 @@ static AST_RWLIST_HEAD_STATIC(users, ast_manager_user);
 /*! \brief list of actions registered */
 static AST_RWLIST_HEAD_STATIC(actions, manager_action);
 
+/*! \brief Number of buckets in the registered action index */
+#define ACTION_INDEX_BUCKETS 53
+
+/*!
+ * \brief Hash index over the registered actions.
+ *
+ * The \ref actions list stays authoritative (and sorted, for the CLI and
+ * ListCommands), but per-request dispatch looks the action up here instead
+ * of walking the list.  Maintained under the \ref actions list lock.
+ */
+static struct ao2_container *action_index;
+
+AO2_STRING_FIELD_CASE_HASH_FN(manager_action, action)
+AO2_STRING_FIELD_CASE_CMP_FN(manager_action, action)
+
 /*! \brief list of hooks registered */
 static AST_RWLIST_HEAD_STATIC(manager_hooks, manager_custom_hook);
 
@@ -1692,7 +1772,7 @@ static int __attribute__((format(printf, 9, 0))) __manager_event_sessions(
 	...);
 static enum add_filter_result manager_add_filter(const char *filter_pattern, struct ao2_container *whitefilters, struct ao2_container *blackfilters);
 
-static int match_filter(struct mansession *s, char *eventdata);
+static int match_filter(struct mansession *s, struct eventqent *eqe);
 
 /*!
  * @{ \brief Define AMI message types.
@@ -1712,6 +1792,11 @@ static struct manager_action *action_find(const char *name)
 {
 	struct manager_action *act;
 
+	if (action_index) {
+		return ao2_t_find(action_index, name, OBJ_SEARCH_KEY, "find action object");
+	}
+
+	/* The index could not be allocated; fall back to scanning the list. */
 	AST_RWLIST_RDLOCK(&actions);
 	AST_RWLIST_TRAVERSE(&actions, act, list) {
 		if (!strcasecmp(name, act->action)) {
@@ -2198,8 +2283,11 @@ static struct mansession_session *unref_mansession(struct mansession_session *s)
 
 static void event_filter_destructor(void *obj)
 {
-	regex_t *regex_filter = obj;
-	regfree(regex_filter);
+	struct event_filter *filter = obj;
+
+	if (filter->regex_compiled) {
+		regfree(&filter->regex);
+	}
 }
 
 static void session_destructor(void *obj)
@@ -2207,6 +2295,7 @@ static void session_destructor(void *obj)
 	struct mansession_session *session = obj;
 	struct eventqent *eqe = session->last_ev;
 	struct ast_datastore *datastore;
+	struct action_completion *done;
 
 	/* Get rid of each of the data stores on the session */
 	while ((datastore = AST_LIST_REMOVE_HEAD(&session->datastores, entry))) {
@@ -2214,6 +2303,14 @@ static void session_destructor(void *obj)
 		ast_datastore_free(datastore);
 	}
 
+	/* Pending async action tasks hold session references, so by the time
+	 * we get here only undelivered responses can remain. */
+	while ((done = AST_LIST_REMOVE_HEAD(&session->completions, list))) {
+		ast_free(done->buf);
+		ast_free(done);
+	}
+	ast_taskprocessor_unreference(session->action_tps);
+
 	if (eqe) {
 		ast_atomic_fetchadd_int(&eqe->usecount, -1);
 	}
@@ -2266,11 +2363,42 @@ static struct mansession_session *build_mansession(const struct ast_sockaddr *ad
 	return newsession;
 }
 
+static int mansession_hash_fn(const void *obj, const int flags)
+{
+	const struct mansession_session *session = obj;
+	const char *key;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_KEY:
+		key = obj;
+		break;
+	case OBJ_SEARCH_OBJECT:
+		key = session->username;
+		break;
+	default:
+		/* Hash can only work on something with a full key. */
+		ast_assert(0);
+		return 0;
+	}
+	return ast_str_case_hash(key);
+}
+
 static int mansession_cmp_fn(void *obj, void *arg, int flags)
 {
 	struct mansession_session *s = obj;
-	char *str = arg;
-	return !strcasecmp(s->username, str) ? CMP_MATCH : 0;
+	const char *key;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_KEY:
+		key = arg;
+		break;
+	case OBJ_SEARCH_OBJECT:
+		key = ((struct mansession_session *) arg)->username;
+		break;
+	default:
+		return 0;
+	}
+	return !strcasecmp(s->username, key) ? CMP_MATCH : 0;
 }
 
 static void session_destroy(struct mansession_session *s)
@@ -2294,7 +2422,7 @@ static int check_manager_session_inuse(const char *name)
 
 	sessions = ao2_global_obj_ref(mgr_sessions);
 	if (sessions) {
-		session = ao2_find(sessions, (char *) name, 0);
+		session = ao2_find(sessions, name, OBJ_SEARCH_KEY);
 		ao2_ref(sessions, -1);
 		if (session) {
 			unref_mansession(session);
@@ -3044,6 +3172,16 @@ static int send_string(struct mansession *s, char *string)
 		return 0;
 	}
 
+	/* Asynchronously executed actions capture their output; it is
+	 * written out by the session's reader thread upon completion. */
+	if (s->response_buf) {
+		if (ast_str_append(&s->response_buf, 0, "%s", string) == AST_DYNSTR_BUILD_FAILED) {
+			s->write_error = 1;
+			return -1;
+		}
+		return strlen(string);
+	}
+
 	stream = s->stream ? s->stream : s->session->stream;
 
 	len = strlen(string);
@@ -3101,7 +3239,8 @@ void astman_append(struct mansession *s, const char *fmt, ...)
 		return;
 	}
 
-	if (s->hook || (s->tcptls_session != NULL && s->tcptls_session->stream != NULL)) {
+	if (s->hook || s->response_buf
+		|| (s->tcptls_session != NULL && s->tcptls_session->stream != NULL)) {
 		send_string(s, ast_str_buffer(buf));
 	} else {
 		ast_verbose("No connection stream in astman_append, should not happen\n");
@@ -3515,8 +3654,9 @@ static int authenticate(struct mansession *s, const struct message *m)
 	const char *password = astman_get_header(m, "Secret");
 	int error = -1;
 	struct ast_manager_user *user = NULL;
-	regex_t *regex_filter;
+	struct event_filter *filter;
 	struct ao2_iterator filter_iter;
+	struct ao2_container *sessions;
 
 	if (ast_strlen_zero(username)) {	/* missing username */
 		return -1;
@@ -3574,7 +3714,18 @@ static int authenticate(struct mansession *s, const struct message *m)
 	/* All of the user parameters are copied to the session so that in the event
 	* of a reload and a configuration change, the session parameters are not
 	* changed. */
+
+	/* The session registry hashes by username, so pull the session out of
+	 * its pre-login bucket and re-add it once the username is known. */
+	sessions = ao2_global_obj_ref(mgr_sessions);
+	if (sessions) {
+		ao2_unlink(sessions, s->session);
+	}
 	ast_copy_string(s->session->username, username, sizeof(s->session->username));
+	if (sessions) {
+		ao2_link(sessions, s->session);
+		ao2_ref(sessions, -1);
+	}
 	s->session->readperm = user->readperm;
 	s->session->writeperm = user->writeperm;
 	s->session->writetimeout = user->writetimeout;
@@ -3583,16 +3734,16 @@ static int authenticate(struct mansession *s, const struct message *m)
 	}
 
 	filter_iter = ao2_iterator_init(user->whitefilters, 0);
-	while ((regex_filter = ao2_iterator_next(&filter_iter))) {
-		ao2_t_link(s->session->whitefilters, regex_filter, "add white user filter to session");
-		ao2_t_ref(regex_filter, -1, "remove iterator ref");
+	while ((filter = ao2_iterator_next(&filter_iter))) {
+		ao2_t_link(s->session->whitefilters, filter, "add white user filter to session");
+		ao2_t_ref(filter, -1, "remove iterator ref");
 	}
 	ao2_iterator_destroy(&filter_iter);
 
 	filter_iter = ao2_iterator_init(user->blackfilters, 0);
-	while ((regex_filter = ao2_iterator_next(&filter_iter))) {
-		ao2_t_link(s->session->blackfilters, regex_filter, "add black user filter to session");
-		ao2_t_ref(regex_filter, -1, "remove iterator ref");
+	while ((filter = ao2_iterator_next(&filter_iter))) {
+		ao2_t_link(s->session->blackfilters, filter, "add black user filter to session");
+		ao2_t_ref(filter, -1, "remove iterator ref");
 	}
 	ao2_iterator_destroy(&filter_iter);
 
@@ -4308,7 +4459,7 @@ static int action_waitevent(struct mansession *s, const struct message *m)
 		while ((eqe = advance_event(eqe))) {
 			if (((s->session->readperm & eqe->category) == eqe->category)
 				&& ((s->session->send_events & eqe->category) == eqe->category)
-				&& match_filter(s, eqe->eventdata)) {
+				&& match_filter(s, eqe)) {
 				astman_append(s, "%s", eqe->eventdata);
 			}
 			s->session->last_ev = eqe;
@@ -6081,13 +6232,26 @@ static int action_timeout(struct mansession *s, const struct message *m)
 	return 0;
 }
 
+/*! \brief Evaluate one filter against an event, preferring the compiled event name */
+static int filter_event_cmp(struct event_filter *filter, struct eventqent *eqe)
+{
+	if (filter->event_name[0]) {
+		if (filter->exact) {
+			return !strcmp(filter->event_name, eqe->event_name);
+		}
+		return !strncmp(filter->event_name, eqe->event_name, strlen(filter->event_name));
+	}
+
+	return !regexec(&filter->regex, eqe->eventdata, 0, NULL, 0);
+}
+
 static int whitefilter_cmp_fn(void *obj, void *arg, void *data, int flags)
 {
-	regex_t *regex_filter = obj;
-	const char *eventdata = arg;
+	struct event_filter *filter = obj;
+	struct eventqent *eqe = arg;
 	int *result = data;
 
-	if (!regexec(regex_filter, eventdata, 0, NULL, 0)) {
+	if (filter_event_cmp(filter, eqe)) {
 		*result = 1;
 		return (CMP_MATCH | CMP_STOP);
 	}
@@ -6097,11 +6261,11 @@ static int whitefilter_cmp_fn(void *obj, void *arg, void *data, int flags)
 
 static int blackfilter_cmp_fn(void *obj, void *arg, void *data, int flags)
 {
-	regex_t *regex_filter = obj;
-	const char *eventdata = arg;
+	struct event_filter *filter = obj;
+	struct eventqent *eqe = arg;
 	int *result = data;
 
-	if (!regexec(regex_filter, eventdata, 0, NULL, 0)) {
+	if (filter_event_cmp(filter, eqe)) {
 		*result = 0;
 		return (CMP_MATCH | CMP_STOP);
 	}
@@ -6166,13 +6330,59 @@ static int action_filter(struct mansession *s, const struct message *m)
  * \endcode
  *
  */
-static enum add_filter_result manager_add_filter(const char *filter_pattern, struct ao2_container *whitefilters, struct ao2_container *blackfilters) {
-	regex_t *new_filter = ao2_t_alloc(sizeof(*new_filter), event_filter_destructor, "event_filter allocation");
-	int is_blackfilter;
+/*!
+ * \internal
+ * \brief Try to reduce a filter pattern to a literal event name
+ *
+ * Recognizes patterns of the form <literal>^?Event: name$?</literal>
+ * where name contains no regex metacharacters.  A trailing $ makes the
+ * comparison exact; without it the name is a prefix match, mirroring
+ * what the unanchored regex would have matched.
+ *
+ * \retval 0 pattern was reduced, name and exact are filled in
+ * \retval -1 pattern needs a real regex
+ */
+static int filter_compile_event_name(const char *filter_pattern, char *name, size_t name_len, int *exact)
+{
+	const char *p = filter_pattern;
+	size_t i = 0;
 
-	if (!new_filter) {
-		return FILTER_ALLOC_FAILED;
+	if (*p == '^') {
+		p++;
 	}
+	if (strncmp(p, "Event: ", 7)) {
+		return -1;
+	}
+	p += 7;
+
+	while (*p && (isalnum((unsigned char) *p) || *p == '_' || *p == '-')) {
+		if (i + 1 >= name_len) {
+			return -1;
+		}
+		name[i++] = *p++;
+	}
+	if (!i) {
+		return -1;
+	}
+	name[i] = '\0';
+
+	if (!strcmp(p, "$")) {
+		*exact = 1;
+		return 0;
+	}
+	if (*p) {
+		return -1;
+	}
+
+	*exact = 0;
+	return 0;
+}
+
+static enum add_filter_result manager_add_filter(const char *filter_pattern, struct ao2_container *whitefilters, struct ao2_container *blackfilters) {
+	struct event_filter *new_filter;
+	char event_name[sizeof(((struct eventqent *) NULL)->event_name)];
+	int exact = 0;
+	int is_blackfilter;
 
 	if (filter_pattern[0] == '!') {
 		is_blackfilter = 1;
@@ -6181,9 +6391,27 @@ static enum add_filter_result manager_add_filter(const char *filter_pattern, str
 		is_blackfilter = 0;
 	}
 
-	if (regcomp(new_filter, filter_pattern, REG_EXTENDED | REG_NOSUB)) {
-		ao2_t_ref(new_filter, -1, "failed to make regex");
-		return FILTER_COMPILE_FAIL;
+	/* Compile patterns that only constrain the event name down to a
+	 * literal comparison; everything else gets the full regex. */
+	if (filter_compile_event_name(filter_pattern, event_name, sizeof(event_name), &exact)) {
+		event_name[0] = '\0';
+	}
+
+	new_filter = ao2_t_alloc(sizeof(*new_filter) + strlen(event_name) + 1,
+		event_filter_destructor, "event_filter allocation");
+	if (!new_filter) {
+		return FILTER_ALLOC_FAILED;
+	}
+
+	strcpy(new_filter->event_name, event_name); /* Safe */
+	new_filter->exact = exact;
+
+	if (!new_filter->event_name[0]) {
+		if (regcomp(&new_filter->regex, filter_pattern, REG_EXTENDED | REG_NOSUB)) {
+			ao2_t_ref(new_filter, -1, "failed to make regex");
+			return FILTER_COMPILE_FAIL;
+		}
+		new_filter->regex_compiled = 1;
 	}
 
 	if (is_blackfilter) {
@@ -6197,29 +6425,29 @@ static enum add_filter_result manager_add_filter(const char *filter_pattern, str
 	return FILTER_SUCCESS;
 }
 
-static int match_filter(struct mansession *s, char *eventdata)
+static int match_filter(struct mansession *s, struct eventqent *eqe)
 {
 	int result = 0;
 
 	if (manager_debug) {
-		ast_verbose("<-- Examining AMI event: -->\n%s\n", eventdata);
+		ast_verbose("<-- Examining AMI event: -->\n%s\n", eqe->eventdata);
 	} else {
-		ast_debug(3, "Examining AMI event:\n%s\n", eventdata);
+		ast_debug(3, "Examining AMI event:\n%s\n", eqe->eventdata);
 	}
 	if (!ao2_container_count(s->session->whitefilters) && !ao2_container_count(s->session->blackfilters)) {
 		return 1; /* no filtering means match all */
 	} else if (ao2_container_count(s->session->whitefilters) && !ao2_container_count(s->session->blackfilters)) {
 		/* white filters only: implied black all filter processed first, then white filters */
-		ao2_t_callback_data(s->session->whitefilters, OBJ_NODATA, whitefilter_cmp_fn, eventdata, &result, "find filter in session filter container");
+		ao2_t_callback_data(s->session->whitefilters, OBJ_NODATA, whitefilter_cmp_fn, eqe, &result, "find filter in session filter container");
 	} else if (!ao2_container_count(s->session->whitefilters) && ao2_container_count(s->session->blackfilters)) {
 		/* black filters only: implied white all filter processed first, then black filters */
-		ao2_t_callback_data(s->session->blackfilters, OBJ_NODATA, blackfilter_cmp_fn, eventdata, &result, "find filter in session filter container");
+		ao2_t_callback_data(s->session->blackfilters, OBJ_NODATA, blackfilter_cmp_fn, eqe, &result, "find filter in session filter container");
 	} else {
 		/* white and black filters: implied black all filter processed first, then white filters, and lastly black filters */
-		ao2_t_callback_data(s->session->whitefilters, OBJ_NODATA, whitefilter_cmp_fn, eventdata, &result, "find filter in session filter container");
+		ao2_t_callback_data(s->session->whitefilters, OBJ_NODATA, whitefilter_cmp_fn, eqe, &result, "find filter in session filter container");
 		if (result) {
 			result = 0;
-			ao2_t_callback_data(s->session->blackfilters, OBJ_NODATA, blackfilter_cmp_fn, eventdata, &result, "find filter in session filter container");
+			ao2_t_callback_data(s->session->blackfilters, OBJ_NODATA, blackfilter_cmp_fn, eqe, &result, "find filter in session filter container");
 		}
 	}
 
@@ -6247,7 +6475,7 @@ static int process_events(struct mansession *s)
 			if (!ret && s->session->authenticated &&
 			    (s->session->readperm & eqe->category) == eqe->category &&
 			    (s->session->send_events & eqe->category) == eqe->category) {
-					if (match_filter(s, eqe->eventdata)) {
+					if (match_filter(s, eqe)) {
 						if (send_string(s, eqe->eventdata) < 0 || s->write_error)
 							ret = -1;	/* don't send more */
 					}
@@ -6397,8 +6625,10 @@ static int action_reload(struct mansession *s, const struct message *m)
 static int action_coreshowchannels(struct mansession *s, const struct message *m)
 {
 	const char *actionid = astman_get_header(m, "ActionID");
+	const char *generation_hdr = astman_get_header(m, "Generation");
 	char idText[256];
 	int numchans = 0;
+	int generation;
 	struct ao2_container *channels;
 	struct ao2_iterator it_chans;
 	struct ast_channel_snapshot *cs;
@@ -6409,6 +6639,19 @@ static int action_coreshowchannels(struct mansession *s, const struct message *m
 		idText[0] = '\0';
 	}
 
+	/* Sample the generation before dumping so a concurrent update can at
+	 * worst cause an unnecessary re-dump on the next poll, never a miss. */
+	generation = ast_channel_cache_generation();
+
+	if (!ast_strlen_zero(generation_hdr) && atoi(generation_hdr) == generation) {
+		/* Nothing has changed since the client's last dump. */
+		astman_send_listack(s, m, "Channels unchanged", "start");
+		astman_send_list_complete_start(s, m, "CoreShowChannelsComplete", 0);
+		astman_append(s, "Generation: %d\r\n", generation);
+		astman_send_list_complete_end(s);
+		return 0;
+	}
+
 	channels = ast_channel_cache_by_name();
 
 	astman_send_listack(s, m, "Channels will follow", "start");
@@ -6454,7 +6697,9 @@ static int action_coreshowchannels(struct mansession *s, const struct message *m
 	}
 	ao2_iterator_destroy(&it_chans);
 
-	astman_send_list_complete(s, m, "CoreShowChannelsComplete", numchans);
+	astman_send_list_complete_start(s, m, "CoreShowChannelsComplete", numchans);
+	astman_append(s, "Generation: %d\r\n", generation);
+	astman_send_list_complete_end(s);
 
 	ao2_ref(channels, -1);
 	return 0;
@@ -6601,6 +6846,211 @@ static void log_action(const struct message *m, const char *action)
  * the appropriate handler.
  */
 
+/*! \brief An action queued for execution off the session reader thread. */
+struct action_task {
+	struct mansession_session *session;
+	struct ast_tcptls_session_instance *tcptls_session;
+	struct manager_action *act_found;
+	/*! Running reference to the action's module; released after execution. */
+	struct ast_module *mod_ref;
+	/*! Private copy of the request headers. */
+	struct message m;
+};
+
+static void action_task_destroy(struct action_task *task)
+{
+	astman_free_headers(&task->m);
+	ao2_t_ref(task->act_found, -1, "done with async action object");
+	ao2_ref(task->session, -1);
+	ao2_ref(task->tcptls_session, -1);
+	ast_free(task);
+}
+
+/*! \brief Queue a completed async action response for the reader thread. */
+static void action_completion_queue(struct mansession_session *session, struct ast_str *buf, int destroy)
+{
+	struct action_completion *done;
+
+	done = ast_calloc(1, sizeof(*done));
+	if (!done) {
+		ast_free(buf);
+		return;
+	}
+	done->buf = buf;
+	done->destroy = destroy;
+
+	ao2_lock(session);
+	AST_LIST_INSERT_TAIL(&session->completions, done, list);
+	ao2_unlock(session);
+
+	/* Wake the reader thread the same way new events do. */
+	ast_mutex_lock(&session->notify_lock);
+	if (session->waiting_thread != AST_PTHREADT_NULL) {
+		pthread_kill(session->waiting_thread, SIGURG);
+	} else {
+		session->pending_event = 1;
+	}
+	ast_mutex_unlock(&session->notify_lock);
+}
+
+/*! \brief Execute a queued action, capturing its response for the reader thread. */
+static int action_task_exec(void *data)
+{
+	struct action_task *task = data;
+	struct mansession s = {
+		.session = task->session,
+		.tcptls_session = task->tcptls_session,
+	};
+	int ret;
+
+	ast_mutex_init(&s.lock);
+	s.response_buf = ast_str_create(256);
+	if (!s.response_buf) {
+		/* We cannot capture a response; drop the session rather than
+		 * leave the client waiting on a reply forever. */
+		action_completion_queue(task->session, NULL, 1);
+	} else {
+		ast_debug(1, "Running queued action '%s'\n", task->act_found->action);
+		ret = task->act_found->func(&s, &task->m);
+		action_completion_queue(task->session, s.response_buf,
+			(ret || s.write_error) ? 1 : 0);
+		s.response_buf = NULL;
+	}
+	ast_module_unref(task->mod_ref);
+	ast_mutex_destroy(&s.lock);
+	action_task_destroy(task);
+	return 0;
+}
+
+/*! \brief Actions that manipulate state shared with the reader thread and
+ * so must keep running on it.
+ *
+ * \note Logoff is deliberately not here: its session teardown request is
+ * carried by the completion's destroy flag, which keeps it ordered behind
+ * any still-running actions on the session.
+ */
+static int action_requires_session_thread(const char *action)
+{
+	return !strcasecmp(action, "Login")
+		|| !strcasecmp(action, "Challenge")
+		|| !strcasecmp(action, "Events")
+		|| !strcasecmp(action, "Filter")
+		|| !strcasecmp(action, "WaitEvent");
+}
+
+/*! \brief Determine if an action may be executed off the reader thread.
+ *
+ * Only plain AMI sessions qualify: HTTP sessions and custom hooks have no
+ * reader loop to deliver the completion, and unauthenticated sessions must
+ * keep the login sequence synchronous.
+ */
+static int action_can_run_async(struct mansession *s, const char *action)
+{
+	if (!actions_threadpool
+		|| s->hook
+		|| !s->session
+		|| s->session->managerid	/* HTTP sessions have no reader thread */
+		|| !s->session->action_tps
+		|| !s->session->authenticated) {
+		return 0;
+	}
+	return !action_requires_session_thread(action);
+}
+
+/*!
+ * \brief Queue an action for execution on the threadpool.
+ *
+ * By default actions go through the session's serializer, so responses
+ * complete in submission order.  A client may send <literal>Concurrent:
+ * true</literal> on read-only actions to run them directly on the pool,
+ * allowing them to complete out of order ahead of slower actions.
+ *
+ * \retval 0 the action was queued and the task owns \a mod_ref.
+ * \retval -1 queueing failed; the caller should run the action inline.
+ */
+static int action_dispatch(struct mansession *s, const struct message *m,
+	struct manager_action *act_found, struct ast_module *mod_ref)
+{
+	struct action_task *task;
+	unsigned int x;
+
+	task = ast_calloc(1, sizeof(*task));
+	if (!task) {
+		return -1;
+	}
+
+	for (x = 0; x < m->hdrcount; x++) {
+		task->m.headers[x] = ast_strdup(m->headers[x]);
+		if (!task->m.headers[x]) {
+			break;
+		}
+		++task->m.hdrcount;
+	}
+	if (task->m.hdrcount != m->hdrcount) {
+		astman_free_headers(&task->m);
+		ast_free(task);
+		return -1;
+	}
+
+	ao2_t_ref(act_found, +1, "bump found action for async execution");
+	task->act_found = act_found;
+	ao2_ref(s->session, +1);
+	task->session = s->session;
+	ao2_ref(s->tcptls_session, +1);
+	task->tcptls_session = s->tcptls_session;
+	task->mod_ref = mod_ref;
+
+	if (ast_true(astman_get_header(m, "Concurrent"))) {
+		if (!ast_threadpool_push(actions_threadpool, action_task_exec, task)) {
+			return 0;
+		}
+	} else if (!ast_taskprocessor_push(s->session->action_tps, action_task_exec, task)) {
+		return 0;
+	}
+
+	/* The caller keeps its module reference when we fail to queue. */
+	task->mod_ref = NULL;
+	action_task_destroy(task);
+	return -1;
+}
+
+/*! \brief Deliver any completed asynchronous action responses, in order.
+ *
+ * Called from the session's reader thread so that responses and event
+ * frames never interleave on the wire.
+ *
+ * \retval 0 Retain the session.
+ * \retval -1 An action requested the session be destroyed.
+ */
+static int flush_completions(struct mansession *s)
+{
+	struct action_completion *done;
+	int res = 0;
+
+	for (;;) {
+		ao2_lock(s->session);
+		done = AST_LIST_REMOVE_HEAD(&s->session->completions, list);
+		ao2_unlock(s->session);
+		if (!done) {
+			break;
+		}
+		if (done->buf) {
+			if (ast_str_strlen(done->buf)) {
+				send_string(s, ast_str_buffer(done->buf));
+			}
+			ast_free(done->buf);
+		}
+		if (done->destroy) {
+			res = -1;
+		}
+		ast_free(done);
+		if (res) {
+			break;
+		}
+	}
+	return res;
+}
+
 /*! \brief
  * Process an AMI message, performing desired action.
  * Return 0 on success, -1 on error that require the session to be destroyed.
@@ -6681,10 +7131,17 @@ static int process_message(struct mansession *s, const struct message *m)
 
 				ao2_unlock(act_found);
 				if (mod_ref || !act_found->module) {
-					ast_debug(1, "Running action '%s'\n", act_found->action);
-					ret = act_found->func(s, m);
+					if (action_can_run_async(s, action)
+						&& !action_dispatch(s, m, act_found, mod_ref)) {
+						/* Queued; the reader loop delivers the response
+						 * once the action completes. */
+						ret = 0;
+					} else {
+						ast_debug(1, "Running action '%s'\n", act_found->action);
+						ret = act_found->func(s, m);
+						ast_module_unref(mod_ref);
+					}
 					acted = 1;
-					ast_module_unref(mod_ref);
 				}
 			} else {
 				ao2_unlock(act_found);
@@ -6794,7 +7251,7 @@ static int get_input(struct mansession *s, char *output)
 		s->session->waiting_thread = pthread_self();
 		ast_mutex_unlock(&s->session->notify_lock);
 
-		res = ast_wait_for_input(ast_iostream_get_fd(s->session->stream), timeout);
+		res = ast_iostream_wait_for_input(s->session->stream, timeout);
 
 		ast_mutex_lock(&s->session->notify_lock);
 		s->session->waiting_thread = AST_PTHREADT_NULL;
@@ -6860,6 +7317,11 @@ static int do_message(struct mansession *s)
 
 	hdr_loss = 0;
 	for (;;) {
+		/* Deliver any completed asynchronous action responses */
+		if (flush_completions(s)) {
+			res = -1;
+			break;
+		}
 		/* Check if any events are pending and do them if needed */
 		if (process_events(s)) {
 			res = -1;
@@ -6979,6 +7441,18 @@ static void *session_do(void *data)
 	s.session = session;
 
 	AST_LIST_HEAD_INIT_NOLOCK(&session->datastores);
+	AST_LIST_HEAD_INIT_NOLOCK(&session->completions);
+
+	if (actions_threadpool) {
+		char tps_name[AST_TASKPROCESSOR_MAX_NAME + 1];
+
+		ast_taskprocessor_build_name(tps_name, sizeof(tps_name), "mgr/session");
+		session->action_tps = ast_threadpool_serializer(tps_name, actions_threadpool);
+		if (!session->action_tps) {
+			ast_log(LOG_WARNING, "Failed to create action serializer for %s; actions will run inline\n",
+				ast_sockaddr_stringify_addr(&session->addr));
+		}
+	}
 
 	if(time(&session->authstart) == -1) {
 		ast_log(LOG_ERROR, "error executing time(): %s; disconnecting client\n", strerror(errno));
@@ -7066,9 +7540,9 @@ static void purge_sessions(int n_max)
  * events are appended to a queue from where they
  * can be dispatched to clients.
  */
-static int append_event(const char *str, int category)
+static int append_event(const char *str, size_t len, int category)
 {
-	struct eventqent *tmp = ast_malloc(sizeof(*tmp) + strlen(str));
+	struct eventqent *tmp = ast_malloc(sizeof(*tmp) + len);
 	static int seq;	/* sequence number */
 
 	if (!tmp) {
@@ -7081,7 +7555,20 @@ static int append_event(const char *str, int category)
 	tmp->seq = ast_atomic_fetchadd_int(&seq, 1);
 	tmp->tv = ast_tvnow();
 	AST_RWLIST_NEXT(tmp, eq_next) = NULL;
-	strcpy(tmp->eventdata, str);
+	memcpy(tmp->eventdata, str, len + 1);
+
+	/* Pull the event name out once so compiled session filters can match
+	 * it without running a regex over the formatted event. */
+	tmp->event_name[0] = '\0';
+	if (!strncmp(str, "Event: ", 7)) {
+		size_t i;
+
+		str += 7;
+		for (i = 0; i < sizeof(tmp->event_name) - 1 && str[i] && str[i] != '\r' && str[i] != '\n'; i++) {
+			tmp->event_name[i] = str[i];
+		}
+		tmp->event_name[i] = '\0';
+	}
 
 	AST_RWLIST_WRLOCK(&all_events);
 	AST_RWLIST_INSERT_TAIL(&all_events, tmp, eq_next);
@@ -7170,7 +7657,7 @@ static int __attribute__((format(printf, 9, 0))) __manager_event_sessions_va(
 
 	ast_str_append(&buf, 0, "\r\n");
 
-	append_event(ast_str_buffer(buf), category);
+	append_event(ast_str_buffer(buf), ast_str_strlen(buf), category);
 
 	/* Wake up any sleeping sessions */
 	if (sessions) {
@@ -7277,6 +7764,9 @@ int ast_manager_unregister(const char *action)
 		}
 	}
 	AST_RWLIST_TRAVERSE_SAFE_END;
+	if (cur && action_index) {
+		ao2_t_unlink(action_index, cur, "action object removed from index");
+	}
 	AST_RWLIST_UNLOCK(&actions);
 
 	if (cur) {
@@ -7364,6 +7854,16 @@ static int ast_manager_register_struct(struct manager_action *act)
 		AST_RWLIST_INSERT_HEAD(&actions, act, list);
 	}
 
+	if (!action_index) {
+		/* Dispatch still works without the index; lookups just walk the list. */
+		action_index = ao2_t_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0,
+			ACTION_INDEX_BUCKETS, manager_action_hash_fn, NULL,
+			manager_action_cmp_fn, "Create registered action index");
+	}
+	if (action_index) {
+		ao2_t_link(action_index, act, "action object added to index");
+	}
+
 	ast_verb(2, "Manager registered action %s\n", act->action);
 
 	AST_RWLIST_UNLOCK(&actions);
@@ -8144,6 +8644,7 @@ static int auth_http_callback(struct ast_tcptls_session_instance *ser,
 {
 	struct mansession_session *session = NULL;
 	struct mansession s = { .session = NULL, .tcptls_session = ser };
+	struct ao2_container *sessions;
 	struct ast_variable *v, *params = get_params;
 	char template[] = "/tmp/ast-http-XXXXXX";	/* template for temporary file */
 	struct ast_str *http_header = NULL, *out = NULL;
@@ -8276,7 +8777,18 @@ static int auth_http_callback(struct ast_tcptls_session_instance *ser,
 		}
 		ao2_lock(session);
 
+		/* The session registry hashes by username, so pull the session
+		 * out of its pre-login bucket and re-add it once the username
+		 * is known. */
+		sessions = ao2_global_obj_ref(mgr_sessions);
+		if (sessions) {
+			ao2_unlink(sessions, session);
+		}
 		ast_copy_string(session->username, u_username, sizeof(session->username));
+		if (sessions) {
+			ao2_link(sessions, session);
+			ao2_ref(sessions, -1);
+		}
 		session->managerid = nonce;
 		session->last_ev = grab_last();
 		AST_LIST_HEAD_INIT_NOLOCK(&session->datastores);
@@ -9055,6 +9567,11 @@ static void manager_shutdown(void)
 	ast_tcptls_server_stop(&ami_desc);
 	ast_tcptls_server_stop(&amis_desc);
 
+	if (actions_threadpool) {
+		ast_threadpool_shutdown(actions_threadpool);
+		actions_threadpool = NULL;
+	}
+
 	ast_free(ami_tls_cfg.certfile);
 	ami_tls_cfg.certfile = NULL;
 	ast_free(ami_tls_cfg.pvtfile);
@@ -9068,6 +9585,9 @@ static void manager_shutdown(void)
 
 	ao2_global_obj_release(mgr_sessions);
 
+	ao2_cleanup(action_index);
+	action_index = NULL;
+
 	while ((user = AST_LIST_REMOVE_HEAD(&users, list))) {
 		manager_free_user(user);
 	}
@@ -9204,6 +9724,22 @@ static int __init_manager(int reload, int by_external_config)
 			return -1;
 		}
 
+		{
+			struct ast_threadpool_options pool_opts = {
+				.version = AST_THREADPOOL_OPTIONS_VERSION,
+				.idle_timeout = ACTION_POOL_IDLE_TIMEOUT,
+				.auto_increment = ACTION_POOL_AUTO_INCREMENT,
+				.initial_size = 0,
+				.max_size = 0,
+			};
+
+			actions_threadpool = ast_threadpool_create("mgr/actions", NULL, &pool_opts);
+			if (!actions_threadpool) {
+				/* Not fatal; actions run inline on their session threads. */
+				ast_log(LOG_WARNING, "Failed to create AMI action threadpool\n");
+			}
+		}
+
 		/* Register default actions */
 		ast_manager_register_xml_core("Ping", 0, action_ping);
 		ast_manager_register_xml_core("Events", 0, action_events);
@@ -9253,7 +9789,7 @@ static int __init_manager(int reload, int by_external_config)
 		ast_extension_state_add(NULL, NULL, manager_state_cb, NULL);
 
 		/* Append placeholder event so master_eventq never runs dry */
-		if (append_event("Event: Placeholder\r\n\r\n", 0)) {
+		if (append_event("Event: Placeholder\r\n\r\n", strlen("Event: Placeholder\r\n\r\n"), 0)) {
 			return -1;
 		}
 
@@ -9265,8 +9801,11 @@ static int __init_manager(int reload, int by_external_config)
 		}
 #endif
 
-		/* If you have a NULL hash fn, you only need a single bucket */
-		sessions = ao2_container_alloc_list(AO2_ALLOC_OPT_LOCK_MUTEX, 0, NULL, mansession_cmp_fn);
+		/* Hash the sessions by username and guard them with a rwlock so
+		 * event fan-out (a read-side traversal) does not serialize
+		 * against session lookups or other broadcasters. */
+		sessions = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0,
+			MANSESSION_BUCKETS, mansession_hash_fn, NULL, mansession_cmp_fn);
 		if (!sessions) {
 			return -1;
 		}
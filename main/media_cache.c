@@ -36,6 +36,7 @@
 #include "asterisk/astdb.h"
 #include "asterisk/cli.h"
 #include "asterisk/file.h"
+#include "asterisk/taskprocessor.h"
 #include "asterisk/media_cache.h"
 
 /*! The name of the AstDB family holding items in the cache. */
@@ -50,6 +51,83 @@
 /*! Our one and only container holding media items */
 static struct ao2_container *media_cache;
 
+/*! Taskprocessor performing background refreshes of stale items */
+static struct ast_taskprocessor *refresh_tps;
+
+/*! URIs that currently have a refresh task queued */
+static struct ao2_container *pending_refreshes;
+
+static int media_cache_retrieve(const char *uri, const char *preferred_file_name,
+	char *file_path, size_t len, int wait_for_refresh);
+
+/*! \brief Data for a queued background refresh, in a single allocation */
+struct media_refresh_task {
+	/*! Points into \c uri storage, or NULL if none was given */
+	char *preferred_file_name;
+	char uri[0];
+};
+
+/*!
+ * \internal
+ * \brief Taskprocessor callback re-retrieving a stale URI from its backend
+ */
+static int media_cache_refresh_cb(void *data)
+{
+	struct media_refresh_task *task = data;
+	char file_path[PATH_MAX];
+
+	/* Failures are fine here; the stale copy stays in place and the
+	 * next playback queues another attempt */
+	media_cache_retrieve(task->uri, task->preferred_file_name,
+		file_path, sizeof(file_path), 1);
+
+	ast_str_container_remove(pending_refreshes, task->uri);
+	ast_free(task);
+
+	return 0;
+}
+
+/*!
+ * \internal
+ * \brief Queue a background refresh of \c uri, unless one is already pending
+ */
+static void media_cache_refresh_queue(const char *uri, const char *preferred_file_name)
+{
+	struct media_refresh_task *task;
+	char *pending;
+	size_t uri_len = strlen(uri) + 1;
+
+	ao2_lock(pending_refreshes);
+	pending = ao2_find(pending_refreshes, uri, OBJ_SEARCH_KEY | OBJ_NOLOCK);
+	if (pending) {
+		ao2_ref(pending, -1);
+		ao2_unlock(pending_refreshes);
+		return;
+	}
+	if (ast_str_container_add(pending_refreshes, uri)) {
+		ao2_unlock(pending_refreshes);
+		return;
+	}
+	ao2_unlock(pending_refreshes);
+
+	task = ast_malloc(sizeof(*task) + uri_len
+		+ (preferred_file_name ? strlen(preferred_file_name) + 1 : 0));
+	if (task) {
+		strcpy(task->uri, uri); /* Safe */
+		if (preferred_file_name) {
+			task->preferred_file_name = task->uri + uri_len;
+			strcpy(task->preferred_file_name, preferred_file_name); /* Safe */
+		} else {
+			task->preferred_file_name = NULL;
+		}
+	}
+
+	if (!task || ast_taskprocessor_push(refresh_tps, media_cache_refresh_cb, task)) {
+		ast_free(task);
+		ast_str_container_remove(pending_refreshes, uri);
+	}
+}
+
 int ast_media_cache_exists(const char *uri)
 {
 	struct ast_bucket_file *bucket_file;
@@ -154,8 +232,8 @@ static void bucket_file_update_path(struct ast_bucket_file *bucket_file,
 	}
 }
 
-int ast_media_cache_retrieve(const char *uri, const char *preferred_file_name,
-	char *file_path, size_t len)
+static int media_cache_retrieve(const char *uri, const char *preferred_file_name,
+	char *file_path, size_t len, int wait_for_refresh)
 {
 	struct ast_bucket_file *bucket_file;
 	struct ast_bucket_file *tmp_bucket_file;
@@ -173,7 +251,9 @@ int ast_media_cache_retrieve(const char *uri, const char *preferred_file_name,
 	 */
 	bucket_file = ao2_find(media_cache, uri, OBJ_SEARCH_KEY | OBJ_NOLOCK);
 	if (bucket_file) {
-		if (!ast_bucket_file_is_stale(bucket_file)
+		int stale = ast_bucket_file_is_stale(bucket_file);
+
+		if ((!stale || !wait_for_refresh)
 			&& ast_file_is_readable(bucket_file->path)) {
 			ast_copy_string(file_path, bucket_file->path, len);
 			if ((ext = strrchr(file_path, '.'))) {
@@ -181,8 +261,15 @@ int ast_media_cache_retrieve(const char *uri, const char *preferred_file_name,
 			}
 			ao2_ref(bucket_file, -1);
 
-			ast_debug(5, "Returning media at local file: %s\n", file_path);
+			ast_debug(5, "Returning media at local file: %s%s\n", file_path,
+				stale ? " (stale, queueing refresh)" : "");
 			ao2_unlock(media_cache);
+
+			if (stale) {
+				/* Serve the copy we have now; the caller must not stall
+				 * for the download, so freshen it in the background */
+				media_cache_refresh_queue(uri, preferred_file_name);
+			}
 			return 0;
 		}
 
@@ -238,6 +325,12 @@ int ast_media_cache_retrieve(const char *uri, const char *preferred_file_name,
 	return 0;
 }
 
+int ast_media_cache_retrieve(const char *uri, const char *preferred_file_name,
+	char *file_path, size_t len)
+{
+	return media_cache_retrieve(uri, preferred_file_name, file_path, len, 0);
+}
+
 int ast_media_cache_retrieve_metadata(const char *uri, const char *key,
 	char *value, size_t len)
 {
@@ -662,6 +755,10 @@ static struct ast_cli_entry cli_media_cache[] = {
  */
 static void media_cache_shutdown(void)
 {
+	refresh_tps = ast_taskprocessor_unreference(refresh_tps);
+	ao2_cleanup(pending_refreshes);
+	pending_refreshes = NULL;
+
 	ao2_cleanup(media_cache);
 	media_cache = NULL;
 
@@ -678,6 +775,16 @@ int ast_media_cache_init(void)
 		return -1;
 	}
 
+	pending_refreshes = ast_str_container_alloc(AO2_BUCKETS);
+	if (!pending_refreshes) {
+		return -1;
+	}
+
+	refresh_tps = ast_taskprocessor_get("media_cache", TPS_REF_DEFAULT);
+	if (!refresh_tps) {
+		return -1;
+	}
+
 	if (ast_cli_register_multiple(cli_media_cache, ARRAY_LEN(cli_media_cache))) {
 		return -1;
 	}
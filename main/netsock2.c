@@ -450,6 +450,40 @@ int ast_sockaddr_cmp_addr(const struct ast_sockaddr *a, const struct ast_sockadd
 	return ret;
 }
 
+int ast_sockaddr_to_key(const struct ast_sockaddr *addr, struct ast_sockaddr_key *key)
+{
+	union {
+		unsigned char buf[16];
+		uint64_t word[2];
+	} canonical = { .word = { 0, 0 }, };
+
+	if (ast_sockaddr_is_ipv4(addr)) {
+		const struct sockaddr_in *sin = (const struct sockaddr_in *) &addr->ss;
+
+		/* Store IPv4 addresses in their IPv4-mapped IPv6 form so a mapped
+		 * address and its plain IPv4 equivalent produce the same key. */
+		canonical.buf[10] = 0xff;
+		canonical.buf[11] = 0xff;
+		memcpy(&canonical.buf[12], &sin->sin_addr, sizeof(sin->sin_addr));
+		key->scope_id = 0;
+		key->port = sin->sin_port;
+	} else if (ast_sockaddr_is_ipv6(addr)) {
+		const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *) &addr->ss;
+
+		memcpy(canonical.buf, &sin6->sin6_addr, sizeof(sin6->sin6_addr));
+		key->scope_id = sin6->sin6_scope_id;
+		key->port = sin6->sin6_port;
+	} else {
+		memset(key, 0, sizeof(*key));
+		return -1;
+	}
+
+	key->addr[0] = canonical.word[0];
+	key->addr[1] = canonical.word[1];
+
+	return 0;
+}
+
 uint16_t _ast_sockaddr_port(const struct ast_sockaddr *addr, const char *file, int line, const char *func)
 {
 	/*
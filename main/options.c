@@ -77,6 +77,16 @@ int ast_option_pjproject_cache_pools;
 double ast_option_maxload;
 /*! Max number of active calls */
 int ast_option_maxcalls;
+/*! Number of pre-constructed channel shells to keep warm */
+int ast_option_channel_pool_size;
+/*! Megabytes of sound files to share between streams, 0 disables the cache */
+int ast_option_soundscachesize;
+/*! Max threads flushing recordings off the media threads, 0 writes inline */
+int ast_option_recordasyncthreads;
+/*! fsync() recorded files before closing them */
+int ast_option_recordfsync;
+/*! Minimum ms between insignificant channel snapshot publishes, 0 publishes every change */
+int ast_option_snapshotcoalesce;
 /*! Max number of open file handles (files, sockets) */
 int ast_option_maxfiles;
 /*! Minimum duration of DTMF. */
@@ -385,6 +395,36 @@ void load_asterisk_conf(void)
 			if ((sscanf(v->value, "%30d", &ast_option_maxcalls) != 1) || (ast_option_maxcalls < 0)) {
 				ast_option_maxcalls = 0;
 			}
+		/* How many megabytes of sound files to keep in memory, shared by all streams */
+		} else if (!strcasecmp(v->name, "sounds_cache_size")) {
+			if ((sscanf(v->value, "%30d", &ast_option_soundscachesize) != 1)
+				|| (ast_option_soundscachesize < 0)) {
+				ast_option_soundscachesize = 0;
+			}
+		/* How many writer threads flush recordings off the media threads */
+		} else if (!strcasecmp(v->name, "record_async_threads")) {
+			if ((sscanf(v->value, "%30d", &ast_option_recordasyncthreads) != 1)
+				|| (ast_option_recordasyncthreads < 0)
+				|| (ast_option_recordasyncthreads > 64)) {
+				ast_option_recordasyncthreads = 0;
+			}
+		/* Whether recorded files are fsync()ed before they are closed */
+		} else if (!strcasecmp(v->name, "record_fsync")) {
+			ast_option_recordfsync = ast_true(v->value);
+		/* Minimum milliseconds between channel snapshot publishes which carry no significant change */
+		} else if (!strcasecmp(v->name, "snapshot_coalesce")) {
+			if ((sscanf(v->value, "%30d", &ast_option_snapshotcoalesce) != 1)
+				|| (ast_option_snapshotcoalesce < 0)
+				|| (ast_option_snapshotcoalesce > 10000)) {
+				ast_option_snapshotcoalesce = 0;
+			}
+		/* Number of pre-constructed channel shells to keep warm for call setup bursts */
+		} else if (!strcasecmp(v->name, "channel_pool_size")) {
+			if ((sscanf(v->value, "%30d", &ast_option_channel_pool_size) != 1)
+				|| (ast_option_channel_pool_size < 0)
+				|| (ast_option_channel_pool_size > 4096)) {
+				ast_option_channel_pool_size = 0;
+			}
 		} else if (!strcasecmp(v->name, "maxload")) {
 			double test[1];
 
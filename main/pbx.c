@@ -247,6 +247,7 @@ struct ast_exten {
 	struct ast_app *cached_app;     /*!< Cached location of application */
 	void *data;			/*!< Data to use (arguments) */
 	void (*datad)(void *);		/*!< Data destructor */
+	int data_needs_subst;		/*!< Non-zero if data contains variables or expressions to substitute */
 	struct ast_exten *peer;		/*!< Next higher priority with our extension */
 	struct ast_hashtab *peer_table;    /*!< Priorities list in hashtab form -- only on the head of the peer list */
 	struct ast_hashtab *peer_label_table; /*!< labeled priorities in the peers -- only on the head of the peer list */
@@ -284,6 +285,7 @@ struct scoreboard  /* make sure all fields are 0 before calling new_find_extensi
 struct ast_context {
 	ast_rwlock_t lock;			/*!< A lock to prevent multiple threads from clobbering the context */
 	struct ast_exten *root;			/*!< The root of the list of extensions */
+	struct ast_exten *ins_cache;		/*!< Most recently inserted extension; scan resume hint for sorted bulk loads */
 	struct ast_hashtab *root_table;            /*!< For exact matches on the extensions in the pattern tree, and for traversals of the pattern_tree  */
 	struct match_char *pattern_tree;        /*!< A tree to speed up extension pattern matching */
 	struct ast_context *next;		/*!< Link them together */
@@ -343,6 +345,11 @@ struct ast_hint {
 	char exten_name[AST_MAX_EXTENSION];/*!< Extension of destroyed hint extension. */
 
 	AST_VECTOR(, char *) devices; /*!< Devices associated with the hint */
+
+	/*! Count of member devices in each device state, maintained incrementally */
+	unsigned int state_counts[AST_DEVICE_TOTAL];
+	/*! Non-zero when state_counts and the member device cached states are seeded */
+	unsigned int state_counts_valid:1;
 };
 
 STASIS_MESSAGE_TYPE_DEFN_LOCAL(hint_change_message_type);
@@ -372,6 +379,10 @@ struct ast_hintdevice {
 	 * \note Holds a reference to the hint object.
 	 */
 	struct ast_hint *hint;
+	/*! Last known state of this device, valid when state_known is set. */
+	enum ast_device_state last_state;
+	/*! Non-zero once last_state has been seeded. */
+	unsigned int state_known:1;
 	/*! Name of the hint device. */
 	char hintdevice[1];
 };
@@ -500,8 +511,8 @@ static int autohint_cmp(void *obj, void *arg, int flags)
 	return cmp ? 0 : CMP_MATCH | CMP_STOP;
 }
 
-/*! \internal \brief \c ao2_callback function to remove hintdevices */
-static int hintdevice_remove_cb(void *obj, void *arg, void *data, int flags)
+/*! \internal \brief \c ao2_callback function to match a hint's entry for a device name */
+static int hintdevice_find_cb(void *obj, void *arg, void *data, int flags)
 {
 	struct ast_hintdevice *candidate = obj;
 	char *device = arg;
@@ -516,11 +527,15 @@ static int hintdevice_remove_cb(void *obj, void *arg, void *data, int flags)
 
 static int remove_hintdevice(struct ast_hint *hint)
 {
+	ao2_lock(hint);
+	hint->state_counts_valid = 0;
+	ao2_unlock(hint);
+
 	while (AST_VECTOR_SIZE(&hint->devices) > 0) {
 		char *device = AST_VECTOR_GET(&hint->devices, 0);
 
 		ao2_t_callback_data(hintdevices, OBJ_SEARCH_KEY | OBJ_UNLINK | OBJ_NODATA,
-			hintdevice_remove_cb, device, hint, "Remove device from container");
+			hintdevice_find_cb, device, hint, "Remove device from container");
 		AST_VECTOR_REMOVE_UNORDERED(&hint->devices, 0);
 		ast_free(device);
 	}
@@ -562,6 +577,11 @@ static int add_hintdevice(struct ast_hint *hint, const char *devicelist)
 	if (!(str = ast_str_thread_get(&hintdevice_data, 16))) {
 		return -1;
 	}
+
+	/* The membership is changing so the incremental counts must be reseeded. */
+	ao2_lock(hint);
+	hint->state_counts_valid = 0;
+	ao2_unlock(hint);
 	ast_str_set(&str, 0, "%s", devicelist);
 	parse = ast_str_buffer(str);
 
@@ -2861,6 +2881,21 @@ static struct ast_custom_function exception_function = {
 	.read = acf_exception_read,
 };
 
+/*!
+ * \internal
+ * \brief Determine whether extension data requires variable substitution.
+ *
+ * The answer only depends on the registered data, so it is computed once
+ * when the extension is added instead of rescanning the arguments on every
+ * priority of every call.
+ */
+static int exten_data_needs_subst(const char *data)
+{
+	const char *dollar = data ? strchr(data, '$') : NULL;
+
+	return dollar && (strstr(dollar, "${") || strstr(dollar, "$["));
+}
+
 /*!
  * \brief The return value depends on the action:
  *
@@ -2919,15 +2954,12 @@ static int pbx_extension_helper(struct ast_channel *c, struct ast_context *con,
 			app = e->cached_app;
 			if (ast_strlen_zero(e->data)) {
 				*passdata = '\0';
+			} else if (!e->data_needs_subst) {
+				/* no variables to substitute, copy on through */
+				ast_copy_string(passdata, e->data, sizeof(passdata));
 			} else {
-				const char *tmp;
-				if ((!(tmp = strchr(e->data, '$'))) || (!strstr(tmp, "${") && !strstr(tmp, "$["))) {
-					/* no variables to substitute, copy on through */
-					ast_copy_string(passdata, e->data, sizeof(passdata));
-				} else {
-					/* save e->data on stack for later processing after lock released */
-					substitute = ast_strdupa(e->data);
-				}
+				/* save e->data on stack for later processing after lock released */
+				substitute = ast_strdupa(e->data);
 			}
 			ast_unlock_contexts();
 			if (!app) {
@@ -3374,7 +3406,114 @@ static void get_device_state_causing_channels(struct ao2_container *c)
 	ao2_iterator_destroy(&iter);
 }
 
-static void device_state_notify_callbacks(struct ast_hint *hint, struct ast_str **hint_app)
+/*!
+ * \internal
+ * \brief Compute the extension state of a hint from its incremental counts.
+ *
+ * \note The hint must be locked.
+ */
+static int hint_state_from_counts(const unsigned int *state_counts)
+{
+	struct ast_devstate_aggregate agg;
+	int state;
+
+	/*
+	 * The aggregate result only depends on which states are present,
+	 * not on the order the member devices were folded in, so feeding
+	 * each represented state once gives the same answer as scanning
+	 * every device.
+	 */
+	ast_devstate_aggregate_init(&agg);
+	for (state = 0; state < AST_DEVICE_TOTAL; state++) {
+		if (state_counts[state]) {
+			ast_devstate_aggregate_add(&agg, state);
+		}
+	}
+	return ast_devstate_to_extenstate(ast_devstate_aggregate_result(&agg));
+}
+
+/*!
+ * \internal
+ * \brief Apply one device transition to a hint's incremental aggregate.
+ *
+ * \retval state The extension state computed from the updated counts.
+ * \retval -1 if the counts are not valid and a full device scan is needed.
+ */
+static int hint_update_device_state(struct ast_hintdevice *device, enum ast_device_state new_state)
+{
+	struct ast_hint *hint = device->hint;
+	int state;
+
+	if (AST_DEVICE_TOTAL <= (unsigned int) new_state) {
+		return -1;
+	}
+
+	ao2_lock(hint);
+	if (!hint->state_counts_valid || !device->state_known) {
+		ao2_unlock(hint);
+		return -1;
+	}
+	if (device->last_state != new_state) {
+		if (hint->state_counts[device->last_state]) {
+			hint->state_counts[device->last_state]--;
+		}
+		hint->state_counts[new_state]++;
+		device->last_state = new_state;
+	}
+	state = hint_state_from_counts(hint->state_counts);
+	ao2_unlock(hint);
+
+	return state;
+}
+
+/*!
+ * \internal
+ * \brief Seed the incremental device state counts for a hint.
+ *
+ * Queries every member device once, off the same subscription thread
+ * that applies transitions, with no locks held during the queries just
+ * like a full aggregate scan.
+ */
+static void hint_seed_state_counts(struct ast_hint *hint, struct ast_str **hint_app)
+{
+	unsigned int state_counts[AST_DEVICE_TOTAL] = { 0, };
+	char *parse;
+	char *cur;
+
+	ao2_lock(hint);
+	if (!hint->exten) {
+		/* The extension has already been destroyed */
+		ao2_unlock(hint);
+		return;
+	}
+	ast_str_set(hint_app, 0, "%s", ast_get_extension_app(hint->exten));
+	ao2_unlock(hint);
+
+	parse = parse_hint_device(*hint_app);
+	while ((cur = strsep(&parse, "&"))) {
+		enum ast_device_state state = ast_device_state(cur);
+		struct ast_hintdevice *device;
+
+		if ((unsigned int) state < AST_DEVICE_TOTAL) {
+			state_counts[state]++;
+		}
+		device = ao2_t_callback_data(hintdevices, OBJ_SEARCH_KEY,
+			hintdevice_find_cb, cur, hint, "Find hint's entry for this device");
+		if (device) {
+			device->last_state = state;
+			device->state_known = 1;
+			ao2_t_ref(device, -1, "Done seeding device entry");
+		}
+	}
+
+	ao2_lock(hint);
+	memcpy(hint->state_counts, state_counts, sizeof(hint->state_counts));
+	hint->state_counts_valid = 1;
+	ao2_unlock(hint);
+}
+
+static void device_state_notify_callbacks(struct ast_hint *hint, struct ast_str **hint_app,
+	int cached_state)
 {
 	struct ao2_iterator cb_iter;
 	struct ast_state_cb *state_cb;
@@ -3417,7 +3556,14 @@ static void device_state_notify_callbacks(struct ast_hint *hint, struct ast_str
 	 */
 	device_state_info = alloc_device_state_info();
 
-	state = ast_extension_state3(*hint_app, device_state_info);
+	if (cached_state < 0) {
+		state = ast_extension_state3(*hint_app, device_state_info);
+	} else {
+		/* The incremental aggregate already knows the answer; the
+		 * per device detail is only gathered below if an extended
+		 * callback actually needs it. */
+		state = cached_state;
+	}
 	same_state = state == hint->laststate;
 	if (same_state && (~state & AST_EXTENSION_RINGING)) {
 		ao2_cleanup(device_state_info);
@@ -3451,6 +3597,10 @@ static void device_state_notify_callbacks(struct ast_hint *hint, struct ast_str
 		if (state_cb->extended && first_extended_cb_call) {
 			/* Fill detailed device_state_info now that we know it is used by extd. callback */
 			first_extended_cb_call = 0;
+			if (cached_state >= 0) {
+				/* The incremental path skipped the device scan. */
+				ast_extension_state3(*hint_app, device_state_info);
+			}
 			get_device_state_causing_channels(device_state_info);
 		}
 		if (state_cb->extended || !same_state) {
@@ -3558,7 +3708,7 @@ static int handle_hint_change_message_type(struct stasis_message *msg, enum ast_
 
 	switch (reason) {
 	case AST_HINT_UPDATE_DEVICE:
-		device_state_notify_callbacks(hint, &hint_app);
+		device_state_notify_callbacks(hint, &hint_app, -1);
 		break;
 	case AST_HINT_UPDATE_PRESENCE:
 		{
@@ -3663,7 +3813,15 @@ static void device_state_cb(void *unused, struct stasis_subscription *sub, struc
 	if (dev_iter) {
 		for (; (device = ao2_iterator_next(dev_iter)); ao2_t_ref(device, -1, "Next device")) {
 			if (device->hint) {
-				device_state_notify_callbacks(device->hint, &hint_app);
+				int cached_state = hint_update_device_state(device, dev_state->state);
+
+				if (cached_state < 0) {
+					/* First transition seen for this hint (or its devices
+					 * changed); pay for one full scan to seed the counts. */
+					hint_seed_state_counts(device->hint, &hint_app);
+					cached_state = hint_update_device_state(device, dev_state->state);
+				}
+				device_state_notify_callbacks(device->hint, &hint_app, cached_state);
 			}
 		}
 		ao2_iterator_destroy(dev_iter);
@@ -5001,6 +5159,9 @@ int ast_context_remove_extension_callerid2(struct ast_context *con, const char *
 	if (!already_locked)
 		ast_wrlock_context(con);
 
+	/* The extension about to be removed may be the insertion scan hint. */
+	con->ins_cache = NULL;
+
 #ifdef NEED_DEBUG
 	ast_verb(3,"Removing %s/%s/%d%s%s from trees, registrar=%s\n", con->name, extension, priority, matchcallerid ? "/" : "", matchcallerid ? callerid : "", registrar);
 #endif
@@ -6470,6 +6631,7 @@ void ast_merge_contexts_and_delete(struct ast_context **extcontexts, struct ast_
 {
 	double ft;
 	struct ast_context *tmp;
+	struct ast_context *scanned_head;
 	struct ast_context *oldcontextslist;
 	struct ast_hashtab *oldtable;
 	struct store_hints hints_stored = AST_LIST_HEAD_NOLOCK_INIT_VALUE;
@@ -6479,7 +6641,6 @@ void ast_merge_contexts_and_delete(struct ast_context **extcontexts, struct ast_
 	struct ast_exten *exten;
 	int length;
 	struct ast_state_cb *thiscb;
-	struct ast_hashtab_iter *iter;
 	struct ao2_iterator i;
 	int ctx_count = 0;
 	struct timeval begintime;
@@ -6501,8 +6662,8 @@ void ast_merge_contexts_and_delete(struct ast_context **extcontexts, struct ast_
 
 	begintime = ast_tvnow();
 	ast_mutex_lock(&context_merge_lock);/* Serialize ast_merge_contexts_and_delete */
-	ast_wrlock_contexts();
 
+	ast_wrlock_contexts();
 	if (!contexts_table) {
 		/* Create any autohint contexts */
 		context_table_create_autohints(exttable);
@@ -6514,13 +6675,35 @@ void ast_merge_contexts_and_delete(struct ast_context **extcontexts, struct ast_
 		ast_mutex_unlock(&context_merge_lock);
 		return;
 	}
+	ast_unlock_contexts();
 
-	iter = ast_hashtab_start_traversal(contexts_table);
-	while ((tmp = ast_hashtab_next(iter))) {
+	/*
+	 * Scan the old dialplan and merge leftovers belonging to other
+	 * registrars into the still private new tables while holding the
+	 * contexts lock only for reading, so call processing continues
+	 * against the old dialplan during the expensive part of the merge.
+	 * context_merge_lock keeps other merges out, each scanned context
+	 * is read locked to hold off extension changes to it, and contexts
+	 * created concurrently are only ever inserted at the head of the
+	 * list, so they are picked up below once the write lock is held.
+	 */
+	ast_rdlock_contexts();
+	scanned_head = contexts;
+	for (tmp = scanned_head; tmp; tmp = tmp->next) {
+		++ctx_count;
+		ast_rdlock_context(tmp);
+		context_merge(extcontexts, exttable, tmp, registrar);
+		ast_unlock_context(tmp);
+	}
+	ast_unlock_contexts();
+
+	ast_wrlock_contexts();
+
+	/* Merge any contexts that were created while the scan above ran. */
+	for (tmp = contexts; tmp && tmp != scanned_head; tmp = tmp->next) {
 		++ctx_count;
 		context_merge(extcontexts, exttable, tmp, registrar);
 	}
-	ast_hashtab_end_traversal(iter);
 
 	ao2_lock(hints);
 	writelocktime = ast_tvnow();
@@ -7469,6 +7652,7 @@ static int ast_add_extension2_lockopt(struct ast_context *con,
 	strcpy(p, application);
 	tmp->parent = con;
 	tmp->data = data;
+	tmp->data_needs_subst = exten_data_needs_subst(data);
 	tmp->datad = datad;
 	tmp->registrar = registrar;
 	tmp->registrar_line = registrar_line;
@@ -7491,22 +7675,49 @@ static int ast_add_extension2_lockopt(struct ast_context *con,
 		}
 	}
 	res = 0; /* some compilers will think it is uninitialized otherwise */
-	for (e = con->root; e; el = e, e = e->next) {   /* scan the extension list */
-		res = ext_cmp(e->exten, tmp->exten);
-		if (res == 0) { /* extension match, now look at cidmatch */
-			if (e->matchcid == AST_EXT_MATCHCID_OFF && tmp->matchcid == AST_EXT_MATCHCID_OFF)
-				res = 0;
-			else if (tmp->matchcid == AST_EXT_MATCHCID_ON && e->matchcid == AST_EXT_MATCHCID_OFF)
-				res = 1;
-			else if (e->matchcid == AST_EXT_MATCHCID_ON && tmp->matchcid == AST_EXT_MATCHCID_OFF)
-				res = -1;
-			else
-				res = ext_cmp(e->cidmatch, tmp->cidmatch);
+
+	/*
+	 * Rescanning the sorted extension list from the start for every added
+	 * priority made loading very large contexts quadratic.  Another
+	 * priority of an already present extension is found through the
+	 * context's hash table instead, and when a brand new extension sorts
+	 * after the most recently inserted one - the normal case when loading
+	 * a sorted dump - the scan resumes from that insertion point.
+	 */
+	e = con->root_table ? ast_hashtab_lookup(con->root_table, tmp) : NULL;
+	if (e) {
+		if (replace) {
+			/* The replace path of add_priority() needs the list predecessor. */
+			for (el = NULL, tmp2 = con->root; tmp2 && tmp2 != e; el = tmp2, tmp2 = tmp2->next) {
+			}
+		}
+	} else {
+		e = con->root;
+		if (con->ins_cache && ext_cmp(con->ins_cache->exten, tmp->exten) < 0) {
+			el = con->ins_cache;
+			e = el->next;
+		}
+		for (; e; el = e, e = e->next) {   /* scan the extension list */
+			res = ext_cmp(e->exten, tmp->exten);
+			if (res == 0) { /* extension match, now look at cidmatch */
+				if (e->matchcid == AST_EXT_MATCHCID_OFF && tmp->matchcid == AST_EXT_MATCHCID_OFF)
+					res = 0;
+				else if (tmp->matchcid == AST_EXT_MATCHCID_ON && e->matchcid == AST_EXT_MATCHCID_OFF)
+					res = 1;
+				else if (e->matchcid == AST_EXT_MATCHCID_ON && tmp->matchcid == AST_EXT_MATCHCID_OFF)
+					res = -1;
+				else
+					res = ext_cmp(e->cidmatch, tmp->cidmatch);
+			}
+			if (res >= 0)
+				break;
 		}
-		if (res >= 0)
-			break;
 	}
 	if (e && res == 0) { /* exact match, insert in the priority chain */
+		if (con->ins_cache == e) {
+			/* add_priority() may free or replace the head on the replace path */
+			con->ins_cache = NULL;
+		}
 		res = add_priority(con, tmp, el, e, replace);
 		if (res < 0) {
 			if (con->pattern_tree) {
@@ -7572,6 +7783,7 @@ static int ast_add_extension2_lockopt(struct ast_context *con,
 		}
 		ast_hashtab_insert_safe(tmp->peer_table, tmp);
 		ast_hashtab_insert_safe(con->root_table, tmp);
+		con->ins_cache = tmp;
 
 		if (lock_context) {
 			ast_unlock_context(con);
@@ -34,6 +34,7 @@
 #include "asterisk/ast_expr.h"
 #include "asterisk/chanvars.h"
 #include "asterisk/cli.h"
+#include "asterisk/hashtab.h"
 #include "asterisk/linkedlists.h"
 #include "asterisk/lock.h"
 #include "asterisk/module.h"
@@ -108,6 +109,82 @@
 
 AST_RWLOCK_DEFINE_STATIC(globalslock);
 static struct varshead globals = AST_LIST_HEAD_NOLOCK_INIT_VALUE;
+/*!
+ * Name index over \ref globals so lookups do not have to walk the list.
+ * Holds the list entry currently visible for each name and is protected
+ * by \ref globalslock like the list itself.
+ */
+static struct ast_hashtab *globals_table;
+
+static int hashtab_compare_vars(const void *ah_a, const void *ah_b)
+{
+	const struct ast_var_t *var_a = ah_a;
+	const struct ast_var_t *var_b = ah_b;
+
+	return strcmp(ast_var_name(var_a), ast_var_name(var_b));
+}
+
+static unsigned int hashtab_hash_vars(const void *obj)
+{
+	const struct ast_var_t *var = obj;
+
+	return ast_hashtab_hash_string(ast_var_name(var));
+}
+
+/*! \brief Look up a global by name.  Must be called with globalslock held. */
+static struct ast_var_t *globals_lookup(const char *name)
+{
+	struct ast_var_t *pattern;
+
+	if (!globals_table) {
+		return NULL;
+	}
+	pattern = ast_alloca(sizeof(*pattern) + strlen(name) + 1);
+	strcpy(pattern->name, name); /* Safe */
+	return ast_hashtab_lookup(globals_table, pattern);
+}
+
+/*!
+ * \brief Index a global that was just inserted at the head of the list.
+ * Must be called with globalslock held for writing.
+ */
+static void globals_index_insert(struct ast_var_t *variable)
+{
+	if (!globals_table) {
+		globals_table = ast_hashtab_create(61, hashtab_compare_vars,
+			ast_hashtab_resize_java, ast_hashtab_newsize_java,
+			hashtab_hash_vars, 0);
+		if (!globals_table) {
+			return;
+		}
+	}
+	/* The new entry shadows any older one with the same name. */
+	ast_hashtab_remove_object_via_lookup(globals_table, variable);
+	ast_hashtab_insert_safe(globals_table, variable);
+}
+
+/*!
+ * \brief Unindex a global that was just removed from the list.
+ * Must be called with globalslock held for writing.
+ */
+static void globals_index_remove(struct ast_var_t *variable)
+{
+	struct ast_var_t *shadowed;
+
+	if (!globals_table) {
+		return;
+	}
+	ast_hashtab_remove_object_via_lookup(globals_table, variable);
+	/* pbx_builtin_pushvar_helper() may have stacked an older entry with
+	 * the same name; it becomes the visible one again now.
+	 */
+	AST_LIST_TRAVERSE(&globals, shadowed, entries) {
+		if (!strcmp(ast_var_name(shadowed), ast_var_name(variable))) {
+			ast_hashtab_insert_safe(globals_table, shadowed);
+			break;
+		}
+	}
+}
 
 /*!
  * \brief extract offset:length from variable name.
@@ -235,13 +312,13 @@ static const char *ast_str_substring(struct ast_str *value, int offset, int leng
  */
 void pbx_retrieve_variable(struct ast_channel *c, const char *var, char **ret, char *workspace, int workspacelen, struct varshead *headp)
 {
-	struct ast_str *str = ast_str_create(16);
+	struct ast_str *str = ast_str_scratch_get(16);
 	const char *cret;
 
 	cret = ast_str_retrieve_variable(&str, 0, c, headp, var);
 	ast_copy_string(workspace, ast_str_buffer(str), workspacelen);
 	*ret = cret ? workspace : NULL;
-	ast_free(str);
+	ast_str_scratch_release(&str);
 }
 
 const char *ast_str_retrieve_variable(struct ast_str **str, ssize_t maxlen, struct ast_channel *c, struct varshead *headp, const char *var)
@@ -362,16 +439,28 @@ const char *ast_str_retrieve_variable(struct ast_str **str, ssize_t maxlen, stru
 		struct ast_var_t *variables;
 		if (!places[i])
 			continue;
-		if (places[i] == &globals)
+		if (places[i] == &globals) {
 			ast_rwlock_rdlock(&globalslock);
+			if ((variables = globals_lookup(var))) {
+				s = ast_var_value(variables);
+			}
+			ast_rwlock_unlock(&globalslock);
+			continue;
+		}
+		if (i == 0 && c) {
+			/* The channel's own list is locked, so hot variables may
+			 * be promoted towards the front as they are read. */
+			if ((variables = ast_var_list_find(places[i], var))) {
+				s = ast_var_value(variables);
+			}
+			continue;
+		}
 		AST_LIST_TRAVERSE(places[i], variables, entries) {
 			if (!strcmp(ast_var_name(variables), var)) {
 				s = ast_var_value(variables);
 				break;
 			}
 		}
-		if (places[i] == &globals)
-			ast_rwlock_unlock(&globalslock);
 	}
 	if (s == &not_found || s == NULL) {
 		ast_debug(5, "Result of '%s' is NULL\n", var);
@@ -398,18 +487,35 @@ void ast_str_substitute_variables_full(struct ast_str **buf, ssize_t maxlen, str
 {
 	/* Substitutes variables into buf, based on string templ */
 	const char *whereweare;
-	struct ast_str *substr1 = ast_str_create(16);
+	struct ast_str *substr1;
 	struct ast_str *substr2 = NULL;
-	struct ast_str *substr3 = ast_str_create(16);
+	struct ast_str *substr3;
 
 	ast_str_reset(*buf);
 
+	/*
+	 * Most templates contain nothing to substitute, so don't pay for
+	 * the scratch buffers until a '$' has actually been seen.
+	 */
+	if (!templ || !strchr(templ, '$')) {
+		if (!ast_strlen_zero(templ)) {
+			ast_str_set(buf, maxlen, "%s", templ);
+		}
+		if (used) {
+			*used = ast_str_strlen(*buf);
+		}
+		return;
+	}
+
+	substr1 = ast_str_scratch_get(16);
+	substr3 = ast_str_scratch_get(16);
+
 	if (!substr1 || !substr3) {
 		if (used) {
 			*used = ast_str_strlen(*buf);
 		}
-		ast_free(substr1);
-		ast_free(substr3);
+		ast_str_scratch_release(&substr1);
+		ast_str_scratch_release(&substr3);
 		return;
 	}
 
@@ -506,7 +612,7 @@ void ast_str_substitute_variables_full(struct ast_str **buf, ssize_t maxlen, str
 			/* Substitute if necessary */
 			if (needsub) {
 				if (!substr2) {
-					substr2 = ast_str_create(16);
+					substr2 = ast_str_scratch_get(16);
 					if (!substr2) {
 						continue;
 					}
@@ -591,7 +697,7 @@ void ast_str_substitute_variables_full(struct ast_str **buf, ssize_t maxlen, str
 			/* Substitute if necessary */
 			if (needsub) {
 				if (!substr2) {
-					substr2 = ast_str_create(16);
+					substr2 = ast_str_scratch_get(16);
 					if (!substr2) {
 						continue;
 					}
@@ -611,9 +717,9 @@ void ast_str_substitute_variables_full(struct ast_str **buf, ssize_t maxlen, str
 	if (used) {
 		*used = ast_str_strlen(*buf);
 	}
-	ast_free(substr1);
-	ast_free(substr2);
-	ast_free(substr3);
+	ast_str_scratch_release(&substr1);
+	ast_str_scratch_release(&substr2);
+	ast_str_scratch_release(&substr3);
 }
 
 void ast_str_substitute_variables(struct ast_str **buf, ssize_t maxlen, struct ast_channel *chan, const char *templ)
@@ -640,6 +746,25 @@ void pbx_substitute_variables_helper_full_location(struct ast_channel *c, struct
 	char var[VAR_BUF_SIZE];
 
 	*cp2 = 0; /* just in case nothing ends up there */
+
+	/*
+	 * Most dialplan lines contain nothing to substitute; handle a
+	 * template without '$' as a single bounded copy.
+	 */
+	if (!ast_strlen_zero(cp1) && count && !strchr(cp1, '$')) {
+		int pos = strlen(cp1);
+
+		if (pos > count) {
+			pos = count;
+		}
+		memcpy(cp2, cp1, pos);
+		cp2[pos] = 0;
+		if (used) {
+			*used = pos;
+		}
+		return;
+	}
+
 	whereweare = cp1;
 	while (!ast_strlen_zero(whereweare) && count) {
 		char *nextvar = NULL;
@@ -695,7 +820,12 @@ void pbx_substitute_variables_helper_full_location(struct ast_channel *c, struct
 			int offset2;
 			int isfunction;
 			char *cp4 = NULL;
-			char workspace[VAR_BUF_SIZE] = "";
+			char workspace[VAR_BUF_SIZE];
+
+			/* Every consumer writes the workspace before reading it, so
+			 * terminating the first byte avoids zeroing the whole buffer
+			 * for each variable. */
+			workspace[0] = '\0';
 
 			/* We have a variable.  Find the start and end, and determine
 			   if we are going to have to recursively call ourselves on the
@@ -1081,16 +1211,19 @@ const char *pbx_builtin_getvar_helper(struct ast_channel *chan, const char *name
 	for (i = 0; i < 2; i++) {
 		if (!places[i])
 			continue;
-		if (places[i] == &globals)
+		if (places[i] == &globals) {
 			ast_rwlock_rdlock(&globalslock);
-		AST_LIST_TRAVERSE(places[i], variables, entries) {
-			if (!strcmp(name, ast_var_name(variables))) {
+			if ((variables = globals_lookup(name))) {
 				ret = ast_var_value(variables);
-				break;
 			}
-		}
-		if (places[i] == &globals)
 			ast_rwlock_unlock(&globalslock);
+		} else {
+			/* The channel is locked, so reads may promote hot
+			 * variables towards the front of the list. */
+			if ((variables = ast_var_list_find(places[i], name))) {
+				ret = ast_var_value(variables);
+			}
+		}
 		if (ret)
 			break;
 	}
@@ -1126,6 +1259,8 @@ void pbx_builtin_pushvar_helper(struct ast_channel *chan, const char *name, cons
 		if (headp == &globals)
 			ast_verb(2, "Setting global variable '%s' to '%s'\n", name, value);
 		AST_LIST_INSERT_HEAD(headp, newvariable, entries);
+		if (headp == &globals)
+			globals_index_insert(newvariable);
 	}
 
 	if (chan)
@@ -1167,6 +1302,9 @@ int pbx_builtin_setvar_helper(struct ast_channel *chan, const char *name, const
 		if (strcmp(ast_var_name(newvariable), nametail) == 0) {
 			/* there is already such a variable, delete it */
 			AST_LIST_REMOVE_CURRENT(entries);
+			if (headp == &globals) {
+				globals_index_remove(newvariable);
+			}
 			old_value_existed = !ast_strlen_zero(ast_var_value(newvariable));
 			ast_var_delete(newvariable);
 			break;
@@ -1179,6 +1317,9 @@ int pbx_builtin_setvar_helper(struct ast_channel *chan, const char *name, const
 			ast_verb(2, "Setting global variable '%s' to '%s'\n", name, value);
 		}
 		AST_LIST_INSERT_HEAD(headp, newvariable, entries);
+		if (headp == &globals) {
+			globals_index_insert(newvariable);
+		}
 		ast_channel_publish_varset(chan, name, value);
 	} else if (old_value_existed) {
 		/* We just deleted a non-empty dialplan variable. */
@@ -1259,6 +1400,10 @@ void pbx_builtin_clear_globals(void)
 	struct ast_var_t *vardata;
 
 	ast_rwlock_wrlock(&globalslock);
+	if (globals_table) {
+		ast_hashtab_destroy(globals_table, NULL);
+		globals_table = NULL;
+	}
 	while ((vardata = AST_LIST_REMOVE_HEAD(&globals, entries)))
 		ast_var_delete(vardata);
 	ast_rwlock_unlock(&globalslock);
@@ -74,6 +74,62 @@ static const struct ast_datastore_info pickup_active = {
 	.type = "pickup-active",
 };
 
+/*! Number of buckets for the pickup candidate index */
+#define PICKUP_CANDIDATE_BUCKETS 53
+
+/*!
+ * \brief Index of channel names currently in a pickup-able state.
+ *
+ * Group pickup used to walk every channel in the system testing group
+ * intersection.  The index instead follows channel state from stasis
+ * and remembers only channels whose state could make them a pickup
+ * target, so the search touches just those.  Membership is a superset
+ * of what ast_can_pickup() accepts; every hit is still confirmed under
+ * the channel lock.
+ */
+static struct ao2_container *pickup_candidates;
+
+/*! \brief Subscription feeding the pickup candidate index */
+static struct stasis_subscription *pickup_state_sub;
+
+/*!
+ * \internal
+ * \brief Determine if a channel state could make a channel a pickup target.
+ *
+ * Down is included because some devices give 183 session progress
+ * instead of 180 ringing.  See ast_can_pickup().
+ */
+static int pickup_state_eligible(enum ast_channel_state state)
+{
+	return state == AST_STATE_RINGING
+		|| state == AST_STATE_RING
+		|| state == AST_STATE_DOWN;
+}
+
+static void pickup_state_cb(void *data, struct stasis_subscription *sub, struct stasis_message *message)
+{
+	struct ast_channel_snapshot_update *update;
+
+	if (stasis_message_type(message) != ast_channel_snapshot_type()) {
+		return;
+	}
+	update = stasis_message_data(message);
+
+	/* A masquerade can rename the channel; drop the stale name. */
+	if (update->old_snapshot
+		&& strcmp(update->old_snapshot->base->name, update->new_snapshot->base->name)) {
+		ast_str_container_remove(pickup_candidates, update->old_snapshot->base->name);
+	}
+
+	if (pickup_state_eligible(update->new_snapshot->state)
+		&& !ast_test_flag(&update->new_snapshot->flags, AST_FLAG_DEAD)
+		&& !ast_test_flag(&update->new_snapshot->flags, AST_FLAG_ZOMBIE)) {
+		ast_str_container_add(pickup_candidates, update->new_snapshot->base->name);
+	} else {
+		ast_str_container_remove(pickup_candidates, update->new_snapshot->base->name);
+	}
+}
+
 int ast_can_pickup(struct ast_channel *chan)
 {
 	if (!ast_channel_pbx(chan) && !ast_channel_masq(chan) && !ast_test_flag(ast_channel_flags(chan), AST_FLAG_ZOMBIE)
@@ -141,7 +197,24 @@ struct ast_channel *ast_pickup_find_by_group(struct ast_channel *chan)
 	}
 
 	/* Find all candidate targets by group. */
-	ast_channel_callback(find_channel_by_group, chan, candidates, 0);
+	if (pickup_state_sub) {
+		struct ao2_iterator iter;
+		char *candidate_name;
+
+		iter = ao2_iterator_init(pickup_candidates, 0);
+		while ((candidate_name = ao2_iterator_next(&iter))) {
+			struct ast_channel *candidate = ast_channel_get_by_name(candidate_name);
+
+			if (candidate) {
+				find_channel_by_group(candidate, chan, candidates, 0);
+				ast_channel_unref(candidate);
+			}
+			ao2_ref(candidate_name, -1);
+		}
+		ao2_iterator_destroy(&iter);
+	} else {
+		ast_channel_callback(find_channel_by_group, chan, candidates, 0);
+	}
 
 	/* Find the oldest pickup target candidate */
 	target = NULL;
@@ -395,6 +468,9 @@ pickup_failed:
 static void pickup_shutdown(void)
 {
 	STASIS_MESSAGE_TYPE_CLEANUP(ast_call_pickup_type);
+	pickup_state_sub = stasis_unsubscribe_and_join(pickup_state_sub);
+	ao2_cleanup(pickup_candidates);
+	pickup_candidates = NULL;
 }
 
 int ast_pickup_init(void)
@@ -402,5 +478,19 @@ int ast_pickup_init(void)
 	STASIS_MESSAGE_TYPE_INIT(ast_call_pickup_type);
 	ast_register_cleanup(pickup_shutdown);
 
+	pickup_candidates = ast_str_container_alloc(PICKUP_CANDIDATE_BUCKETS);
+	if (!pickup_candidates) {
+		return -1;
+	}
+
+	pickup_state_sub = stasis_subscribe(ast_channel_topic_all(), pickup_state_cb, NULL);
+	if (!pickup_state_sub) {
+		/* Group pickup falls back to walking all channels. */
+		ast_log(LOG_WARNING, "Failed to subscribe to channel state; pickup will search all channels\n");
+	} else {
+		stasis_subscription_accept_message_type(pickup_state_sub, ast_channel_snapshot_type());
+		stasis_subscription_set_filter(pickup_state_sub, STASIS_SUBSCRIPTION_FILTER_SELECTIVE);
+	}
+
 	return 0;
 }
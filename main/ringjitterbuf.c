@@ -0,0 +1,399 @@
+/*
+ * Asterisk -- An open source telephony toolkit.
+ *
+ * See http://www.asterisk.org for more information about
+ * the Asterisk project. Please do not directly contact
+ * any of the maintainers of this project for assistance;
+ * the project provides a web site, mailing lists and IRC
+ * channels for your use.
+ *
+ * This program is free software, distributed under the terms of
+ * the GNU General Public License Version 2. See the LICENSE file
+ * at the top of the source tree.
+ */
+
+/*! \file
+ *
+ * \brief Ring buffer jitterbuffering algorithm.
+ *
+ * The timing model is the same constant-delay one used by fixedjitterbuf,
+ * but frames are stored in a sequence-number-indexed ring instead of a
+ * sorted doubly linked list.  An out-of-order arrival lands directly in
+ * its slot in O(1), where the list implementation walks backwards from the
+ * tail looking for the insertion point.
+ */
+
+/*** MODULEINFO
+	<support_level>core</support_level>
+ ***/
+
+#include "asterisk.h"
+
+#include <assert.h>
+
+#include "asterisk/utils.h"
+#include "ringjitterbuf.h"
+
+#define ASSERT(a) ast_assert(a)
+
+/*!
+ * Number of slots in the ring.  Must be a power of two.  At a minimum
+ * frame length of 2 ms this covers more than half a second of buffered
+ * audio, well beyond any sane jitterbuffer depth.
+ */
+#define RING_JB_CAPACITY 256
+
+/* defaults */
+#define RING_JB_SIZE_DEFAULT 200
+#define RING_JB_RESYNCH_THRESHOLD_DEFAULT 1000
+
+/*! \brief One slot of the ring */
+struct ring_jb_slot
+{
+	void *data;
+	long ts;
+	long ms;
+	long delivery;
+	int used;
+};
+
+/*! \brief private ring_jb structure */
+struct ring_jb
+{
+	struct ring_jb_slot slots[RING_JB_CAPACITY];
+	/*! Extended sequence number of the next frame to deliver */
+	long head_seq;
+	/*! Extended sequence number of the newest frame in the ring */
+	long tail_seq;
+	/*! Timestamp of the newest frame ever put, for resynch decisions */
+	long tail_ts;
+	/*! Length of the newest frame ever put, for resynch decisions */
+	long tail_ms;
+	/*! Number of frames currently stored */
+	int count;
+	/*! True when sequence numbers are synthesized from timestamps */
+	int seq_from_ts;
+	struct ring_jb_conf conf;
+	long rxcore;
+	long delay;
+	long next_delivery;
+	int force_resynch;
+};
+
+
+static int resynch_jb(struct ring_jb *jb, void *data, long ms, long ts, long now, int seqno);
+
+static size_t slot_index(long seq)
+{
+	return (size_t)((unsigned long) seq & (RING_JB_CAPACITY - 1));
+}
+
+/*!
+ * \brief Extend a 16 bit RTP sequence number into the ring's numbering space.
+ *
+ * The extension is anchored at the head of the ring so sequence wraparound
+ * keeps mapping arrivals onto monotonically growing values.
+ */
+static long extend_seq(const struct ring_jb *jb, int seqno)
+{
+	int diff = (seqno - (int)(jb->head_seq & 0xffff)) & 0xffff;
+
+	if (diff >= 0x8000) {
+		diff -= 0x10000;
+	}
+
+	return jb->head_seq + diff;
+}
+
+static long resolve_seq(const struct ring_jb *jb, long ms, long ts, int seqno)
+{
+	if (jb->seq_from_ts) {
+		/* The source provides no sequence numbers - derive one from the
+		 * timestamp, which grows by ms from frame to frame. */
+		return ts / (ms > 0 ? ms : 1);
+	}
+
+	if (seqno < 0) {
+		/* Sporadically missing sequence number; assume in-order arrival. */
+		return jb->tail_seq + 1;
+	}
+
+	return extend_seq(jb, seqno);
+}
+
+static void pop_slot(struct ring_jb *jb, long seq, struct ring_jb_frame *frame)
+{
+	struct ring_jb_slot *slot = &jb->slots[slot_index(seq)];
+
+	/* copy the destination */
+	frame->data = slot->data;
+	frame->ts = slot->ts;
+	frame->ms = slot->ms;
+	frame->delivery = slot->delivery;
+
+	/* update next */
+	jb->next_delivery = slot->delivery + slot->ms;
+
+	/* and release the slot */
+	slot->data = NULL;
+	slot->used = 0;
+	jb->count--;
+	jb->head_seq = seq + 1;
+}
+
+
+struct ring_jb *ring_jb_new(struct ring_jb_conf *conf)
+{
+	struct ring_jb *jb;
+
+	if (!(jb = ast_calloc(1, sizeof(*jb))))
+		return NULL;
+
+	/* First copy our config */
+	memcpy(&jb->conf, conf, sizeof(struct ring_jb_conf));
+
+	/* we don't need the passed config anymore - continue working with the saved one */
+	conf = &jb->conf;
+
+	/* validate the configuration */
+	if (conf->jbsize < 1)
+		conf->jbsize = RING_JB_SIZE_DEFAULT;
+
+	if (conf->resync_threshold < 1)
+		conf->resync_threshold = RING_JB_RESYNCH_THRESHOLD_DEFAULT;
+
+	/* Set the constant delay to the jitterbuf */
+	jb->delay = conf->jbsize;
+
+	return jb;
+}
+
+
+void ring_jb_destroy(struct ring_jb *jb)
+{
+	/* jitterbuf MUST be empty before it can be destroyed */
+	ASSERT(jb->count == 0);
+
+	ast_free(jb);
+}
+
+
+static int resynch_jb(struct ring_jb *jb, void *data, long ms, long ts, long now, int seqno)
+{
+	long diff, offset;
+	size_t i;
+
+	/* If jb is empty, just reinitialize the jb */
+	if (!jb->count) {
+		return ring_jb_put_first(jb, data, ms, ts, now, seqno);
+	}
+
+	/* Adjust all jb state just as the new frame is with delivery = the delivery of the last
+	   frame (e.g. this one with max delivery) + the length of the last frame. */
+
+	/* Get the diff in timestamps */
+	diff = ts - jb->tail_ts;
+
+	/* Ideally this should be just the length of the last frame. The deviation is the desired
+	   offset */
+	offset = diff - jb->tail_ms;
+
+	/* Do we really need to resynch, or this is just a frame for dropping? */
+	if (!jb->force_resynch && (offset < jb->conf.resync_threshold && offset > -jb->conf.resync_threshold))
+		return RING_JB_DROP;
+
+	/* Reset the force resynch flag */
+	jb->force_resynch = 0;
+
+	/* apply the offset to the jb state */
+	jb->rxcore -= offset;
+	jb->tail_ts += offset;
+	for (i = 0; i < RING_JB_CAPACITY; i++) {
+		if (jb->slots[i].used) {
+			jb->slots[i].ts += offset;
+		}
+	}
+
+	/* now ring_jb_put() should add the frame at a last position */
+	return ring_jb_put(jb, data, ms, ts, now, seqno);
+}
+
+
+void ring_jb_set_force_resynch(struct ring_jb *jb)
+{
+	jb->force_resynch = 1;
+}
+
+
+int ring_jb_put_first(struct ring_jb *jb, void *data, long ms, long ts, long now, int seqno)
+{
+	/* this is our first frame - set the base of the receivers time */
+	jb->rxcore = now - ts;
+
+	/* init next for a first time - it should be the time the first frame should be played */
+	jb->next_delivery = now + jb->delay;
+
+	/* decide where sequence numbers come from and anchor the ring on this frame */
+	jb->seq_from_ts = seqno < 0;
+	jb->head_seq = jb->seq_from_ts ? ts / (ms > 0 ? ms : 1) : seqno;
+
+	/* put the frame */
+	return ring_jb_put(jb, data, ms, ts, now, seqno);
+}
+
+int ring_jb_put(struct ring_jb *jb, void *data, long ms, long ts, long now, int seqno)
+{
+	struct ring_jb_slot *slot;
+	long delivery;
+	long seq;
+
+	/* debug check the validity of the input params */
+	ASSERT(data != NULL);
+	/* do not allow frames shorter than 2 ms */
+	ASSERT(ms >= 2);
+	ASSERT(ts >= 0);
+	ASSERT(now >= 0);
+
+	delivery = jb->rxcore + jb->delay + ts;
+
+	/* check if the new frame is not too late */
+	if (delivery < jb->next_delivery) {
+		/* should drop the frame, but let first resynch_jb() check if this is not a jump in ts, or
+		   the force resynch flag was not set. */
+		return resynch_jb(jb, data, ms, ts, now, seqno);
+	}
+
+	/* what if the delivery time is bigger than next + delay? Seems like a frame for the future.
+	   However, allow more resync_threshold ms in advance */
+	if (delivery > jb->next_delivery + jb->delay + jb->conf.resync_threshold) {
+		/* should drop the frame, but let first resynch_jb() check if this is not a jump in ts, or
+		   the force resynch flag was not set. */
+		return resynch_jb(jb, data, ms, ts, now, seqno);
+	}
+
+	seq = resolve_seq(jb, ms, ts, seqno);
+
+	if (!jb->count) {
+		/* The ring drained while the head kept advancing on interpolations;
+		   re-anchor it on this frame. */
+		jb->head_seq = seq;
+	}
+
+	if (seq < jb->head_seq || seq >= jb->head_seq + RING_JB_CAPACITY) {
+		/* Behind the playout point or beyond the ring - treat like any
+		   other unplaceable frame. */
+		return resynch_jb(jb, data, ms, ts, now, seqno);
+	}
+
+	slot = &jb->slots[slot_index(seq)];
+	if (slot->used) {
+		/* Duplicate sequence number. */
+		return resynch_jb(jb, data, ms, ts, now, seqno);
+	}
+
+	/* Reset the force resynch flag */
+	jb->force_resynch = 0;
+
+	/* and insert it right on place - O(1), no list walk */
+	slot->data = data;
+	slot->ts = ts;
+	slot->ms = ms;
+	slot->delivery = delivery;
+	slot->used = 1;
+	jb->count++;
+
+	if (jb->count == 1 || seq > jb->tail_seq) {
+		jb->tail_seq = seq;
+		jb->tail_ts = ts;
+		jb->tail_ms = ms;
+	}
+
+	return RING_JB_OK;
+}
+
+
+int ring_jb_get(struct ring_jb *jb, struct ring_jb_frame *frame, long now, long interpl)
+{
+	struct ring_jb_slot *slot;
+
+	ASSERT(now >= 0);
+	ASSERT(interpl >= 2);
+
+	if (now < jb->next_delivery) {
+		/* too early for the next frame */
+		return RING_JB_NOFRAME;
+	}
+
+	/* Is the jb empty? */
+	if (!jb->count) {
+		/* should interpolate a frame */
+		/* update next */
+		jb->next_delivery += interpl;
+
+		return RING_JB_INTERP;
+	}
+
+	slot = &jb->slots[slot_index(jb->head_seq)];
+	if (!slot->used) {
+		/* The head frame never arrived (lost or still in flight) - step
+		   over the gap and interpolate in its place */
+		jb->head_seq++;
+		jb->next_delivery += interpl;
+
+		return RING_JB_INTERP;
+	}
+
+	/* Isn't it too late for the first frame available in the jb? */
+	if (now > slot->delivery + slot->ms) {
+		/* yes - should drop this frame and update next to point the next frame (pop_slot() does it) */
+		pop_slot(jb, jb->head_seq, frame);
+
+		return RING_JB_DROP;
+	}
+
+	/* isn't it too early to play the first frame available? */
+	if (now < slot->delivery) {
+		/* yes - should interpolate one frame */
+		/* update next */
+		jb->next_delivery += interpl;
+
+		return RING_JB_INTERP;
+	}
+
+	/* we have a frame for playing now (pop_slot() updates next) */
+	pop_slot(jb, jb->head_seq, frame);
+
+	return RING_JB_OK;
+}
+
+
+long ring_jb_next(struct ring_jb *jb)
+{
+	return jb->next_delivery;
+}
+
+
+int ring_jb_remove(struct ring_jb *jb, struct ring_jb_frame *frameout)
+{
+	long seq;
+
+	if (!jb->count)
+		return RING_JB_NOFRAME;
+
+	/* find the first stored frame at or past the head; gaps are possible */
+	for (seq = jb->head_seq; seq < jb->head_seq + RING_JB_CAPACITY; seq++) {
+		if (jb->slots[slot_index(seq)].used) {
+			pop_slot(jb, seq, frameout);
+			return RING_JB_OK;
+		}
+	}
+
+	/* cannot happen while count is accurate */
+	ASSERT(0);
+	return RING_JB_NOFRAME;
+}
+
+int ring_jb_is_late(struct ring_jb *jb, long ts)
+{
+	return jb->rxcore + jb->delay + ts < jb->next_delivery;
+}
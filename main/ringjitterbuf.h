@@ -0,0 +1,93 @@
+/*
+ * Asterisk -- An open source telephony toolkit.
+ *
+ * See http://www.asterisk.org for more information about
+ * the Asterisk project. Please do not directly contact
+ * any of the maintainers of this project for assistance;
+ * the project provides a web site, mailing lists and IRC
+ * channels for your use.
+ *
+ * This program is free software, distributed under the terms of
+ * the GNU General Public License Version 2. See the LICENSE file
+ * at the top of the source tree.
+ */
+
+/*! \file
+ *
+ * \brief Ring buffer jitterbuffering algorithm.
+ *
+ * Keeps the constant-delay model of the "fixed" implementation but stores
+ * frames in a sequence-number-indexed ring instead of a sorted linked list,
+ * so out-of-order arrivals are placed in O(1).
+ */
+
+#ifndef _RINGJITTERBUF_H_
+#define _RINGJITTERBUF_H_
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+
+/* return codes */
+enum {
+	RING_JB_OK,
+	RING_JB_DROP,
+	RING_JB_INTERP,
+	RING_JB_NOFRAME
+};
+
+
+/* jb configuration properties */
+struct ring_jb_conf
+{
+	long jbsize;
+	long resync_threshold;
+};
+
+
+struct ring_jb_frame
+{
+	void *data;
+	long ts;
+	long ms;
+	long delivery;
+};
+
+
+struct ring_jb;
+
+
+/* jb interface */
+
+struct ring_jb *ring_jb_new(struct ring_jb_conf *conf);
+
+void ring_jb_destroy(struct ring_jb *jb);
+
+int ring_jb_put_first(struct ring_jb *jb, void *data, long ms, long ts, long now, int seqno);
+
+/*!
+ * \brief Insert a frame into the ring.
+ *
+ * \param seqno the RTP sequence number of the frame, or -1 when the source
+ *              provides none; a synthetic sequence is derived from the
+ *              timestamp in that case.
+ */
+int ring_jb_put(struct ring_jb *jb, void *data, long ms, long ts, long now, int seqno);
+
+int ring_jb_get(struct ring_jb *jb, struct ring_jb_frame *frame, long now, long interpl);
+
+long ring_jb_next(struct ring_jb *jb);
+
+int ring_jb_remove(struct ring_jb *jb, struct ring_jb_frame *frameout);
+
+void ring_jb_set_force_resynch(struct ring_jb *jb);
+
+/*! \brief Checks if the given time stamp is late */
+int ring_jb_is_late(struct ring_jb *jb, long ts);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif /* _RINGJITTERBUF_H_ */
@@ -2439,6 +2439,13 @@ int ast_rtp_instance_get_stats(struct ast_rtp_instance *instance, struct ast_rtp
 {
 	int res;
 
+	/* Prefer an engine provided lock-free snapshot so statistics polling
+	 * does not contend with the media path for the instance lock. */
+	if (instance->engine->get_stat_nolock
+		&& !instance->engine->get_stat_nolock(instance, stats, stat)) {
+		return 0;
+	}
+
 	if (instance->engine->get_stat) {
 		ao2_lock(instance);
 		res = instance->engine->get_stat(instance, stats, stat);
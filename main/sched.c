@@ -42,7 +42,8 @@
 #include "asterisk/channel.h"
 #include "asterisk/lock.h"
 #include "asterisk/utils.h"
-#include "asterisk/heap.h"
+#include "asterisk/linkedlists.h"
+#include "asterisk/dlinkedlists.h"
 #include "asterisk/threadstorage.h"
 
 /*!
@@ -55,6 +56,37 @@
  */
 #define SCHED_MAX_CACHE 128
 
+/*!
+ * \brief Hashed hierarchical timer wheel geometry.
+ *
+ * Scheduled entries live on doubly linked lists hanging off wheel
+ * slots.  Level 0 has one slot per millisecond tick; each higher
+ * level covers the span of the entire level below it per slot.  An
+ * entry is filed by how far in the future it expires, so insert and
+ * delete are O(1) regardless of how many timers are outstanding.
+ * When level 0 wraps, the next slot of the level above is cascaded
+ * down into the finer levels.  Entries beyond the coverage of the
+ * last level wait on an overflow list and are refiled when the top
+ * level wraps.
+ */
+#define WHEEL_L0_BITS 8
+#define WHEEL_L0_SLOTS (1 << WHEEL_L0_BITS)       /*!< 256 slots of 1ms each */
+#define WHEEL_LN_BITS 6
+#define WHEEL_LN_SLOTS (1 << WHEEL_LN_BITS)       /*!< 64 slots per upper level */
+#define WHEEL_LEVELS 4
+#define WHEEL_SLOT_COUNT (WHEEL_L0_SLOTS + (WHEEL_LEVELS - 1) * WHEEL_LN_SLOTS)
+
+/*! \brief Number of hash buckets used to find an entry by its sched ID. */
+#define ID_HASH_BUCKETS 256
+
+/*!
+ * \brief Number of execution statistic histogram buckets.
+ *
+ * Bucket N counts samples of up to 2^N milliseconds, so the histogram
+ * covers 1ms through 1 second with the last bucket as overflow.
+ */
+#define SCHED_STAT_BUCKETS 12
+
 AST_THREADSTORAGE(last_del_id);
 
 /*!
@@ -74,23 +106,25 @@ struct sched_id {
 };
 
 struct sched {
+	/*!
+	 * While scheduled this links the entry into its ID hash bucket;
+	 * while cached it links the entry into the context's cache.  The
+	 * two states are mutually exclusive so one linkage serves both.
+	 */
 	AST_LIST_ENTRY(sched) list;
+	/*! Linkage into the timer wheel slot (or overflow list) holding this entry */
+	AST_DLLIST_ENTRY(sched) wheel_list;
 	/*! The ID that has been popped off the scheduler context's queue */
 	struct sched_id *sched_id;
 	struct timeval when;          /*!< Absolute time event should take place */
-	/*!
-	 * \brief Tie breaker in case the when is the same for multiple entries.
-	 *
-	 * \note The oldest expiring entry in the scheduler heap goes first.
-	 * This is possible when multiple events are scheduled to expire at
-	 * the same time by internal coding.
-	 */
-	unsigned int tie_breaker;
+	/*! Absolute expiry time in wheel ticks (milliseconds) */
+	int64_t tick;
+	/*! Index of the wheel slot holding this entry, or -1 for the overflow list */
+	int wheel_slot;
 	int resched;                  /*!< When to reschedule */
 	int variable;                 /*!< Use return value from callback to reschedule */
 	const void *data;             /*!< Data */
 	ast_sched_cb callback;        /*!< Callback */
-	ssize_t __heap_index;
 	/*!
 	 * Used to synchronize between thread running a task and thread
 	 * attempting to delete a task
@@ -102,24 +136,60 @@ struct sched {
 	unsigned int rescheduled:1;
 };
 
+AST_DLLIST_HEAD_NOLOCK(sched_bucket, sched);
+
 struct sched_thread {
 	pthread_t thread;
 	ast_cond_t cond;
 	unsigned int stop:1;
 };
 
+/*!
+ * \brief Per-context callback execution statistics.
+ *
+ * Updated by ast_sched_runq() while holding the context lock.  The
+ * late-fire delta is how far past its scheduled expiry a callback
+ * actually started; a growing delta is an early warning that the
+ * context (or the machine) is overloaded.
+ */
+struct sched_stats {
+	/*! Number of callbacks executed */
+	unsigned int runcnt;
+	/*! Total callback execution time in microseconds */
+	int64_t total_cb_us;
+	/*! Longest single callback execution in microseconds */
+	int64_t max_cb_us;
+	/*! Total milliseconds callbacks started past their expiry */
+	int64_t total_late_ms;
+	/*! Largest single late-fire delta in milliseconds */
+	int64_t max_late_ms;
+	/*! Callback duration histogram (bucket N is <= 2^N ms) */
+	unsigned int cb_buckets[SCHED_STAT_BUCKETS];
+	/*! Late-fire delta histogram (bucket N is <= 2^N ms) */
+	unsigned int late_buckets[SCHED_STAT_BUCKETS];
+};
+
 struct ast_sched_context {
 	ast_mutex_t lock;
 	unsigned int eventcnt;                  /*!< Number of events processed */
 	unsigned int highwater;					/*!< highest count so far */
-	/*! Next tie breaker in case events expire at the same time. */
-	unsigned int tie_breaker;
-	struct ast_heap *sched_heap;
+	/*! Number of entries currently scheduled on the wheel */
+	unsigned int schedcnt;
+	/*! The wheel tick (millisecond) up to which all slots have been run */
+	int64_t cur_tick;
+	/*! Timer wheel slots; level 0 first, then the upper levels */
+	struct sched_bucket wheel[WHEEL_SLOT_COUNT];
+	/*! Entries expiring beyond the wheel's horizon */
+	struct sched_bucket overflow;
+	/*! Scheduled entries hashed by sched ID for O(1) lookup */
+	AST_LIST_HEAD_NOLOCK(, sched) id_hash[ID_HASH_BUCKETS];
 	struct sched_thread *sched_thread;
 	/*! The scheduled task that is currently executing */
 	struct sched *currently_executing;
 	/*! Valid while currently_executing is not NULL */
 	pthread_t executing_thread_id;
+	/*! Callback execution statistics */
+	struct sched_stats stats;
 
 #ifdef SCHED_MAX_CACHE
 	AST_LIST_HEAD_NOLOCK(, sched) schedc;   /*!< Cache of unused schedule structures and how many */
@@ -131,6 +201,121 @@ struct ast_sched_context {
 	int id_queue_size;
 };
 
+static int64_t sched_tvtotick(struct timeval tv)
+{
+	return tv.tv_sec * INT64_C(1000) + tv.tv_usec / 1000;
+}
+
+/*!
+ * \internal
+ * \brief Determine which wheel slot an entry expiring at the given tick belongs in.
+ *
+ * \retval slot index into con->wheel
+ * \retval -1 the tick is beyond the wheel's horizon (overflow list)
+ */
+static int wheel_slot_index(const struct ast_sched_context *con, int64_t tick)
+{
+	int64_t delta = tick - con->cur_tick;
+	int shift = WHEEL_L0_BITS;
+	int base = WHEEL_L0_SLOTS;
+	int level;
+
+	if (delta < 1) {
+		/* Already due (or overdue); file it in the slot about to run. */
+		return con->cur_tick & (WHEEL_L0_SLOTS - 1);
+	}
+	if (delta < ((int64_t) 1 << WHEEL_L0_BITS)) {
+		return tick & (WHEEL_L0_SLOTS - 1);
+	}
+	for (level = 1; level < WHEEL_LEVELS; level++) {
+		if (delta < ((int64_t) 1 << (shift + WHEEL_LN_BITS))) {
+			return base + ((tick >> shift) & (WHEEL_LN_SLOTS - 1));
+		}
+		shift += WHEEL_LN_BITS;
+		base += WHEEL_LN_SLOTS;
+	}
+
+	return -1;
+}
+
+static void wheel_enqueue(struct ast_sched_context *con, struct sched *s)
+{
+	s->wheel_slot = wheel_slot_index(con, s->tick);
+	if (s->wheel_slot < 0) {
+		AST_DLLIST_INSERT_TAIL(&con->overflow, s, wheel_list);
+	} else {
+		AST_DLLIST_INSERT_TAIL(&con->wheel[s->wheel_slot], s, wheel_list);
+	}
+}
+
+static void wheel_remove(struct ast_sched_context *con, struct sched *s)
+{
+	struct sched_bucket *bucket;
+
+	bucket = s->wheel_slot < 0 ? &con->overflow : &con->wheel[s->wheel_slot];
+	AST_DLLIST_REMOVE(bucket, s, wheel_list);
+}
+
+/*!
+ * \internal
+ * \brief Refile every entry in a bucket into the (now finer) wheel position.
+ *
+ * The entries are moved onto a private list first since an overflow
+ * entry that is still beyond the horizon gets filed right back onto
+ * the overflow list.
+ */
+static void wheel_cascade(struct ast_sched_context *con, struct sched_bucket *bucket)
+{
+	struct sched_bucket moving = AST_DLLIST_HEAD_NOLOCK_INIT_VALUE;
+	struct sched *s;
+
+	while ((s = AST_DLLIST_REMOVE_HEAD(bucket, wheel_list))) {
+		AST_DLLIST_INSERT_TAIL(&moving, s, wheel_list);
+	}
+	while ((s = AST_DLLIST_REMOVE_HEAD(&moving, wheel_list))) {
+		wheel_enqueue(con, s);
+	}
+}
+
+/*!
+ * \internal
+ * \brief Advance the wheel by one tick, cascading upper levels on wrap.
+ */
+static void wheel_advance(struct ast_sched_context *con)
+{
+	int shift = WHEEL_L0_BITS;
+	int base = WHEEL_L0_SLOTS;
+	int level;
+
+	con->cur_tick++;
+	if (con->cur_tick & (WHEEL_L0_SLOTS - 1)) {
+		return;
+	}
+
+	/* Level 0 wrapped: pull the upper level slot we just reached down
+	 * into the finer levels, and keep going up while each level wraps. */
+	for (level = 1; level < WHEEL_LEVELS; level++) {
+		int idx = (con->cur_tick >> shift) & (WHEEL_LN_SLOTS - 1);
+
+		wheel_cascade(con, &con->wheel[base + idx]);
+		if (idx) {
+			return;
+		}
+		shift += WHEEL_LN_BITS;
+		base += WHEEL_LN_SLOTS;
+	}
+	wheel_cascade(con, &con->overflow);
+}
+
+/*!
+ * \internal
+ * \brief Iterate the wheel slots and the overflow list as one sequence.
+ */
+static struct sched_bucket *wheel_bucket(struct ast_sched_context *con, int i)
+{
+	return i < WHEEL_SLOT_COUNT ? &con->wheel[i] : &con->overflow;
+}
+
 static void *sched_run(void *data)
 {
 	struct ast_sched_context *con = data;
@@ -222,19 +407,6 @@ int ast_sched_start_thread(struct ast_sched_context *con)
 	return 0;
 }
 
-static int sched_time_cmp(void *va, void *vb)
-{
-	struct sched *a = va;
-	struct sched *b = vb;
-	int cmp;
-
-	cmp = ast_tvcmp(b->when, a->when);
-	if (!cmp) {
-		cmp = b->tie_breaker - a->tie_breaker;
-	}
-	return cmp;
-}
-
 struct ast_sched_context *ast_sched_context_create(void)
 {
 	struct ast_sched_context *tmp;
@@ -245,15 +417,10 @@ struct ast_sched_context *ast_sched_context_create(void)
 
 	ast_mutex_init(&tmp->lock);
 	tmp->eventcnt = 1;
+	tmp->cur_tick = sched_tvtotick(ast_tvnow());
 
 	AST_LIST_HEAD_INIT_NOLOCK(&tmp->id_queue);
 
-	if (!(tmp->sched_heap = ast_heap_create(8, sched_time_cmp,
-			offsetof(struct sched, __heap_index)))) {
-		ast_sched_context_destroy(tmp);
-		return NULL;
-	}
-
 	return tmp;
 }
 
@@ -272,6 +439,7 @@ void ast_sched_context_destroy(struct ast_sched_context *con)
 {
 	struct sched *s;
 	struct sched_id *sid;
+	int i;
 
 	sched_thread_destroy(con);
 	con->sched_thread = NULL;
@@ -284,12 +452,10 @@ void ast_sched_context_destroy(struct ast_sched_context *con)
 	}
 #endif
 
-	if (con->sched_heap) {
-		while ((s = ast_heap_pop(con->sched_heap))) {
+	for (i = 0; i <= WHEEL_SLOT_COUNT; i++) {
+		while ((s = AST_DLLIST_REMOVE_HEAD(wheel_bucket(con, i), wheel_list))) {
 			sched_free(s);
 		}
-		ast_heap_destroy(con->sched_heap);
-		con->sched_heap = NULL;
 	}
 
 	while ((sid = AST_LIST_REMOVE_HEAD(&con->id_queue, list))) {
@@ -406,22 +572,40 @@ static struct sched *sched_alloc(struct ast_sched_context *con)
 	return tmp;
 }
 
+/*!
+ * \internal
+ * \brief Take a scheduled entry off the wheel and out of the ID hash.
+ */
+static void unschedule(struct ast_sched_context *con, struct sched *s)
+{
+	wheel_remove(con, s);
+	AST_LIST_REMOVE(&con->id_hash[s->sched_id->id % ID_HASH_BUCKETS], s, list);
+	con->schedcnt--;
+}
+
 void ast_sched_clean_by_callback(struct ast_sched_context *con, ast_sched_cb match, ast_sched_cb cleanup_cb)
 {
-	int i = 1;
+	int i;
 	struct sched *current;
 
 	ast_mutex_lock(&con->lock);
-	while ((current = ast_heap_peek(con->sched_heap, i))) {
-		if (current->callback != match) {
-			i++;
-			continue;
-		}
+	for (i = 0; i <= WHEEL_SLOT_COUNT; i++) {
+		struct sched_bucket *bucket = wheel_bucket(con, i);
 
-		ast_heap_remove(con->sched_heap, current);
+		AST_DLLIST_TRAVERSE_SAFE_BEGIN(bucket, current, wheel_list) {
+			if (current->callback != match) {
+				continue;
+			}
+
+			AST_DLLIST_REMOVE_CURRENT(wheel_list);
+			AST_LIST_REMOVE(&con->id_hash[current->sched_id->id % ID_HASH_BUCKETS],
+				current, list);
+			con->schedcnt--;
 
-		cleanup_cb(current->data);
-		sched_release(con, current);
+			cleanup_cb(current->data);
+			sched_release(con, current);
+		}
+		AST_DLLIST_TRAVERSE_SAFE_END;
 	}
 	ast_mutex_unlock(&con->lock);
 }
@@ -432,19 +616,59 @@ void ast_sched_clean_by_callback(struct ast_sched_context *con, ast_sched_cb mat
  */
 int ast_sched_wait(struct ast_sched_context *con)
 {
-	int ms;
-	struct sched *s;
+	int ms = -1;
+	int i;
 
 	DEBUG(ast_debug(1, "ast_sched_wait()\n"));
 
 	ast_mutex_lock(&con->lock);
-	if ((s = ast_heap_peek(con->sched_heap, 1))) {
-		ms = ast_tvdiff_ms(s->when, ast_tvnow());
-		if (ms < 0) {
+	if (con->schedcnt) {
+		int64_t now_tick = sched_tvtotick(ast_tvnow());
+		int64_t next_tick = -1;
+
+		/* Every level 0 resident expires within the current rotation,
+		 * so the first occupied slot at or after the wheel hand is the
+		 * next event. */
+		for (i = 0; i < WHEEL_L0_SLOTS; i++) {
+			int64_t tick = con->cur_tick + i;
+
+			if (!AST_DLLIST_EMPTY(&con->wheel[tick & (WHEEL_L0_SLOTS - 1)])) {
+				next_tick = tick;
+				break;
+			}
+		}
+		if (next_tick < 0) {
+			/* Nothing on level 0, so the next event is the soonest entry
+			 * waiting on the upper levels or the overflow list.  Those
+			 * buckets are not sorted, so walk their entries; a context
+			 * with an empty level 0 is idle and holds few of them.  The
+			 * wheel hand only advances when the runq processes events, so
+			 * reporting the true expiry keeps idle pollers asleep instead
+			 * of waking them once per rotation. */
+			for (i = WHEEL_L0_SLOTS; i <= WHEEL_SLOT_COUNT; i++) {
+				struct sched_bucket *bucket = wheel_bucket(con, i);
+				struct sched *entry;
+
+				AST_DLLIST_TRAVERSE(bucket, entry, wheel_list) {
+					if (next_tick < 0 || entry->tick < next_tick) {
+						next_tick = entry->tick;
+					}
+				}
+			}
+		}
+		if (next_tick < 0) {
+			/* Should not happen while schedcnt is nonzero, but never
+			 * report an infinite wait with entries outstanding. */
+			next_tick = (con->cur_tick | (WHEEL_L0_SLOTS - 1)) + 1;
+		}
+
+		if (next_tick <= now_tick) {
 			ms = 0;
+		} else if (next_tick - now_tick > INT_MAX) {
+			ms = INT_MAX;
+		} else {
+			ms = next_tick - now_tick;
 		}
-	} else {
-		ms = -1;
 	}
 	ast_mutex_unlock(&con->lock);
 
@@ -453,34 +677,21 @@ int ast_sched_wait(struct ast_sched_context *con)
 
 
 /*! \brief
- * Take a sched structure and put it in the
- * queue, such that the soonest event is
- * first in the list.
+ * Take a sched structure and file it on the timer wheel
+ * slot matching its expiry time.
  */
 static void schedule(struct ast_sched_context *con, struct sched *s)
 {
-	size_t size;
-
-	size = ast_heap_size(con->sched_heap);
+	con->schedcnt++;
 
-	/* Record the largest the scheduler heap became for reporting purposes. */
-	if (con->highwater <= size) {
-		con->highwater = size + 1;
-	}
-
-	/* Determine the tie breaker value for the new entry. */
-	if (size) {
-		++con->tie_breaker;
-	} else {
-		/*
-		 * Restart the sequence for the first entry to make integer
-		 * roll over more unlikely.
-		 */
-		con->tie_breaker = 0;
+	/* Record the largest the scheduler became for reporting purposes. */
+	if (con->highwater < con->schedcnt) {
+		con->highwater = con->schedcnt;
 	}
-	s->tie_breaker = con->tie_breaker;
 
-	ast_heap_push(con->sched_heap, s);
+	s->tick = sched_tvtotick(s->when);
+	wheel_enqueue(con, s);
+	AST_LIST_INSERT_HEAD(&con->id_hash[s->sched_id->id % ID_HASH_BUCKETS], s, list);
 }
 
 /*! \brief
@@ -571,13 +782,9 @@ int ast_sched_add(struct ast_sched_context *con, int when, ast_sched_cb callback
 
 static struct sched *sched_find(struct ast_sched_context *con, int id)
 {
-	int x;
-	size_t heap_size;
-
-	heap_size = ast_heap_size(con->sched_heap);
-	for (x = 1; x <= heap_size; x++) {
-		struct sched *cur = ast_heap_peek(con->sched_heap, x);
+	struct sched *cur;
 
+	AST_LIST_TRAVERSE(&con->id_hash[id % ID_HASH_BUCKETS], cur, list) {
 		if (cur->sched_id->id == id) {
 			return cur;
 		}
@@ -640,9 +847,7 @@ int ast_sched_del_nonrunning(struct ast_sched_context *con, int id)
 
 	s = sched_find(con, id);
 	if (s) {
-		if (!ast_heap_remove(con->sched_heap, s)) {
-			ast_log(LOG_WARNING,"sched entry %d not in the sched heap?\n", s->sched_id->id);
-		}
+		unschedule(con, s);
 		sched_release(con, s);
 	} else if (con->currently_executing && (id == con->currently_executing->sched_id->id)) {
 		if (con->executing_thread_id == pthread_self()) {
@@ -702,31 +907,119 @@ int ast_sched_del_nonrunning(struct ast_sched_context *con, int id)
 	return res;
 }
 
+/*!
+ * \internal
+ * \brief Histogram bucket for a millisecond sample. (bucket N is <= 2^N ms)
+ */
+static int sched_stat_bucket(int64_t ms)
+{
+	int idx;
+
+	for (idx = 0; idx < SCHED_STAT_BUCKETS - 1; ++idx) {
+		if (ms <= (INT64_C(1) << idx)) {
+			return idx;
+		}
+	}
+
+	return SCHED_STAT_BUCKETS - 1;
+}
+
+/*!
+ * \internal
+ * \brief Record one callback execution.  Called with the context locked.
+ */
+static void sched_stats_record(struct sched_stats *stats, int64_t cb_us, int64_t late_ms)
+{
+	if (late_ms < 0) {
+		/* Fired early (clock stepped back or sub-ms jitter); call it on time. */
+		late_ms = 0;
+	}
+
+	stats->runcnt++;
+	stats->total_cb_us += cb_us;
+	if (stats->max_cb_us < cb_us) {
+		stats->max_cb_us = cb_us;
+	}
+	stats->total_late_ms += late_ms;
+	if (stats->max_late_ms < late_ms) {
+		stats->max_late_ms = late_ms;
+	}
+	++stats->cb_buckets[sched_stat_bucket(cb_us / 1000)];
+	++stats->late_buckets[sched_stat_bucket(late_ms)];
+}
+
+/*!
+ * \internal
+ * \brief Millisecond upper bound holding the given percentile of a histogram.
+ */
+static int64_t sched_stat_pct(const unsigned int *buckets, unsigned int count, int pct, int64_t max_ms)
+{
+	uint64_t needed = ((uint64_t) count * pct + 99) / 100;
+	uint64_t cumulative = 0;
+	int idx;
+
+	for (idx = 0; idx < SCHED_STAT_BUCKETS - 1; ++idx) {
+		cumulative += buckets[idx];
+		if (needed <= cumulative) {
+			return INT64_C(1) << idx;
+		}
+	}
+
+	/* The percentile landed in the overflow bucket; all we know is
+	 * that it is no larger than the largest sample seen. */
+	return max_ms;
+}
+
+void ast_sched_exec_report(struct ast_sched_context *con, struct ast_str **buf)
+{
+	struct sched_stats stats;
+
+	ast_mutex_lock(&con->lock);
+	stats = con->stats;
+	ast_mutex_unlock(&con->lock);
+
+	ast_str_append(buf, 0, " Executed = %u\n", stats.runcnt);
+	if (!stats.runcnt) {
+		return;
+	}
+	ast_str_append(buf, 0,
+		" Callback (ms): avg %.3f, p50 <= %" PRId64 ", p99 <= %" PRId64 ", max %.3f\n",
+		stats.total_cb_us / 1000.0 / stats.runcnt,
+		sched_stat_pct(stats.cb_buckets, stats.runcnt, 50, stats.max_cb_us / 1000),
+		sched_stat_pct(stats.cb_buckets, stats.runcnt, 99, stats.max_cb_us / 1000),
+		stats.max_cb_us / 1000.0);
+	ast_str_append(buf, 0,
+		" Late fire (ms): avg %.3f, p50 <= %" PRId64 ", p99 <= %" PRId64 ", max %" PRId64 "\n",
+		(double) stats.total_late_ms / stats.runcnt,
+		sched_stat_pct(stats.late_buckets, stats.runcnt, 50, stats.max_late_ms),
+		sched_stat_pct(stats.late_buckets, stats.runcnt, 99, stats.max_late_ms),
+		stats.max_late_ms);
+}
+
 void ast_sched_report(struct ast_sched_context *con, struct ast_str **buf, struct ast_cb_names *cbnames)
 {
 	int i, x;
 	struct sched *cur;
 	int countlist[cbnames->numassocs + 1];
-	size_t heap_size;
 
 	memset(countlist, 0, sizeof(countlist));
-	ast_str_set(buf, 0, " Highwater = %u\n schedcnt = %zu\n", con->highwater, ast_heap_size(con->sched_heap));
+	ast_str_set(buf, 0, " Highwater = %u\n schedcnt = %u\n", con->highwater, con->schedcnt);
 
 	ast_mutex_lock(&con->lock);
 
-	heap_size = ast_heap_size(con->sched_heap);
-	for (x = 1; x <= heap_size; x++) {
-		cur = ast_heap_peek(con->sched_heap, x);
-		/* match the callback to the cblist */
-		for (i = 0; i < cbnames->numassocs; i++) {
-			if (cur->callback == cbnames->cblist[i]) {
-				break;
+	for (x = 0; x <= WHEEL_SLOT_COUNT; x++) {
+		AST_DLLIST_TRAVERSE(wheel_bucket(con, x), cur, wheel_list) {
+			/* match the callback to the cblist */
+			for (i = 0; i < cbnames->numassocs; i++) {
+				if (cur->callback == cbnames->cblist[i]) {
+					break;
+				}
+			}
+			if (i < cbnames->numassocs) {
+				countlist[i]++;
+			} else {
+				countlist[cbnames->numassocs]++;
 			}
-		}
-		if (i < cbnames->numassocs) {
-			countlist[i]++;
-		} else {
-			countlist[cbnames->numassocs]++;
 		}
 	}
 
@@ -737,6 +1030,8 @@ void ast_sched_report(struct ast_sched_context *con, struct ast_str **buf, struc
 	}
 
 	ast_str_append(buf, 0, "   <unknown> : %d\n", countlist[cbnames->numassocs]);
+
+	ast_sched_exec_report(con, buf);
 }
 
 /*! \brief Dump the contents of the scheduler to LOG_DEBUG */
@@ -745,7 +1040,6 @@ void ast_sched_dump(struct ast_sched_context *con)
 	struct sched *q;
 	struct timeval when;
 	int x;
-	size_t heap_size;
 
 	if (!DEBUG_ATLEAST(1)) {
 		return;
@@ -753,28 +1047,28 @@ void ast_sched_dump(struct ast_sched_context *con)
 
 	when = ast_tvnow();
 #ifdef SCHED_MAX_CACHE
-	ast_log(LOG_DEBUG, "Asterisk Schedule Dump (%zu in Q, %u Total, %u Cache, %u high-water)\n",
-		ast_heap_size(con->sched_heap), con->eventcnt - 1, con->schedccnt, con->highwater);
+	ast_log(LOG_DEBUG, "Asterisk Schedule Dump (%u in Q, %u Total, %u Cache, %u high-water)\n",
+		con->schedcnt, con->eventcnt - 1, con->schedccnt, con->highwater);
 #else
-	ast_log(LOG_DEBUG, "Asterisk Schedule Dump (%zu in Q, %u Total, %u high-water)\n",
-		ast_heap_size(con->sched_heap), con->eventcnt - 1, con->highwater);
+	ast_log(LOG_DEBUG, "Asterisk Schedule Dump (%u in Q, %u Total, %u high-water)\n",
+		con->schedcnt, con->eventcnt - 1, con->highwater);
 #endif
 
 	ast_log(LOG_DEBUG, "=============================================================\n");
 	ast_log(LOG_DEBUG, "|ID    Callback          Data              Time  (sec:ms)   |\n");
 	ast_log(LOG_DEBUG, "+-----+-----------------+-----------------+-----------------+\n");
 	ast_mutex_lock(&con->lock);
-	heap_size = ast_heap_size(con->sched_heap);
-	for (x = 1; x <= heap_size; x++) {
-		struct timeval delta;
-		q = ast_heap_peek(con->sched_heap, x);
-		delta = ast_tvsub(q->when, when);
-		ast_log(LOG_DEBUG, "|%.4d | %-15p | %-15p | %.6ld : %.6ld |\n",
-			q->sched_id->id,
-			q->callback,
-			q->data,
-			(long)delta.tv_sec,
-			(long int)delta.tv_usec);
+	for (x = 0; x <= WHEEL_SLOT_COUNT; x++) {
+		AST_DLLIST_TRAVERSE(wheel_bucket(con, x), q, wheel_list) {
+			struct timeval delta;
+			delta = ast_tvsub(q->when, when);
+			ast_log(LOG_DEBUG, "|%.4d | %-15p | %-15p | %.6ld : %.6ld |\n",
+				q->sched_id->id,
+				q->callback,
+				q->data,
+				(long)delta.tv_sec,
+				(long int)delta.tv_usec);
+		}
 	}
 	ast_mutex_unlock(&con->lock);
 	ast_log(LOG_DEBUG, "=============================================================\n");
@@ -786,7 +1080,7 @@ void ast_sched_dump(struct ast_sched_context *con)
 int ast_sched_runq(struct ast_sched_context *con)
 {
 	struct sched *current;
-	struct timeval when;
+	int64_t target_tick;
 	int numevents;
 	int res;
 
@@ -794,53 +1088,72 @@ int ast_sched_runq(struct ast_sched_context *con)
 
 	ast_mutex_lock(&con->lock);
 
-	when = ast_tvadd(ast_tvnow(), ast_tv(0, 1000));
-	for (numevents = 0; (current = ast_heap_peek(con->sched_heap, 1)); numevents++) {
-		/* schedule all events which are going to expire within 1ms.
-		 * We only care about millisecond accuracy anyway, so this will
-		 * help us get more than one event at one time if they are very
-		 * close together.
-		 */
-		if (ast_tvcmp(current->when, when) != -1) {
+	/* schedule all events which are going to expire within 1ms.
+	 * We only care about millisecond accuracy anyway, so this will
+	 * help us get more than one event at one time if they are very
+	 * close together.
+	 */
+	target_tick = sched_tvtotick(ast_tvadd(ast_tvnow(), ast_tv(0, 1000)));
+
+	numevents = 0;
+	while (con->cur_tick < target_tick) {
+		struct sched_bucket *slot;
+
+		if (!con->schedcnt) {
+			/* Nothing anywhere on the wheel; jump the hand forward
+			 * rather than sweeping empty slots. */
+			con->cur_tick = target_tick;
 			break;
 		}
 
-		current = ast_heap_pop(con->sched_heap);
+		slot = &con->wheel[con->cur_tick & (WHEEL_L0_SLOTS - 1)];
+		while ((current = AST_DLLIST_REMOVE_HEAD(slot, wheel_list))) {
+			struct timeval cb_start;
 
-		/*
-		 * At this point, the schedule queue is still intact.  We
-		 * have removed the first event and the rest is still there,
-		 * so it's permissible for the callback to add new events, but
-		 * trying to delete itself won't work because it isn't in
-		 * the schedule queue.  If that's what it wants to do, it
-		 * should return 0.
-		 */
+			AST_LIST_REMOVE(&con->id_hash[current->sched_id->id % ID_HASH_BUCKETS],
+				current, list);
+			con->schedcnt--;
+			numevents++;
 
-		con->currently_executing = current;
-		con->executing_thread_id = pthread_self();
-		ast_mutex_unlock(&con->lock);
-		res = current->callback(current->data);
-		ast_mutex_lock(&con->lock);
-		con->currently_executing = NULL;
-		ast_cond_signal(&current->cond);
-
-		if (current->deleted) {
 			/*
-			 * Another thread is waiting on this scheduled item.  That thread
-			 * will be responsible for it's destruction
+			 * At this point, the wheel is still intact.  We have removed
+			 * the entry and the rest is still there, so it's permissible
+			 * for the callback to add new events, but trying to delete
+			 * itself won't work because it isn't on the wheel.  If that's
+			 * what it wants to do, it should return 0.
 			 */
-			current->rescheduled = res ? 1 : 0;
-		} else if (res) {
-			/*
-			 * If they return non-zero, we should schedule them to be
-			 * run again.
-			 */
-			sched_settime(&current->when, current->variable ? res : current->resched);
-			schedule(con, current);
-		} else {
-			/* No longer needed, so release it */
-			sched_release(con, current);
+
+			con->currently_executing = current;
+			con->executing_thread_id = pthread_self();
+			ast_mutex_unlock(&con->lock);
+			cb_start = ast_tvnow();
+			res = current->callback(current->data);
+			ast_mutex_lock(&con->lock);
+			sched_stats_record(&con->stats, ast_tvdiff_us(ast_tvnow(), cb_start),
+				ast_tvdiff_ms(cb_start, current->when));
+			con->currently_executing = NULL;
+			ast_cond_signal(&current->cond);
+
+			if (current->deleted) {
+				/*
+				 * Another thread is waiting on this scheduled item.  That thread
+				 * will be responsible for it's destruction
+				 */
+				current->rescheduled = res ? 1 : 0;
+			} else if (res) {
+				/*
+				 * If they return non-zero, we should schedule them to be
+				 * run again.
+				 */
+				sched_settime(&current->when, current->variable ? res : current->resched);
+				schedule(con, current);
+			} else {
+				/* No longer needed, so release it */
+				sched_release(con, current);
+			}
 		}
+
+		wheel_advance(con);
 	}
 
 	ast_mutex_unlock(&con->lock);
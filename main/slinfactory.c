@@ -39,14 +39,12 @@
 void ast_slinfactory_init(struct ast_slinfactory *sf)
 {
 	memset(sf, 0, sizeof(*sf));
-	sf->offset = sf->hold;
 	sf->output_format = ao2_bump(ast_format_slin);
 }
 
 int ast_slinfactory_init_with_format(struct ast_slinfactory *sf, struct ast_format *slin_out)
 {
 	memset(sf, 0, sizeof(*sf));
-	sf->offset = sf->hold;
 	if (!ast_format_cache_is_slinear(slin_out)) {
 		return -1;
 	}
@@ -145,48 +143,31 @@ int ast_slinfactory_feed(struct ast_slinfactory *sf, struct ast_frame *f)
 int ast_slinfactory_read(struct ast_slinfactory *sf, short *buf, size_t samples)
 {
 	struct ast_frame *frame_ptr;
-	unsigned int sofar = 0, ineed, remain;
+	unsigned int sofar = 0, ineed, avail;
 	short *frame_data, *offset = buf;
 
 	while (sofar < samples) {
 		ineed = samples - sofar;
 
-		if (sf->holdlen) {
-			if (sf->holdlen <= ineed) {
-				memcpy(offset, sf->offset, sf->holdlen * sizeof(*offset));
-				sofar += sf->holdlen;
-				offset += sf->holdlen;
-				sf->holdlen = 0;
-				sf->offset = sf->hold;
+		if ((frame_ptr = AST_LIST_FIRST(&sf->queue))) {
+			frame_data = (short *) frame_ptr->data.ptr + sf->head_used;
+			avail = frame_ptr->samples - sf->head_used;
+
+			if (avail <= ineed) {
+				/* Consume the rest of the head frame */
+				memcpy(offset, frame_data, avail * sizeof(*offset));
+				sofar += avail;
+				offset += avail;
+				AST_LIST_REMOVE_HEAD(&sf->queue, frame_list);
+				sf->head_used = 0;
+				ast_frfree(frame_ptr);
 			} else {
-				remain = sf->holdlen - ineed;
-				memcpy(offset, sf->offset, ineed * sizeof(*offset));
-				sofar += ineed;
-				sf->offset += ineed;
-				sf->holdlen = remain;
-			}
-			continue;
-		}
-
-		if ((frame_ptr = AST_LIST_REMOVE_HEAD(&sf->queue, frame_list))) {
-			frame_data = frame_ptr->data.ptr;
-
-			if (frame_ptr->samples <= ineed) {
-				memcpy(offset, frame_data, frame_ptr->samples * sizeof(*offset));
-				sofar += frame_ptr->samples;
-				offset += frame_ptr->samples;
-			} else {
-				remain = frame_ptr->samples - ineed;
+				/* Take what we need and leave the head frame queued,
+				   avoiding a copy into a separate hold buffer */
 				memcpy(offset, frame_data, ineed * sizeof(*offset));
 				sofar += ineed;
-				frame_data += ineed;
-				if (remain > (AST_SLINFACTORY_MAX_HOLD - sf->holdlen)) {
-					remain = AST_SLINFACTORY_MAX_HOLD - sf->holdlen;
-				}
-				memcpy(sf->hold, frame_data, remain * sizeof(*offset));
-				sf->holdlen = remain;
+				sf->head_used += ineed;
 			}
-			ast_frfree(frame_ptr);
 		} else {
 			break;
 		}
@@ -213,8 +194,8 @@ void ast_slinfactory_flush(struct ast_slinfactory *sf)
 	while ((fr = AST_LIST_REMOVE_HEAD(&sf->queue, frame_list)))
 		ast_frfree(fr);
 
-	sf->size = sf->holdlen = 0;
-	sf->offset = sf->hold;
+	sf->size = 0;
+	sf->head_used = 0;
 
 	return;
 }
@@ -45,27 +45,41 @@ struct ast_smoother {
 	struct ast_format *format;
 	int flags;
 	float samplesperbyte;
-	unsigned int opt_needs_swap:1;
 	struct ast_frame f;
 	struct timeval delivery;
-	char data[SMOOTHER_SIZE];
-	char framedata[SMOOTHER_SIZE + AST_FRIENDLY_OFFSET];
+	/*!
+	 * Accumulation buffer.  The payload occupies [pos, pos + len) past the
+	 * reserved AST_FRIENDLY_OFFSET prefix; frames are emitted directly out
+	 * of this window instead of being copied to a staging buffer, with the
+	 * consumed region doubling as frame offset headroom.
+	 */
+	char data[AST_FRIENDLY_OFFSET + SMOOTHER_SIZE];
 	struct ast_frame *opt;
+	/*! Read cursor of the frame parked in \c opt */
+	int opt_pos;
+	int pos;
 	int len;
 };
 
 static int smoother_frame_feed(struct ast_smoother *s, struct ast_frame *f, int swap)
 {
+	char *base = s->data + AST_FRIENDLY_OFFSET;
+
 	if (s->flags & AST_SMOOTHER_FLAG_G729) {
 		if (s->len % 10) {
 			ast_log(LOG_NOTICE, "Dropping extra frame of G.729 since we already have a VAD frame at the end\n");
 			return 0;
 		}
 	}
+	if (s->pos && s->pos + s->len + f->datalen > SMOOTHER_SIZE) {
+		/* Reclaim the consumed front of the buffer */
+		memmove(base, base + s->pos, s->len);
+		s->pos = 0;
+	}
 	if (swap) {
-		ast_swapcopy_samples(s->data + s->len, f->data.ptr, f->samples);
+		ast_swapcopy_samples(base + s->pos + s->len, f->data.ptr, f->samples);
 	} else {
-		memcpy(s->data + s->len, f->data.ptr, f->datalen);
+		memcpy(base + s->pos + s->len, f->data.ptr, f->datalen);
 	}
 	/* If either side is empty, reset the delivery time */
 	if (!s->len || ast_tvzero(f->delivery) || ast_tvzero(s->delivery)) {	/* XXX really ? */
@@ -76,6 +90,46 @@ static int smoother_frame_feed(struct ast_smoother *s, struct ast_frame *f, int
 	return 0;
 }
 
+/*!
+ * \internal
+ * \brief Move what remains of a parked multi-frame into the buffer.
+ *
+ * Used when the zero-copy view mode has to give the parked frame back
+ * (new data arrived, a reconfigure happened, or only a partial frame of
+ * data remains) so that byte order is preserved.
+ */
+static void smoother_opt_flush(struct ast_smoother *s)
+{
+	struct ast_frame *opt = s->opt;
+	int rem;
+
+	if (!opt) {
+		return;
+	}
+
+	rem = opt->datalen - s->opt_pos;
+	if (rem > 0) {
+		char *base = s->data + AST_FRIENDLY_OFFSET;
+
+		if (s->pos && s->pos + s->len + rem > SMOOTHER_SIZE) {
+			memmove(base, base + s->pos, s->len);
+			s->pos = 0;
+		}
+		memcpy(base + s->pos + s->len, (char *) opt->data.ptr + s->opt_pos, rem);
+		if (!s->len) {
+			s->delivery = opt->delivery;
+			if (!ast_tvzero(s->delivery) && s->opt_pos) {
+				s->delivery = ast_tvadd(s->delivery, ast_samp2tv(
+					s->opt_pos * s->samplesperbyte,
+					ast_format_get_sample_rate(s->format)));
+			}
+		}
+		s->len += rem;
+	}
+	s->opt = NULL;
+	s->opt_pos = 0;
+}
+
 void ast_smoother_reset(struct ast_smoother *s, int bytes)
 {
 	ao2_cleanup(s->format);
@@ -101,8 +155,7 @@ void ast_smoother_reconfigure(struct ast_smoother *s, int bytes)
 	 * but it must now be put into the buffer so the data
 	 * can be extracted at the new size
 	 */
-	smoother_frame_feed(s, s->opt, s->opt_needs_swap);
-	s->opt = NULL;
+	smoother_opt_flush(s);
 }
 
 struct ast_smoother *ast_smoother_new(int size)
@@ -144,22 +197,26 @@ int __ast_smoother_feed(struct ast_smoother *s, struct ast_frame *f, int swap)
 			ast_format_get_name(s->format), ast_format_get_name(f->subclass.format));
 		return -1;
 	}
+	if (s->opt) {
+		/* A frame is still parked for zero-copy emission; bank what
+		   remains of it so the new data lands behind it in order */
+		smoother_opt_flush(s);
+	}
 	if (s->len + f->datalen > SMOOTHER_SIZE) {
 		ast_log(LOG_WARNING, "Out of smoother space\n");
 		return -1;
 	}
-	if (((f->datalen == s->size) ||
+	if (((f->datalen >= s->size) ||
 	     ((f->datalen < 10) && (s->flags & AST_SMOOTHER_FLAG_G729))) &&
-	    !s->opt &&
 	    !s->len &&
 	    (f->offset >= AST_MIN_OFFSET)) {
-		/* Optimize by sending the frame we just got
-		   on the next read, thus eliminating the douple
-		   copy */
+		/* Optimize by sending windows into the frame we just got on
+		   the following reads, thus eliminating the double copy.  The
+		   frame must remain valid until the smoother is drained. */
 		if (swap)
 			ast_swapcopy_samples(f->data.ptr, f->data.ptr, f->samples);
 		s->opt = f;
-		s->opt_needs_swap = swap ? 1 : 0;
+		s->opt_pos = 0;
 		return 0;
 	}
 
@@ -171,14 +228,43 @@ struct ast_frame *ast_smoother_read(struct ast_smoother *s)
 	struct ast_frame *opt;
 	int len;
 
-	/* IF we have an optimization frame, send it */
+	/* IF we have an optimization frame, send from it */
 	if (s->opt) {
+		int rem = s->opt->datalen - s->opt_pos;
+
 		if (s->opt->offset < AST_FRIENDLY_OFFSET)
 			ast_log(LOG_WARNING, "Returning a frame of inappropriate offset (%d).\n",
 							s->opt->offset);
-		opt = s->opt;
-		s->opt = NULL;
-		return opt;
+		if (!s->opt_pos && rem <= s->size) {
+			/* Exactly our size (or a G.729 VAD runt): hand the fed
+			   frame straight back */
+			opt = s->opt;
+			s->opt = NULL;
+			return opt;
+		}
+		if (rem >= s->size) {
+			/* Emit a window into the fed frame without copying */
+			s->f.frametype = AST_FRAME_VOICE;
+			s->f.subclass.format = s->format;
+			s->f.data.ptr = (char *) s->opt->data.ptr + s->opt_pos;
+			s->f.offset = s->opt->offset + s->opt_pos;
+			s->f.datalen = s->size;
+			s->f.samples = s->size * s->samplesperbyte;	/* XXX rounding */
+			s->f.delivery = s->opt->delivery;
+			if (!ast_tvzero(s->f.delivery) && s->opt_pos) {
+				s->f.delivery = ast_tvadd(s->f.delivery, ast_samp2tv(
+					s->opt_pos * s->samplesperbyte,
+					ast_format_get_sample_rate(s->format)));
+			}
+			s->opt_pos += s->size;
+			if (s->opt_pos == s->opt->datalen) {
+				s->opt = NULL;
+				s->opt_pos = 0;
+			}
+			return &s->f;
+		}
+		/* Less than a full frame left; bank it and fall through */
+		smoother_opt_flush(s);
 	}
 
 	/* Make sure we have enough data */
@@ -190,28 +276,29 @@ struct ast_frame *ast_smoother_read(struct ast_smoother *s)
 	len = s->size;
 	if (len > s->len)
 		len = s->len;
-	/* Make frame */
+	/* Make frame pointing straight into the buffer; the consumed region
+	   in front of the read cursor serves as the frame's offset headroom */
 	s->f.frametype = AST_FRAME_VOICE;
 	s->f.subclass.format = s->format;
-	s->f.data.ptr = s->framedata + AST_FRIENDLY_OFFSET;
-	s->f.offset = AST_FRIENDLY_OFFSET;
+	s->f.data.ptr = s->data + AST_FRIENDLY_OFFSET + s->pos;
+	s->f.offset = AST_FRIENDLY_OFFSET + s->pos;
 	s->f.datalen = len;
 	/* Samples will be improper given VAD, but with VAD the concept really doesn't even exist */
 	s->f.samples = len * s->samplesperbyte;	/* XXX rounding */
 	s->f.delivery = s->delivery;
-	/* Fill Data */
-	memcpy(s->f.data.ptr, s->data, len);
+	s->pos += len;
 	s->len -= len;
-	/* Move remaining data to the front if applicable */
 	if (s->len) {
 		/* In principle this should all be fine because if we are sending
 		   G.729 VAD, the next timestamp will take over anyway */
-		memmove(s->data, s->data + len, s->len);
 		if (!ast_tvzero(s->delivery)) {
 			/* If we have delivery time, increment it, otherwise, leave it at 0 */
 			s->delivery = ast_tvadd(s->delivery, ast_samp2tv(s->f.samples,
 				ast_format_get_sample_rate(s->format)));
 		}
+	} else {
+		/* Drained; rewind the cursor to reclaim the whole buffer */
+		s->pos = 0;
 	}
 	/* Return frame */
 	return &s->f;
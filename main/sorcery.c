@@ -199,6 +199,9 @@ struct sorcery_observer_invocation {
 
 	/*! \brief Pointer to the object */
 	void *object;
+
+	/*! \brief Fields which changed on update, if computed (update invocations only) */
+	struct ast_variable *changes;
 };
 
 /*! \brief Structure for registered object field */
@@ -1286,6 +1289,7 @@ static void sorcery_observer_invocation_destroy(void *obj)
 
 	ao2_cleanup(invocation->object_type);
 	ao2_cleanup(invocation->object);
+	ast_variables_destroy(invocation->changes);
 }
 
 /*! \brief Allocator function for observer invocation */
@@ -2108,9 +2112,13 @@ int ast_sorcery_create(const struct ast_sorcery *sorcery, void *object)
 static int sorcery_observer_notify_update(void *obj, void *arg, int flags)
 {
 	const struct ast_sorcery_object_type_observer *observer = obj;
+	struct sorcery_observer_invocation *invocation = arg;
 
 	if (observer->callbacks->updated) {
-		observer->callbacks->updated(arg);
+		observer->callbacks->updated(invocation->object);
+	}
+	if (observer->callbacks->updated_with_changes) {
+		observer->callbacks->updated_with_changes(invocation->object, invocation->changes);
 	}
 
 	return 0;
@@ -2121,12 +2129,20 @@ static int sorcery_observers_notify_update(void *data)
 {
 	struct sorcery_observer_invocation *invocation = data;
 
-	ao2_callback(invocation->object_type->observers, OBJ_NODATA, sorcery_observer_notify_update, invocation->object);
+	ao2_callback(invocation->object_type->observers, OBJ_NODATA, sorcery_observer_notify_update, invocation);
 	ao2_cleanup(invocation);
 
 	return 0;
 }
 
+/*! \brief Internal callback function for finding an observer which wants field-level change sets */
+static int sorcery_observer_wants_changes(void *obj, void *arg, int flags)
+{
+	const struct ast_sorcery_object_type_observer *observer = obj;
+
+	return observer->callbacks->updated_with_changes ? CMP_MATCH | CMP_STOP : 0;
+}
+
 /*! \brief Internal function which returns if a wizard has updated the object */
 static int sorcery_wizard_update(const struct ast_sorcery_object_wizard *object_wizard, const struct sorcery_details *details)
 {
@@ -2148,6 +2164,7 @@ int ast_sorcery_update(const struct ast_sorcery *sorcery, void *object)
 	RAII_VAR(struct ast_sorcery_object_type *, object_type, ao2_find(sorcery->types, details->object->type, OBJ_KEY), ao2_cleanup);
 	struct ast_sorcery_object_wizard *object_wizard = NULL;
 	struct ast_sorcery_object_wizard *found_wizard;
+	struct ast_variable *changes = NULL;
 	int i;
 	struct sorcery_details sdetails = {
 		.sorcery = sorcery,
@@ -2158,6 +2175,28 @@ int ast_sorcery_update(const struct ast_sorcery *sorcery, void *object)
 		return -1;
 	}
 
+	if (ao2_container_count(object_type->observers)) {
+		struct ast_sorcery_object_type_observer *wants_changes;
+
+		/* If an observer is interested in field-level change sets the previous
+		 * version of the object must be retrieved for comparison before any
+		 * wizard (in particular a caching one) has the new version applied.
+		 */
+		wants_changes = ao2_callback(object_type->observers, 0, sorcery_observer_wants_changes, NULL);
+		if (wants_changes) {
+			void *old_object = ast_sorcery_retrieve_by_id(sorcery, details->object->type,
+				ast_sorcery_object_get_id(object));
+
+			if (old_object) {
+				if (ast_sorcery_diff(sorcery, old_object, object, &changes)) {
+					changes = NULL;
+				}
+				ao2_ref(old_object, -1);
+			}
+			ao2_ref(wants_changes, -1);
+		}
+	}
+
 	AST_VECTOR_RW_RDLOCK(&object_type->wizards);
 	for (i = 0; i < AST_VECTOR_SIZE(&object_type->wizards); i++) {
 		found_wizard = AST_VECTOR_GET(&object_type->wizards, i);
@@ -2179,16 +2218,22 @@ int ast_sorcery_update(const struct ast_sorcery *sorcery, void *object)
 			struct sorcery_observer_invocation *invocation;
 
 			invocation = sorcery_observer_invocation_alloc(object_type, object);
-			if (invocation
-				&& ast_taskprocessor_push(object_type->serializer, sorcery_observers_notify_update,
-					invocation)) {
-				ao2_cleanup(invocation);
+			if (invocation) {
+				/* Ownership of the change set passes to the invocation */
+				invocation->changes = changes;
+				changes = NULL;
+				if (ast_taskprocessor_push(object_type->serializer,
+					sorcery_observers_notify_update, invocation)) {
+					ao2_cleanup(invocation);
+				}
 			}
 		}
 	}
 
 	AST_VECTOR_RW_UNLOCK(&object_type->wizards);
 
+	ast_variables_destroy(changes);
+
 	return object_wizard ? 0 : -1;
 }
 
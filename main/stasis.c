@@ -251,9 +251,10 @@
  * The destructors of both have assertions regarding this to catch ref-counting
  * problems where a subscription or topic has had an extra ao2_cleanup().
  *
- * The \ref dispatch_exec_sync object is a transient object, which is posted to
- * a subscription's taskprocessor to send a message to the subscriber. They have
- * short life cycles, allocated on one thread, destroyed on another.
+ * Messages for a subscriber are appended to its pending batch and handed to the
+ * subscription's taskprocessor by a single \ref dispatch_exec_batch task, which
+ * drains whatever accumulated while the mailbox was busy. The batch entries
+ * have short life cycles, queued on one thread, consumed on another.
  *
  * During shutdown, or the deletion of a domain object, there are a flurry of
  * ao2_cleanup()s on subscriptions and topics, as the final in-flight messages
@@ -679,6 +680,18 @@ struct stasis_subscription_statistics {
 #endif
 
 /*! \internal */
+struct sync_task_data;
+
+/*! \brief A message waiting in a subscription's pending batch. */
+struct pending_dispatch {
+	/*! Message to deliver (holds a reference). */
+	struct stasis_message *message;
+	/*! Non-NULL if a publisher is waiting on the delivery. */
+	struct sync_task_data *std;
+};
+
+AST_VECTOR(pending_dispatch_batch, struct pending_dispatch);
+
 struct stasis_subscription {
 	/*! Unique ID for this subscription */
 	char *uniqueid;
@@ -700,6 +713,13 @@ struct stasis_subscription {
 	 *  Be sure join_lock is held before reading/setting. */
 	int final_message_processed;
 
+	/*! Accepted messages not yet handed to the mailbox drain task.
+	 *  Protected by the subscription ao2 lock. */
+	struct pending_dispatch_batch pending;
+	/*! TRUE if a drain task is queued on the mailbox.
+	 *  Protected by the subscription ao2 lock. */
+	int batch_queued;
+
 	/*! The message types this subscription is accepting */
 	AST_VECTOR(, char) accepted_message_types;
 	/*! The message formatters this subscription is accepting */
@@ -734,6 +754,7 @@ static void subscription_dtor(void *obj)
 	sub->mailbox = NULL;
 	ast_cond_destroy(&sub->join_cond);
 
+	AST_VECTOR_FREE(&sub->pending);
 	AST_VECTOR_FREE(&sub->accepted_message_types);
 
 #ifdef AST_DEVMODE
@@ -927,6 +948,7 @@ struct stasis_subscription *internal_stasis_subscribe(
 	sub->data = data;
 	ast_cond_init(&sub->join_cond, NULL);
 	sub->filter = STASIS_SUBSCRIPTION_FILTER_NONE;
+	AST_VECTOR_INIT(&sub->pending, 0);
 	AST_VECTOR_INIT(&sub->accepted_message_types, 0);
 	sub->accepted_formatters = STASIS_SUBSCRIPTION_FORMATTER_NONE;
 
@@ -1254,50 +1276,124 @@ static int topic_remove_subscription(struct stasis_topic *topic, struct stasis_s
 }
 
 /*!
- * \internal \brief Dispatch a message to a subscriber asynchronously
- * \param local \ref ast_taskprocessor_local object
- * \return 0
- */
-static int dispatch_exec_async(struct ast_taskprocessor_local *local)
-{
-	struct stasis_subscription *sub = local->local_data;
-	struct stasis_message *message = local->data;
-
-	subscription_invoke(sub, message);
-	ao2_cleanup(message);
-
-	return 0;
-}
-
-/*!
- * \internal \brief Data passed to \ref dispatch_exec_sync to synchronize
- * a published message to a subscriber
+ * \internal \brief Data used to synchronize a published message to a
+ * subscriber with the waiting publisher
  */
 struct sync_task_data {
 	ast_mutex_t lock;
 	ast_cond_t cond;
 	int complete;
-	void *task_data;
 };
 
 /*!
- * \internal \brief Dispatch a message to a subscriber synchronously
+ * \internal \brief Mark a pending dispatch as delivered (or dropped) and
+ * wake the waiting publisher.
+ */
+static void pending_dispatch_complete(struct sync_task_data *std)
+{
+	ast_mutex_lock(&std->lock);
+	std->complete = 1;
+	ast_cond_signal(&std->cond);
+	ast_mutex_unlock(&std->lock);
+}
+
+/*!
+ * \internal \brief Deliver a subscription's pending message batch
+ *
+ * A single queued instance of this task drains however many messages
+ * publishers managed to accumulate while the mailbox was busy, rather
+ * than the mailbox running one task per message.
+ *
  * \param local \ref ast_taskprocessor_local object
  * \return 0
  */
-static int dispatch_exec_sync(struct ast_taskprocessor_local *local)
+static int dispatch_exec_batch(struct ast_taskprocessor_local *local)
 {
 	struct stasis_subscription *sub = local->local_data;
-	struct sync_task_data *std = local->data;
-	struct stasis_message *message = std->task_data;
 
-	subscription_invoke(sub, message);
-	ao2_cleanup(message);
+	for (;;) {
+		struct pending_dispatch_batch batch;
+		size_t i;
 
-	ast_mutex_lock(&std->lock);
-	std->complete = 1;
-	ast_cond_signal(&std->cond);
-	ast_mutex_unlock(&std->lock);
+		ao2_lock(sub);
+		if (!AST_VECTOR_SIZE(&sub->pending)) {
+			sub->batch_queued = 0;
+			ao2_unlock(sub);
+			break;
+		}
+		/* Steal the accumulated batch so delivery happens unlocked. */
+		batch = sub->pending;
+		AST_VECTOR_INIT(&sub->pending, 0);
+		ao2_unlock(sub);
+
+		for (i = 0; i < AST_VECTOR_SIZE(&batch); i++) {
+			struct pending_dispatch entry = AST_VECTOR_GET(&batch, i);
+
+			subscription_invoke(sub, entry.message);
+			ao2_cleanup(entry.message);
+			if (entry.std) {
+				pending_dispatch_complete(entry.std);
+			}
+		}
+		AST_VECTOR_FREE(&batch);
+	}
+
+	return 0;
+}
+
+/*!
+ * \internal \brief Queue a message on a subscription's pending batch
+ *
+ * Takes over the caller's message reference, including on failure.
+ * Queues a drain task on the mailbox if one is not already queued.
+ *
+ * \retval 0 on success
+ * \retval -1 if the message was dropped
+ */
+static int dispatch_enqueue(struct stasis_subscription *sub,
+	struct stasis_message *message, struct sync_task_data *std)
+{
+	struct pending_dispatch entry = { message, std };
+	int need_push = 0;
+	int res = 0;
+
+	ao2_lock(sub);
+	if (AST_VECTOR_APPEND(&sub->pending, entry)) {
+		res = -1;
+	} else if (!sub->batch_queued) {
+		sub->batch_queued = 1;
+		need_push = 1;
+	}
+	ao2_unlock(sub);
+
+	if (res) {
+		ao2_cleanup(message);
+		return -1;
+	}
+	if (need_push
+		&& ast_taskprocessor_push_local(sub->mailbox, dispatch_exec_batch, NULL)) {
+		struct pending_dispatch_batch dropped;
+		size_t i;
+
+		/* Nothing will drain the batch; drop it, waking any waiting
+		 * publishers so they do not block forever. */
+		ao2_lock(sub);
+		dropped = sub->pending;
+		AST_VECTOR_INIT(&sub->pending, 0);
+		sub->batch_queued = 0;
+		ao2_unlock(sub);
+
+		for (i = 0; i < AST_VECTOR_SIZE(&dropped); i++) {
+			struct pending_dispatch drop = AST_VECTOR_GET(&dropped, i);
+
+			ao2_cleanup(drop.message);
+			if (drop.std) {
+				pending_dispatch_complete(drop.std);
+			}
+		}
+		AST_VECTOR_FREE(&dropped);
+		return -1;
+	}
 
 	return 0;
 }
@@ -1381,15 +1477,14 @@ static unsigned int dispatch_message(struct stasis_subscription *sub,
 		return 1;
 	}
 
-	/* Bump the message for the taskprocessor push. This will get de-ref'd
-	 * by the task processor callback.
+	/* Bump the message for the pending batch. This will get de-ref'd
+	 * by the drain task.
 	 */
 	ao2_bump(message);
 	if (!synchronous) {
-		if (ast_taskprocessor_push_local(sub->mailbox, dispatch_exec_async, message)) {
-			/* Push failed; ugh. */
+		if (dispatch_enqueue(sub, message, NULL)) {
+			/* Enqueue failed; ugh. */
 			ast_log(LOG_ERROR, "Dropping async dispatch\n");
-			ao2_cleanup(message);
 			return 0;
 		}
 	} else {
@@ -1398,12 +1493,10 @@ static unsigned int dispatch_message(struct stasis_subscription *sub,
 		ast_mutex_init(&std.lock);
 		ast_cond_init(&std.cond, NULL);
 		std.complete = 0;
-		std.task_data = message;
 
-		if (ast_taskprocessor_push_local(sub->mailbox, dispatch_exec_sync, &std)) {
-			/* Push failed; ugh. */
+		if (dispatch_enqueue(sub, message, &std)) {
+			/* Enqueue failed; ugh. */
 			ast_log(LOG_ERROR, "Dropping sync dispatch\n");
-			ao2_cleanup(message);
 			ast_mutex_destroy(&std.lock);
 			ast_cond_destroy(&std.cond);
 			return 0;
@@ -1841,7 +1934,7 @@ struct stasis_topic_pool *stasis_topic_pool_create(struct stasis_topic *pooled_t
 		return NULL;
 	}
 
-	pool->pool_container = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0,
+	pool->pool_container = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0,
 		TOPIC_POOL_BUCKETS, topic_pool_entry_hash, NULL, topic_pool_entry_cmp);
 	if (!pool->pool_container) {
 		ao2_cleanup(pool);
@@ -3150,7 +3243,9 @@ int stasis_init(void)
 		return -1;
 	}
 
-	topic_all = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0, TOPIC_ALL_BUCKETS,
+	/* Topic lookups vastly outnumber creations; a rwlock lets them run
+	 * concurrently instead of serializing on a single mutex. */
+	topic_all = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0, TOPIC_ALL_BUCKETS,
 			topic_proxy_hash_fn, 0, topic_proxy_cmp_fn);
 	if (!topic_all) {
 		return -1;
@@ -3164,7 +3259,7 @@ int stasis_init(void)
 	/* Statistics information is stored separately so that we don't alter or interrupt the lifetime of the underlying
 	 * topic or subscripton.
 	 */
-	subscription_stats = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0, SUBSCRIPTION_STATISTICS_BUCKETS,
+	subscription_stats = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0, SUBSCRIPTION_STATISTICS_BUCKETS,
 		subscription_statistics_hash, 0, subscription_statistics_cmp);
 	if (!subscription_stats) {
 		return -1;
@@ -3172,7 +3267,7 @@ int stasis_init(void)
 	ao2_global_obj_replace_unref(subscription_statistics, subscription_stats);
 	ao2_cleanup(subscription_stats);
 
-	topic_stats = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0, TOPIC_STATISTICS_BUCKETS,
+	topic_stats = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0, TOPIC_STATISTICS_BUCKETS,
 		topic_statistics_hash, 0, topic_statistics_cmp);
 	if (!topic_stats) {
 		return -1;
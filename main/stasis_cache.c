@@ -36,18 +36,26 @@
 #include "asterisk/utils.h"
 #include "asterisk/vector.h"
 
+/*! Number of independently locked entry containers per cache.  Power of
+ *  two so the shard pick is a cheap mask. */
+#define NUM_CACHE_SHARDS 16
+
 #ifdef LOW_MEMORY
-#define NUM_CACHE_BUCKETS 17
+#define NUM_CACHE_BUCKETS 5
 #else
-#define NUM_CACHE_BUCKETS 563
+#define NUM_CACHE_BUCKETS 37
 #endif
 
 /*! \internal */
 struct stasis_cache {
-	struct ao2_container *entries;
+	/*! Entries sharded by entity-id hash so concurrent updates of
+	 *  unrelated entities do not contend on one container lock. */
+	struct ao2_container *shards[NUM_CACHE_SHARDS];
 	snapshot_get_id id_fn;
 	cache_aggregate_calc_fn aggregate_calc_fn;
 	cache_aggregate_publish_fn aggregate_publish_fn;
+	/*! Incremented whenever a snapshot is inserted, updated or removed. */
+	int generation;
 	int registered;
 };
 
@@ -326,9 +334,12 @@ static int cache_entry_cmp(void *obj, void *arg, int flags)
 static void cache_dtor(void *obj)
 {
 	struct stasis_cache *cache = obj;
+	size_t idx;
 
-	ao2_cleanup(cache->entries);
-	cache->entries = NULL;
+	for (idx = 0; idx < NUM_CACHE_SHARDS; ++idx) {
+		ao2_cleanup(cache->shards[idx]);
+		cache->shards[idx] = NULL;
+	}
 }
 
 struct stasis_cache *stasis_cache_create_full(snapshot_get_id id_fn,
@@ -336,6 +347,7 @@ struct stasis_cache *stasis_cache_create_full(snapshot_get_id id_fn,
 	cache_aggregate_publish_fn aggregate_publish_fn)
 {
 	struct stasis_cache *cache;
+	size_t idx;
 
 	cache = ao2_alloc_options(sizeof(*cache), cache_dtor,
 		AO2_ALLOC_OPT_LOCK_NOLOCK);
@@ -343,11 +355,13 @@ struct stasis_cache *stasis_cache_create_full(snapshot_get_id id_fn,
 		return NULL;
 	}
 
-	cache->entries = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0,
-		NUM_CACHE_BUCKETS, cache_entry_hash, NULL, cache_entry_cmp);
-	if (!cache->entries) {
-		ao2_cleanup(cache);
-		return NULL;
+	for (idx = 0; idx < NUM_CACHE_SHARDS; ++idx) {
+		cache->shards[idx] = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0,
+			NUM_CACHE_BUCKETS, cache_entry_hash, NULL, cache_entry_cmp);
+		if (!cache->shards[idx]) {
+			ao2_cleanup(cache);
+			return NULL;
+		}
 	}
 
 	cache->id_fn = id_fn;
@@ -410,6 +424,22 @@ static struct stasis_cache_entry *cache_find(struct ao2_container *entries, stru
 	return entry;
 }
 
+/*!
+ * \internal
+ * \brief Pick the shard holding entries for the given type and id.
+ */
+static struct ao2_container *cache_shard(struct stasis_cache *cache,
+	struct stasis_message_type *type, const char *id)
+{
+	struct cache_entry_key search_key;
+
+	search_key.type = type;
+	search_key.id = id;
+	cache_entry_compute_hash(&search_key);
+
+	return cache->shards[search_key.hash & (NUM_CACHE_SHARDS - 1)];
+}
+
 /*!
  * \internal
  * \brief Remove the stasis snapshot in the cache entry determined by eid.
@@ -508,23 +538,26 @@ static struct cache_put_snapshots cache_put(struct stasis_cache *cache,
 {
 	struct stasis_cache_entry *cached_entry;
 	struct cache_put_snapshots snapshots;
+	struct ao2_container *shard;
 
-	ast_assert(cache->entries != NULL);
+	ast_assert(cache->shards[0] != NULL);
 	ast_assert(eid != NULL);/* Aggregate snapshots not allowed to be put directly. */
 	ast_assert(new_snapshot == NULL ||
 		type == stasis_message_type(new_snapshot));
 
 	memset(&snapshots, 0, sizeof(snapshots));
 
-	ao2_wrlock(cache->entries);
+	shard = cache_shard(cache, type, id);
 
-	cached_entry = cache_find(cache->entries, type, id);
+	ao2_wrlock(shard);
+
+	cached_entry = cache_find(shard, type, id);
 
 	/* Update the eid snapshot. */
 	if (!new_snapshot) {
 		/* Remove snapshot from cache */
 		if (cached_entry) {
-			snapshots.old = cache_remove(cache->entries, cached_entry, eid);
+			snapshots.old = cache_remove(shard, cached_entry, eid);
 		}
 	} else if (cached_entry) {
 		/* Update snapshot in cache */
@@ -533,7 +566,7 @@ static struct cache_put_snapshots cache_put(struct stasis_cache *cache,
 		/* Insert into the cache */
 		cached_entry = cache_entry_create(type, id, new_snapshot);
 		if (cached_entry) {
-			ao2_link_flags(cache->entries, cached_entry, OBJ_NOLOCK);
+			ao2_link_flags(shard, cached_entry, OBJ_NOLOCK);
 		}
 	}
 
@@ -544,7 +577,9 @@ static struct cache_put_snapshots cache_put(struct stasis_cache *cache,
 		cached_entry->aggregate = ao2_bump(snapshots.aggregate_new);
 	}
 
-	ao2_unlock(cache->entries);
+	ao2_unlock(shard);
+
+	ast_atomic_fetchadd_int(&cache->generation, +1);
 
 	ao2_cleanup(cached_entry);
 	return snapshots;
@@ -588,9 +623,10 @@ struct ao2_container *stasis_cache_get_all(struct stasis_cache *cache, struct st
 {
 	struct stasis_cache_entry *cached_entry;
 	struct ao2_container *found;
+	struct ao2_container *shard;
 
 	ast_assert(cache != NULL);
-	ast_assert(cache->entries != NULL);
+	ast_assert(cache->shards[0] != NULL);
 	ast_assert(id != NULL);
 
 	if (!type) {
@@ -602,15 +638,17 @@ struct ao2_container *stasis_cache_get_all(struct stasis_cache *cache, struct st
 		return NULL;
 	}
 
-	ao2_rdlock(cache->entries);
+	shard = cache_shard(cache, type, id);
+
+	ao2_rdlock(shard);
 
-	cached_entry = cache_find(cache->entries, type, id);
+	cached_entry = cache_find(shard, type, id);
 	if (cached_entry && cache_entry_dump(found, cached_entry)) {
 		ao2_cleanup(found);
 		found = NULL;
 	}
 
-	ao2_unlock(cache->entries);
+	ao2_unlock(shard);
 
 	ao2_cleanup(cached_entry);
 	return found;
@@ -660,24 +698,27 @@ struct stasis_message *stasis_cache_get_by_eid(struct stasis_cache *cache, struc
 {
 	struct stasis_cache_entry *cached_entry;
 	struct stasis_message *snapshot = NULL;
+	struct ao2_container *shard;
 
 	ast_assert(cache != NULL);
-	ast_assert(cache->entries != NULL);
+	ast_assert(cache->shards[0] != NULL);
 	ast_assert(id != NULL);
 
 	if (!type) {
 		return NULL;
 	}
 
-	ao2_rdlock(cache->entries);
+	shard = cache_shard(cache, type, id);
 
-	cached_entry = cache_find(cache->entries, type, id);
+	ao2_rdlock(shard);
+
+	cached_entry = cache_find(shard, type, id);
 	if (cached_entry) {
 		snapshot = cache_entry_by_eid(cached_entry, eid);
 		ao2_bump(snapshot);
 	}
 
-	ao2_unlock(cache->entries);
+	ao2_unlock(shard);
 
 	ao2_cleanup(cached_entry);
 	return snapshot;
@@ -688,6 +729,14 @@ struct stasis_message *stasis_cache_get(struct stasis_cache *cache, struct stasi
 	return stasis_cache_get_by_eid(cache, type, id, &ast_eid_default);
 }
 
+int stasis_cache_generation(struct stasis_cache *cache)
+{
+	ast_assert(cache != NULL);
+
+	/* Adding zero gives us an atomic read of the counter. */
+	return ast_atomic_fetchadd_int(&cache->generation, 0);
+}
+
 struct cache_dump_data {
 	struct ao2_container *container;
 	struct stasis_message_type *type;
@@ -718,9 +767,10 @@ static int cache_dump_by_eid_cb(void *obj, void *arg, int flags)
 struct ao2_container *stasis_cache_dump_by_eid(struct stasis_cache *cache, struct stasis_message_type *type, const struct ast_eid *eid)
 {
 	struct cache_dump_data cache_dump;
+	size_t idx;
 
 	ast_assert(cache != NULL);
-	ast_assert(cache->entries != NULL);
+	ast_assert(cache->shards[0] != NULL);
 
 	cache_dump.eid = eid;
 	cache_dump.type = type;
@@ -729,7 +779,9 @@ struct ao2_container *stasis_cache_dump_by_eid(struct stasis_cache *cache, struc
 		return NULL;
 	}
 
-	ao2_callback(cache->entries, OBJ_MULTIPLE | OBJ_NODATA, cache_dump_by_eid_cb, &cache_dump);
+	for (idx = 0; idx < NUM_CACHE_SHARDS; ++idx) {
+		ao2_callback(cache->shards[idx], OBJ_MULTIPLE | OBJ_NODATA, cache_dump_by_eid_cb, &cache_dump);
+	}
 	return cache_dump.container;
 }
 
@@ -757,9 +809,10 @@ static int cache_dump_all_cb(void *obj, void *arg, int flags)
 struct ao2_container *stasis_cache_dump_all(struct stasis_cache *cache, struct stasis_message_type *type)
 {
 	struct cache_dump_data cache_dump;
+	size_t idx;
 
 	ast_assert(cache != NULL);
-	ast_assert(cache->entries != NULL);
+	ast_assert(cache->shards[0] != NULL);
 
 	cache_dump.eid = NULL;
 	cache_dump.type = type;
@@ -768,7 +821,9 @@ struct ao2_container *stasis_cache_dump_all(struct stasis_cache *cache, struct s
 		return NULL;
 	}
 
-	ao2_callback(cache->entries, OBJ_MULTIPLE | OBJ_NODATA, cache_dump_all_cb, &cache_dump);
+	for (idx = 0; idx < NUM_CACHE_SHARDS; ++idx) {
+		ao2_callback(cache->shards[idx], OBJ_MULTIPLE | OBJ_NODATA, cache_dump_all_cb, &cache_dump);
+	}
 	return cache_dump.container;
 }
 
@@ -864,14 +919,17 @@ static void caching_topic_exec(void *data, struct stasis_subscription *sub,
 		 */
 		if (strcmp(change->description, "Unsubscribe") == 0) {
 			struct stasis_cache_entry *cached_sub;
+			struct ao2_container *shard;
 
-			ao2_wrlock(caching_topic->cache->entries);
-			cached_sub = cache_find(caching_topic->cache->entries, stasis_subscription_change_type(), change->uniqueid);
+			shard = cache_shard(caching_topic->cache, stasis_subscription_change_type(), change->uniqueid);
+			ao2_wrlock(shard);
+			cached_sub = cache_find(shard, stasis_subscription_change_type(), change->uniqueid);
 			if (cached_sub) {
-				ao2_cleanup(cache_remove(caching_topic->cache->entries, cached_sub, stasis_message_eid(message)));
+				ao2_cleanup(cache_remove(shard, cached_sub, stasis_message_eid(message)));
 				ao2_cleanup(cached_sub);
 			}
-			ao2_unlock(caching_topic->cache->entries);
+			ao2_unlock(shard);
+			ast_atomic_fetchadd_int(&caching_topic->cache->generation, +1);
 			ao2_cleanup(caching_topic_needs_unref);
 			return;
 		}
@@ -976,11 +1034,20 @@ struct stasis_caching_topic *stasis_caching_topic_create(struct stasis_topic *or
 	ao2_ref(cache, +1);
 	caching_topic->cache = cache;
 	if (!cache->registered) {
-		if (ao2_container_register(new_name, cache->entries, print_cache_entry)) {
-			ast_log(LOG_ERROR, "Stasis cache container '%p' for '%s' did not register\n",
-				cache->entries, new_name);
-		} else {
-			cache->registered = 1;
+		size_t idx;
+
+		cache->registered = 1;
+		for (idx = 0; idx < NUM_CACHE_SHARDS; ++idx) {
+			char *shard_name;
+
+			if (ast_asprintf(&shard_name, "%s/%02zu", new_name, idx) < 0) {
+				break;
+			}
+			if (ao2_container_register(shard_name, cache->shards[idx], print_cache_entry)) {
+				ast_log(LOG_ERROR, "Stasis cache container '%p' for '%s' did not register\n",
+					cache->shards[idx], shard_name);
+			}
+			ast_free(shard_name);
 		}
 	}
 	ast_free(new_name);
@@ -120,6 +120,9 @@ static struct stasis_topic *channel_topic_all;
 static struct ao2_container *channel_cache;
 static struct ao2_container *channel_cache_by_name;
 
+/*! Bumped on every channel cache mutation so pollers can detect change. */
+static int channel_cache_generation;
+
 struct ao2_container *ast_channel_cache_all(void)
 {
 	return ao2_bump(channel_cache);
@@ -135,6 +138,11 @@ struct ao2_container *ast_channel_cache_by_name(void)
 	return ao2_bump(channel_cache_by_name);
 }
 
+int ast_channel_cache_generation(void)
+{
+	return ast_atomic_fetchadd_int(&channel_cache_generation, 0);
+}
+
 /*!
  * \internal
  * \brief Hash function for \ref ast_channel_snapshot objects
@@ -267,8 +275,10 @@ static struct ast_channel_snapshot_base *channel_snapshot_base_create(struct ast
 {
 	struct ast_channel_snapshot_base *snapshot;
 
+	/* Snapshots and their segments are regenerated on every publish and
+	 * are never locked or weak-proxied, so they all use compact headers. */
 	snapshot = ao2_alloc_options(sizeof(*snapshot), channel_snapshot_base_dtor,
-		AO2_ALLOC_OPT_LOCK_NOLOCK);
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT);
 	if (!snapshot) {
 		return NULL;
 	}
@@ -303,7 +313,8 @@ static struct ast_channel_snapshot_peer *channel_snapshot_peer_create(struct ast
 	size_t peeraccount_len = strlen(peeraccount) + 1;
 	struct ast_channel_snapshot_peer *snapshot;
 
-	snapshot = ao2_alloc_options(sizeof(*snapshot) + linkedid_len + peeraccount_len, NULL, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	snapshot = ao2_alloc_options(sizeof(*snapshot) + linkedid_len + peeraccount_len, NULL,
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT);
 	if (!snapshot) {
 		return NULL;
 	}
@@ -315,44 +326,46 @@ static struct ast_channel_snapshot_peer *channel_snapshot_peer_create(struct ast
 	return snapshot;
 }
 
-static void channel_snapshot_caller_dtor(void *obj)
-{
-	struct ast_channel_snapshot_caller *snapshot = obj;
-
-	ast_string_field_free_memory(snapshot);
-}
-
 static struct ast_channel_snapshot_caller *channel_snapshot_caller_create(struct ast_channel *chan)
 {
+	const char *name = S_COR(ast_channel_caller(chan)->id.name.valid, ast_channel_caller(chan)->id.name.str, "");
+	const char *number = S_COR(ast_channel_caller(chan)->id.number.valid, ast_channel_caller(chan)->id.number.str, "");
+	const char *subaddr = S_COR(ast_channel_caller(chan)->id.subaddress.valid, ast_channel_caller(chan)->id.subaddress.str, "");
+	const char *ani = S_COR(ast_channel_caller(chan)->ani.number.valid, ast_channel_caller(chan)->ani.number.str, "");
+	const char *rdnis = S_COR(ast_channel_redirecting(chan)->from.number.valid, ast_channel_redirecting(chan)->from.number.str, "");
+	const char *dnid = S_OR(ast_channel_dialed(chan)->number.str, "");
+	const char *dialed_subaddr = S_COR(ast_channel_dialed(chan)->subaddress.valid, ast_channel_dialed(chan)->subaddress.str, "");
+	size_t name_len = strlen(name) + 1;
+	size_t number_len = strlen(number) + 1;
+	size_t subaddr_len = strlen(subaddr) + 1;
+	size_t ani_len = strlen(ani) + 1;
+	size_t rdnis_len = strlen(rdnis) + 1;
+	size_t dnid_len = strlen(dnid) + 1;
+	size_t dialed_subaddr_len = strlen(dialed_subaddr) + 1;
 	struct ast_channel_snapshot_caller *snapshot;
 
-	snapshot = ao2_alloc_options(sizeof(*snapshot), channel_snapshot_caller_dtor,
-		AO2_ALLOC_OPT_LOCK_NOLOCK);
+	/* This segment is regenerated on every snapshot, so it is packed
+	 * into a single allocation like the peer and connected segments. */
+	snapshot = ao2_alloc_options(sizeof(*snapshot) + name_len + number_len + subaddr_len
+		+ ani_len + rdnis_len + dnid_len + dialed_subaddr_len, NULL,
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT);
 	if (!snapshot) {
 		return NULL;
 	}
 
-	if (ast_string_field_init(snapshot, 256)) {
-		ao2_ref(snapshot, -1);
-		return NULL;
-	}
-
-	ast_string_field_set(snapshot, name,
-		S_COR(ast_channel_caller(chan)->id.name.valid, ast_channel_caller(chan)->id.name.str, ""));
-	ast_string_field_set(snapshot, number,
-		S_COR(ast_channel_caller(chan)->id.number.valid, ast_channel_caller(chan)->id.number.str, ""));
-	ast_string_field_set(snapshot, subaddr,
-		S_COR(ast_channel_caller(chan)->id.subaddress.valid, ast_channel_caller(chan)->id.subaddress.str, ""));
-	ast_string_field_set(snapshot, ani,
-		S_COR(ast_channel_caller(chan)->ani.number.valid, ast_channel_caller(chan)->ani.number.str, ""));
-
-	ast_string_field_set(snapshot, rdnis,
-		S_COR(ast_channel_redirecting(chan)->from.number.valid, ast_channel_redirecting(chan)->from.number.str, ""));
-
-	ast_string_field_set(snapshot, dnid,
-		S_OR(ast_channel_dialed(chan)->number.str, ""));
-	ast_string_field_set(snapshot, dialed_subaddr,
-		S_COR(ast_channel_dialed(chan)->subaddress.valid, ast_channel_dialed(chan)->subaddress.str, ""));
+	strcpy(snapshot->name, name); /* Safe */
+	snapshot->number = snapshot->name + name_len;
+	ast_copy_string(snapshot->number, number, number_len); /* Safe */
+	snapshot->subaddr = snapshot->number + number_len;
+	ast_copy_string(snapshot->subaddr, subaddr, subaddr_len); /* Safe */
+	snapshot->ani = snapshot->subaddr + subaddr_len;
+	ast_copy_string(snapshot->ani, ani, ani_len); /* Safe */
+	snapshot->rdnis = snapshot->ani + ani_len;
+	ast_copy_string(snapshot->rdnis, rdnis, rdnis_len); /* Safe */
+	snapshot->dnid = snapshot->rdnis + rdnis_len;
+	ast_copy_string(snapshot->dnid, dnid, dnid_len); /* Safe */
+	snapshot->dialed_subaddr = snapshot->dnid + dnid_len;
+	ast_copy_string(snapshot->dialed_subaddr, dialed_subaddr, dialed_subaddr_len); /* Safe */
 
 	snapshot->pres = ast_party_id_presentation(&ast_channel_caller(chan)->id);
 
@@ -367,7 +380,8 @@ static struct ast_channel_snapshot_connected *channel_snapshot_connected_create(
 	size_t number_len = strlen(number) + 1;
 	struct ast_channel_snapshot_connected *snapshot;
 
-	snapshot = ao2_alloc_options(sizeof(*snapshot) + name_len + number_len, NULL, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	snapshot = ao2_alloc_options(sizeof(*snapshot) + name_len + number_len, NULL,
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT);
 	if (!snapshot) {
 		return NULL;
 	}
@@ -391,7 +405,8 @@ static struct ast_channel_snapshot_bridge *channel_snapshot_bridge_create(struct
 	}
 	ao2_cleanup(bridge);
 
-	snapshot = ao2_alloc_options(sizeof(*snapshot) + strlen(uniqueid) + 1, NULL, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	snapshot = ao2_alloc_options(sizeof(*snapshot) + strlen(uniqueid) + 1, NULL,
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT);
 	if (!snapshot) {
 		return NULL;
 	}
@@ -413,7 +428,7 @@ static struct ast_channel_snapshot_dialplan *channel_snapshot_dialplan_create(st
 	struct ast_channel_snapshot_dialplan *snapshot;
 
 	snapshot = ao2_alloc_options(sizeof(*snapshot), channel_snapshot_dialplan_dtor,
-		AO2_ALLOC_OPT_LOCK_NOLOCK);
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT);
 	if (!snapshot) {
 		return NULL;
 	}
@@ -441,7 +456,8 @@ static struct ast_channel_snapshot_hangup *channel_snapshot_hangup_create(struct
 	const char *hangupsource = S_OR(ast_channel_hangupsource(chan), "");
 	struct ast_channel_snapshot_hangup *snapshot;
 
-	snapshot = ao2_alloc_options(sizeof(*snapshot) + strlen(hangupsource) + 1, NULL, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	snapshot = ao2_alloc_options(sizeof(*snapshot) + strlen(hangupsource) + 1, NULL,
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT);
 	if (!snapshot) {
 		return NULL;
 	}
@@ -463,7 +479,7 @@ struct ast_channel_snapshot *ast_channel_snapshot_create(struct ast_channel *cha
 	}
 
 	snapshot = ao2_alloc_options(sizeof(*snapshot), channel_snapshot_dtor,
-		AO2_ALLOC_OPT_LOCK_NOLOCK);
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT);
 	if (!snapshot) {
 		return NULL;
 	}
@@ -572,7 +588,7 @@ static struct ast_channel_snapshot_update *channel_snapshot_update_create(struct
 	struct ast_channel_snapshot_update *update;
 
 	update = ao2_alloc_options(sizeof(*update), channel_snapshot_update_dtor,
-		AO2_ALLOC_OPT_LOCK_NOLOCK);
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT);
 	if (!update) {
 		return NULL;
 	}
@@ -943,6 +959,7 @@ void ast_channel_publish_final_snapshot(struct ast_channel *chan)
 
 	ao2_unlink(channel_cache, update->old_snapshot);
 	ao2_unlink(channel_cache_by_name, update->old_snapshot);
+	ast_atomic_fetchadd_int(&channel_cache_generation, +1);
 
 	ast_channel_snapshot_set(chan, NULL);
 
@@ -1056,6 +1073,40 @@ void ast_channel_snapshot_invalidate_segment(struct ast_channel *chan,
 	ast_set_flag(ast_channel_snapshot_segment_flags(chan), segment);
 }
 
+/*!
+ * \internal
+ * \brief Determine if a snapshot publish may be deferred to the coalescing window
+ *
+ * Variable-heavy dialplan execution can request dozens of snapshots in quick
+ * succession where nothing an observer keys off of has changed. Those are safe
+ * to coalesce: the segments remain flagged as invalidated, so the next publish
+ * outside the window carries the accumulated changes. Anything touching the
+ * channel state or a state-significant segment always publishes immediately,
+ * as does the final snapshot at hangup.
+ */
+static int channel_snapshot_coalesce(struct ast_channel *chan)
+{
+	struct ast_channel_snapshot *old_snapshot = ast_channel_snapshot(chan);
+
+	if (ast_option_snapshotcoalesce <= 0 || !old_snapshot) {
+		return 0;
+	}
+
+	if (old_snapshot->state != ast_channel_state(chan)) {
+		return 0;
+	}
+
+	if (ast_test_flag(ast_channel_snapshot_segment_flags(chan),
+		AST_CHANNEL_SNAPSHOT_INVALIDATE_BASE | AST_CHANNEL_SNAPSHOT_INVALIDATE_BRIDGE
+		| AST_CHANNEL_SNAPSHOT_INVALIDATE_CALLER | AST_CHANNEL_SNAPSHOT_INVALIDATE_CONNECTED
+		| AST_CHANNEL_SNAPSHOT_INVALIDATE_HANGUP)) {
+		return 0;
+	}
+
+	return ast_remaining_ms(ast_channel_snapshot_publish_time(chan),
+		ast_option_snapshotcoalesce) > 0;
+}
+
 void ast_channel_publish_snapshot(struct ast_channel *chan)
 {
 	struct ast_channel_snapshot_update *update;
@@ -1069,6 +1120,10 @@ void ast_channel_publish_snapshot(struct ast_channel *chan)
 		return;
 	}
 
+	if (channel_snapshot_coalesce(chan)) {
+		return;
+	}
+
 	update = channel_snapshot_update_create(chan);
 	if (!update) {
 		return;
@@ -1109,7 +1164,10 @@ void ast_channel_publish_snapshot(struct ast_channel *chan)
 	ao2_link_flags(channel_cache_by_name, update->new_snapshot, OBJ_NOLOCK);
 	ao2_unlock(channel_cache_by_name);
 
+	ast_atomic_fetchadd_int(&channel_cache_generation, +1);
+
 	ast_channel_snapshot_set(chan, update->new_snapshot);
+	ast_channel_snapshot_publish_time_set(chan, ast_tvnow());
 
 	/* As this is now the new snapshot any existing invalidated segments have been
 	 * created fresh and are up to date.
@@ -78,11 +78,15 @@ static struct ast_manager_event_blob *cc_callerrecalling_to_ami(struct stasis_me
 static struct ast_manager_event_blob *cc_recallcomplete_to_ami(struct stasis_message *message);
 static struct ast_manager_event_blob *cc_failure_to_ami(struct stasis_message *message);
 static struct ast_manager_event_blob *cc_monitorfailed_to_ami(struct stasis_message *message);
+static struct ast_manager_event_blob *taskprocessor_overload_to_ami(struct stasis_message *message);
 
 STASIS_MESSAGE_TYPE_DEFN(ast_network_change_type);
 STASIS_MESSAGE_TYPE_DEFN(ast_system_registry_type,
 	.to_ami = system_registry_to_ami,
 	);
+STASIS_MESSAGE_TYPE_DEFN(ast_taskprocessor_overload_type,
+	.to_ami = taskprocessor_overload_to_ami,
+	);
 STASIS_MESSAGE_TYPE_DEFN(ast_cc_available_type,
 	.to_ami = cc_available_to_ami,
 	);
@@ -182,6 +186,64 @@ static struct ast_manager_event_blob *system_registry_to_ami(struct stasis_messa
 		channeltype, username, domain, status, ast_str_buffer(cause_string));
 }
 
+void ast_system_publish_taskprocessor_overload(const char *name, const char *subsystem,
+	long p99_wait_ms, long threshold_ms, long queue_size)
+{
+	struct ast_json *alert;
+	struct ast_json_payload *payload;
+	struct stasis_message *message;
+
+	if (!ast_taskprocessor_overload_type()) {
+		return;
+	}
+
+	alert = ast_json_pack("{s: s, s: s, s: i, s: i, s: i}",
+		"taskprocessor", name,
+		"subsystem", S_OR(subsystem, ""),
+		"p99_wait_ms", (int) p99_wait_ms,
+		"threshold_ms", (int) threshold_ms,
+		"queue_size", (int) queue_size);
+
+	payload = ast_json_payload_create(alert);
+	ast_json_unref(alert);
+	if (!payload) {
+		return;
+	}
+
+	message = stasis_message_create(ast_taskprocessor_overload_type(), payload);
+	ao2_ref(payload, -1);
+	if (!message) {
+		return;
+	}
+
+	stasis_publish(ast_system_topic(), message);
+	ao2_ref(message, -1);
+}
+
+static struct ast_manager_event_blob *taskprocessor_overload_to_ami(struct stasis_message *message)
+{
+	struct ast_json_payload *payload = stasis_message_data(message);
+	const char *name;
+	const char *subsystem;
+	int p99_wait_ms;
+	int threshold_ms;
+	int queue_size;
+
+	name = ast_json_string_get(ast_json_object_get(payload->json, "taskprocessor"));
+	subsystem = ast_json_string_get(ast_json_object_get(payload->json, "subsystem"));
+	p99_wait_ms = ast_json_integer_get(ast_json_object_get(payload->json, "p99_wait_ms"));
+	threshold_ms = ast_json_integer_get(ast_json_object_get(payload->json, "threshold_ms"));
+	queue_size = ast_json_integer_get(ast_json_object_get(payload->json, "queue_size"));
+
+	return ast_manager_event_blob_create(EVENT_FLAG_SYSTEM, "TaskprocessorOverload",
+		"Taskprocessor: %s\r\n"
+		"Subsystem: %s\r\n"
+		"P99WaitMs: %d\r\n"
+		"ThresholdMs: %d\r\n"
+		"QueueSize: %d\r\n",
+		name, subsystem, p99_wait_ms, threshold_ms, queue_size);
+}
+
 static struct ast_manager_event_blob *cc_available_to_ami(struct stasis_message *message)
 {
 	struct ast_json_payload *payload = stasis_message_data(message);
@@ -356,6 +418,7 @@ static void stasis_system_cleanup(void)
 	system_topic = NULL;
 	STASIS_MESSAGE_TYPE_CLEANUP(ast_network_change_type);
 	STASIS_MESSAGE_TYPE_CLEANUP(ast_system_registry_type);
+	STASIS_MESSAGE_TYPE_CLEANUP(ast_taskprocessor_overload_type);
 	STASIS_MESSAGE_TYPE_CLEANUP(ast_cc_available_type);
 	STASIS_MESSAGE_TYPE_CLEANUP(ast_cc_offertimerstart_type);
 	STASIS_MESSAGE_TYPE_CLEANUP(ast_cc_requested_type);
@@ -387,6 +450,10 @@ int ast_stasis_system_init(void)
 		return -1;
 	}
 
+	if (STASIS_MESSAGE_TYPE_INIT(ast_taskprocessor_overload_type) != 0) {
+		return -1;
+	}
+
 	if (STASIS_MESSAGE_TYPE_INIT(ast_cc_available_type) != 0) {
 		return -1;
 	}
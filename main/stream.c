@@ -275,12 +275,13 @@ struct ast_stream *ast_stream_clone(const struct ast_stream *stream, const char
 	strcpy(new_stream->name, stream_name); /* Safe */
 	new_stream->group = -1;
 
-	new_stream->formats = ast_format_cap_alloc(AST_FORMAT_CAP_FLAG_DEFAULT);
-	if (!new_stream->formats) {
-		ast_free(new_stream);
-		return NULL;
-	}
-	ast_format_cap_append_from_cap(new_stream->formats, stream->formats, AST_MEDIA_TYPE_UNKNOWN);
+	/* Copy-on-write: the format capabilities are shared with the original
+	 * stream rather than deep copied.  They are only ever replaced wholesale
+	 * through ast_stream_set_formats, so sharing is safe and renegotiation
+	 * heavy paths (every re-INVITE and bridge join clones the topology) skip
+	 * a capability allocation and copy per stream.
+	 */
+	new_stream->formats = ao2_bump(stream->formats);
 
 	new_stream->metadata = ast_stream_get_metadata_list(stream);
 
@@ -701,6 +702,10 @@ int ast_stream_topology_equal(const struct ast_stream_topology *left,
 	ast_assert(left != NULL);
 	ast_assert(right != NULL);
 
+	if (left == right) {
+		return 1;
+	}
+
 	if (ast_stream_topology_get_count(left) != ast_stream_topology_get_count(right)) {
 		return 0;
 	}
@@ -717,7 +722,11 @@ int ast_stream_topology_equal(const struct ast_stream_topology *left,
 			return 0;
 		}
 
-		if (!ast_stream_get_formats(left_stream) && ast_stream_get_formats(right_stream) &&
+		if (ast_stream_get_formats(left_stream) == ast_stream_get_formats(right_stream)) {
+			/* Clones share format capabilities, so identical pointers are
+			 * common and short-circuit the format comparison entirely.
+			 */
+		} else if (!ast_stream_get_formats(left_stream) && ast_stream_get_formats(right_stream) &&
 			ast_format_cap_count(ast_stream_get_formats(right_stream))) {
 			/* A NULL format capabilities and an empty format capabilities are the same, as they have
 			 * no formats inside. If one does though... they are not equal.
@@ -740,6 +749,50 @@ int ast_stream_topology_equal(const struct ast_stream_topology *left,
 	return 1;
 }
 
+unsigned int ast_stream_hash(const struct ast_stream *stream)
+{
+	const struct ast_format_cap *formats = ast_stream_get_formats(stream);
+	unsigned int hash;
+	int format_index;
+
+	ast_assert(stream != NULL);
+
+	hash = ast_stream_get_type(stream);
+	hash = hash * 31 + ast_stream_get_state(stream);
+	hash = hash * 31 + ast_str_hash(ast_stream_get_name(stream));
+
+	if (!formats) {
+		return hash;
+	}
+
+	for (format_index = 0; format_index < ast_format_cap_count(formats); ++format_index) {
+		struct ast_format *format = ast_format_cap_get_format(formats, format_index);
+
+		hash = hash * 31 + ast_str_hash(ast_format_get_name(format));
+		ao2_ref(format, -1);
+	}
+
+	return hash;
+}
+
+unsigned int ast_stream_topology_hash(const struct ast_stream_topology *topology)
+{
+	unsigned int hash;
+	int index;
+
+	ast_assert(topology != NULL);
+
+	hash = ast_stream_topology_get_count(topology);
+
+	for (index = 0; index < ast_stream_topology_get_count(topology); ++index) {
+		const struct ast_stream *stream = ast_stream_topology_get_stream(topology, index);
+
+		hash = hash * 31 + ast_stream_hash(stream);
+	}
+
+	return hash;
+}
+
 void ast_stream_topology_free(struct ast_stream_topology *topology)
 {
 	ao2_cleanup(topology);
@@ -170,6 +170,73 @@ char *__ast_str_helper2(struct ast_str **buf, ssize_t maxlen, const char *src, s
 	return (*buf)->__AST_STR_STR;
 }
 
+/*! \brief Maximum number of scratch strings retained per thread */
+#define STR_SCRATCH_POOL_MAX 8
+
+/*! \brief Per-thread pool of scratch dynamic strings */
+struct str_scratch_pool {
+	struct ast_str *bufs[STR_SCRATCH_POOL_MAX];
+	unsigned int count;
+};
+
+static void str_scratch_pool_cleanup(void *data)
+{
+	struct str_scratch_pool *pool = data;
+	unsigned int i;
+
+	for (i = 0; i < pool->count; i++) {
+		ast_free(pool->bufs[i]);
+	}
+	ast_free(pool);
+}
+
+AST_THREADSTORAGE_CUSTOM(str_scratch_pool_storage, NULL, str_scratch_pool_cleanup);
+
+struct ast_str *ast_str_scratch_get(size_t init_len)
+{
+	struct str_scratch_pool *pool;
+
+	pool = ast_threadstorage_get(&str_scratch_pool_storage, sizeof(*pool));
+	if (pool && pool->count) {
+		struct ast_str *buf;
+		unsigned int i;
+		unsigned int best = 0;
+
+		/* Hand out the largest pooled buffer so repeated users converge on
+		 * a few buffers already grown to their working size. */
+		for (i = 1; i < pool->count; i++) {
+			if (ast_str_size(pool->bufs[i]) > ast_str_size(pool->bufs[best])) {
+				best = i;
+			}
+		}
+
+		buf = pool->bufs[best];
+		pool->bufs[best] = pool->bufs[--pool->count];
+		ast_str_reset(buf);
+
+		return buf;
+	}
+
+	return ast_str_create(init_len);
+}
+
+void ast_str_scratch_release(struct ast_str **buf)
+{
+	struct str_scratch_pool *pool;
+
+	if (!buf || !*buf) {
+		return;
+	}
+
+	pool = ast_threadstorage_get(&str_scratch_pool_storage, sizeof(*pool));
+	if (pool && pool->count < STR_SCRATCH_POOL_MAX) {
+		pool->bufs[pool->count++] = *buf;
+	} else {
+		ast_free(*buf);
+	}
+	*buf = NULL;
+}
+
 static int str_hash(const void *obj, const int flags)
 {
 	return ast_str_hash(obj);
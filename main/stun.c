@@ -101,6 +101,7 @@ struct stun_addr {
 #define STUN_BINDREQ	0x0001
 #define STUN_BINDRESP	0x0101
 #define STUN_BINDERR	0x0111
+#define STUN_BINDINDICATION	0x0011	/*!< RFC 5389 Binding Indication, elicits no response */
 #define STUN_SECREQ	0x0002
 #define STUN_SECRESP	0x0102
 #define STUN_SECERR	0x0112
@@ -132,6 +133,8 @@ static const char *stun_msg2str(int msg)
 		return "Binding Response";
 	case STUN_BINDERR:
 		return "Binding Error Response";
+	case STUN_BINDINDICATION:
+		return "Binding Indication";
 	case STUN_SECREQ:
 		return "Shared Secret Request";
 	case STUN_SECRESP:
@@ -518,6 +521,26 @@ try_again:
 	return res;
 }
 
+int ast_stun_send_indication(int s, struct sockaddr_in *dst)
+{
+	struct stun_header *req;
+	unsigned char req_buf[sizeof(struct stun_header)];
+
+	/* Create an attribute-less STUN binding indication.  No response is
+	 * expected so there are no retries and nothing to wait for. */
+	req = (struct stun_header *) req_buf;
+	stun_req_id(req);
+	req->msglen = 0;
+	req->msgtype = htons(STUN_BINDINDICATION);
+
+	if (stun_send(s, dst, req) < 0) {
+		ast_debug_stun(1, "stun indication send failed: %s\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
 static char *handle_cli_stun_set_debug(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
 {
 	switch (cmd) {
@@ -36,6 +36,7 @@
 #include "asterisk/cli.h"
 #include "asterisk/taskprocessor.h"
 #include "asterisk/sem.h"
+#include "asterisk/stasis_system.h"
 
 /*!
  * \brief tps_task structure is queued to a taskprocessor
@@ -54,15 +55,42 @@ struct tps_task {
 	void *datap;
 	/*! \brief AST_LIST_ENTRY overhead */
 	AST_LIST_ENTRY(tps_task) list;
+	/*! \brief When the task was pushed onto the queue */
+	struct timeval enqueued;
 	unsigned int wants_local:1;
 };
 
+/*! \brief Number of tasks between wait histogram window rollovers. */
+#define TPS_WAIT_WINDOW 256
+
+/*!
+ * \brief Number of power-of-two wait histogram buckets.
+ *
+ * Bucket N counts waits of at most (1 << N) milliseconds; the final
+ * bucket collects everything longer.
+ */
+#define TPS_WAIT_BUCKETS 12
+
 /*! \brief tps_taskprocessor_stats maintain statistics for a taskprocessor. */
 struct tps_taskprocessor_stats {
 	/*! \brief This is the maximum number of tasks queued at any one time */
 	unsigned long max_qsize;
 	/*! \brief This is the current number of tasks processed */
 	unsigned long _tasks_processed_count;
+	/*! \brief Decaying average of how long tasks waited in queue before running (ms) */
+	long avg_wait_ms;
+	/*! \brief Longest time a task waited in queue before running (ms) */
+	long max_wait_ms;
+	/*! \brief Queue wait histogram of the window being filled */
+	unsigned int wait_buckets[TPS_WAIT_BUCKETS];
+	/*! \brief Number of tasks folded into wait_buckets so far */
+	unsigned int wait_count;
+	/*! \brief Queue wait histogram of the last completed window */
+	unsigned int report_buckets[TPS_WAIT_BUCKETS];
+	/*! \brief Number of tasks in report_buckets */
+	unsigned int report_count;
+	/*! \brief p99 queue wait of the last completed window (ms) */
+	long p99_wait_ms;
 };
 
 /*! \brief A ast_taskprocessor structure is a singleton by name */
@@ -76,6 +104,8 @@ struct ast_taskprocessor {
 	long tps_queue_low;
 	/*! \brief Taskprocessor high water alert trigger level */
 	long tps_queue_high;
+	/*! \brief p99 queue wait alert trigger level (ms), zero to disable */
+	long tps_wait_high;
 	/*! \brief Taskprocessor queue */
 	AST_LIST_HEAD_NOLOCK(tps_queue, tps_task) tps_queue;
 	struct ast_taskprocessor_listener *listener;
@@ -87,6 +117,8 @@ struct ast_taskprocessor {
 	unsigned int high_water_warned:1;
 	/*! Indicates that a high water alert is active on this taskprocessor */
 	unsigned int high_water_alert:1;
+	/*! Indicates that a queue wait alert is active on this taskprocessor */
+	unsigned int wait_alert:1;
 	/*! Indicates if the taskprocessor is currently suspended */
 	unsigned int suspended:1;
 	/*! \brief Anything before the first '/' in the name (if there is one) */
@@ -136,6 +168,14 @@ static AST_VECTOR_RW(subsystem_alert_vector, struct subsystem_alert *) overloade
 /*! \brief tps_singletons is the astobj2 container for taskprocessor singletons */
 static struct ao2_container *tps_singletons;
 
+/*!
+ * \brief Default p99 queue wait alert level (ms) for new taskprocessors.
+ *
+ * Zero disables wait alerting unless it is enabled per taskprocessor
+ * with ast_taskprocessor_alert_set_wait_level().
+ */
+static long tps_default_wait_high;
+
 /*! \brief CLI <example>taskprocessor ping &lt;blah&gt;</example> operation requires a ping condition */
 static ast_cond_t cli_ping_cond;
 
@@ -155,6 +195,7 @@ static char *cli_tps_report(struct ast_cli_entry *e, int cmd, struct ast_cli_arg
 static char *cli_subsystem_alert_report(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a);
 static char *cli_tps_reset_stats(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a);
 static char *cli_tps_reset_stats_all(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a);
+static char *cli_tps_set_wait_alert(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a);
 
 static int tps_sort_cb(const void *obj_left, const void *obj_right, int flags);
 
@@ -165,6 +206,7 @@ static struct ast_cli_entry taskprocessor_clis[] = {
 	AST_CLI_DEFINE(cli_subsystem_alert_report, "List task processor subsystems in alert"),
 	AST_CLI_DEFINE(cli_tps_reset_stats, "Reset a named task processor's stats"),
 	AST_CLI_DEFINE(cli_tps_reset_stats_all, "Reset all task processors' stats"),
+	AST_CLI_DEFINE(cli_tps_set_wait_alert, "Set the task processor p99 queue wait alert level"),
 };
 
 struct default_taskprocessor_listener_pvt {
@@ -574,8 +616,8 @@ static int tps_sort_cb(const void *obj_left, const void *obj_right, int flags)
 	return cmp;
 }
 
-#define FMT_HEADERS		"%-70s %10s %10s %10s %10s %10s\n"
-#define FMT_FIELDS		"%-70s %10lu %10lu %10lu %10lu %10lu\n"
+#define FMT_HEADERS		"%-70s %10s %10s %10s %10s %10s %10s %10s %10s\n"
+#define FMT_FIELDS		"%-70s %10lu %10lu %10lu %10lu %10lu %10ld %10ld %10ld\n"
 
 /*!
  * \internal
@@ -589,7 +631,8 @@ static void tps_report_taskprocessor_list_helper(int fd, struct ast_taskprocesso
 {
 	ast_cli(fd, FMT_FIELDS, tps->name, tps->stats._tasks_processed_count,
 		tps->tps_queue_size, tps->stats.max_qsize, tps->tps_queue_low,
-		tps->tps_queue_high);
+		tps->tps_queue_high, tps->stats.avg_wait_ms, tps->stats.p99_wait_ms,
+		tps->stats.max_wait_ms);
 }
 
 /*!
@@ -667,7 +710,7 @@ static char *cli_tps_report(struct ast_cli_entry *e, int cmd, struct ast_cli_arg
 		return CLI_SHOWUSAGE;
 	}
 
-	ast_cli(a->fd, "\n" FMT_HEADERS, "Processor", "Processed", "In Queue", "Max Depth", "Low water", "High water");
+	ast_cli(a->fd, "\n" FMT_HEADERS, "Processor", "Processed", "In Queue", "Max Depth", "Low water", "High water", "Avg Wait", "p99 Wait", "Max Wait");
 	ast_cli(a->fd, "\n%d taskprocessors\n\n", tps_report_taskprocessor_list(a->fd, like));
 
 	return CLI_SUCCESS;
@@ -927,6 +970,27 @@ int ast_taskprocessor_alert_set_levels(struct ast_taskprocessor *tps, long low_w
 	return 0;
 }
 
+int ast_taskprocessor_alert_set_wait_level(struct ast_taskprocessor *tps, long wait_ms)
+{
+	if (!tps || wait_ms < 0) {
+		return -1;
+	}
+
+	ao2_lock(tps);
+
+	tps->tps_wait_high = wait_ms;
+
+	if (tps->wait_alert && (!wait_ms || tps->stats.p99_wait_ms <= (wait_ms * 9) / 10)) {
+		/* Update wait alert immediately */
+		tps->wait_alert = 0;
+		tps_alert_add(tps, -1);
+	}
+
+	ao2_unlock(tps);
+
+	return 0;
+}
+
 /* destroy the taskprocessor */
 static void tps_taskprocessor_dtor(void *tps)
 {
@@ -943,6 +1007,11 @@ static void tps_taskprocessor_dtor(void *tps)
 		tps_alert_add(t, -1);
 	}
 
+	if (t->wait_alert) {
+		t->wait_alert = 0;
+		tps_alert_add(t, -1);
+	}
+
 	ao2_cleanup(t->listener);
 	t->listener = NULL;
 }
@@ -967,6 +1036,30 @@ long ast_taskprocessor_size(struct ast_taskprocessor *tps)
 	return (tps) ? tps->tps_queue_size : -1;
 }
 
+long ast_taskprocessor_avg_wait_ms(struct ast_taskprocessor *tps)
+{
+	long avg_wait_ms;
+
+	ao2_lock(tps);
+	avg_wait_ms = tps->stats.avg_wait_ms;
+	ao2_unlock(tps);
+	return avg_wait_ms;
+}
+
+long ast_taskprocessor_oldest_wait_ms(struct ast_taskprocessor *tps)
+{
+	struct tps_task *t;
+	long wait_ms = 0;
+
+	ao2_lock(tps);
+	t = AST_LIST_FIRST(&tps->tps_queue);
+	if (t) {
+		wait_ms = ast_tvdiff_ms(ast_tvnow(), t->enqueued);
+	}
+	ao2_unlock(tps);
+	return wait_ms;
+}
+
 /* taskprocessor name accessor */
 const char *ast_taskprocessor_name(struct ast_taskprocessor *tps)
 {
@@ -1067,6 +1160,7 @@ static struct ast_taskprocessor *__allocate_taskprocessor(const char *name, stru
 	/* Set default congestion water level alert triggers. */
 	p->tps_queue_low = (AST_TASKPROCESSOR_HIGH_WATER_LEVEL * 9) / 10;
 	p->tps_queue_high = AST_TASKPROCESSOR_HIGH_WATER_LEVEL;
+	p->tps_wait_high = tps_default_wait_high;
 
 	strcpy(p->name, name); /* Safe */
 	p->subsystem = p->name + name_length + 1;
@@ -1217,6 +1311,7 @@ static int taskprocessor_push(struct ast_taskprocessor *tps, struct tps_task *t)
 	}
 
 	ao2_lock(tps);
+	t->enqueued = ast_tvnow();
 	AST_LIST_INSERT_TAIL(&tps->tps_queue, t, list);
 	previous_size = tps->tps_queue_size++;
 
@@ -1274,11 +1369,54 @@ int ast_taskprocessor_is_suspended(struct ast_taskprocessor *tps)
 	return tps ? tps->suspended : -1;
 }
 
+/*!
+ * \internal
+ * \brief Map a queue wait in ms to its power-of-two histogram bucket.
+ */
+static int tps_wait_bucket(long wait_ms)
+{
+	int idx;
+
+	for (idx = 0; idx < TPS_WAIT_BUCKETS - 1; ++idx) {
+		if (wait_ms <= (1L << idx)) {
+			return idx;
+		}
+	}
+	return TPS_WAIT_BUCKETS - 1;
+}
+
+/*!
+ * \internal
+ * \brief Compute the p99 queue wait (ms) of the last completed window.
+ *
+ * Must be called with the taskprocessor locked.  The percentile is the
+ * upper edge of the bucket containing the 99th percentile task; waits
+ * falling into the overflow bucket report the observed maximum instead.
+ */
+static long tps_wait_p99(const struct tps_taskprocessor_stats *stats)
+{
+	unsigned int needed = (stats->report_count * 99 + 99) / 100;
+	unsigned int seen = 0;
+	int idx;
+
+	for (idx = 0; idx < TPS_WAIT_BUCKETS - 1; ++idx) {
+		seen += stats->report_buckets[idx];
+		if (needed <= seen) {
+			return 1L << idx;
+		}
+	}
+	return stats->max_wait_ms;
+}
+
 int ast_taskprocessor_execute(struct ast_taskprocessor *tps)
 {
 	struct ast_taskprocessor_local local;
 	struct tps_task *t;
 	long size;
+	long wait_ms;
+	long p99_wait_ms = 0;
+	long wait_high = 0;
+	int overloaded = 0;
 
 	ao2_lock(tps);
 	t = tps_taskprocessor_pop(tps);
@@ -1286,6 +1424,7 @@ int ast_taskprocessor_execute(struct ast_taskprocessor *tps)
 		ao2_unlock(tps);
 		return 0;
 	}
+	wait_ms = ast_tvdiff_ms(ast_tvnow(), t->enqueued);
 
 	tps->thread = pthread_self();
 	tps->executing = 1;
@@ -1319,8 +1458,48 @@ int ast_taskprocessor_execute(struct ast_taskprocessor *tps)
 	if (size >= tps->stats.max_qsize) {
 		tps->stats.max_qsize = size + 1;
 	}
+
+	/* Fold the task's queue wait into a decaying average. */
+	tps->stats.avg_wait_ms = (tps->stats.avg_wait_ms * 7 + wait_ms) / 8;
+	if (wait_ms > tps->stats.max_wait_ms) {
+		tps->stats.max_wait_ms = wait_ms;
+	}
+
+	/* Bucket the wait for the windowed percentile report. */
+	++tps->stats.wait_buckets[tps_wait_bucket(wait_ms)];
+	if (++tps->stats.wait_count == TPS_WAIT_WINDOW) {
+		memcpy(tps->stats.report_buckets, tps->stats.wait_buckets,
+			sizeof(tps->stats.report_buckets));
+		tps->stats.report_count = tps->stats.wait_count;
+		memset(tps->stats.wait_buckets, 0, sizeof(tps->stats.wait_buckets));
+		tps->stats.wait_count = 0;
+		tps->stats.p99_wait_ms = tps_wait_p99(&tps->stats);
+
+		if (tps->tps_wait_high) {
+			if (!tps->wait_alert) {
+				if (tps->tps_wait_high < tps->stats.p99_wait_ms) {
+					tps->wait_alert = 1;
+					tps_alert_add(tps, +1);
+					overloaded = 1;
+				}
+			} else if (tps->stats.p99_wait_ms <= (tps->tps_wait_high * 9) / 10) {
+				tps->wait_alert = 0;
+				tps_alert_add(tps, -1);
+			}
+		}
+		p99_wait_ms = tps->stats.p99_wait_ms;
+		wait_high = tps->tps_wait_high;
+	}
 	ao2_unlock(tps);
 
+	if (overloaded) {
+		ast_log(LOG_WARNING,
+			"The '%s' task processor p99 queue wait reached %ld ms (alert level %ld ms).\n",
+			tps->name, p99_wait_ms, wait_high);
+		ast_system_publish_taskprocessor_overload(tps->name, tps->subsystem,
+			p99_wait_ms, wait_high, size);
+	}
+
 	/* If we executed a task, check for the transition to empty */
 	if (size == 0 && tps->listener->callbacks->emptied) {
 		tps->listener->callbacks->emptied(tps->listener);
@@ -1388,6 +1567,13 @@ static void tps_reset_stats(struct ast_taskprocessor *tps)
 	ao2_lock(tps);
 	tps->stats._tasks_processed_count = 0;
 	tps->stats.max_qsize = 0;
+	tps->stats.avg_wait_ms = 0;
+	tps->stats.max_wait_ms = 0;
+	memset(tps->stats.wait_buckets, 0, sizeof(tps->stats.wait_buckets));
+	tps->stats.wait_count = 0;
+	memset(tps->stats.report_buckets, 0, sizeof(tps->stats.report_buckets));
+	tps->stats.report_count = 0;
+	tps->stats.p99_wait_ms = 0;
 	ao2_unlock(tps);
 }
 
@@ -1456,3 +1642,49 @@ static char *cli_tps_reset_stats_all(struct ast_cli_entry *e, int cmd, struct as
 
 	return CLI_SUCCESS;
 }
+
+static char *cli_tps_set_wait_alert(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	struct ast_taskprocessor *tps;
+	struct ao2_iterator iter;
+	long wait_ms;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "core set taskprocessor wait alert";
+		e->usage =
+			"Usage: core set taskprocessor wait alert {off|<milliseconds>}\n"
+			"    Sets the p99 queue wait alert level for all taskprocessors.\n"
+			"    A taskprocessor whose p99 queue wait exceeds the level raises\n"
+			"    an alert and publishes a TaskprocessorOverload event.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != e->args + 1) {
+		return CLI_SHOWUSAGE;
+	}
+
+	if (!strcasecmp(a->argv[e->args], "off")) {
+		wait_ms = 0;
+	} else if (sscanf(a->argv[e->args], "%30ld", &wait_ms) != 1 || wait_ms <= 0) {
+		return CLI_SHOWUSAGE;
+	}
+
+	tps_default_wait_high = wait_ms;
+	if (wait_ms) {
+		ast_cli(a->fd, "\nSetting p99 queue wait alert level to %ld ms\n\n", wait_ms);
+	} else {
+		ast_cli(a->fd, "\nDisabling p99 queue wait alerts\n\n");
+	}
+
+	iter = ao2_iterator_init(tps_singletons, 0);
+	while ((tps = ao2_iterator_next(&iter))) {
+		ast_taskprocessor_alert_set_wait_level(tps, wait_ms);
+		ast_taskprocessor_unreference(tps);
+	}
+	ao2_iterator_destroy(&iter);
+
+	return CLI_SUCCESS;
+}
@@ -38,6 +38,7 @@
 #include <openssl/asn1.h>               /* for ASN1_STRING_to_UTF8 */
 #include <openssl/crypto.h>             /* for OPENSSL_free */
 #include <openssl/err.h>                /* for ERR_print_errors_fp */
+#include <openssl/evp.h>                /* for EVP_sha256 */
 #include <openssl/opensslconf.h>        /* for OPENSSL_NO_SSL3_METHOD, OPENS... */
 #include <openssl/opensslv.h>           /* for OPENSSL_VERSION_NUMBER */
 #include <openssl/safestack.h>          /* for STACK_OF */
@@ -128,6 +129,205 @@ static void write_openssl_error_to_log(void)
 
 	ast_free(buffer);
 }
+
+/*! Seconds a cached certificate verification result stays valid */
+#define VERIFY_CACHE_TTL 300
+/*! Upper bound on cached verification results */
+#define VERIFY_CACHE_MAX_ENTRIES 1024
+#define VERIFY_CACHE_BUCKETS 61
+
+/*!
+ * \brief Cached result of a peer certificate chain verification.
+ *
+ * Reconnect storms on SIP-over-TLS trunks and AMI repeat the exact same
+ * chain verification for the same peer certificate.  Since the result
+ * only depends on the certificate and the trust configuration it was
+ * checked against, it can be reused for a bounded time.  The generation
+ * identifies one __ssl_setup() outcome, so a reconfigured trust store
+ * never matches entries cached before the reload.
+ */
+struct verify_cache_entry {
+	/*! SHA-256 fingerprint of the peer certificate */
+	unsigned char fingerprint[EVP_MAX_MD_SIZE];
+	unsigned int fingerprint_len;
+	/*! Which SSL_CTX setup the result was computed against */
+	uintptr_t generation;
+	/*! X509_V_OK or the verification error encountered */
+	int error;
+	/*! When the result was cached */
+	struct timeval when;
+};
+
+/*! Key for looking up a verify_cache_entry without allocating one */
+struct verify_cache_key {
+	const unsigned char *fingerprint;
+	unsigned int fingerprint_len;
+	uintptr_t generation;
+};
+
+static struct ao2_container *verify_cache;
+AST_MUTEX_DEFINE_STATIC(verify_cache_lock);
+
+static int verify_cache_hash_fn(const void *obj, int flags)
+{
+	const unsigned char *fingerprint;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_KEY:
+		fingerprint = ((const struct verify_cache_key *) obj)->fingerprint;
+		break;
+	case OBJ_SEARCH_OBJECT:
+		fingerprint = ((const struct verify_cache_entry *) obj)->fingerprint;
+		break;
+	default:
+		/* Hash can only work on something with a full key. */
+		ast_assert(0);
+		return 0;
+	}
+
+	return (fingerprint[0] | (fingerprint[1] << 8) | (fingerprint[2] << 16)
+		| (fingerprint[3] << 24)) & INT_MAX;
+}
+
+static int verify_cache_cmp_fn(void *obj, void *arg, int flags)
+{
+	const struct verify_cache_entry *entry = obj;
+	struct verify_cache_key key;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_KEY:
+		key = *(const struct verify_cache_key *) arg;
+		break;
+	case OBJ_SEARCH_OBJECT:
+		key.fingerprint = ((const struct verify_cache_entry *) arg)->fingerprint;
+		key.fingerprint_len = ((const struct verify_cache_entry *) arg)->fingerprint_len;
+		key.generation = ((const struct verify_cache_entry *) arg)->generation;
+		break;
+	default:
+		ast_assert(0);
+		return 0;
+	}
+
+	return entry->generation == key.generation
+		&& entry->fingerprint_len == key.fingerprint_len
+		&& !memcmp(entry->fingerprint, key.fingerprint, key.fingerprint_len)
+		? CMP_MATCH : 0;
+}
+
+/*! \brief ao2_callback to unlink entries older than the TTL */
+static int verify_cache_expired_cb(void *obj, void *arg, int flags)
+{
+	const struct verify_cache_entry *entry = obj;
+	const struct timeval *now = arg;
+
+	return ast_tvdiff_ms(*now, entry->when) >= VERIFY_CACHE_TTL * 1000 ? CMP_MATCH : 0;
+}
+
+/*!
+ * \internal
+ * \brief Allocate a fresh verification cache generation for one SSL_CTX.
+ *
+ * Also creates the cache container on first use.
+ */
+static uintptr_t verify_cache_new_generation(void)
+{
+	static uintptr_t generation;
+	uintptr_t new_generation;
+
+	ast_mutex_lock(&verify_cache_lock);
+	if (!verify_cache) {
+		verify_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0,
+			VERIFY_CACHE_BUCKETS, verify_cache_hash_fn, NULL, verify_cache_cmp_fn);
+	}
+	new_generation = ++generation;
+	ast_mutex_unlock(&verify_cache_lock);
+
+	return new_generation;
+}
+
+/*!
+ * \internal
+ * \brief SSL_CTX certificate verification callback with result caching.
+ *
+ * Looks up the peer certificate fingerprint before running the full
+ * chain verification and reuses the previous verdict when it is recent
+ * enough.  Negative results are cached as well so a storm of doomed
+ * reconnects does not re-verify either.
+ */
+static int tcptls_cert_verify_cb(X509_STORE_CTX *store_ctx, void *arg)
+{
+	struct verify_cache_key key = {
+		.generation = (uintptr_t) arg,
+	};
+	struct verify_cache_entry *entry;
+	unsigned char fingerprint[EVP_MAX_MD_SIZE];
+	unsigned int fingerprint_len;
+	struct timeval now = ast_tvnow();
+	X509 *cert;
+	int res;
+
+#if !defined(LIBRESSL_VERSION_NUMBER) && (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+	cert = X509_STORE_CTX_get0_cert(store_ctx);
+#else
+	cert = store_ctx->cert;
+#endif
+
+	if (!verify_cache || !cert
+		|| !X509_digest(cert, EVP_sha256(), fingerprint, &fingerprint_len)) {
+		return X509_verify_cert(store_ctx);
+	}
+
+	key.fingerprint = fingerprint;
+	key.fingerprint_len = fingerprint_len;
+
+	entry = ao2_find(verify_cache, &key, OBJ_SEARCH_KEY);
+	if (entry) {
+		if (ast_tvdiff_ms(now, entry->when) < VERIFY_CACHE_TTL * 1000) {
+			int error = entry->error;
+
+			ao2_ref(entry, -1);
+			if (error != X509_V_OK) {
+				X509_STORE_CTX_set_error(store_ctx, error);
+				return 0;
+			}
+			return 1;
+		}
+		ao2_unlink(verify_cache, entry);
+		ao2_ref(entry, -1);
+	}
+
+	res = X509_verify_cert(store_ctx);
+
+	if (res <= 0 && X509_STORE_CTX_get_error(store_ctx) == X509_V_OK) {
+		/* The verification machinery failed without producing a verdict
+		 * on the certificate (for example an allocation failure inside
+		 * the library).  That is a transient condition, not a property
+		 * of the certificate, so it must not be cached: a cached entry
+		 * with error == X509_V_OK would turn into a pass on the next
+		 * lookup. */
+		return 0;
+	}
+
+	entry = ao2_alloc_options(sizeof(*entry), NULL, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (entry) {
+		memcpy(entry->fingerprint, fingerprint, fingerprint_len);
+		entry->fingerprint_len = fingerprint_len;
+		entry->generation = key.generation;
+		entry->error = res > 0 ? X509_V_OK : X509_STORE_CTX_get_error(store_ctx);
+		entry->when = now;
+
+		if (ao2_container_count(verify_cache) >= VERIFY_CACHE_MAX_ENTRIES) {
+			ao2_callback(verify_cache, OBJ_NODATA | OBJ_MULTIPLE | OBJ_UNLINK,
+				verify_cache_expired_cb, &now);
+		}
+		if (ao2_container_count(verify_cache) < VERIFY_CACHE_MAX_ENTRIES) {
+			ao2_link(verify_cache, entry);
+		}
+		ao2_ref(entry, -1);
+	}
+
+	return res > 0;
+}
 #endif
 
 /*! \brief
@@ -137,7 +337,7 @@ static void write_openssl_error_to_log(void)
 *
 * \note must decrement ref count before returning NULL on error
 */
-static void *handle_tcptls_connection(void *data)
+void *ast_tcptls_server_process(void *data)
 {
 	struct ast_tcptls_session_instance *tcptls_session = data;
 #ifdef DO_SSL
@@ -339,7 +539,11 @@ void *ast_tcptls_server_root(void *data)
 		tcptls_session->client = 0;
 
 		/* This thread is now the only place that controls the single ref to tcptls_session */
-		if (ast_pthread_create_detached_background(&launched, NULL, handle_tcptls_connection, tcptls_session)) {
+		if (desc->dispatch_fn && !desc->dispatch_fn(tcptls_session)) {
+			/* The dispatcher took over the session reference. */
+			continue;
+		}
+		if (ast_pthread_create_detached_background(&launched, NULL, ast_tcptls_server_process, tcptls_session)) {
 			ast_log(LOG_ERROR, "TCP/TLS unable to launch helper thread for peer '%s': %s\n",
 				ast_sockaddr_stringify(&tcptls_session->remote_address),
 				strerror(errno));
@@ -470,6 +674,25 @@ static int __ssl_setup(struct ast_tls_config *cfg, int client)
 		ast_test_flag(&cfg->flags, AST_SSL_VERIFY_CLIENT) ? SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT : SSL_VERIFY_NONE,
 		NULL);
 
+	/* Cache chain verification results so reconnect storms presenting an
+	 * unchanged peer certificate do not repeat identical verifications.
+	 * The generation ties cached results to this SSL_CTX setup. */
+	SSL_CTX_set_cert_verify_callback(cfg->ssl_ctx, tcptls_cert_verify_cb,
+		(void *) verify_cache_new_generation());
+
+	if (!client) {
+		/* Enable session resumption so reconnecting clients can skip the
+		 * full key exchange.  Stateless session tickets are on by default;
+		 * the server side cache additionally allows session-ID resumption,
+		 * which requires a session ID context whenever client certificates
+		 * are verified.
+		 */
+		SSL_CTX_set_session_id_context(cfg->ssl_ctx,
+			(const unsigned char *) "asterisk", strlen("asterisk"));
+		SSL_CTX_set_session_cache_mode(cfg->ssl_ctx, SSL_SESS_CACHE_SERVER);
+		SSL_CTX_sess_set_cache_size(cfg->ssl_ctx, 4096);
+	}
+
 	if (!ast_strlen_zero(cfg->certfile)) {
 		char *tmpprivate = ast_strlen_zero(cfg->pvtfile) ? cfg->certfile : cfg->pvtfile;
 		if (SSL_CTX_use_certificate_chain_file(cfg->ssl_ctx, cfg->certfile) == 0) {
@@ -667,7 +890,7 @@ struct ast_tcptls_session_instance *ast_tcptls_client_start_timeout(
 		__ssl_setup(desc->tls_cfg, 1);
 	}
 
-	return handle_tcptls_connection(tcptls_session);
+	return ast_tcptls_server_process(tcptls_session);
 }
 
 struct ast_tcptls_session_instance *ast_tcptls_client_start(struct ast_tcptls_session_instance *tcptls_session)
@@ -23,10 +23,24 @@
 #include "asterisk/taskprocessor.h"
 #include "asterisk/astobj2.h"
 #include "asterisk/utils.h"
+#include "asterisk/time.h"
 
 /* Needs to stay prime if increased */
 #define THREAD_BUCKETS 89
 
+/*!
+ * \brief Queue wait (in milliseconds) above which an auto-increment pool grows.
+ *
+ * Automatic growth is driven by how long tasks are actually waiting for a
+ * thread rather than by instantaneous queue depth, so a short burst that
+ * the existing threads absorb quickly does not add threads that will just
+ * idle out again.
+ */
+#define GROW_WAIT_TARGET_MS 20
+
+/*! \brief Minimum time (in milliseconds) between automatic growth steps. */
+#define GROW_COOLDOWN_MS 100
+
 /*!
  * \brief An opaque threadpool structure
  *
@@ -94,6 +108,8 @@ struct ast_threadpool {
 	 * that the threadpool had its state change.
 	 */
 	struct ast_taskprocessor *control_tps;
+	/*! Time of the last automatic growth step.  Control thread use only. */
+	struct timeval last_grow;
 	/*! True if the threadpool is in the process of shutting down */
 	int shutting_down;
 	/*! Threadpool-specific options */
@@ -553,6 +569,41 @@ static void grow(struct ast_threadpool *pool, int delta)
 	}
 }
 
+/*!
+ * \brief Decide whether an automatic growth step is warranted
+ *
+ * Called from the threadpool's control taskprocessor thread when a task
+ * was pushed and no idle thread could be activated.
+ *
+ * \param pool The pool considering growth
+ * \retval 0 Growth should be skipped for now.
+ * \retval 1 The pool should grow.
+ */
+static int grow_warranted(struct ast_threadpool *pool)
+{
+	int current_size = ao2_container_count(pool->active_threads) +
+		ao2_container_count(pool->idle_threads);
+
+	if (!current_size) {
+		/* Nothing can drain the queue until we have at least one thread. */
+		return 1;
+	}
+
+	if (!ast_tvzero(pool->last_grow)
+		&& ast_tvdiff_ms(ast_tvnow(), pool->last_grow) < GROW_COOLDOWN_MS) {
+		/* Let the threads from the last step start pulling tasks before
+		 * deciding they are not enough.
+		 */
+		return 0;
+	}
+
+	/* The average covers recently completed waits; the oldest-wait check
+	 * catches a wedged pool where nothing is completing at all.
+	 */
+	return ast_taskprocessor_avg_wait_ms(pool->tps) >= GROW_WAIT_TARGET_MS
+		|| ast_taskprocessor_oldest_wait_ms(pool->tps) >= GROW_WAIT_TARGET_MS;
+}
+
 /*!
  * \brief Queued task called when tasks are pushed into the threadpool
  *
@@ -586,10 +637,11 @@ static int queued_task_pushed(void *data)
 
 	/* If no idle threads could be transitioned to active grow the pool as permitted. */
 	if (ao2_container_count(pool->active_threads) == existing_active) {
-		if (!pool->options.auto_increment) {
+		if (!pool->options.auto_increment || !grow_warranted(pool)) {
 			return 0;
 		}
 		grow(pool, pool->options.auto_increment);
+		pool->last_grow = ast_tvnow();
 		/* An optional second pass transitions any newly added threads. */
 		ao2_callback(pool->idle_threads, OBJ_UNLINK | OBJ_NOLOCK | OBJ_NODATA,
 				activate_thread, pool);
@@ -1152,23 +1204,38 @@ static void worker_active(struct worker_thread *worker)
  */
 static int worker_idle(struct worker_thread *worker)
 {
-	struct timeval start = ast_tvnow();
-	struct timespec end = {
-		.tv_sec = start.tv_sec + worker->options.idle_timeout,
-		.tv_nsec = start.tv_usec * 1000,
-	};
-	while (!worker->wake_up) {
-		if (worker->options.idle_timeout <= 0) {
-			ast_cond_wait(&worker->cond, &worker->lock);
-		} else if (ast_cond_timedwait(&worker->cond, &worker->lock, &end) == ETIMEDOUT) {
+	for (;;) {
+		struct timeval start = ast_tvnow();
+		struct timespec end = {
+			.tv_sec = start.tv_sec + worker->options.idle_timeout,
+			.tv_nsec = start.tv_usec * 1000,
+		};
+
+		while (!worker->wake_up) {
+			if (worker->options.idle_timeout <= 0) {
+				ast_cond_wait(&worker->cond, &worker->lock);
+			} else if (ast_cond_timedwait(&worker->cond, &worker->lock, &end) == ETIMEDOUT) {
+				break;
+			}
+		}
+
+		if (worker->wake_up) {
 			break;
 		}
-	}
 
-	if (!worker->wake_up) {
-		ast_debug(1, "Worker thread idle timeout reached. Dying.\n");
-		threadpool_idle_thread_dead(worker->pool, worker);
-		worker->state = DEAD;
+		/* Idle timeouts only shrink the pool back to its initial size.
+		 * The remaining threads stay on as warm spares so the next burst
+		 * of tasks does not pay thread creation latency, and so the pool
+		 * does not oscillate between zero and full under sawtooth load.
+		 */
+		if (ao2_container_count(worker->pool->active_threads)
+			+ ao2_container_count(worker->pool->idle_threads)
+			> worker->options.initial_size) {
+			ast_debug(1, "Worker thread idle timeout reached. Dying.\n");
+			threadpool_idle_thread_dead(worker->pool, worker);
+			worker->state = DEAD;
+			break;
+		}
 	}
 	worker->wake_up = 0;
 	return worker->state == ALIVE;
@@ -1342,17 +1409,40 @@ static struct serializer *serializer_create(struct ast_threadpool *pool,
 
 AST_THREADSTORAGE_RAW(current_serializer);
 
+/*!
+ * \brief Maximum number of tasks a serializer will run in one trip through the pool.
+ *
+ * A serializer occupies a pool thread while its queue drains.  Without a
+ * bound, a serializer whose queue is refilled as fast as it is consumed
+ * holds that thread indefinitely, and other serializers sharing a
+ * saturated pool never get a turn.  After this many tasks the serializer
+ * is pushed back onto the pool behind any other pending work.
+ */
+#define SERIALIZER_BATCH_SIZE 64
+
 static int execute_tasks(void *data)
 {
-	struct ast_taskprocessor *tps = data;
+	struct ast_taskprocessor_listener *listener = data;
+	struct serializer *ser = ast_taskprocessor_listener_get_user_data(listener);
+	struct ast_taskprocessor *tps = ast_taskprocessor_listener_get_tps(listener);
+	unsigned int batch = SERIALIZER_BATCH_SIZE;
+	int more;
 
 	ast_threadstorage_set_ptr(&current_serializer, tps);
-	while (ast_taskprocessor_execute(tps)) {
-		/* No-op */
-	}
+	do {
+		more = ast_taskprocessor_execute(tps);
+	} while (more && --batch);
 	ast_threadstorage_set_ptr(&current_serializer, NULL);
 
+	if (more && !ast_threadpool_push(ser->pool, execute_tasks, listener)) {
+		/* Tasks remain; our listener ref rode along with the re-push so
+		 * another pool thread picks up where we left off. */
+		ast_taskprocessor_unreference(tps);
+		return 0;
+	}
+
 	ast_taskprocessor_unreference(tps);
+	ao2_ref(listener, -1);
 	return 0;
 }
 
@@ -1360,10 +1450,10 @@ static void serializer_task_pushed(struct ast_taskprocessor_listener *listener,
 {
 	if (was_empty) {
 		struct serializer *ser = ast_taskprocessor_listener_get_user_data(listener);
-		struct ast_taskprocessor *tps = ast_taskprocessor_listener_get_tps(listener);
 
-		if (ast_threadpool_push(ser->pool, execute_tasks, tps)) {
-			ast_taskprocessor_unreference(tps);
+		ao2_ref(listener, +1);
+		if (ast_threadpool_push(ser->pool, execute_tasks, listener)) {
+			ao2_ref(listener, -1);
 		}
 	}
 }
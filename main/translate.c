@@ -43,6 +43,7 @@
 #include "asterisk/term.h"
 #include "asterisk/format.h"
 #include "asterisk/linkedlists.h"
+#include "asterisk/latency_trace.h"
 
 /*! \todo
  * TODO: sample frames for each supported input format.
@@ -53,6 +54,10 @@
 /*! max sample recalc */
 #define MAX_RECALC 1000
 
+/*! \brief longest translation pipeline we bother precomputing; anything
+ * longer falls back to walking the matrix step by step */
+#define MAX_PATH_STEPS 16
+
 /*! \brief the list of translators */
 static AST_RWLIST_HEAD_STATIC(translators, ast_translator);
 
@@ -60,6 +65,10 @@ struct translator_path {
 	struct ast_translator *step;       /*!< Next step translator */
 	uint32_t table_cost;               /*!< Complete table cost to destination */
 	uint8_t multistep;                 /*!< Multiple conversions required for this translation */
+	/*! \brief Number of entries in \c steps, or 0 if not precomputed */
+	uint8_t num_steps;
+	/*! \brief The complete pipeline to the destination, precomputed at rebuild time */
+	struct ast_translator *steps[MAX_PATH_STEPS];
 };
 
 /*!
@@ -470,6 +479,124 @@ static struct ast_frame *default_frameout(struct ast_trans_pvt *pvt)
 	return ast_trans_frameout(pvt, 0, 0);
 }
 
+void ast_trans_ring_init(struct ast_trans_ring *ring, void *buf, size_t size)
+{
+	memset(ring, 0, sizeof(*ring));
+	ring->buf = buf;
+	ring->size = size;
+}
+
+size_t ast_trans_ring_peek(struct ast_trans_ring *ring, unsigned char **data)
+{
+	*data = ring->buf + ring->tail;
+	return MIN(ring->used, ring->size - ring->tail);
+}
+
+void ast_trans_ring_consume(struct ast_trans_ring *ring, size_t len)
+{
+	len = MIN(len, ring->used);
+	ring->tail = (ring->tail + len) % ring->size;
+	ring->used -= len;
+}
+
+/*!
+ * \internal
+ * \brief Append translated bytes to a translator output ring.
+ *
+ * \param ring Ring to append to.
+ * \param data Bytes to append.
+ * \param len Number of bytes to append.
+ *
+ * \return Number of bytes appended.  Bytes that do not fit are
+ * dropped and counted in ring->overruns.
+ */
+static size_t trans_ring_append(struct ast_trans_ring *ring, const void *data, size_t len)
+{
+	const unsigned char *src = data;
+	size_t space = ring->size - ring->used;
+	size_t chunk;
+	size_t appended;
+
+	if (len > space) {
+		ring->overruns += len - space;
+		len = space;
+	}
+	appended = len;
+
+	while (len) {
+		chunk = MIN(len, ring->size - ring->head);
+		memcpy(ring->buf + ring->head, src, chunk);
+		ring->head = (ring->head + chunk) % ring->size;
+		ring->used += chunk;
+		src += chunk;
+		len -= chunk;
+	}
+
+	return appended;
+}
+
+int ast_translate_ring(struct ast_trans_pvt *path, struct ast_frame *f, int consume, struct ast_trans_ring *ring)
+{
+	struct ast_trans_pvt *p;
+	struct ast_frame *out = f;
+	int appended = 0;
+
+	for (p = path; p; p = p->next) {
+		struct ast_frame *current = out;
+
+		do {
+			if (framein(p, current)) {
+				if (out != f) {
+					ast_frfree(out);
+				}
+				if (consume) {
+					ast_frfree(f);
+				}
+				return -1;
+			}
+			current = AST_LIST_NEXT(current, frame_list);
+		} while (current);
+		if (out != f) {
+			ast_frfree(out);
+		}
+		out = NULL;
+
+		if (!p->next) {
+			/* Terminal step: move its output straight into the ring. */
+			if (p->t->frameout == default_frameout) {
+				/* The output is already sitting in outbuf; append it
+				 * without fabricating an isolated frame around it. */
+				appended = trans_ring_append(ring, p->outbuf.c, p->datalen);
+				p->datalen = 0;
+				p->samples = 0;
+			} else {
+				struct ast_frame *chunk = p->t->frameout(p);
+				struct ast_frame *cur;
+
+				for (cur = chunk; cur; cur = AST_LIST_NEXT(cur, frame_list)) {
+					appended += trans_ring_append(ring, cur->data.ptr, cur->datalen);
+				}
+				if (chunk) {
+					ast_frfree(chunk);
+				}
+			}
+			break;
+		}
+
+		out = p->t->frameout(p);
+		if (!out) {
+			/* This step is buffering; nothing downstream yet. */
+			break;
+		}
+	}
+
+	if (consume) {
+		ast_frfree(f);
+	}
+
+	return appended;
+}
+
 /* end of callback wrappers and helpers */
 
 void ast_translator_free_path(struct ast_trans_pvt *p)
@@ -485,7 +612,10 @@ void ast_translator_free_path(struct ast_trans_pvt *p)
 struct ast_trans_pvt *ast_translator_build_path(struct ast_format *dst, struct ast_format *src)
 {
 	struct ast_trans_pvt *head = NULL, *tail = NULL;
+	struct ast_translator *steps[MAX_PATH_STEPS];
+	int num_steps = 0;
 	int src_index, dst_index;
+	int i;
 
 	src_index = format2index(src);
 	dst_index = format2index(dst);
@@ -495,19 +625,52 @@ struct ast_trans_pvt *ast_translator_build_path(struct ast_format *dst, struct a
 		return NULL;
 	}
 
+	if (src_index == dst_index) {
+		return NULL;
+	}
+
+	/*
+	 * Snapshot the precomputed pipeline while holding the read lock.
+	 * Module references pin each step so instantiating the translators,
+	 * which can be comparatively slow, happens with the global
+	 * translator lock released.
+	 */
 	AST_RWLIST_RDLOCK(&translators);
+	num_steps = matrix_get(src_index, dst_index)->num_steps;
+	if (num_steps) {
+		memcpy(steps, matrix_get(src_index, dst_index)->steps,
+			num_steps * sizeof(steps[0]));
+	} else {
+		/* No precomputed pipeline (no path, or one too long to cache);
+		 * walk the matrix the traditional way. */
+		int cur_index = src_index;
 
-	while (src_index != dst_index) {
-		struct ast_trans_pvt *cur;
-		struct ast_format *explicit_dst = NULL;
-		struct ast_translator *t = matrix_get(src_index, dst_index)->step;
-		if (!t) {
+		while (cur_index != dst_index && num_steps < ARRAY_LEN(steps)) {
+			struct ast_translator *t = matrix_get(cur_index, dst_index)->step;
+
+			if (!t) {
+				break;
+			}
+			steps[num_steps++] = t;
+			cur_index = t->dst_fmt_index;
+		}
+		if (cur_index != dst_index) {
+			AST_RWLIST_UNLOCK(&translators);
 			ast_log(LOG_WARNING, "No translator path from %s to %s\n",
 				ast_format_get_name(src), ast_format_get_name(dst));
-			AST_RWLIST_UNLOCK(&translators);
-			ast_translator_free_path(head);
 			return NULL;
 		}
+	}
+	for (i = 0; i < num_steps; i++) {
+		ast_module_ref(steps[i]->module);
+	}
+	AST_RWLIST_UNLOCK(&translators);
+
+	for (i = 0; i < num_steps; i++) {
+		struct ast_trans_pvt *cur;
+		struct ast_translator *t = steps[i];
+		struct ast_format *explicit_dst = NULL;
+
 		if ((t->dst_codec.sample_rate == ast_format_get_sample_rate(dst)) && (t->dst_codec.type == ast_format_get_type(dst))) {
 			explicit_dst = dst;
 		}
@@ -515,8 +678,8 @@ struct ast_trans_pvt *ast_translator_build_path(struct ast_format *dst, struct a
 			ast_log(LOG_WARNING, "Failed to build translator step from %s to %s\n",
 				ast_format_get_name(src), ast_format_get_name(dst));
 			ast_translator_free_path(head);
-			AST_RWLIST_UNLOCK(&translators);
-			return NULL;
+			head = NULL;
+			break;
 		}
 		if (!head) {
 			head = cur;
@@ -525,11 +688,12 @@ struct ast_trans_pvt *ast_translator_build_path(struct ast_format *dst, struct a
 		}
 		tail = cur;
 		cur->nextin = cur->nextout = ast_tv(0, 0);
-		/* Keep going if this isn't the final destination */
-		src_index = cur->t->dst_fmt_index;
 	}
 
-	AST_RWLIST_UNLOCK(&translators);
+	for (i = 0; i < num_steps; i++) {
+		ast_module_unref(steps[i]->module);
+	}
+
 	return head;
 }
 
@@ -562,7 +726,7 @@ static struct ast_frame *generate_interpolated_slin(struct ast_trans_pvt *p, str
 }
 
 /*! \brief do the actual translation */
-struct ast_frame *ast_translate(struct ast_trans_pvt *path, struct ast_frame *f, int consume)
+static struct ast_frame *translate_frame(struct ast_trans_pvt *path, struct ast_frame *f, int consume)
 {
 	struct ast_trans_pvt *p = path;
 	struct ast_frame *out;
@@ -678,40 +842,54 @@ struct ast_frame *ast_translate(struct ast_trans_pvt *path, struct ast_frame *f,
 	return out;
 }
 
+struct ast_frame *ast_translate(struct ast_trans_pvt *path, struct ast_frame *f, int consume)
+{
+	struct ast_frame *out;
+	struct timeval trace_start = ast_latency_trace_start();
+
+	out = translate_frame(path, f, consume);
+	ast_latency_trace_end(AST_LATENCY_STAGE_TRANSLATE, &trace_start);
+	return out;
+}
+
+/*! \brief Measurements taken while running a translator over its sample corpus */
+struct translator_benchmark {
+	/*! Sample frames pushed into the translator */
+	unsigned int frames_in;
+	/*! Frames produced by the translator */
+	unsigned int frames_out;
+	/*! Samples produced by the translator */
+	int out_samples;
+	/*! CPU time (user + system) consumed, in microseconds */
+	int64_t usec;
+};
+
 /*!
  * \internal
- * \brief Compute the computational cost of a single translation step.
+ * \brief Run a translator over its canned sample audio and collect timings.
  *
- * \note This function is only used to decide which translation path to
- * use between two translators with identical src and dst formats.  Computational
- * cost acts only as a tie breaker. This is done so hardware translators
- * can naturally have precedence over software translators.
+ * The translator's own sample() corpus is fed through a scratch pvt until
+ * at least \a seconds seconds of output audio have been produced.
+ *
+ * \note This function expects the list of translators to be locked
+ *
+ * \retval 0 on success, with \a result filled in.
+ * \retval -1 if the translator could not be exercised.
  */
-static void generate_computational_cost(struct ast_translator *t, int seconds)
+static int benchmark_translator(struct ast_translator *t, int seconds, struct translator_benchmark *result)
 {
 	int num_samples = 0;
 	struct ast_trans_pvt *pvt;
 	struct rusage start;
 	struct rusage end;
-	int cost;
 	int out_rate = t->dst_codec.sample_rate;
 
-	if (!seconds) {
-		seconds = 1;
-	}
-
-	/* If they don't make samples, give them a terrible score */
-	if (!t->sample) {
-		ast_debug(3, "Translator '%s' does not produce sample frames.\n", t->name);
-		t->comp_cost = 999999;
-		return;
-	}
+	memset(result, 0, sizeof(*result));
 
 	pvt = newpvt(t, NULL);
 	if (!pvt) {
 		ast_log(LOG_WARNING, "Translator '%s' appears to be broken and will probably fail.\n", t->name);
-		t->comp_cost = 999999;
-		return;
+		return -1;
 	}
 
 	getrusage(RUSAGE_SELF, &start);
@@ -722,12 +900,13 @@ static void generate_computational_cost(struct ast_translator *t, int seconds)
 		if (!f) {
 			ast_log(LOG_WARNING, "Translator '%s' failed to produce a sample frame.\n", t->name);
 			destroy(pvt);
-			t->comp_cost = 999999;
-			return;
+			return -1;
 		}
+		result->frames_in++;
 		framein(pvt, f);
 		ast_frfree(f);
 		while ((f = t->frameout(pvt))) {
+			result->frames_out++;
 			num_samples += f->samples;
 			ast_frfree(f);
 		}
@@ -735,12 +914,45 @@ static void generate_computational_cost(struct ast_translator *t, int seconds)
 
 	getrusage(RUSAGE_SELF, &end);
 
-	cost = ((end.ru_utime.tv_sec - start.ru_utime.tv_sec) * 1000000) + end.ru_utime.tv_usec - start.ru_utime.tv_usec;
-	cost += ((end.ru_stime.tv_sec - start.ru_stime.tv_sec) * 1000000) + end.ru_stime.tv_usec - start.ru_stime.tv_usec;
+	result->usec = ((end.ru_utime.tv_sec - start.ru_utime.tv_sec) * 1000000) + end.ru_utime.tv_usec - start.ru_utime.tv_usec;
+	result->usec += ((end.ru_stime.tv_sec - start.ru_stime.tv_sec) * 1000000) + end.ru_stime.tv_usec - start.ru_stime.tv_usec;
+	result->out_samples = num_samples;
 
 	destroy(pvt);
 
-	t->comp_cost = cost / seconds;
+	return 0;
+}
+
+/*!
+ * \internal
+ * \brief Compute the computational cost of a single translation step.
+ *
+ * \note This function is only used to decide which translation path to
+ * use between two translators with identical src and dst formats.  Computational
+ * cost acts only as a tie breaker. This is done so hardware translators
+ * can naturally have precedence over software translators.
+ */
+static void generate_computational_cost(struct ast_translator *t, int seconds)
+{
+	struct translator_benchmark result;
+
+	if (!seconds) {
+		seconds = 1;
+	}
+
+	/* If they don't make samples, give them a terrible score */
+	if (!t->sample) {
+		ast_debug(3, "Translator '%s' does not produce sample frames.\n", t->name);
+		t->comp_cost = 999999;
+		return;
+	}
+
+	if (benchmark_translator(t, seconds, &result)) {
+		t->comp_cost = 999999;
+		return;
+	}
+
+	t->comp_cost = result.usec / seconds;
 
 	if (!t->comp_cost) {
 		t->comp_cost = 1;
@@ -914,6 +1126,34 @@ static void matrix_rebuild(int samples)
 			break;
 		}
 	}
+
+	/*
+	 * Now that the matrix is stable, record the complete pipeline for
+	 * every reachable pair so building a translation path is a single
+	 * lookup instead of a walk across the matrix for each step.
+	 */
+	for (x = 0; x < cur_max_index; x++) {
+		for (z = 0; z < cur_max_index; z++) {
+			struct translator_path *path = matrix_get(x, z);
+
+			path->num_steps = 0;
+			if (x == z || !path->step) {
+				continue;
+			}
+			for (y = x; y != z;) {
+				struct ast_translator *t = matrix_get(y, z)->step;
+
+				if (!t || path->num_steps == ARRAY_LEN(path->steps)) {
+					/* Inconsistent or absurdly long chain; leave it
+					 * to the per-step walk in build_path. */
+					path->num_steps = 0;
+					break;
+				}
+				path->steps[path->num_steps++] = t;
+				y = t->dst_fmt_index;
+			}
+		}
+	}
 }
 
 static void codec_append_name(const struct ast_codec *codec, struct ast_str **buf)
@@ -1212,8 +1452,82 @@ static char *handle_cli_core_show_translation(struct ast_cli_entry *e, int cmd,
 	return handle_show_translation_table(a);
 }
 
+static char *handle_cli_core_benchmark_codecs(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	struct ast_translator *t;
+	int seconds;
+	int benched = 0;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "core benchmark codecs";
+		e->usage =
+			"Usage: core benchmark codecs [<seconds>]\n"
+			"       Runs every registered translator over the given number of\n"
+			"       seconds of its canned sample audio (default 1), reporting\n"
+			"       achieved frames per second and per-frame latency.  The\n"
+			"       measured costs are fed back into the translation cost table\n"
+			"       and the translation matrix is rebuilt with them; multi-step\n"
+			"       path costs can then be inspected with\n"
+			"       'core show translation paths'.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc > 4) {
+		return CLI_SHOWUSAGE;
+	}
+
+	seconds = a->argv[3] ? atoi(a->argv[3]) : 1;
+	if (seconds <= 0) {
+		seconds = 1;
+	}
+	if (seconds > MAX_RECALC) {
+		ast_cli(a->fd, "Maximum limit of %d sample seconds exceeded, truncating.\n", MAX_RECALC);
+		seconds = MAX_RECALC;
+	}
+
+	ast_cli(a->fd, "Benchmarking translators over %d second(s) of sample audio each\n\n", seconds);
+	ast_cli(a->fd, "%-25s %10s %12s %12s %10s\n",
+		"Translator", "Frames", "Frames/sec", "usec/frame", "Cost");
+
+	AST_RWLIST_WRLOCK(&translators);
+	AST_RWLIST_TRAVERSE(&translators, t, list) {
+		struct translator_benchmark result;
+
+		if (!t->active || !t->sample) {
+			continue;
+		}
+		if (benchmark_translator(t, seconds, &result) || !result.frames_in) {
+			ast_cli(a->fd, "%-25s failed\n", t->name);
+			continue;
+		}
+		if (!result.usec) {
+			result.usec = 1;
+		}
+		t->comp_cost = result.usec / seconds ?: 1;
+		ast_cli(a->fd, "%-25s %10u %12.0f %12.2f %10d\n",
+			t->name,
+			result.frames_in,
+			result.frames_in * 1000000.0 / result.usec,
+			(double) result.usec / result.frames_in,
+			t->comp_cost);
+		benched++;
+	}
+	/* Re-pick translation steps using the costs just measured */
+	matrix_rebuild(0);
+	AST_RWLIST_UNLOCK(&translators);
+
+	ast_cli(a->fd, "\n%d translator(s) benchmarked.  Cost is microseconds of CPU to translate\n"
+		"one second of audio, as used by the translation matrix tie breaker.\n", benched);
+
+	return CLI_SUCCESS;
+}
+
 static struct ast_cli_entry cli_translate[] = {
-	AST_CLI_DEFINE(handle_cli_core_show_translation, "Display translation matrix")
+	AST_CLI_DEFINE(handle_cli_core_show_translation, "Display translation matrix"),
+	AST_CLI_DEFINE(handle_cli_core_benchmark_codecs, "Benchmark registered codec translators")
 };
 
 /*! \brief register codec translator */
@@ -167,6 +167,177 @@ static inline short ulaw2linear(unsigned char ulawbyte)
 }
 #endif
 
+/*!
+ * \name Block conversion kernels
+ *
+ * Whole-frame u-Law conversion.  The C versions walk the lookup tables;
+ * on x86-64 an SSSE3 kernel computes the transform arithmetically, eight
+ * samples at a time.  The SIMD kernels are only selected after being
+ * verified bit-exact against the tables over the full input domain, so
+ * table variants (ZEROTRAP, G711_NEW_ALGORITHM) safely fall back to C.
+ *
+ * @{
+ */
+
+static void ulaw_expand_block_c(short *dst, const unsigned char *src, unsigned int samples)
+{
+	while (samples--) {
+		*dst++ = AST_MULAW(*src++);
+	}
+}
+
+static void ulaw_compress_block_c(unsigned char *dst, const short *src, unsigned int samples)
+{
+	while (samples--) {
+		*dst++ = AST_LIN2MU(*src++);
+	}
+}
+
+#if defined(__x86_64__)
+/* mm_malloc.h, pulled in by immintrin.h, calls malloc() and free() directly,
+ * which astmm.h rejects.  Restore the real functions around the include. */
+#pragma push_macro("malloc")
+#pragma push_macro("free")
+#undef malloc
+#undef free
+#include <immintrin.h>
+#pragma pop_macro("free")
+#pragma pop_macro("malloc")
+
+static __attribute__((target("ssse3"))) void ulaw_expand_block_ssse3(short *dst, const unsigned char *src, unsigned int samples)
+{
+	/* (1 << e) for the per-lane mantissa scaling, selected with pshufb */
+	const __m128i pow2 = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+		0, 0, 0, 0, 0, 0, 0, 0);
+	/* Setting the high byte of each pshufb index to 0x80 zeroes the
+	 * high byte of the looked up 16 bit multiplier. */
+	const __m128i hi_zero = _mm_set1_epi16((short) 0x8000);
+	unsigned int i = 0;
+
+	for (; i + 8 <= samples; i += 8) {
+		__m128i u = _mm_unpacklo_epi8(
+			_mm_loadl_epi64((const __m128i *) (src + i)), _mm_setzero_si128());
+		/* mu = ~u; y = ((((mu & 0x0F) << 3) + 0x84) << ((mu >> 4) & 7)) - 0x84,
+		 * negated when mu has the sign bit. */
+		__m128i mu = _mm_andnot_si128(u, _mm_set1_epi16(0xFF));
+		__m128i e = _mm_and_si128(_mm_srli_epi16(mu, 4), _mm_set1_epi16(7));
+		__m128i t = _mm_add_epi16(
+			_mm_slli_epi16(_mm_and_si128(mu, _mm_set1_epi16(0x0F)), 3),
+			_mm_set1_epi16(0x84));
+		__m128i mult = _mm_shuffle_epi8(pow2, _mm_or_si128(e, hi_zero));
+		__m128i y = _mm_sub_epi16(_mm_mullo_epi16(t, mult), _mm_set1_epi16(0x84));
+		__m128i neg = _mm_cmpgt_epi16(_mm_and_si128(mu, _mm_set1_epi16(0x80)),
+			_mm_setzero_si128());
+
+		y = _mm_sub_epi16(_mm_xor_si128(y, neg), neg);
+		_mm_storeu_si128((__m128i *) (dst + i), y);
+	}
+	ulaw_expand_block_c(dst + i, src + i, samples - i);
+}
+
+static __attribute__((target("ssse3"))) void ulaw_compress_block_ssse3(unsigned char *dst, const short *src, unsigned int samples)
+{
+	/* 2^(13 - e), split into low/high bytes and selected by exponent;
+	 * multiplying with mulhi yields mag >> (e + 3). */
+	const __m128i mult_lo = _mm_setr_epi8(0, 0, 0, 0, 0, 0, -128, 64,
+		0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mult_hi = _mm_setr_epi8(32, 16, 8, 4, 2, 1, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i hi_zero = _mm_set1_epi16((short) 0x8000);
+	unsigned int i = 0;
+
+	for (; i + 8 <= samples; i += 8) {
+		/* The table is indexed by (unsigned short) sample >> 2, and each
+		 * four-sample bucket holds the encoding of its highest member, so
+		 * OR in the low bits to match AST_LIN2MU exactly. */
+		__m128i s = _mm_or_si128(
+			_mm_loadu_si128((const __m128i *) (src + i)), _mm_set1_epi16(3));
+		__m128i neg = _mm_srai_epi16(s, 15);
+		__m128i mag = _mm_sub_epi16(_mm_xor_si128(s, neg), neg);
+		__m128i e = _mm_setzero_si128();
+		__m128i idx, mult, mant, ulaw;
+
+		mag = _mm_min_epi16(mag, _mm_set1_epi16(32635));
+		mag = _mm_add_epi16(mag, _mm_set1_epi16(0x84));
+
+		/* e = how many of the thresholds 256 << k the magnitude reaches */
+		e = _mm_sub_epi16(e, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x00FF)));
+		e = _mm_sub_epi16(e, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x01FF)));
+		e = _mm_sub_epi16(e, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x03FF)));
+		e = _mm_sub_epi16(e, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x07FF)));
+		e = _mm_sub_epi16(e, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x0FFF)));
+		e = _mm_sub_epi16(e, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x1FFF)));
+		e = _mm_sub_epi16(e, _mm_cmpgt_epi16(mag, _mm_set1_epi16(0x3FFF)));
+
+		idx = _mm_or_si128(e, hi_zero);
+		mult = _mm_or_si128(_mm_shuffle_epi8(mult_lo, idx),
+			_mm_slli_epi16(_mm_shuffle_epi8(mult_hi, idx), 8));
+		mant = _mm_and_si128(_mm_mulhi_epu16(mag, mult), _mm_set1_epi16(0x0F));
+
+		ulaw = _mm_or_si128(_mm_and_si128(neg, _mm_set1_epi16(0x80)),
+			_mm_or_si128(_mm_slli_epi16(e, 4), mant));
+		ulaw = _mm_andnot_si128(ulaw, _mm_set1_epi16(0xFF));
+		_mm_storel_epi64((__m128i *) (dst + i), _mm_packus_epi16(ulaw, ulaw));
+	}
+	ulaw_compress_block_c(dst + i, src + i, samples - i);
+}
+
+/*!
+ * \internal
+ * \brief Verify the SIMD kernels against the tables over every input.
+ *
+ * \retval non-zero when bit-exact, zero when the kernels must not be used
+ */
+static int ulaw_simd_kernels_match(void)
+{
+	unsigned char codes[256];
+	unsigned char back[256];
+	short lin[256];
+	int i;
+	int block;
+
+	for (i = 0; i < 256; i++) {
+		codes[i] = i;
+	}
+	ulaw_expand_block_ssse3(lin, codes, 256);
+	for (i = 0; i < 256; i++) {
+		if (lin[i] != AST_MULAW(i)) {
+			return 0;
+		}
+	}
+
+	for (block = -32768; block < 32768; block += 256) {
+		for (i = 0; i < 256; i++) {
+			lin[i] = block + i;
+		}
+		ulaw_compress_block_ssse3(back, lin, 256);
+		for (i = 0; i < 256; i++) {
+			if (back[i] != AST_LIN2MU((short) (block + i))) {
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+#endif /* __x86_64__ */
+
+/*! Selected in ast_ulaw_init(). */
+static void (*ulaw_expand_block_impl)(short *, const unsigned char *, unsigned int) = ulaw_expand_block_c;
+static void (*ulaw_compress_block_impl)(unsigned char *, const short *, unsigned int) = ulaw_compress_block_c;
+
+void ast_ulaw_expand_block(short *dst, const unsigned char *src, unsigned int samples)
+{
+	ulaw_expand_block_impl(dst, src, samples);
+}
+
+void ast_ulaw_compress_block(unsigned char *dst, const short *src, unsigned int samples)
+{
+	ulaw_compress_block_impl(dst, src, samples);
+}
+
+/*! @} */
+
 /*!
  * \brief  Set up mu-law conversion table
  */
@@ -245,4 +416,11 @@ void ast_ulaw_init(void)
 	}
 	ast_log(LOG_NOTICE, "u-Law tandem transcoding test complete.\n");
 #endif /* TEST_TANDEM_TRANSCODING */
+
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("ssse3") && ulaw_simd_kernels_match()) {
+		ulaw_expand_block_impl = ulaw_expand_block_ssse3;
+		ulaw_compress_block_impl = ulaw_compress_block_ssse3;
+	}
+#endif
 }
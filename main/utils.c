@@ -2207,10 +2207,80 @@ void ast_format_duration_hh_mm_ss(int duration, char *buf, size_t length)
 AST_MUTEX_DEFINE_STATIC(randomlock);
 #endif
 
+/*! \brief Number of values a thread may draw before reseeding from the kernel */
+#define RANDOM_RESEED_INTERVAL (1 << 20)
+
+AST_THREADSTORAGE(random_state_storage);
+
+/*! \brief Per-thread xorshift128+ state, periodically reseeded from /dev/urandom */
+struct random_state {
+	uint64_t seed[2];
+	unsigned int remaining;
+};
+
+/*!
+ * \internal
+ * \brief Draw a random value from the calling thread's generator
+ *
+ * Random numbers are consumed on hot paths (RTP initialization, retry
+ * jitter, the dialplan RAND function), so each thread runs its own
+ * generator and only goes back to /dev/urandom to reseed. No locks, and
+ * a syscall only once per RANDOM_RESEED_INTERVAL draws.
+ *
+ * \retval 0 success
+ * \retval -1 no generator state or seed material was available
+ */
+static int random_state_next(long int *result)
+{
+	struct random_state *state;
+	uint64_t x;
+	uint64_t y;
+	long int res;
+	long int rm = RAND_MAX;
+
+	if (dev_urandom_fd < 0) {
+		return -1;
+	}
+
+	state = ast_threadstorage_get(&random_state_storage, sizeof(*state));
+	if (!state) {
+		return -1;
+	}
+
+	if (!state->remaining) {
+		if (read(dev_urandom_fd, state->seed, sizeof(state->seed)) != sizeof(state->seed)) {
+			return -1;
+		}
+		/* xorshift128+ requires a nonzero state */
+		if (!state->seed[0] && !state->seed[1]) {
+			state->seed[0] = 1;
+		}
+		state->remaining = RANDOM_RESEED_INTERVAL;
+	}
+
+	x = state->seed[0];
+	y = state->seed[1];
+	state->seed[0] = y;
+	x ^= x << 23;
+	state->seed[1] = x ^ y ^ (x >> 17) ^ (y >> 26);
+	state->remaining--;
+
+	res = (long int) (state->seed[1] + y);
+	res = res < 0 ? ~res : res;
+	rm++;
+	*result = res % rm;
+
+	return 0;
+}
+
 long int ast_random(void)
 {
 	long int res;
 
+	if (!random_state_next(&res)) {
+		return res;
+	}
+
 	if (dev_urandom_fd >= 0) {
 		int read_res = read(dev_urandom_fd, &res, sizeof(res));
 		if (read_res > 0) {
@@ -2503,6 +2573,154 @@ int ast_safe_mkdir(const char *base_path, const char *path, int mode)
 	return safe_mkdir(absolute_base_path, p, mode);
 }
 
+/*!
+ * \name Vectorized slinear mixing kernels
+ *
+ * Runtime-dispatched block forms of ast_slinear_saturated_add() and
+ * ast_slinear_saturated_subtract().  The packed saturated 16-bit
+ * add/subtract instructions map directly onto these loops, and the
+ * conference mixing inner loop spends most of its time here.
+ *
+ * @{
+ */
+
+static void slinear_saturated_add_block_c(short *input, const short *value, unsigned int samples)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < samples; idx++) {
+		ast_slinear_saturated_add(input + idx, (short *) value + idx);
+	}
+}
+
+static void slinear_saturated_subtract_block_c(short *input, const short *value, unsigned int samples)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < samples; idx++) {
+		ast_slinear_saturated_subtract(input + idx, (short *) value + idx);
+	}
+}
+
+#if defined(__x86_64__)
+/* mm_malloc.h, pulled in by immintrin.h, calls malloc() and free() directly,
+ * which astmm.h rejects.  Restore the real functions around the include. */
+#pragma push_macro("malloc")
+#pragma push_macro("free")
+#undef malloc
+#undef free
+#include <immintrin.h>
+#pragma pop_macro("free")
+#pragma pop_macro("malloc")
+
+static void slinear_saturated_add_block_sse2(short *input, const short *value, unsigned int samples)
+{
+	unsigned int idx = 0;
+
+	for (; idx + 8 <= samples; idx += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (input + idx));
+		__m128i b = _mm_loadu_si128((const __m128i *) (value + idx));
+
+		_mm_storeu_si128((__m128i *) (input + idx), _mm_adds_epi16(a, b));
+	}
+	slinear_saturated_add_block_c(input + idx, value + idx, samples - idx);
+}
+
+static void slinear_saturated_subtract_block_sse2(short *input, const short *value, unsigned int samples)
+{
+	unsigned int idx = 0;
+
+	for (; idx + 8 <= samples; idx += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (input + idx));
+		__m128i b = _mm_loadu_si128((const __m128i *) (value + idx));
+
+		_mm_storeu_si128((__m128i *) (input + idx), _mm_subs_epi16(a, b));
+	}
+	slinear_saturated_subtract_block_c(input + idx, value + idx, samples - idx);
+}
+
+static __attribute__((target("avx2"))) void slinear_saturated_add_block_avx2(short *input, const short *value, unsigned int samples)
+{
+	unsigned int idx = 0;
+
+	for (; idx + 16 <= samples; idx += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) (input + idx));
+		__m256i b = _mm256_loadu_si256((const __m256i *) (value + idx));
+
+		_mm256_storeu_si256((__m256i *) (input + idx), _mm256_adds_epi16(a, b));
+	}
+	slinear_saturated_add_block_sse2(input + idx, value + idx, samples - idx);
+}
+
+static __attribute__((target("avx2"))) void slinear_saturated_subtract_block_avx2(short *input, const short *value, unsigned int samples)
+{
+	unsigned int idx = 0;
+
+	for (; idx + 16 <= samples; idx += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) (input + idx));
+		__m256i b = _mm256_loadu_si256((const __m256i *) (value + idx));
+
+		_mm256_storeu_si256((__m256i *) (input + idx), _mm256_subs_epi16(a, b));
+	}
+	slinear_saturated_subtract_block_sse2(input + idx, value + idx, samples - idx);
+}
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+
+static void slinear_saturated_add_block_neon(short *input, const short *value, unsigned int samples)
+{
+	unsigned int idx = 0;
+
+	for (; idx + 8 <= samples; idx += 8) {
+		vst1q_s16(input + idx, vqaddq_s16(vld1q_s16(input + idx), vld1q_s16(value + idx)));
+	}
+	slinear_saturated_add_block_c(input + idx, value + idx, samples - idx);
+}
+
+static void slinear_saturated_subtract_block_neon(short *input, const short *value, unsigned int samples)
+{
+	unsigned int idx = 0;
+
+	for (; idx + 8 <= samples; idx += 8) {
+		vst1q_s16(input + idx, vqsubq_s16(vld1q_s16(input + idx), vld1q_s16(value + idx)));
+	}
+	slinear_saturated_subtract_block_c(input + idx, value + idx, samples - idx);
+}
+#endif
+
+/*! Selected once at startup in ast_utils_init(). */
+static void (*slinear_saturated_add_block_impl)(short *, const short *, unsigned int) = slinear_saturated_add_block_c;
+static void (*slinear_saturated_subtract_block_impl)(short *, const short *, unsigned int) = slinear_saturated_subtract_block_c;
+
+static void slinear_block_kernels_init(void)
+{
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("avx2")) {
+		slinear_saturated_add_block_impl = slinear_saturated_add_block_avx2;
+		slinear_saturated_subtract_block_impl = slinear_saturated_subtract_block_avx2;
+	} else {
+		/* SSE2 is part of the x86-64 baseline. */
+		slinear_saturated_add_block_impl = slinear_saturated_add_block_sse2;
+		slinear_saturated_subtract_block_impl = slinear_saturated_subtract_block_sse2;
+	}
+#elif defined(__ARM_NEON)
+	slinear_saturated_add_block_impl = slinear_saturated_add_block_neon;
+	slinear_saturated_subtract_block_impl = slinear_saturated_subtract_block_neon;
+#endif
+}
+
+void ast_slinear_saturated_add_block(short *input, const short *value, unsigned int samples)
+{
+	slinear_saturated_add_block_impl(input, value, samples);
+}
+
+void ast_slinear_saturated_subtract_block(short *input, const short *value, unsigned int samples)
+{
+	slinear_saturated_subtract_block_impl(input, value, samples);
+}
+
+/*! @} */
+
 static void utils_shutdown(void)
 {
 	close(dev_urandom_fd);
@@ -2516,6 +2734,7 @@ int ast_utils_init(void)
 {
 	dev_urandom_fd = open("/dev/urandom", O_RDONLY);
 	base64_init();
+	slinear_block_kernels_init();
 #ifdef DEBUG_THREADS
 #if !defined(LOW_MEMORY)
 	ast_cli_register_multiple(utils_cli, ARRAY_LEN(utils_cli));
@@ -31,15 +31,106 @@
 #include "asterisk/strings.h"
 #include "asterisk/logger.h"
 #include "asterisk/lock.h"
+#include "asterisk/threadstorage.h"
 
 AST_MUTEX_DEFINE_STATIC(uuid_lock);
 
+AST_THREADSTORAGE(uuid_thread_state);
+
 static int has_dev_urandom;
 
 struct ast_uuid {
 	uuid_t uu;
 };
 
+/*! \brief Per-thread xorshift128+ state, seeded once from the kernel */
+struct uuid_state {
+	uint64_t seed[2];
+	unsigned int seeded:1;
+};
+
+/*!
+ * \internal
+ * \brief Seed a thread's UUID generator state from /dev/urandom
+ *
+ * \retval 0 success
+ * \retval -1 the kernel entropy could not be read
+ */
+static int uuid_state_seed(struct uuid_state *state)
+{
+	int fd;
+	ssize_t len;
+
+	fd = open("/dev/urandom", O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	len = read(fd, state->seed, sizeof(state->seed));
+	close(fd);
+	if (len != sizeof(state->seed)) {
+		return -1;
+	}
+
+	/* xorshift128+ requires a nonzero state */
+	if (!state->seed[0] && !state->seed[1]) {
+		state->seed[0] = 1;
+	}
+
+	state->seeded = 1;
+
+	return 0;
+}
+
+static uint64_t uuid_state_next(struct uuid_state *state)
+{
+	uint64_t x = state->seed[0];
+	uint64_t y = state->seed[1];
+
+	state->seed[0] = y;
+	x ^= x << 23;
+	state->seed[1] = x ^ y ^ (x >> 17) ^ (y >> 26);
+
+	return state->seed[1] + y;
+}
+
+/*!
+ * \internal
+ * \brief Generate a version 4 UUID without locks or syscalls
+ *
+ * libuuid can go back to the random pool on every generated UUID, and
+ * UUIDs are requested several times per call setup. This fills the UUID
+ * from a per-thread generator instead, which costs one read of
+ * /dev/urandom per thread lifetime.
+ *
+ * \retval 0 success
+ * \retval -1 no seed material was available; use libuuid instead
+ */
+static int generate_uuid_fast(struct ast_uuid *uuid)
+{
+	struct uuid_state *state;
+	uint64_t value;
+
+	if (!has_dev_urandom) {
+		return -1;
+	}
+
+	state = ast_threadstorage_get(&uuid_thread_state, sizeof(*state));
+	if (!state || (!state->seeded && uuid_state_seed(state))) {
+		return -1;
+	}
+
+	value = uuid_state_next(state);
+	memcpy(&uuid->uu[0], &value, sizeof(value));
+	value = uuid_state_next(state);
+	memcpy(&uuid->uu[8], &value, sizeof(value));
+
+	/* Stamp the RFC 4122 version (4, random) and variant bits */
+	uuid->uu[6] = (uuid->uu[6] & 0x0f) | 0x40;
+	uuid->uu[8] = (uuid->uu[8] & 0x3f) | 0x80;
+
+	return 0;
+}
+
 /*!
  * \internal
  * \brief Generate a UUID.
@@ -107,6 +198,10 @@ static void generate_uuid(struct ast_uuid *uuid)
 	 * or /dev/urandom not existing on systems in this age is next to none.
 	 */
 
+	if (!generate_uuid_fast(uuid)) {
+		return;
+	}
+
 	/* XXX Currently, we only protect this call if the user has no /dev/urandom on their system.
 	 * If it turns out that there are issues with UUID generation despite the presence of
 	 * /dev/urandom, then we may need to make the locking/unlocking unconditional.
@@ -69,6 +69,7 @@
 #include "asterisk/netsock2.h"
 #include "asterisk/crypto.h"
 #include "asterisk/astdb.h"
+#include "asterisk/astobj2.h"
 #include "asterisk/acl.h"
 #include "asterisk/app.h"
 
@@ -163,6 +164,14 @@
 /*! Keep times of last 10 lookups */
 #define DUNDI_TIMING_HISTORY	10
 
+/*! Maximum number of cache entries kept in memory in front of astdb */
+#define DUNDI_MEMCACHE_MAXSIZE	1024
+
+#define DUNDI_MEMCACHE_BUCKETS	53
+
+/*! Maximum number of precache queries serviced concurrently */
+#define DUNDI_PRECACHE_CONCURRENCY	4
+
 enum {
 	FLAG_ISREG =       (1 << 0),  /*!< Transaction is register request */
 	FLAG_DEAD =        (1 << 1),  /*!< Transaction is dead */
@@ -212,6 +221,12 @@ static time_t rotatetime;
 static dundi_eid empty_eid = { { 0, 0, 0, 0, 0, 0 } };
 static int dundi_shutdown = 0;
 
+static struct ao2_container *dundi_memcache;
+
+AST_MUTEX_DEFINE_STATIC(precache_batch_lock);
+static ast_cond_t precache_batch_cond;
+static int precache_batch_running = 0;
+
 struct permission {
 	AST_LIST_ENTRY(permission) list;
 	int allow;
@@ -861,6 +876,122 @@ static int dundi_answer_entity(struct dundi_transaction *trans, struct dundi_ies
 	return 0;
 }
 
+/*!
+ * \internal
+ * \brief In-memory front for the "dundi/cache" astdb family.
+ *
+ * A busy mesh hits the same handful of cache keys on every call setup and
+ * each astdb round trip costs a database query (a single cache_lookup() is
+ * at least three).  Keep a bounded, LRU-evicted copy of the hot entries in
+ * memory and fall through to astdb, which remains the authoritative store,
+ * only on a miss.  Values are kept byte for byte as stored in astdb so the
+ * parsing in cache_lookup_internal() is oblivious to where they came from.
+ */
+struct dundi_cache_entry {
+	time_t expiration;   /*!< Mirrors the timeout encoded in the value */
+	time_t used;         /*!< Last read, for LRU eviction */
+	char *value;         /*!< Value exactly as stored in astdb */
+	char key[0];
+};
+
+static void dundi_cache_entry_destroy(void *obj)
+{
+	struct dundi_cache_entry *entry = obj;
+
+	ast_free(entry->value);
+}
+
+AO2_STRING_FIELD_HASH_FN(dundi_cache_entry, key)
+AO2_STRING_FIELD_SORT_FN(dundi_cache_entry, key)
+
+/*!
+ * \internal
+ * \brief Drop the least recently read entry to make room.
+ */
+static void dundi_memcache_evict(void)
+{
+	struct ao2_iterator i;
+	struct dundi_cache_entry *entry;
+	struct dundi_cache_entry *oldest = NULL;
+
+	i = ao2_iterator_init(dundi_memcache, 0);
+	while ((entry = ao2_iterator_next(&i))) {
+		if (!oldest || entry->used < oldest->used) {
+			ao2_replace(oldest, entry);
+		}
+		ao2_ref(entry, -1);
+	}
+	ao2_iterator_destroy(&i);
+	if (oldest) {
+		ao2_unlink(dundi_memcache, oldest);
+		ao2_ref(oldest, -1);
+	}
+}
+
+static void dundi_memcache_insert(const char *key, const char *value)
+{
+	struct dundi_cache_entry *entry;
+	time_t timeout;
+
+	if (!dundi_memcache || ast_get_time_t(value, &timeout, 0, NULL)) {
+		return;
+	}
+	if (!(entry = ao2_alloc(sizeof(*entry) + strlen(key) + 1, dundi_cache_entry_destroy))) {
+		return;
+	}
+	strcpy(entry->key, key); /* Safe */
+	if (!(entry->value = ast_strdup(value))) {
+		ao2_ref(entry, -1);
+		return;
+	}
+	entry->expiration = timeout;
+	time(&entry->used);
+	ao2_link(dundi_memcache, entry);
+	ao2_ref(entry, -1);
+	if (ao2_container_count(dundi_memcache) > DUNDI_MEMCACHE_MAXSIZE) {
+		dundi_memcache_evict();
+	}
+}
+
+static int dundi_cache_put(const char *key, const char *value)
+{
+	dundi_memcache_insert(key, value);
+	return ast_db_put("dundi/cache", key, value);
+}
+
+static int dundi_cache_get(const char *key, char *buf, int length)
+{
+	struct dundi_cache_entry *entry;
+	time_t now;
+
+	time(&now);
+	if (dundi_memcache && (entry = ao2_find(dundi_memcache, key, OBJ_SEARCH_KEY))) {
+		if (entry->expiration > now) {
+			/* Unsynchronized stamp update; a stale LRU ordering is harmless */
+			entry->used = now;
+			ast_copy_string(buf, entry->value, length);
+			ao2_ref(entry, -1);
+			return 0;
+		}
+		ao2_unlink(dundi_memcache, entry);
+		ao2_ref(entry, -1);
+	}
+	if (ast_db_get("dundi/cache", key, buf, length)) {
+		return -1;
+	}
+	/* Promote the astdb hit so repeat lookups stay in memory */
+	dundi_memcache_insert(key, buf);
+	return 0;
+}
+
+static int dundi_cache_del(const char *key)
+{
+	if (dundi_memcache) {
+		ao2_find(dundi_memcache, key, OBJ_SEARCH_KEY | OBJ_UNLINK | OBJ_NODATA);
+	}
+	return ast_db_del("dundi/cache", key);
+}
+
 static int cache_save_hint(dundi_eid *eidpeer, struct dundi_request *req, struct dundi_hint *hint, int expiration)
 {
 	int unaffected;
@@ -889,9 +1020,9 @@ static int cache_save_hint(dundi_eid *eidpeer, struct dundi_request *req, struct
 	timeout += expiration;
 	snprintf(data, sizeof(data), "%ld|", (long)(timeout));
 
-	ast_db_put("dundi/cache", key1, data);
+	dundi_cache_put(key1, data);
 	ast_debug(1, "Caching hint at '%s'\n", key1);
-	ast_db_put("dundi/cache", key2, data);
+	dundi_cache_put(key2, data);
 	ast_debug(1, "Caching hint at '%s'\n", key2);
 	return 0;
 }
@@ -932,8 +1063,8 @@ static int cache_save(dundi_eid *eidpeer, struct dundi_request *req, int start,
 			req->dr[x].flags, req->dr[x].weight, req->dr[x].techint, req->dr[x].dest,
 			dundi_eid_to_str_short(eidpeer_str, sizeof(eidpeer_str), &req->dr[x].eid));
 	}
-	ast_db_put("dundi/cache", key1, data);
-	ast_db_put("dundi/cache", key2, data);
+	dundi_cache_put(key1, data);
+	dundi_cache_put(key2, data);
 	return 0;
 }
 
@@ -1179,7 +1310,7 @@ static int cache_lookup_internal(time_t now, struct dundi_request *req, char *ke
 	char fs[256];
 
 	/* Build request string */
-	if (!ast_db_get("dundi/cache", key, data, sizeof(data))) {
+	if (!dundi_cache_get(key, data, sizeof(data))) {
 		time_t timeout;
 		ptr = data;
 		if (!ast_get_time_t(ptr, &timeout, 0, &length)) {
@@ -1231,9 +1362,9 @@ static int cache_lookup_internal(time_t now, struct dundi_request *req, char *ke
 					*lowexpiration = expiration;
 				return 1;
 			} else
-				ast_db_del("dundi/cache", key);
+				dundi_cache_del(key);
 		} else
-			ast_db_del("dundi/cache", key);
+			dundi_cache_del(key);
 	}
 
 	return 0;
@@ -2243,7 +2374,7 @@ static void *process_clearcache(void *ignore)
 			if (!ast_get_time_t(db_entry->data, &expiry, 0, NULL)) {
 				if (expiry < now) {
 					ast_debug(1, "clearing expired DUNDI cache entry: %s\n", db_entry->key);
-					ast_db_del("dundi/cache", db_entry->key + striplen);
+					dundi_cache_del(db_entry->key + striplen);
 				}
 			}
 		}
@@ -2258,38 +2389,84 @@ static void *process_clearcache(void *ignore)
 	return NULL;
 }
 
+/*!
+ * \internal
+ * \brief Run one precache query and retire a batch slot.
+ */
+static void *dundi_precache_job(void *data)
+{
+	struct dundi_precache_queue *qe = data;
+
+	dundi_precache(qe->context, qe->number);
+	ast_free(qe);
+
+	ast_mutex_lock(&precache_batch_lock);
+	precache_batch_running--;
+	ast_cond_signal(&precache_batch_cond);
+	ast_mutex_unlock(&precache_batch_lock);
+
+	return NULL;
+}
+
 static void *process_precache(void *ign)
 {
 	struct dundi_precache_queue *qe;
+	AST_LIST_HEAD_NOLOCK(, dundi_precache_queue) batch;
 	time_t now;
-	char context[256];
-	char number[256];
-	int run;
+	int avail;
 
 	while (!dundi_shutdown) {
 		time(&now);
-		run = 0;
+		AST_LIST_HEAD_INIT_NOLOCK(&batch);
+
+		ast_mutex_lock(&precache_batch_lock);
+		avail = DUNDI_PRECACHE_CONCURRENCY - precache_batch_running;
+		ast_mutex_unlock(&precache_batch_lock);
+
+		/* Each query blocks on network round trips, so pull every entry
+		 * that is due, up to the concurrency limit, and fan them out to
+		 * their own threads rather than working through them serially. */
 		AST_LIST_LOCK(&pcq);
-		if ((qe = AST_LIST_FIRST(&pcq))) {
+		while (avail > 0 && (qe = AST_LIST_FIRST(&pcq))) {
 			if (!qe->expiration) {
 				/* Gone...  Remove... */
 				AST_LIST_REMOVE_HEAD(&pcq, list);
 				ast_free(qe);
-			} else if (qe->expiration < now) {
-				/* Process this entry */
-				qe->expiration = 0;
-				ast_copy_string(context, qe->context, sizeof(context));
-				ast_copy_string(number, qe->number, sizeof(number));
-				run = 1;
+				continue;
 			}
+			if (qe->expiration >= now) {
+				break;
+			}
+			AST_LIST_REMOVE_HEAD(&pcq, list);
+			AST_LIST_INSERT_TAIL(&batch, qe, list);
+			avail--;
 		}
 		AST_LIST_UNLOCK(&pcq);
-		if (run) {
-			dundi_precache(context, number);
-		} else
+
+		if (AST_LIST_EMPTY(&batch)) {
 			sleep(1);
+			continue;
+		}
+		while ((qe = AST_LIST_REMOVE_HEAD(&batch, list))) {
+			pthread_t dont_care;
+
+			ast_mutex_lock(&precache_batch_lock);
+			precache_batch_running++;
+			ast_mutex_unlock(&precache_batch_lock);
+			if (ast_pthread_create_detached_background(&dont_care, NULL, dundi_precache_job, qe)) {
+				/* Out of threads; do the work here so the entry is not lost */
+				dundi_precache_job(qe);
+			}
+		}
 	}
 
+	/* Let any outstanding queries land before we go away */
+	ast_mutex_lock(&precache_batch_lock);
+	while (precache_batch_running) {
+		ast_cond_wait(&precache_batch_cond, &precache_batch_lock);
+	}
+	ast_mutex_unlock(&precache_batch_lock);
+
 	return NULL;
 }
 
@@ -5122,6 +5299,10 @@ static int unload_module(void)
 		clearcachethreadid = AST_PTHREADT_NULL;
  	}
 
+	ao2_cleanup(dundi_memcache);
+	dundi_memcache = NULL;
+	ast_cond_destroy(&precache_batch_cond);
+
 	if (netsocket >= 0) {
 		close(netsocket);
 	}
@@ -5174,6 +5355,13 @@ static int load_module(void)
 	dundi_set_output(dundi_debug_output);
 	dundi_set_error(dundi_error_output);
 
+	ast_cond_init(&precache_batch_cond, NULL);
+
+	/* The module runs without the in-memory cache; astdb just gets hit harder */
+	dundi_memcache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, DUNDI_MEMCACHE_BUCKETS,
+		dundi_cache_entry_hash_fn, dundi_cache_entry_sort_fn, NULL);
+
 	/* Make a UDP socket */
 	io = io_context_create();
 	sched = ast_sched_context_create();
@@ -58,6 +58,18 @@
 
 #define EXT_DATA_SIZE 256
 
+/*! \brief How long a cached lookup result may be served, in milliseconds */
+#define CACHE_TTL_MS 1000
+
+/*!
+ * \brief How long a cached miss may be served, in milliseconds.
+ *
+ * Misses are cached so that repeated dials of nonexistent numbers do not
+ * each query the backend.  The window also delays how soon a newly
+ * provisioned extension becomes visible after a miss, so keep it short.
+ */
+#define NEGATIVE_CACHE_TTL_MS 5000
+
 enum option_flags {
 	OPTION_PATTERNS_DISABLED = (1 << 0),
 };
@@ -118,7 +130,8 @@ static int purge_old_fn(void *obj, void *arg, int flags)
 {
 	struct cache_entry *e = obj;
 	struct timeval *now = arg;
-	return ast_tvdiff_ms(*now, e->when) >= 1000 ? CMP_MATCH : 0;
+	int ttl = e->var ? CACHE_TTL_MS : NEGATIVE_CACHE_TTL_MS;
+	return ast_tvdiff_ms(*now, e->when) >= ttl ? CMP_MATCH : 0;
 }
 
 static void *cleanup(void *unused)
@@ -260,12 +273,16 @@ static struct ast_variable *realtime_common(const char *context, const char *ext
 	} else {
 		var = realtime_switch_common(table, ctx, exten, priority, mode, flags);
 		do {
-			struct ast_variable *new;
-			/* Only cache matches */
+			struct ast_variable *new = NULL;
+
+			/* Only cache exact match lookups.  A miss is cached too
+			 * (as an entry with no variables) so that repeated dials
+			 * of a nonexistent number are answered from memory until
+			 * the negative TTL expires. */
 			if (mode != MODE_MATCH) {
 				break;
 			}
-			if (!(new = dup_vars(var))) {
+			if (var && !(new = dup_vars(var))) {
 				break;
 			}
 			if (!(ce = ao2_alloc(sizeof(*ce) + strlen(exten) + strlen(context), free_entry))) {
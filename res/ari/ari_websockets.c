@@ -155,11 +155,10 @@ struct ast_json *ast_ari_websocket_session_read(
 	"  \"message\": \"Message validation failed\""	\
 	"}"
 
-int ast_ari_websocket_session_write(struct ast_ari_websocket_session *session,
-	struct ast_json *message)
+int ast_ari_websocket_session_write_serialized(
+	struct ast_ari_websocket_session *session, struct ast_json *message,
+	const char *str)
 {
-	RAII_VAR(char *, str, NULL, ast_json_free);
-
 #ifdef AST_DEVMODE
 	if (!session->validator(message)) {
 		ast_log(LOG_ERROR, "Outgoing message failed validation\n");
@@ -167,6 +166,19 @@ int ast_ari_websocket_session_write(struct ast_ari_websocket_session *session,
 	}
 #endif
 
+	if (ast_websocket_write_string(session->ws_session, str)) {
+		ast_log(LOG_NOTICE, "Problem occurred during websocket write to %s, websocket closed\n",
+			ast_sockaddr_stringify(ast_ari_websocket_session_get_remote_addr(session)));
+		return -1;
+	}
+	return 0;
+}
+
+int ast_ari_websocket_session_write(struct ast_ari_websocket_session *session,
+	struct ast_json *message)
+{
+	RAII_VAR(char *, str, NULL, ast_json_free);
+
 	str = ast_json_dump_string_format(message, ast_ari_json_format());
 
 	if (str == NULL) {
@@ -174,12 +186,7 @@ int ast_ari_websocket_session_write(struct ast_ari_websocket_session *session,
 		return -1;
 	}
 
-	if (ast_websocket_write_string(session->ws_session, str)) {
-		ast_log(LOG_NOTICE, "Problem occurred during websocket write to %s, websocket closed\n",
-			ast_sockaddr_stringify(ast_ari_websocket_session_get_remote_addr(session)));
-		return -1;
-	}
-	return 0;
+	return ast_ari_websocket_session_write_serialized(session, message, str);
 }
 
 struct ast_sockaddr *ast_ari_websocket_session_get_remote_addr(
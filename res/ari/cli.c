@@ -421,6 +421,49 @@ static char *ari_set_debug(struct ast_cli_entry *e, int cmd, struct ast_cli_args
 	return CLI_SUCCESS;
 }
 
+static char *ari_set_talk_coalesce(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	void *app;
+	unsigned int window_ms;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "ari set talk-coalesce";
+		e->usage =
+			"Usage: ari set talk-coalesce <application> <window_ms>\n"
+			"       Set the window, in milliseconds, over which channel talking\n"
+			"       transitions are coalesced before delivery to an application.\n"
+			"       A window of 0 delivers every transition.\n"
+			;
+		return NULL;
+	case CLI_GENERATE:
+		return complete_ari_app(a, 1);
+	default:
+		break;
+	}
+
+	if (a->argc != 5) {
+		return CLI_SHOWUSAGE;
+	}
+
+	if (sscanf(a->argv[4], "%30u", &window_ms) != 1) {
+		return CLI_SHOWUSAGE;
+	}
+
+	app = stasis_app_get_by_name(a->argv[3]);
+	if (!app) {
+		return CLI_FAILURE;
+	}
+
+	stasis_app_set_talk_coalesce(app, window_ms);
+	ast_cli(a->fd, "Talk coalescing window on '%s' set to %u ms\n",
+		stasis_app_name(app), window_ms);
+
+	ao2_ref(app, -1);
+
+	return CLI_SUCCESS;
+}
+
 static struct ast_cli_entry cli_ari[] = {
 	AST_CLI_DEFINE(ari_show, "Show ARI settings"),
 	AST_CLI_DEFINE(ari_show_users, "List ARI users"),
@@ -429,6 +472,7 @@ static struct ast_cli_entry cli_ari[] = {
 	AST_CLI_DEFINE(ari_show_apps, "List registered ARI applications"),
 	AST_CLI_DEFINE(ari_show_app, "Display details of a registered ARI application"),
 	AST_CLI_DEFINE(ari_set_debug, "Enable/disable debugging of an ARI application"),
+	AST_CLI_DEFINE(ari_set_talk_coalesce, "Set the talking event coalescing window of an ARI application"),
 };
 
 int ast_ari_cli_register(void) {
@@ -167,6 +167,97 @@ static struct aco_type user_option = {
 
 static struct aco_type *global_user[] = ACO_TYPES(&user_option);
 
+/*! \brief Destructor for \ref ast_ari_conf_outbound_websocket */
+static void outbound_websocket_dtor(void *obj)
+{
+	struct ast_ari_conf_outbound_websocket *outbound = obj;
+
+	ast_debug(3, "Disposing of outbound websocket %s\n", outbound->name);
+	ast_string_field_free_memory(outbound);
+	ast_free(outbound->name);
+}
+
+/*! \brief Allocate an \ref ast_ari_conf_outbound_websocket for config parsing */
+static void *outbound_websocket_alloc(const char *cat)
+{
+	RAII_VAR(struct ast_ari_conf_outbound_websocket *, outbound, NULL, ao2_cleanup);
+
+	if (!cat) {
+		return NULL;
+	}
+
+	ast_debug(3, "Allocating outbound websocket %s\n", cat);
+
+	outbound = ao2_alloc_options(sizeof(*outbound), outbound_websocket_dtor,
+		AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!outbound) {
+		return NULL;
+	}
+
+	if (ast_string_field_init(outbound, 64)) {
+		return NULL;
+	}
+
+	outbound->name = ast_strdup(cat);
+	if (!outbound->name) {
+		return NULL;
+	}
+
+	ao2_ref(outbound, +1);
+	return outbound;
+}
+
+/*! \brief Sorting function for use with red/black tree */
+static int outbound_websocket_sort_cmp(const void *obj_left, const void *obj_right, int flags)
+{
+	const struct ast_ari_conf_outbound_websocket *outbound_left = obj_left;
+	const struct ast_ari_conf_outbound_websocket *outbound_right = obj_right;
+	const char *key_right = obj_right;
+	int cmp;
+
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_OBJECT:
+		key_right = outbound_right->name;
+		/* Fall through */
+	case OBJ_SEARCH_KEY:
+		cmp = strcasecmp(outbound_left->name, key_right);
+		break;
+	case OBJ_SEARCH_PARTIAL_KEY:
+		cmp = strncasecmp(outbound_left->name, key_right, strlen(key_right));
+		break;
+	default:
+		/* Sort can only work on something with a full or partial key. */
+		ast_assert(0);
+		cmp = 0;
+		break;
+	}
+	return cmp;
+}
+
+/*! \brief \ref aco_type item_find function */
+static void *outbound_websocket_find(struct ao2_container *tmp_container, const char *cat)
+{
+	if (!cat) {
+		return NULL;
+	}
+
+	return ao2_find(tmp_container, cat, OBJ_SEARCH_KEY);
+}
+
+static struct aco_type outbound_websocket_option = {
+	.type = ACO_ITEM,
+	.name = "outbound_websocket",
+	.category_match = ACO_BLACKLIST_EXACT,
+	.category = "general",
+	.matchfield = "type",
+	.matchvalue = "outbound_websocket",
+	.item_alloc = outbound_websocket_alloc,
+	.item_find = outbound_websocket_find,
+	.item_offset = offsetof(struct ast_ari_conf, outbound_websockets),
+};
+
+static struct aco_type *global_outbound_websocket[] = ACO_TYPES(&outbound_websocket_option);
+
 static void conf_general_dtor(void *obj)
 {
 	struct ast_ari_conf_general *general = obj;
@@ -181,6 +272,7 @@ static void conf_destructor(void *obj)
 
 	ao2_cleanup(cfg->general);
 	ao2_cleanup(cfg->users);
+	ao2_cleanup(cfg->outbound_websockets);
 }
 
 /*! \brief Allocate an \ref ast_ari_conf for config parsing */
@@ -200,7 +292,11 @@ static void *conf_alloc(void)
 	cfg->users = ao2_container_alloc_rbtree(AO2_ALLOC_OPT_LOCK_NOLOCK,
 		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, user_sort_cmp, NULL);
 
+	cfg->outbound_websockets = ao2_container_alloc_rbtree(AO2_ALLOC_OPT_LOCK_NOLOCK,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, outbound_websocket_sort_cmp, NULL);
+
 	if (!cfg->users
+		|| !cfg->outbound_websockets
 		|| !cfg->general
 		|| ast_string_field_init(cfg->general, 64)
 		|| aco_set_defaults(&general_option, "general", cfg->general)) {
@@ -218,7 +314,7 @@ static struct aco_file conf_file = {
 	/*! The config file name. */
 	.filename = CONF_FILENAME,
 	/*! The mapping object types to be processed. */
-	.types = ACO_TYPES(&general_option, &user_option),
+	.types = ACO_TYPES(&general_option, &user_option, &outbound_websocket_option),
 };
 
 CONFIG_INFO_STANDARD(cfg_info, confs, conf_alloc,
@@ -275,6 +371,19 @@ struct ast_ari_conf_user *ast_ari_config_validate_user(const char *username,
 	return user;
 }
 
+/*! \brief Callback to validate an outbound websocket object */
+static int validate_outbound_websocket_cb(void *obj, void *arg, int flags)
+{
+	struct ast_ari_conf_outbound_websocket *outbound = obj;
+
+	if (ast_strlen_zero(outbound->uri) || ast_strlen_zero(outbound->app)) {
+		ast_log(LOG_WARNING, "Outbound websocket '%s' missing uri or app; connection disabled\n",
+			outbound->name);
+	}
+
+	return 0;
+}
+
 /*! \brief Callback to validate a user object */
 static int validate_user_cb(void *obj, void *arg, int flags)
 {
@@ -313,6 +422,9 @@ static int process_config(int reload)
 		} else {
 			ao2_callback(conf->users, OBJ_NODATA, validate_user_cb, NULL);
 		}
+
+		ao2_callback(conf->outbound_websockets, OBJ_NODATA,
+			validate_outbound_websocket_cb, NULL);
 	}
 
 	return 0;
@@ -372,6 +484,24 @@ int ast_ari_config_init(void)
 	aco_option_register_custom(&cfg_info, "password_format", ACO_EXACT,
 		global_user, "plain",  password_format_handler, 0);
 
+	/* ARI type=outbound_websocket category options */
+	aco_option_register(&cfg_info, "type", ACO_EXACT, global_outbound_websocket,
+		NULL, OPT_NOOP_T, 0, 0);
+	aco_option_register(&cfg_info, "uri", ACO_EXACT, global_outbound_websocket,
+		"", OPT_STRINGFIELD_T, 0,
+		STRFLDSET(struct ast_ari_conf_outbound_websocket, uri));
+	aco_option_register(&cfg_info, "app", ACO_EXACT, global_outbound_websocket,
+		"", OPT_STRINGFIELD_T, 0,
+		STRFLDSET(struct ast_ari_conf_outbound_websocket, app));
+	aco_option_register(&cfg_info, "reconnect_interval", ACO_EXACT,
+		global_outbound_websocket, "5", OPT_INT_T, PARSE_IN_RANGE,
+		FLDSET(struct ast_ari_conf_outbound_websocket, reconnect_interval),
+		1, INT_MAX);
+	aco_option_register(&cfg_info, "spool_limit", ACO_EXACT,
+		global_outbound_websocket, "1000", OPT_INT_T, PARSE_IN_RANGE,
+		FLDSET(struct ast_ari_conf_outbound_websocket, spool_limit),
+		1, INT_MAX);
+
 	return process_config(0);
 }
 
@@ -56,6 +56,8 @@ struct ast_ari_conf {
 	struct ast_ari_conf_general *general;
 	/*! Configured users */
 	struct ao2_container *users;
+	/*! Configured outbound websocket connections */
+	struct ao2_container *outbound_websockets;
 };
 
 /*! Max length for auth_realm field */
@@ -104,6 +106,22 @@ struct ast_ari_conf_user {
 	int read_only;
 };
 
+/*! \brief Per-connection configuration for an outbound websocket */
+struct ast_ari_conf_outbound_websocket {
+	/*! Name of the config category */
+	char *name;
+	/*! Seconds between reconnection attempts */
+	int reconnect_interval;
+	/*! Maximum number of events spooled while disconnected */
+	int spool_limit;
+	AST_DECLARE_STRING_FIELDS(
+		/*! ws:// or wss:// URI of the application */
+		AST_STRING_FIELD(uri);
+		/*! Stasis application served by the connection */
+		AST_STRING_FIELD(app);
+	);
+};
+
 /*!
  * \brief Initialize the ARI configuration
  */
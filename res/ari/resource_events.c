@@ -30,9 +30,12 @@
 #include "asterisk.h"
 
 #include "resource_events.h"
+#include "internal.h"
+#include "ari_model_validators.h"
 #include "asterisk/astobj2.h"
 #include "asterisk/http_websocket.h"
 #include "asterisk/stasis_app.h"
+#include "asterisk/utils.h"
 #include "asterisk/vector.h"
 
 /*! Number of buckets for the event session registry. Remember to keep it a prime number! */
@@ -51,6 +54,9 @@ struct event_session {
 	struct ao2_container *websocket_apps;           /*!< List of Stasis apps registered to
 	                                                     the websocket session. */
 	AST_VECTOR(, struct ast_json *) message_queue;  /*!< Container for holding delayed messages. */
+	int spool_limit;                                /*!< Maximum queued messages while disconnected,
+	                                                     zero for the legacy inbound behavior. */
+	unsigned int spool_dropped;                     /*!< Messages dropped due to the spool limit. */
 	char session_id[];                              /*!< The id for the websocket session. */
 };
 
@@ -114,25 +120,45 @@ static void stasis_app_message_handler(
 		        msg_application);
 	} else if (!session->ws_session) {
 		/* If the websocket is NULL, the message goes to the queue */
+		if (session->spool_limit
+			&& AST_VECTOR_SIZE(&session->message_queue) >= session->spool_limit) {
+			struct ast_json *oldest =
+				AST_VECTOR_REMOVE_ORDERED(&session->message_queue, 0);
+
+			ast_json_unref(oldest);
+			++session->spool_dropped;
+		}
 		if (!AST_VECTOR_APPEND(&session->message_queue, message)) {
 			ast_json_ref(message);
 		}
-		ast_log(LOG_WARNING,
-				"Queued '%s' message for Stasis app '%s'; websocket is not ready\n",
+		if (session->spool_limit) {
+			ast_debug(3, "Spooled '%s' message for Stasis app '%s'; websocket is not connected\n",
 				msg_type,
 				msg_application);
+		} else {
+			ast_log(LOG_WARNING,
+					"Queued '%s' message for Stasis app '%s'; websocket is not ready\n",
+					msg_type,
+					msg_application);
+		}
 	} else if (stasis_app_event_allowed(app_name, message)) {
-		if (app_debug_enabled) {
-			char *str = ast_json_dump_string_format(message, ast_ari_json_format());
-
-			ast_verbose("<--- Sending ARI event to %s --->\n%s\n",
-				ast_sockaddr_stringify(ast_ari_websocket_session_get_remote_addr(session->ws_session)),
-				str);
+		/* Encode the event once; debug logging and the websocket write
+		 * share the same buffer. */
+		char *str = ast_json_dump_string_format(message, ast_ari_json_format());
+
+		if (!str) {
+			ast_log(LOG_ERROR, "Failed to encode JSON object\n");
+		} else {
+			if (app_debug_enabled) {
+				ast_verbose("<--- Sending ARI event to %s --->\n%s\n",
+					ast_sockaddr_stringify(ast_ari_websocket_session_get_remote_addr(session->ws_session)),
+					str);
+			}
+
+			/* We are ready to publish the message */
+			ast_ari_websocket_session_write_serialized(session->ws_session, message, str);
 			ast_json_free(str);
 		}
-
-		/* We are ready to publish the message */
-		ast_ari_websocket_session_write(session->ws_session, message);
 	}
 
 	ao2_unlock(session);
@@ -284,6 +310,13 @@ static void event_session_update_websocket(
 	}
 
 	AST_VECTOR_RESET(&session->message_queue, AST_VECTOR_ELEM_CLEANUP_NOOP);
+
+	if (session->spool_dropped) {
+		ast_log(LOG_WARNING,
+			"Replayed spooled events for session '%s' but %u were dropped due to the spool limit\n",
+			session->session_id, session->spool_dropped);
+		session->spool_dropped = 0;
+	}
 	ao2_unlock(session);
 }
 
@@ -340,26 +373,34 @@ static int event_session_allocation_error_handler(
 		struct event_session *session, enum event_session_error_type error,
 		struct ast_tcptls_session_instance *ser)
 {
-	/* Notify the client */
+	/* Notify the client, if the session was requested over HTTP */
 	switch (error) {
 	case ERROR_TYPE_STASIS_REGISTRATION:
-		ast_http_error(ser, 500, "Internal Server Error",
-			"Stasis registration failed");
+		if (ser) {
+			ast_http_error(ser, 500, "Internal Server Error",
+				"Stasis registration failed");
+		}
 		break;
 
 	case ERROR_TYPE_OOM:
-		ast_http_error(ser, 500, "Internal Server Error",
-			"Allocation failed");
+		if (ser) {
+			ast_http_error(ser, 500, "Internal Server Error",
+				"Allocation failed");
+		}
 		break;
 
 	case ERROR_TYPE_MISSING_APP_PARAM:
-		ast_http_error(ser, 400, "Bad Request",
-			"HTTP request is missing param: [app]");
+		if (ser) {
+			ast_http_error(ser, 400, "Bad Request",
+				"HTTP request is missing param: [app]");
+		}
 		break;
 
 	case ERROR_TYPE_INVALID_APP_PARAM:
-		ast_http_error(ser, 400, "Bad Request",
-			"Invalid application provided in param [app].");
+		if (ser) {
+			ast_http_error(ser, 400, "Bad Request",
+				"Invalid application provided in param [app].");
+		}
 		break;
 
 	default:
@@ -386,7 +427,8 @@ static int event_session_allocation_error_handler(
  * \retval -1  on failure
  */
 static int event_session_alloc(struct ast_tcptls_session_instance *ser,
-		struct ast_ari_events_event_websocket_args *args, const char *session_id)
+		struct ast_ari_events_event_websocket_args *args, const char *session_id,
+		int spool_limit)
 {
 	RAII_VAR(struct event_session *, session, NULL, ao2_cleanup);
 	int (* register_handler)(const char *, stasis_app_cb handler, void *data);
@@ -407,6 +449,7 @@ static int event_session_alloc(struct ast_tcptls_session_instance *ser,
 	}
 
 	strncpy(session->session_id, session_id, size - sizeof(*session));
+	session->spool_limit = spool_limit;
 
 	/* Instantiate the hash table for Stasis apps */
 	session->websocket_apps =
@@ -455,6 +498,242 @@ static int event_session_alloc(struct ast_tcptls_session_instance *ser,
 	return 0;
 }
 
+/*! \brief State for a configured persistent outbound websocket connection. */
+struct outbound_websocket {
+	/*! Thread driving the connect/read/reconnect loop */
+	pthread_t thread;
+	ast_mutex_t lock;
+	ast_cond_t cond;
+	/*! Set to end the connection loop */
+	unsigned int stop:1;
+	/*! Currently connected websocket, if any */
+	struct ast_websocket *ws;
+	/*! Configuration for this connection */
+	struct ast_ari_conf_outbound_websocket *config;
+	/*! The id of the persistent event session backing this connection */
+	char session_id[];
+};
+
+/*! \brief Established outbound connections. */
+static AST_VECTOR(, struct outbound_websocket *) outbound_connections;
+
+/*!
+ * \internal
+ * \brief Sleep until the reconnect interval elapses or the connection is stopped.
+ */
+static void outbound_websocket_wait(struct outbound_websocket *outbound)
+{
+	struct timeval expires = ast_tvadd(ast_tvnow(),
+		ast_samp2tv(outbound->config->reconnect_interval, 1));
+	struct timespec ts = { .tv_sec = expires.tv_sec, .tv_nsec = expires.tv_usec * 1000, };
+
+	ast_mutex_lock(&outbound->lock);
+	while (!outbound->stop) {
+		if (ast_cond_timedwait(&outbound->cond, &outbound->lock, &ts) == ETIMEDOUT) {
+			break;
+		}
+	}
+	ast_mutex_unlock(&outbound->lock);
+}
+
+/*!
+ * \internal
+ * \brief Connection loop for an outbound websocket.
+ *
+ * The backing \ref event_session outlives the individual connections, so
+ * events dispatched while the application is away land in its bounded
+ * message queue and replay when the connection is re-established.
+ */
+static void *outbound_websocket_run(void *data)
+{
+	struct outbound_websocket *outbound = data;
+
+	while (!outbound->stop) {
+		enum ast_websocket_result result;
+		struct ast_websocket *ws;
+		struct ast_ari_websocket_session *ari_session;
+		struct event_session *session;
+		struct ast_json *msg;
+
+		ws = ast_websocket_client_create(outbound->config->uri, "ari", NULL, &result);
+		if (!ws) {
+			ast_debug(3, "Outbound ARI websocket '%s' could not connect to '%s'; retrying in %d seconds\n",
+				outbound->config->name, outbound->config->uri,
+				outbound->config->reconnect_interval);
+			outbound_websocket_wait(outbound);
+			continue;
+		}
+
+#if defined(AST_DEVMODE)
+		ari_session = ast_ari_websocket_session_create(ws,
+			ast_ari_validate_message_fn());
+#else
+		ari_session = ast_ari_websocket_session_create(ws, NULL);
+#endif
+		if (!ari_session) {
+			ast_websocket_unref(ws);
+			outbound_websocket_wait(outbound);
+			continue;
+		}
+
+		ast_mutex_lock(&outbound->lock);
+		outbound->ws = ws;
+		ast_mutex_unlock(&outbound->lock);
+
+		ast_verb(3, "Outbound ARI websocket '%s' connected to '%s'\n",
+			outbound->config->name, outbound->config->uri);
+
+		/* Attaching the websocket replays any spooled events */
+		session = ao2_find(event_session_registry, outbound->session_id,
+			OBJ_SEARCH_KEY);
+		if (session) {
+			event_session_update_websocket(session, ari_session);
+		}
+
+		/* We don't process any input, but we'll consume it waiting for EOF */
+		while ((msg = ast_ari_websocket_session_read(ari_session))) {
+			ast_json_unref(msg);
+		}
+
+		if (session) {
+			/* Detach the websocket so events spool until we reconnect */
+			ao2_lock(session);
+			session->ws_session = NULL;
+			ao2_unlock(session);
+			ao2_ref(session, -1);
+		}
+
+		ast_mutex_lock(&outbound->lock);
+		outbound->ws = NULL;
+		ast_mutex_unlock(&outbound->lock);
+
+		ao2_ref(ari_session, -1);
+		ast_websocket_unref(ws);
+
+		if (!outbound->stop) {
+			ast_verb(3, "Outbound ARI websocket '%s' disconnected; events will spool until reconnect\n",
+				outbound->config->name);
+			outbound_websocket_wait(outbound);
+		}
+	}
+
+	return NULL;
+}
+
+/*!
+ * \internal
+ * \brief Destroy an outbound websocket connection object.
+ */
+static void outbound_websocket_destroy(struct outbound_websocket *outbound)
+{
+	ast_mutex_destroy(&outbound->lock);
+	ast_cond_destroy(&outbound->cond);
+	ao2_cleanup(outbound->config);
+	ast_free(outbound);
+}
+
+/*!
+ * \internal
+ * \brief Stop an outbound websocket connection and reclaim its resources.
+ */
+static void outbound_websocket_stop(struct outbound_websocket *outbound)
+{
+	ast_mutex_lock(&outbound->lock);
+	outbound->stop = 1;
+	if (outbound->ws) {
+		ast_websocket_close(outbound->ws, 1000);
+	}
+	ast_cond_signal(&outbound->cond);
+	ast_mutex_unlock(&outbound->lock);
+
+	pthread_kill(outbound->thread, SIGURG);
+	pthread_join(outbound->thread, NULL);
+
+	outbound_websocket_destroy(outbound);
+}
+
+/*!
+ * \internal
+ * \brief Create an outbound websocket connection and its persistent event session.
+ */
+static struct outbound_websocket *outbound_websocket_create(
+		struct ast_ari_conf_outbound_websocket *config)
+{
+	struct outbound_websocket *outbound;
+	const char *app = config->app;
+	struct ast_ari_events_event_websocket_args args = {
+		.app = &app,
+		.app_count = 1,
+	};
+	size_t size;
+
+	if (ast_strlen_zero(config->uri) || ast_strlen_zero(config->app)) {
+		return NULL;
+	}
+
+	size = sizeof(*outbound) + strlen("outbound-") + strlen(config->name) + 1;
+	outbound = ast_calloc(1, size);
+	if (!outbound) {
+		return NULL;
+	}
+
+	sprintf(outbound->session_id, "outbound-%s", config->name); /* Safe */
+	ast_mutex_init(&outbound->lock);
+	ast_cond_init(&outbound->cond, NULL);
+	outbound->config = ao2_bump(config);
+
+	/* The event session persists across reconnects so events spool while
+	 * the application is away and replay when it returns. */
+	if (event_session_alloc(NULL, &args, outbound->session_id, config->spool_limit)) {
+		ast_log(LOG_WARNING, "Failed to create event session for outbound ARI websocket '%s'\n",
+			config->name);
+		outbound_websocket_destroy(outbound);
+		return NULL;
+	}
+
+	if (ast_pthread_create_background(&outbound->thread, NULL,
+			outbound_websocket_run, outbound)) {
+		struct event_session *session = ao2_find(event_session_registry,
+			outbound->session_id, OBJ_SEARCH_KEY);
+
+		if (session) {
+			event_session_cleanup(session);
+			ao2_ref(session, -1);
+		}
+		outbound_websocket_destroy(outbound);
+		return NULL;
+	}
+
+	return outbound;
+}
+
+/*!
+ * \internal
+ * \brief Start the configured outbound websocket connections.
+ */
+static void outbound_websockets_start(void)
+{
+	struct ast_ari_conf *config = ast_ari_config_get();
+	struct ao2_iterator iter;
+	struct ast_ari_conf_outbound_websocket *outbound_config;
+
+	if (!config) {
+		return;
+	}
+
+	iter = ao2_iterator_init(config->outbound_websockets, 0);
+	while ((outbound_config = ao2_iterator_next(&iter))) {
+		struct outbound_websocket *outbound = outbound_websocket_create(outbound_config);
+
+		if (outbound && AST_VECTOR_APPEND(&outbound_connections, outbound)) {
+			outbound_websocket_stop(outbound);
+		}
+		ao2_ref(outbound_config, -1);
+	}
+	ao2_iterator_destroy(&iter);
+	ao2_ref(config, -1);
+}
+
 static int event_session_shutdown_cb(void *session, void *arg, int flags)
 {
 	event_session_cleanup(session);
@@ -464,6 +743,13 @@ static int event_session_shutdown_cb(void *session, void *arg, int flags)
 
 void ast_ari_websocket_events_event_websocket_dtor(void)
 {
+	int i;
+
+	for (i = 0; i < AST_VECTOR_SIZE(&outbound_connections); i++) {
+		outbound_websocket_stop(AST_VECTOR_GET(&outbound_connections, i));
+	}
+	AST_VECTOR_FREE(&outbound_connections);
+
 	ao2_callback(event_session_registry, OBJ_MULTIPLE | OBJ_NODATA, event_session_shutdown_cb, NULL);
 
 	ao2_cleanup(event_session_registry);
@@ -482,6 +768,13 @@ int ast_ari_websocket_events_event_websocket_init(void)
 		return -1;
 	}
 
+	if (AST_VECTOR_INIT(&outbound_connections, 0)) {
+		ao2_cleanup(event_session_registry);
+		event_session_registry = NULL;
+		return -1;
+	}
+	outbound_websockets_start();
+
 	return 0;
 }
 
@@ -492,7 +785,7 @@ int ast_ari_websocket_events_event_websocket_attempted(
 	ast_debug(3, "/events WebSocket attempted\n");
 
 	/* Create the event session */
-	return event_session_alloc(ser, args, session_id);
+	return event_session_alloc(ser, args, session_id, 0);
 }
 
 void ast_ari_websocket_events_event_websocket_established(
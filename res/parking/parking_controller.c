@@ -154,17 +154,6 @@ int parking_lot_get_space(struct parking_lot *lot, int target_override)
 	return -1;
 }
 
-static int retrieve_parked_user_targeted(void *obj, void *arg, int flags)
-{
-	int *target = arg;
-	struct parked_user *user = obj;
-	if (user->parking_space == *target) {
-		return CMP_MATCH;
-	}
-
-	return 0;
-}
-
 struct parked_user *parking_lot_inspect_parked_user(struct parking_lot *lot, int target)
 {
 	struct parked_user *user;
@@ -172,7 +161,7 @@ struct parked_user *parking_lot_inspect_parked_user(struct parking_lot *lot, int
 	if (target < 0) {
 		user = ao2_callback(lot->parked_users, 0, NULL, NULL);
 	} else {
-		user = ao2_callback(lot->parked_users, 0, retrieve_parked_user_targeted, &target);
+		user = ao2_find(lot->parked_users, &target, OBJ_SEARCH_KEY);
 	}
 
 	if (!user) {
@@ -189,7 +178,7 @@ struct parked_user *parking_lot_retrieve_parked_user(struct parking_lot *lot, in
 	if (target < 0) {
 		user = ao2_callback(lot->parked_users, 0, NULL, NULL);
 	} else {
-		user = ao2_callback(lot->parked_users, 0, retrieve_parked_user_targeted, &target);
+		user = ao2_find(lot->parked_users, &target, OBJ_SEARCH_KEY);
 	}
 
 	if (!user) {
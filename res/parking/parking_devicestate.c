@@ -33,17 +33,6 @@ struct parking_lot_extension_inuse_search {
 	int exten;
 };
 
-static int retrieve_parked_user_targeted(void *obj, void *arg, int flags)
-{
-	int *target = arg;
-	struct parked_user *user = obj;
-	if (user->parking_space == *target) {
-		return CMP_MATCH;
-	}
-
-	return 0;
-}
-
 static int parking_lot_search_context_extension_inuse(void *obj, void *arg, int flags)
 {
 	struct parking_lot *lot = obj;
@@ -58,7 +47,7 @@ static int parking_lot_search_context_extension_inuse(void *obj, void *arg, int
 		return 0;
 	}
 
-	user = ao2_callback(lot->parked_users, 0, retrieve_parked_user_targeted, &search->exten);
+	user = ao2_find(lot->parked_users, &search->exten, OBJ_SEARCH_KEY);
 	if (!user) {
 		return 0;
 	}
@@ -97,7 +86,7 @@ static enum ast_device_state metermaidstate(const char *data)
 
 	ast_debug(4, "Checking state of exten %d in context %s\n", search.exten, context);
 
-	lot = ao2_callback(global_lots, 0, parking_lot_search_context_extension_inuse, &data);
+	lot = ao2_callback(global_lots, 0, parking_lot_search_context_extension_inuse, &search);
 	if (!lot) {
 		return AST_DEVICE_NOT_INUSE;
 	}
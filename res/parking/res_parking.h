@@ -92,7 +92,7 @@ struct parking_lot_cfg {
 struct parking_lot {
 	int next_space;                           /*!< When using parkfindnext, which space we should start searching from next time we park */
 	struct ast_bridge *parking_bridge;        /*!< Bridged where parked calls will rest until they are answered or otherwise leave */
-	struct ao2_container *parked_users;       /*!< List of parked users rigidly ordered by their parking space */
+	struct ao2_container *parked_users;       /*!< Parked users indexed and rigidly ordered by their parking space */
 	struct parking_lot_cfg *cfg;              /*!< Reference to configuration object for the parking lot */
 	enum parking_lot_modes mode;              /*!< Whether a parking lot is operational, being reconfigured, primed for deletion, or dynamically created. */
 	int disable_mark;                         /*!< On reload, disable this parking lot if it doesn't receive a new configuration. */
@@ -28,6 +28,7 @@
 #include "asterisk.h"
 #include "asterisk/res_prometheus.h"
 #include "asterisk/stasis_channels.h"
+#include "asterisk/channel.h"
 #include "asterisk/pbx.h"
 #include "prometheus_internal.h"
 
@@ -35,6 +36,8 @@
 
 #define CHANNELS_DURATION_HELP "Individual channel durations (in seconds)."
 
+#define CHANNELS_FRAME_DROPS_HELP "Media frames dropped by the core, by cause."
+
 /*!
  * \internal
  * \brief Callback function to get a channel's current state
@@ -121,6 +124,31 @@ static struct prometheus_metric global_channel_metrics[] = {
 	),
 };
 
+/*!
+ * \internal
+ * \brief Frame drop counters, one child metric per drop cause
+ */
+static struct prometheus_metric frame_drop_metrics[AST_FRAME_DROP_CAUSE_COUNT] = {
+	[AST_FRAME_DROP_READQ] = PROMETHEUS_METRIC_STATIC_INITIALIZATION(
+		PROMETHEUS_METRIC_COUNTER,
+		"asterisk_channels_frame_drops",
+		CHANNELS_FRAME_DROPS_HELP,
+		NULL
+	),
+	[AST_FRAME_DROP_JITTERBUFFER] = PROMETHEUS_METRIC_STATIC_INITIALIZATION(
+		PROMETHEUS_METRIC_COUNTER,
+		"asterisk_channels_frame_drops",
+		CHANNELS_FRAME_DROPS_HELP,
+		NULL
+	),
+	[AST_FRAME_DROP_MIXING] = PROMETHEUS_METRIC_STATIC_INITIALIZATION(
+		PROMETHEUS_METRIC_COUNTER,
+		"asterisk_channels_frame_drops",
+		CHANNELS_FRAME_DROPS_HELP,
+		NULL
+	),
+};
+
 /*!
  * \internal
  * \brief Callback invoked when Prometheus scrapes the server
@@ -171,6 +199,23 @@ static void channels_scrape_cb(struct ast_str **response)
 		prometheus_metric_to_string(&global_channel_metrics[i], response);
 	}
 
+	/* Frame drop counters, by cause */
+	for (i = 0; i < ARRAY_LEN(frame_drop_metrics); i++) {
+		PROMETHEUS_METRIC_SET_LABEL(&frame_drop_metrics[i], 0, "eid", eid_str);
+		PROMETHEUS_METRIC_SET_LABEL(&frame_drop_metrics[i], 1, "cause",
+			ast_frame_drop_cause_name(i));
+		snprintf(frame_drop_metrics[i].value, sizeof(frame_drop_metrics[i].value),
+			"%u", ast_frame_drops_global(i));
+		if (i) {
+			AST_LIST_INSERT_TAIL(&frame_drop_metrics[0].children,
+				&frame_drop_metrics[i], entry);
+		}
+	}
+	prometheus_metric_to_string(&frame_drop_metrics[0], response);
+	while (AST_LIST_REMOVE_HEAD(&frame_drop_metrics[0].children, entry)) {
+		/* Unlink the children so the next scrape rebuilds the list. */
+	}
+
 	if (num_channels == 0) {
 		ao2_ref(channels, -1);
 		return;
@@ -24,6 +24,7 @@
 #include "asterisk.h"
 
 #include "asterisk/astobj2.h"
+#include "asterisk/linkedlists.h"
 #include "asterisk/module.h"
 #include "asterisk/sorcery.h"
 #include "asterisk/cli.h"
@@ -325,6 +326,109 @@ struct ast_aeap *ast_aeap_create_and_connect_by_id(const char *id,
 	return aeap_create(id, params, 1, timeout);
 }
 
+/*! Maximum number of idle connections parked for reuse per client configuration */
+#define POOL_MAX_IDLE 16
+
+/*! An idle connection parked for later reuse */
+struct aeap_pooled {
+	/*! The parked connection (Holds ref) */
+	struct ast_aeap *aeap;
+	/*! Parameters the connection was created with */
+	const struct ast_aeap_params *params;
+	AST_LIST_ENTRY(aeap_pooled) list;
+	/*! Client configuration id the connection belongs to */
+	char id[0];
+};
+
+static AST_LIST_HEAD_STATIC(aeap_pool, aeap_pooled);
+
+static void aeap_pool_flush(void)
+{
+	struct aeap_pooled *entry;
+
+	AST_LIST_LOCK(&aeap_pool);
+	while ((entry = AST_LIST_REMOVE_HEAD(&aeap_pool, list))) {
+		ao2_ref(entry->aeap, -1);
+		ast_free(entry);
+	}
+	AST_LIST_UNLOCK(&aeap_pool);
+}
+
+struct ast_aeap *ast_aeap_acquire_by_id(const char *id,
+	const struct ast_aeap_params *params, int timeout)
+{
+	struct aeap_pooled *entry;
+	struct ast_aeap *aeap = NULL;
+
+	AST_LIST_LOCK(&aeap_pool);
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&aeap_pool, entry, list) {
+		if (strcmp(entry->id, id) || entry->params != params) {
+			continue;
+		}
+		AST_LIST_REMOVE_CURRENT(list);
+		aeap = entry->aeap;
+		ast_free(entry);
+		if (ast_aeap_is_connected(aeap)) {
+			break;
+		}
+		/* The connection died while parked.  Toss it and keep looking. */
+		ao2_ref(aeap, -1);
+		aeap = NULL;
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+	AST_LIST_UNLOCK(&aeap_pool);
+
+	if (aeap) {
+		return aeap;
+	}
+
+	return aeap_create(id, params, 1, timeout);
+}
+
+void ast_aeap_release_by_id(const char *id, const struct ast_aeap_params *params,
+	struct ast_aeap *aeap)
+{
+	struct aeap_pooled *entry = NULL;
+	int parked = 0;
+
+	if (!aeap) {
+		return;
+	}
+
+	if (ast_aeap_is_connected(aeap)) {
+		entry = ast_malloc(sizeof(*entry) + strlen(id) + 1);
+	}
+
+	if (entry) {
+		struct aeap_pooled *idle;
+		int idle_count = 0;
+
+		entry->aeap = aeap;
+		entry->params = params;
+		strcpy(entry->id, id); /* Safe */
+
+		AST_LIST_LOCK(&aeap_pool);
+		AST_LIST_TRAVERSE(&aeap_pool, idle, list) {
+			if (!strcmp(idle->id, id)) {
+				++idle_count;
+			}
+		}
+		if (idle_count < POOL_MAX_IDLE) {
+			AST_LIST_INSERT_HEAD(&aeap_pool, entry, list);
+			parked = 1;
+		}
+		AST_LIST_UNLOCK(&aeap_pool);
+
+		if (!parked) {
+			ast_free(entry);
+		}
+	}
+
+	if (!parked) {
+		ao2_ref(aeap, -1);
+	}
+}
+
 struct ast_variable *ast_aeap_custom_fields_get(const char *id)
 {
 	struct ast_aeap_client_config *cfg;
@@ -346,11 +450,16 @@ static int reload_module(void)
 {
 	ast_sorcery_reload(aeap_sorcery);
 
+	/* Parked connections may point at stale URLs after a reload */
+	aeap_pool_flush();
+
 	return 0;
 }
 
 static int unload_module(void)
 {
+	aeap_pool_flush();
+
 	ast_sorcery_unref(aeap_sorcery);
 	aeap_sorcery = NULL;
 
@@ -401,6 +401,11 @@ int ast_aeap_disconnect(struct ast_aeap *aeap)
 	return 0;
 }
 
+int ast_aeap_is_connected(struct ast_aeap *aeap)
+{
+	return aeap_transport_is_connected(aeap->transport);
+}
+
 static int aeap_send(struct ast_aeap *aeap, const void *buf, uintmax_t size,
 	enum AST_AEAP_DATA_TYPE type)
 {
@@ -36,6 +36,7 @@
 #include <sys/time.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <netinet/tcp.h>
 #include <pthread.h>
 
 #include "asterisk/paths.h"	/* use many ast_config_AST_*_DIR */
@@ -1401,6 +1402,120 @@ static int agidebug = 0;
 
 #define AGI_PORT 4573
 
+/*! Seconds a FastAGI host resolution stays usable before re-resolving */
+#define FASTAGI_DNS_CACHE_TTL 60
+
+/*! Number of buckets for the FastAGI resolution cache */
+#define FASTAGI_DNS_CACHE_BUCKETS 17
+
+/*!
+ * \brief Cached resolution of a FastAGI host.
+ *
+ * Resolving the host on every AGI() invocation dominates connection
+ * setup at high call rates.  Entries hold the resolved addresses with
+ * default ports already applied and expire after a short TTL so server
+ * address changes are still picked up.
+ */
+struct fastagi_dns_entry {
+	/*! Resolved addresses for the host, ports filled in */
+	struct ast_sockaddr *addrs;
+	/*! Number of entries in addrs */
+	int num_addrs;
+	/*! When this resolution stops being usable */
+	time_t expires;
+	/*! The host[:port] portion of the AGI url */
+	char host[];
+};
+
+static struct ao2_container *fastagi_dns_cache;
+
+static void fastagi_dns_entry_dtor(void *obj)
+{
+	struct fastagi_dns_entry *entry = obj;
+
+	ast_free(entry->addrs);
+}
+
+AO2_STRING_FIELD_HASH_FN(fastagi_dns_entry, host)
+AO2_STRING_FIELD_CMP_FN(fastagi_dns_entry, host)
+
+/*!
+ * \internal
+ * \brief Resolve a FastAGI host, preferring the cache.
+ *
+ * \param host The host[:port] portion of the AGI url.
+ * \param addrs Output array of resolved addresses to be freed by the caller.
+ *
+ * \return Number of addresses in addrs, zero on failure.
+ */
+static int fastagi_resolve(const char *host, struct ast_sockaddr **addrs)
+{
+	struct fastagi_dns_entry *entry;
+	int num_addrs;
+	int i;
+
+	if (fastagi_dns_cache) {
+		entry = ao2_find(fastagi_dns_cache, host, OBJ_SEARCH_KEY);
+		if (entry) {
+			if (time(NULL) < entry->expires) {
+				*addrs = ast_malloc(entry->num_addrs * sizeof(**addrs));
+				if (*addrs) {
+					memcpy(*addrs, entry->addrs, entry->num_addrs * sizeof(**addrs));
+					num_addrs = entry->num_addrs;
+					ao2_ref(entry, -1);
+					return num_addrs;
+				}
+			}
+			ao2_unlink(fastagi_dns_cache, entry);
+			ao2_ref(entry, -1);
+		}
+	}
+
+	num_addrs = ast_sockaddr_resolve(addrs, host, 0, AST_AF_UNSPEC);
+	if (!num_addrs) {
+		return 0;
+	}
+
+	/* Apply the default port up front so cached addresses are complete. */
+	for (i = 0; i < num_addrs; i++) {
+		if (!ast_sockaddr_port(&(*addrs)[i])) {
+			ast_sockaddr_set_port(&(*addrs)[i], AGI_PORT);
+		}
+	}
+
+	if (fastagi_dns_cache) {
+		entry = ao2_alloc(sizeof(*entry) + strlen(host) + 1, fastagi_dns_entry_dtor);
+		if (entry) {
+			entry->addrs = ast_malloc(num_addrs * sizeof(*entry->addrs));
+			if (entry->addrs) {
+				memcpy(entry->addrs, *addrs, num_addrs * sizeof(*entry->addrs));
+				entry->num_addrs = num_addrs;
+				entry->expires = time(NULL) + FASTAGI_DNS_CACHE_TTL;
+				strcpy(entry->host, host); /* Safe */
+				ao2_link(fastagi_dns_cache, entry);
+			}
+			ao2_ref(entry, -1);
+		}
+	}
+
+	return num_addrs;
+}
+
+/*!
+ * \internal
+ * \brief Forget a cached resolution that stopped working.
+ */
+static void fastagi_resolve_invalidate(const char *host)
+{
+	struct fastagi_dns_entry *entry;
+
+	if (!fastagi_dns_cache) {
+		return;
+	}
+	entry = ao2_find(fastagi_dns_cache, host, OBJ_SEARCH_KEY | OBJ_UNLINK);
+	ao2_cleanup(entry);
+}
+
 /*! Special return code for "asyncagi break" command. */
 #define ASYNC_AGI_BREAK	3
 
@@ -2062,16 +2177,12 @@ static enum agi_result launch_netscript(char *agiurl, char *argv[], int *fds)
 		script = "";
 	}
 
-	if (!(num_addrs = ast_sockaddr_resolve(&addrs, host, 0, AST_AF_UNSPEC))) {
+	if (!(num_addrs = fastagi_resolve(host, &addrs))) {
 		ast_log(LOG_WARNING, "Unable to locate host '%s'\n", host);
 		return AGI_RESULT_FAILURE;
 	}
 
 	for (i = 0; i < num_addrs; i++) {
-		if (!ast_sockaddr_port(&addrs[i])) {
-			ast_sockaddr_set_port(&addrs[i], AGI_PORT);
-		}
-
 		if ((s = ast_socket_nonblock(addrs[i].ss.ss_family, SOCK_STREAM, IPPROTO_TCP)) < 0) {
 			ast_log(LOG_WARNING, "Unable to create socket: %s\n", strerror(errno));
 			continue;
@@ -2095,10 +2206,23 @@ static enum agi_result launch_netscript(char *agiurl, char *argv[], int *fds)
 	ast_free(addrs);
 
 	if (i == num_addrs) {
+		/* Do not keep handing out addresses that cannot be reached. */
+		fastagi_resolve_invalidate(host);
 		ast_log(LOG_WARNING, "Couldn't connect to any host.  FastAGI failed.\n");
 		return AGI_RESULT_FAILURE;
 	}
 
+	{
+		int nodelay = 1;
+
+		/* The AGI conversation is a latency sensitive request/response
+		 * ping-pong of tiny writes; don't let Nagle delay them. */
+		if (setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay))) {
+			ast_log(LOG_WARNING, "Failed to set TCP_NODELAY on FastAGI socket: %s\n",
+				strerror(errno));
+		}
+	}
+
 	if (ast_agi_send(s, NULL, "agi_network: yes\n") < 0) {
 		if (errno != EINTR) {
 			ast_log(LOG_WARNING, "Connect to '%s' failed: %s\n", agiurl, strerror(errno));
@@ -2313,47 +2437,56 @@ static enum agi_result launch_script(struct ast_channel *chan, char *script, int
 static void setup_env(struct ast_channel *chan, char *request, int fd, int enhanced, int argc, char *argv[])
 {
 	int count;
+	struct ast_str *buf = ast_str_create(1024);
+
+	if (!buf) {
+		return;
+	}
 
-	/* Print initial environment, with agi_request always being the first
-	   thing */
-	ast_agi_send(fd, chan, "agi_request: %s\n", request);
-	ast_agi_send(fd, chan, "agi_channel: %s\n", ast_channel_name(chan));
-	ast_agi_send(fd, chan, "agi_language: %s\n", ast_channel_language(chan));
-	ast_agi_send(fd, chan, "agi_type: %s\n", ast_channel_tech(chan)->type);
-	ast_agi_send(fd, chan, "agi_uniqueid: %s\n", ast_channel_uniqueid(chan));
-	ast_agi_send(fd, chan, "agi_version: %s\n", ast_get_version());
+	/* Build the whole environment so it goes out in a single write
+	   instead of one syscall per variable, with agi_request always
+	   being the first thing */
+	ast_str_append(&buf, 0, "agi_request: %s\n", request);
+	ast_str_append(&buf, 0, "agi_channel: %s\n", ast_channel_name(chan));
+	ast_str_append(&buf, 0, "agi_language: %s\n", ast_channel_language(chan));
+	ast_str_append(&buf, 0, "agi_type: %s\n", ast_channel_tech(chan)->type);
+	ast_str_append(&buf, 0, "agi_uniqueid: %s\n", ast_channel_uniqueid(chan));
+	ast_str_append(&buf, 0, "agi_version: %s\n", ast_get_version());
 
 	/* ANI/DNIS */
-	ast_agi_send(fd, chan, "agi_callerid: %s\n",
+	ast_str_append(&buf, 0, "agi_callerid: %s\n",
 		S_COR(ast_channel_caller(chan)->id.number.valid, ast_channel_caller(chan)->id.number.str, "unknown"));
-	ast_agi_send(fd, chan, "agi_calleridname: %s\n",
+	ast_str_append(&buf, 0, "agi_calleridname: %s\n",
 		S_COR(ast_channel_caller(chan)->id.name.valid, ast_channel_caller(chan)->id.name.str, "unknown"));
-	ast_agi_send(fd, chan, "agi_callingpres: %d\n",
+	ast_str_append(&buf, 0, "agi_callingpres: %d\n",
 		ast_party_id_presentation(&ast_channel_caller(chan)->id));
-	ast_agi_send(fd, chan, "agi_callingani2: %d\n", ast_channel_caller(chan)->ani2);
-	ast_agi_send(fd, chan, "agi_callington: %d\n", ast_channel_caller(chan)->id.number.plan);
-	ast_agi_send(fd, chan, "agi_callingtns: %d\n", ast_channel_dialed(chan)->transit_network_select);
-	ast_agi_send(fd, chan, "agi_dnid: %s\n", S_OR(ast_channel_dialed(chan)->number.str, "unknown"));
-	ast_agi_send(fd, chan, "agi_rdnis: %s\n",
+	ast_str_append(&buf, 0, "agi_callingani2: %d\n", ast_channel_caller(chan)->ani2);
+	ast_str_append(&buf, 0, "agi_callington: %d\n", ast_channel_caller(chan)->id.number.plan);
+	ast_str_append(&buf, 0, "agi_callingtns: %d\n", ast_channel_dialed(chan)->transit_network_select);
+	ast_str_append(&buf, 0, "agi_dnid: %s\n", S_OR(ast_channel_dialed(chan)->number.str, "unknown"));
+	ast_str_append(&buf, 0, "agi_rdnis: %s\n",
 		S_COR(ast_channel_redirecting(chan)->from.number.valid, ast_channel_redirecting(chan)->from.number.str, "unknown"));
 
 	/* Context information */
-	ast_agi_send(fd, chan, "agi_context: %s\n", ast_channel_context(chan));
-	ast_agi_send(fd, chan, "agi_extension: %s\n", ast_channel_exten(chan));
-	ast_agi_send(fd, chan, "agi_priority: %d\n", ast_channel_priority(chan));
-	ast_agi_send(fd, chan, "agi_enhanced: %s\n", enhanced ? "1.0" : "0.0");
+	ast_str_append(&buf, 0, "agi_context: %s\n", ast_channel_context(chan));
+	ast_str_append(&buf, 0, "agi_extension: %s\n", ast_channel_exten(chan));
+	ast_str_append(&buf, 0, "agi_priority: %d\n", ast_channel_priority(chan));
+	ast_str_append(&buf, 0, "agi_enhanced: %s\n", enhanced ? "1.0" : "0.0");
 
 	/* User information */
-	ast_agi_send(fd, chan, "agi_accountcode: %s\n", ast_channel_accountcode(chan) ? ast_channel_accountcode(chan) : "");
-	ast_agi_send(fd, chan, "agi_threadid: %ld\n", (long)pthread_self());
+	ast_str_append(&buf, 0, "agi_accountcode: %s\n", ast_channel_accountcode(chan) ? ast_channel_accountcode(chan) : "");
+	ast_str_append(&buf, 0, "agi_threadid: %ld\n", (long)pthread_self());
 
 	/* Send any parameters to the fastagi server that have been passed via the agi application */
 	/* Agi application paramaters take the form of: AGI(/path/to/example/script|${EXTEN}) */
 	for(count = 1; count < argc; count++)
-		ast_agi_send(fd, chan, "agi_arg_%d: %s\n", count, argv[count]);
+		ast_str_append(&buf, 0, "agi_arg_%d: %s\n", count, argv[count]);
 
 	/* End with empty return */
-	ast_agi_send(fd, chan, "\n");
+	ast_str_append(&buf, 0, "\n");
+
+	ast_agi_send(fd, chan, "%s", ast_str_buffer(buf));
+	ast_free(buf);
 }
 
 static int handle_answer(struct ast_channel *chan, AGI *agi, int argc, const char * const argv[])
@@ -4687,6 +4820,8 @@ static int unload_module(void)
 	ast_manager_unregister("AGI");
 	ast_unregister_application(app);
 	AST_TEST_UNREGISTER(test_agi_null_docs);
+	ao2_cleanup(fastagi_dns_cache);
+	fastagi_dns_cache = NULL;
 	return 0;
 }
 
@@ -4694,6 +4829,11 @@ static int load_module(void)
 {
 	int err = 0;
 
+	/* FastAGI still works without the cache, just slower. */
+	fastagi_dns_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, FASTAGI_DNS_CACHE_BUCKETS,
+		fastagi_dns_entry_hash_fn, NULL, fastagi_dns_entry_cmp_fn);
+
 	err |= STASIS_MESSAGE_TYPE_INIT(agi_exec_start_type);
 	err |= STASIS_MESSAGE_TYPE_INIT(agi_exec_end_type);
 	err |= STASIS_MESSAGE_TYPE_INIT(agi_async_start_type);
@@ -31,6 +31,8 @@
 #include "asterisk.h"
 #include "errno.h"
 #include <uuid/uuid.h>
+#include <sys/uio.h>
+#include <netinet/tcp.h>
 
 #include "asterisk/file.h"
 #include "asterisk/res_audiosocket.h"
@@ -100,7 +102,7 @@ const int ast_audiosocket_connect(const char *server, struct ast_channel *chan)
 {
 	int s = -1;
 	struct ast_sockaddr *addrs = NULL;
-	int num_addrs = 0, i = 0;
+	int num_addrs = 0, i = 0, nodelay = 1;
 
 	if (chan && ast_autoservice_start(chan) < 0) {
 		ast_log(LOG_WARNING, "Failed to start autoservice for channel "
@@ -153,6 +155,14 @@ const int ast_audiosocket_connect(const char *server, struct ast_channel *chan)
 			s = -1;
 		}
 
+		if (s >= 0 && setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &nodelay,
+				sizeof(nodelay))) {
+			/* Frames are small and latency sensitive; don't let Nagle
+			 * hold them back behind unacknowledged data. */
+			ast_log(LOG_WARNING, "Failed to set TCP_NODELAY on AudioSocket: %s\n",
+				strerror(errno));
+		}
+
 		break;
 	}
 
@@ -208,24 +218,26 @@ const int ast_audiosocket_init(const int svc, const char *id)
 
 const int ast_audiosocket_send_frame(const int svc, const struct ast_frame *f)
 {
-	int ret = 0;
-	uint8_t kind = 0x10;	/* always 16-bit, 8kHz signed linear mono, for now */
-	uint8_t *p;
-	uint8_t buf[3 + f->datalen];
+	uint8_t header[3];
+	struct iovec iov[2];
 
-	p = buf;
+	header[0] = 0x10;	/* always 16-bit, 8kHz signed linear mono, for now */
+	header[1] = f->datalen >> 8;
+	header[2] = f->datalen & 0xff;
 
-	*(p++) = kind;
-	*(p++) = f->datalen >> 8;
-	*(p++) = f->datalen & 0xff;
-	memcpy(p, f->data.ptr, f->datalen);
+	iov[0].iov_base = header;
+	iov[0].iov_len = 3;
+	iov[1].iov_base = f->data.ptr;
+	iov[1].iov_len = f->datalen;
 
-	if (write(svc, buf, 3 + f->datalen) != 3 + f->datalen) {
+	/* A vectored write sends header and payload as one segment without
+	 * copying the audio into a staging buffer first. */
+	if (writev(svc, iov, 2) != 3 + f->datalen) {
 		ast_log(LOG_WARNING, "Failed to write data to AudioSocket\n");
-		ret = -1;
+		return -1;
 	}
 
-	return ret;
+	return 0;
 }
 
 struct ast_frame *ast_audiosocket_receive_frame(const int svc)
@@ -238,23 +250,38 @@ struct ast_frame *ast_audiosocket_receive_frame(const int svc)
 		.src = "AudioSocket",
 		.mallocd = AST_MALLOCD_DATA,
 	};
+	uint8_t header[3];
 	uint8_t kind;
-	uint8_t len_high;
-	uint8_t len_low;
 	uint16_t len = 0;
 	uint8_t *data;
 
-	n = read(svc, &kind, 1);
+	/* Read the whole kind/length header with one syscall in the common
+	 * case rather than a byte at a time. */
+	n = read(svc, header, 3);
 	if (n < 0 && errno == EAGAIN) {
 		return &ast_null_frame;
 	}
 	if (n == 0) {
 		return &ast_null_frame;
 	}
-	if (n != 1) {
+	if (n < 0) {
 		ast_log(LOG_WARNING, "Failed to read type header from AudioSocket\n");
 		return NULL;
 	}
+	while (n < 3) {
+		/* The peer may have straddled the header across segments */
+		i = read(svc, header + n, 3 - n);
+		if (i < 0 && errno == EAGAIN) {
+			continue;
+		}
+		if (i <= 0) {
+			ast_log(LOG_WARNING, "Failed to read data length from AudioSocket\n");
+			return NULL;
+		}
+		n += i;
+	}
+
+	kind = header[0];
 	if (kind == 0x00) {
 		/* AudioSocket ended by remote */
 		return NULL;
@@ -265,18 +292,7 @@ struct ast_frame *ast_audiosocket_receive_frame(const int svc)
 		not_audio = 1;
 	}
 
-	n = read(svc, &len_high, 1);
-	if (n != 1) {
-		ast_log(LOG_WARNING, "Failed to read data length from AudioSocket\n");
-		return NULL;
-	}
-	len += len_high * 256;
-	n = read(svc, &len_low, 1);
-	if (n != 1) {
-		ast_log(LOG_WARNING, "Failed to read data length from AudioSocket\n");
-		return NULL;
-	}
-	len += len_low;
+	len = header[1] * 256 + header[2];
 
 	if (len < 1) {
 		return &ast_null_frame;
@@ -68,9 +68,43 @@
 #define RES_CONFIG_LDAP_CONF "res_ldap.conf"
 #define RES_CONFIG_LDAP_DEFAULT_BASEDN "asterisk"
 
-AST_MUTEX_DEFINE_STATIC(ldap_lock);
+/*! \brief Default and upper bound for the number of pooled connections */
+#define LDAP_POOL_DEFAULT_SIZE 5
+#define LDAP_POOL_MAX_SIZE 32
+/*! \brief Probe a pooled connection that has sat idle for longer than this */
+#define LDAP_POOL_IDLE_PROBE_SEC 60
+/*! \brief Default number of entries requested per page (RFC 2696) */
+#define LDAP_PAGE_DEFAULT_SIZE 1000
+
+/*! \brief Guards the table configs and connection parameters.
+ *
+ * Queries take it for reading so they can run concurrently on separate
+ * pooled connections; config load/reload/unload take it for writing.
+ */
+AST_RWLOCK_DEFINE_STATIC(ldap_lock);
+
+/*! \brief One pooled directory connection
+ *
+ * Checked out for the duration of a single query and returned afterwards.
+ */
+struct ldap_conn {
+	AST_LIST_ENTRY(ldap_conn) list;
+	LDAP *ld;                /*!< bound handle, NULL until (re)connected */
+	time_t connect_time;
+	time_t last_used;        /*!< when this connection was last returned */
+	unsigned int generation; /*!< pool generation the bind belongs to */
+};
+
+AST_MUTEX_DEFINE_STATIC(ldap_pool_lock);
+static AST_LIST_HEAD_NOLOCK_STATIC(ldap_conn_pool, ldap_conn);
+static ast_cond_t ldap_pool_cond;
+static unsigned int ldap_pool_size = LDAP_POOL_DEFAULT_SIZE;
+static unsigned int ldap_pool_open;  /*!< connections idle plus checked out */
+static unsigned int ldap_pool_idle;
+/*! \brief Bumped on reload so stale binds are dropped at next checkout */
+static unsigned int ldap_pool_generation;
+static unsigned int page_size = LDAP_PAGE_DEFAULT_SIZE;
 
-static LDAP *ldapConn;
 static char url[512];
 static char user[512];
 static char pass[512];
@@ -79,7 +113,7 @@ static int version;
 static time_t connect_time;
 
 static int parse_config(void);
-static int ldap_reconnect(void);
+static int ldap_reconnect_conn(struct ldap_conn *conn);
 static char *realtime_ldap_status(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a);
 
 struct category_and_metric {
@@ -305,8 +339,8 @@ static const char *convert_attribute_name_from_ldap(struct ldap_table_config *ta
  * \note Should be locked before using it
  * \return a linked list of ast_variable variables.
  */
-static struct ast_variable *realtime_ldap_entry_to_var(struct ldap_table_config *table_config,
-	LDAPMessage *ldap_entry)
+static struct ast_variable *realtime_ldap_entry_to_var(LDAP *ld,
+	struct ldap_table_config *table_config, LDAPMessage *ldap_entry)
 {
 	BerElement *ber = NULL;
 	struct ast_variable *var = NULL;
@@ -319,14 +353,14 @@ static struct ast_variable *realtime_ldap_entry_to_var(struct ldap_table_config
 	struct berval *value;
 	int pos = 0;
 
-	ldap_attribute_name = ldap_first_attribute(ldapConn, ldap_entry, &ber);
+	ldap_attribute_name = ldap_first_attribute(ld, ldap_entry, &ber);
 
 	while (ldap_attribute_name) {
 		struct berval **values = NULL;
 		const char *attribute_name = convert_attribute_name_from_ldap(table_config, ldap_attribute_name);
 		int is_realmed_password_attribute = strcasecmp(attribute_name, "md5secret") == 0;
 
-		values = ldap_get_values_len(ldapConn, ldap_entry, ldap_attribute_name); /* these are freed at the end */
+		values = ldap_get_values_len(ld, ldap_entry, ldap_attribute_name); /* these are freed at the end */
 		if (values) {
 			struct berval **v;
 			char *valptr;
@@ -378,7 +412,7 @@ static struct ast_variable *realtime_ldap_entry_to_var(struct ldap_table_config
 			ldap_value_free_len(values);
 		}
 		ldap_memfree(ldap_attribute_name);
-		ldap_attribute_name = ldap_next_attribute(ldapConn, ldap_entry, ber);
+		ldap_attribute_name = ldap_next_attribute(ld, ldap_entry, ber);
 	}
 	ber_free(ber, 0);
 
@@ -391,8 +425,9 @@ static struct ast_variable *realtime_ldap_entry_to_var(struct ldap_table_config
  *
  * \return \a vars - an array of ast_variable variables terminated with a null.
  */
-static struct ast_variable **realtime_ldap_result_to_vars(struct ldap_table_config *table_config,
-	LDAPMessage *ldap_result_msg, unsigned int *entries_count_ptr)
+static struct ast_variable **realtime_ldap_result_to_vars(LDAP *ld,
+	struct ldap_table_config *table_config, LDAPMessage *ldap_result_msg,
+	unsigned int *entries_count_ptr)
 {
 	struct ast_variable **vars;
 	int i = 0;
@@ -409,12 +444,12 @@ static struct ast_variable **realtime_ldap_result_to_vars(struct ldap_table_conf
 
 	/*! \brief First find the total count
 	 */
-	ldap_entry = ldap_first_entry(ldapConn, ldap_result_msg);
+	ldap_entry = ldap_first_entry(ld, ldap_result_msg);
 
 	for (tot_count = 0; ldap_entry; tot_count++) {
-		struct ast_variable *tmp = realtime_ldap_entry_to_var(table_config, ldap_entry);
+		struct ast_variable *tmp = realtime_ldap_entry_to_var(ld, table_config, ldap_entry);
 		tot_count += semicolon_count_var(tmp);
-		ldap_entry = ldap_next_entry(ldapConn, ldap_entry);
+		ldap_entry = ldap_next_entry(ld, ldap_entry);
 		ast_variables_destroy(tmp);
 	}
 
@@ -430,7 +465,7 @@ static struct ast_variable **realtime_ldap_result_to_vars(struct ldap_table_conf
 	 */
 	vars = ast_calloc(tot_count + 1, sizeof(struct ast_variable *));
 
-	ldap_entry = ldap_first_entry(ldapConn, ldap_result_msg);
+	ldap_entry = ldap_first_entry(ld, ldap_result_msg);
 
 	i = 0;
 
@@ -445,14 +480,14 @@ static struct ast_variable **realtime_ldap_result_to_vars(struct ldap_table_conf
 		do { /* while delim_count */
 
 			/* Starting new static var */
-			char *ldap_attribute_name = ldap_first_attribute(ldapConn, ldap_entry, &ber);
+			char *ldap_attribute_name = ldap_first_attribute(ld, ldap_entry, &ber);
 			struct berval *value;
 			while (ldap_attribute_name) {
 				const char *attribute_name = convert_attribute_name_from_ldap(table_config, ldap_attribute_name);
 				int is_realmed_password_attribute = strcasecmp(attribute_name, "md5secret") == 0;
 				struct berval **values = NULL;
 
-				values = ldap_get_values_len(ldapConn, ldap_entry, ldap_attribute_name);
+				values = ldap_get_values_len(ld, ldap_entry, ldap_attribute_name);
 				if (values) {
 					struct berval **v;
 					char *valptr;
@@ -546,7 +581,7 @@ static struct ast_variable **realtime_ldap_result_to_vars(struct ldap_table_conf
 					ldap_value_free_len(values);
 				}/*!< if (values) */
 				ldap_memfree(ldap_attribute_name);
-				ldap_attribute_name = ldap_next_attribute(ldapConn, ldap_entry, ber);
+				ldap_attribute_name = ldap_next_attribute(ld, ldap_entry, ber);
 			} /*!< while (ldap_attribute_name) */
 			ber_free(ber, 0);
 			if (static_table_config == table_config) {
@@ -570,12 +605,72 @@ static struct ast_variable **realtime_ldap_result_to_vars(struct ldap_table_conf
 			vars[entry_index++] = var;
 			prev = NULL;
 		}
-		ldap_entry = ldap_next_entry(ldapConn, ldap_entry);
+		ldap_entry = ldap_next_entry(ld, ldap_entry);
 	} /*!< end for loop over ldap_entry */
 
 	return vars;
 }
 
+/*! \brief Free a NULL terminated array of variable lists
+ */
+static void vars_destroy(struct ast_variable **vars)
+{
+	struct ast_variable **p;
+
+	if (!vars) {
+		return;
+	}
+	for (p = vars; *p; p++) {
+		ast_variables_destroy(*p);
+	}
+	ast_free(vars);
+}
+
+/*! \brief Merge one page of results into the accumulated \a vars array
+ *
+ * Takes ownership of \a src: its entries are moved into the returned
+ * array and the source array itself is freed.
+ *
+ * \param dst the accumulated array so far (may be NULL for the first page)
+ * \param dst_used in/out count of entries in \a dst
+ * \param src the page to append
+ *
+ * \return the (possibly reallocated) destination array.  On allocation
+ * failure the page is destroyed and \a dst is returned unchanged.
+ */
+static struct ast_variable **vars_append(struct ast_variable **dst,
+	size_t *dst_used, struct ast_variable **src)
+{
+	size_t src_used = 0;
+	struct ast_variable **merged;
+
+	if (!src) {
+		return dst;
+	}
+
+	while (src[src_used]) {
+		src_used++;
+	}
+
+	if (!dst) {
+		*dst_used = src_used;
+		return src;
+	}
+
+	merged = ast_realloc(dst, (*dst_used + src_used + 1) * sizeof(*merged));
+	if (!merged) {
+		vars_destroy(src);
+		return dst;
+	}
+
+	/* Copy the NULL terminator along with the entries. */
+	memcpy(merged + *dst_used, src, (src_used + 1) * sizeof(*src));
+	*dst_used += src_used;
+	ast_free(src);
+
+	return merged;
+}
+
 
 /*! \brief Check if we have a connection error
  */
@@ -584,6 +679,154 @@ static int is_ldap_connect_error(int err)
 	return (err == LDAP_SERVER_DOWN || err == LDAP_TIMEOUT || err == LDAP_CONNECT_ERROR);
 }
 
+/*! \brief Probe a pooled connection that has been idle for a while
+ *
+ * Directory servers routinely close connections that sit idle.  A cheap
+ * root-DSE read tells us whether the handle is still usable before we
+ * spend a query (and its retries) finding out the hard way.
+ */
+static void ldap_conn_check(struct ldap_conn *conn)
+{
+	LDAPMessage *ldap_result_msg = NULL;
+	struct timeval timeout = { 5, 0 };
+	int result;
+
+	if (time(NULL) - conn->last_used < LDAP_POOL_IDLE_PROBE_SEC) {
+		return;
+	}
+
+	result = ldap_search_ext_s(conn->ld, "", LDAP_SCOPE_BASE, "(objectclass=*)",
+			NULL, 0, NULL, NULL, &timeout, LDAP_NO_LIMIT, &ldap_result_msg);
+	if (ldap_result_msg) {
+		ldap_msgfree(ldap_result_msg);
+	}
+	if (is_ldap_connect_error(result)) {
+		ast_debug(2, "Dropping stale pooled connection: %s\n", ldap_err2string(result));
+		ldap_unbind_ext_s(conn->ld, NULL, NULL);
+		conn->ld = NULL;
+	}
+}
+
+/*! \brief Check a connection out of the pool
+ *
+ * Hands out an idle connection when one is available, opens a new slot
+ * while the pool is below its configured size, and otherwise waits for a
+ * query in flight to finish with its connection.
+ *
+ * \note The returned connection may still need a (re)bind; the caller is
+ * expected to run it through ldap_reconnect_conn().
+ *
+ * \return a connection, or NULL on allocation failure.
+ */
+static struct ldap_conn *ldap_conn_get(void)
+{
+	struct ldap_conn *conn;
+	unsigned int generation;
+
+	ast_mutex_lock(&ldap_pool_lock);
+	for (;;) {
+		conn = AST_LIST_REMOVE_HEAD(&ldap_conn_pool, list);
+		if (conn) {
+			ldap_pool_idle--;
+			break;
+		}
+		if (ldap_pool_open < ldap_pool_size) {
+			conn = ast_calloc(1, sizeof(*conn));
+			if (!conn) {
+				ast_mutex_unlock(&ldap_pool_lock);
+				return NULL;
+			}
+			ldap_pool_open++;
+			break;
+		}
+		ast_cond_wait(&ldap_pool_cond, &ldap_pool_lock);
+	}
+	generation = ldap_pool_generation;
+	ast_mutex_unlock(&ldap_pool_lock);
+
+	if (conn->ld && conn->generation != generation) {
+		/* Bound before the last reload; URL or credentials may have changed. */
+		ldap_unbind_ext_s(conn->ld, NULL, NULL);
+		conn->ld = NULL;
+	}
+	if (conn->ld) {
+		ldap_conn_check(conn);
+	}
+
+	return conn;
+}
+
+/*! \brief Return a connection to the pool
+ *
+ * \param conn the connection being returned
+ * \param broken non-zero when the last operation failed with a connection
+ * error, in which case the bind is discarded rather than recycled
+ */
+static void ldap_conn_release(struct ldap_conn *conn, int broken)
+{
+	if (broken && conn->ld) {
+		ldap_unbind_ext_s(conn->ld, NULL, NULL);
+		conn->ld = NULL;
+	}
+	conn->last_used = time(NULL);
+
+	ast_mutex_lock(&ldap_pool_lock);
+	if (ldap_pool_open > ldap_pool_size) {
+		/* The pool shrank on reload; retire this slot instead of recycling it. */
+		if (conn->ld) {
+			ldap_unbind_ext_s(conn->ld, NULL, NULL);
+		}
+		ast_free(conn);
+		ldap_pool_open--;
+	} else {
+		AST_LIST_INSERT_HEAD(&ldap_conn_pool, conn, list);
+		ldap_pool_idle++;
+	}
+	ast_cond_signal(&ldap_pool_cond);
+	ast_mutex_unlock(&ldap_pool_lock);
+}
+
+/*! \brief Drop every pooled bind after a configuration change
+ *
+ * Idle connections are unbound in place; connections currently checked
+ * out see the generation bump at their next checkout.
+ */
+static void ldap_pool_invalidate(void)
+{
+	struct ldap_conn *conn;
+
+	ast_mutex_lock(&ldap_pool_lock);
+	ldap_pool_generation++;
+	AST_LIST_TRAVERSE(&ldap_conn_pool, conn, list) {
+		if (conn->ld) {
+			ldap_unbind_ext_s(conn->ld, NULL, NULL);
+			conn->ld = NULL;
+		}
+	}
+	ast_mutex_unlock(&ldap_pool_lock);
+}
+
+/*! \brief Tear the pool down
+ *
+ * \note Callers hold ldap_lock for writing, so no query has a connection
+ * checked out and every open connection is on the idle list.
+ */
+static void ldap_pool_shutdown(void)
+{
+	struct ldap_conn *conn;
+
+	ast_mutex_lock(&ldap_pool_lock);
+	while ((conn = AST_LIST_REMOVE_HEAD(&ldap_conn_pool, list))) {
+		if (conn->ld) {
+			ldap_unbind_ext_s(conn->ld, NULL, NULL);
+		}
+		ast_free(conn);
+		ldap_pool_open--;
+	}
+	ldap_pool_idle = 0;
+	ast_mutex_unlock(&ldap_pool_lock);
+}
+
 /*! \brief Get LDAP entry by dn and return attributes as variables
  *
  * Should be locked before using it
@@ -591,7 +834,8 @@ static int is_ldap_connect_error(int err)
  * This is used for setting the default values of an object
  * i.e., with accountBaseDN
 */
-static struct ast_variable *ldap_loadentry(struct ldap_table_config *table_config,
+static struct ast_variable *ldap_loadentry(struct ldap_conn *conn,
+					   struct ldap_table_config *table_config,
 					   const char *dn)
 {
 	if (!table_config) {
@@ -607,18 +851,18 @@ static struct ast_variable *ldap_loadentry(struct ldap_table_config *table_confi
 		ast_debug(2, "ldap_loadentry dn=%s\n", dn);
 
 		do {
-			result = ldap_search_ext_s(ldapConn, dn, LDAP_SCOPE_BASE,
+			result = ldap_search_ext_s(conn->ld, dn, LDAP_SCOPE_BASE,
 					   "(objectclass=*)", NULL, 0, NULL, NULL, NULL, LDAP_NO_LIMIT, &ldap_result_msg);
 			if (result != LDAP_SUCCESS && is_ldap_connect_error(result)) {
 				ast_log(LOG_WARNING, "Failed to query directory. Try %d/3\n", tries + 1);
 				tries++;
 				if (tries < 3) {
 					usleep(500000L * tries);
-					if (ldapConn) {
-						ldap_unbind_ext_s(ldapConn, NULL, NULL);
-						ldapConn = NULL;
+					if (conn->ld) {
+						ldap_unbind_ext_s(conn->ld, NULL, NULL);
+						conn->ld = NULL;
 					}
-					if (!ldap_reconnect()) {
+					if (!ldap_reconnect_conn(conn)) {
 						break;
 					}
 				}
@@ -628,16 +872,15 @@ static struct ast_variable *ldap_loadentry(struct ldap_table_config *table_confi
 		if (result != LDAP_SUCCESS) {
 			ast_log(LOG_WARNING, "Failed to query directory. Error: %s.\n", ldap_err2string(result));
 			ast_debug(2, "dn=%s\n", dn);
-			ast_mutex_unlock(&ldap_lock);
 			return NULL;
 		} else {
 			int num_entry = 0;
 			unsigned int *entries_count_ptr = NULL; /*!< not using this */
 
-			if ((num_entry = ldap_count_entries(ldapConn, ldap_result_msg)) > 0) {
+			if ((num_entry = ldap_count_entries(conn->ld, ldap_result_msg)) > 0) {
 				ast_debug(3, "num_entry: %d\n", num_entry);
 
-				vars = realtime_ldap_result_to_vars(table_config, ldap_result_msg, entries_count_ptr);
+				vars = realtime_ldap_result_to_vars(conn->ld, table_config, ldap_result_msg, entries_count_ptr);
 				if (num_entry > 1) {
 					ast_log(LOG_NOTICE, "More than one entry for dn=%s. Take only 1st one\n", dn);
 				}
@@ -813,10 +1056,14 @@ static struct ast_variable **realtime_ldap_base_ap(unsigned int *entries_count_p
 	const char *basedn, const char *table_name, const struct ast_variable *fields)
 {
 	struct ast_variable **vars = NULL;
+	size_t vars_used = 0;
+	unsigned int total_count = 0;
 	const struct ast_variable *field = fields;
 	struct ldap_table_config *table_config = NULL;
+	struct ldap_conn *conn = NULL;
 	char *clean_basedn = cleaned_basedn(NULL, basedn);
 	struct ast_str *filter = NULL;
+	struct berval *cookie = NULL;
 	int tries = 0;
 	int result = 0;
 	LDAPMessage *ldap_result_msg = NULL;
@@ -834,11 +1081,15 @@ static struct ast_variable **realtime_ldap_base_ap(unsigned int *entries_count_p
 		return NULL;
 	}
 
-	ast_mutex_lock(&ldap_lock);
+	ast_rwlock_rdlock(&ldap_lock);
 
 	/* We now have our complete statement; Lets connect to the server and execute it.  */
-	if (!ldap_reconnect()) {
-		ast_mutex_unlock(&ldap_lock);
+	conn = ldap_conn_get();
+	if (!conn || !ldap_reconnect_conn(conn)) {
+		if (conn) {
+			ldap_conn_release(conn, 0);
+		}
+		ast_rwlock_unlock(&ldap_lock);
 		ast_free(clean_basedn);
 		return NULL;
 	}
@@ -846,52 +1097,132 @@ static struct ast_variable **realtime_ldap_base_ap(unsigned int *entries_count_p
 	table_config = table_config_for_table_name(table_name);
 	if (!table_config) {
 		ast_log(LOG_WARNING, "No table named '%s'.\n", table_name);
-		ast_mutex_unlock(&ldap_lock);
+		ldap_conn_release(conn, 0);
+		ast_rwlock_unlock(&ldap_lock);
 		ast_free(clean_basedn);
 		return NULL;
 	}
 
 	filter = create_lookup_filter(table_config, fields);
 	if (!filter) {
-		ast_mutex_unlock(&ldap_lock);
+		ldap_conn_release(conn, 0);
+		ast_rwlock_unlock(&ldap_lock);
 		ast_free(clean_basedn);
 		return NULL;
 	}
 
 	do {
-		/* freeing ldap_result further down */
-		result = ldap_search_ext_s(ldapConn, clean_basedn,
-				  LDAP_SCOPE_SUBTREE, ast_str_buffer(filter), NULL, 0, NULL, NULL, NULL, LDAP_NO_LIMIT,
-				  &ldap_result_msg);
+		int morepages;
+
+		/* A pagination pass is all-or-nothing: a connection error in the
+		 * middle of it throws away the pages collected so far and the whole
+		 * search starts over on a fresh bind. */
+		vars_destroy(vars);
+		vars = NULL;
+		vars_used = 0;
+		total_count = 0;
+		if (cookie) {
+			ber_bvfree(cookie);
+			cookie = NULL;
+		}
+
+		do {
+			LDAPControl *page_control = NULL;
+			LDAPControl *server_controls[2] = { NULL, NULL };
+
+			morepages = 0;
+
+			if (page_size) {
+				if (ldap_create_page_control(conn->ld, page_size, cookie, 0,
+						&page_control) == LDAP_SUCCESS) {
+					server_controls[0] = page_control;
+				} else {
+					ast_log(LOG_WARNING, "Failed to create paged results control; retrieving in one response.\n");
+				}
+			}
+
+			/* freeing ldap_result further down */
+			result = ldap_search_ext_s(conn->ld, clean_basedn,
+					  LDAP_SCOPE_SUBTREE, ast_str_buffer(filter), NULL, 0,
+					  page_control ? server_controls : NULL, NULL, NULL, LDAP_NO_LIMIT,
+					  &ldap_result_msg);
+
+			if (result == LDAP_SUCCESS && page_control) {
+				LDAPControl **response_controls = NULL;
+
+				if (ldap_parse_result(conn->ld, ldap_result_msg, NULL, NULL, NULL,
+						NULL, &response_controls, 0) == LDAP_SUCCESS
+					&& response_controls) {
+					LDAPControl *response = ldap_control_find(
+						LDAP_CONTROL_PAGEDRESULTS, response_controls, NULL);
+
+					if (response) {
+						struct berval *new_cookie = NULL;
+
+						if (ldap_parse_pageresponse_control(conn->ld, response,
+								NULL, &new_cookie) == LDAP_SUCCESS) {
+							if (cookie) {
+								ber_bvfree(cookie);
+							}
+							cookie = new_cookie;
+							morepages = cookie && cookie->bv_len > 0;
+						}
+					}
+					ldap_controls_free(response_controls);
+				}
+			}
+			if (page_control) {
+				ldap_control_free(page_control);
+			}
+
+			if (result == LDAP_SUCCESS
+				&& ldap_count_entries(conn->ld, ldap_result_msg) > 0) {
+				unsigned int page_count = 0;
+				struct ast_variable **page_vars;
+
+				/* is this a static var or some other? they are handled different for delimited values */
+				page_vars = realtime_ldap_result_to_vars(conn->ld, table_config,
+					ldap_result_msg, &page_count);
+				total_count += page_count;
+				vars = vars_append(vars, &vars_used, page_vars);
+			}
+			ldap_msgfree(ldap_result_msg);
+			ldap_result_msg = NULL;
+		} while (result == LDAP_SUCCESS && morepages);
+
 		if (result != LDAP_SUCCESS && is_ldap_connect_error(result)) {
 			ast_debug(1, "Failed to query directory. Try %d/10\n", tries + 1);
 			if (++tries < 10) {
 				usleep(1);
-				if (ldapConn) {
-					ldap_unbind_ext_s(ldapConn, NULL, NULL);
-					ldapConn = NULL;
+				if (conn->ld) {
+					ldap_unbind_ext_s(conn->ld, NULL, NULL);
+					conn->ld = NULL;
 				}
-				if (!ldap_reconnect()) {
+				if (!ldap_reconnect_conn(conn)) {
 					break;
 				}
 			}
 		}
 	} while (result != LDAP_SUCCESS && tries < 10 && is_ldap_connect_error(result));
 
+	if (cookie) {
+		ber_bvfree(cookie);
+		cookie = NULL;
+	}
+
 	if (result != LDAP_SUCCESS) {
 		ast_log(LOG_WARNING, "Failed to query directory. Error: %s.\n", ldap_err2string(result));
 		ast_log(LOG_WARNING, "Query: %s\n", ast_str_buffer(filter));
+		vars_destroy(vars);
+		vars = NULL;
 	} else {
-		/* this is where we create the variables from the search result
-		 * freeing this \a vars outside this function */
-		if (ldap_count_entries(ldapConn, ldap_result_msg) > 0) {
-			/* is this a static var or some other? they are handled different for delimited values */
-			vars = realtime_ldap_result_to_vars(table_config, ldap_result_msg, entries_count_ptr);
-		} else {
+		/* freeing this \a vars outside this function */
+		if (!vars) {
 			ast_debug(1, "Could not find any entry matching %s in base dn %s.\n", ast_str_buffer(filter), clean_basedn);
 		}
-
-		ldap_msgfree(ldap_result_msg);
+		if (entries_count_ptr) {
+			*entries_count_ptr = total_count;
+		}
 
 		/*! \todo get the default variables from the accountBaseDN, not implemented with delimited values
 		 */
@@ -903,7 +1234,7 @@ static struct ast_variable **realtime_ldap_base_ap(unsigned int *entries_count_p
 				while (tmp) {
 					if (strcasecmp(tmp->name, "accountBaseDN") == 0) {
 						/* Get the variable to compare with for the defaults */
-						struct ast_variable *base_var = ldap_loadentry(table_config, tmp->value);
+						struct ast_variable *base_var = ldap_loadentry(conn, table_config, tmp->value);
 
 						while (base_var) {
 							struct ast_variable *next = base_var->next;
@@ -954,7 +1285,8 @@ static struct ast_variable **realtime_ldap_base_ap(unsigned int *entries_count_p
 	ast_free(filter);
 	ast_free(clean_basedn);
 
-	ast_mutex_unlock(&ldap_lock);
+	ldap_conn_release(conn, result != LDAP_SUCCESS && is_ldap_connect_error(result));
+	ast_rwlock_unlock(&ldap_lock);
 
 	return vars;
 }
@@ -1396,12 +1728,12 @@ static LDAPMod *ldap_mod_find(LDAPMod **modifications, const char *lookup)
  *
  * \returns 1 if the attribute was found, 0 otherwise.
  */
-static int ldap_entry_has_attribute(LDAPMessage *entry, const char *lookup)
+static int ldap_entry_has_attribute(LDAP *ld, LDAPMessage *entry, const char *lookup)
 {
 	BerElement *ber = NULL;
 	char *attribute;
 
-	attribute = ldap_first_attribute(ldapConn, entry, &ber);
+	attribute = ldap_first_attribute(ld, entry, &ber);
 	while (attribute) {
 		if (!strcasecmp(attribute, lookup)) {
 			ldap_memfree(attribute);
@@ -1409,7 +1741,7 @@ static int ldap_entry_has_attribute(LDAPMessage *entry, const char *lookup)
 			return 1;
 		}
 		ldap_memfree(attribute);
-		attribute = ldap_next_attribute(ldapConn, entry, ber);
+		attribute = ldap_next_attribute(ld, entry, ber);
 	}
 	ber_free(ber, 0);
 	return 0;
@@ -1431,14 +1763,14 @@ static int ldap_entry_has_attribute(LDAPMessage *entry, const char *lookup)
  *
  * \returns an LDAPMod * if modifications needed to be removed, NULL otherwise.
  */
-static LDAPMod **massage_mods_for_entry(LDAPMessage *entry, LDAPMod **mods)
+static LDAPMod **massage_mods_for_entry(LDAP *ld, LDAPMessage *entry, LDAPMod **mods)
 {
 	size_t k, i, remove_count;
 	LDAPMod **copies;
 
 	for (i = remove_count = 0; mods[i]; i++) {
 		if (mods[i]->mod_op == LDAP_MOD_DELETE
-			&& !ldap_entry_has_attribute(entry, mods[i]->mod_type)) {
+			&& !ldap_entry_has_attribute(ld, entry, mods[i]->mod_type)) {
 			remove_count++;
 		}
 	}
@@ -1455,7 +1787,7 @@ static LDAPMod **massage_mods_for_entry(LDAPMessage *entry, LDAPMod **mods)
 
 	for (i = k = 0; mods[i]; i++) {
 		if (mods[i]->mod_op != LDAP_MOD_DELETE
-			|| ldap_entry_has_attribute(entry, mods[i]->mod_type)) {
+			|| ldap_entry_has_attribute(ld, entry, mods[i]->mod_type)) {
 			copies[k] = ldap_mod_duplicate(mods[i]);
 			if (!copies[k]) {
 				ast_log(LOG_ERROR, "Memory allocation failure massaging LDAP modification\n");
@@ -1494,6 +1826,7 @@ static int update2_ldap(const char *basedn, const char *table_name, const struct
 {
 	const struct ast_variable *field;
 	struct ldap_table_config *table_config = NULL;
+	struct ldap_conn *conn = NULL;
 	char *clean_basedn = NULL;
 	struct ast_str *filter = NULL;
 	int search_result = 0;
@@ -1516,18 +1849,23 @@ static int update2_ldap(const char *basedn, const char *table_name, const struct
 		return res;
 	}
 
-	ast_mutex_lock(&ldap_lock);
+	ast_rwlock_rdlock(&ldap_lock);
 
 	/* We now have our complete statement; Lets connect to the server and execute it.  */
-	if (!ldap_reconnect()) {
-		ast_mutex_unlock(&ldap_lock);
+	conn = ldap_conn_get();
+	if (!conn || !ldap_reconnect_conn(conn)) {
+		if (conn) {
+			ldap_conn_release(conn, 0);
+		}
+		ast_rwlock_unlock(&ldap_lock);
 		return res;
 	}
 
 	table_config = table_config_for_table_name(table_name);
 	if (!table_config) {
 		ast_log(LOG_ERROR, "No table named '%s'.\n", table_name);
-		ast_mutex_unlock(&ldap_lock);
+		ldap_conn_release(conn, 0);
+		ast_rwlock_unlock(&ldap_lock);
 		return res;
 	}
 
@@ -1535,7 +1873,8 @@ static int update2_ldap(const char *basedn, const char *table_name, const struct
 
 	filter = create_lookup_filter(table_config, lookup_fields);
 	if (!filter) {
-		ast_mutex_unlock(&ldap_lock);
+		ldap_conn_release(conn, 0);
+		ast_rwlock_unlock(&ldap_lock);
 		ast_free(clean_basedn);
 		return res;
 	}
@@ -1547,7 +1886,7 @@ static int update2_ldap(const char *basedn, const char *table_name, const struct
 
 	do {
 		search_result = ldap_search_ext_s(
-				ldapConn,
+				conn->ld,
 				clean_basedn,
 				LDAP_SCOPE_SUBTREE,
 				ast_str_buffer(filter),
@@ -1559,11 +1898,11 @@ static int update2_ldap(const char *basedn, const char *table_name, const struct
 			tries++;
 			if (tries < 3) {
 				usleep(500000L * tries);
-				if (ldapConn) {
-					ldap_unbind_ext_s(ldapConn, NULL, NULL);
-					ldapConn = NULL;
+				if (conn->ld) {
+					ldap_unbind_ext_s(conn->ld, NULL, NULL);
+					conn->ld = NULL;
 				}
-				if (!ldap_reconnect()) {
+				if (!ldap_reconnect_conn(conn)) {
 					break;
 				}
 			}
@@ -1576,7 +1915,7 @@ static int update2_ldap(const char *basedn, const char *table_name, const struct
 		goto early_bailout;
 	}
 
-	entry_count = ldap_count_entries(ldapConn, ldap_result_msg);
+	entry_count = ldap_count_entries(conn->ld, ldap_result_msg);
 	if (!entry_count) {
 		/* Nothing found, nothing to update */
 		res = 0;
@@ -1632,13 +1971,13 @@ static int update2_ldap(const char *basedn, const char *table_name, const struct
 		}
 	}
 
-	for (ldap_entry = ldap_first_entry(ldapConn, ldap_result_msg);
+	for (ldap_entry = ldap_first_entry(conn->ld, ldap_result_msg);
 		ldap_entry;
-		ldap_entry = ldap_next_entry(ldapConn, ldap_entry)) {
+		ldap_entry = ldap_next_entry(conn->ld, ldap_entry)) {
 		int error;
 		LDAPMod **massaged, **working;
 
-		char *dn = ldap_get_dn(ldapConn, ldap_entry);
+		char *dn = ldap_get_dn(conn->ld, ldap_entry);
 		if (!dn) {
 			ast_log(LOG_ERROR, "Memory allocation failure\n");
 			goto late_bailout;
@@ -1646,7 +1985,7 @@ static int update2_ldap(const char *basedn, const char *table_name, const struct
 
 		working = modifications;
 
-		massaged = massage_mods_for_entry(ldap_entry, modifications);
+		massaged = massage_mods_for_entry(conn->ld, ldap_entry, modifications);
 		if (massaged) {
 			/* Did we massage everything out of the list? */
 			if (!massaged[0]) {
@@ -1658,7 +1997,7 @@ static int update2_ldap(const char *basedn, const char *table_name, const struct
 			working = massaged;
 		}
 
-		if ((error = ldap_modify_ext_s(ldapConn, dn, working, NULL, NULL)) != LDAP_SUCCESS)  {
+		if ((error = ldap_modify_ext_s(conn->ld, dn, working, NULL, NULL)) != LDAP_SUCCESS)  {
 			ast_log(LOG_ERROR, "Couldn't modify dn:%s because %s", dn, ldap_err2string(error));
 		}
 
@@ -1678,7 +2017,8 @@ early_bailout:
 	ldap_msgfree(ldap_result_msg);
 	ast_free(filter);
 	ast_free(clean_basedn);
-	ast_mutex_unlock(&ldap_lock);
+	ldap_conn_release(conn, search_result != LDAP_SUCCESS && is_ldap_connect_error(search_result));
+	ast_rwlock_unlock(&ldap_lock);
 
 	return res;
 }
@@ -1716,22 +2056,31 @@ static struct ast_config_engine ldap_engine = {
  */
 static int load_module(void)
 {
+	struct ldap_conn *conn;
+
+	ast_cond_init(&ldap_pool_cond, NULL);
+
 	if (parse_config() < 0) {
 		ast_log(LOG_ERROR, "Cannot load LDAP RealTime driver.\n");
 		return 0;
 	}
 
-	ast_mutex_lock(&ldap_lock);
+	ast_rwlock_wrlock(&ldap_lock);
 
-	if (!ldap_reconnect())  {
+	/* Warm one pooled connection so misconfiguration shows up at load time. */
+	conn = ldap_conn_get();
+	if (!conn || !ldap_reconnect_conn(conn)) {
 		ast_log(LOG_WARNING, "Couldn't establish connection to LDAP directory. Check debug.\n");
 	}
+	if (conn) {
+		ldap_conn_release(conn, 0);
+	}
 
 	ast_config_engine_register(&ldap_engine);
 	ast_verb(1, "LDAP RealTime driver loaded.\n");
 	ast_cli_register_multiple(ldap_cli, ARRAY_LEN(ldap_cli));
 
-	ast_mutex_unlock(&ldap_lock);
+	ast_rwlock_unlock(&ldap_lock);
 
 	return 0;
 }
@@ -1742,20 +2091,19 @@ static int load_module(void)
 static int unload_module(void)
 {
 	/* Aquire control before doing anything to the module itself. */
-	ast_mutex_lock(&ldap_lock);
+	ast_rwlock_wrlock(&ldap_lock);
 
 	table_configs_free();
 
-	if (ldapConn) {
-		ldap_unbind_ext_s(ldapConn, NULL, NULL);
-		ldapConn = NULL;
-	}
+	ldap_pool_shutdown();
 	ast_cli_unregister_multiple(ldap_cli, ARRAY_LEN(ldap_cli));
 	ast_config_engine_deregister(&ldap_engine);
 	ast_verb(1, "LDAP RealTime driver unloaded.\n");
 
 	/* Unlock so something else can destroy the lock. */
-	ast_mutex_unlock(&ldap_lock);
+	ast_rwlock_unlock(&ldap_lock);
+
+	ast_cond_destroy(&ldap_pool_cond);
 
 	return 0;
 }
@@ -1764,28 +2112,32 @@ static int unload_module(void)
  */
 static int reload(void)
 {
-	/* Aquire control before doing anything to the module itself. */
-	ast_mutex_lock(&ldap_lock);
+	struct ldap_conn *conn;
 
-	if (ldapConn) {
-		ldap_unbind_ext_s(ldapConn, NULL, NULL);
-		ldapConn = NULL;
-	}
+	/* Aquire control before doing anything to the module itself. */
+	ast_rwlock_wrlock(&ldap_lock);
 
 	if (parse_config() < 0) {
 		ast_log(LOG_NOTICE, "Cannot reload LDAP RealTime driver.\n");
-		ast_mutex_unlock(&ldap_lock);
+		ast_rwlock_unlock(&ldap_lock);
 		return 0;
 	}
 
-	if (!ldap_reconnect())  {
+	/* Existing binds may be against the old URL or credentials. */
+	ldap_pool_invalidate();
+
+	conn = ldap_conn_get();
+	if (!conn || !ldap_reconnect_conn(conn)) {
 		ast_log(LOG_WARNING, "Couldn't establish connection to your directory server. Check debug.\n");
 	}
+	if (conn) {
+		ldap_conn_release(conn, 0);
+	}
 
 	ast_verb(2, "LDAP RealTime driver reloaded.\n");
 
 	/* Done reloading. Release lock so others can now use driver. */
-	ast_mutex_unlock(&ldap_lock);
+	ast_rwlock_unlock(&ldap_lock);
 
 	return 0;
 }
@@ -1794,7 +2146,8 @@ static int config_can_be_inherited(const char *key)
 {
 	int i;
 	static const char * const config[] = {
-		"basedn", "host", "pass", "port", "protocol", "url", "user", "version", NULL
+		"basedn", "host", "pagesize", "pass", "pool_size", "port", "protocol",
+		"url", "user", "version", NULL
 	};
 
 	for (i = 0; config[i]; i++) {
@@ -1821,6 +2174,8 @@ static int parse_config(void)
 	pass[0] = '\0';
 	base_distinguished_name[0] = '\0';
 	version = 3;
+	ldap_pool_size = LDAP_POOL_DEFAULT_SIZE;
+	page_size = LDAP_PAGE_DEFAULT_SIZE;
 
 	config = ast_config_load(RES_CONFIG_LDAP_CONF, config_flags);
 	if (config == CONFIG_STATUS_FILEMISSING || config == CONFIG_STATUS_FILEINVALID) {
@@ -1873,6 +2228,24 @@ static int parse_config(void)
 		version = 3;
 	}
 
+	if ((s = ast_variable_retrieve(config, "_general", "pool_size"))) {
+		if (sscanf(s, "%30u", &ldap_pool_size) != 1
+			|| ldap_pool_size < 1 || ldap_pool_size > LDAP_POOL_MAX_SIZE) {
+			ast_log(LOG_WARNING, "Invalid pool_size '%s', using %d as default.\n",
+				s, LDAP_POOL_DEFAULT_SIZE);
+			ldap_pool_size = LDAP_POOL_DEFAULT_SIZE;
+		}
+	}
+
+	if ((s = ast_variable_retrieve(config, "_general", "pagesize"))) {
+		/* 0 disables paged retrieval */
+		if (sscanf(s, "%30u", &page_size) != 1) {
+			ast_log(LOG_WARNING, "Invalid pagesize '%s', using %d as default.\n",
+				s, LDAP_PAGE_DEFAULT_SIZE);
+			page_size = LDAP_PAGE_DEFAULT_SIZE;
+		}
+	}
+
 	table_configs_free();
 
 	while ((category_name = ast_category_browse(config, category_name))) {
@@ -1908,13 +2281,14 @@ static int parse_config(void)
 	return 1;
 }
 
-/*! \note ldap_lock should have been locked before calling this function. */
-static int ldap_reconnect(void)
+/*! \note ldap_lock should have been locked (at least for reading) before
+ * calling this function, as it reads the connection parameters. */
+static int ldap_reconnect_conn(struct ldap_conn *conn)
 {
 	int bind_result = 0;
 	struct berval cred;
 
-	if (ldapConn) {
+	if (conn->ld) {
 		ast_debug(2, "Everything seems fine.\n");
 		return 1;
 	}
@@ -1924,12 +2298,12 @@ static int ldap_reconnect(void)
 		return 0;
 	}
 
-	if (LDAP_SUCCESS != ldap_initialize(&ldapConn, url)) {
+	if (LDAP_SUCCESS != ldap_initialize(&conn->ld, url)) {
 		ast_log(LOG_ERROR, "Failed to init ldap connection to '%s'. Check debug for more info.\n", url);
 		return 0;
 	}
 
-	if (LDAP_OPT_SUCCESS != ldap_set_option(ldapConn, LDAP_OPT_PROTOCOL_VERSION, &version)) {
+	if (LDAP_OPT_SUCCESS != ldap_set_option(conn->ld, LDAP_OPT_PROTOCOL_VERSION, &version)) {
 		ast_log(LOG_WARNING, "Unable to set LDAP protocol version to %d, falling back to default.\n", version);
 	}
 
@@ -1937,21 +2311,23 @@ static int ldap_reconnect(void)
 		ast_debug(2, "bind to '%s' as user '%s'\n", url, user);
 		cred.bv_val = (char *) pass;
 		cred.bv_len = strlen(pass);
-		bind_result = ldap_sasl_bind_s(ldapConn, user, LDAP_SASL_SIMPLE, &cred, NULL, NULL, NULL);
+		bind_result = ldap_sasl_bind_s(conn->ld, user, LDAP_SASL_SIMPLE, &cred, NULL, NULL, NULL);
 	} else {
 		ast_debug(2, "bind %s anonymously\n", url);
 		cred.bv_val = NULL;
 		cred.bv_len = 0;
-		bind_result = ldap_sasl_bind_s(ldapConn, NULL, LDAP_SASL_SIMPLE, &cred, NULL, NULL, NULL);
+		bind_result = ldap_sasl_bind_s(conn->ld, NULL, LDAP_SASL_SIMPLE, &cred, NULL, NULL, NULL);
 	}
 	if (bind_result == LDAP_SUCCESS) {
 		ast_debug(2, "Successfully connected to directory.\n");
-		connect_time = time(NULL);
+		conn->connect_time = time(NULL);
+		conn->generation = ldap_pool_generation;
+		connect_time = conn->connect_time;
 		return 1;
 	} else {
 		ast_log(LOG_WARNING, "bind failed: %s\n", ldap_err2string(bind_result));
-		ldap_unbind_ext_s(ldapConn, NULL, NULL);
-		ldapConn = NULL;
+		ldap_unbind_ext_s(conn->ld, NULL, NULL);
+		conn->ld = NULL;
 		return 0;
 	}
 }
@@ -1963,6 +2339,7 @@ static char *realtime_ldap_status(struct ast_cli_entry *e, int cmd, struct ast_c
 {
 	struct ast_str *buf;
 	int ctimesec = time(NULL) - connect_time;
+	unsigned int pool_open, pool_idle, pool_max;
 
 	switch (cmd) {
 	case CLI_INIT:
@@ -1975,9 +2352,15 @@ static char *realtime_ldap_status(struct ast_cli_entry *e, int cmd, struct ast_c
 		return NULL;
 	}
 
-	if (!ldapConn)
+	if (!connect_time)
 		return CLI_FAILURE;
 
+	ast_mutex_lock(&ldap_pool_lock);
+	pool_open = ldap_pool_open;
+	pool_idle = ldap_pool_idle;
+	pool_max = ldap_pool_size;
+	ast_mutex_unlock(&ldap_pool_lock);
+
 	buf = ast_str_create(512);
 	if (!ast_strlen_zero(url)) {
 		ast_str_append(&buf, 0, "Connected to '%s', baseDN %s", url, base_distinguished_name);
@@ -1987,7 +2370,8 @@ static char *realtime_ldap_status(struct ast_cli_entry *e, int cmd, struct ast_c
 		ast_str_append(&buf, 0, " with username %s", user);
 	}
 
-	ast_str_append(&buf, 0, " for ");
+	ast_str_append(&buf, 0, " (%u of %u pooled connections open, %u idle) for ",
+		pool_open, pool_max, pool_idle);
 	ast_cli_print_timestr_fromseconds(a->fd, ctimesec, ast_str_buffer(buf));
 	ast_free(buf);
 
@@ -30,12 +30,41 @@
 	<support_level>core</support_level>
  ***/
 
+/*** DOCUMENTATION
+	<manager name="FileConvert" language="en_US">
+		<synopsis>
+			Convert an audio file from one format to another.
+		</synopsis>
+		<syntax>
+			<xi:include xpointer="xpointer(/docs/manager[@name='Login']/syntax/parameter[@name='ActionID'])" />
+			<parameter name="Filename" required="true">
+				<para>The file to convert from, including its format extension.
+				Relative paths are resolved against the Asterisk sounds
+				directory.</para>
+			</parameter>
+			<parameter name="DestFilename" required="true">
+				<para>The file to convert to, including its format extension.</para>
+			</parameter>
+		</syntax>
+		<description>
+			<para>Converts <replaceable>Filename</replaceable> into
+			<replaceable>DestFilename</replaceable>, transcoding between the
+			formats named by the two extensions.  This is the same conversion
+			performed by the <literal>file convert</literal> CLI command, made
+			available to AMI so bulk conversion jobs can be driven remotely;
+			each conversion runs on the AMI session's thread, so jobs may be
+			spread over several sessions to convert files in parallel.</para>
+		</description>
+	</manager>
+ ***/
+
 #include "asterisk.h"
 
 #include "asterisk/channel.h"
 #include "asterisk/module.h"
 #include "asterisk/cli.h"
 #include "asterisk/file.h"
+#include "asterisk/manager.h"
 
 /*! \brief Split the filename to basename and extension */
 static int split_ext(char *filename, char **name, char **ext)
@@ -55,60 +84,41 @@ static int split_ext(char *filename, char **name, char **ext)
 
 /*!
  * \brief Convert a file from one format to another
- * \param e CLI entry
- * \param cmd command number
- * \param a list of cli arguments
- * \retval CLI_SUCCESS on success.
- * \retval CLI_SHOWUSAGE or CLI_FAILURE on failure.
-*/
-static char *handle_cli_file_convert(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+ * \param file_in input filename, including format extension
+ * \param file_out output filename, including format extension
+ * \param duration_ms on success, how long the conversion took
+ * \param error buffer populated with an error message on failure
+ * \param error_len length of the buffer pointed to by \c error
+ * \retval 0 on success.
+ * \retval -1 on failure.
+ */
+static int file_convert(const char *file_in, const char *file_out, int *duration_ms, char *error, size_t error_len)
 {
-	char *ret = CLI_FAILURE;
+	int ret = -1;
 	struct ast_filestream *fs_in = NULL, *fs_out = NULL;
 	struct ast_frame *f;
 	struct timeval start;
-	int cost;
-	char *file_in = NULL, *file_out = NULL;
+	char *in, *out;
 	char *name_in, *ext_in, *name_out, *ext_out;
 
-	switch (cmd) {
-	case CLI_INIT:
-		e->command = "file convert";
-		e->usage =
-			"Usage: file convert <file_in> <file_out>\n"
-			"       Convert from file_in to file_out. If an absolute path\n"
-			"       is not given, the default Asterisk sounds directory\n"
-			"       will be used.\n\n"
-			"       Example:\n"
-			"           file convert tt-weasels.gsm tt-weasels.ulaw\n";
-		return NULL;
-	case CLI_GENERATE:
-		return NULL;
-	}
-
-	if (a->argc != 4 || ast_strlen_zero(a->argv[2]) || ast_strlen_zero(a->argv[3])) {
-		ret = CLI_SHOWUSAGE;
-		goto fail_out;
-	}
-
-	file_in = ast_strdupa(a->argv[2]);
-	file_out = ast_strdupa(a->argv[3]);
+	in = ast_strdupa(file_in);
+	out = ast_strdupa(file_out);
 
-	if (split_ext(file_in, &name_in, &ext_in)) {
-		ast_cli(a->fd, "'%s' is an invalid filename!\n", a->argv[2]);
+	if (split_ext(in, &name_in, &ext_in)) {
+		snprintf(error, error_len, "'%s' is an invalid filename!", file_in);
 		goto fail_out;
 	}
 	if (!(fs_in = ast_readfile(name_in, ext_in, NULL, O_RDONLY, 0, 0))) {
-		ast_cli(a->fd, "Unable to open input file: %s\n", a->argv[2]);
+		snprintf(error, error_len, "Unable to open input file: %s", file_in);
 		goto fail_out;
 	}
 
-	if (split_ext(file_out, &name_out, &ext_out)) {
-		ast_cli(a->fd, "'%s' is an invalid filename!\n", a->argv[3]);
+	if (split_ext(out, &name_out, &ext_out)) {
+		snprintf(error, error_len, "'%s' is an invalid filename!", file_out);
 		goto fail_out;
 	}
 	if (!(fs_out = ast_writefile(name_out, ext_out, NULL, O_CREAT|O_TRUNC|O_WRONLY, 0, AST_FILE_MODE))) {
-		ast_cli(a->fd, "Unable to open output file: %s\n", a->argv[3]);
+		snprintf(error, error_len, "Unable to open output file: %s", file_out);
 		goto fail_out;
 	}
 
@@ -117,21 +127,21 @@ static char *handle_cli_file_convert(struct ast_cli_entry *e, int cmd, struct as
 	while ((f = ast_readframe(fs_in))) {
 		if (ast_writestream(fs_out, f)) {
 			ast_frfree(f);
-			ast_cli(a->fd, "Failed to convert %s.%s to %s.%s!\n", name_in, ext_in, name_out, ext_out);
+			snprintf(error, error_len, "Failed to convert %s.%s to %s.%s!", name_in, ext_in, name_out, ext_out);
 			goto fail_out;
 		}
 		ast_frfree(f);
 	}
 
-	cost = ast_tvdiff_ms(ast_tvnow(), start);
-	ast_cli(a->fd, "Converted %s.%s to %s.%s in %dms\n", name_in, ext_in, name_out, ext_out, cost);
-	ret = CLI_SUCCESS;
+	*duration_ms = ast_tvdiff_ms(ast_tvnow(), start);
+	ret = 0;
 
 fail_out:
 	if (fs_out) {
 		ast_closestream(fs_out);
-		if (ret != CLI_SUCCESS)
+		if (ret) {
 			ast_filedelete(name_out, ext_out);
+		}
 	}
 
 	if (fs_in)
@@ -140,20 +150,89 @@ fail_out:
 	return ret;
 }
 
+/*!
+ * \brief Convert a file from one format to another
+ * \param e CLI entry
+ * \param cmd command number
+ * \param a list of cli arguments
+ * \retval CLI_SUCCESS on success.
+ * \retval CLI_SHOWUSAGE or CLI_FAILURE on failure.
+*/
+static char *handle_cli_file_convert(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	char error[256];
+	int cost;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "file convert";
+		e->usage =
+			"Usage: file convert <file_in> <file_out>\n"
+			"       Convert from file_in to file_out. If an absolute path\n"
+			"       is not given, the default Asterisk sounds directory\n"
+			"       will be used.\n\n"
+			"       Example:\n"
+			"           file convert tt-weasels.gsm tt-weasels.ulaw\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != 4 || ast_strlen_zero(a->argv[2]) || ast_strlen_zero(a->argv[3])) {
+		return CLI_SHOWUSAGE;
+	}
+
+	if (file_convert(a->argv[2], a->argv[3], &cost, error, sizeof(error))) {
+		ast_cli(a->fd, "%s\n", error);
+		return CLI_FAILURE;
+	}
+
+	ast_cli(a->fd, "Converted %s to %s in %dms\n", a->argv[2], a->argv[3], cost);
+
+	return CLI_SUCCESS;
+}
+
+static int action_file_convert(struct mansession *s, const struct message *m)
+{
+	const char *file_in = astman_get_header(m, "Filename");
+	const char *file_out = astman_get_header(m, "DestFilename");
+	char error[256];
+	int cost;
+
+	if (ast_strlen_zero(file_in) || ast_strlen_zero(file_out)) {
+		astman_send_error(s, m, "Filename and DestFilename are required");
+		return 0;
+	}
+
+	if (file_convert(file_in, file_out, &cost, error, sizeof(error))) {
+		astman_send_error(s, m, error);
+		return 0;
+	}
+
+	astman_send_ack(s, m, "File converted");
+
+	return 0;
+}
+
 static struct ast_cli_entry cli_convert[] = {
 	AST_CLI_DEFINE(handle_cli_file_convert, "Convert audio file")
 };
 
 static int unload_module(void)
 {
+	ast_manager_unregister("FileConvert");
 	ast_cli_unregister_multiple(cli_convert, ARRAY_LEN(cli_convert));
 	return 0;
 }
 
 static int load_module(void)
 {
-	ast_cli_register_multiple(cli_convert, ARRAY_LEN(cli_convert));
-	return AST_MODULE_LOAD_SUCCESS;
+	int res;
+
+	res = ast_cli_register_multiple(cli_convert, ARRAY_LEN(cli_convert));
+	res |= ast_manager_register_xml("FileConvert", EVENT_FLAG_SYSTEM, action_file_convert);
+
+	return res ? AST_MODULE_LOAD_DECLINE : AST_MODULE_LOAD_SUCCESS;
 }
 
 AST_MODULE_INFO_STANDARD(ASTERISK_GPL_KEY, "File format conversion CLI command");
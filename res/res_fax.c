@@ -462,6 +462,10 @@ struct fax_gateway {
 	struct ast_format *chan_write_format;
 	struct ast_format *peer_read_format;
 	struct ast_format *peer_write_format;
+	/*! \brief silence returned to the bridge while T.38 is negotiating */
+	struct ast_frame silence;
+	/*! \brief number of samples the silence frame buffer can hold */
+	unsigned int silence_samples;
 };
 
 /*! \brief used for fax detect framehook */
@@ -2855,6 +2859,9 @@ static void destroy_gateway(void *data)
 	ao2_cleanup(gateway->chan_write_format);
 	ao2_cleanup(gateway->peer_read_format);
 	ao2_cleanup(gateway->peer_write_format);
+
+	ast_free(gateway->silence.data.ptr);
+	gateway->silence.data.ptr = NULL;
 }
 
 static struct ast_fax_session *fax_v21_session_new (struct ast_channel *chan) {
@@ -3363,6 +3370,42 @@ static void fax_gateway_framehook_destroy(void *data)
 	ao2_ref(gateway, -1);
 }
 
+/*!
+ * \internal
+ * \brief Ensure the gateway's preallocated silence frame can hold the given sample count.
+ *
+ * The buffer is sized on first use and only regrows if a larger frame
+ * shows up, so the per-frame silence fill during T.38 negotiation does
+ * not allocate.
+ *
+ * \param gateway gateway the silence frame belongs to
+ * \param samples number of samples of silence needed
+ *
+ * \retval 0 on success.
+ * \retval -1 on error.
+ */
+static int fax_gateway_silence_ensure(struct fax_gateway *gateway, unsigned int samples)
+{
+	int16_t *buf;
+
+	if (gateway->silence_samples >= samples) {
+		return 0;
+	}
+
+	if (!(buf = ast_calloc(samples, sizeof(*buf)))) {
+		return -1;
+	}
+	ast_free(gateway->silence.data.ptr);
+
+	gateway->silence.frametype = AST_FRAME_VOICE;
+	gateway->silence.subclass.format = ast_format_slin;
+	gateway->silence.src = "res_fax_gateway_silence";
+	gateway->silence.data.ptr = buf;
+	gateway->silence_samples = samples;
+
+	return 0;
+}
+
 /*!
  * \brief T.30<->T.38 gateway framehook.
  *
@@ -3598,16 +3641,14 @@ static struct ast_frame *fax_gateway_framehook(struct ast_channel *chan, struct
 	if (gateway->t38_state != T38_STATE_UNAVAILABLE && gateway->t38_state != T38_STATE_REJECTED) {
 		if (f->frametype == AST_FRAME_VOICE &&
 			(ast_format_cmp(f->subclass.format, ast_format_slin) == AST_FORMAT_CMP_EQUAL)) {
-			short silence_buf[f->samples];
-			struct ast_frame silence_frame = {
-				.frametype = AST_FRAME_VOICE,
-				.subclass.format = ast_format_slin,
-				.data.ptr = silence_buf,
-				.samples = f->samples,
-				.datalen = sizeof(silence_buf),
-			};
-			memset(silence_buf, 0, sizeof(silence_buf));
-			return ast_frisolate(&silence_frame);
+			/* The silence frame is owned by the gateway and not mallocd,
+			 * so handing it out repeatedly costs nothing per frame. */
+			if (fax_gateway_silence_ensure(gateway, f->samples)) {
+				return &ast_null_frame;
+			}
+			gateway->silence.samples = f->samples;
+			gateway->silence.datalen = f->samples * sizeof(int16_t);
+			return &gateway->silence;
 		} else {
 			return &ast_null_frame;
 		}
@@ -70,6 +70,8 @@
 #define SPANDSP_FAX_SAMPLES 160
 #define SPANDSP_FAX_TIMER_RATE 8000 / SPANDSP_FAX_SAMPLES	/* 50 ticks per second, 20ms, 160 samples per second */
 #define SPANDSP_ENGAGE_UDPTL_NAT_RETRY 3
+/*! Samples decoded per block when transcoding G.711 audio for v.21 detection */
+#define SPANDSP_V21_BLOCK_SAMPLES 240
 
 static void *spandsp_fax_new(struct ast_fax_session *s, struct ast_fax_tech_token *token);
 static void spandsp_fax_destroy(struct ast_fax_session *s);
@@ -162,6 +164,13 @@ struct spandsp_pvt {
 
 	int v21_detected;
 	modem_connect_tones_rx_state_t *tone_state;
+	/*! \brief G.711 decoder preallocated for the life of the session so
+	 * v.21 detection does not create and destroy one per frame */
+	g711_state_t *v21_decoder;
+	/*! \brief Companding mode v21_decoder was initialized with */
+	int v21_decoder_mode;
+	/*! \brief Scratch block v.21 detection audio is decoded into */
+	int16_t v21_block[SPANDSP_V21_BLOCK_SAMPLES];
 };
 
 static int spandsp_v21_new(struct spandsp_pvt *p);
@@ -631,6 +640,14 @@ static void spandsp_v21_cleanup(struct ast_fax_session *s)
 	struct spandsp_pvt *p = s->tech_pvt;
 
 	modem_connect_tones_rx_free(p->tone_state);
+
+	if (p->v21_decoder) {
+		g711_release(p->v21_decoder);
+#if SPANDSP_RELEASE_DATE >= 20090220
+		g711_free(p->v21_decoder);
+#endif
+		p->v21_decoder = NULL;
+	}
 }
 
 /*! \brief Destroy a spandsp fax session.
@@ -708,8 +725,6 @@ static void spandsp_v21_tone(void *data, int code, int level, int delay)
 static int spandsp_v21_detect(struct ast_fax_session *s, const struct ast_frame *f)
 {
 	struct spandsp_pvt *p = s->tech_pvt;
-	int16_t *slndata;
-	g711_state_t *decoder;
 
 	if (p->v21_detected) {
 		return 0;
@@ -729,18 +744,37 @@ static int spandsp_v21_detect(struct ast_fax_session *s, const struct ast_frame
 	/* alaw/ulaw frame must be converted to slinear before passing to spandsp */
 	} else if (ast_format_cmp(f->subclass.format, ast_format_alaw) == AST_FORMAT_CMP_EQUAL ||
 	           ast_format_cmp(f->subclass.format, ast_format_ulaw) == AST_FORMAT_CMP_EQUAL) {
-		if (!(slndata = ast_malloc(sizeof(*slndata) * f->samples))) {
-			return -1;
-		}
-		decoder = g711_init(NULL, (ast_format_cmp(f->subclass.format, ast_format_alaw) == AST_FORMAT_CMP_EQUAL ? G711_ALAW : G711_ULAW));
-		g711_decode(decoder, slndata, f->data.ptr, f->samples);
-		ast_debug(5, "spandsp transcoding frame from %s to slinear for v21 detection\n", ast_format_get_name(f->subclass.format));
-		modem_connect_tones_rx(p->tone_state, slndata, f->samples);
-		g711_release(decoder);
+		const uint8_t *data = f->data.ptr;
+		int mode = (ast_format_cmp(f->subclass.format, ast_format_alaw) == AST_FORMAT_CMP_EQUAL ? G711_ALAW : G711_ULAW);
+		int offset = 0;
+		int block;
+
+		if (p->v21_decoder && p->v21_decoder_mode != mode) {
+			/* The leg switched companding laws mid-detection; rebuild the
+			 * decoder to match. */
+			g711_release(p->v21_decoder);
 #if SPANDSP_RELEASE_DATE >= 20090220
-		g711_free(decoder);
+			g711_free(p->v21_decoder);
 #endif
-		ast_free(slndata);
+			p->v21_decoder = NULL;
+		}
+		if (!p->v21_decoder) {
+			if (!(p->v21_decoder = g711_init(NULL, mode))) {
+				return -1;
+			}
+			p->v21_decoder_mode = mode;
+		}
+
+		ast_debug(5, "spandsp transcoding frame from %s to slinear for v21 detection\n", ast_format_get_name(f->subclass.format));
+
+		/* Decode through the preallocated scratch block in fixed size
+		 * pieces so detection never touches the allocator per frame. */
+		while (offset < f->samples) {
+			block = MIN(f->samples - offset, SPANDSP_V21_BLOCK_SAMPLES);
+			g711_decode(p->v21_decoder, p->v21_block, data + offset, block);
+			modem_connect_tones_rx(p->tone_state, p->v21_block, block);
+			offset += block;
+		}
 
 	/* frame in other formats cannot be passed to spandsp, it could cause segfault */
 	} else {
@@ -78,6 +78,17 @@
 				<configOption name="capture_id" default="0">
 					<synopsis>The ID for this capture agent.</synopsis>
 				</configOption>
+				<configOption name="sampling_rate" default="1">
+					<synopsis>Capture one out of this many non-error flows.</synopsis>
+					<description><para>
+						When set above <literal>1</literal>, only one out of this many
+						flows is forwarded to Homer, selected by a hash of the packet
+						UUID so all packets of a sampled flow are kept together.
+						SIP failure responses (4xx, 5xx and 6xx) are always forwarded
+						regardless of this setting.
+						</para>
+					</description>
+				</configOption>
 			</configObject>
 		</configFile>
 	</configInfo>
@@ -236,6 +247,7 @@ struct hep_generic {
 struct hepv3_global_config {
 	unsigned int enabled;                    /*!< Whether or not sending is enabled */
 	unsigned int capture_id;                 /*!< Capture ID for this agent */
+	unsigned int sampling_rate;              /*!< Capture one out of this many non-error flows */
 	enum hep_uuid_type uuid_type;            /*!< The preferred type of the UUID */
 	AST_DECLARE_STRING_FIELDS(
 		AST_STRING_FIELD(capture_address);   /*!< Address to send to */
@@ -277,6 +289,23 @@ static AO2_GLOBAL_OBJ_STATIC(global_data);
 
 static struct ast_taskprocessor *hep_queue_tp;
 
+/*! Maximum number of built packets staged before they are sent */
+#define HEP_BATCH_SIZE 16
+
+/*!
+ * \brief Staging area for built HEP packets awaiting emission.
+ *
+ * Only ever touched from the \ref hep_queue_tp taskprocessor thread,
+ * which serializes all senders, so no locking is needed.
+ */
+struct hep_batch {
+	void *buf[HEP_BATCH_SIZE];        /*!< The built packets */
+	unsigned int len[HEP_BATCH_SIZE]; /*!< Length of each built packet */
+	int count;                        /*!< How many packets are staged */
+};
+
+static struct hep_batch send_batch;
+
 static void *module_config_alloc(void);
 static int hepv3_config_pre_apply(void);
 static void hepv3_config_post_apply(void);
@@ -448,28 +477,24 @@ struct hepv3_capture_info *hepv3_create_capture_info(const void *payload, size_t
 	return info;
 }
 
-/*! \brief Callback function for the \ref hep_queue_tp taskprocessor */
-static int hep_queue_cb(void *data)
+/*!
+ * \internal
+ * \brief Build the wire form of a HEPv3 packet
+ *
+ * \param config The general configuration of the module
+ * \param capture_info The capture to encode
+ * \param[out] len The length of the built packet
+ *
+ * \return An allocated buffer holding the packet, or NULL on error.
+ */
+static void *hep_packet_build(struct hepv3_global_config *config, struct hepv3_capture_info *capture_info, unsigned int *len)
 {
-	RAII_VAR(struct module_config *, config, ao2_global_obj_ref(global_config), ao2_cleanup);
-	RAII_VAR(struct hepv3_runtime_data *, hepv3_data, ao2_global_obj_ref(global_data), ao2_cleanup);
-	RAII_VAR(struct hepv3_capture_info *, capture_info, data, ao2_cleanup);
 	struct hep_generic hg_pkt;
 	unsigned int packet_len = 0, sock_buffer_len;
 	struct hep_chunk_ip4 ipv4_src, ipv4_dst;
 	struct hep_chunk_ip6 ipv6_src, ipv6_dst;
 	struct hep_chunk auth_key, payload, uuid;
 	void *sock_buffer;
-	int res;
-
-	if (!capture_info || !config || !hepv3_data) {
-		return 0;
-	}
-
-	if (ast_sockaddr_is_ipv4(&capture_info->src_addr) != ast_sockaddr_is_ipv4(&capture_info->dst_addr)) {
-		ast_log(AST_LOG_NOTICE, "Unable to send packet: Address Family mismatch between source/destination\n");
-		return -1;
-	}
 
 	packet_len = sizeof(hg_pkt);
 
@@ -482,7 +507,7 @@ static int hep_queue_cb(void *data)
 	INITIALIZE_GENERIC_HEP_CHUNK_DATA(&hg_pkt.time_sec, CHUNK_TYPE_TIMESTAMP_SEC, htonl(capture_info->capture_time.tv_sec));
 	INITIALIZE_GENERIC_HEP_CHUNK_DATA(&hg_pkt.time_usec, CHUNK_TYPE_TIMESTAMP_USEC, htonl(capture_info->capture_time.tv_usec));
 	INITIALIZE_GENERIC_HEP_CHUNK_DATA(&hg_pkt.proto_t, CHUNK_TYPE_PROTOCOL_TYPE, capture_info->capture_type);
-	INITIALIZE_GENERIC_HEP_CHUNK_DATA(&hg_pkt.capt_id, CHUNK_TYPE_CAPTURE_AGENT_ID, htonl(config->general->capture_id));
+	INITIALIZE_GENERIC_HEP_CHUNK_DATA(&hg_pkt.capt_id, CHUNK_TYPE_CAPTURE_AGENT_ID, htonl(config->capture_id));
 
 	if (ast_sockaddr_is_ipv4(&capture_info->src_addr)) {
 		INITIALIZE_GENERIC_HEP_CHUNK_DATA(&hg_pkt.ip_family,
@@ -508,9 +533,9 @@ static int hep_queue_cb(void *data)
 		packet_len += (sizeof(ipv6_src) + sizeof(ipv6_dst));
 	}
 
-	if (!ast_strlen_zero(config->general->capture_password))  {
-		INITIALIZE_GENERIC_HEP_IDS_VAR(&auth_key, CHUNK_TYPE_AUTH_KEY, strlen(config->general->capture_password));
-		packet_len += (sizeof(auth_key) + strlen(config->general->capture_password));
+	if (!ast_strlen_zero(config->capture_password))  {
+		INITIALIZE_GENERIC_HEP_IDS_VAR(&auth_key, CHUNK_TYPE_AUTH_KEY, strlen(config->capture_password));
+		packet_len += (sizeof(auth_key) + strlen(config->capture_password));
 	}
 	INITIALIZE_GENERIC_HEP_IDS_VAR(&uuid, CHUNK_TYPE_UUID, strlen(capture_info->uuid));
 	packet_len += (sizeof(uuid) + strlen(capture_info->uuid));
@@ -522,7 +547,7 @@ static int hep_queue_cb(void *data)
 	/* Build the buffer to send */
 	sock_buffer = ast_malloc(packet_len);
 	if (!sock_buffer) {
-		return -1;
+		return NULL;
 	}
 
 	/* Copy in the header */
@@ -543,11 +568,11 @@ static int hep_queue_cb(void *data)
 	}
 
 	/* Auth Key */
-	if (!ast_strlen_zero(config->general->capture_password)) {
+	if (!ast_strlen_zero(config->capture_password)) {
 		memcpy(sock_buffer + sock_buffer_len, &auth_key, sizeof(auth_key));
 		sock_buffer_len += sizeof(auth_key);
-		memcpy(sock_buffer + sock_buffer_len, config->general->capture_password, strlen(config->general->capture_password));
-		sock_buffer_len += strlen(config->general->capture_password);
+		memcpy(sock_buffer + sock_buffer_len, config->capture_password, strlen(config->capture_password));
+		sock_buffer_len += strlen(config->capture_password);
 	}
 
 	/* UUID */
@@ -564,20 +589,149 @@ static int hep_queue_cb(void *data)
 
 	ast_assert(sock_buffer_len == packet_len);
 
-	res = ast_sendto(hepv3_data->sockfd, sock_buffer, sock_buffer_len, 0, &hepv3_data->remote_addr);
-	if (res < 0) {
-		ast_log(AST_LOG_ERROR, "Error [%d] while sending packet to HEPv3 server: %s\n",
-			errno, strerror(errno));
-	} else if (res != sock_buffer_len) {
-		ast_log(AST_LOG_WARNING, "Failed to send complete packet to HEPv3 server: %d of %u sent\n",
-			res, sock_buffer_len);
+	*len = packet_len;
+	return sock_buffer;
+}
+
+/*! \brief Free any staged packets without sending them */
+static void hep_batch_drop(void)
+{
+	int i;
+
+	for (i = 0; i < send_batch.count; i++) {
+		ast_free(send_batch.buf[i]);
+	}
+	send_batch.count = 0;
+}
+
+/*!
+ * \internal
+ * \brief Send all staged packets to the capture server.
+ *
+ * With sendmmsg() support the whole batch leaves in a single syscall,
+ * still one packet per datagram, so the wire format seen by the
+ * collector is unchanged.  Without it the packets are sent one by one.
+ *
+ * \retval 0 on success.
+ * \retval -1 if any packet could not be sent.
+ */
+static int hep_batch_flush(struct hepv3_runtime_data *hepv3_data)
+{
+	int res = 0;
+	int i;
+#ifdef HAVE_SENDMMSG
+	struct mmsghdr msgs[HEP_BATCH_SIZE];
+	struct iovec iovs[HEP_BATCH_SIZE];
+
+	if (send_batch.count > 1) {
+		memset(msgs, 0, sizeof(msgs));
+		for (i = 0; i < send_batch.count; i++) {
+			iovs[i].iov_base = send_batch.buf[i];
+			iovs[i].iov_len = send_batch.len[i];
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_name = &hepv3_data->remote_addr.ss;
+			msgs[i].msg_hdr.msg_namelen = hepv3_data->remote_addr.len;
+		}
+
+		res = sendmmsg(hepv3_data->sockfd, msgs, send_batch.count, 0);
+		if (res < 0) {
+			ast_log(AST_LOG_ERROR, "Error [%d] while sending %d packets to HEPv3 server: %s\n",
+				errno, send_batch.count, strerror(errno));
+		} else if (res < send_batch.count) {
+			ast_log(AST_LOG_WARNING, "Failed to send complete batch to HEPv3 server: %d of %d sent\n",
+				res, send_batch.count);
+			res = -1;
+		} else {
+			res = 0;
+		}
+
+		hep_batch_drop();
+		return res;
+	}
+#endif
+
+	for (i = 0; i < send_batch.count; i++) {
+		int sent = ast_sendto(hepv3_data->sockfd, send_batch.buf[i], send_batch.len[i], 0,
+			&hepv3_data->remote_addr);
+
+		if (sent < 0) {
+			ast_log(AST_LOG_ERROR, "Error [%d] while sending packet to HEPv3 server: %s\n",
+				errno, strerror(errno));
+			res = -1;
+		} else if (sent != send_batch.len[i]) {
+			ast_log(AST_LOG_WARNING, "Failed to send complete packet to HEPv3 server: %d of %u sent\n",
+				sent, send_batch.len[i]);
+			res = -1;
+		}
+	}
+
+	hep_batch_drop();
+	return res;
+}
+
+/*! \brief Callback function for the \ref hep_queue_tp taskprocessor */
+static int hep_queue_cb(void *data)
+{
+	RAII_VAR(struct module_config *, config, ao2_global_obj_ref(global_config), ao2_cleanup);
+	RAII_VAR(struct hepv3_runtime_data *, hepv3_data, ao2_global_obj_ref(global_data), ao2_cleanup);
+	RAII_VAR(struct hepv3_capture_info *, capture_info, data, ao2_cleanup);
+	unsigned int packet_len = 0;
+	void *sock_buffer;
+	int res = 0;
+
+	if (!capture_info || !config || !hepv3_data) {
+		/* Without run-time data anything staged cannot be sent either */
+		hep_batch_drop();
+		return 0;
+	}
+
+	if (ast_sockaddr_is_ipv4(&capture_info->src_addr) != ast_sockaddr_is_ipv4(&capture_info->dst_addr)) {
+		ast_log(AST_LOG_NOTICE, "Unable to send packet: Address Family mismatch between source/destination\n");
 		res = -1;
+	} else {
+		sock_buffer = hep_packet_build(config->general, capture_info, &packet_len);
+		if (!sock_buffer) {
+			res = -1;
+		} else {
+			send_batch.buf[send_batch.count] = sock_buffer;
+			send_batch.len[send_batch.count] = packet_len;
+			send_batch.count++;
+		}
+	}
+
+	/* Emit when the batch is full or nothing else is waiting to be built */
+	if (send_batch.count
+		&& (send_batch.count == HEP_BATCH_SIZE || !ast_taskprocessor_size(hep_queue_tp))) {
+		if (hep_batch_flush(hepv3_data)) {
+			res = -1;
+		}
 	}
 
-	ast_free(sock_buffer);
 	return res;
 }
 
+/*!
+ * \internal
+ * \brief Determine if a capture must always be sent regardless of sampling
+ *
+ * SIP failure responses are the captures that matter most when tracing
+ * problems, so they bypass the sampling policy.
+ */
+static int hepv3_capture_is_error(const struct hepv3_capture_info *capture_info)
+{
+	const char *payload = capture_info->payload;
+
+	if (capture_info->capture_type != HEPV3_CAPTURE_TYPE_SIP
+		|| capture_info->zipped
+		|| capture_info->len < 9) {
+		return 0;
+	}
+
+	/* Failure responses: SIP/2.0 4xx, 5xx, and 6xx */
+	return !strncmp(payload, "SIP/2.0 ", 8) && '4' <= payload[8] && payload[8] <= '6';
+}
+
 int hepv3_send_packet(struct hepv3_capture_info *capture_info)
 {
 	RAII_VAR(struct module_config *, config, ao2_global_obj_ref(global_config), ao2_cleanup);
@@ -588,6 +742,17 @@ int hepv3_send_packet(struct hepv3_capture_info *capture_info)
 		return 0;
 	}
 
+	if (config->general->sampling_rate > 1
+		&& !ast_strlen_zero(capture_info->uuid)
+		&& !hepv3_capture_is_error(capture_info)
+		&& ast_str_hash(capture_info->uuid) % config->general->sampling_rate) {
+		/* The flow this packet belongs to is not in the sampled slice.
+		 * Hashing on the UUID keeps or drops whole flows, not single
+		 * packets, so sampled traces stay complete. */
+		ao2_ref(capture_info, -1);
+		return 0;
+	}
+
 	res = ast_taskprocessor_push(hep_queue_tp, hep_queue_cb, capture_info);
 	if (res == -1) {
 		ao2_ref(capture_info, -1);
@@ -656,6 +821,9 @@ static int unload_module(void)
 {
 	hep_queue_tp = ast_taskprocessor_unreference(hep_queue_tp);
 
+	/* With the taskprocessor gone nothing can touch the batch */
+	hep_batch_drop();
+
 	ao2_global_obj_release(global_config);
 	ao2_global_obj_release(global_data);
 	aco_info_destroy(&cfg_info);
@@ -681,6 +849,7 @@ static int load_module(void)
 	aco_option_register(&cfg_info, "capture_address", ACO_EXACT, global_options, "", OPT_STRINGFIELD_T, 1, STRFLDSET(struct hepv3_global_config, capture_address));
 	aco_option_register(&cfg_info, "capture_password", ACO_EXACT, global_options, "", OPT_STRINGFIELD_T, 0, STRFLDSET(struct hepv3_global_config, capture_password));
 	aco_option_register(&cfg_info, "capture_id", ACO_EXACT, global_options, "0", OPT_UINT_T, 0, STRFLDSET(struct hepv3_global_config, capture_id));
+	aco_option_register(&cfg_info, "sampling_rate", ACO_EXACT, global_options, "1", OPT_UINT_T, 0, FLDSET(struct hepv3_global_config, sampling_rate));
 	aco_option_register_custom(&cfg_info, "uuid_type", ACO_EXACT, global_options, "call-id", uuid_type_handler, 0);
 
 	if (aco_process_config(&cfg_info, 0) == ACO_PROCESS_ERROR) {
@@ -29,6 +29,8 @@
 
 #include "asterisk.h"
 
+#include <sys/uio.h>
+
 #include "asterisk/module.h"
 #include "asterisk/http.h"
 #include "asterisk/astobj2.h"
@@ -374,9 +376,10 @@ static const char *websocket_opcode2str(enum ast_websocket_opcode opcode)
 int AST_OPTIONAL_API_NAME(ast_websocket_write)(struct ast_websocket *session, enum ast_websocket_opcode opcode, char *payload, uint64_t payload_size)
 {
 	size_t header_size = 2; /* The minimum size of a websocket frame is 2 bytes */
-	char *frame;
+	char header[14] = { 0, }; /* Maximum header is 10 bytes plus a 4 byte client masking key */
 	uint64_t length;
 	uint64_t frame_size;
+	ssize_t res;
 
 	ast_debug(3, "Writing websocket %s frame, length %" PRIu64 "\n",
 			websocket_opcode2str(opcode), payload_size);
@@ -400,23 +403,16 @@ int AST_OPTIONAL_API_NAME(ast_websocket_write)(struct ast_websocket *session, en
 
 	frame_size = header_size + payload_size;
 
-	frame = ast_alloca(frame_size + 1);
-	memset(frame, 0, frame_size + 1);
-
-	frame[0] = opcode | 0x80;
-	frame[1] = length;
+	header[0] = opcode | 0x80;
+	header[1] = length;
 
 	/* Use the additional available bytes to store the length */
 	if (length == 126) {
-		put_unaligned_uint16(&frame[2], htons(payload_size));
+		put_unaligned_uint16(&header[2], htons(payload_size));
 	} else if (length == 127) {
-		put_unaligned_uint64(&frame[2], htonll(payload_size));
+		put_unaligned_uint64(&header[2], htonll(payload_size));
 	}
 
-	memcpy(&frame[header_size], payload, payload_size);
-
-	websocket_mask_payload(session, frame, &frame[header_size], payload_size);
-
 	ao2_lock(session);
 	if (session->closing) {
 		ao2_unlock(session);
@@ -424,7 +420,28 @@ int AST_OPTIONAL_API_NAME(ast_websocket_write)(struct ast_websocket *session, en
 	}
 
 	ast_iostream_set_timeout_sequence(session->stream, ast_tvnow(), session->timeout);
-	if (ast_iostream_write(session->stream, frame, frame_size) != frame_size) {
+	if (session->client) {
+		/* RFC 6455 5.1 - clients MUST mask frame data.  Masking mutates
+		 * the payload, so assemble the frame in a scratch buffer rather
+		 * than modifying the caller's data. */
+		char *frame = ast_alloca(frame_size);
+
+		memcpy(frame, header, header_size);
+		memcpy(&frame[header_size], payload, payload_size);
+		websocket_mask_payload(session, frame, &frame[header_size], payload_size);
+
+		res = ast_iostream_write(session->stream, frame, frame_size);
+	} else {
+		/* Servers never mask, so the payload can go straight from the
+		 * caller's buffer alongside the header in one vectored write. */
+		struct iovec iov[2] = {
+			{ .iov_base = header, .iov_len = header_size, },
+			{ .iov_base = payload, .iov_len = payload_size, },
+		};
+
+		res = ast_iostream_writev(session->stream, iov, ARRAY_LEN(iov));
+	}
+	if (res < 0 || (uint64_t) res != frame_size) {
 		ao2_unlock(session);
 		/* 1011 - server terminating connection due to not being able to fulfill the request */
 		ast_debug(1, "Closing WS with 1011 because we can't fulfill a write request\n");
@@ -0,0 +1,361 @@
+/*
+ * Asterisk -- An open source telephony toolkit.
+ *
+ * See http://www.asterisk.org for more information about
+ * the Asterisk project. Please do not directly contact
+ * any of the maintainers of this project for assistance;
+ * the project provides a web site, mailing lists and IRC
+ * channels for your use.
+ *
+ * This program is free software, distributed under the terms of
+ * the GNU General Public License Version 2. See the LICENSE file
+ * at the top of the source tree.
+ */
+
+/*!
+ * \file
+ *
+ * \brief CLI driven call load generator
+ *
+ * Originates Local channels at a configurable rate into a dialplan
+ * scenario so call setup and media capacity can be measured on a box
+ * without external traffic generators.  Each origination creates a
+ * Local channel pair with both legs executing the scenario extension,
+ * so a scenario built from Echo, Playback or Bridge exercises the
+ * same core paths a real call would.
+ *
+ * The generator is driven entirely from the CLI, which also makes it
+ * scriptable from a build: asterisk -rx "loadtest start 50 5000".
+ */
+
+/*** MODULEINFO
+	<support_level>extended</support_level>
+ ***/
+
+#include "asterisk.h"
+
+#include "asterisk/channel.h"
+#include "asterisk/pbx.h"
+#include "asterisk/module.h"
+#include "asterisk/cli.h"
+#include "asterisk/utils.h"
+#include "asterisk/lock.h"
+#include "asterisk/format_cache.h"
+
+/*! \brief The timeout for originated calls, in seconds */
+#define LOADTEST_TIMEOUT 30
+
+/*! \brief Upper bound on the configured origination rate, per second */
+#define LOADTEST_MAX_RATE 1000
+
+/*! \brief State of the running load generator, protected by loadtest_lock */
+static struct {
+	pthread_t thread;
+	/*! \brief Originations per second */
+	unsigned int rate;
+	/*! \brief Total originations before the run ends on its own */
+	unsigned int total;
+	/*! \brief Scenario dialplan context */
+	char context[AST_MAX_CONTEXT];
+	/*! \brief Scenario dialplan extension */
+	char exten[AST_MAX_EXTENSION];
+	/*! \brief Originations attempted so far in this run */
+	unsigned int attempted;
+	/*! \brief Originations that failed immediately */
+	unsigned int failed;
+	/*! \brief When the run started */
+	struct timeval start;
+	/*! \brief When the run finished, zero while still running */
+	struct timeval end;
+	/*! \brief Set to ask the pacing thread to wind down */
+	unsigned int stop:1;
+	/*! \brief Set while the pacing thread exists */
+	unsigned int running:1;
+} loadtest = {
+	.thread = AST_PTHREADT_NULL,
+};
+
+AST_MUTEX_DEFINE_STATIC(loadtest_lock);
+
+/*!
+ * \internal
+ * \brief Pacing thread: originate scenario calls on a fixed schedule.
+ *
+ * Origination n is due at start + n / rate.  Sleeping toward absolute
+ * deadlines rather than a fixed interval keeps the offered rate honest
+ * even when ast_pbx_outgoing_exten() itself takes time.
+ */
+static void *loadtest_run(void *data)
+{
+	struct ast_format_cap *cap;
+	char dialstr[AST_MAX_EXTENSION + AST_MAX_CONTEXT + 1];
+	unsigned int sequence = 0;
+
+	cap = ast_format_cap_alloc(AST_FORMAT_CAP_FLAG_DEFAULT);
+	if (!cap) {
+		ast_log(LOG_ERROR, "Load test aborted: unable to allocate format capabilities\n");
+		ast_mutex_lock(&loadtest_lock);
+		loadtest.running = 0;
+		loadtest.end = ast_tvnow();
+		ast_mutex_unlock(&loadtest_lock);
+		return NULL;
+	}
+	ast_format_cap_append(cap, ast_format_slin, 0);
+
+	snprintf(dialstr, sizeof(dialstr), "%s@%s", loadtest.exten, loadtest.context);
+
+	for (;;) {
+		int64_t due_us;
+		int64_t elapsed_us;
+		int reason = 0;
+		int res;
+
+		ast_mutex_lock(&loadtest_lock);
+		if (loadtest.stop || loadtest.attempted >= loadtest.total) {
+			loadtest.running = 0;
+			loadtest.end = ast_tvnow();
+			ast_mutex_unlock(&loadtest_lock);
+			break;
+		}
+		++loadtest.attempted;
+		ast_mutex_unlock(&loadtest_lock);
+
+		res = ast_pbx_outgoing_exten("Local", cap, dialstr,
+			LOADTEST_TIMEOUT * 1000, loadtest.context, loadtest.exten, 1,
+			&reason, AST_OUTGOING_NO_WAIT, NULL, NULL, NULL, NULL, NULL, 0,
+			NULL);
+		if (res) {
+			ast_mutex_lock(&loadtest_lock);
+			++loadtest.failed;
+			ast_mutex_unlock(&loadtest_lock);
+		}
+
+		++sequence;
+		due_us = (int64_t) sequence * 1000000 / loadtest.rate;
+		elapsed_us = ast_tvdiff_us(ast_tvnow(), loadtest.start);
+		if (elapsed_us < due_us) {
+			usleep(due_us - elapsed_us);
+		}
+	}
+
+	ao2_ref(cap, -1);
+	return NULL;
+}
+
+static char *handle_loadtest_start(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	unsigned int rate;
+	unsigned int total;
+	const char *exten = "s";
+	char *context = NULL;
+	char *parse;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "loadtest start";
+		e->usage =
+			"Usage: loadtest start <rate> <count> [exten@][context]\n"
+			"       Originates <count> Local channel calls at <rate> calls per\n"
+			"       second into the given dialplan scenario.  If no context is\n"
+			"       specified, the 'default' context will be used.  If no\n"
+			"       extension is given, the 's' extension will be used.  Both\n"
+			"       legs of each Local pair run the scenario.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != e->args + 2 && a->argc != e->args + 3) {
+		return CLI_SHOWUSAGE;
+	}
+
+	if (sscanf(a->argv[e->args], "%30u", &rate) != 1
+		|| !rate || rate > LOADTEST_MAX_RATE) {
+		ast_cli(a->fd, "Rate must be between 1 and %d calls per second\n",
+			LOADTEST_MAX_RATE);
+		return CLI_SHOWUSAGE;
+	}
+	if (sscanf(a->argv[e->args + 1], "%30u", &total) != 1 || !total) {
+		ast_cli(a->fd, "Count must be a positive number of calls\n");
+		return CLI_SHOWUSAGE;
+	}
+	if (a->argc == e->args + 3) {
+		parse = ast_strdupa(a->argv[e->args + 2]);
+		context = parse;
+		exten = strsep(&context, "@");
+		if (ast_strlen_zero(exten)) {
+			exten = "s";
+		}
+	}
+	if (ast_strlen_zero(context)) {
+		context = "default";
+	}
+
+	if (!ast_exists_extension(NULL, context, exten, 1, NULL)) {
+		ast_cli(a->fd, "Scenario %s@%s does not exist in the dialplan\n",
+			exten, context);
+		return CLI_FAILURE;
+	}
+
+	ast_mutex_lock(&loadtest_lock);
+	if (loadtest.running) {
+		ast_mutex_unlock(&loadtest_lock);
+		ast_cli(a->fd, "A load test is already running; stop it first\n");
+		return CLI_FAILURE;
+	}
+	if (loadtest.thread != AST_PTHREADT_NULL) {
+		/* Reap the previous, completed run. */
+		pthread_join(loadtest.thread, NULL);
+		loadtest.thread = AST_PTHREADT_NULL;
+	}
+
+	loadtest.rate = rate;
+	loadtest.total = total;
+	ast_copy_string(loadtest.exten, exten, sizeof(loadtest.exten));
+	ast_copy_string(loadtest.context, context, sizeof(loadtest.context));
+	loadtest.attempted = 0;
+	loadtest.failed = 0;
+	loadtest.start = ast_tvnow();
+	loadtest.end = ast_tv(0, 0);
+	loadtest.stop = 0;
+	loadtest.running = 1;
+
+	if (ast_pthread_create_background(&loadtest.thread, NULL, loadtest_run, NULL)) {
+		loadtest.thread = AST_PTHREADT_NULL;
+		loadtest.running = 0;
+		ast_mutex_unlock(&loadtest_lock);
+		ast_cli(a->fd, "Failed to create load test thread\n");
+		return CLI_FAILURE;
+	}
+	ast_mutex_unlock(&loadtest_lock);
+
+	ast_cli(a->fd, "Load test started: %u calls at %u/sec into %s@%s\n",
+		total, rate, exten, context);
+
+	return CLI_SUCCESS;
+}
+
+static char *handle_loadtest_stop(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	pthread_t thread;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "loadtest stop";
+		e->usage =
+			"Usage: loadtest stop\n"
+			"       Stops the running load test.  Calls already originated are\n"
+			"       left to complete normally.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != e->args) {
+		return CLI_SHOWUSAGE;
+	}
+
+	ast_mutex_lock(&loadtest_lock);
+	if (!loadtest.running) {
+		ast_mutex_unlock(&loadtest_lock);
+		ast_cli(a->fd, "No load test is running\n");
+		return CLI_FAILURE;
+	}
+	loadtest.stop = 1;
+	thread = loadtest.thread;
+	loadtest.thread = AST_PTHREADT_NULL;
+	ast_mutex_unlock(&loadtest_lock);
+
+	pthread_join(thread, NULL);
+	ast_cli(a->fd, "Load test stopped after %u of %u calls\n",
+		loadtest.attempted, loadtest.total);
+
+	return CLI_SUCCESS;
+}
+
+static char *handle_loadtest_show(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	unsigned int attempted;
+	unsigned int failed;
+	unsigned int total;
+	unsigned int rate;
+	int running;
+	int64_t elapsed_us;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "loadtest show status";
+		e->usage =
+			"Usage: loadtest show status\n"
+			"       Shows the progress and effective rate of the current or\n"
+			"       most recent load test.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != e->args) {
+		return CLI_SHOWUSAGE;
+	}
+
+	ast_mutex_lock(&loadtest_lock);
+	if (!loadtest.rate) {
+		ast_mutex_unlock(&loadtest_lock);
+		ast_cli(a->fd, "No load test has been run\n");
+		return CLI_SUCCESS;
+	}
+	attempted = loadtest.attempted;
+	failed = loadtest.failed;
+	total = loadtest.total;
+	rate = loadtest.rate;
+	running = loadtest.running;
+	elapsed_us = ast_tvdiff_us(running ? ast_tvnow() : loadtest.end, loadtest.start);
+	ast_mutex_unlock(&loadtest_lock);
+
+	ast_cli(a->fd, "Scenario:       %s@%s\n", loadtest.exten, loadtest.context);
+	ast_cli(a->fd, "State:          %s\n", running ? "running" : "finished");
+	ast_cli(a->fd, "Configured:     %u calls at %u/sec\n", total, rate);
+	ast_cli(a->fd, "Attempted:      %u\n", attempted);
+	ast_cli(a->fd, "Failed:         %u\n", failed);
+	if (elapsed_us > 0) {
+		ast_cli(a->fd, "Elapsed:        %.1f sec\n", elapsed_us / 1000000.0);
+		ast_cli(a->fd, "Effective rate: %.1f calls/sec\n",
+			attempted * 1000000.0 / elapsed_us);
+	}
+
+	return CLI_SUCCESS;
+}
+
+static struct ast_cli_entry cli_loadtest[] = {
+	AST_CLI_DEFINE(handle_loadtest_start, "Start originating load test calls"),
+	AST_CLI_DEFINE(handle_loadtest_stop, "Stop the running load test"),
+	AST_CLI_DEFINE(handle_loadtest_show, "Show load test progress"),
+};
+
+static int unload_module(void)
+{
+	pthread_t thread;
+
+	ast_mutex_lock(&loadtest_lock);
+	loadtest.stop = 1;
+	thread = loadtest.thread;
+	loadtest.thread = AST_PTHREADT_NULL;
+	ast_mutex_unlock(&loadtest_lock);
+
+	if (thread != AST_PTHREADT_NULL) {
+		pthread_join(thread, NULL);
+	}
+
+	return ast_cli_unregister_multiple(cli_loadtest, ARRAY_LEN(cli_loadtest));
+}
+
+static int load_module(void)
+{
+	int res;
+
+	res = ast_cli_register_multiple(cli_loadtest, ARRAY_LEN(cli_loadtest));
+
+	return res ? AST_MODULE_LOAD_DECLINE : AST_MODULE_LOAD_SUCCESS;
+}
+
+AST_MODULE_INFO_STANDARD_EXTENDED(ASTERISK_GPL_KEY, "CLI driven call load generator");
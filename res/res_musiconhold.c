@@ -188,6 +188,12 @@ struct mohclass {
 	int srcfd;
 	/*! Generic timer */
 	struct ast_timer *timer;
+	/*! Next file to open in "broadcast" mode */
+	int bcast_pos;
+	/*! Stream the "broadcast" decoder thread is currently reading */
+	struct ast_filestream *bcast_stream;
+	/*! Translation path to class->format for the current broadcast file, if needed */
+	struct ast_trans_pvt *bcast_trans;
 	/*! Created on the fly, from RT engine */
 	unsigned int realtime:1;
 	unsigned int delete:1;
@@ -865,6 +871,225 @@ static void *monmp3thread(void *data)
 	return NULL;
 }
 
+/*! \brief Extensions tried for each file in "broadcast" mode, cheapest to decode first */
+static const char *bcast_exts[] = { "sln", "ulaw", "alaw", "g722", "wav", "gsm" };
+
+static void moh_broadcast_close(struct mohclass *class)
+{
+	if (class->bcast_stream) {
+		ast_closestream(class->bcast_stream);
+		class->bcast_stream = NULL;
+	}
+	if (class->bcast_trans) {
+		ast_translator_free_path(class->bcast_trans);
+		class->bcast_trans = NULL;
+	}
+}
+
+/*! \brief Open the next playable file in the class for the "broadcast" decoder
+ *
+ * On success class->bcast_stream is ready to read and class->bcast_trans is
+ * set up when the file's format differs from the class format.
+ */
+static int moh_broadcast_next(struct mohclass *class)
+{
+	struct ast_vector_string *files;
+	size_t file_count;
+	size_t tries;
+	int i;
+
+	ao2_lock(class);
+	files = ao2_bump(class->files);
+	ao2_unlock(class);
+
+	file_count = AST_VECTOR_SIZE(files);
+	if (!file_count) {
+		ao2_ref(files, -1);
+		return -1;
+	}
+
+	if (ast_test_flag(class, MOH_SORTMODE) == MOH_RANDOMIZE) {
+		class->bcast_pos = ast_random() % file_count;
+	}
+
+	for (tries = 0; tries < file_count; tries++) {
+		const char *filename = AST_VECTOR_GET(files, class->bcast_pos % file_count);
+
+		class->bcast_pos = (class->bcast_pos + 1) % file_count;
+
+		for (i = 0; i < ARRAY_LEN(bcast_exts); i++) {
+			struct ast_format *file_format;
+
+			if (ast_fileexists(filename, bcast_exts[i], NULL) <= 0) {
+				continue;
+			}
+			file_format = ast_get_format_for_file_ext(bcast_exts[i]);
+			if (!file_format) {
+				continue;
+			}
+			if (ast_format_cmp(file_format, class->format) != AST_FORMAT_CMP_EQUAL) {
+				class->bcast_trans = ast_translator_build_path(class->format, file_format);
+				if (!class->bcast_trans) {
+					/* No way to get this file into the class format */
+					continue;
+				}
+			}
+			if (!(class->bcast_stream = ast_readfile(filename, bcast_exts[i], NULL, O_RDONLY, 0, 0))) {
+				if (class->bcast_trans) {
+					ast_translator_free_path(class->bcast_trans);
+					class->bcast_trans = NULL;
+				}
+				continue;
+			}
+			ast_debug(3, "%s: broadcast decoder opened '%s.%s'\n", class->name, filename, bcast_exts[i]);
+			ao2_ref(files, -1);
+			return 0;
+		}
+	}
+
+	ast_log(LOG_WARNING, "No broadcastable files in directory '%s' for class '%s'\n",
+		class->dir, class->name);
+	ao2_ref(files, -1);
+	return -1;
+}
+
+/*!
+ * \brief Single decoder feeding every member of a "broadcast" class
+ *
+ * Same pacing as monmp3thread(), but instead of draining an external
+ * process we decode the class files ourselves, once, and fan the audio
+ * out to the per-member pipes.
+ */
+static void *moh_broadcast_thread(void *data)
+{
+	struct mohclass *class = data;
+	struct mohdata *moh;
+	short sbuf[8192];
+	int banked = 0;		/* decoded bytes waiting in sbuf */
+	int res;
+	int len;
+	struct timeval deadline, tv_tmp;
+
+	deadline.tv_sec = 0;
+	deadline.tv_usec = 0;
+	for (;/* ever */;) {
+		int opens = 0;
+
+		pthread_testcancel();
+		if (class->timer) {
+			struct pollfd pfd = { .fd = ast_timer_fd(class->timer), .events = POLLIN | POLLPRI, };
+
+#ifdef SOLARIS
+			thr_yield();
+#endif
+			/* Pause some amount of time */
+			if (ast_poll(&pfd, 1, -1) > 0) {
+				if (ast_timer_ack(class->timer, 1) < 0) {
+					ast_log(LOG_ERROR, "Failed to acknowledge timer for broadcast decoder\n");
+					return NULL;
+				}
+				/* 25 samples per second => 40ms framerate => 320 samples */
+				res = 320; /* 320/40 = 8 samples/ms */
+			} else {
+				ast_log(LOG_WARNING, "poll() failed: %s\n", strerror(errno));
+				res = 0;
+			}
+			pthread_testcancel();
+		} else {
+			long delta;
+			/* Reliable sleep */
+			tv_tmp = ast_tvnow();
+			if (ast_tvzero(deadline))
+				deadline = tv_tmp;
+			delta = ast_tvdiff_ms(tv_tmp, deadline);
+			if (delta < MOH_MS_INTERVAL) {	/* too early */
+				deadline = ast_tvadd(deadline, ast_samp2tv(MOH_MS_INTERVAL, 1000));	/* next deadline */
+				usleep(1000 * (MOH_MS_INTERVAL - delta));
+				pthread_testcancel();
+			} else {
+				ast_log(LOG_NOTICE, "Request to schedule in the past?!?!\n");
+				deadline = tv_tmp;
+			}
+			/* 10 samples per second (MOH_MS_INTERVAL) => 100ms framerate => 800 samples */
+			res = 8 * MOH_MS_INTERVAL; /* 800/100 = 8 samples/ms */
+		}
+		/* For non-8000Hz formats, we need to alter the resolution */
+		res = res * ast_format_get_sample_rate(class->format) / 8000;
+
+		if (AST_LIST_EMPTY(&class->members)) {
+			/* Nobody is listening, so don't bother decoding */
+			continue;
+		}
+
+		len = ast_format_determine_length(class->format, res);
+		if (len > sizeof(sbuf)) {
+			len = sizeof(sbuf);
+		}
+
+		/* Decode until a full interval is banked */
+		while (banked < len) {
+			struct ast_frame *f, *out, *cur;
+
+			if (!class->bcast_stream) {
+				/* A couple of reopens per interval covers normal end-of-file
+				 * rollover without spinning on empty or unreadable files. */
+				if (opens++ >= 2 || moh_broadcast_next(class)) {
+					break;
+				}
+			}
+			if (!(f = ast_readframe(class->bcast_stream))) {
+				moh_broadcast_close(class);
+				continue;
+			}
+			if (class->bcast_trans) {
+				if (!(out = ast_translate(class->bcast_trans, f, 1))) {
+					/* The translator is buffering; feed it more */
+					continue;
+				}
+			} else {
+				out = f;
+			}
+			for (cur = out; cur; cur = AST_LIST_NEXT(cur, frame_list)) {
+				int copy = cur->datalen;
+
+				if (copy > sizeof(sbuf) - banked) {
+					copy = sizeof(sbuf) - banked;
+				}
+				if (copy > 0) {
+					memcpy((char *) sbuf + banked, cur->data.ptr, copy);
+					banked += copy;
+				}
+			}
+			ast_frfree(out);
+		}
+
+		if (banked < len) {
+			/* Distribute what little we have rather than stalling everyone */
+			len = banked;
+		}
+		if (!len) {
+			continue;
+		}
+
+		pthread_testcancel();
+
+		ao2_lock(class);
+		AST_LIST_TRAVERSE(&class->members, moh, list) {
+			/* Write data */
+			if ((res = write(moh->pipe[1], sbuf, len)) != len) {
+				ast_debug(1, "Only wrote %d of %d bytes to pipe\n", res, len);
+			}
+		}
+		ao2_unlock(class);
+
+		banked -= len;
+		if (banked) {
+			memmove(sbuf, (char *) sbuf + len, banked);
+		}
+	}
+	return NULL;
+}
+
 static int play_moh_exec(struct ast_channel *chan, const char *data)
 {
 	char *parse;
@@ -1404,6 +1629,43 @@ static int init_app_class(struct mohclass *class)
 	return 0;
 }
 
+static int init_broadcast_class(struct mohclass *class)
+{
+	int res;
+
+	res = moh_scan_files(class);
+
+	if (res < 0) {
+		return -1;
+	}
+
+	if (!res) {
+		ast_verb(3, "Files not found in %s for moh class:%s\n",
+			class->dir, class->name);
+		return -1;
+	}
+
+	if (!(class->timer = ast_timer_open())) {
+		ast_log(LOG_WARNING, "Unable to create timer: %s\n", strerror(errno));
+	}
+	if (class->timer && ast_timer_set_rate(class->timer, 25)) {
+		ast_log(LOG_WARNING, "Unable to set 40ms frame rate: %s\n", strerror(errno));
+		ast_timer_close(class->timer);
+		class->timer = NULL;
+	}
+
+	if (ast_pthread_create_background(&class->thread, NULL, moh_broadcast_thread, class)) {
+		ast_log(LOG_WARNING, "Unable to create moh thread...\n");
+		if (class->timer) {
+			ast_timer_close(class->timer);
+			class->timer = NULL;
+		}
+		return -1;
+	}
+
+	return 0;
+}
+
 /*!
  * \note This function owns the reference it gets to moh if unref is true
  */
@@ -1449,6 +1711,13 @@ static int _moh_register(struct mohclass *moh, int reload, int unref, const char
 			}
 			return -1;
 		}
+	} else if (!strcasecmp(moh->mode, "broadcast")) {
+		if (init_broadcast_class(moh)) {
+			if (unref) {
+				moh = mohclass_unref(moh, "unreffing potential new moh class (init_broadcast_class failed)");
+			}
+			return -1;
+		}
 	} else if (!strcasecmp(moh->mode, "mp3") || !strcasecmp(moh->mode, "mp3nb") ||
 			!strcasecmp(moh->mode, "quietmp3") || !strcasecmp(moh->mode, "quietmp3nb") ||
 			!strcasecmp(moh->mode, "httpmp3") || !strcasecmp(moh->mode, "custom")) {
@@ -1778,6 +2047,11 @@ static int local_ast_moh_start(struct ast_channel *chan, const char *mclass, con
 						mohclass = mohclass_unref(mohclass, "unreffing potential mohclass (no playlist entries)");
 						return -1;
 					}
+				} else if (!strcasecmp(mohclass->mode, "broadcast")) {
+					if (init_broadcast_class(mohclass)) {
+						mohclass = mohclass_unref(mohclass, "unreffing potential mohclass (init_broadcast_class failed)");
+						return -1;
+					}
 				} else if (!strcasecmp(mohclass->mode, "mp3") || !strcasecmp(mohclass->mode, "mp3nb") || !strcasecmp(mohclass->mode, "quietmp3") || !strcasecmp(mohclass->mode, "quietmp3nb") || !strcasecmp(mohclass->mode, "httpmp3") || !strcasecmp(mohclass->mode, "custom")) {
 
 					if (!strcasecmp(mohclass->mode, "custom"))
@@ -1857,9 +2131,11 @@ static int local_ast_moh_start(struct ast_channel *chan, const char *mclass, con
 		file_count = AST_VECTOR_SIZE(mohclass->files);
 		ao2_unlock(mohclass);
 
-		if (file_count) {
+		if (file_count && strcasecmp(mohclass->mode, "broadcast")) {
 			res = ast_activate_generator(chan, &moh_file_stream, mohclass);
 		} else {
+			/* Broadcast classes have files too, but their single decoder
+			 * thread feeds the member pipes just like the app modes do. */
 			res = ast_activate_generator(chan, &mohgen, mohclass);
 		}
 	}
@@ -1949,6 +2225,8 @@ static void moh_class_destructor(void *obj)
 		pthread_join(tid, NULL);
 	}
 
+	/* The broadcast decoder's stream is owned by the (now dead) thread */
+	moh_broadcast_close(class);
 }
 
 static int moh_class_mark(void *obj, void *arg, int flags)
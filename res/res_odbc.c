@@ -112,6 +112,21 @@ static void odbc_register_class(struct odbc_class *class, int connect);
 
 AST_THREADSTORAGE(errors_buf);
 
+/*! \brief Maximum number of prepared statements cached on each connection */
+#define MAX_CACHED_STMTS 25
+
+/*!
+ * \brief A prepared statement cached on a pooled connection.
+ *
+ * The cache belongs to the connection and a connection is only ever used by
+ * one thread at a time, so no locking is needed.
+ */
+struct odbc_cached_stmt {
+	AST_LIST_ENTRY(odbc_cached_stmt) list;
+	SQLHSTMT stmt;
+	char sql[0];
+};
+
 struct odbc_txn_frame {
 	AST_LIST_ENTRY(odbc_txn_frame) list;
 	struct ast_channel *owner;
@@ -191,6 +206,46 @@ static void odbc_class_destructor(void *data)
 	ast_free(class->sql_text);
 }
 
+/*!
+ * \internal
+ * \brief Free every prepared statement cached on a connection.
+ *
+ * \note Must be called before the connection is disconnected, as the
+ * statement handles are invalid afterwards.
+ */
+static void odbc_obj_flush_stmt_cache(struct odbc_obj *obj)
+{
+	struct odbc_cached_stmt *cached;
+
+	while ((cached = AST_LIST_REMOVE_HEAD(&obj->cached_stmts, list))) {
+		SQLFreeHandle(SQL_HANDLE_STMT, cached->stmt);
+		ast_free(cached);
+	}
+	obj->cached_stmt_cnt = 0;
+}
+
+/*!
+ * \internal
+ * \brief Dispose of a statement handle, dropping it from the connection's
+ * prepared statement cache if it was cached there.
+ */
+static void odbc_obj_drop_stmt(struct odbc_obj *obj, SQLHSTMT stmt)
+{
+	struct odbc_cached_stmt *cached;
+
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&obj->cached_stmts, cached, list) {
+		if (cached->stmt == stmt) {
+			AST_LIST_REMOVE_CURRENT(list);
+			ast_free(cached);
+			obj->cached_stmt_cnt--;
+			break;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+
+	SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+}
+
 static void odbc_obj_destructor(void *data)
 {
 	struct odbc_obj *obj = data;
@@ -422,7 +477,7 @@ SQLHSTMT ast_odbc_prepare_and_execute(struct odbc_obj *obj, SQLHSTMT (*prepare_c
 		}
 
 		ast_log(LOG_WARNING, "SQL Execute error %d!\n", res);
-		SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+		odbc_obj_drop_stmt(obj, stmt);
 		stmt = NULL;
 	} else if (obj->parent->logging) {
 		long execution_time = ast_tvdiff_ms(ast_tvnow(), start);
@@ -466,6 +521,87 @@ int ast_odbc_prepare(struct odbc_obj *obj, SQLHSTMT *stmt, const char *sql)
 	return SQLPrepare(stmt, (unsigned char *)sql, SQL_NTS);
 }
 
+SQLHSTMT ast_odbc_prepare_cached(struct odbc_obj *obj, const char *sql)
+{
+	struct odbc_cached_stmt *cached;
+	SQLHSTMT stmt;
+	int res;
+
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&obj->cached_stmts, cached, list) {
+		if (!strcmp(cached->sql, sql)) {
+			/* Keep frequently reused statements at the front so that
+			 * eviction below always removes the coldest one. */
+			AST_LIST_REMOVE_CURRENT(list);
+			AST_LIST_INSERT_HEAD(&obj->cached_stmts, cached, list);
+
+			/* Reset the statement so it is ready for fresh bindings */
+			SQLFreeStmt(cached->stmt, SQL_CLOSE);
+			SQLFreeStmt(cached->stmt, SQL_UNBIND);
+			SQLFreeStmt(cached->stmt, SQL_RESET_PARAMS);
+
+			if (obj->parent->logging) {
+				ast_free(obj->sql_text);
+				obj->sql_text = ast_strdup(sql);
+			}
+
+			return cached->stmt;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+
+	res = SQLAllocHandle(SQL_HANDLE_STMT, obj->con, &stmt);
+	if ((res != SQL_SUCCESS) && (res != SQL_SUCCESS_WITH_INFO)) {
+		ast_log(LOG_WARNING, "SQL Alloc Handle failed!\n");
+		return NULL;
+	}
+
+	res = ast_odbc_prepare(obj, stmt, sql);
+	if ((res != SQL_SUCCESS) && (res != SQL_SUCCESS_WITH_INFO)) {
+		if (res == SQL_ERROR) {
+			ast_odbc_print_errors(SQL_HANDLE_STMT, stmt, "SQL Prepare");
+		}
+		ast_log(LOG_WARNING, "SQL Prepare failed! [%s]\n", sql);
+		SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+		return NULL;
+	}
+
+	cached = ast_malloc(sizeof(*cached) + strlen(sql) + 1);
+	if (cached) {
+		strcpy(cached->sql, sql); /* Safe */
+		cached->stmt = stmt;
+		AST_LIST_INSERT_HEAD(&obj->cached_stmts, cached, list);
+
+		if (++obj->cached_stmt_cnt > MAX_CACHED_STMTS) {
+			struct odbc_cached_stmt *coldest = AST_LIST_LAST(&obj->cached_stmts);
+
+			AST_LIST_REMOVE(&obj->cached_stmts, coldest, list);
+			SQLFreeHandle(SQL_HANDLE_STMT, coldest->stmt);
+			ast_free(coldest);
+			obj->cached_stmt_cnt--;
+		}
+	}
+	/* If the cache entry could not be allocated the statement is simply not
+	 * cached; the caller can use and release it all the same. */
+
+	return stmt;
+}
+
+void ast_odbc_release_stmt(struct odbc_obj *obj, SQLHSTMT stmt)
+{
+	struct odbc_cached_stmt *cached;
+
+	AST_LIST_TRAVERSE(&obj->cached_stmts, cached, list) {
+		if (cached->stmt == stmt) {
+			/* Cached on the connection; just close the cursor and keep the
+			 * prepared statement around for the next use. */
+			SQLFreeStmt(stmt, SQL_CLOSE);
+			return;
+		}
+	}
+
+	SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+}
+
 SQLRETURN ast_odbc_execute_sql(struct odbc_obj *obj, SQLHSTMT *stmt, const char *sql)
 {
 	if (obj->parent->logging) {
@@ -996,6 +1132,8 @@ static odbc_status odbc_obj_disconnect(struct odbc_obj *obj)
 		return ODBC_SUCCESS;
 	}
 
+	odbc_obj_flush_stmt_cache(obj);
+
 	con = obj->con;
 	obj->con = NULL;
 	res = SQLDisconnect(con);
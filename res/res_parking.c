@@ -431,25 +431,23 @@ static void parking_lot_cfg_destructor(void *obj)
 	ast_string_field_free_memory(lot_cfg);
 }
 
-/* The arg just needs to have the parking space with it */
-static int parked_user_cmp_fn(void *obj, void *arg, int flags)
-{
-	int *search_space = arg;
-	struct parked_user *user = obj;
-	int object_space = user->parking_space;
-
-	if (*search_space == object_space) {
-		return CMP_MATCH;
-	}
-	return 0;
-}
-
+/*! \brief Sort parked users by space.  The search key is a pointer to the space number. */
 static int parked_user_sort_fn(const void *obj_left, const void *obj_right, int flags)
 {
 	const struct parked_user *left = obj_left;
-	const struct parked_user *right = obj_right;
+	int right_space;
 
-	return left->parking_space - right->parking_space;
+	switch (flags & OBJ_SEARCH_MASK) {
+	case OBJ_SEARCH_KEY:
+		right_space = *(const int *) obj_right;
+		break;
+	case OBJ_SEARCH_OBJECT:
+	default:
+		right_space = ((const struct parked_user *) obj_right)->parking_space;
+		break;
+	}
+
+	return left->parking_space - right_space;
 }
 
 /*!
@@ -646,11 +644,11 @@ static struct parking_lot *alloc_new_parking_lot(struct parking_lot_cfg *lot_cfg
 		return NULL;
 	}
 
-	/* Create parked user ordered list */
-	lot->parked_users = ao2_container_alloc_list(AO2_ALLOC_OPT_LOCK_RWLOCK,
+	/* Create parked user index, ordered and searchable by parking space */
+	lot->parked_users = ao2_container_alloc_rbtree(AO2_ALLOC_OPT_LOCK_RWLOCK,
 		AO2_CONTAINER_ALLOC_OPT_DUPS_REJECT,
 		parked_user_sort_fn,
-		parked_user_cmp_fn);
+		NULL);
 
 	if (!lot->parked_users) {
 		ao2_cleanup(lot);
@@ -432,6 +432,231 @@ static char *cli_show_endpoint_identifiers(struct ast_cli_entry *e, int cmd, str
 #undef ENDPOINT_IDENTIFIER_FORMAT
 }
 
+/*!
+ * Queue depth at which a serializer is considered congested and new work
+ * is refused.  Deliberately below the taskprocessor high-water level so
+ * admission is rejected before the generic overload alert fires.
+ */
+#define SERIALIZER_CONGESTION_LEVEL ((AST_TASKPROCESSOR_HIGH_WATER_LEVEL * 9) / 10)
+
+/*! Number of buckets for the container of serializer statistics */
+#define SERIALIZER_STATS_BUCKETS 53
+
+/*! Number of log2 latency histogram buckets (microsecond scale, ~8 seconds max) */
+#define SERIALIZER_STAT_BUCKETS 24
+
+/*!
+ * \brief Latency statistics aggregated for a family of serializers
+ *
+ * Serializer names carry a unique trailing serial number so statistics
+ * are keyed by the name with that serial stripped.  This keeps the
+ * container bounded while short lived serializers (sessions, subscriptions)
+ * come and go.
+ */
+struct serializer_stats {
+	/*! Number of tasks that have completed */
+	int completed;
+	/*! log2 histogram of enqueue-to-start latency in microseconds */
+	int queue_buckets[SERIALIZER_STAT_BUCKETS];
+	/*! log2 histogram of task run duration in microseconds */
+	int run_buckets[SERIALIZER_STAT_BUCKETS];
+	/*! Serializer family name the statistics are aggregated for */
+	char name[0];
+};
+
+/*! \brief Container of serializer_stats keyed by serializer family name */
+static struct ao2_container *serializer_stats;
+
+AO2_STRING_FIELD_HASH_FN(serializer_stats, name);
+AO2_STRING_FIELD_CMP_FN(serializer_stats, name);
+AO2_STRING_FIELD_SORT_FN(serializer_stats, name);
+
+/*! \brief Histogram bucket index for the given latency: floor(log2(usec)) */
+static unsigned int serializer_stats_bucket(int64_t usec)
+{
+	unsigned int bucket = 0;
+
+	while (usec > 1 && bucket < SERIALIZER_STAT_BUCKETS - 1) {
+		usec >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+/*!
+ * \internal
+ * \brief Find or create the statistics record for a serializer.
+ *
+ * \note Returns the record with its reference bumped or NULL if
+ * statistics are unavailable.
+ */
+static struct serializer_stats *serializer_stats_get(struct ast_taskprocessor *serializer)
+{
+	char key[AST_TASKPROCESSOR_MAX_NAME + 1];
+	const char *name;
+	const char *suffix;
+	struct serializer_stats *stats;
+
+	if (!serializer_stats) {
+		return NULL;
+	}
+
+	name = ast_taskprocessor_name(serializer);
+
+	/* Strip the "-%08x" serial ast_taskprocessor_build_name() appends. */
+	suffix = strrchr(name, '-');
+	if (suffix && strspn(suffix + 1, "0123456789abcdef") == 8 && !suffix[9]) {
+		ast_copy_string(key, name, MIN((size_t) (suffix - name) + 1, sizeof(key)));
+	} else {
+		ast_copy_string(key, name, sizeof(key));
+	}
+
+	stats = ao2_find(serializer_stats, key, OBJ_SEARCH_KEY);
+	if (stats) {
+		return stats;
+	}
+
+	stats = ao2_alloc_options(sizeof(*stats) + strlen(key) + 1, NULL,
+		AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!stats) {
+		return NULL;
+	}
+	strcpy(stats->name, key); /* Safe */
+
+	ao2_link(serializer_stats, stats);
+	return stats;
+}
+
+/*! \brief Task wrapper carrying the enqueue timestamp for latency recording */
+struct serializer_task {
+	/*! The pushed task */
+	int (*sip_task)(void *);
+	/*! Data for the pushed task */
+	void *task_data;
+	/*! Statistics record the execution is charged to */
+	struct serializer_stats *stats;
+	/*! When the task was pushed to the serializer */
+	struct timeval enqueued;
+};
+
+static int serializer_task_exec(void *data)
+{
+	struct serializer_task *wrapper = data;
+	struct serializer_stats *stats = wrapper->stats;
+	struct timeval start = ast_tvnow();
+	unsigned int bucket;
+	int res;
+
+	bucket = serializer_stats_bucket(ast_tvdiff_us(start, wrapper->enqueued));
+	ast_atomic_fetchadd_int(&stats->queue_buckets[bucket], +1);
+
+	res = wrapper->sip_task(wrapper->task_data);
+
+	bucket = serializer_stats_bucket(ast_tvdiff_us(ast_tvnow(), start));
+	ast_atomic_fetchadd_int(&stats->run_buckets[bucket], +1);
+	ast_atomic_fetchadd_int(&stats->completed, +1);
+
+	ao2_ref(stats, -1);
+	ast_free(wrapper);
+	return res;
+}
+
+/*!
+ * \internal
+ * \brief Upper bound latency of the bucket holding the given percentile.
+ *
+ * \retval Latency in microseconds
+ * \retval -1 if the histogram has no samples
+ */
+static int64_t serializer_stats_percentile(const int buckets[], unsigned int percentile)
+{
+	int64_t total = 0;
+	int64_t needed;
+	int64_t seen = 0;
+	unsigned int idx;
+
+	for (idx = 0; idx < SERIALIZER_STAT_BUCKETS; ++idx) {
+		total += buckets[idx];
+	}
+	if (!total) {
+		return -1;
+	}
+
+	needed = (total * percentile + 99) / 100;
+	for (idx = 0; idx < SERIALIZER_STAT_BUCKETS; ++idx) {
+		seen += buckets[idx];
+		if (seen >= needed) {
+			return (int64_t) 1 << (idx + 1);
+		}
+	}
+	return -1;
+}
+
+static void serializer_stats_format(char *buf, size_t size, int64_t usec)
+{
+	if (usec < 0) {
+		ast_copy_string(buf, "-", size);
+	} else if (usec < 1000) {
+		snprintf(buf, size, "%" PRId64 "us", usec);
+	} else {
+		snprintf(buf, size, "%.1fms", usec / 1000.0);
+	}
+}
+
+#define SERIALIZER_STATS_FORMAT "%-46.46s %10d %10s %10s %10s %10s\n"
+#define SERIALIZER_STATS_FORMAT_HDR "%-46.46s %10s %10s %10s %10s %10s\n"
+
+static int cli_print_serializer_stats(void *obj, void *arg, int flags)
+{
+	struct serializer_stats *stats = obj;
+	struct ast_cli_args *a = arg;
+	char queue_p50[32];
+	char queue_p99[32];
+	char run_p50[32];
+	char run_p99[32];
+
+	serializer_stats_format(queue_p50, sizeof(queue_p50),
+		serializer_stats_percentile(stats->queue_buckets, 50));
+	serializer_stats_format(queue_p99, sizeof(queue_p99),
+		serializer_stats_percentile(stats->queue_buckets, 99));
+	serializer_stats_format(run_p50, sizeof(run_p50),
+		serializer_stats_percentile(stats->run_buckets, 50));
+	serializer_stats_format(run_p99, sizeof(run_p99),
+		serializer_stats_percentile(stats->run_buckets, 99));
+
+	ast_cli(a->fd, SERIALIZER_STATS_FORMAT, stats->name, stats->completed,
+		queue_p50, queue_p99, run_p50, run_p99);
+	return 0;
+}
+
+static char *cli_show_serializers(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "pjsip show serializers";
+		e->usage = "Usage: pjsip show serializers\n"
+		            "      Show PJSIP serializer latency statistics\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != 3) {
+		return CLI_SHOWUSAGE;
+	}
+
+	if (!serializer_stats) {
+		ast_cli(a->fd, "No serializer statistics available.\n");
+		return CLI_SUCCESS;
+	}
+
+	ast_cli(a->fd, SERIALIZER_STATS_FORMAT_HDR, "Serializer",
+		"Tasks", "Queue p50", "Queue p99", "Run p50", "Run p99");
+	ao2_callback(serializer_stats, OBJ_NODATA, cli_print_serializer_stats, a);
+
+	return CLI_SUCCESS;
+}
+
 static char *cli_show_settings(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
 {
 	struct ast_sip_cli_context context;
@@ -466,7 +691,8 @@ static char *cli_show_settings(struct ast_cli_entry *e, int cmd, struct ast_cli_
 static struct ast_cli_entry cli_commands[] = {
 	AST_CLI_DEFINE(cli_dump_endpt, "Dump the res_pjsip endpt internals"),
 	AST_CLI_DEFINE(cli_show_settings, "Show global and system configuration options"),
-	AST_CLI_DEFINE(cli_show_endpoint_identifiers, "List registered endpoint identifiers")
+	AST_CLI_DEFINE(cli_show_endpoint_identifiers, "List registered endpoint identifiers"),
+	AST_CLI_DEFINE(cli_show_serializers, "Show PJSIP serializer latency statistics")
 };
 
 AST_RWLIST_HEAD_STATIC(endpoint_formatters, ast_sip_endpoint_formatter);
@@ -1932,13 +2158,41 @@ struct ast_taskprocessor *ast_sip_create_serializer(const char *name)
 
 int ast_sip_push_task(struct ast_taskprocessor *serializer, int (*sip_task)(void *), void *task_data)
 {
+	struct serializer_task *wrapper;
+	struct serializer_stats *stats;
+
 	if (!serializer) {
 		serializer = ast_serializer_pool_get(sip_serializer_pool);
 	}
 
+	stats = serializer ? serializer_stats_get(serializer) : NULL;
+	if (stats) {
+		wrapper = ast_malloc(sizeof(*wrapper));
+		if (wrapper) {
+			wrapper->sip_task = sip_task;
+			wrapper->task_data = task_data;
+			wrapper->stats = stats;
+			wrapper->enqueued = ast_tvnow();
+			if (ast_taskprocessor_push(serializer, serializer_task_exec, wrapper)) {
+				ao2_ref(stats, -1);
+				ast_free(wrapper);
+				return -1;
+			}
+			return 0;
+		}
+		ao2_ref(stats, -1);
+	}
+
+	/* Push the task unwrapped if statistics cannot be collected for it. */
 	return ast_taskprocessor_push(serializer, sip_task, task_data);
 }
 
+int ast_sip_serializer_congested(struct ast_taskprocessor *serializer)
+{
+	return serializer
+		&& ast_taskprocessor_size(serializer) >= SERIALIZER_CONGESTION_LEVEL;
+}
+
 struct sync_task_data {
 	ast_mutex_t lock;
 	ast_cond_t cond;
@@ -2698,6 +2952,14 @@ static int load_module(void)
 		goto error;
 	}
 
+	serializer_stats = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, SERIALIZER_STATS_BUCKETS,
+		serializer_stats_hash_fn, serializer_stats_sort_fn, serializer_stats_cmp_fn);
+	if (!serializer_stats) {
+		ast_log(LOG_ERROR, "Failed to create SIP serializer statistics. Aborting load\n");
+		goto error;
+	}
+
 	if (ast_sip_initialize_scheduler()) {
 		ast_log(LOG_ERROR, "Failed to start scheduler. Aborting load\n");
 		goto error;
@@ -2768,6 +3030,8 @@ error:
 	ast_sip_destroy_scheduler();
 	ast_serializer_pool_destroy(sip_serializer_pool);
 	ast_threadpool_shutdown(sip_threadpool);
+	ao2_cleanup(serializer_stats);
+	serializer_stats = NULL;
 
 	return AST_MODULE_LOAD_DECLINE;
 }
@@ -2799,6 +3063,8 @@ static int unload_module(void)
 	ast_sip_destroy_scheduler();
 	ast_serializer_pool_destroy(sip_serializer_pool);
 	ast_threadpool_shutdown(sip_threadpool);
+	ao2_cleanup(serializer_stats);
+	serializer_stats = NULL;
 
 	return 0;
 }
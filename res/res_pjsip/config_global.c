@@ -54,6 +54,7 @@
 #define DEFAULT_SEND_CONTACT_STATUS_ON_UPDATE_REGISTRATION 0
 #define DEFAULT_TASKPROCESSOR_OVERLOAD_TRIGGER TASKPROCESSOR_OVERLOAD_TRIGGER_GLOBAL
 #define DEFAULT_NOREFERSUB 1
+#define DEFAULT_DISTRIBUTOR_POOL_SIZE 31
 
 /*!
  * \brief Cached global config object
@@ -119,6 +120,8 @@ struct global_config {
 	enum ast_sip_taskprocessor_overload_trigger overload_trigger;
 	/*! Nonzero if norefersub is to be sent in Supported header */
 	unsigned int norefersub;
+	/*! Number of serializers unauthenticated requests are distributed across */
+	unsigned int distributor_pool_size;
 };
 
 static void global_destructor(void *obj)
@@ -537,6 +540,21 @@ unsigned int ast_sip_get_norefersub(void)
 	return norefersub;
 }
 
+unsigned int ast_sip_get_distributor_pool_size(void)
+{
+	unsigned int distributor_pool_size;
+	struct global_config *cfg;
+
+	cfg = get_global_cfg();
+	if (!cfg) {
+		return DEFAULT_DISTRIBUTOR_POOL_SIZE;
+	}
+
+	distributor_pool_size = cfg->distributor_pool_size;
+	ao2_ref(cfg, -1);
+	return distributor_pool_size;
+}
+
 static int overload_trigger_handler(const struct aco_option *opt,
 	struct ast_variable *var, void *obj)
 {
@@ -741,6 +759,9 @@ int ast_sip_initialize_sorcery_global(void)
 	ast_sorcery_object_field_register_custom(sorcery, "global", "taskprocessor_overload_trigger",
 		overload_trigger_map[DEFAULT_TASKPROCESSOR_OVERLOAD_TRIGGER],
 		overload_trigger_handler, overload_trigger_to_str, NULL, 0, 0);
+	ast_sorcery_object_field_register(sorcery, "global", "distributor_pool_size",
+		__stringify(DEFAULT_DISTRIBUTOR_POOL_SIZE),
+		OPT_UINT_T, 0, FLDSET(struct global_config, distributor_pool_size));
 	ast_sorcery_object_field_register(sorcery, "global", "norefersub",
 		DEFAULT_NOREFERSUB ? "yes" : "no",
 		OPT_YESNO_T, 1, FLDSET(struct global_config, norefersub));
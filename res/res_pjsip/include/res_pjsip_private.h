@@ -20,6 +20,7 @@
 struct ao2_container;
 struct ast_threadpool_options;
 struct ast_sip_cli_context;
+struct ast_taskprocessor;
 
 /*!
  * \internal
@@ -412,6 +413,26 @@ enum ast_sip_taskprocessor_overload_trigger {
 
 enum ast_sip_taskprocessor_overload_trigger ast_sip_get_taskprocessor_overload_trigger(void);
 
+/*!
+ * \internal
+ * \brief Retrieve the configured number of distributor pool shards
+ *
+ * \retval Number of serializers unauthenticated requests are distributed across
+ */
+unsigned int ast_sip_get_distributor_pool_size(void);
+
+/*!
+ * \internal
+ * \brief Determine if a serializer's queue is congested
+ *
+ * A serializer is considered congested once its queue depth nears the
+ * taskprocessor high-water alert level.  Admission of new work should
+ * be refused at that point so existing work can drain.
+ *
+ * \retval 1 The serializer is congested, 0 otherwise
+ */
+int ast_sip_serializer_congested(struct ast_taskprocessor *serializer);
+
 const char *ast_sip_overload_trigger_to_str(enum ast_sip_taskprocessor_overload_trigger trigger);
 
 #endif /* RES_PJSIP_PRIVATE_H_ */
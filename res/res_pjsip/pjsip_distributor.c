@@ -30,6 +30,7 @@
 static int distribute(void *data);
 static pj_bool_t distributor(pjsip_rx_data *rdata);
 static pj_status_t record_serializer(pjsip_tx_data *tdata);
+static int distributor_pool_resize(unsigned int new_size);
 
 static pjsip_module distributor_mod = {
 	.name = {"Request Distributor", 19},
@@ -59,11 +60,27 @@ struct unidentified_request{
 	char src_name[];
 };
 
-/*! Number of serializers in pool if one not otherwise known.  (Best if prime number) */
+/*! Default number of serializers in pool if one not otherwise known.  (Best if prime number) */
 #define DISTRIBUTOR_POOL_SIZE		31
 
+/*! Upper bound on the configurable number of distributor shards. */
+#define DISTRIBUTOR_POOL_SIZE_MAX	1024
+
 /*! Pool of serializers to use if not supplied. */
-static struct ast_taskprocessor *distributor_pool[DISTRIBUTOR_POOL_SIZE];
+static struct ast_taskprocessor **distributor_pool;
+
+/*! Number of shards requests are currently distributed across. */
+static unsigned int distributor_pool_size;
+
+/*!
+ * Number of serializers created.  This never shrinks below
+ * distributor_pool_size so shards deactivated by a reload keep draining
+ * their queued work.
+ */
+static unsigned int distributor_pool_alloc;
+
+/*! Protects the distributor pool arrangement against resizes while in use. */
+static ast_rwlock_t distributor_pool_lock = AST_RWLOCK_INIT_VALUE;
 
 /*!
  * \internal
@@ -455,18 +472,60 @@ struct ast_taskprocessor *ast_sip_get_distributor_serializer(pjsip_rx_data *rdat
 		return NULL;
 	}
 
-	if (rdata->msg_info.msg->type == PJSIP_REQUEST_MSG) {
-		remote_tag = &rdata->msg_info.from->tag;
+	if (rdata->tp_info.transport
+		&& rdata->tp_info.transport->key.type != PJSIP_TRANSPORT_UDP
+		&& rdata->tp_info.transport->key.type != PJSIP_TRANSPORT_UDP6) {
+		/*
+		 * Connection oriented transport.  Hash on the connection itself so
+		 * everything received on it lands on the same shard.  A reconnecting
+		 * endpoint's burst of requests is then processed in order by one
+		 * serializer instead of being scattered across the pool.
+		 */
+		hash = buf_hash((const char *) &rdata->tp_info.transport,
+			sizeof(rdata->tp_info.transport));
 	} else {
-		remote_tag = &rdata->msg_info.to->tag;
-	}
+		if (rdata->msg_info.msg->type == PJSIP_REQUEST_MSG) {
+			remote_tag = &rdata->msg_info.from->tag;
+		} else {
+			remote_tag = &rdata->msg_info.to->tag;
+		}
 
-	/* Compute the hash from the SIP message call-id and remote-tag */
-	hash = pjstr_hash(&rdata->msg_info.cid->id);
-	hash = pjstr_hash_add(remote_tag, hash);
+		/* Compute the hash from the SIP message call-id and remote-tag */
+		hash = pjstr_hash(&rdata->msg_info.cid->id);
+		hash = pjstr_hash_add(remote_tag, hash);
+	}
 	hash = ast_str_hash_restrict(hash);
 
-	serializer = ao2_bump(distributor_pool[hash % ARRAY_LEN(distributor_pool)]);
+	ast_rwlock_rdlock(&distributor_pool_lock);
+	if (!distributor_pool_size) {
+		ast_rwlock_unlock(&distributor_pool_lock);
+		return NULL;
+	}
+	serializer = distributor_pool[hash % distributor_pool_size];
+	if (ast_taskprocessor_size(serializer) >= AST_TASKPROCESSOR_HIGH_WATER_LEVEL) {
+		/*
+		 * The hashed shard is backlogged.  Overflow onto the least loaded
+		 * shard so one hot connection or hash bucket cannot stall everyone
+		 * behind it.  Strict receive ordering is already lost once the
+		 * preferred shard is this far behind.
+		 */
+		struct ast_taskprocessor *candidate;
+		long least = ast_taskprocessor_size(serializer);
+		long depth;
+		unsigned int idx;
+
+		for (idx = 0; idx < distributor_pool_size; ++idx) {
+			candidate = distributor_pool[idx];
+			depth = ast_taskprocessor_size(candidate);
+			if (depth < least) {
+				least = depth;
+				serializer = candidate;
+			}
+		}
+	}
+	serializer = ao2_bump(serializer);
+	ast_rwlock_unlock(&distributor_pool_lock);
+
 	if (serializer) {
 		ast_debug(3, "Calculated serializer %s to use for %s\n",
 			ast_taskprocessor_name(serializer), pjsip_rx_data_get_info(rdata));
@@ -566,6 +625,31 @@ static pj_bool_t distributor(pjsip_rx_data *rdata)
 
 		/* Pick a serializer for the out-of-dialog request. */
 		serializer = ast_sip_get_distributor_serializer(rdata);
+		if (ast_sip_serializer_congested(serializer)) {
+			/*
+			 * The chosen serializer is already nearing its high-water
+			 * alert level.  Refuse the new work now, while in-dialog
+			 * traffic can still be processed, rather than letting the
+			 * queue grow until the overload alert fires.
+			 */
+			switch (rdata->tp_info.transport->key.type) {
+			case PJSIP_TRANSPORT_UDP6:
+			case PJSIP_TRANSPORT_UDP:
+				ast_debug(3, "Serializer '%s' congested: Ignoring '%s'.\n",
+					ast_taskprocessor_name(serializer), pjsip_rx_data_get_info(rdata));
+				break;
+			default:
+				ast_debug(3, "Serializer '%s' congested. Received:'%s'. "
+					"Responding with a 503.\n",
+					ast_taskprocessor_name(serializer), pjsip_rx_data_get_info(rdata));
+				pjsip_endpt_respond_stateless(ast_sip_get_pjsip_endpoint(), rdata,
+					PJSIP_SC_SERVICE_UNAVAILABLE, NULL, NULL, NULL);
+				break;
+			}
+			ast_taskprocessor_unreference(serializer);
+			ao2_cleanup(dist);
+			return PJ_TRUE;
+		}
 	}
 
 	if (pjsip_rx_data_clone(rdata, 0, &clone) != PJ_SUCCESS) {
@@ -715,6 +799,186 @@ static void apply_acls(pjsip_rx_data *rdata)
 	}
 }
 
+/*! Number of buckets for the endpoint identity cache.  (Best if prime number) */
+#define IDENTITY_CACHE_BUCKETS 53
+
+/*! Maximum length of an identity cache key ("<transport pointer>/<From user>") */
+#define IDENTITY_CACHE_KEY_LEN 128
+
+/*!
+ * \brief Cached result of endpoint identification for one connection.
+ *
+ * Keyed by the transport and the request From user so several endpoints
+ * sharing one connection (e.g. behind an outbound proxy) cannot be
+ * mistaken for each other.
+ */
+struct identity_cache_entry {
+	/*! Transport the identification was made on.  Used for invalidation, not reffed. */
+	pjsip_transport *transport;
+	/*! Name of the endpoint the request identified to */
+	char *endpoint_name;
+	/*! Search key combining the transport and the From user */
+	char key[];
+};
+
+/*! Endpoint identifications made on still connected transports */
+static struct ao2_container *identity_cache;
+
+/*! Data passed to the transport shutdown monitor so it knows what to prune */
+struct identity_cache_monitor {
+	/*! The transport being monitored */
+	pjsip_transport *transport;
+};
+
+static void identity_cache_entry_destructor(void *obj)
+{
+	struct identity_cache_entry *entry = obj;
+
+	ast_free(entry->endpoint_name);
+}
+
+AO2_STRING_FIELD_HASH_FN(identity_cache_entry, key);
+AO2_STRING_FIELD_CMP_FN(identity_cache_entry, key);
+AO2_STRING_FIELD_SORT_FN(identity_cache_entry, key);
+
+/*!
+ * \internal
+ * \brief Build the identity cache key for a received message.
+ *
+ * \retval 0 on success.
+ * \retval -1 if the message is not cacheable (connectionless transport or
+ * no usable From URI).
+ */
+static int identity_cache_key(pjsip_rx_data *rdata, char *buf, size_t size)
+{
+	pjsip_uri *from = rdata->msg_info.from->uri;
+	pjsip_sip_uri *sip_from;
+
+	if (!rdata->tp_info.transport
+		|| rdata->tp_info.transport->key.type == PJSIP_TRANSPORT_UDP
+		|| rdata->tp_info.transport->key.type == PJSIP_TRANSPORT_UDP6) {
+		/* Only a connection identifies a peer across requests. */
+		return -1;
+	}
+
+	if (!PJSIP_URI_SCHEME_IS_SIP(from) && !PJSIP_URI_SCHEME_IS_SIPS(from)) {
+		return -1;
+	}
+	sip_from = pjsip_uri_get_uri(from);
+
+	snprintf(buf, size, "%p/%.*s", rdata->tp_info.transport,
+		(int) pj_strlen(&sip_from->user), pj_strbuf(&sip_from->user));
+	return 0;
+}
+
+static int identity_cache_prune_transport(void *obj, void *arg, int flags)
+{
+	struct identity_cache_entry *entry = obj;
+
+	return entry->transport == arg ? CMP_MATCH : 0;
+}
+
+static void identity_cache_transport_shutdown(void *data)
+{
+	struct identity_cache_monitor *monitor = data;
+
+	ao2_callback(identity_cache, OBJ_MULTIPLE | OBJ_NODATA | OBJ_UNLINK,
+		identity_cache_prune_transport, monitor->transport);
+}
+
+static int identity_cache_monitor_matcher(void *a, void *b)
+{
+	/* Only one cache monitor is ever needed per transport. */
+	return 1;
+}
+
+/*!
+ * \internal
+ * \brief Retrieve the endpoint a connection's earlier request identified to.
+ *
+ * \retval endpoint (reffed) on a cache hit.
+ * \retval NULL if the identifier chain must run.
+ */
+static struct ast_sip_endpoint *identity_cache_get(pjsip_rx_data *rdata)
+{
+	struct identity_cache_entry *entry;
+	struct ast_sip_endpoint *endpoint;
+	char key[IDENTITY_CACHE_KEY_LEN];
+
+	if (identity_cache_key(rdata, key, sizeof(key))) {
+		return NULL;
+	}
+
+	entry = ao2_find(identity_cache, key, OBJ_SEARCH_KEY);
+	if (!entry) {
+		return NULL;
+	}
+
+	endpoint = ast_sorcery_retrieve_by_id(ast_sip_get_sorcery(), "endpoint",
+		entry->endpoint_name);
+	if (endpoint) {
+		ast_debug(3, "Reusing cached identification of '%s' for %s\n",
+			entry->endpoint_name, pjsip_rx_data_get_info(rdata));
+	} else {
+		/* The endpoint is gone so the cached identity is no longer valid. */
+		ao2_unlink(identity_cache, entry);
+	}
+	ao2_ref(entry, -1);
+	return endpoint;
+}
+
+/*!
+ * \internal
+ * \brief Remember which endpoint a connection's request identified to.
+ *
+ * A transport shutdown monitor is registered so the cached identity cannot
+ * outlive the connection it was learned on.
+ */
+static void identity_cache_add(pjsip_rx_data *rdata, struct ast_sip_endpoint *endpoint)
+{
+	struct identity_cache_entry *entry;
+	struct identity_cache_monitor *monitor;
+	enum ast_transport_monitor_reg reg;
+	char key[IDENTITY_CACHE_KEY_LEN];
+
+	if (identity_cache_key(rdata, key, sizeof(key))) {
+		return;
+	}
+
+	entry = ao2_alloc_options(sizeof(*entry) + strlen(key) + 1,
+		identity_cache_entry_destructor, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!entry) {
+		return;
+	}
+	entry->transport = rdata->tp_info.transport;
+	entry->endpoint_name = ast_strdup(ast_sorcery_object_get_id(endpoint));
+	if (!entry->endpoint_name) {
+		ao2_ref(entry, -1);
+		return;
+	}
+	strcpy(entry->key, key);/* Safe */
+
+	monitor = ao2_alloc_options(sizeof(*monitor), NULL, AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!monitor) {
+		ao2_ref(entry, -1);
+		return;
+	}
+	monitor->transport = rdata->tp_info.transport;
+
+	reg = ast_sip_transport_monitor_register_replace(rdata->tp_info.transport,
+		identity_cache_transport_shutdown, monitor, identity_cache_monitor_matcher);
+	ao2_ref(monitor, -1);
+	if (reg != AST_TRANSPORT_MONITOR_REG_SUCCESS
+		&& reg != AST_TRANSPORT_MONITOR_REG_REPLACED) {
+		/* Without shutdown invalidation the identity must not be cached. */
+		ao2_ref(entry, -1);
+		return;
+	}
+
+	ao2_link(identity_cache, entry);
+	ao2_ref(entry, -1);
+}
+
 static pj_bool_t endpoint_lookup(pjsip_rx_data *rdata)
 {
 	struct ast_sip_endpoint *endpoint;
@@ -738,7 +1002,13 @@ static pj_bool_t endpoint_lookup(pjsip_rx_data *rdata)
 		return PJ_FALSE;
 	}
 
-	endpoint = ast_sip_identify_endpoint(rdata);
+	endpoint = identity_cache_get(rdata);
+	if (!endpoint) {
+		endpoint = ast_sip_identify_endpoint(rdata);
+		if (endpoint) {
+			identity_cache_add(rdata, endpoint);
+		}
+	}
 	if (endpoint) {
 		unid = ao2_find(unidentified_requests, rdata->pkt_info.src_name, OBJ_SEARCH_KEY);
 		if (unid) {
@@ -1124,11 +1394,47 @@ static int cli_unid_print_body(void *obj, void *arg, int flags)
 	return 0;
 }
 
+static char *cli_show_distributor(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	unsigned int idx;
+	long depth;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "pjsip show distributor";
+		e->usage =
+			"Usage: pjsip show distributor\n"
+			"       Show the PJSIP request distributor shards and their queue depths.\n";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != 3) {
+		return CLI_SHOWUSAGE;
+	}
+
+	ast_rwlock_rdlock(&distributor_pool_lock);
+	ast_cli(a->fd, "Distributor shards in use: %u of %u allocated\n\n",
+		distributor_pool_size, distributor_pool_alloc);
+	ast_cli(a->fd, "%-45s %8s\n", "Serializer", "Queued");
+	for (idx = 0; idx < distributor_pool_alloc; ++idx) {
+		depth = ast_taskprocessor_size(distributor_pool[idx]);
+		ast_cli(a->fd, "%-45s %8ld%s\n",
+			ast_taskprocessor_name(distributor_pool[idx]), depth,
+			idx < distributor_pool_size ? "" : " (draining)");
+	}
+	ast_rwlock_unlock(&distributor_pool_lock);
+
+	return CLI_SUCCESS;
+}
+
 static struct ast_cli_entry cli_commands[] = {
 	AST_CLI_DEFINE(ast_sip_cli_traverse_objects, "Show PJSIP Unidentified Requests",
 		.command = "pjsip show unidentified_requests",
 		.usage = "Usage: pjsip show unidentified_requests\n"
 				"       Show the PJSIP Unidentified Requests\n"),
+	AST_CLI_DEFINE(cli_show_distributor, "Show PJSIP request distributor shards"),
 };
 
 struct ast_sip_cli_formatter_entry *unid_formatter;
@@ -1202,6 +1508,12 @@ static void global_loaded(const char *object_type)
 
 	overload_trigger = ast_sip_get_taskprocessor_overload_trigger();
 
+	distributor_pool_resize(ast_sip_get_distributor_pool_size());
+
+	/* A configuration change may remap identities so cached identifications
+	 * cannot be trusted across a reload. */
+	ao2_callback(identity_cache, OBJ_MULTIPLE | OBJ_NODATA | OBJ_UNLINK, NULL, NULL);
+
 	/* Clean out the old task, if any */
 	ast_sched_clean_by_callback(prune_context, prune_task, clean_task);
 	/* Have to do something with the return value to shut up the stupid compiler. */
@@ -1222,39 +1534,96 @@ static struct ast_sorcery_observer global_observer = {
  */
 static void distributor_pool_shutdown(void)
 {
-	int idx;
+	unsigned int idx;
 
-	for (idx = 0; idx < ARRAY_LEN(distributor_pool); ++idx) {
+	ast_rwlock_wrlock(&distributor_pool_lock);
+	for (idx = 0; idx < distributor_pool_alloc; ++idx) {
 		ast_taskprocessor_unreference(distributor_pool[idx]);
-		distributor_pool[idx] = NULL;
 	}
+	ast_free(distributor_pool);
+	distributor_pool = NULL;
+	distributor_pool_size = 0;
+	distributor_pool_alloc = 0;
+	ast_rwlock_unlock(&distributor_pool_lock);
 }
 
 /*!
  * \internal
- * \brief Setup the serializers in the distributor pool.
- * \since 13.10.0
+ * \brief Set the number of shards requests are distributed across.
+ *
+ * Growing creates the additional serializers.  Shrinking only lowers the
+ * number of shards new requests hash onto; the excess serializers are kept
+ * until module shutdown so any work already queued on them still drains.
+ *
+ * \param new_size Requested number of shards.
  *
  * \retval 0 on success.
  * \retval -1 on error.
  */
-static int distributor_pool_setup(void)
+static int distributor_pool_resize(unsigned int new_size)
 {
 	char tps_name[AST_TASKPROCESSOR_MAX_NAME + 1];
-	int idx;
+	struct ast_taskprocessor **new_pool;
+	unsigned int idx;
+
+	if (!new_size) {
+		new_size = DISTRIBUTOR_POOL_SIZE;
+	} else if (new_size > DISTRIBUTOR_POOL_SIZE_MAX) {
+		ast_log(LOG_WARNING, "Distributor pool size %u too large, using maximum of %u\n",
+			new_size, (unsigned int) DISTRIBUTOR_POOL_SIZE_MAX);
+		new_size = DISTRIBUTOR_POOL_SIZE_MAX;
+	}
 
-	for (idx = 0; idx < ARRAY_LEN(distributor_pool); ++idx) {
-		/* Create name with seq number appended. */
-		ast_taskprocessor_build_name(tps_name, sizeof(tps_name), "pjsip/distributor");
+	ast_rwlock_wrlock(&distributor_pool_lock);
+	if (new_size == distributor_pool_size) {
+		ast_rwlock_unlock(&distributor_pool_lock);
+		return 0;
+	}
 
-		distributor_pool[idx] = ast_sip_create_serializer(tps_name);
-		if (!distributor_pool[idx]) {
+	if (new_size > distributor_pool_alloc) {
+		new_pool = ast_realloc(distributor_pool, new_size * sizeof(*new_pool));
+		if (!new_pool) {
+			ast_rwlock_unlock(&distributor_pool_lock);
 			return -1;
 		}
+		distributor_pool = new_pool;
+
+		for (idx = distributor_pool_alloc; idx < new_size; ++idx) {
+			/* Create name with seq number appended. */
+			ast_taskprocessor_build_name(tps_name, sizeof(tps_name), "pjsip/distributor");
+
+			distributor_pool[idx] = ast_sip_create_serializer(tps_name);
+			if (!distributor_pool[idx]) {
+				ast_rwlock_unlock(&distributor_pool_lock);
+				return -1;
+			}
+			distributor_pool_alloc = idx + 1;
+		}
+	}
+
+	if (distributor_pool_size) {
+		ast_debug(1, "Distributor now using %u of %u shards\n", new_size,
+			distributor_pool_alloc);
 	}
+	distributor_pool_size = new_size;
+	ast_rwlock_unlock(&distributor_pool_lock);
 	return 0;
 }
 
+/*!
+ * \internal
+ * \brief Setup the serializers in the distributor pool.
+ * \since 13.10.0
+ *
+ * \retval 0 on success.
+ * \retval -1 on error.
+ */
+static int distributor_pool_setup(void)
+{
+	/* The configured size is applied when the global configuration loads. */
+	return distributor_pool_resize(DISTRIBUTOR_POOL_SIZE);
+}
+
 int ast_sip_initialize_distributor(void)
 {
 	unidentified_requests = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK, 0,
@@ -1271,6 +1640,15 @@ int ast_sip_initialize_distributor(void)
 		return -1;
 	}
 
+	identity_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, IDENTITY_CACHE_BUCKETS,
+		identity_cache_entry_hash_fn, identity_cache_entry_sort_fn,
+		identity_cache_entry_cmp_fn);
+	if (!identity_cache) {
+		ast_sip_destroy_distributor();
+		return -1;
+	}
+
 	if (distributor_pool_setup()) {
 		ast_sip_destroy_distributor();
 		return -1;
@@ -1349,6 +1727,12 @@ void ast_sip_destroy_distributor(void)
 
 	distributor_pool_shutdown();
 
+	if (identity_cache) {
+		ast_sip_transport_monitor_unregister_all(identity_cache_transport_shutdown,
+			NULL, NULL);
+	}
+	ao2_cleanup(identity_cache);
+	identity_cache = NULL;
 	ao2_cleanup(dialog_associations);
 	ao2_cleanup(unidentified_requests);
 }
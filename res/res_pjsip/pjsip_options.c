@@ -125,6 +125,12 @@
 /*! \brief Maximum wait time to join the below shutdown group */
 #define MAX_UNLOAD_TIMEOUT_TIME		10	/* Seconds */
 
+/*! \brief Number of slots in the qualify timer wheel (must be a power of two) */
+#define QUALIFY_WHEEL_SLOTS 64
+
+/*! \brief Granularity of the qualify timer wheel in milliseconds */
+#define QUALIFY_WHEEL_TICK 1000
+
 /*! \brief Shutdown group for options serializers */
 static struct ast_serializer_shutdown_group *shutdown_group;
 
@@ -162,8 +168,10 @@ struct sip_options_endpoint_state_compositor {
  * \brief Structure which contains an AOR and contacts for qualifying purposes
  */
 struct sip_options_aor {
-	/*! \brief The scheduler task for this AOR */
-	struct ast_sip_sched_task *sched_task;
+	/*! \brief Next qualify due time in milliseconds, valid while on the qualify timer wheel */
+	int64_t qualify_due;
+	/*! \brief Non-zero if this AOR is linked into the qualify timer wheel */
+	unsigned int qualify_scheduled:1;
 	/*! \brief The serializer for this AOR */
 	struct ast_taskprocessor *serializer;
 	/*! \brief All contacts associated with this AOR */
@@ -206,6 +214,26 @@ static struct ao2_container *sip_options_contact_statuses;
  */
 static struct ao2_container *sip_options_endpoint_state_compositors;
 
+/*!
+ * \internal
+ * \brief Hashed timer wheel of AORs awaiting their next qualify
+ *
+ * Scheduling a qualify per AOR through the core scheduler churns its
+ * heap constantly with many thousands of qualified AORs.  Instead all
+ * qualifies are driven by a single periodic task which walks one wheel
+ * slot per tick.
+ */
+static struct ao2_container *qualify_wheel[QUALIFY_WHEEL_SLOTS];
+
+/*! \brief Lock protecting qualify timer wheel membership and due times */
+AST_MUTEX_DEFINE_STATIC(qualify_wheel_lock);
+
+/*! \brief The scheduled task driving the qualify timer wheel */
+static struct ast_sip_sched_task *qualify_wheel_task;
+
+/*! \brief Timestamp in milliseconds up to which wheel slots have been processed */
+static int64_t qualify_wheel_processed;
+
 /*!
  * \internal
  * \brief Serializer for AOR, endpoint state compositor, and contact existence management
@@ -934,6 +962,232 @@ static int sip_options_qualify_aor(void *obj)
 	return aor_options->qualify_frequency * 1000;
 }
 
+/*! \brief Current monotonic-enough time in milliseconds for the qualify timer wheel */
+static int64_t qualify_wheel_now(void)
+{
+	return ast_tvdiff_ms(ast_tvnow(), ast_tv(0, 0));
+}
+
+/*! \brief The wheel slot a due time in milliseconds maps to */
+static unsigned int qualify_wheel_slot(int64_t due)
+{
+	return (due / QUALIFY_WHEEL_TICK) & (QUALIFY_WHEEL_SLOTS - 1);
+}
+
+/*!
+ * \internal
+ * \brief Determine when an AOR should next be qualified
+ *
+ * Each AOR fires at a phase within its qualify frequency determined by a
+ * hash of its name.  The jitter is therefore deterministic: AORs sharing
+ * a frequency spread uniformly and keep their spacing across reloads
+ * instead of re-randomizing into bursts.
+ */
+static int64_t sip_options_qualify_next_due(const struct sip_options_aor *aor_options,
+	int64_t now, int initial)
+{
+	int64_t period = aor_options->qualify_frequency * 1000LL;
+	int64_t offset = ast_str_hash(aor_options->name) % period;
+	int64_t due = ((now - offset) / period + 1) * period + offset;
+	int max_time = ast_sip_get_max_initial_qualify_time();
+
+	if (initial && max_time && due > now + max_time * 1000LL) {
+		/* Honor the maximum initial qualify time.  The AOR drifts back
+		 * to its deterministic phase on the following qualify.
+		 */
+		due = now + 1 + ast_str_hash(aor_options->name) % (max_time * 1000LL);
+	}
+
+	return due;
+}
+
+/*!
+ * \internal
+ * \brief Place an AOR onto the qualify timer wheel
+ * \note An AOR already on the wheel is moved to its recomputed slot
+ *
+ * \retval 0 success
+ * \retval -1 failure
+ */
+static int sip_options_qualify_wheel_add(struct sip_options_aor *aor_options, int initial)
+{
+	int64_t due;
+
+	ast_mutex_lock(&qualify_wheel_lock);
+	if (!qualify_wheel[0]) {
+		ast_mutex_unlock(&qualify_wheel_lock);
+		return -1;
+	}
+
+	if (aor_options->qualify_scheduled) {
+		ao2_find(qualify_wheel[qualify_wheel_slot(aor_options->qualify_due)],
+			aor_options, OBJ_NODATA | OBJ_UNLINK | OBJ_SEARCH_OBJECT);
+		aor_options->qualify_scheduled = 0;
+	}
+
+	due = sip_options_qualify_next_due(aor_options, qualify_wheel_now(), initial);
+	ao2_link(qualify_wheel[qualify_wheel_slot(due)], aor_options);
+	aor_options->qualify_due = due;
+	aor_options->qualify_scheduled = 1;
+	ast_mutex_unlock(&qualify_wheel_lock);
+
+	return 0;
+}
+
+/*! \brief Remove an AOR from the qualify timer wheel if it is on it */
+static void sip_options_qualify_wheel_remove(struct sip_options_aor *aor_options)
+{
+	ast_mutex_lock(&qualify_wheel_lock);
+	if (aor_options->qualify_scheduled && qualify_wheel[0]) {
+		ao2_find(qualify_wheel[qualify_wheel_slot(aor_options->qualify_due)],
+			aor_options, OBJ_NODATA | OBJ_UNLINK | OBJ_SEARCH_OBJECT);
+	}
+	aor_options->qualify_scheduled = 0;
+	ast_mutex_unlock(&qualify_wheel_lock);
+}
+
+/*!
+ * \brief Task to qualify an AOR dispatched by the timer wheel
+ * \note Run by aor_options->serializer
+ */
+static int sip_options_qualify_aor_wheel_task(void *obj)
+{
+	struct sip_options_aor *aor_options = obj;
+
+	sip_options_qualify_aor(aor_options);
+	ao2_ref(aor_options, -1);
+
+	return 0;
+}
+
+/*!
+ * \brief Periodic task which advances the qualify timer wheel
+ * \note Run by management_serializer
+ */
+static int sip_options_qualify_wheel_tick(void *obj)
+{
+	struct ao2_container *due_aors;
+	struct sip_options_aor *aor_options;
+	struct ao2_iterator iter;
+	int64_t now = qualify_wheel_now();
+	int64_t slot_time;
+	int64_t start;
+
+	due_aors = ao2_container_alloc_list(AO2_ALLOC_OPT_LOCK_NOLOCK, 0, NULL, NULL);
+	if (!due_aors) {
+		return QUALIFY_WHEEL_TICK;
+	}
+
+	ast_mutex_lock(&qualify_wheel_lock);
+
+	if (!qualify_wheel[0]) {
+		/* The wheel has been torn down, stop ticking */
+		ast_mutex_unlock(&qualify_wheel_lock);
+		ao2_ref(due_aors, -1);
+		return 0;
+	}
+
+	/* Process every slot between the last processed time and now so that a
+	 * delayed tick does not skip slots.  A delay beyond a full rotation needs
+	 * at most one pass over the whole wheel.
+	 */
+	start = qualify_wheel_processed;
+	if (now - start > (int64_t) (QUALIFY_WHEEL_SLOTS - 1) * QUALIFY_WHEEL_TICK) {
+		start = now - (int64_t) (QUALIFY_WHEEL_SLOTS - 1) * QUALIFY_WHEEL_TICK;
+	}
+
+	for (slot_time = start; slot_time <= now; slot_time += QUALIFY_WHEEL_TICK) {
+		struct ao2_container *slot = qualify_wheel[qualify_wheel_slot(slot_time)];
+
+		iter = ao2_iterator_init(slot, 0);
+		while ((aor_options = ao2_iterator_next(&iter))) {
+			/* Entries due on a later rotation share the slot and stay put */
+			if (aor_options->qualify_due <= now) {
+				ao2_link(due_aors, aor_options);
+				ao2_unlink(slot, aor_options);
+			}
+			ao2_ref(aor_options, -1);
+		}
+		ao2_iterator_destroy(&iter);
+	}
+	qualify_wheel_processed = slot_time;
+
+	/* Reinsert the due AORs at their next deterministic deadline while the
+	 * lock is still held so they can never fall off the wheel.
+	 */
+	iter = ao2_iterator_init(due_aors, 0);
+	while ((aor_options = ao2_iterator_next(&iter))) {
+		int64_t due = sip_options_qualify_next_due(aor_options, now, 0);
+
+		ao2_link(qualify_wheel[qualify_wheel_slot(due)], aor_options);
+		aor_options->qualify_due = due;
+		ao2_ref(aor_options, -1);
+	}
+	ao2_iterator_destroy(&iter);
+
+	ast_mutex_unlock(&qualify_wheel_lock);
+
+	/* Dispatch the qualifies outside the wheel lock, each on its own serializer */
+	iter = ao2_iterator_init(due_aors, 0);
+	while ((aor_options = ao2_iterator_next(&iter))) {
+		ao2_ref(aor_options, +1);
+		if (ast_sip_push_task(aor_options->serializer,
+			sip_options_qualify_aor_wheel_task, aor_options)) {
+			ast_log(LOG_ERROR, "Unable to queue qualify for contacts of AOR '%s'\n",
+				aor_options->name);
+			ao2_ref(aor_options, -1);
+		}
+		ao2_ref(aor_options, -1);
+	}
+	ao2_iterator_destroy(&iter);
+	ao2_ref(due_aors, -1);
+
+	return QUALIFY_WHEEL_TICK;
+}
+
+/*! \brief Allocate the qualify timer wheel and start its periodic task */
+static int sip_options_qualify_wheel_setup(struct ast_taskprocessor *serializer)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < QUALIFY_WHEEL_SLOTS; ++idx) {
+		qualify_wheel[idx] = ao2_container_alloc_list(AO2_ALLOC_OPT_LOCK_NOLOCK,
+			0, NULL, NULL);
+		if (!qualify_wheel[idx]) {
+			return -1;
+		}
+	}
+	qualify_wheel_processed = qualify_wheel_now();
+
+	qualify_wheel_task = ast_sip_schedule_task(serializer, QUALIFY_WHEEL_TICK,
+		sip_options_qualify_wheel_tick, "pjsip/options/qualify-wheel", NULL,
+		AST_SIP_SCHED_TASK_VARIABLE);
+	if (!qualify_wheel_task) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/*! \brief Stop the qualify timer wheel task and release the wheel slots */
+static void sip_options_qualify_wheel_destroy(void)
+{
+	unsigned int idx;
+
+	if (qualify_wheel_task) {
+		ast_sip_sched_task_cancel(qualify_wheel_task);
+		ao2_ref(qualify_wheel_task, -1);
+		qualify_wheel_task = NULL;
+	}
+
+	ast_mutex_lock(&qualify_wheel_lock);
+	for (idx = 0; idx < QUALIFY_WHEEL_SLOTS; ++idx) {
+		ao2_cleanup(qualify_wheel[idx]);
+		qualify_wheel[idx] = NULL;
+	}
+	ast_mutex_unlock(&qualify_wheel_lock);
+}
+
 /*! \brief Forward declaration of this helpful function */
 static int sip_options_remove_contact(void *obj, void *arg, int flags);
 
@@ -1090,22 +1344,6 @@ static int sip_options_remove_contact(void *obj, void *arg, int flags)
 	return CMP_MATCH;
 }
 
-/*! \brief Determine an initial time for scheduling AOR qualifying */
-static int sip_options_determine_initial_qualify_time(int qualify_frequency)
-{
-	int initial_interval;
-	int max_time = ast_sip_get_max_initial_qualify_time();
-
-	if (max_time && max_time < qualify_frequency) {
-		initial_interval = max_time;
-	} else {
-		initial_interval = qualify_frequency;
-	}
-
-	initial_interval = (int)((initial_interval * 1000) * ast_random_double());
-	return 0 < initial_interval ? initial_interval : 1;
-}
-
 /*! \brief Set the contact status for a contact */
 static void sip_options_set_contact_status(struct ast_sip_contact_status *contact_status,
 	enum ast_sip_contact_status_type status)
@@ -1349,23 +1587,15 @@ static void sip_options_apply_aor_configuration(struct sip_options_aor *aor_opti
 	 * 3. There are no contacts but previously there were some
 	 */
 	if (aor_options->qualify_frequency != aor->qualify_frequency
-		|| (!aor_options->sched_task && ao2_container_count(aor_options->contacts))
-		|| (aor_options->sched_task && !ao2_container_count(aor_options->contacts))) {
-		if (aor_options->sched_task) {
-			ast_sip_sched_task_cancel(aor_options->sched_task);
-			ao2_ref(aor_options->sched_task, -1);
-			aor_options->sched_task = NULL;
-		}
+		|| (!aor_options->qualify_scheduled && ao2_container_count(aor_options->contacts))
+		|| (aor_options->qualify_scheduled && !ao2_container_count(aor_options->contacts))) {
+		sip_options_qualify_wheel_remove(aor_options);
 
 		/* If there is still a qualify frequency then schedule this */
 		aor_options->qualify_frequency = aor->qualify_frequency;
 		if (aor_options->qualify_frequency
 			&& ao2_container_count(aor_options->contacts)) {
-			aor_options->sched_task = ast_sip_schedule_task(aor_options->serializer,
-				sip_options_determine_initial_qualify_time(aor_options->qualify_frequency),
-				sip_options_qualify_aor, ast_taskprocessor_name(aor_options->serializer),
-				aor_options, AST_SIP_SCHED_TASK_VARIABLE | AST_SIP_SCHED_TASK_DATA_AO2);
-			if (!aor_options->sched_task) {
+			if (sip_options_qualify_wheel_add(aor_options, 1)) {
 				ast_log(LOG_ERROR, "Unable to schedule qualify for contacts of AOR '%s'\n",
 					aor_options->name);
 			}
@@ -1691,11 +1921,7 @@ static int sip_options_aor_remove_task(void *obj)
 
 	sip_options_notify_endpoint_state_compositors(aor_options, REMOVED);
 
-	if (aor_options->sched_task) {
-		ast_sip_sched_task_cancel(aor_options->sched_task);
-		ao2_ref(aor_options->sched_task, -1);
-		aor_options->sched_task = NULL;
-	}
+	sip_options_qualify_wheel_remove(aor_options);
 
 	return 0;
 }
@@ -2103,29 +2329,20 @@ static int sip_options_contact_add_task(void *obj)
 	ao2_cleanup(contact_status);
 
 	if (task_data->aor_options->qualify_frequency) {
-		/* There will always be a contact here, and we need to immediately schedule
-		 * a qualify so that contacts are not waiting for the qualify_frequency
+		/* There will always be a contact here, and we need to immediately
+		 * qualify so that contacts are not waiting for the qualify_frequency
 		 * timer duration before qualifying.
 		 */
-		ast_debug(3, "Starting scheduled callback on AOR '%s' for qualifying as there is now a contact on it\n",
+		ast_debug(3, "Starting qualifying on AOR '%s' as there is now a contact on it\n",
 			task_data->aor_options->name);
 		/*
-		 * We immediately schedule the initial qualify so that we get
-		 * reachable/unreachable as soon as possible.  Realistically
-		 * since they pretty much just registered they should be
-		 * reachable.
+		 * We qualify immediately so that we get reachable/unreachable
+		 * as soon as possible.  Realistically since they pretty much
+		 * just registered they should be reachable.  We are already
+		 * running on the AOR serializer so it can be done in place.
 		 */
-		if (task_data->aor_options->sched_task) {
-			ast_sip_sched_task_cancel(task_data->aor_options->sched_task);
-			ao2_ref(task_data->aor_options->sched_task, -1);
-			task_data->aor_options->sched_task = NULL;
-		}
-		task_data->aor_options->sched_task = ast_sip_schedule_task(
-			task_data->aor_options->serializer, 1, sip_options_qualify_aor,
-			ast_taskprocessor_name(task_data->aor_options->serializer),
-			task_data->aor_options,
-			AST_SIP_SCHED_TASK_VARIABLE | AST_SIP_SCHED_TASK_DATA_AO2);
-		if (!task_data->aor_options->sched_task) {
+		sip_options_qualify_aor(task_data->aor_options);
+		if (sip_options_qualify_wheel_add(task_data->aor_options, 0)) {
 			ast_log(LOG_ERROR, "Unable to schedule qualify for contacts of AOR '%s'\n",
 				task_data->aor_options->name);
 		}
@@ -2282,15 +2499,11 @@ static int sip_options_contact_delete_task(void *obj)
 	sip_options_remove_contact_status(task_data->aor_options, task_data->contact);
 
 	if (task_data->aor_options->qualify_frequency) {
-		/* If this is the last contact then we need to stop the scheduled callback */
+		/* If this is the last contact then we need to stop qualifying */
 		if (!ao2_container_count(task_data->aor_options->contacts)) {
-			ast_debug(3, "Terminating scheduled callback on AOR '%s' as there are no contacts to qualify\n",
+			ast_debug(3, "Terminating qualifying on AOR '%s' as there are no contacts to qualify\n",
 				task_data->aor_options->name);
-			if (task_data->aor_options->sched_task) {
-				ast_sip_sched_task_cancel(task_data->aor_options->sched_task);
-				ao2_ref(task_data->aor_options->sched_task, -1);
-				task_data->aor_options->sched_task = NULL;
-			}
+			sip_options_qualify_wheel_remove(task_data->aor_options);
 		}
 	} else {
 		task_data->aor_options->available =
@@ -2800,11 +3013,7 @@ static int sip_options_cleanup_aor_task(void *obj)
 	ast_debug(2, "Cleaning up AOR '%s' for shutdown\n", aor_options->name);
 
 	aor_options->qualify_frequency = 0;
-	if (aor_options->sched_task) {
-		ast_sip_sched_task_cancel(aor_options->sched_task);
-		ao2_ref(aor_options->sched_task, -1);
-		aor_options->sched_task = NULL;
-	}
+	sip_options_qualify_wheel_remove(aor_options);
 	AST_VECTOR_RESET(&aor_options->compositors, ao2_cleanup);
 
 	return 0;
@@ -2851,6 +3060,8 @@ void ast_res_pjsip_cleanup_options_handling(void)
 	ast_sorcery_observer_remove(ast_sip_get_sorcery(), "endpoint",
 		&endpoint_observer_callbacks);
 
+	sip_options_qualify_wheel_destroy();
+
 	mgmt_serializer = management_serializer;
 	management_serializer = NULL;
 	if (mgmt_serializer) {
@@ -2969,6 +3180,13 @@ int ast_res_pjsip_init_options_handling(int reload)
 	ast_taskprocessor_alert_set_levels(mgmt_serializer, -1,
 		10 * AST_TASKPROCESSOR_HIGH_WATER_LEVEL);
 
+	/* The qualify timer wheel must exist before any AOR can be synchronized */
+	if (sip_options_qualify_wheel_setup(mgmt_serializer)) {
+		management_serializer = mgmt_serializer;
+		ast_res_pjsip_cleanup_options_handling();
+		return -1;
+	}
+
 	/*
 	 * We make sure that the environment is completely setup before we allow
 	 * any other threads to post contact_status updates to the
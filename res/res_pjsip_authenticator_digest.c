@@ -38,6 +38,131 @@ static char default_realm[MAX_REALM_LENGTH + 1];
 
 AO2_GLOBAL_OBJ_STATIC(entity_id);
 
+/*! Number of buckets for the resolved auth object cache.  (Best if prime number) */
+#define AUTH_CACHE_BUCKETS 53
+
+/*!
+ * \brief A resolved authentication object held for reuse.
+ *
+ * Resolving auth objects through sorcery for every request is a noticeable
+ * part of the cost of authenticating a REGISTER flood.  Since sorcery
+ * objects are immutable once created it is safe to hold a reference here
+ * and reuse it until the auth configuration changes.
+ */
+struct auth_cache_entry {
+	/*! The resolved authentication object */
+	struct ast_sip_auth *auth;
+	/*! Value of auth_cache_generation when the object was resolved */
+	int generation;
+	/*! Sorcery object id of the authentication object */
+	char name[];
+};
+
+/*! Cache of resolved authentication objects */
+static struct ao2_container *auth_cache;
+
+/*!
+ * Incremented whenever an auth object is created, updated, deleted or
+ * loaded.  Entries resolved under an older generation are re-resolved on
+ * their next use.
+ */
+static int auth_cache_generation;
+
+static void auth_cache_entry_destructor(void *obj)
+{
+	struct auth_cache_entry *entry = obj;
+
+	ao2_cleanup(entry->auth);
+}
+
+AO2_STRING_FIELD_HASH_FN(auth_cache_entry, name);
+AO2_STRING_FIELD_CMP_FN(auth_cache_entry, name);
+AO2_STRING_FIELD_SORT_FN(auth_cache_entry, name);
+
+static void auth_observer_modified(const void *object)
+{
+	ast_atomic_fetchadd_int(&auth_cache_generation, +1);
+}
+
+static void auth_observer_loaded(const char *object_type)
+{
+	ast_atomic_fetchadd_int(&auth_cache_generation, +1);
+}
+
+/*! \brief Observer which invalidates cached auth objects when they change */
+static const struct ast_sorcery_observer auth_observer = {
+	.created = auth_observer_modified,
+	.updated = auth_observer_modified,
+	.deleted = auth_observer_modified,
+	.loaded = auth_observer_loaded,
+};
+
+/*!
+ * \internal
+ * \brief Resolve an auth object by name, preferring the cache.
+ *
+ * \retval auth (reffed) on success.
+ * \retval NULL if no such auth exists.
+ */
+static struct ast_sip_auth *auth_cache_get(const char *name)
+{
+	struct auth_cache_entry *entry;
+	struct ast_sip_auth *auth = NULL;
+	int generation = ast_atomic_fetchadd_int(&auth_cache_generation, 0);
+
+	entry = ao2_find(auth_cache, name, OBJ_SEARCH_KEY);
+	if (entry) {
+		if (entry->generation == generation) {
+			auth = ao2_bump(entry->auth);
+		} else {
+			/* The auth configuration changed since this was resolved. */
+			ao2_unlink(auth_cache, entry);
+		}
+		ao2_ref(entry, -1);
+	}
+
+	if (!auth) {
+		auth = ast_sorcery_retrieve_by_id(ast_sip_get_sorcery(),
+			SIP_SORCERY_AUTH_TYPE, name);
+		if (auth) {
+			entry = ao2_alloc_options(sizeof(*entry) + strlen(name) + 1,
+				auth_cache_entry_destructor, AO2_ALLOC_OPT_LOCK_NOLOCK);
+			if (entry) {
+				entry->auth = ao2_bump(auth);
+				entry->generation = generation;
+				strcpy(entry->name, name);/* Safe */
+				ao2_link(auth_cache, entry);
+				ao2_ref(entry, -1);
+			}
+		}
+	}
+
+	return auth;
+}
+
+/*!
+ * \internal
+ * \brief Cached equivalent of ast_sip_retrieve_auths().
+ */
+static int retrieve_auths_cached(const struct ast_sip_auth_vector *auth_ids,
+	struct ast_sip_auth **out)
+{
+	int i;
+
+	for (i = 0; i < AST_VECTOR_SIZE(auth_ids); ++i) {
+		/* Using AST_VECTOR_GET is safe since the vector is immutable */
+		const char *name = AST_VECTOR_GET(auth_ids, i);
+
+		out[i] = auth_cache_get(name);
+		if (!out[i]) {
+			ast_log(LOG_NOTICE, "Couldn't find auth '%s'. Cannot authenticate\n", name);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 /*!
  * \brief Determine if authentication is required
  *
@@ -439,7 +564,7 @@ static enum ast_sip_check_auth_result digest_check_auth(struct ast_sip_endpoint
 		}
 	} else {
 		memset(auths, 0, auth_size * sizeof(*auths));
-		if (ast_sip_retrieve_auths(&endpoint->inbound_auths, auths)) {
+		if (retrieve_auths_cached(&endpoint->inbound_auths, auths)) {
 			res = AST_SIP_AUTHENTICATION_ERROR;
 			goto cleanup;
 		}
@@ -546,10 +671,24 @@ static int load_module(void)
 		return AST_MODULE_LOAD_DECLINE;
 	}
 
+	auth_cache = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_RWLOCK,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REPLACE, AUTH_CACHE_BUCKETS,
+		auth_cache_entry_hash_fn, auth_cache_entry_sort_fn,
+		auth_cache_entry_cmp_fn);
+	if (!auth_cache) {
+		ao2_global_obj_release(entity_id);
+		return AST_MODULE_LOAD_DECLINE;
+	}
+
 	ast_sorcery_observer_add(ast_sip_get_sorcery(), "global", &global_observer);
+	ast_sorcery_observer_add(ast_sip_get_sorcery(), SIP_SORCERY_AUTH_TYPE, &auth_observer);
 	ast_sorcery_reload_object(ast_sip_get_sorcery(), "global");
 
 	if (ast_sip_register_authenticator(&digest_authenticator)) {
+		ast_sorcery_observer_remove(ast_sip_get_sorcery(), "global", &global_observer);
+		ast_sorcery_observer_remove(ast_sip_get_sorcery(), SIP_SORCERY_AUTH_TYPE, &auth_observer);
+		ao2_cleanup(auth_cache);
+		auth_cache = NULL;
 		ao2_global_obj_release(entity_id);
 		return AST_MODULE_LOAD_DECLINE;
 	}
@@ -559,7 +698,10 @@ static int load_module(void)
 static int unload_module(void)
 {
 	ast_sorcery_observer_remove(ast_sip_get_sorcery(), "global", &global_observer);
+	ast_sorcery_observer_remove(ast_sip_get_sorcery(), SIP_SORCERY_AUTH_TYPE, &auth_observer);
 	ast_sip_unregister_authenticator(&digest_authenticator);
+	ao2_cleanup(auth_cache);
+	auth_cache = NULL;
 	ao2_global_obj_release(entity_id);
 	return 0;
 }
@@ -369,8 +369,12 @@ struct sip_outbound_registration_client_state {
 	 * we need it to skip failed SRV entries if any.
 	 */
 	pjsip_tx_data *last_tdata;
-	/*! \brief Timer entry for retrying on temporal responses */
-	pj_timer_entry timer;
+	/*! \brief Entry in the shared refresh queue, ordered by due time */
+	AST_LIST_ENTRY(sip_outbound_registration_client_state) refresh_entry;
+	/*! \brief Time at which the next REGISTER attempt is due */
+	time_t refresh_due;
+	/*! \brief Non-zero if this client is linked into the shared refresh queue */
+	unsigned int refresh_scheduled:1;
 	/*! \brief Optional line parameter placed into Contact */
 	char line[LINE_PARAMETER_SIZE];
 	/*! \brief Current number of retries */
@@ -428,6 +432,28 @@ static AO2_GLOBAL_OBJ_STATIC(current_states);
 /*! subscription id for network change events */
 static struct stasis_subscription *network_change_sub;
 
+/*!
+ * \brief Window in seconds within which due refreshes are sent in one batch
+ *
+ * All registrations coming due within the window of a timer tick are
+ * dispatched together, so one wakeup serves every registration whose
+ * refresh aligns (typically trunks registering to the same server with
+ * the same expiration) instead of one timer pop per registration.
+ */
+#define REFRESH_BATCH_WINDOW 1
+
+/*! \brief Queue of clients awaiting their next REGISTER, ordered by due time */
+static AST_LIST_HEAD_STATIC(refresh_queue, sip_outbound_registration_client_state);
+
+/*! \brief The single timer entry driving all registration refreshes */
+static pj_timer_entry refresh_timer;
+
+/*! \brief Non-zero while refresh_timer is believed to be scheduled */
+static int refresh_timer_active;
+
+/*! \brief The due time refresh_timer is currently scheduled for */
+static time_t refresh_timer_due;
+
 /*! \brief hashing function for state objects */
 static int registration_state_hash(const void *obj, const int flags)
 {
@@ -553,14 +579,56 @@ static struct ast_sip_endpoint_identifier line_identifier = {
 	.identify_endpoint = line_identify,
 };
 
-/*! \brief Helper function which cancels the timer on a client */
+/*!
+ * \internal
+ * \brief Arm the shared refresh timer for the earliest queued refresh
+ * \note Must be called with the refresh_queue locked
+ */
+static void refresh_timer_sync(void)
+{
+	struct sip_outbound_registration_client_state *first;
+	pj_time_val delay = { .sec = 0, };
+	time_t now;
+
+	first = AST_LIST_FIRST(&refresh_queue);
+	if (!first) {
+		pj_timer_heap_cancel_if_active(pjsip_endpt_get_timer_heap(ast_sip_get_pjsip_endpoint()),
+			&refresh_timer, refresh_timer.id);
+		refresh_timer_active = 0;
+		return;
+	}
+
+	if (refresh_timer_active && refresh_timer_due <= first->refresh_due) {
+		/* The timer already fires at or before the earliest due refresh */
+		return;
+	}
+
+	pj_timer_heap_cancel_if_active(pjsip_endpt_get_timer_heap(ast_sip_get_pjsip_endpoint()),
+		&refresh_timer, refresh_timer.id);
+	refresh_timer_active = 0;
+
+	now = time(NULL);
+	delay.sec = first->refresh_due > now ? first->refresh_due - now : 0;
+	if (pjsip_endpt_schedule_timer(ast_sip_get_pjsip_endpoint(), &refresh_timer, &delay) == PJ_SUCCESS) {
+		refresh_timer_active = 1;
+		refresh_timer_due = first->refresh_due;
+	} else {
+		ast_log(LOG_WARNING, "Failed to schedule outbound registration refresh timer\n");
+	}
+}
+
+/*! \brief Helper function which removes a client from the shared refresh queue */
 static void cancel_registration(struct sip_outbound_registration_client_state *client_state)
 {
-	if (pj_timer_heap_cancel_if_active(pjsip_endpt_get_timer_heap(ast_sip_get_pjsip_endpoint()),
-		&client_state->timer, client_state->timer.id)) {
-		/* The timer was successfully cancelled, drop the refcount of client_state */
+	AST_LIST_LOCK(&refresh_queue);
+	if (client_state->refresh_scheduled) {
+		AST_LIST_REMOVE(&refresh_queue, client_state, refresh_entry);
+		client_state->refresh_scheduled = 0;
+		refresh_timer_sync();
+		/* The client is out of the queue, drop the refcount it held */
 		ao2_ref(client_state, -1);
 	}
+	AST_LIST_UNLOCK(&refresh_queue);
 }
 
 static pj_str_t PATH_NAME = { "path", 4 };
@@ -712,31 +780,45 @@ static int handle_client_registration(void *data)
 	return 0;
 }
 
-/*! \brief Timer callback function, used just for registrations */
+/*! \brief Timer callback function which dispatches every registration refresh now due */
 static void sip_outbound_registration_timer_cb(pj_timer_heap_t *timer_heap, struct pj_timer_entry *entry)
 {
-	struct sip_outbound_registration_client_state *client_state = entry->user_data;
+	struct sip_outbound_registration_client_state *client_state;
+	AST_LIST_HEAD_NOLOCK(, sip_outbound_registration_client_state) due = AST_LIST_HEAD_NOLOCK_INIT_VALUE;
+	time_t horizon = time(NULL) + REFRESH_BATCH_WINDOW;
 
 	entry->id = 0;
 
-	/*
-	 * Transfer client_state reference to serializer task so the
-	 * nominal path will not dec the client_state ref in this
-	 * pjproject callback thread.
-	 */
-	if (ast_sip_push_task(client_state->serializer, handle_client_registration, client_state)) {
-		ast_log(LOG_WARNING, "Scheduled outbound registration could not be executed.\n");
-		ao2_ref(client_state, -1);
+	AST_LIST_LOCK(&refresh_queue);
+	refresh_timer_active = 0;
+	while ((client_state = AST_LIST_FIRST(&refresh_queue))
+		&& client_state->refresh_due <= horizon) {
+		AST_LIST_REMOVE_HEAD(&refresh_queue, refresh_entry);
+		client_state->refresh_scheduled = 0;
+		AST_LIST_INSERT_TAIL(&due, client_state, refresh_entry);
+	}
+	refresh_timer_sync();
+	AST_LIST_UNLOCK(&refresh_queue);
+
+	while ((client_state = AST_LIST_REMOVE_HEAD(&due, refresh_entry))) {
+		/*
+		 * Transfer the queue's client_state reference to the serializer
+		 * task so the nominal path will not dec the client_state ref in
+		 * this pjproject callback thread.
+		 */
+		if (ast_sip_push_task(client_state->serializer, handle_client_registration, client_state)) {
+			ast_log(LOG_WARNING, "Scheduled outbound registration could not be executed.\n");
+			ao2_ref(client_state, -1);
+		}
 	}
 }
 
-/*! \brief Helper function which sets up the timer to re-register in a specific amount of time */
+/*! \brief Helper function which queues a re-register in a specific amount of time */
 static void schedule_registration(struct sip_outbound_registration_client_state *client_state, unsigned int seconds)
 {
-	pj_time_val delay = { .sec = seconds, };
+	struct sip_outbound_registration_client_state *existing;
 	pjsip_regc_info info;
-
-	cancel_registration(client_state);
+	int inserted = 0;
 
 	pjsip_regc_get_info(client_state->client, &info);
 	ast_debug(1, "Scheduling outbound registration to server '%.*s' from client '%.*s' in %d seconds\n",
@@ -744,13 +826,31 @@ static void schedule_registration(struct sip_outbound_registration_client_state
 			(int) info.client_uri.slen, info.client_uri.ptr,
 			seconds);
 
-	ao2_ref(client_state, +1);
-	if (pjsip_endpt_schedule_timer(ast_sip_get_pjsip_endpoint(), &client_state->timer, &delay) != PJ_SUCCESS) {
-		ast_log(LOG_WARNING, "Failed to schedule registration to server '%.*s' from client '%.*s'\n",
-				(int) info.server_uri.slen, info.server_uri.ptr,
-				(int) info.client_uri.slen, info.client_uri.ptr);
-		ao2_ref(client_state, -1);
+	AST_LIST_LOCK(&refresh_queue);
+	if (client_state->refresh_scheduled) {
+		AST_LIST_REMOVE(&refresh_queue, client_state, refresh_entry);
+	} else {
+		/* The queue holds a reference while the client is on it */
+		ao2_ref(client_state, +1);
+		client_state->refresh_scheduled = 1;
 	}
+	client_state->refresh_due = time(NULL) + seconds;
+
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&refresh_queue, existing, refresh_entry) {
+		if (client_state->refresh_due < existing->refresh_due) {
+			AST_LIST_INSERT_BEFORE_CURRENT(client_state, refresh_entry);
+			inserted = 1;
+			break;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+	if (!inserted) {
+		AST_LIST_INSERT_TAIL(&refresh_queue, client_state, refresh_entry);
+	}
+
+	refresh_timer_sync();
+	AST_LIST_UNLOCK(&refresh_queue);
+
 	client_state->registration_expires = ((int) time(NULL)) + seconds;
 }
 
@@ -1340,8 +1440,6 @@ static struct sip_outbound_registration_state *sip_outbound_registration_state_a
 	}
 
 	state->client_state->status = SIP_REGISTRATION_UNREGISTERED;
-	pj_timer_entry_init(&state->client_state->timer, 0, state->client_state,
-		sip_outbound_registration_timer_cb);
 	state->client_state->transport_name = ast_strdup(registration->transport);
 	state->client_state->registration_name =
 		ast_strdup(ast_sorcery_object_get_id(registration));
@@ -2476,10 +2574,26 @@ static void network_change_stasis_cb(void *data, struct stasis_subscription *sub
 
 static int unload_module(void)
 {
+	struct sip_outbound_registration_client_state *client_state;
 	int remaining;
 
 	network_change_sub = stasis_unsubscribe_and_join(network_change_sub);
 
+	/*
+	 * Stop the shared refresh timer and drop any clients still queued.
+	 * The registration stop paths normally remove each client but this
+	 * makes teardown safe regardless of ordering.
+	 */
+	AST_LIST_LOCK(&refresh_queue);
+	pj_timer_heap_cancel_if_active(pjsip_endpt_get_timer_heap(ast_sip_get_pjsip_endpoint()),
+		&refresh_timer, refresh_timer.id);
+	refresh_timer_active = 0;
+	while ((client_state = AST_LIST_REMOVE_HEAD(&refresh_queue, refresh_entry))) {
+		client_state->refresh_scheduled = 0;
+		ao2_ref(client_state, -1);
+	}
+	AST_LIST_UNLOCK(&refresh_queue);
+
 	ast_manager_unregister("PJSIPShowRegistrationsOutbound");
 	ast_manager_unregister("PJSIPUnregister");
 	ast_manager_unregister("PJSIPRegister");
@@ -2530,6 +2644,8 @@ static int load_module(void)
 		return AST_MODULE_LOAD_DECLINE;
 	}
 
+	pj_timer_entry_init(&refresh_timer, 0, NULL, sip_outbound_registration_timer_cb);
+
 	/* Create outbound registration states container. */
 	new_states = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0,
 		DEFAULT_STATE_BUCKETS, registration_state_hash, NULL, registration_state_cmp);
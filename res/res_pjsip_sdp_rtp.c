@@ -488,6 +488,186 @@ static struct ast_format_cap *set_incoming_call_offer_cap(
 	SCOPE_EXIT_RTN_VALUE(incoming_call_offer_cap);
 }
 
+/*! \brief Maximum number of memoized joint capability results */
+#define JOINT_CAP_CACHE_SIZE 64
+
+/*!
+ * \brief A memoized joint capability negotiation result
+ *
+ * The key is the exact sequence of format objects (with framing) on both
+ * sides.  Holding references to those formats keeps the pointers from
+ * being reused, so a hit can never alias a different format.  Formats
+ * carrying SDP attributes are fresh objects per offer and simply never
+ * hit, which keeps attribute-sensitive negotiation exact.  Formats from
+ * unloaded codec modules stop hitting for the same reason and age out
+ * of the LRU.
+ */
+struct joint_cap_cache_entry {
+	/*! \brief Next entry in the cache, ordered most recently used first */
+	AST_LIST_ENTRY(joint_cap_cache_entry) next;
+	/*! \brief Hash over the format pointers of both sides */
+	unsigned int hash;
+	/*! \brief Snapshot of our capabilities */
+	struct ast_format_cap *ours;
+	/*! \brief Snapshot of the peer capabilities */
+	struct ast_format_cap *theirs;
+	/*! \brief The resulting joint capabilities */
+	struct ast_format_cap *joint;
+};
+
+static AST_LIST_HEAD_STATIC(joint_cap_cache, joint_cap_cache_entry);
+
+/*! \brief Number of entries currently in the joint capability cache */
+static unsigned int joint_cap_cache_count;
+
+/*! \brief Fold the format pointers and framing of a capability set into a hash */
+static unsigned int joint_cap_cache_hash_cap(const struct ast_format_cap *cap, unsigned int hash)
+{
+	size_t count = ast_format_cap_count(cap);
+	size_t idx;
+
+	for (idx = 0; idx < count; ++idx) {
+		struct ast_format *format = ast_format_cap_get_format(cap, idx);
+
+		hash = hash * 31 + (unsigned int) (uintptr_t) format;
+		hash = hash * 31 + ast_format_cap_get_format_framing(cap, format);
+		ao2_ref(format, -1);
+	}
+
+	return hash;
+}
+
+/*! \brief Determine if two capability sets hold the identical format sequence */
+static int joint_cap_cache_cap_identical(const struct ast_format_cap *left,
+	const struct ast_format_cap *right)
+{
+	size_t count = ast_format_cap_count(left);
+	size_t idx;
+
+	if (count != ast_format_cap_count(right)) {
+		return 0;
+	}
+
+	for (idx = 0; idx < count; ++idx) {
+		struct ast_format *left_format = ast_format_cap_get_format(left, idx);
+		struct ast_format *right_format = ast_format_cap_get_format(right, idx);
+		int identical = left_format == right_format
+			&& ast_format_cap_get_format_framing(left, left_format)
+				== ast_format_cap_get_format_framing(right, right_format);
+
+		ao2_ref(left_format, -1);
+		ao2_ref(right_format, -1);
+		if (!identical) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*! \brief Free a joint capability cache entry */
+static void joint_cap_cache_entry_free(struct joint_cap_cache_entry *entry)
+{
+	ao2_cleanup(entry->ours);
+	ao2_cleanup(entry->theirs);
+	ao2_cleanup(entry->joint);
+	ast_free(entry);
+}
+
+/*!
+ * \internal
+ * \brief Look up a memoized joint capability result
+ *
+ * \retval 0 hit, the result was appended to \a joint
+ * \retval -1 miss
+ */
+static int joint_cap_cache_get(const struct ast_format_cap *ours,
+	const struct ast_format_cap *theirs, struct ast_format_cap *joint)
+{
+	struct joint_cap_cache_entry *entry;
+	unsigned int hash;
+
+	hash = joint_cap_cache_hash_cap(theirs, joint_cap_cache_hash_cap(ours, 5381));
+
+	AST_LIST_LOCK(&joint_cap_cache);
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&joint_cap_cache, entry, next) {
+		if (entry->hash == hash
+			&& joint_cap_cache_cap_identical(entry->ours, ours)
+			&& joint_cap_cache_cap_identical(entry->theirs, theirs)) {
+			/* Move the hit to the front so frequent pairs stay cached */
+			AST_LIST_REMOVE_CURRENT(next);
+			AST_LIST_INSERT_HEAD(&joint_cap_cache, entry, next);
+			ast_format_cap_append_from_cap(joint, entry->joint, AST_MEDIA_TYPE_UNKNOWN);
+			AST_LIST_UNLOCK(&joint_cap_cache);
+			return 0;
+		}
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+	AST_LIST_UNLOCK(&joint_cap_cache);
+
+	return -1;
+}
+
+/*! \brief Memoize a joint capability result, evicting the least recently used entry */
+static void joint_cap_cache_put(const struct ast_format_cap *ours,
+	const struct ast_format_cap *theirs, const struct ast_format_cap *joint)
+{
+	struct joint_cap_cache_entry *entry;
+
+	entry = ast_calloc(1, sizeof(*entry));
+	if (!entry) {
+		return;
+	}
+
+	/* The caller's capability sets may be modified later so the key and
+	 * result are snapshotted.  The snapshots reference the same format
+	 * objects, keeping the pointer based key stable.
+	 */
+	entry->ours = ast_format_cap_alloc(AST_FORMAT_CAP_FLAG_DEFAULT);
+	entry->theirs = ast_format_cap_alloc(AST_FORMAT_CAP_FLAG_DEFAULT);
+	entry->joint = ast_format_cap_alloc(AST_FORMAT_CAP_FLAG_DEFAULT);
+	if (!entry->ours || !entry->theirs || !entry->joint
+		|| ast_format_cap_append_from_cap(entry->ours, ours, AST_MEDIA_TYPE_UNKNOWN)
+		|| ast_format_cap_append_from_cap(entry->theirs, theirs, AST_MEDIA_TYPE_UNKNOWN)
+		|| ast_format_cap_append_from_cap(entry->joint, joint, AST_MEDIA_TYPE_UNKNOWN)) {
+		joint_cap_cache_entry_free(entry);
+		return;
+	}
+
+	entry->hash = joint_cap_cache_hash_cap(entry->theirs,
+		joint_cap_cache_hash_cap(entry->ours, 5381));
+
+	AST_LIST_LOCK(&joint_cap_cache);
+	AST_LIST_INSERT_HEAD(&joint_cap_cache, entry, next);
+	if (++joint_cap_cache_count > JOINT_CAP_CACHE_SIZE) {
+		struct joint_cap_cache_entry *evicted;
+		struct joint_cap_cache_entry *last = NULL;
+
+		AST_LIST_TRAVERSE(&joint_cap_cache, evicted, next) {
+			last = evicted;
+		}
+		AST_LIST_REMOVE(&joint_cap_cache, last, next);
+		joint_cap_cache_count--;
+		AST_LIST_UNLOCK(&joint_cap_cache);
+		joint_cap_cache_entry_free(last);
+		return;
+	}
+	AST_LIST_UNLOCK(&joint_cap_cache);
+}
+
+/*! \brief Empty the joint capability cache, releasing the held format references */
+static void joint_cap_cache_flush(void)
+{
+	struct joint_cap_cache_entry *entry;
+
+	AST_LIST_LOCK(&joint_cap_cache);
+	while ((entry = AST_LIST_REMOVE_HEAD(&joint_cap_cache, next))) {
+		joint_cap_cache_entry_free(entry);
+	}
+	joint_cap_cache_count = 0;
+	AST_LIST_UNLOCK(&joint_cap_cache);
+}
+
 static int set_caps(struct ast_sip_session *session,
 	struct ast_sip_session_media *session_media,
 	struct ast_sip_session_media *session_media_transport,
@@ -524,7 +704,12 @@ static int set_caps(struct ast_sip_session *session,
 	get_codecs(session, stream, &codecs, session_media, peer);
 
 	/* get the joint capabilities between peer and endpoint */
-	ast_format_cap_get_compatible(caps, peer, joint);
+	if (joint_cap_cache_get(caps, peer, joint)) {
+		ast_format_cap_get_compatible(caps, peer, joint);
+		if (ast_format_cap_count(joint)) {
+			joint_cap_cache_put(caps, peer, joint);
+		}
+	}
 	if (!ast_format_cap_count(joint)) {
 		struct ast_str *usbuf = ast_str_alloca(AST_FORMAT_CAP_NAMES_LEN);
 		struct ast_str *thembuf = ast_str_alloca(AST_FORMAT_CAP_NAMES_LEN);
@@ -2342,6 +2527,8 @@ static int unload_module(void)
 	ast_sip_session_unregister_sdp_handler(&video_sdp_handler, STR_VIDEO);
 	ast_sip_session_unregister_sdp_handler(&audio_sdp_handler, STR_AUDIO);
 
+	joint_cap_cache_flush();
+
 	if (sched) {
 		ast_sched_context_destroy(sched);
 	}
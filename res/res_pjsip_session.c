@@ -481,6 +481,10 @@ static void session_media_dtor(void *obj)
 		ast_sdp_srtp_destroy(session_media->srtp);
 	}
 
+	if (session_media->cached_media_pool) {
+		pjsip_endpt_release_pool(ast_sip_get_pjsip_endpoint(), session_media->cached_media_pool);
+	}
+
 	ast_free(session_media->mid);
 	ast_free(session_media->remote_mslabel);
 	ast_free(session_media->remote_label);
@@ -4965,6 +4969,121 @@ static void session_inv_on_tsx_state_changed(pjsip_inv_session *inv, pjsip_trans
 	SCOPE_EXIT_RTN();
 }
 
+/*!
+ * \internal
+ * \brief Non-stream state the cached outgoing SDP stream depends upon
+ *
+ * The direction attribute is rewritten on each reuse so hold state is
+ * deliberately not part of this.
+ */
+static unsigned int sdp_stream_cache_flags(const struct ast_sip_session_media *session_media)
+{
+	return session_media->remote_rtcp_mux ? 1 : 0;
+}
+
+/*!
+ * \internal
+ * \brief Set the direction attribute on a reused outgoing SDP stream
+ *
+ * The direction is the only part of an outgoing stream which differs across
+ * hold and unhold cycles, so rather than invalidating the cached copy on
+ * every hold change we rewrite the attribute using the same rules as the
+ * RTP SDP handler.
+ */
+static void sdp_stream_cache_set_direction(struct pjmedia_sdp_media *media,
+	const struct ast_sip_session_media *session_media, const struct ast_stream *stream)
+{
+	static const pj_str_t STR_SENDRECV = { "sendrecv", 8 };
+	static const pj_str_t STR_SENDONLY = { "sendonly", 8 };
+	static const pj_str_t STR_RECVONLY = { "recvonly", 8 };
+	static const pj_str_t STR_INACTIVE = { "inactive", 8 };
+	pj_str_t direction;
+	int index;
+
+	if (session_media->locally_held) {
+		direction = session_media->remotely_held ? STR_INACTIVE : STR_SENDONLY;
+	} else if (session_media->remotely_held) {
+		direction = STR_RECVONLY;
+	} else if (ast_stream_get_state(stream) == AST_STREAM_STATE_SENDONLY) {
+		direction = STR_SENDONLY;
+	} else if (ast_stream_get_state(stream) == AST_STREAM_STATE_RECVONLY) {
+		direction = STR_RECVONLY;
+	} else if (ast_stream_get_state(stream) == AST_STREAM_STATE_INACTIVE) {
+		direction = STR_INACTIVE;
+	} else {
+		direction = STR_SENDRECV;
+	}
+
+	for (index = 0; index < media->attr_count; ++index) {
+		pjmedia_sdp_attr *attr = media->attr[index];
+
+		if (!pj_strcmp(&attr->name, &STR_SENDRECV) || !pj_strcmp(&attr->name, &STR_SENDONLY)
+			|| !pj_strcmp(&attr->name, &STR_RECVONLY) || !pj_strcmp(&attr->name, &STR_INACTIVE)) {
+			attr->name = direction;
+			return;
+		}
+	}
+}
+
+/*!
+ * \internal
+ * \brief Determine whether the cached outgoing SDP stream may be offered again
+ *
+ * Reuse is restricted to the cases where composition is a pure function of
+ * state we can cheaply fingerprint: locally generated offers for unbundled
+ * RTP streams without direct media. Everything else goes back through the
+ * SDP handler.
+ */
+static int sdp_stream_cache_usable(const struct ast_sip_session_media *session_media,
+	const struct pjmedia_sdp_session *remote, const struct ast_stream *stream)
+{
+	if (!session_media->cached_media || remote) {
+		/* Answers depend on the remote SDP so only offers are reused */
+		return 0;
+	}
+	if (session_media->changed || !session_media->rtp || session_media->bundle_group != -1
+		|| !ast_sockaddr_isnull(&session_media->direct_media_addr)) {
+		return 0;
+	}
+	if (session_media->cached_media_flags != sdp_stream_cache_flags(session_media)) {
+		return 0;
+	}
+	return session_media->cached_media_stream_hash == ast_stream_hash(stream);
+}
+
+/*!
+ * \internal
+ * \brief Keep a copy of the outgoing SDP stream a handler just composed
+ *
+ * Outgoing streams are composed into the INVITE session's provisional pool
+ * which does not outlive the negotiation, so the copy lives in a small pool
+ * owned by the session media and is replaced wholesale on the next store.
+ */
+static void sdp_stream_cache_store(struct ast_sip_session_media *session_media,
+	const struct pjmedia_sdp_media *media, const struct ast_stream *stream)
+{
+	if (session_media->cached_media_pool) {
+		session_media->cached_media = NULL;
+		pjsip_endpt_release_pool(ast_sip_get_pjsip_endpoint(), session_media->cached_media_pool);
+	}
+
+	session_media->cached_media_pool = pjsip_endpt_create_pool(ast_sip_get_pjsip_endpoint(),
+		"sdp-cache", 1024, 512);
+	if (!session_media->cached_media_pool) {
+		return;
+	}
+
+	session_media->cached_media = pjmedia_sdp_media_clone(session_media->cached_media_pool, media);
+	if (!session_media->cached_media) {
+		pjsip_endpt_release_pool(ast_sip_get_pjsip_endpoint(), session_media->cached_media_pool);
+		session_media->cached_media_pool = NULL;
+		return;
+	}
+
+	session_media->cached_media_stream_hash = ast_stream_hash(stream);
+	session_media->cached_media_flags = sdp_stream_cache_flags(session_media);
+}
+
 static int add_sdp_streams(struct ast_sip_session_media *session_media,
 	struct ast_sip_session *session, pjmedia_sdp_session *answer,
 	const struct pjmedia_sdp_session *remote,
@@ -4977,11 +5096,29 @@ static int add_sdp_streams(struct ast_sip_session_media *session_media,
 		ast_str_tmp(128, ast_stream_to_str(stream, &STR_TMP)));
 
 	if (handler) {
+		unsigned int media_count = answer->media_count;
+
+		if (sdp_stream_cache_usable(session_media, remote, stream)) {
+			struct pjmedia_sdp_media *media = pjmedia_sdp_media_clone(
+				session->inv_session->pool_prov, session_media->cached_media);
+
+			if (media) {
+				sdp_stream_cache_set_direction(media, session_media, stream);
+				answer->media[answer->media_count++] = media;
+				SCOPE_EXIT_RTN_VALUE(0, "Reused cached outgoing stream\n");
+			}
+		}
+
 		/* if an already assigned handler reports a catastrophic error, fail */
 		res = handler->create_outgoing_sdp_stream(session, session_media, answer, remote, stream);
 		if (res < 0) {
 			SCOPE_EXIT_RTN_VALUE(-1, "Coudn't create sdp stream\n");
 		}
+		if (!remote && answer->media_count > media_count && session_media->rtp
+			&& session_media->bundle_group == -1
+			&& ast_sockaddr_isnull(&session_media->direct_media_addr)) {
+			sdp_stream_cache_store(session_media, answer->media[answer->media_count - 1], stream);
+		}
 		SCOPE_EXIT_RTN_VALUE(0, "Had handler\n");
 	}
 
@@ -144,6 +144,18 @@ AST_VECTOR(, const struct prometheus_metrics_provider *) providers;
 
 static struct timeval last_scrape;
 
+/*! \brief Cached copy of the last formatted scrape (protected by scrape_lock).
+ *
+ * With several Prometheus servers scraping the same instance, re-walking
+ * every metric provider for each request needlessly perturbs the
+ * subsystems being measured.  When \c scrape_cache_ms is configured,
+ * requests arriving within that window are served this copy instead.
+ */
+static struct ast_str *scrape_cache;
+
+/*! \brief When \c scrape_cache was last refreshed */
+static struct timeval scrape_cache_time;
+
 /*! \brief The actual module config */
 struct module_config {
 	/*! \brief General settings */
@@ -636,6 +648,19 @@ static int http_callback(struct ast_tcptls_session_instance *ser,
 
 	ast_mutex_lock(&scrape_lock);
 
+	if (mod_cfg->general->scrape_cache_ms && scrape_cache
+		&& ast_tvdiff_ms(start, scrape_cache_time) < mod_cfg->general->scrape_cache_ms) {
+		if (ast_str_append(&response, 0, "%s", ast_str_buffer(scrape_cache)) == AST_DYNSTR_BUILD_FAILED) {
+			ast_mutex_unlock(&scrape_lock);
+			goto err500;
+		}
+		ast_mutex_unlock(&scrape_lock);
+
+		ast_http_send(ser, method, 200, "OK", NULL, response, 0, 0);
+
+		return 0;
+	}
+
 	last_scrape = start;
 	scrape_metrics(&response);
 
@@ -650,6 +675,17 @@ static int http_callback(struct ast_tcptls_session_instance *ser,
 			duration);
 		prometheus_metric_to_string(&core_scrape_metric, &response);
 	}
+
+	if (mod_cfg->general->scrape_cache_ms) {
+		/* ast_http_send takes ownership of response, so stash a copy */
+		if (!scrape_cache) {
+			scrape_cache = ast_str_create(ast_str_strlen(response) + 1);
+		}
+		if (scrape_cache
+			&& ast_str_set(&scrape_cache, 0, "%s", ast_str_buffer(response)) != AST_DYNSTR_BUILD_FAILED) {
+			scrape_cache_time = start;
+		}
+	}
 	ast_mutex_unlock(&scrape_lock);
 
 	ast_http_send(ser, method, 200, "OK", NULL, response, 0, 0);
@@ -901,6 +937,9 @@ static int unload_module(void)
 
 	AST_VECTOR_FREE(&providers);
 
+	ast_free(scrape_cache);
+	scrape_cache = NULL;
+
 	aco_info_destroy(&cfg_info);
 	ao2_global_obj_release(global_config);
 
@@ -967,6 +1006,7 @@ static int load_module(void)
 	aco_option_register(&cfg_info, "auth_username", ACO_EXACT, global_options, "", OPT_STRINGFIELD_T, 0, STRFLDSET(struct prometheus_general_config, auth_username));
 	aco_option_register(&cfg_info, "auth_password", ACO_EXACT, global_options, "", OPT_STRINGFIELD_T, 0, STRFLDSET(struct prometheus_general_config, auth_password));
 	aco_option_register(&cfg_info, "auth_realm", ACO_EXACT, global_options, "Asterisk Prometheus Metrics", OPT_STRINGFIELD_T, 0, STRFLDSET(struct prometheus_general_config, auth_realm));
+	aco_option_register(&cfg_info, "scrape_cache_ms", ACO_EXACT, global_options, "0", OPT_UINT_T, 0, FLDSET(struct prometheus_general_config, scrape_cache_ms));
 	if (aco_process_config(&cfg_info, 0) == ACO_PROCESS_ERROR) {
 		goto cleanup;
 	}
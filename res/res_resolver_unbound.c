@@ -332,6 +332,7 @@ static int unbound_resolver_cancel(struct ast_dns_query *query)
 struct ast_dns_resolver unbound_resolver = {
 	.name = "unbound",
 	.priority = 100,
+	.cacheable = 1,
 	.resolve = unbound_resolver_resolve,
 	.cancel = unbound_resolver_cancel,
 };
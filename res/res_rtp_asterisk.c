@@ -42,6 +42,12 @@
 #include "asterisk/dns_recurring.h"
 
 #include <sys/time.h>
+#ifdef HAVE_RECVMMSG
+#include <sys/socket.h>
+#endif
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
 #include <signal.h>
 #include <fcntl.h>
 #include <math.h>
@@ -71,6 +77,7 @@
 #endif
 
 #include "asterisk/conversions.h"
+#include "asterisk/alertpipe.h"
 #include "asterisk/options.h"
 #include "asterisk/logger_category.h"
 #include "asterisk/stun.h"
@@ -88,6 +95,9 @@
 #include "asterisk/module.h"
 #include "asterisk/rtp_engine.h"
 #include "asterisk/smoother.h"
+#include "asterisk/timing.h"
+#include "asterisk/latency_trace.h"
+#include "asterisk/poll-compat.h"
 #include "asterisk/uuid.h"
 #include "asterisk/test.h"
 #include "asterisk/data_buffer.h"
@@ -190,8 +200,21 @@ enum strict_rtp_mode {
 
 #define DEFAULT_STRICT_RTP STRICT_RTP_YES	/*!< Enabled by default */
 #define DEFAULT_SRTP_REPLAY_PROTECTION 1
+#define DEFAULT_BATCH_RECEIVE 0	/*!< Disabled by default */
+#define DEFAULT_RTP_REACTOR 0	/*!< Disabled by default */
 #define DEFAULT_ICESUPPORT 1
 #define DEFAULT_STUN_SOFTWARE_ATTRIBUTE 1
+#define DEFAULT_ICE_POOL_SIZE 0	/*!< Pre-gathered ICE transport pool disabled by default */
+#define MAX_ICE_POOL_SIZE 64
+#define ICE_POOL_REFRESH_INTERVAL 30	/*!< Seconds between keepalive passes over pooled STUN mappings */
+#define ICE_POOL_VALIDATE_INTERVAL 300	/*!< Seconds between full re-resolutions of a pooled STUN mapping */
+#define DEFAULT_PACING 0	/*!< Outbound RTP pacing disabled by default */
+#define DEFAULT_PACING_INTERVAL 5	/*!< Milliseconds between pacer bursts */
+#define MIN_PACING_INTERVAL 1
+#define MAX_PACING_INTERVAL 20
+#define DEFAULT_PACING_BURST 3	/*!< Packets an instance may send per pacer burst */
+#define MAX_PACING_BURST 32
+#define PACING_MAX_QUEUE 64	/*!< Queued packets per instance before the pacer starts dropping */
 #define DEFAULT_DTLS_MTU 1200
 
 extern struct ast_srtp_res *res_srtp;
@@ -214,6 +237,11 @@ static int strictrtp = DEFAULT_STRICT_RTP; /*!< Only accept RTP frames from a de
 static int learning_min_sequential = DEFAULT_LEARNING_MIN_SEQUENTIAL; /*!< Number of sequential RTP frames needed from a single source during learning mode to accept new source. */
 static int learning_min_duration = DEFAULT_LEARNING_MIN_DURATION; /*!< Lowest acceptable timeout between the first and the last sequential RTP frame. */
 static int srtp_replay_protection = DEFAULT_SRTP_REPLAY_PROTECTION;
+static int batchreceive = DEFAULT_BATCH_RECEIVE; /*!< Drain multiple datagrams per syscall with recvmmsg() where available. */
+static int rtpreactor = DEFAULT_RTP_REACTOR; /*!< Service RTP sockets from shared I/O reactor threads where available. */
+static int pacing = DEFAULT_PACING; /*!< Pace and batch outgoing RTP from a timer driven thread instead of sending inline. */
+static int pacing_interval = DEFAULT_PACING_INTERVAL; /*!< Milliseconds between pacer bursts. */
+static int pacing_burst = DEFAULT_PACING_BURST; /*!< Maximum packets an instance may send per pacer burst. */
 #if defined(HAVE_OPENSSL) && (OPENSSL_VERSION_NUMBER >= 0x10001000L) && !defined(OPENSSL_NO_SRTP)
 static int dtls_mtu = DEFAULT_DTLS_MTU;
 #endif
@@ -240,6 +268,39 @@ static ast_rwlock_t stun_acl_lock = AST_RWLOCK_INIT_VALUE;
 static ast_rwlock_t stunaddr_lock = AST_RWLOCK_INIT_VALUE;
 static struct ast_dns_query_recurring *stunaddr_resolver = NULL;
 
+/*!
+ * \brief A pre-gathered ICE transport waiting to be drawn by a new RTP instance.
+ *
+ * The sockets are already bound to an even/odd port pair within the
+ * configured RTP port range and their STUN mapped addresses have been
+ * resolved in the background, so instances drawing from the pool skip the
+ * blocking STUN round trip during call setup.
+ */
+struct ice_pooled_transport {
+	AST_LIST_ENTRY(ice_pooled_transport) next;
+	/*! Bound RTP socket */
+	int rtp_sock;
+	/*! Bound RTCP socket (RTP port plus one) */
+	int rtcp_sock;
+	/*! Even port the RTP socket is bound to */
+	int port;
+	/*! STUN server the mapped addresses were gathered from */
+	struct sockaddr_in stun_server;
+	/*! STUN mapped address of the RTP socket */
+	struct sockaddr_in stun_rtp;
+	/*! STUN mapped address of the RTCP socket */
+	struct sockaddr_in stun_rtcp;
+	/*! When the mapped addresses were last gathered or refreshed */
+	struct timeval gathered;
+};
+
+static AST_LIST_HEAD_STATIC(ice_pool, ice_pooled_transport);
+static int ice_pool_size = DEFAULT_ICE_POOL_SIZE;
+static int ice_pool_count;
+static int ice_pool_shutdown;
+static pthread_t ice_pool_thread = AST_PTHREADT_NULL;
+static ast_cond_t ice_pool_cond;
+
 /*! \brief Pool factory used by pjlib to allocate memory. */
 static pj_caching_pool cachingpool;
 
@@ -291,6 +352,30 @@ static char *generate_random_string(char *buf, size_t size);
 
 #endif
 
+/*! \brief An outbound RTP packet waiting for the pacer thread to send it */
+struct rtp_paced_packet {
+	AST_LIST_ENTRY(rtp_paced_packet) next;
+	/*! Where the packet is to be sent */
+	struct ast_sockaddr sa;
+	/*! Length of the packet */
+	size_t len;
+	/*! The packet itself */
+	unsigned char data[0];
+};
+
+/*! \brief Entry on the pacer thread's list of instances with queued packets */
+struct rtp_pacer_entry {
+	AST_LIST_ENTRY(rtp_pacer_entry) next;
+	/*! The RTP instance, holds a reference while on the list */
+	struct ast_rtp_instance *instance;
+};
+
+/*! \brief Instances with packets queued for the pacer thread */
+static AST_LIST_HEAD_STATIC(rtp_pacer, rtp_pacer_entry);
+static int rtp_pacer_shutdown;
+static pthread_t rtp_pacer_thread = AST_PTHREADT_NULL;
+static ast_cond_t rtp_pacer_cond;
+
 #define FLAG_3389_WARNING               (1 << 0)
 #define FLAG_NAT_ACTIVE                 (3 << 1)
 #define FLAG_NAT_INACTIVE               (0 << 1)
@@ -307,6 +392,7 @@ static char *generate_random_string(char *buf, size_t size);
 /*! \brief RTP learning mode tracking information */
 struct rtp_learning_info {
 	struct ast_sockaddr proposed_address;	/*!< Proposed remote address for strict RTP */
+	struct ast_sockaddr_key proposed_address_key;	/*!< Comparison key kept in sync with proposed_address */
 	struct timeval start;	/*!< The time learning mode was started */
 	struct timeval received; /*!< The time of the first received packet */
 	int max_seq;	/*!< The highest sequence number received */
@@ -323,6 +409,8 @@ struct dtls_details {
 	enum ast_rtp_dtls_setup dtls_setup; /*!< Current setup state */
 	enum ast_rtp_dtls_connection connection; /*!< Whether this is a new or existing connection */
 	int timeout_timer; /*!< Scheduler id for timeout timer */
+	SSL_SESSION *session; /*!< Established session cached for resumption on re-setup */
+	struct timeval handshake_begin; /*!< Start of the in-progress handshake, zero when none */
 };
 #endif
 
@@ -343,6 +431,15 @@ struct rtp_ssrc_mapping {
 	struct ast_rtp_instance *instance;
 };
 
+/*! \brief Number of slots in the per-instance SSRC demultiplexing hash (power of two) */
+#define SSRC_MAPPING_HASH_SIZE 32
+
+/*! \brief Maximum number of SSRC mappings the hash will index before falling back to a linear scan */
+#define SSRC_MAPPING_HASH_LIMIT 24
+
+/*! \brief Fibonacci hash of a received SSRC to a slot in the demultiplexing hash */
+#define SSRC_MAPPING_HASH(ssrc) (((ssrc) * 2654435761U) >> 27)
+
 /*! \brief Packet statistics (used for transport-cc) */
 struct rtp_transport_wide_cc_packet_statistics {
 	/*! The transport specific sequence number */
@@ -374,6 +471,28 @@ typedef struct {
 	unsigned char is_set;
 } optional_ts;
 
+#ifdef HAVE_RECVMMSG
+/*! \brief Number of datagrams recvmmsg() may drain in one syscall */
+#define RTP_RECV_BATCH_SIZE 16
+/*! \brief Size of each staging slot; RTP packets stay under the path MTU in practice */
+#define RTP_RECV_BATCH_SLOT 2048
+
+/*! \brief Staging area for datagrams drained by one recvmmsg() call */
+struct rtp_recv_batch {
+	/*! Source address of each staged datagram */
+	struct ast_sockaddr addr[RTP_RECV_BATCH_SIZE];
+	/*! Length of each staged datagram */
+	unsigned short len[RTP_RECV_BATCH_SIZE];
+	/*! Next staged datagram to hand out */
+	unsigned short next;
+	/*! Number of datagrams from the last drain */
+	unsigned short count;
+	/*! Staged datagram payloads; slot 0 is unused since the first
+	 * datagram of a drain is delivered into the caller's buffer. */
+	unsigned char slot[RTP_RECV_BATCH_SIZE][RTP_RECV_BATCH_SLOT];
+};
+#endif
+
 /*! \brief RTP session description */
 struct ast_rtp {
 	int s;
@@ -432,13 +551,20 @@ struct ast_rtp {
 	struct ast_rtcp *rtcp;
 	unsigned int asymmetric_codec;  /*!< Indicate if asymmetric send/receive codecs are allowed */
 
+	AST_LIST_HEAD_NOLOCK(, rtp_paced_packet) paced_packets; /*!< Outbound packets queued for the pacer thread */
+	unsigned int paced_count;         /*!< Number of packets queued for the pacer thread */
+	unsigned int paced_scheduled:1;   /*!< This instance is on the pacer thread's list */
+
 	struct ast_rtp_instance *bundled; /*!< The RTP instance we are bundled to */
 	int stream_num; /*!< Stream num for this RTP instance */
 	AST_VECTOR(, struct rtp_ssrc_mapping) ssrc_mapping; /*!< Mappings of SSRC to RTP instances */
+	struct rtp_ssrc_mapping ssrc_hash[SSRC_MAPPING_HASH_SIZE]; /*!< Open-addressing index of ssrc_mapping by received SSRC */
+	unsigned int ssrc_hash_full:1; /*!< Too many mappings to index, lookups must use the linear scan */
 	struct ast_sockaddr bind_address; /*!< Requested bind address for the sockets */
 
 	enum strict_rtp_state strict_rtp_state; /*!< Current state that strict RTP protection is in */
 	struct ast_sockaddr strict_rtp_address;  /*!< Remote address information for strict RTP purposes */
+	struct ast_sockaddr_key strict_rtp_address_key; /*!< Comparison key kept in sync with strict_rtp_address */
 
 	/*
 	 * Learning mode values based on pjmedia's probation mode.  Many of these values are redundant to the above,
@@ -450,6 +576,15 @@ struct ast_rtp {
 
 	struct ast_data_buffer *send_buffer;		/*!< Buffer for storing sent packets for retransmission */
 	struct ast_data_buffer *recv_buffer;		/*!< Buffer for storing received packets for retransmission */
+#ifdef HAVE_RECVMMSG
+	struct rtp_recv_batch *recv_batch;		/*!< Datagrams drained by recvmmsg() awaiting processing */
+#endif
+#ifdef HAVE_EPOLL
+	int reactor_registered;		/*!< Socket has been handed to the shared I/O reactor */
+#endif
+
+	unsigned int stats_seq;		/*!< Seqlock counter guarding stats_snapshot; odd while an update is in progress, zero until first publish */
+	struct ast_rtp_instance_stats stats_snapshot;	/*!< Last published statistics, readable without the instance lock */
 
 	struct rtp_transport_wide_cc_statistics transport_wide_cc; /*!< Transport-cc statistics information */
 
@@ -482,6 +617,13 @@ struct ast_rtp {
 	struct ast_sockaddr ice_original_rtp_addr;            /*!< rtp address that ICE started on first session */
 	unsigned int ice_num_components; /*!< The number of ICE components */
 	unsigned int ice_media_started:1; /*!< ICE media has started, either on a valid pair or on ICE completion */
+
+	int pool_rtcp_sock;         /*!< Pre-bound RTCP socket drawn from the candidate pool but not yet adopted, -1 when none */
+	unsigned int pool_stun_rtp_valid:1;  /*!< pool_stun_rtp holds a pre-gathered mapped address for the RTP socket */
+	unsigned int pool_stun_rtcp_valid:1; /*!< pool_stun_rtcp holds a pre-gathered mapped address for the RTCP socket */
+	struct sockaddr_in pool_stun_server; /*!< STUN server the pre-gathered mapped addresses came from */
+	struct sockaddr_in pool_stun_rtp;    /*!< Pre-gathered STUN mapped address of the RTP socket */
+	struct sockaddr_in pool_stun_rtcp;   /*!< Pre-gathered STUN mapped address of the RTCP socket */
 #endif
 
 #if defined(HAVE_OPENSSL) && (OPENSSL_VERSION_NUMBER >= 0x10001000L) && !defined(OPENSSL_NO_SRTP)
@@ -619,6 +761,8 @@ static int rtp_red_init(struct ast_rtp_instance *instance, int buffer_time, int
 static int rtp_red_buffer(struct ast_rtp_instance *instance, struct ast_frame *frame);
 static int ast_rtp_local_bridge(struct ast_rtp_instance *instance0, struct ast_rtp_instance *instance1);
 static int ast_rtp_get_stat(struct ast_rtp_instance *instance, struct ast_rtp_instance_stats *stats, enum ast_rtp_instance_stat stat);
+static int ast_rtp_get_stat_nolock(struct ast_rtp_instance *instance, struct ast_rtp_instance_stats *stats, enum ast_rtp_instance_stat stat);
+static void rtp_stats_publish(struct ast_rtp_instance *instance, struct ast_rtp *rtp);
 static int ast_rtp_dtmf_compatible(struct ast_channel *chan0, struct ast_rtp_instance *instance0, struct ast_channel *chan1, struct ast_rtp_instance *instance1);
 static void ast_rtp_stun_request(struct ast_rtp_instance *instance, struct ast_sockaddr *suggestion, const char *username);
 static void ast_rtp_stop(struct ast_rtp_instance *instance);
@@ -654,7 +798,7 @@ static BIO_METHOD *dtls_bio_methods;
 #endif
 #endif
 
-static int __rtp_sendto(struct ast_rtp_instance *instance, void *buf, size_t size, int flags, struct ast_sockaddr *sa, int rtcp, int *via_ice, int use_srtp);
+static int __rtp_sendto(struct ast_rtp_instance *instance, void *buf, size_t size, size_t avail, int flags, struct ast_sockaddr *sa, int rtcp, int *via_ice, int use_srtp);
 
 #ifdef HAVE_PJPROJECT
 static void stunaddr_resolve_callback(const struct ast_dns_query *query);
@@ -718,7 +862,7 @@ static int dtls_bio_write(BIO *bio, const char *buf, int len)
 		return len;
 	}
 
-	bytes_sent = __rtp_sendto(instance, (char *)buf, len, 0, &remote_address, rtcp, &ice, 0);
+	bytes_sent = __rtp_sendto(instance, (char *)buf, len, 0, 0, &remote_address, rtcp, &ice, 0);
 
 	if (bytes_sent > 0 && ast_debug_dtls_packet_is_allowed) {
 		ast_debug(0, "(%p) DTLS - sent %s packet to %s%s (len %-6.6d)\n",
@@ -2167,6 +2311,13 @@ static int ast_rtp_dtls_set_configuration(struct ast_rtp_instance *instance, con
 
 	SSL_CTX_set_read_ahead(rtp->ssl_ctx, 1);
 
+	/* Cache negotiated sessions so that when the connection is re-established
+	 * within the call (re-INVITE driven resets, ICE restarts) the handshake
+	 * resumes instead of repeating the expensive key exchange.
+	 */
+	SSL_CTX_set_session_cache_mode(rtp->ssl_ctx, SSL_SESS_CACHE_BOTH);
+	SSL_CTX_set_session_id_context(rtp->ssl_ctx, (const unsigned char *)"asterisk", 8);
+
 	configure_dhparams(rtp, dtls_cfg);
 
 	rtp->dtls_verify = dtls_cfg->verify;
@@ -2288,6 +2439,11 @@ static void ast_rtp_dtls_stop(struct ast_rtp_instance *instance)
 		rtp->dtls.ssl = NULL;
 	}
 
+	if (rtp->dtls.session) {
+		SSL_SESSION_free(rtp->dtls.session);
+		rtp->dtls.session = NULL;
+	}
+
 	if (rtp->rtcp) {
 		ao2_unlock(instance);
 		dtls_srtp_stop_timeout_timer(instance, rtp, 1);
@@ -2299,6 +2455,11 @@ static void ast_rtp_dtls_stop(struct ast_rtp_instance *instance)
 			}
 			rtp->rtcp->dtls.ssl = NULL;
 		}
+
+		if (rtp->rtcp->dtls.session) {
+			SSL_SESSION_free(rtp->rtcp->dtls.session);
+			rtp->rtcp->dtls.session = NULL;
+		}
 	}
 }
 
@@ -2517,6 +2678,7 @@ static struct ast_rtp_engine asterisk_rtp_engine = {
 	.red_buffer = rtp_red_buffer,
 	.local_bridge = ast_rtp_local_bridge,
 	.get_stat = ast_rtp_get_stat,
+	.get_stat_nolock = ast_rtp_get_stat_nolock,
 	.dtmf_compatible = ast_rtp_dtmf_compatible,
 	.stun_request = ast_rtp_stun_request,
 	.stop = ast_rtp_stop,
@@ -2541,6 +2703,34 @@ static struct ast_rtp_engine asterisk_rtp_engine = {
 };
 
 #if defined(HAVE_OPENSSL) && (OPENSSL_VERSION_NUMBER >= 0x10001000L) && !defined(OPENSSL_NO_SRTP)
+/*! DTLS handshake latency accounting reported by 'rtp show settings' */
+static int dtls_handshakes_completed;
+static int dtls_handshakes_resumed;
+static int dtls_handshake_total_ms;
+static int dtls_handshake_max_ms;
+
+/*! \pre instance is locked */
+static void dtls_handshake_record(struct ast_rtp_instance *instance, struct dtls_details *dtls, int resumed)
+{
+	int latency = ast_tvdiff_ms(ast_tvnow(), dtls->handshake_begin);
+
+	if (latency < 0) {
+		latency = 0;
+	}
+
+	ast_atomic_fetchadd_int(&dtls_handshakes_completed, +1);
+	ast_atomic_fetchadd_int(&dtls_handshake_total_ms, latency);
+	if (latency > dtls_handshake_max_ms) {
+		dtls_handshake_max_ms = latency;
+	}
+	if (resumed) {
+		ast_atomic_fetchadd_int(&dtls_handshakes_resumed, +1);
+	}
+
+	ast_debug_dtls(2, "(%p) DTLS handshake completed in %d ms%s\n",
+		instance, latency, resumed ? " (session resumed)" : "");
+}
+
 /*! \pre instance is locked */
 static void dtls_perform_handshake(struct ast_rtp_instance *instance, struct dtls_details *dtls, int rtcp)
 {
@@ -2557,6 +2747,7 @@ static void dtls_perform_handshake(struct ast_rtp_instance *instance, struct dtl
 		return;
 	}
 
+	dtls->handshake_begin = ast_tvnow();
 	SSL_do_handshake(dtls->ssl);
 
 	/*
@@ -2583,6 +2774,10 @@ static void dtls_perform_setup(struct dtls_details *dtls)
 		SSL_set_accept_state(dtls->ssl);
 	} else {
 		SSL_set_connect_state(dtls->ssl);
+		if (dtls->session) {
+			/* Offer the previously negotiated session for resumption */
+			SSL_set_session(dtls->ssl, dtls->session);
+		}
 	}
 	dtls->connection = AST_RTP_DTLS_CONNECTION_NEW;
 
@@ -3096,6 +3291,350 @@ static int rtcp_mux(struct ast_rtp *rtp, const unsigned char *packet)
 	return 0;
 }
 
+#ifdef HAVE_EPOLL
+/*!
+ * \page RtpReactor Shared RTP I/O reactor
+ *
+ * When rtpreactor is enabled in rtp.conf, a small set of epoll based
+ * threads services all registered RTP sockets.  An instance is handed to
+ * a reactor thread on its first read once it is associated with a
+ * channel; from then on the reactor drains its socket, runs the normal
+ * interpret path and queues the resulting frames straight onto the
+ * channel's read queue, so the channel's own thread no longer does the
+ * media syscall and demultiplexing work for it.  The channel keeps
+ * polling the socket as before; whichever side wins the instance lock
+ * reads the datagram and the other sees EAGAIN, which is harmless.
+ *
+ * Frames delivered this way bypass the channel technology's read
+ * callback, so driver level inspection such as fax tone detection does
+ * not see them.  The mode is therefore opt-in and intended for plain
+ * media passthrough deployments.
+ */
+
+#define RTP_REACTOR_MAX_THREADS 4
+#define RTP_REACTOR_MAX_EVENTS 32
+#define RTP_REACTOR_BUCKETS 563
+
+struct rtp_reactor_thread {
+	pthread_t thread;
+	int epfd;
+};
+
+/*! \brief A socket registered with a reactor thread */
+struct rtp_reactor_entry {
+	/*! The RTP socket; also the container key */
+	int fd;
+	/*! Which reactor thread owns the socket */
+	int reactor_idx;
+	/*! The owning instance.  The entry holds a reference, released when
+	 * ast_rtp_stop() unregisters the socket or the module unloads. */
+	struct ast_rtp_instance *instance;
+};
+
+static struct rtp_reactor_thread rtp_reactor_threads[RTP_REACTOR_MAX_THREADS];
+static int rtp_reactor_num_threads;
+static int rtp_reactor_rr;
+static int rtp_reactor_shutting_down;
+static int rtp_reactor_alert[2] = { -1, -1 };
+static struct ao2_container *rtp_reactor_entries;
+
+static void rtp_reactor_entry_destructor(void *obj)
+{
+	struct rtp_reactor_entry *entry = obj;
+
+	ao2_cleanup(entry->instance);
+}
+
+static int rtp_reactor_entry_hash(const void *obj, const int flags)
+{
+	return (flags & OBJ_KEY)
+		? *(const int *) obj : ((const struct rtp_reactor_entry *) obj)->fd;
+}
+
+static int rtp_reactor_entry_cmp(void *obj, void *arg, int flags)
+{
+	struct rtp_reactor_entry *entry = obj;
+	int fd = (flags & OBJ_KEY) ? *(int *) arg : ((struct rtp_reactor_entry *) arg)->fd;
+
+	return entry->fd == fd ? CMP_MATCH | CMP_STOP : 0;
+}
+
+/*! \brief Read a reactor owned socket and queue the frames to its channel */
+static void rtp_reactor_process(struct rtp_reactor_entry *entry)
+{
+	struct ast_channel *chan = NULL;
+	struct ast_frame *frame;
+	const char *channel_id;
+
+	channel_id = ast_rtp_instance_get_channel_id(entry->instance);
+	if (!ast_strlen_zero(channel_id)) {
+		chan = ast_channel_get_by_name(channel_id);
+	}
+
+	/* The socket must be drained even when there is no channel to queue
+	 * to, or the level triggered epoll would spin on the pending
+	 * datagram. */
+	frame = ast_rtp_instance_read(entry->instance, 0);
+	if (!frame) {
+		/* Fatal read error.  Let the channel deal with it. */
+		if (chan) {
+			ast_queue_hangup(chan);
+		}
+		ast_channel_cleanup(chan);
+		return;
+	}
+
+	while (frame) {
+		struct ast_frame *next = AST_LIST_NEXT(frame, frame_list);
+
+		AST_LIST_NEXT(frame, frame_list) = NULL;
+		if (chan && frame->frametype != AST_FRAME_NULL) {
+			ast_queue_frame(chan, frame);
+		}
+		ast_frfree(frame);
+		frame = next;
+	}
+
+	ast_channel_cleanup(chan);
+}
+
+static void *rtp_reactor_thread_loop(void *data)
+{
+	struct rtp_reactor_thread *reactor = data;
+	struct epoll_event events[RTP_REACTOR_MAX_EVENTS];
+	int num, idx;
+
+	while (!rtp_reactor_shutting_down) {
+		num = epoll_wait(reactor->epfd, events, ARRAY_LEN(events), -1);
+		if (num < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		for (idx = 0; idx < num; idx++) {
+			struct rtp_reactor_entry *entry;
+			int fd = events[idx].data.fd;
+
+			if (fd == rtp_reactor_alert[0]) {
+				/* Shutdown poke; the while condition handles it. */
+				continue;
+			}
+			entry = ao2_find(rtp_reactor_entries, &fd, OBJ_SEARCH_KEY);
+			if (!entry) {
+				/* Unregistered while the event was in flight. */
+				continue;
+			}
+			rtp_reactor_process(entry);
+			ao2_ref(entry, -1);
+		}
+	}
+
+	return NULL;
+}
+
+/*! \pre instance is locked */
+static void rtp_reactor_register(struct ast_rtp_instance *instance, struct ast_rtp *rtp)
+{
+	struct rtp_reactor_entry *entry;
+	struct epoll_event ev = { .events = EPOLLIN, };
+	int idx;
+
+	/* Only one attempt is made; on failure the channel simply keeps
+	 * servicing the socket itself. */
+	rtp->reactor_registered = 1;
+
+	entry = ao2_alloc_options(sizeof(*entry), rtp_reactor_entry_destructor,
+		AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!entry) {
+		return;
+	}
+	idx = ast_atomic_fetchadd_int(&rtp_reactor_rr, +1) % rtp_reactor_num_threads;
+	entry->fd = rtp->s;
+	entry->reactor_idx = idx;
+	entry->instance = ao2_bump(instance);
+	ao2_link(rtp_reactor_entries, entry);
+
+	ev.data.fd = rtp->s;
+	if (epoll_ctl(rtp_reactor_threads[idx].epfd, EPOLL_CTL_ADD, rtp->s, &ev)) {
+		ast_debug_rtp(1, "(%p) RTP failed to hand socket to reactor: %s\n",
+			instance, strerror(errno));
+		ao2_unlink(rtp_reactor_entries, entry);
+	}
+	ao2_ref(entry, -1);
+}
+
+/*! \pre instance is locked */
+static void rtp_reactor_unregister(struct ast_rtp *rtp)
+{
+	struct rtp_reactor_entry *entry;
+
+	if (!rtp->reactor_registered) {
+		return;
+	}
+	rtp->reactor_registered = 0;
+
+	if (!rtp_reactor_entries) {
+		return;
+	}
+	entry = ao2_find(rtp_reactor_entries, &rtp->s, OBJ_SEARCH_KEY | OBJ_UNLINK);
+	if (!entry) {
+		return;
+	}
+	epoll_ctl(rtp_reactor_threads[entry->reactor_idx].epfd, EPOLL_CTL_DEL,
+		entry->fd, NULL);
+	ao2_ref(entry, -1);
+}
+
+static void rtp_reactor_start(void)
+{
+	int idx, num;
+
+	if (rtp_reactor_num_threads || !rtpreactor) {
+		return;
+	}
+
+	num = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num > RTP_REACTOR_MAX_THREADS) {
+		num = RTP_REACTOR_MAX_THREADS;
+	} else if (num < 1) {
+		num = 1;
+	}
+
+	rtp_reactor_entries = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0,
+		RTP_REACTOR_BUCKETS, rtp_reactor_entry_hash, NULL, rtp_reactor_entry_cmp);
+	if (!rtp_reactor_entries) {
+		return;
+	}
+	if (ast_alertpipe_init(rtp_reactor_alert)) {
+		ao2_cleanup(rtp_reactor_entries);
+		rtp_reactor_entries = NULL;
+		return;
+	}
+
+	for (idx = 0; idx < num; idx++) {
+		struct rtp_reactor_thread *reactor = &rtp_reactor_threads[idx];
+		struct epoll_event ev = { .events = EPOLLIN, };
+
+		ev.data.fd = rtp_reactor_alert[0];
+		reactor->epfd = epoll_create1(0);
+		if (reactor->epfd < 0
+			|| epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, rtp_reactor_alert[0], &ev)
+			|| ast_pthread_create_background(&reactor->thread, NULL,
+				rtp_reactor_thread_loop, reactor)) {
+			if (reactor->epfd > -1) {
+				close(reactor->epfd);
+			}
+			break;
+		}
+		rtp_reactor_num_threads = idx + 1;
+	}
+
+	if (!rtp_reactor_num_threads) {
+		ast_log(LOG_WARNING, "Failed to start RTP reactor threads; falling back to per-channel polling\n");
+		ast_alertpipe_close(rtp_reactor_alert);
+		ao2_cleanup(rtp_reactor_entries);
+		rtp_reactor_entries = NULL;
+	} else {
+		ast_debug_rtp(1, "Started %d RTP reactor thread(s)\n", rtp_reactor_num_threads);
+	}
+}
+
+static void rtp_reactor_shutdown(void)
+{
+	int idx;
+
+	if (!rtp_reactor_num_threads) {
+		return;
+	}
+
+	rtp_reactor_shutting_down = 1;
+	ast_alertpipe_write(rtp_reactor_alert);
+	for (idx = 0; idx < rtp_reactor_num_threads; idx++) {
+		pthread_join(rtp_reactor_threads[idx].thread, NULL);
+		close(rtp_reactor_threads[idx].epfd);
+	}
+	rtp_reactor_num_threads = 0;
+	rtp_reactor_shutting_down = 0;
+	ast_alertpipe_close(rtp_reactor_alert);
+
+	/* Dropping the container releases all entries and their instance
+	 * references. */
+	ao2_cleanup(rtp_reactor_entries);
+	rtp_reactor_entries = NULL;
+}
+#endif	/* HAVE_EPOLL */
+
+/*!
+ * \internal
+ * \brief Receive one datagram for the session, draining the socket in batches.
+ *
+ * When batch receive is enabled, a single recvmmsg() syscall pulls up to
+ * RTP_RECV_BATCH_SIZE datagrams off the RTP socket.  The first is delivered
+ * into the caller's buffer right away and the rest are staged on the
+ * session, to be handed out by subsequent calls without touching the
+ * kernel.  RTCP and sessions without a staging area use plain recvfrom().
+ *
+ * \pre instance is locked
+ */
+static ssize_t rtp_socket_recvfrom(struct ast_rtp *rtp, int rtcp, void *buf, size_t size, int flags, struct ast_sockaddr *sa)
+{
+#ifdef HAVE_RECVMMSG
+	struct rtp_recv_batch *batch = rtp->recv_batch;
+
+	if (!rtcp && batch) {
+		struct mmsghdr msgs[RTP_RECV_BATCH_SIZE];
+		struct iovec iovs[RTP_RECV_BATCH_SIZE];
+		int i, n;
+
+		if (batch->next < batch->count) {
+			/* Hand out a previously staged datagram. */
+			i = batch->next++;
+			memcpy(buf, batch->slot[i], MIN(batch->len[i], size));
+			ast_sockaddr_copy(sa, &batch->addr[i]);
+			return batch->len[i];
+		}
+
+		memset(msgs, 0, sizeof(msgs));
+		iovs[0].iov_base = buf;
+		iovs[0].iov_len = size;
+		msgs[0].msg_hdr.msg_name = &sa->ss;
+		msgs[0].msg_hdr.msg_namelen = sizeof(sa->ss);
+		for (i = 1; i < RTP_RECV_BATCH_SIZE; i++) {
+			iovs[i].iov_base = batch->slot[i];
+			iovs[i].iov_len = sizeof(batch->slot[i]);
+			msgs[i].msg_hdr.msg_name = &batch->addr[i].ss;
+			msgs[i].msg_hdr.msg_namelen = sizeof(batch->addr[i].ss);
+		}
+		for (i = 0; i < RTP_RECV_BATCH_SIZE; i++) {
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		n = recvmmsg(rtp->s, msgs, RTP_RECV_BATCH_SIZE, 0, NULL);
+		if (n <= 0) {
+			return n ? -1 : 0;
+		}
+
+		for (i = 1; i < n; i++) {
+			if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				ast_debug_rtp(1, "RTP datagram of %u bytes truncated to staging slot size %d\n",
+					msgs[i].msg_len, RTP_RECV_BATCH_SLOT);
+				msgs[i].msg_len = RTP_RECV_BATCH_SLOT;
+			}
+			batch->len[i] = msgs[i].msg_len;
+			batch->addr[i].len = msgs[i].msg_hdr.msg_namelen;
+		}
+		batch->next = 1;
+		batch->count = n;
+
+		sa->len = msgs[0].msg_hdr.msg_namelen;
+		return msgs[0].msg_len;
+	}
+#endif
+	return ast_recvfrom(rtcp ? rtp->rtcp->s : rtp->s, buf, size, flags, sa);
+}
+
 /*! \pre instance is locked */
 static int __rtp_recvfrom(struct ast_rtp_instance *instance, void *buf, size_t size, int flags, struct ast_sockaddr *sa, int rtcp)
 {
@@ -3111,7 +3650,7 @@ static int __rtp_recvfrom(struct ast_rtp_instance *instance, void *buf, size_t s
 	struct ast_rtp_engine_test *test = ast_rtp_instance_get_test(instance);
 #endif
 
-	if ((len = ast_recvfrom(rtcp ? rtp->rtcp->s : rtp->s, buf, size, flags, sa)) < 0) {
+	if ((len = rtp_socket_recvfrom(rtp, rtcp, buf, size, flags, sa)) < 0) {
 		return len;
 	}
 
@@ -3157,6 +3696,11 @@ static int __rtp_recvfrom(struct ast_rtp_instance *instance, void *buf, size_t s
 			SSL_set_accept_state(dtls->ssl);
 		}
 
+		if (!SSL_is_init_finished(dtls->ssl) && ast_tvzero(dtls->handshake_begin)) {
+			/* As the passive side our handshake starts with the first packet */
+			dtls->handshake_begin = ast_tvnow();
+		}
+
 		BIO_write(dtls->read_bio, buf, len);
 
 		len = SSL_read(dtls->ssl, buf, len);
@@ -3169,6 +3713,15 @@ static int __rtp_recvfrom(struct ast_rtp_instance *instance, void *buf, size_t s
 		}
 
 		if (SSL_is_init_finished(dtls->ssl)) {
+			if (!ast_tvzero(dtls->handshake_begin)) {
+				dtls_handshake_record(instance, dtls, SSL_session_reused(dtls->ssl));
+				dtls->handshake_begin = ast_tv(0, 0);
+			}
+			/* Cache the established session so a re-setup can resume it */
+			if (dtls->session) {
+				SSL_SESSION_free(dtls->session);
+			}
+			dtls->session = SSL_get1_session(dtls->ssl);
 			/* Any further connections will be existing since this is now established */
 			dtls->connection = AST_RTP_DTLS_CONNECTION_EXISTING;
 			/* Use the keying material to set up key/salt information */
@@ -3260,7 +3813,7 @@ static int rtp_recvfrom(struct ast_rtp_instance *instance, void *buf, size_t siz
 }
 
 /*! \pre instance is locked */
-static int __rtp_sendto(struct ast_rtp_instance *instance, void *buf, size_t size, int flags, struct ast_sockaddr *sa, int rtcp, int *via_ice, int use_srtp)
+static int __rtp_sendto(struct ast_rtp_instance *instance, void *buf, size_t size, size_t avail, int flags, struct ast_sockaddr *sa, int rtcp, int *via_ice, int use_srtp)
 {
 	int len = size;
 	void *temp = buf;
@@ -3272,7 +3825,7 @@ static int __rtp_sendto(struct ast_rtp_instance *instance, void *buf, size_t siz
 
 	*via_ice = 0;
 
-	if (use_srtp && res_srtp && srtp && res_srtp->protect(srtp, &temp, &len, rtcp) < 0) {
+	if (use_srtp && res_srtp && srtp && res_srtp->protect(srtp, &temp, &len, rtcp, avail) < 0) {
 		return -1;
 	}
 
@@ -3316,26 +3869,209 @@ static int __rtp_sendto(struct ast_rtp_instance *instance, void *buf, size_t siz
 }
 
 /*! \pre instance is locked */
-static int rtcp_sendto(struct ast_rtp_instance *instance, void *buf, size_t size, int flags, struct ast_sockaddr *sa, int *ice)
+static int rtcp_sendto(struct ast_rtp_instance *instance, void *buf, size_t size, size_t avail, int flags, struct ast_sockaddr *sa, int *ice)
+{
+	return __rtp_sendto(instance, buf, size, avail, flags, sa, 1, ice, 1);
+}
+
+/*!
+ * \internal
+ * \brief Queue an outgoing RTP packet for the pacer thread.
+ *
+ * The packet is copied and sent by the pacer thread on a subsequent burst,
+ * so the caller sees it as sent.  When the instance transitions from having
+ * no queued packets it is placed on the pacer thread's list with a
+ * reference, which the pacer drops once it has drained the queue.
+ *
+ * \pre instance is locked
+ *
+ * \retval size on success (the packet was queued or intentionally dropped)
+ * \retval -1 on allocation failure
+ */
+static int rtp_pacer_enqueue(struct ast_rtp_instance *instance, struct ast_rtp *rtp,
+	const void *buf, size_t size, struct ast_sockaddr *sa)
 {
-	return __rtp_sendto(instance, buf, size, flags, sa, 1, ice, 1);
+	struct rtp_paced_packet *packet;
+
+	if (rtp->paced_count >= PACING_MAX_QUEUE) {
+		/* The instance is persistently over its pacing budget, shed the
+		 * newest packet rather than grow the queue (and latency) without
+		 * bound. */
+		ast_debug_rtp(1, "(%p) RTP pacer queue full, dropping outgoing packet\n", instance);
+		return size;
+	}
+
+	packet = ast_malloc(sizeof(*packet) + size);
+	if (!packet) {
+		return -1;
+	}
+	packet->len = size;
+	ast_sockaddr_copy(&packet->sa, sa);
+	memcpy(packet->data, buf, size);
+
+	AST_LIST_INSERT_TAIL(&rtp->paced_packets, packet, next);
+	rtp->paced_count++;
+
+	if (!rtp->paced_scheduled) {
+		struct rtp_pacer_entry *entry;
+
+		entry = ast_calloc(1, sizeof(*entry));
+		if (!entry) {
+			AST_LIST_REMOVE(&rtp->paced_packets, packet, next);
+			rtp->paced_count--;
+			ast_free(packet);
+			return -1;
+		}
+		entry->instance = ao2_bump(instance);
+		rtp->paced_scheduled = 1;
+
+		AST_LIST_LOCK(&rtp_pacer);
+		AST_LIST_INSERT_TAIL(&rtp_pacer, entry, next);
+		ast_cond_signal(&rtp_pacer_cond);
+		AST_LIST_UNLOCK(&rtp_pacer);
+	}
+
+	return size;
 }
 
 /*! \pre instance is locked */
-static int rtp_sendto(struct ast_rtp_instance *instance, void *buf, size_t size, int flags, struct ast_sockaddr *sa, int *ice)
+static int rtp_sendto(struct ast_rtp_instance *instance, void *buf, size_t size, size_t avail, int flags, struct ast_sockaddr *sa, int *ice)
 {
 	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
 	int hdrlen = 12;
 	int res;
 
-	if ((res = __rtp_sendto(instance, buf, size, flags, sa, 0, ice, 1)) > 0) {
+	if (pacing && rtp_pacer_thread != AST_PTHREADT_NULL) {
+		*ice = 0;
+		res = rtp_pacer_enqueue(instance, rtp, buf, size, sa);
+	} else {
+		res = __rtp_sendto(instance, buf, size, avail, flags, sa, 0, ice, 1);
+	}
+
+	if (res > 0) {
 		rtp->txcount++;
 		rtp->txoctetcount += (res - hdrlen);
+		if (!(rtp->txcount & 0x3f)) {
+			/* Refresh the lock-free statistics snapshot periodically so
+			 * packet counters do not grow stale between RTCP reports. */
+			rtp_stats_publish(instance, rtp);
+		}
 	}
 
 	return res;
 }
 
+/*!
+ * \internal
+ * \brief Send one pacing burst for every instance with queued packets.
+ *
+ * The pacer list is detached before any instance lock is taken so the
+ * enqueue path, which appends to the list while holding the instance lock,
+ * cannot deadlock against us.  Instances that still have packets queued
+ * after their burst are placed back on the list for the next tick.
+ */
+static void rtp_pacer_run_tick(void)
+{
+	struct rtp_pacer_entry *entry;
+	int burst = pacing_burst;
+	AST_LIST_HEAD_NOLOCK(, rtp_pacer_entry) ready = AST_LIST_HEAD_NOLOCK_INIT_VALUE;
+	AST_LIST_HEAD_NOLOCK(, rtp_pacer_entry) requeue = AST_LIST_HEAD_NOLOCK_INIT_VALUE;
+
+	AST_LIST_LOCK(&rtp_pacer);
+	AST_LIST_APPEND_LIST(&ready, &rtp_pacer, next);
+	AST_LIST_UNLOCK(&rtp_pacer);
+
+	while ((entry = AST_LIST_REMOVE_HEAD(&ready, next))) {
+		struct ast_rtp_instance *instance = entry->instance;
+		struct ast_rtp *rtp;
+		struct rtp_paced_packet *packet;
+		int sent = 0;
+
+		ao2_lock(instance);
+		rtp = ast_rtp_instance_get_data(instance);
+
+		while (sent < burst && (packet = AST_LIST_REMOVE_HEAD(&rtp->paced_packets, next))) {
+			int ice;
+
+			rtp->paced_count--;
+			if (__rtp_sendto(instance, packet->data, packet->len, 0, 0, &packet->sa, 0, &ice, 1) < 0) {
+				ast_debug_rtp(1, "(%p) RTP paced transmission error to %s: %s\n",
+					instance, ast_sockaddr_stringify(&packet->sa), strerror(errno));
+			}
+			ast_free(packet);
+			sent++;
+		}
+
+		if (AST_LIST_EMPTY(&rtp->paced_packets)) {
+			rtp->paced_scheduled = 0;
+			ao2_unlock(instance);
+			ast_free(entry);
+			ao2_ref(instance, -1);
+		} else {
+			ao2_unlock(instance);
+			AST_LIST_INSERT_TAIL(&requeue, entry, next);
+		}
+	}
+
+	if (!AST_LIST_EMPTY(&requeue)) {
+		AST_LIST_LOCK(&rtp_pacer);
+		AST_LIST_APPEND_LIST(&rtp_pacer, &requeue, next);
+		AST_LIST_UNLOCK(&rtp_pacer);
+	}
+}
+
+/*!
+ * \internal
+ * \brief Background thread pacing outbound RTP transmission.
+ *
+ * Sleeps until an instance queues a packet, then sends bursts on a timer
+ * tick (timerfd backed where available through the timing core) until all
+ * queues have drained.
+ */
+static void *rtp_pacer_thread_loop(void *data)
+{
+	struct ast_timer *timer;
+	int rate = 0;
+
+	timer = ast_timer_open();
+	if (!timer) {
+		ast_log(LOG_WARNING, "RTP pacer could not open a timer, falling back to sleeping between bursts\n");
+	}
+
+	for (;;) {
+		AST_LIST_LOCK(&rtp_pacer);
+		while (!rtp_pacer_shutdown && AST_LIST_EMPTY(&rtp_pacer)) {
+			ast_cond_wait(&rtp_pacer_cond, &rtp_pacer.lock);
+		}
+		if (rtp_pacer_shutdown) {
+			AST_LIST_UNLOCK(&rtp_pacer);
+			break;
+		}
+		AST_LIST_UNLOCK(&rtp_pacer);
+
+		if (timer) {
+			struct pollfd pfd = { .fd = ast_timer_fd(timer), .events = POLLIN, };
+
+			if (rate != 1000 / pacing_interval) {
+				rate = 1000 / pacing_interval;
+				ast_timer_set_rate(timer, rate);
+			}
+			if (ast_poll(&pfd, 1, pacing_interval * 2) > 0) {
+				ast_timer_ack(timer, 1);
+			}
+		} else {
+			usleep(pacing_interval * 1000);
+		}
+
+		rtp_pacer_run_tick();
+	}
+
+	if (timer) {
+		ast_timer_close(timer);
+	}
+	return NULL;
+}
+
 static unsigned int ast_rtcp_calc_interval(struct ast_rtp *rtp)
 {
 	unsigned int interval;
@@ -3469,6 +4205,8 @@ static void rtp_learning_start(struct ast_rtp *rtp)
 	rtp->strict_rtp_state = STRICT_RTP_LEARN;
 	memset(&rtp->rtp_source_learn.proposed_address, 0,
 		sizeof(rtp->rtp_source_learn.proposed_address));
+	memset(&rtp->rtp_source_learn.proposed_address_key, 0,
+		sizeof(rtp->rtp_source_learn.proposed_address_key));
 	rtp->rtp_source_learn.start = ast_tvnow();
 	rtp_learning_seq_init(&rtp->rtp_source_learn, (uint16_t) rtp->lastrxseqno);
 }
@@ -3489,45 +4227,294 @@ static void rtp_unload_acl(ast_rwlock_t *lock, struct ast_acl_list **acl)
 
 /*!
  * \internal
- * \brief Checks an address against the ICE blacklist
- * \note If there is no ice_blacklist list, always returns 0
- *
- * \param address The address to consider
- * \retval 0 if address is not ICE blacklisted
- * \retval 1 if address is ICE blacklisted
+ * \brief Checks an address against the ICE blacklist
+ * \note If there is no ice_blacklist list, always returns 0
+ *
+ * \param address The address to consider
+ * \retval 0 if address is not ICE blacklisted
+ * \retval 1 if address is ICE blacklisted
+ */
+static int rtp_address_is_ice_blacklisted(const struct ast_sockaddr *address)
+{
+	int result = 0;
+
+	ast_rwlock_rdlock(&ice_acl_lock);
+	result |= ast_apply_acl_nolog(ice_acl, address) == AST_SENSE_DENY;
+	ast_rwlock_unlock(&ice_acl_lock);
+
+	return result;
+}
+
+/*!
+ * \internal
+ * \brief Checks an address against the STUN blacklist
+ * \since 13.16.0
+ *
+ * \note If there is no stun_blacklist list, always returns 0
+ *
+ * \param addr The address to consider
+ *
+ * \retval 0 if address is not STUN blacklisted
+ * \retval 1 if address is STUN blacklisted
+ */
+static int stun_address_is_blacklisted(const struct ast_sockaddr *addr)
+{
+	int result = 0;
+
+	ast_rwlock_rdlock(&stun_acl_lock);
+	result |= ast_apply_acl_nolog(stun_acl, addr) == AST_SENSE_DENY;
+	ast_rwlock_unlock(&stun_acl_lock);
+
+	return result;
+}
+
+/*!
+ * \internal
+ * \brief Bind a socket pair and resolve its STUN mapped addresses for the pool.
+ *
+ * Runs in the pool maintenance thread so the blocking STUN round trips
+ * happen off the call setup path.
+ *
+ * \retval NULL when no STUN server is configured, no port pair could be
+ *         bound, or the STUN server did not answer.
+ */
+static struct ice_pooled_transport *ice_pool_gather(void)
+{
+	struct ice_pooled_transport *pooled;
+	struct sockaddr_in stun_server;
+	struct ast_sockaddr addr;
+	int x, startplace;
+
+	ast_rwlock_rdlock(&stunaddr_lock);
+	memcpy(&stun_server, &stunaddr, sizeof(stun_server));
+	ast_rwlock_unlock(&stunaddr_lock);
+
+	if (!stun_server.sin_addr.s_addr) {
+		/* Nothing to pre-gather without a STUN server */
+		return NULL;
+	}
+
+	pooled = ast_calloc(1, sizeof(*pooled));
+	if (!pooled) {
+		return NULL;
+	}
+	pooled->rtp_sock = -1;
+	pooled->rtcp_sock = -1;
+
+	ast_sockaddr_parse(&addr, "0.0.0.0", PARSE_PORT_FORBID);
+
+	x = (ast_random() % (rtpend - rtpstart)) + rtpstart;
+	x = x & ~1;
+	startplace = x;
+
+	for (;;) {
+		if ((pooled->rtp_sock = create_new_socket("RTP", AF_INET)) < 0
+			|| (pooled->rtcp_sock = create_new_socket("RTCP", AF_INET)) < 0) {
+			break;
+		}
+
+		ast_sockaddr_set_port(&addr, x);
+		if (!ast_bind(pooled->rtp_sock, &addr)) {
+			ast_sockaddr_set_port(&addr, x + 1);
+			if (!ast_bind(pooled->rtcp_sock, &addr)) {
+				pooled->port = x;
+				break;
+			}
+		}
+
+		/* The RTP socket may have been bound already so both sockets have
+		 * to be recreated before trying the next pair. */
+		close(pooled->rtp_sock);
+		close(pooled->rtcp_sock);
+		pooled->rtp_sock = -1;
+		pooled->rtcp_sock = -1;
+
+		if (errno != EADDRINUSE && errno != EACCES) {
+			break;
+		}
+
+		x += 2;
+		if (x > rtpend) {
+			x = (rtpstart + 1) & ~1;
+		}
+		if (x == startplace) {
+			break;
+		}
+	}
+
+	if (pooled->rtp_sock < 0 || pooled->rtcp_sock < 0
+		|| ast_stun_request(pooled->rtp_sock, &stun_server, NULL, &pooled->stun_rtp)
+		|| ast_stun_request(pooled->rtcp_sock, &stun_server, NULL, &pooled->stun_rtcp)) {
+		if (pooled->rtp_sock > -1) {
+			close(pooled->rtp_sock);
+		}
+		if (pooled->rtcp_sock > -1) {
+			close(pooled->rtcp_sock);
+		}
+		ast_free(pooled);
+		return NULL;
+	}
+
+	pooled->stun_server = stun_server;
+	pooled->gathered = ast_tvnow();
+
+	ast_debug_category(3, AST_DEBUG_CATEGORY_ICE | AST_DEBUG_CATEGORY_STUN,
+		"ICE pool pre-gathered ports %d/%d\n", pooled->port, pooled->port + 1);
+
+	return pooled;
+}
+
+/*!
+ * \internal
+ * \brief Close and free all pooled transports.
+ */
+static void ice_pool_flush(void)
+{
+	struct ice_pooled_transport *pooled;
+
+	AST_LIST_LOCK(&ice_pool);
+	while ((pooled = AST_LIST_REMOVE_HEAD(&ice_pool, next))) {
+		close(pooled->rtp_sock);
+		close(pooled->rtcp_sock);
+		ast_free(pooled);
+		ice_pool_count--;
+	}
+	AST_LIST_UNLOCK(&ice_pool);
+}
+
+/*!
+ * \internal
+ * \brief Keep the NAT mappings of pooled transports alive.
+ *
+ * Most passes only batch out STUN binding indications, one fire and
+ * forget datagram per pooled socket, so keeping even a large pool warm
+ * costs a burst of sends from this one thread rather than a blocking
+ * round trip per transport.  A full blocking re-resolution of the
+ * mapped addresses happens only every ICE_POOL_VALIDATE_INTERVAL, when
+ * the STUN server changed, or when a keepalive send fails.  Entries the
+ * server no longer answers for are dropped and replaced by the
+ * maintenance thread.
+ */
+static void ice_pool_refresh(void)
+{
+	AST_LIST_HEAD_NOLOCK(, ice_pooled_transport) stale = AST_LIST_HEAD_NOLOCK_INIT_VALUE;
+	struct ice_pooled_transport *pooled;
+	struct sockaddr_in stun_server;
+	struct timeval now = ast_tvnow();
+
+	ast_rwlock_rdlock(&stunaddr_lock);
+	memcpy(&stun_server, &stunaddr, sizeof(stun_server));
+	ast_rwlock_unlock(&stunaddr_lock);
+
+	if (!stun_server.sin_addr.s_addr) {
+		return;
+	}
+
+	AST_LIST_LOCK(&ice_pool);
+	AST_LIST_TRAVERSE_SAFE_BEGIN(&ice_pool, pooled, next) {
+		if (ast_tvdiff_ms(now, pooled->gathered) < ICE_POOL_VALIDATE_INTERVAL * 1000
+			&& stun_server.sin_addr.s_addr == pooled->stun_server.sin_addr.s_addr
+			&& stun_server.sin_port == pooled->stun_server.sin_port
+			&& !ast_stun_send_indication(pooled->rtp_sock, &stun_server)
+			&& !ast_stun_send_indication(pooled->rtcp_sock, &stun_server)) {
+			/* The indications refreshed the NAT bindings; the mapped
+			 * addresses are still considered valid. */
+			continue;
+		}
+		AST_LIST_REMOVE_CURRENT(next);
+		ice_pool_count--;
+		AST_LIST_INSERT_TAIL(&stale, pooled, next);
+	}
+	AST_LIST_TRAVERSE_SAFE_END;
+	AST_LIST_UNLOCK(&ice_pool);
+
+	while ((pooled = AST_LIST_REMOVE_HEAD(&stale, next))) {
+		if (ast_stun_request(pooled->rtp_sock, &stun_server, NULL, &pooled->stun_rtp)
+			|| ast_stun_request(pooled->rtcp_sock, &stun_server, NULL, &pooled->stun_rtcp)) {
+			close(pooled->rtp_sock);
+			close(pooled->rtcp_sock);
+			ast_free(pooled);
+			continue;
+		}
+		pooled->stun_server = stun_server;
+		pooled->gathered = ast_tvnow();
+
+		AST_LIST_LOCK(&ice_pool);
+		AST_LIST_INSERT_TAIL(&ice_pool, pooled, next);
+		ice_pool_count++;
+		AST_LIST_UNLOCK(&ice_pool);
+	}
+}
+
+/*!
+ * \internal
+ * \brief Pool maintenance thread keeping ice_pool_size transports pre-gathered.
  */
-static int rtp_address_is_ice_blacklisted(const struct ast_sockaddr *address)
+static void *ice_pool_thread_loop(void *data)
 {
-	int result = 0;
+	for (;;) {
+		struct ice_pooled_transport *pooled = NULL;
+		int gather;
 
-	ast_rwlock_rdlock(&ice_acl_lock);
-	result |= ast_apply_acl_nolog(ice_acl, address) == AST_SENSE_DENY;
-	ast_rwlock_unlock(&ice_acl_lock);
+		AST_LIST_LOCK(&ice_pool);
+		gather = !ice_pool_shutdown && ice_pool_count < ice_pool_size;
+		AST_LIST_UNLOCK(&ice_pool);
 
-	return result;
+		if (gather) {
+			pooled = ice_pool_gather();
+		}
+
+		AST_LIST_LOCK(&ice_pool);
+		if (pooled) {
+			AST_LIST_INSERT_TAIL(&ice_pool, pooled, next);
+			ice_pool_count++;
+		}
+		if (!ice_pool_shutdown && (!gather || !pooled)) {
+			/* The pool is full or gathering is not possible right now.
+			 * The timeout doubles as the mapping refresh interval. */
+			struct timeval wait = ast_tvadd(ast_tvnow(), ast_tv(ICE_POOL_REFRESH_INTERVAL, 0));
+			struct timespec ts = { .tv_sec = wait.tv_sec, .tv_nsec = wait.tv_usec * 1000, };
+
+			ast_cond_timedwait(&ice_pool_cond, &ice_pool.lock, &ts);
+		}
+		if (ice_pool_shutdown) {
+			AST_LIST_UNLOCK(&ice_pool);
+			break;
+		}
+		AST_LIST_UNLOCK(&ice_pool);
+
+		ice_pool_refresh();
+	}
+
+	return NULL;
 }
 
 /*!
  * \internal
- * \brief Checks an address against the STUN blacklist
- * \since 13.16.0
- *
- * \note If there is no stun_blacklist list, always returns 0
- *
- * \param addr The address to consider
+ * \brief Draw a pre-gathered transport matching the requested binding.
  *
- * \retval 0 if address is not STUN blacklisted
- * \retval 1 if address is STUN blacklisted
+ * Only instances binding to the IPv4 any address can use pooled
+ * transports since that is what the pool pre-binds.
  */
-static int stun_address_is_blacklisted(const struct ast_sockaddr *addr)
+static struct ice_pooled_transport *ice_pool_draw(const struct ast_sockaddr *bind_address)
 {
-	int result = 0;
+	struct ice_pooled_transport *pooled;
 
-	ast_rwlock_rdlock(&stun_acl_lock);
-	result |= ast_apply_acl_nolog(stun_acl, addr) == AST_SENSE_DENY;
-	ast_rwlock_unlock(&stun_acl_lock);
+	if (!ice_pool_size
+		|| !ast_sockaddr_is_ipv4(bind_address)
+		|| !ast_sockaddr_is_any(bind_address)) {
+		return NULL;
+	}
 
-	return result;
+	AST_LIST_LOCK(&ice_pool);
+	pooled = AST_LIST_REMOVE_HEAD(&ice_pool, next);
+	if (pooled) {
+		ice_pool_count--;
+		ast_cond_signal(&ice_pool_cond);
+	}
+	AST_LIST_UNLOCK(&ice_pool);
+
+	return pooled;
 }
 
 /*! \pre instance is locked */
@@ -3666,14 +4653,27 @@ static void rtp_add_candidates_to_ice(struct ast_rtp_instance *instance, struct
 			transport == AST_TRANSPORT_UDP ? "UDP" : "TCP",
 			component == AST_RTP_ICE_COMPONENT_RTP ? "RTP" : "RTCP");
 
-		/*
-		 * The instance should not be locked because we can block
-		 * waiting for a STUN respone.
-		 */
-		ao2_unlock(instance);
-		rsp = ast_stun_request(component == AST_RTP_ICE_COMPONENT_RTCP
-			? rtp->rtcp->s : rtp->s, &stunaddr_copy, NULL, &answer);
-		ao2_lock(instance);
+		if ((component == AST_RTP_ICE_COMPONENT_RTCP
+				? rtp->pool_stun_rtcp_valid : rtp->pool_stun_rtp_valid)
+			&& stunaddr_copy.sin_addr.s_addr == rtp->pool_stun_server.sin_addr.s_addr
+			&& stunaddr_copy.sin_port == rtp->pool_stun_server.sin_port) {
+			/* The mapped address was pre-gathered while the transport sat
+			 * in the pool so no blocking request is needed. */
+			answer = component == AST_RTP_ICE_COMPONENT_RTCP
+				? rtp->pool_stun_rtcp : rtp->pool_stun_rtp;
+			rsp = 0;
+			ast_debug_category(3, AST_DEBUG_CATEGORY_ICE | AST_DEBUG_CATEGORY_STUN,
+				"(%p) ICE using pre-gathered STUN candidate\n", instance);
+		} else {
+			/*
+			 * The instance should not be locked because we can block
+			 * waiting for a STUN respone.
+			 */
+			ao2_unlock(instance);
+			rsp = ast_stun_request(component == AST_RTP_ICE_COMPONENT_RTCP
+				? rtp->rtcp->s : rtp->s, &stunaddr_copy, NULL, &answer);
+			ao2_lock(instance);
+		}
 		if (!rsp) {
 			struct ast_rtp_engine_ice_candidate *candidate;
 			pj_sockaddr ext, base;
@@ -3848,6 +4848,35 @@ static int rtp_allocate_transport(struct ast_rtp_instance *instance, struct ast_
 
 	rtp->strict_rtp_state = (strictrtp ? STRICT_RTP_CLOSED : STRICT_RTP_OPEN);
 
+#ifdef HAVE_PJPROJECT
+	rtp->pool_rtcp_sock = -1;
+	rtp->pool_stun_rtp_valid = 0;
+	rtp->pool_stun_rtcp_valid = 0;
+
+	/* A pre-gathered transport saves both the bind scan and the blocking
+	 * STUN round trips during ICE candidate gathering. */
+	{
+		struct ice_pooled_transport *pooled = ice_pool_draw(&rtp->bind_address);
+
+		if (pooled) {
+			rtp->s = pooled->rtp_sock;
+			rtp->pool_rtcp_sock = pooled->rtcp_sock;
+			rtp->pool_stun_server = pooled->stun_server;
+			rtp->pool_stun_rtp = pooled->stun_rtp;
+			rtp->pool_stun_rtcp = pooled->stun_rtcp;
+			rtp->pool_stun_rtp_valid = 1;
+			x = pooled->port;
+			ast_free(pooled);
+
+			ast_sockaddr_set_port(&rtp->bind_address, x);
+			ast_debug_rtp(1, "(%p) RTP allocated pre-gathered port %d\n", instance, x);
+			ast_rtp_instance_set_local_address(instance, &rtp->bind_address);
+			ast_test_suite_event_notify("RTP_PORT_ALLOCATED", "Port: %d", x);
+			goto transport_bound;
+		}
+	}
+#endif
+
 	/* Create a new socket for us to listen on and use */
 	if ((rtp->s =
 	     create_new_socket("RTP",
@@ -3889,6 +4918,10 @@ static int rtp_allocate_transport(struct ast_rtp_instance *instance, struct ast_
 		}
 	}
 
+#ifdef HAVE_PJPROJECT
+transport_bound:
+#endif
+
 #ifdef HAVE_PJPROJECT
 	/* Initialize synchronization aspects */
 	ast_cond_init(&rtp->cond, NULL);
@@ -3945,6 +4978,12 @@ static void rtp_deallocate_transport(struct ast_rtp_instance *instance, struct a
 	}
 
 #ifdef HAVE_PJPROJECT
+	/* Close a pooled RTCP socket that never got adopted */
+	if (rtp->pool_rtcp_sock > -1) {
+		close(rtp->pool_rtcp_sock);
+		rtp->pool_rtcp_sock = -1;
+	}
+
 	pj_thread_register_check();
 
 	/*
@@ -4055,6 +5094,13 @@ static int ast_rtp_new(struct ast_rtp_instance *instance,
 	rtp->lasttxformat = ao2_bump(ast_format_none);
 	rtp->stream_num = -1;
 
+#ifdef HAVE_RECVMMSG
+	if (batchreceive) {
+		/* If this fails the instance simply receives one datagram at a time. */
+		rtp->recv_batch = ast_calloc(1, sizeof(*rtp->recv_batch));
+	}
+#endif
+
 	return 0;
 }
 
@@ -4069,10 +5115,51 @@ static int ast_rtp_new(struct ast_rtp_instance *instance,
  */
 #define SSRC_MAPPING_ELEM_CMP(elem, value) ((elem).instance == (value))
 
+/*!
+ * \internal
+ * \brief Rebuild the open-addressing SSRC demultiplexing hash from the mapping vector.
+ *
+ * The mapping vector only changes on control paths (bundling, unbundling, or
+ * learning the remote SSRC of a bundled stream) so a full rebuild on each
+ * mutation keeps the per-packet lookup trivial.  If there are more mappings
+ * than the hash can index with a guaranteed free slot to terminate probing
+ * then the hash is marked full and lookups fall back to the linear scan.
+ *
+ * \pre The instance owning rtp is locked
+ */
+static void rtp_ssrc_mapping_hash_rebuild(struct ast_rtp *rtp)
+{
+	int index;
+
+	memset(rtp->ssrc_hash, 0, sizeof(rtp->ssrc_hash));
+	rtp->ssrc_hash_full = 0;
+
+	if (AST_VECTOR_SIZE(&rtp->ssrc_mapping) > SSRC_MAPPING_HASH_LIMIT) {
+		rtp->ssrc_hash_full = 1;
+		return;
+	}
+
+	for (index = 0; index < AST_VECTOR_SIZE(&rtp->ssrc_mapping); ++index) {
+		struct rtp_ssrc_mapping *mapping = AST_VECTOR_GET_ADDR(&rtp->ssrc_mapping, index);
+		unsigned int slot;
+
+		if (!mapping->ssrc_valid) {
+			continue;
+		}
+
+		slot = SSRC_MAPPING_HASH(mapping->ssrc);
+		while (rtp->ssrc_hash[slot].ssrc_valid) {
+			slot = (slot + 1) & (SSRC_MAPPING_HASH_SIZE - 1);
+		}
+		rtp->ssrc_hash[slot] = *mapping;
+	}
+}
+
 /*! \pre instance is locked */
 static int ast_rtp_destroy(struct ast_rtp_instance *instance)
 {
 	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
+	struct rtp_paced_packet *paced_packet;
 
 	if (rtp->bundled) {
 		struct ast_rtp *bundled_rtp;
@@ -4083,12 +5170,18 @@ static int ast_rtp_destroy(struct ast_rtp_instance *instance)
 		ao2_lock(rtp->bundled);
 		bundled_rtp = ast_rtp_instance_get_data(rtp->bundled);
 		AST_VECTOR_REMOVE_CMP_UNORDERED(&bundled_rtp->ssrc_mapping, instance, SSRC_MAPPING_ELEM_CMP, AST_VECTOR_ELEM_CLEANUP_NOOP);
+		rtp_ssrc_mapping_hash_rebuild(bundled_rtp);
 		ao2_unlock(rtp->bundled);
 
 		ao2_lock(instance);
 		ao2_ref(rtp->bundled, -1);
 	}
 
+#ifdef HAVE_EPOLL
+	/* Normally already done by ast_rtp_stop(). */
+	rtp_reactor_unregister(rtp);
+#endif
+
 	rtp_deallocate_transport(instance, rtp);
 
 	/* Destroy the smoother that was smoothing out audio if present */
@@ -4126,6 +5219,17 @@ static int ast_rtp_destroy(struct ast_rtp_instance *instance)
 		ast_data_buffer_free(rtp->recv_buffer);
 	}
 
+	/* Toss any packets still waiting on the pacer.  The pacer thread holds a
+	 * reference while the instance is on its list, so nothing can be queued
+	 * for transmission at this point. */
+	while ((paced_packet = AST_LIST_REMOVE_HEAD(&rtp->paced_packets, next))) {
+		ast_free(paced_packet);
+	}
+
+#ifdef HAVE_RECVMMSG
+	ast_free(rtp->recv_batch);
+#endif
+
 	AST_VECTOR_FREE(&rtp->transport_wide_cc.packet_statistics);
 
 	ao2_cleanup(rtp->lasttxformat);
@@ -4205,7 +5309,7 @@ static int ast_rtp_dtmf_begin(struct ast_rtp_instance *instance, char digit)
 		int ice;
 
 		rtpheader[3] = htonl((digit << 24) | (0xa << 16) | (rtp->send_duration));
-		res = rtp_sendto(instance, (void *) rtpheader, hdrlen + 4, 0, &remote_address, &ice);
+		res = rtp_sendto(instance, (void *) rtpheader, hdrlen + 4, sizeof(data), 0, &remote_address, &ice);
 		if (res < 0) {
 			ast_log(LOG_ERROR, "RTP Transmission error to %s: %s\n",
 				ast_sockaddr_stringify(&remote_address),
@@ -4254,7 +5358,7 @@ static int ast_rtp_dtmf_continuation(struct ast_rtp_instance *instance)
 	rtpheader[3] = htonl((rtp->send_digit << 24) | (0xa << 16) | (rtp->send_duration));
 
 	/* Boom, send it on out */
-	res = rtp_sendto(instance, (void *) rtpheader, hdrlen + 4, 0, &remote_address, &ice);
+	res = rtp_sendto(instance, (void *) rtpheader, hdrlen + 4, sizeof(data), 0, &remote_address, &ice);
 	if (res < 0) {
 		ast_log(LOG_ERROR, "RTP Transmission error to %s: %s\n",
 			ast_sockaddr_stringify(&remote_address),
@@ -4329,7 +5433,7 @@ static int ast_rtp_dtmf_end_with_duration(struct ast_rtp_instance *instance, cha
 
 		rtpheader[0] = htonl((2 << 30) | (rtp->send_payload << 16) | (rtp->seqno));
 
-		res = rtp_sendto(instance, (void *) rtpheader, hdrlen + 4, 0, &remote_address, &ice);
+		res = rtp_sendto(instance, (void *) rtpheader, hdrlen + 4, sizeof(data), 0, &remote_address, &ice);
 
 		if (res < 0) {
 			ast_log(LOG_ERROR, "RTP Transmission error to %s: %s\n",
@@ -4663,6 +5767,8 @@ static int ast_rtcp_calculate_sr_rr_statistics(struct ast_rtp_instance *instance
 	ast_rtp_publish_rtcp_message(instance, ast_rtp_rtcp_sent_type(),
 			rtcp_report, message_blob);
 
+	rtp_stats_publish(instance, rtp);
+
 	return 1;
 }
 
@@ -4876,7 +5982,7 @@ static int ast_rtcp_write(const void *data)
 		ast_sockaddr_copy(&remote_address, &rtp->rtcp->them);
 	}
 
-	res = rtcp_sendto(instance, (unsigned int *)rtcpheader, packet_len, 0, &remote_address, &ice);
+	res = rtcp_sendto(instance, (unsigned int *)rtcpheader, packet_len, sizeof(bdata), 0, &remote_address, &ice);
 	if (res < 0) {
 		ast_log(LOG_ERROR, "RTCP %s transmission error to %s, rtcp halted %s\n",
 				sr ? "SR" : "RR",
@@ -5100,7 +6206,7 @@ static int rtp_raw_write(struct ast_rtp_instance *instance, struct ast_frame *fr
 			}
 		}
 
-		res = rtp_sendto(instance, (void *)rtpheader, packet_len, 0, &remote_address, &ice);
+		res = rtp_sendto(instance, (void *)rtpheader, packet_len, 0, 0, &remote_address, &ice);
 		if (res < 0) {
 			if (!ast_rtp_instance_get_prop(instance, AST_RTP_PROPERTY_NAT) || (ast_rtp_instance_get_prop(instance, AST_RTP_PROPERTY_NAT) && (ast_test_flag(rtp, FLAG_NAT_ACTIVE) == FLAG_NAT_ACTIVE))) {
 				ast_debug_rtp(1, "(%p) RTP transmission error of packet %d to %s: %s\n",
@@ -5237,7 +6343,7 @@ static void rtp_write_rtcp_fir(struct ast_rtp_instance *instance, struct ast_rtp
 	put_unaligned_uint32(rtcpheader + packet_len + 8, htonl(rtp->themssrc));
 	put_unaligned_uint32(rtcpheader + packet_len + 12, htonl(rtp->themssrc)); /* FCI: SSRC */
 	put_unaligned_uint32(rtcpheader + packet_len + 16, htonl(rtp->rtcp->firseq << 24)); /* FCI: Sequence number */
-	res = rtcp_sendto(instance, (unsigned int *)rtcpheader, packet_len + fir_len, 0, rtp->bundled ? remote_address : &rtp->rtcp->them, &ice);
+	res = rtcp_sendto(instance, (unsigned int *)rtcpheader, packet_len + fir_len, sizeof(bdata), 0, rtp->bundled ? remote_address : &rtp->rtcp->them, &ice);
 	if (res < 0) {
 		ast_log(LOG_ERROR, "RTCP FIR transmission error: %s\n", strerror(errno));
 	} else {
@@ -5303,7 +6409,7 @@ static void rtp_write_rtcp_psfb(struct ast_rtp_instance *instance, struct ast_rt
 	put_unaligned_uint32(rtcpheader + packet_len + 12, htonl(('R' << 24) | ('E' << 16) | ('M' << 8) | ('B'))); /* Unique identifier 'R' 'E' 'M' 'B' */
 	put_unaligned_uint32(rtcpheader + packet_len + 16, htonl((1 << 24) | (feedback->remb.br_exp << 18) | (feedback->remb.br_mantissa))); /* Number of SSRCs / BR Exp / BR Mantissa */
 	put_unaligned_uint32(rtcpheader + packet_len + 20, htonl(rtp->ssrc)); /* The SSRC this feedback message applies to */
-	res = rtcp_sendto(instance, (unsigned int *)rtcpheader, packet_len + remb_len, 0, rtp->bundled ? remote_address : &rtp->rtcp->them, &ice);
+	res = rtcp_sendto(instance, (unsigned int *)rtcpheader, packet_len + remb_len, sizeof(bdata), 0, rtp->bundled ? remote_address : &rtp->rtcp->them, &ice);
 	if (res < 0) {
 		ast_log(LOG_ERROR, "RTCP PSFB transmission error: %s\n", strerror(errno));
 	} else {
@@ -5314,7 +6420,7 @@ static void rtp_write_rtcp_psfb(struct ast_rtp_instance *instance, struct ast_rt
 }
 
 /*! \pre instance is locked */
-static int ast_rtp_write(struct ast_rtp_instance *instance, struct ast_frame *frame)
+static int rtp_write_frame(struct ast_rtp_instance *instance, struct ast_frame *frame)
 {
 	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
 	struct ast_sockaddr remote_address = { {0,} };
@@ -5438,6 +6544,17 @@ static int ast_rtp_write(struct ast_rtp_instance *instance, struct ast_frame *fr
 	return 0;
 }
 
+/*! \pre instance is locked */
+static int ast_rtp_write(struct ast_rtp_instance *instance, struct ast_frame *frame)
+{
+	int res;
+	struct timeval trace_start = ast_latency_trace_start();
+
+	res = rtp_write_frame(instance, frame);
+	ast_latency_trace_end(AST_LATENCY_STAGE_RTP_WRITE, &trace_start);
+	return res;
+}
+
 static void calc_rxstamp(struct timeval *tv, struct ast_rtp *rtp, unsigned int timestamp, int mark)
 {
 	struct timeval now;
@@ -5904,13 +7021,27 @@ static struct ast_rtp_instance *__rtp_find_instance_by_ssrc(struct ast_rtp_insta
 		return instance;
 	}
 
-	/* Find the bundled child instance */
-	for (index = 0; index < AST_VECTOR_SIZE(&rtp->ssrc_mapping); ++index) {
-		struct rtp_ssrc_mapping *mapping = AST_VECTOR_GET_ADDR(&rtp->ssrc_mapping, index);
-		unsigned int mapping_ssrc = source ? ast_rtp_get_ssrc(mapping->instance) : mapping->ssrc;
+	if (!source && !rtp->ssrc_hash_full) {
+		/* Received SSRCs are indexed by the demultiplexing hash so each
+		 * packet probes a couple of slots instead of scanning the vector. */
+		unsigned int slot = SSRC_MAPPING_HASH(ssrc);
 
-		if (mapping->ssrc_valid && mapping_ssrc == ssrc) {
-			return mapping->instance;
+		while (rtp->ssrc_hash[slot].ssrc_valid) {
+			if (rtp->ssrc_hash[slot].ssrc == ssrc) {
+				return rtp->ssrc_hash[slot].instance;
+			}
+			slot = (slot + 1) & (SSRC_MAPPING_HASH_SIZE - 1);
+		}
+	} else {
+		/* Media source SSRCs are queried from each child instance so they
+		 * can't be indexed, find the bundled child instance by scanning */
+		for (index = 0; index < AST_VECTOR_SIZE(&rtp->ssrc_mapping); ++index) {
+			struct rtp_ssrc_mapping *mapping = AST_VECTOR_GET_ADDR(&rtp->ssrc_mapping, index);
+			unsigned int mapping_ssrc = source ? ast_rtp_get_ssrc(mapping->instance) : mapping->ssrc;
+
+			if (mapping->ssrc_valid && mapping_ssrc == ssrc) {
+				return mapping->instance;
+			}
 		}
 	}
 
@@ -6035,7 +7166,7 @@ static int ast_rtp_rtcp_handle_nack(struct ast_rtp_instance *instance, unsigned
 				 */
 				put_unaligned_time24(payload->buf + 17, now_msw, now_lsw);
 			}
-			res += rtp_sendto(instance, payload->buf, payload->size, 0, &remote_address, &ice);
+			res += rtp_sendto(instance, payload->buf, payload->size, 0, 0, &remote_address, &ice);
 		} else {
 			ast_debug_rtcp(1, "(%p) RTCP received NACK request for RTP packet with seqno %d, "
 				"but we don't have it\n", instance, pid);
@@ -6058,7 +7189,7 @@ static int ast_rtp_rtcp_handle_nack(struct ast_rtp_instance *instance, unsigned
 					if (abs_send_time_id != -1) {
 						put_unaligned_time24(payload->buf + 17, now_msw, now_lsw);
 					}
-					res += rtp_sendto(instance, payload->buf, payload->size, 0, &remote_address, &ice);
+					res += rtp_sendto(instance, payload->buf, payload->size, 0, 0, &remote_address, &ice);
 				} else {
 					ast_debug_rtcp(1, "(%p) RTCP remote end also requested RTP packet with seqno %d, "
 						"but we don't have it\n", instance, seqno);
@@ -6606,6 +7737,10 @@ static struct ast_frame *ast_rtcp_interpret(struct ast_rtp_instance *instance, s
 		position += length;
 		rtp->rtcp->rtcp_info = 1;
 
+		/* Remote report data has been folded in, so refresh the lock-free
+		 * statistics snapshot of whichever instance this record targeted. */
+		rtp_stats_publish(instance, rtp);
+
 		if (child) {
 			ao2_unlock(child);
 		}
@@ -6675,7 +7810,8 @@ static struct ast_frame *ast_rtcp_read(struct ast_rtp_instance *instance)
 
 /*! \pre instance is locked */
 static int bridge_p2p_rtp_write(struct ast_rtp_instance *instance,
-	struct ast_rtp_instance *instance1, unsigned int *rtpheader, int len, int hdrlen)
+	struct ast_rtp_instance *instance1, unsigned int *rtpheader, int len, int hdrlen,
+	size_t avail)
 {
 	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
 	struct ast_rtp *bridged;
@@ -6711,6 +7847,20 @@ static int bridge_p2p_rtp_write(struct ast_rtp_instance *instance,
 		return -1;
 	}
 
+	/*
+	 * When something in the bridge needs to see telephone events (such as
+	 * an active DTMF feature hook) they cannot simply be passed along at
+	 * the packet level.  Feed them to the core and keep only audio on the
+	 * fast path.
+	 */
+	if (!payload_type->asterisk_format
+		&& (payload_type->rtp_code == AST_RTP_DTMF
+			|| payload_type->rtp_code == AST_RTP_CISCO_DTMF)
+		&& ast_rtp_instance_get_prop(instance, AST_RTP_PROPERTY_DTMF_TO_CORE)) {
+		ast_debug_rtp(1, "(%p, %p) RTP feeding telephone event packet to core\n", instance, instance1);
+		return -1;
+	}
+
 	/*
 	 * Even if we are no longer in dtmf, we could still be receiving
 	 * re-transmissions of the last dtmf end still.  Feed those to the
@@ -6808,7 +7958,7 @@ static int bridge_p2p_rtp_write(struct ast_rtp_instance *instance,
 	}
 
 	/* Send the packet back out */
-	res = rtp_sendto(instance1, (void *)rtpheader, len, 0, &remote_address, &ice);
+	res = rtp_sendto(instance1, (void *)rtpheader, len, avail, 0, &remote_address, &ice);
 	if (res < 0) {
 		if (!ast_rtp_instance_get_prop(instance1, AST_RTP_PROPERTY_NAT) || (ast_rtp_instance_get_prop(instance1, AST_RTP_PROPERTY_NAT) && (ast_test_flag(bridged, FLAG_NAT_ACTIVE) == FLAG_NAT_ACTIVE))) {
 			ast_log(LOG_WARNING,
@@ -7097,7 +8247,7 @@ static int rtp_transport_wide_cc_feedback_produce(const void *data)
 	ast_debug_rtcp(2, "(%p) RTCP sending transport-cc feedback packet of size '%d' on '%s' with packet count of %d (small = %d, large = %d, lost = %d)\n",
 		instance, packet_len, ast_rtp_instance_get_channel_id(instance), packet_count, small_delta_count, large_delta_count, lost_count);
 
-	res = rtcp_sendto(instance, (unsigned int *)rtcpheader, packet_len, 0, &remote_address, &ice);
+	res = rtcp_sendto(instance, (unsigned int *)rtcpheader, packet_len, sizeof(bdata), 0, &remote_address, &ice);
 	if (res < 0) {
 		ast_log(LOG_ERROR, "RTCP transport-cc feedback error to %s due to %s\n",
 			ast_sockaddr_stringify(&remote_address), strerror(errno));
@@ -7226,7 +8376,8 @@ static void rtp_instance_parse_extmap_extensions(struct ast_rtp_instance *instan
 }
 
 static struct ast_frame *ast_rtp_interpret(struct ast_rtp_instance *instance, struct ast_srtp *srtp,
-	const struct ast_sockaddr *remote_address, unsigned char *read_area, int length, int prev_seqno,
+	const struct ast_sockaddr *remote_address, unsigned char *read_area, int length,
+	size_t read_area_size, int prev_seqno,
 	unsigned int bundled)
 {
 	unsigned int *rtpheader = (unsigned int*)(read_area);
@@ -7341,6 +8492,10 @@ static struct ast_frame *ast_rtp_interpret(struct ast_rtp_instance *instance, st
 	if (rtp->rxcount == 1) {
 		rtp->seedrxseqno = seqno;
 	}
+	if (!(rtp->rxcount & 0x3f)) {
+		/* Keep the lock-free statistics snapshot reasonably current. */
+		rtp_stats_publish(instance, rtp);
+	}
 
 	/* Do not schedule RR if RTCP isn't run */
 	if (rtp->rtcp && !ast_sockaddr_isnull(&rtp->rtcp->them) && rtp->rtcp->schedid < 0) {
@@ -7361,7 +8516,7 @@ static struct ast_frame *ast_rtp_interpret(struct ast_rtp_instance *instance, st
 	 */
 	instance1 = ast_rtp_instance_get_bridged(instance);
 	if (instance1
-		&& !bridge_p2p_rtp_write(instance, instance1, rtpheader, res, hdrlen)) {
+		&& !bridge_p2p_rtp_write(instance, instance1, rtpheader, res, hdrlen, read_area_size)) {
 		struct timeval rxtime;
 		struct ast_frame *f;
 
@@ -7663,12 +8818,13 @@ static int should_drop_packets(struct ast_sockaddr *addr)
 #endif
 
 /*! \pre instance is locked */
-static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtcp)
+static struct ast_frame *ast_rtp_read_one(struct ast_rtp_instance *instance, int rtcp)
 {
 	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
 	struct ast_srtp *srtp;
 	RAII_VAR(struct ast_rtp_instance *, child, NULL, rtp_instance_unlock);
 	struct ast_sockaddr addr;
+	struct ast_sockaddr_key addr_key = { { 0, 0 }, };
 	int res, hdrlen = 12, version, payloadtype;
 	unsigned char *read_area = rtp->rawdata + AST_FRIENDLY_OFFSET;
 	size_t read_area_size = sizeof(rtp->rawdata) - AST_FRIENDLY_OFFSET;
@@ -7784,6 +8940,11 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 	}
 
 	/* If strict RTP protection is enabled see if we need to learn the remote address or if we need to drop the packet */
+	if (rtp->strict_rtp_state != STRICT_RTP_OPEN) {
+		/* Extract the source comparison key once so the checks below are
+		 * word compares instead of full ast_sockaddr_cmp() calls. */
+		ast_sockaddr_to_key(&addr, &addr_key);
+	}
 	switch (rtp->strict_rtp_state) {
 	case STRICT_RTP_LEARN:
 		/*
@@ -7837,7 +8998,8 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 		} else {
 			struct ast_sockaddr target_address;
 
-			if (!ast_sockaddr_cmp(&rtp->strict_rtp_address, &addr)) {
+			if (!ast_sockaddr_isnull(&rtp->strict_rtp_address)
+				&& !ast_sockaddr_key_cmp(&rtp->strict_rtp_address_key, &addr_key)) {
 				/*
 				 * We are open to learning a new address but have received
 				 * traffic from the current address, accept it and reset
@@ -7861,6 +9023,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 				ast_verb(4, "%p -- Strict RTP switching to RTP target address %s as source\n",
 					rtp, ast_sockaddr_stringify(&addr));
 				ast_sockaddr_copy(&rtp->strict_rtp_address, &addr);
+				rtp->strict_rtp_address_key = addr_key;
 				rtp_learning_seq_init(&rtp->rtp_source_learn, seqno);
 				break;
 			}
@@ -7870,7 +9033,8 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 			 * with it, that means we've stopped getting RTP from the original
 			 * source and we should switch to it.
 			 */
-			if (!ast_sockaddr_cmp(&rtp->rtp_source_learn.proposed_address, &addr)) {
+			if (!ast_sockaddr_isnull(&rtp->rtp_source_learn.proposed_address)
+				&& !ast_sockaddr_key_cmp(&rtp->rtp_source_learn.proposed_address_key, &addr_key)) {
 				if (rtp->rtp_source_learn.stream_type == AST_MEDIA_TYPE_UNKNOWN) {
 					struct ast_rtp_codecs *codecs;
 
@@ -7885,6 +9049,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 					ast_verb(4, "%p -- Strict RTP switching source address to %s\n",
 						rtp, ast_sockaddr_stringify(&addr));
 					ast_sockaddr_copy(&rtp->strict_rtp_address, &addr);
+					rtp->strict_rtp_address_key = addr_key;
 					rtp_learning_seq_init(&rtp->rtp_source_learn, seqno);
 					break;
 				}
@@ -7897,6 +9062,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 				 * the start of the expected new stream.
 				 */
 				ast_sockaddr_copy(&rtp->rtp_source_learn.proposed_address, &addr);
+				rtp->rtp_source_learn.proposed_address_key = addr_key;
 				rtp_learning_seq_init(&rtp->rtp_source_learn, seqno);
 				ast_debug_rtp(1, "(%p) RTP %p -- Received packet from %s, dropping due to strict RTP protection. Qualifying new stream.\n",
 					instance, rtp, ast_sockaddr_stringify(&addr));
@@ -7914,7 +9080,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 		 * An attacker could manage to get an RTCP packet redirected to
 		 * them which can contain the SSRC value.
 		 */
-		if (!ast_sockaddr_cmp(&rtp->strict_rtp_address, &addr)) {
+		if (!ast_sockaddr_key_cmp(&rtp->strict_rtp_address_key, &addr_key)) {
 			break;
 		}
 		ast_debug_rtp(1, "(%p) RTP %p -- Received packet from %s, dropping due to strict RTP protection.\n",
@@ -7979,7 +9145,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 
 	if (!rtp->recv_buffer) {
 		/* If there is no receive buffer then we can pass back the frame directly */
-		frame = ast_rtp_interpret(instance, srtp, &addr, read_area, res, prev_seqno, bundled);
+		frame = ast_rtp_interpret(instance, srtp, &addr, read_area, res, read_area_size, prev_seqno, bundled);
 		AST_LIST_INSERT_TAIL(&frames, frame, frame_list);
 		return AST_LIST_FIRST(&frames);
 	} else if (rtp->expectedrxseqno == -1 || seqno == rtp->expectedrxseqno) {
@@ -7994,7 +9160,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 		 * return it directly without duplicating it.
 		 */
 		if (!ast_data_buffer_count(rtp->recv_buffer)) {
-			frame = ast_rtp_interpret(instance, srtp, &addr, read_area, res, prev_seqno, bundled);
+			frame = ast_rtp_interpret(instance, srtp, &addr, read_area, res, read_area_size, prev_seqno, bundled);
 			AST_LIST_INSERT_TAIL(&frames, frame, frame_list);
 			return AST_LIST_FIRST(&frames);
 		}
@@ -8009,7 +9175,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 		 * chance it will be overwritten.
 		 */
 		if (!ast_data_buffer_get(rtp->recv_buffer, rtp->expectedrxseqno)) {
-			frame = ast_rtp_interpret(instance, srtp, &addr, read_area, res, prev_seqno, bundled);
+			frame = ast_rtp_interpret(instance, srtp, &addr, read_area, res, read_area_size, prev_seqno, bundled);
 			AST_LIST_INSERT_TAIL(&frames, frame, frame_list);
 			return AST_LIST_FIRST(&frames);
 		}
@@ -8019,7 +9185,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 		 * to the head of the frames list and avoid having to duplicate it but this would result in out
 		 * of order packet processing by libsrtp which we are trying to avoid.
 		 */
-		frame = ast_frdup(ast_rtp_interpret(instance, srtp, &addr, read_area, res, prev_seqno, bundled));
+		frame = ast_frdup(ast_rtp_interpret(instance, srtp, &addr, read_area, res, read_area_size, prev_seqno, bundled));
 		if (frame) {
 			AST_LIST_INSERT_TAIL(&frames, frame, frame_list);
 			prev_seqno = seqno;
@@ -8034,7 +9200,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 				break;
 			}
 
-			frame = ast_frdup(ast_rtp_interpret(instance, srtp, &addr, payload->buf, payload->size, prev_seqno, bundled));
+			frame = ast_frdup(ast_rtp_interpret(instance, srtp, &addr, payload->buf, payload->size, payload->size, prev_seqno, bundled));
 			ast_free(payload);
 
 			if (!frame) {
@@ -8080,7 +9246,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 
 			/* If the packet we received is the one we are expecting at this point then add it in */
 			if (rtp->expectedrxseqno == seqno) {
-				frame = ast_frdup(ast_rtp_interpret(instance, srtp, &addr, read_area, res, prev_seqno, bundled));
+				frame = ast_frdup(ast_rtp_interpret(instance, srtp, &addr, read_area, res, read_area_size, prev_seqno, bundled));
 				if (frame) {
 					AST_LIST_INSERT_TAIL(&frames, frame, frame_list);
 					prev_seqno = seqno;
@@ -8105,7 +9271,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 
 			payload = (struct ast_rtp_rtcp_nack_payload *)ast_data_buffer_remove(rtp->recv_buffer, rtp->expectedrxseqno);
 			if (payload) {
-				frame = ast_frdup(ast_rtp_interpret(instance, srtp, &addr, payload->buf, payload->size, prev_seqno, bundled));
+				frame = ast_frdup(ast_rtp_interpret(instance, srtp, &addr, payload->buf, payload->size, payload->size, prev_seqno, bundled));
 				if (frame) {
 					AST_LIST_INSERT_TAIL(&frames, frame, frame_list);
 					prev_seqno = rtp->expectedrxseqno;
@@ -8127,7 +9293,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 			 * to be the last packet processed right now and it is also guaranteed that it will always return
 			 * non-NULL.
 			 */
-			frame = ast_rtp_interpret(instance, srtp, &addr, read_area, res, prev_seqno, bundled);
+			frame = ast_rtp_interpret(instance, srtp, &addr, read_area, res, read_area_size, prev_seqno, bundled);
 			AST_LIST_INSERT_TAIL(&frames, frame, frame_list);
 			rtp->expectedrxseqno = seqno + 1;
 			if (rtp->expectedrxseqno == SEQNO_CYCLE_OVER) {
@@ -8313,7 +9479,7 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 
 			packet_len += res;
 
-			res = rtcp_sendto(instance, rtcpheader, packet_len, 0, &remote_address, &ice);
+			res = rtcp_sendto(instance, rtcpheader, packet_len, data_size, 0, &remote_address, &ice);
 			if (res < 0) {
 				ast_debug_rtcp(1, "(%p) RTCP failed to send NACK request out\n", instance);
 			} else {
@@ -8327,6 +9493,96 @@ static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtc
 	return &ast_null_frame;
 }
 
+/*! \pre instance is locked */
+static struct ast_frame *rtp_read_frames(struct ast_rtp_instance *instance, int rtcp)
+{
+#if defined(HAVE_RECVMMSG) || defined(HAVE_EPOLL)
+	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
+#endif
+#ifdef HAVE_RECVMMSG
+	struct ast_frame *first;
+	struct ast_frame *head = NULL;
+	struct ast_frame *tail = NULL;
+	int fatal = 0;
+#endif
+
+#ifdef HAVE_EPOLL
+	if (!rtcp && rtpreactor && rtp_reactor_num_threads && !rtp->reactor_registered
+		&& !ast_strlen_zero(ast_rtp_instance_get_channel_id(instance))) {
+		rtp_reactor_register(instance, rtp);
+	}
+#endif
+#ifdef HAVE_RECVMMSG
+	first = ast_rtp_read_one(instance, rtcp);
+	if (rtcp || !rtp->recv_batch || !first
+		|| rtp->recv_batch->next >= rtp->recv_batch->count) {
+		return first;
+	}
+
+	/*
+	 * The recvmmsg() drain left datagrams staged on the session.  They
+	 * must all be turned into frames now: the poll that woke us only
+	 * fires again when a new datagram arrives, so anything left staged
+	 * would sit undelivered until then.
+	 */
+	for (;;) {
+		struct ast_frame *cur = first;
+
+		/*
+		 * Frames from the interpret path generally live in scratch
+		 * storage on the RTP session (rtp->f and rtp->rawdata) which
+		 * the next datagram overwrites, so take private copies before
+		 * reading on.
+		 */
+		while (cur) {
+			struct ast_frame *next = AST_LIST_NEXT(cur, frame_list);
+			struct ast_frame *dup;
+
+			AST_LIST_NEXT(cur, frame_list) = NULL;
+			if (cur->frametype != AST_FRAME_NULL
+				&& (dup = ast_frdup(cur))) {
+				if (tail) {
+					AST_LIST_NEXT(tail, frame_list) = dup;
+				} else {
+					head = dup;
+				}
+				tail = dup;
+			}
+			ast_frfree(cur);
+			cur = next;
+		}
+
+		if (rtp->recv_batch->next >= rtp->recv_batch->count) {
+			break;
+		}
+		first = ast_rtp_read_one(instance, 0);
+		if (!first) {
+			/* Deliver what we have; the error repeats on the next read. */
+			fatal = 1;
+			break;
+		}
+	}
+
+	if (head) {
+		return head;
+	}
+	return fatal ? NULL : &ast_null_frame;
+#else
+	return ast_rtp_read_one(instance, rtcp);
+#endif
+}
+
+/*! \pre instance is locked */
+static struct ast_frame *ast_rtp_read(struct ast_rtp_instance *instance, int rtcp)
+{
+	struct ast_frame *frame;
+	struct timeval trace_start = ast_latency_trace_start();
+
+	frame = rtp_read_frames(instance, rtcp);
+	ast_latency_trace_end(AST_LATENCY_STAGE_RTP_READ, &trace_start);
+	return frame;
+}
+
 /*! \pre instance is locked */
 static void ast_rtp_prop_set(struct ast_rtp_instance *instance, enum ast_rtp_property property, int value)
 {
@@ -8379,12 +9635,27 @@ static void ast_rtp_prop_set(struct ast_rtp_instance *instance, enum ast_rtp_pro
 			}
 
 			if (value == AST_RTP_INSTANCE_RTCP_STANDARD) {
+				int rtcp_from_pool = 0;
+
 				/* We're either setting up RTCP from scratch or
 				 * switching from MUX. Either way, we won't have
 				 * a socket set up, and we need to set it up
 				 */
-				if ((rtp->rtcp->s =
-				     create_new_socket("RTCP",
+#ifdef HAVE_PJPROJECT
+				if (rtp->pool_rtcp_sock > -1) {
+					/* The candidate pool already bound a socket to our
+					 * port plus one when the RTP socket was drawn. */
+					rtp->rtcp->s = rtp->pool_rtcp_sock;
+					rtp->pool_rtcp_sock = -1;
+					rtp->pool_stun_rtcp_valid = 1;
+					rtcp_from_pool = 1;
+				} else {
+					rtp->pool_stun_rtcp_valid = 0;
+				}
+#endif
+				if (!rtcp_from_pool
+					&& (rtp->rtcp->s =
+					create_new_socket("RTCP",
 						       ast_sockaddr_is_ipv4(&rtp->rtcp->us) ?
 						       AF_INET :
 						       ast_sockaddr_is_ipv6(&rtp->rtcp->us) ?
@@ -8397,7 +9668,7 @@ static void ast_rtp_prop_set(struct ast_rtp_instance *instance, enum ast_rtp_pro
 				}
 
 				/* Try to actually bind to the IP address and port we are going to use for RTCP, if this fails we have to bail out */
-				if (ast_bind(rtp->rtcp->s, &rtp->rtcp->us)) {
+				if (!rtcp_from_pool && ast_bind(rtp->rtcp->s, &rtp->rtcp->us)) {
 					ast_debug_rtcp(1, "(%p) RTCP failed to setup RTP instance\n", instance);
 					close(rtp->rtcp->s);
 					ast_free(rtp->rtcp->local_addr_str);
@@ -8434,6 +9705,10 @@ static void ast_rtp_prop_set(struct ast_rtp_instance *instance, enum ast_rtp_pro
 				if (rtp->rtcp->dtls.ssl && rtp->rtcp->dtls.ssl != rtp->dtls.ssl) {
 					SSL_free(rtp->rtcp->dtls.ssl);
 				}
+				if (rtp->rtcp->dtls.session) {
+					SSL_SESSION_free(rtp->rtcp->dtls.session);
+					rtp->rtcp->dtls.session = NULL;
+				}
 				rtp->rtcp->dtls.ssl = rtp->dtls.ssl;
 #endif
 			}
@@ -8478,6 +9753,9 @@ static void ast_rtp_prop_set(struct ast_rtp_instance *instance, enum ast_rtp_pro
 				if (rtp->rtcp->dtls.ssl && rtp->rtcp->dtls.ssl != rtp->dtls.ssl) {
 					SSL_free(rtp->rtcp->dtls.ssl);
 				}
+				if (rtp->rtcp->dtls.session) {
+					SSL_SESSION_free(rtp->rtcp->dtls.session);
+				}
 #endif
 				ast_free(rtp->rtcp->local_addr_str);
 				ast_free(rtp->rtcp);
@@ -8695,11 +9973,15 @@ static int ast_rtp_local_bridge(struct ast_rtp_instance *instance0, struct ast_r
 	return 0;
 }
 
-/*! \pre instance is locked */
-static int ast_rtp_get_stat(struct ast_rtp_instance *instance, struct ast_rtp_instance_stats *stats, enum ast_rtp_instance_stat stat)
+/*!
+ * \internal
+ * \brief Copy the requested statistics out of the live RTP counters.
+ *
+ * \pre instance is locked
+ */
+static int rtp_get_stat_fill(struct ast_rtp_instance *instance, struct ast_rtp *rtp,
+	struct ast_rtp_instance_stats *stats, enum ast_rtp_instance_stat stat)
 {
-	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
-
 	if (!rtp->rtcp) {
 		return -1;
 	}
@@ -8747,6 +10029,74 @@ static int ast_rtp_get_stat(struct ast_rtp_instance *instance, struct ast_rtp_in
 	return 0;
 }
 
+/*!
+ * \internal
+ * \brief Publish a fresh statistics snapshot for lock-free readers.
+ *
+ * The snapshot is guarded by a seqlock: the sequence counter is bumped to an
+ * odd value before the copy and back to an even value afterwards, so a reader
+ * that observes the same even value on both sides of its own copy knows the
+ * snapshot it took is consistent.  Every writer runs on the media path with
+ * the instance lock held, so writers never race each other; only the readers
+ * are lock free.
+ *
+ * \pre instance is locked
+ */
+static void rtp_stats_publish(struct ast_rtp_instance *instance, struct ast_rtp *rtp)
+{
+	if (!rtp->rtcp) {
+		return;
+	}
+
+	ast_atomic_store_n(&rtp->stats_seq, rtp->stats_seq + 1, __ATOMIC_RELAXED);
+	ast_atomic_thread_fence(__ATOMIC_SEQ_CST);
+	rtp_get_stat_fill(instance, rtp, &rtp->stats_snapshot, AST_RTP_INSTANCE_STAT_ALL);
+	ast_atomic_thread_fence(__ATOMIC_SEQ_CST);
+	ast_atomic_store_n(&rtp->stats_seq, rtp->stats_seq + 1, __ATOMIC_RELAXED);
+}
+
+/*! \pre instance is locked */
+static int ast_rtp_get_stat(struct ast_rtp_instance *instance, struct ast_rtp_instance_stats *stats, enum ast_rtp_instance_stat stat)
+{
+	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
+
+	return rtp_get_stat_fill(instance, rtp, stats, stat);
+}
+
+/*!
+ * \pre instance is NOT locked
+ *
+ * Serves statistics from the seqlock-guarded snapshot so that monitoring
+ * consumers polling thousands of instances never contend with the media
+ * path for the instance lock.  The full snapshot is copied out regardless
+ * of the requested statistic; the extra fields are harmless to callers.
+ */
+static int ast_rtp_get_stat_nolock(struct ast_rtp_instance *instance, struct ast_rtp_instance_stats *stats, enum ast_rtp_instance_stat stat)
+{
+	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
+	unsigned int seq;
+
+	for (;;) {
+		seq = ast_atomic_load_n(&rtp->stats_seq, __ATOMIC_RELAXED);
+		if (!seq) {
+			/* Nothing has been published yet; fall back to the locked path. */
+			return -1;
+		}
+		if (seq & 1) {
+			/* A writer is mid-update; it holds the instance lock so it
+			 * finishes quickly. */
+			sched_yield();
+			continue;
+		}
+		ast_atomic_thread_fence(__ATOMIC_SEQ_CST);
+		*stats = rtp->stats_snapshot;
+		ast_atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (ast_atomic_load_n(&rtp->stats_seq, __ATOMIC_RELAXED) == seq) {
+			return 0;
+		}
+	}
+}
+
 /*! \pre Neither instance0 nor instance1 are locked */
 static int ast_rtp_dtmf_compatible(struct ast_channel *chan0, struct ast_rtp_instance *instance0, struct ast_channel *chan1, struct ast_rtp_instance *instance1)
 {
@@ -8785,6 +10135,10 @@ static void ast_rtp_stop(struct ast_rtp_instance *instance)
 	struct ast_rtp *rtp = ast_rtp_instance_get_data(instance);
 	struct ast_sockaddr addr = { {0,} };
 
+#ifdef HAVE_EPOLL
+	rtp_reactor_unregister(rtp);
+#endif
+
 #if defined(HAVE_OPENSSL) && (OPENSSL_VERSION_NUMBER >= 0x10001000L) && !defined(OPENSSL_NO_SRTP)
 	ao2_unlock(instance);
 	AST_SCHED_DEL_UNREF(rtp->sched, rtp->rekeyid, ao2_ref(instance, -1));
@@ -8870,7 +10224,7 @@ static int ast_rtp_sendcng(struct ast_rtp_instance *instance, int level)
 	rtpheader[2] = htonl(rtp->ssrc);
 	data[12] = level;
 
-	res = rtp_sendto(instance, (void *) rtpheader, hdrlen + 1, 0, &remote_address, &ice);
+	res = rtp_sendto(instance, (void *) rtpheader, hdrlen + 1, sizeof(data), 0, &remote_address, &ice);
 
 	if (res < 0) {
 		ast_log(LOG_ERROR, "RTP Comfort Noise Transmission error to %s: %s\n", ast_sockaddr_stringify(&remote_address), strerror(errno));
@@ -8934,6 +10288,7 @@ static void ast_rtp_set_remote_ssrc(struct ast_rtp_instance *instance, unsigned
 			if (mapping->instance == instance) {
 				mapping->ssrc = ssrc;
 				mapping->ssrc_valid = 1;
+				rtp_ssrc_mapping_hash_rebuild(bundled_rtp);
 				break;
 			}
 		}
@@ -8984,6 +10339,7 @@ static int ast_rtp_bundle(struct ast_rtp_instance *child, struct ast_rtp_instanc
 		ao2_lock(child_rtp->bundled);
 		bundled_rtp = ast_rtp_instance_get_data(child_rtp->bundled);
 		AST_VECTOR_REMOVE_CMP_UNORDERED(&bundled_rtp->ssrc_mapping, child, SSRC_MAPPING_ELEM_CMP, AST_VECTOR_ELEM_CLEANUP_NOOP);
+		rtp_ssrc_mapping_hash_rebuild(bundled_rtp);
 		ao2_unlock(child_rtp->bundled);
 
 		ao2_lock(child);
@@ -9014,6 +10370,7 @@ static int ast_rtp_bundle(struct ast_rtp_instance *child, struct ast_rtp_instanc
 	ao2_lock(parent);
 
 	AST_VECTOR_APPEND(&parent_rtp->ssrc_mapping, mapping);
+	rtp_ssrc_mapping_hash_rebuild(parent_rtp);
 
 #if defined(HAVE_OPENSSL) && (OPENSSL_VERSION_NUMBER >= 0x10001000L) && !defined(OPENSSL_NO_SRTP)
 	/* If DTLS-SRTP is already in use then add the local SSRC to it, otherwise it will get added once DTLS
@@ -9234,6 +10591,13 @@ static char *handle_cli_rtp_settings(struct ast_cli_entry *e, int cmd, struct as
 	}
 
 	ast_cli(a->fd, "  Replay Protect:  %s\n", AST_CLI_YESNO(srtp_replay_protection));
+	ast_cli(a->fd, "  Packet pacing:   %s\n", AST_CLI_YESNO(pacing));
+
+	if (pacing) {
+		ast_cli(a->fd, "  Pacing interval: %d ms\n", pacing_interval);
+		ast_cli(a->fd, "  Pacing burst:    %d packets\n", pacing_burst);
+	}
+
 #ifdef HAVE_PJPROJECT
 	ast_cli(a->fd, "  ICE support:     %s\n", AST_CLI_YESNO(icesupport));
 
@@ -9241,6 +10605,17 @@ static char *handle_cli_rtp_settings(struct ast_cli_entry *e, int cmd, struct as
 	memcpy(&stunaddr_copy, &stunaddr, sizeof(stunaddr));
 	ast_rwlock_unlock(&stunaddr_lock);
 	ast_cli(a->fd, "  STUN address:    %s:%d\n", ast_inet_ntoa(stunaddr_copy.sin_addr), htons(stunaddr_copy.sin_port));
+	ast_cli(a->fd, "  ICE pool size:   %d\n", ice_pool_size);
+#endif
+
+#if defined(HAVE_OPENSSL) && (OPENSSL_VERSION_NUMBER >= 0x10001000L) && !defined(OPENSSL_NO_SRTP)
+	ast_cli(a->fd, "  DTLS handshakes: %d (%d resumed)\n",
+		dtls_handshakes_completed, dtls_handshakes_resumed);
+	if (dtls_handshakes_completed) {
+		ast_cli(a->fd, "  DTLS setup (ms): avg %.1f, max %d\n",
+			(double)dtls_handshake_total_ms / dtls_handshakes_completed,
+			dtls_handshake_max_ms);
+	}
 #endif
 	return CLI_SUCCESS;
 }
@@ -9476,6 +10851,11 @@ static int rtp_reload(int reload, int by_external_config)
 	learning_min_sequential = DEFAULT_LEARNING_MIN_SEQUENTIAL;
 	learning_min_duration = DEFAULT_LEARNING_MIN_DURATION;
 	srtp_replay_protection = DEFAULT_SRTP_REPLAY_PROTECTION;
+	batchreceive = DEFAULT_BATCH_RECEIVE;
+	rtpreactor = DEFAULT_RTP_REACTOR;
+	pacing = DEFAULT_PACING;
+	pacing_interval = DEFAULT_PACING_INTERVAL;
+	pacing_burst = DEFAULT_PACING_BURST;
 
 	/** This resource is not "reloaded" so much as unloaded and loaded again.
 	 * In the case of the TURN related variables, the memory referenced by a
@@ -9489,6 +10869,7 @@ static int rtp_reload(int reload, int by_external_config)
 	icesupport = DEFAULT_ICESUPPORT;
 	stun_software_attribute = DEFAULT_STUN_SOFTWARE_ATTRIBUTE;
 	turnport = DEFAULT_TURN_PORT;
+	ice_pool_size = DEFAULT_ICE_POOL_SIZE;
 	clean_stunaddr();
 	turnaddr = pj_str(NULL);
 	turnusername = pj_str(NULL);
@@ -9556,6 +10937,47 @@ static int rtp_reload(int reload, int by_external_config)
 		}
 		learning_min_duration = CALC_LEARNING_MIN_DURATION(learning_min_sequential);
 	}
+	if ((s = ast_variable_retrieve(cfg, "general", "batchreceive"))) {
+#ifdef HAVE_RECVMMSG
+		batchreceive = ast_true(s);
+#else
+		if (ast_true(s)) {
+			ast_log(LOG_WARNING, "Batch receive is not supported on this operating system!\n");
+		}
+#endif
+	}
+	if ((s = ast_variable_retrieve(cfg, "general", "rtpreactor"))) {
+#ifdef HAVE_EPOLL
+		rtpreactor = ast_true(s);
+#else
+		if (ast_true(s)) {
+			ast_log(LOG_WARNING, "The RTP reactor is not supported on this operating system!\n");
+		}
+#endif
+	}
+	if ((s = ast_variable_retrieve(cfg, "general", "pacing"))) {
+		pacing = ast_true(s);
+		if (pacing && rtp_pacer_thread == AST_PTHREADT_NULL) {
+			ast_log(LOG_WARNING, "RTP pacing requested but the pacer thread is not running!\n");
+			pacing = 0;
+		}
+	}
+	if ((s = ast_variable_retrieve(cfg, "general", "pacing_interval"))) {
+		pacing_interval = atoi(s);
+		if (pacing_interval < MIN_PACING_INTERVAL || pacing_interval > MAX_PACING_INTERVAL) {
+			ast_log(LOG_WARNING, "Invalid pacing_interval value %d, using default of %d\n",
+				pacing_interval, DEFAULT_PACING_INTERVAL);
+			pacing_interval = DEFAULT_PACING_INTERVAL;
+		}
+	}
+	if ((s = ast_variable_retrieve(cfg, "general", "pacing_burst"))) {
+		pacing_burst = atoi(s);
+		if (pacing_burst < 1 || pacing_burst > MAX_PACING_BURST) {
+			ast_log(LOG_WARNING, "Invalid pacing_burst value %d, using default of %d\n",
+				pacing_burst, DEFAULT_PACING_BURST);
+			pacing_burst = DEFAULT_PACING_BURST;
+		}
+	}
 	if ((s = ast_variable_retrieve(cfg, "general", "srtpreplayprotection"))) {
 		srtp_replay_protection = ast_true(s);
 	}
@@ -9566,6 +10988,16 @@ static int rtp_reload(int reload, int by_external_config)
 	if ((s = ast_variable_retrieve(cfg, "general", "stun_software_attribute"))) {
 		stun_software_attribute = ast_true(s);
 	}
+	if ((s = ast_variable_retrieve(cfg, "general", "ice_pool_size"))) {
+		ice_pool_size = atoi(s);
+		if (ice_pool_size < 0) {
+			ice_pool_size = 0;
+		} else if (ice_pool_size > MAX_ICE_POOL_SIZE) {
+			ast_log(LOG_WARNING, "Invalid ice_pool_size value %d, using maximum of %d\n",
+				ice_pool_size, MAX_ICE_POOL_SIZE);
+			ice_pool_size = MAX_ICE_POOL_SIZE;
+		}
+	}
 	if ((s = ast_variable_retrieve(cfg, "general", "stunaddr"))) {
 		char *hostport, *host, *port;
 		unsigned int port_parsed = STANDARD_STUN_PORT;
@@ -9723,6 +11155,22 @@ static int rtp_reload(int reload, int by_external_config)
 		rtpend = DEFAULT_RTP_END;
 	}
 	ast_verb(2, "RTP Allocating from port range %d -> %d\n", rtpstart, rtpend);
+
+#ifdef HAVE_PJPROJECT
+	/* Pooled transports were bound and gathered with the old configuration */
+	ice_pool_flush();
+	AST_LIST_LOCK(&ice_pool);
+	ast_cond_signal(&ice_pool_cond);
+	AST_LIST_UNLOCK(&ice_pool);
+#endif
+
+#ifdef HAVE_EPOLL
+	/* Reactor threads are started once and kept for the life of the
+	 * module; disabling rtpreactor on a reload stops new registrations
+	 * while already registered sockets continue to be serviced. */
+	rtp_reactor_start();
+#endif
+
 	return 0;
 }
 
@@ -9801,8 +11249,20 @@ static int load_module(void)
 		return AST_MODULE_LOAD_DECLINE;
 	}
 
+	ast_cond_init(&ice_pool_cond, NULL);
+	if (ast_pthread_create_background(&ice_pool_thread, NULL, ice_pool_thread_loop, NULL)) {
+		ast_log(LOG_WARNING, "Failed to start ICE candidate pool thread, pre-gathering disabled\n");
+		ice_pool_thread = AST_PTHREADT_NULL;
+	}
+
 #endif
 
+	ast_cond_init(&rtp_pacer_cond, NULL);
+	if (ast_pthread_create_background(&rtp_pacer_thread, NULL, rtp_pacer_thread_loop, NULL)) {
+		ast_log(LOG_WARNING, "Failed to start RTP pacer thread, pacing disabled\n");
+		rtp_pacer_thread = AST_PTHREADT_NULL;
+	}
+
 #if defined(HAVE_OPENSSL) && (OPENSSL_VERSION_NUMBER >= 0x10001000L) && !defined(OPENSSL_NO_SRTP) && defined(HAVE_OPENSSL_BIO_METHOD)
 	dtls_bio_methods = BIO_meth_new(BIO_TYPE_BIO, "rtp write");
 	if (!dtls_bio_methods) {
@@ -9845,6 +11305,33 @@ static int load_module(void)
 
 static int unload_module(void)
 {
+#ifdef HAVE_EPOLL
+	rtp_reactor_shutdown();
+#endif
+	if (rtp_pacer_thread != AST_PTHREADT_NULL) {
+		struct rtp_pacer_entry *entry;
+
+		AST_LIST_LOCK(&rtp_pacer);
+		rtp_pacer_shutdown = 1;
+		ast_cond_signal(&rtp_pacer_cond);
+		AST_LIST_UNLOCK(&rtp_pacer);
+		pthread_join(rtp_pacer_thread, NULL);
+		rtp_pacer_thread = AST_PTHREADT_NULL;
+
+		/* Drop any instances still waiting on the pacer, their queued
+		 * packets are freed when the instance is destroyed. */
+		while ((entry = AST_LIST_REMOVE_HEAD(&rtp_pacer, next))) {
+			struct ast_rtp *rtp;
+
+			ao2_lock(entry->instance);
+			rtp = ast_rtp_instance_get_data(entry->instance);
+			rtp->paced_scheduled = 0;
+			ao2_unlock(entry->instance);
+			ao2_ref(entry->instance, -1);
+			ast_free(entry);
+		}
+	}
+	ast_cond_destroy(&rtp_pacer_cond);
 	ast_rtp_engine_unregister(&asterisk_rtp_engine);
 	ast_cli_unregister_multiple(cli_rtp, ARRAY_LEN(cli_rtp));
 
@@ -9855,6 +11342,17 @@ static int unload_module(void)
 #endif
 
 #ifdef HAVE_PJPROJECT
+	if (ice_pool_thread != AST_PTHREADT_NULL) {
+		AST_LIST_LOCK(&ice_pool);
+		ice_pool_shutdown = 1;
+		ast_cond_signal(&ice_pool_cond);
+		AST_LIST_UNLOCK(&ice_pool);
+		pthread_join(ice_pool_thread, NULL);
+		ice_pool_thread = AST_PTHREADT_NULL;
+	}
+	ice_pool_flush();
+	ast_cond_destroy(&ice_pool_cond);
+
 	host_candidate_overrides_clear();
 	pj_thread_register_check();
 	rtp_terminate_pjproject();
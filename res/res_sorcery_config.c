@@ -47,6 +47,9 @@ struct sorcery_config {
 	/*! \brief Objects retrieved from the configuration file */
 	struct ao2_global_obj objects;
 
+	/*! \brief Per-section content hashes from the last load, for differential reload */
+	struct ao2_global_obj section_hashes;
+
 	/*! \brief Any specific variable criteria for considering a defined category for this object */
 	struct ast_variable *criteria;
 
@@ -72,6 +75,66 @@ struct sorcery_config {
 	char filename[];
 };
 
+/*! \brief Content hash of a configuration section from the last load */
+struct sorcery_config_section_hash {
+	/*! \brief Hash of the section's variables as they were last loaded */
+	uint64_t hash;
+
+	/*! \brief Name of the section (object id) */
+	char id[];
+};
+
+AO2_STRING_FIELD_HASH_FN(sorcery_config_section_hash, id);
+AO2_STRING_FIELD_CMP_FN(sorcery_config_section_hash, id);
+
+/*! \brief Fold a string into a FNV-1a hash */
+static uint64_t sorcery_section_hash_string(uint64_t hash, const char *str)
+{
+	const unsigned char *pos;
+
+	for (pos = (const unsigned char *) str; *pos; ++pos) {
+		hash ^= *pos;
+		hash *= 1099511628211ULL;
+	}
+
+	/* Terminate each string so adjacent fields cannot alias one another */
+	hash ^= 0xff;
+	hash *= 1099511628211ULL;
+
+	return hash;
+}
+
+/*! \brief Compute a content hash over all variables of a configuration section */
+static uint64_t sorcery_section_hash(struct ast_category *category)
+{
+	struct ast_variable *field;
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (field = ast_category_first(category); field; field = field->next) {
+		hash = sorcery_section_hash_string(hash, field->name);
+		hash = sorcery_section_hash_string(hash, field->value);
+	}
+
+	return hash;
+}
+
+/*! \brief Allocate a section hash record for the given object id */
+static struct sorcery_config_section_hash *sorcery_section_hash_alloc(const char *id, uint64_t hash)
+{
+	struct sorcery_config_section_hash *section;
+
+	section = ao2_alloc_options(sizeof(*section) + strlen(id) + 1, NULL,
+		AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!section) {
+		return NULL;
+	}
+
+	section->hash = hash;
+	strcpy(section->id, id); /* Safe */
+
+	return section;
+}
+
 /*! \brief Structure used for fields comparison */
 struct sorcery_config_fields_cmp_params {
 	/*! \brief Pointer to the sorcery structure */
@@ -125,6 +188,8 @@ static void sorcery_config_destructor(void *obj)
 
 	ao2_global_obj_release(config->objects);
 	ast_rwlock_destroy(&config->objects.lock);
+	ao2_global_obj_release(config->section_hashes);
+	ast_rwlock_destroy(&config->section_hashes.lock);
 	ast_variables_destroy(config->criteria);
 	ast_free(config->explicit_name);
 }
@@ -320,6 +385,8 @@ static void sorcery_config_internal_load(void *data, const struct ast_sorcery *s
 	struct ast_config *cfg = ast_config_load2(config->filename, config->uuid, flags);
 	struct ast_category *category = NULL;
 	RAII_VAR(struct ao2_container *, objects, NULL, ao2_cleanup);
+	RAII_VAR(struct ao2_container *, old_hashes, NULL, ao2_cleanup);
+	RAII_VAR(struct ao2_container *, new_hashes, NULL, ao2_cleanup);
 	const char *id = NULL;
 	unsigned int buckets = 0;
 	unsigned int has_dynamic_contents = 0;
@@ -388,8 +455,18 @@ static void sorcery_config_internal_load(void *data, const struct ast_sorcery *s
 		return;
 	}
 
+	/* The per-section hashes make the next reload differential: unchanged sections
+	 * reuse their existing object instead of being created again.  Failure to
+	 * allocate the container is not fatal, the reload just does full rebuilds.
+	 */
+	old_hashes = ao2_global_obj_ref(config->section_hashes);
+	new_hashes = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_NOLOCK, 0, buckets,
+		sorcery_config_section_hash_hash_fn, NULL, sorcery_config_section_hash_cmp_fn);
+
 	while ((category = ast_category_browse_filtered(cfg, NULL, category, NULL))) {
 		RAII_VAR(void *, obj, NULL, ao2_cleanup);
+		uint64_t section_hash;
+		unsigned int retained = 0;
 		id = ast_category_get_name(category);
 
 		/* If given configuration has not been met skip the category, it is not applicable */
@@ -409,8 +486,31 @@ static void sorcery_config_internal_load(void *data, const struct ast_sorcery *s
 			return;
 		}
 
-		if (!(obj = ast_sorcery_alloc(sorcery, type, id)) ||
-		    ast_sorcery_objectset_apply(sorcery, obj, ast_category_first(category))) {
+		section_hash = sorcery_section_hash(category);
+
+		if (reload && old_hashes) {
+			RAII_VAR(struct sorcery_config_section_hash *, section, NULL, ao2_cleanup);
+
+			section = ao2_find(old_hashes, id, OBJ_SEARCH_KEY);
+			if (section && section->hash == section_hash) {
+				obj = sorcery_config_retrieve_id(sorcery, data, type, id);
+				if (obj && ast_sorcery_object_has_dynamic_contents(obj)) {
+					/* Dynamic contents may expand differently on each load
+					 * so the object must be created again even though the
+					 * raw configuration section has not changed.
+					 */
+					ao2_ref(obj, -1);
+					obj = NULL;
+				}
+				if (obj) {
+					ast_debug(3, "Reusing unchanged object of type '%s' with id '%s' from configuration file '%s'\n",
+						type, id, config->filename);
+				}
+			}
+		}
+
+		if (!obj && (!(obj = ast_sorcery_alloc(sorcery, type, id)) ||
+		    ast_sorcery_objectset_apply(sorcery, obj, ast_category_first(category)))) {
 
 			if (config->file_integrity) {
 				ast_log(LOG_ERROR, "Config file '%s' could not be loaded due to error with object '%s' of type '%s'\n",
@@ -432,6 +532,20 @@ static void sorcery_config_internal_load(void *data, const struct ast_sorcery *s
 			}
 
 			ast_log(LOG_NOTICE, "Retaining existing configuration for object of type '%s' with id '%s'\n", type, id);
+			retained = 1;
+		}
+
+		/* A retained object does not reflect the section as it is on disk so
+		 * no hash is recorded for it, forcing a rebuild on the next reload.
+		 */
+		if (new_hashes && !retained) {
+			struct sorcery_config_section_hash *section;
+
+			section = sorcery_section_hash_alloc(id, section_hash);
+			if (section) {
+				ao2_link(new_hashes, section);
+				ao2_ref(section, -1);
+			}
 		}
 
 		/* We store the dynamic contents state until the end in case this reload or load
@@ -444,6 +558,7 @@ static void sorcery_config_internal_load(void *data, const struct ast_sorcery *s
 
 	config->has_dynamic_contents = has_dynamic_contents;
 	ao2_global_obj_replace_unref(config->objects, objects);
+	ao2_global_obj_replace_unref(config->section_hashes, new_hashes);
 	ast_config_destroy(cfg);
 }
 
@@ -478,6 +593,7 @@ static void *sorcery_config_open(const char *data)
 	ast_uuid_generate_str(config->uuid, sizeof(config->uuid));
 
 	ast_rwlock_init(&config->objects.lock);
+	ast_rwlock_init(&config->section_hashes.lock);
 	strcpy(config->filename, filename);
 
 	while ((option = strsep(&tmp, ","))) {
@@ -29,6 +29,7 @@
 
 #include "asterisk.h"
 
+#include "asterisk/alertpipe.h"
 #include "asterisk/channel.h"
 #include "asterisk/module.h"
 #include "asterisk/lock.h"
@@ -37,6 +38,7 @@
 #include "asterisk/term.h"
 #include "asterisk/speech.h"
 #include "asterisk/format_cache.h"
+#include "asterisk/translate.h"
 
 static AST_RWLIST_HEAD_STATIC(engines, ast_speech_engine);
 static struct ast_speech_engine *default_engine = NULL;
@@ -149,6 +151,81 @@ int ast_speech_write(struct ast_speech *speech, void *data, int len)
 	return speech->engine->write(speech, data, len);
 }
 
+/*! \brief Write a frame of signed linear audio to be recognized */
+/*! \brief Size of the ring translated audio is pulled through */
+#define SPEECH_TRANS_RING_SIZE 8192
+
+/*! \brief Translate a frame into the engine format and feed it to the engine */
+static int speech_write_translated(struct ast_speech *speech, struct ast_frame *frame)
+{
+	unsigned char *data;
+	size_t len;
+
+	if (!speech->trans_ring) {
+		struct ast_trans_ring *ring;
+
+		ring = ast_calloc(1, sizeof(*ring) + SPEECH_TRANS_RING_SIZE);
+		if (!ring) {
+			return -1;
+		}
+		ast_trans_ring_init(ring, ring + 1, SPEECH_TRANS_RING_SIZE);
+		speech->trans_ring = ring;
+	}
+
+	if (speech->translator
+		&& ast_format_cmp(frame->subclass.format, speech->translator_src) == AST_FORMAT_CMP_NOT_EQUAL) {
+		/* The source format changed out from under us, rebuild */
+		ast_translator_free_path(speech->translator);
+		speech->translator = NULL;
+		ao2_replace(speech->translator_src, NULL);
+	}
+	if (!speech->translator) {
+		speech->translator = ast_translator_build_path(speech->format, frame->subclass.format);
+		if (!speech->translator) {
+			ast_log(LOG_WARNING, "Unable to translate from %s to %s for speech engine '%s'\n",
+				ast_format_get_name(frame->subclass.format),
+				ast_format_get_name(speech->format), speech->engine->name);
+			return -1;
+		}
+		speech->translator_src = ao2_bump(frame->subclass.format);
+	}
+
+	if (ast_translate_ring(speech->translator, frame, 0, speech->trans_ring) < 0) {
+		return -1;
+	}
+
+	/* Feed the engine straight from the ring storage; translated audio
+	 * is never copied into an intermediate frame. */
+	while ((len = ast_trans_ring_peek(speech->trans_ring, &data))) {
+		int res = speech->engine->write(speech, data, len);
+
+		ast_trans_ring_consume(speech->trans_ring, len);
+		if (res) {
+			return res;
+		}
+	}
+
+	return 0;
+}
+
+int ast_speech_write_frame(struct ast_speech *speech, struct ast_frame *frame)
+{
+	/* Make sure the speech engine is ready to accept audio */
+	if (speech->state != AST_SPEECH_STATE_READY)
+		return -1;
+
+	if (speech->format && frame->subclass.format
+		&& ast_format_cmp(frame->subclass.format, speech->format) == AST_FORMAT_CMP_NOT_EQUAL) {
+		return speech_write_translated(speech, frame);
+	}
+
+	if (speech->engine->write_frame) {
+		return speech->engine->write_frame(speech, frame);
+	}
+
+	return speech->engine->write(speech, frame->data.ptr, frame->datalen);
+}
+
 /*! \brief Signal to the engine that DTMF was received */
 int ast_speech_dtmf(struct ast_speech *speech, const char *dtmf)
 {
@@ -213,6 +290,10 @@ struct ast_speech *ast_speech_new(const char *engine_name, const struct ast_form
 	/* Initialize the lock */
 	ast_mutex_init(&new_speech->lock);
 
+	/* If the alert pipe cannot be set up pollable alerts are simply unavailable */
+	ast_alertpipe_clear(new_speech->alert_pipe);
+	ast_alertpipe_init(new_speech->alert_pipe);
+
 	/* Make sure no results are present */
 	new_speech->results = NULL;
 
@@ -247,6 +328,8 @@ int ast_speech_destroy(struct ast_speech *speech)
 	/* Deinitialize the lock */
 	ast_mutex_destroy(&speech->lock);
 
+	ast_alertpipe_close(speech->alert_pipe);
+
 	/* If results exist on the speech structure, destroy them */
 	if (speech->results)
 		ast_speech_results_free(speech->results);
@@ -255,6 +338,12 @@ int ast_speech_destroy(struct ast_speech *speech)
 	if (speech->processing_sound)
 		ast_free(speech->processing_sound);
 
+	if (speech->translator) {
+		ast_translator_free_path(speech->translator);
+	}
+	ao2_cleanup(speech->translator_src);
+	ast_free(speech->trans_ring);
+
 	ao2_ref(speech->format, -1);
 
 	/* Aloha we are done */
@@ -277,9 +366,31 @@ int ast_speech_change_state(struct ast_speech *speech, int state)
 		break;
 	}
 
+	switch (state) {
+	case AST_SPEECH_STATE_WAIT:
+	case AST_SPEECH_STATE_DONE:
+		/* Wake up anyone polling the alert pipe for a state change */
+		ast_alertpipe_write(speech->alert_pipe);
+		break;
+	default:
+		break;
+	}
+
 	return res;
 }
 
+/*! \brief Retrieve a pollable speech state alert file descriptor */
+int ast_speech_get_alert_fd(struct ast_speech *speech)
+{
+	return ast_alertpipe_readfd(speech->alert_pipe);
+}
+
+/*! \brief Acknowledge a state alert after waking on the alert file descriptor */
+void ast_speech_clear_alert(struct ast_speech *speech)
+{
+	ast_alertpipe_read(speech->alert_pipe);
+}
+
 const char *ast_speech_results_type_to_string(enum ast_speech_results_type type)
 {
 	switch (type) {
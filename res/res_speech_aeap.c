@@ -32,6 +32,7 @@
 #include "asterisk/config.h"
 #include "asterisk/format.h"
 #include "asterisk/format_cap.h"
+#include "asterisk/frame.h"
 #include "asterisk/json.h"
 #include "asterisk/module.h"
 #include "asterisk/speech.h"
@@ -45,9 +46,63 @@
 
 #define CONNECTION_TIMEOUT 2000
 
+/*! Milliseconds of audio to accumulate before delivery to the external application */
+#define AUDIO_BATCH_MS 100
+
 #define log_error(obj, fmt, ...) \
 	ast_log(LOG_ERROR, "AEAP speech (%p): " fmt "\n", obj, ##__VA_ARGS__)
 
+/*! \brief Engine data attached to a speech session */
+struct speech_aeap {
+	/*! External application connection (Holds ref) */
+	struct ast_aeap *aeap;
+	/*! Audio accumulated for batch delivery */
+	unsigned char *audio;
+	/*! Bytes of audio accumulated */
+	size_t audio_len;
+	/*! Allocated size of the audio buffer */
+	size_t audio_size;
+	/*! Milliseconds of audio accumulated */
+	unsigned int audio_ms;
+};
+
+static void speech_aeap_destructor(void *obj)
+{
+	struct speech_aeap *sp = obj;
+
+	ao2_cleanup(sp->aeap);
+	ast_free(sp->audio);
+}
+
+static struct ast_aeap *speech_aeap(struct ast_speech *speech)
+{
+	return ((struct speech_aeap *) speech->data)->aeap;
+}
+
+/*!
+ * \internal
+ * \brief Deliver any accumulated audio to the external application
+ *
+ * Audio written to the engine is batched so the transport is woken up
+ * once per AUDIO_BATCH_MS instead of once per frame.  Anything that
+ * must be ordered after the audio (requests, DTMF, raw writes) flushes
+ * the batch first.
+ *
+ * \returns 0 on success, -1 on error
+ */
+static int speech_aeap_flush_audio(struct speech_aeap *sp)
+{
+	int res = 0;
+
+	if (sp->audio_len) {
+		res = ast_aeap_send_binary(sp->aeap, sp->audio, sp->audio_len);
+		sp->audio_len = 0;
+		sp->audio_ms = 0;
+	}
+
+	return res;
+}
+
 static struct ast_json *custom_fields_to_params(const struct ast_variable *variables)
 {
 	const struct ast_variable *i;
@@ -130,8 +185,11 @@ static int speech_aeap_get(struct ast_speech *speech, const char *param, void *d
 		return -1;
 	}
 
+	/* Make sure the application has all the audio written so far. */
+	speech_aeap_flush_audio(speech->data);
+
 	/* send_request handles json ref */
-	return speech_aeap_send_request(speech->data,
+	return speech_aeap_send_request(speech_aeap(speech),
 		"get", ast_json_pack("{s:[s]}", "params", param), data);
 }
 
@@ -160,8 +218,11 @@ static int speech_aeap_set(struct ast_speech *speech, const char *name, const ch
 		return -1;
 	}
 
+	/* Make sure the application has all the audio written so far. */
+	speech_aeap_flush_audio(speech->data);
+
 	/* send_request handles json ref */
-	return speech_aeap_send_request(speech->data,
+	return speech_aeap_send_request(speech_aeap(speech),
 		"set", ast_json_pack("{s:{s:s}}", "params", name, value), NULL);
 }
 
@@ -371,16 +432,25 @@ static struct ast_aeap_params speech_aeap_params = {
 static int speech_aeap_engine_create(struct ast_speech *speech, struct ast_format *format)
 {
 	struct ast_aeap *aeap;
+	struct speech_aeap *sp;
 	struct ast_variable *vars;
 	struct ast_json *json;
 
-	aeap = ast_aeap_create_and_connect_by_id(
+	aeap = ast_aeap_acquire_by_id(
 		speech->engine->name, &speech_aeap_params, CONNECTION_TIMEOUT);
 	if (!aeap) {
 		return -1;
 	}
 
-	speech->data = aeap;
+	sp = ao2_alloc_options(sizeof(*sp), speech_aeap_destructor,
+		AO2_ALLOC_OPT_LOCK_NOLOCK);
+	if (!sp) {
+		ao2_ref(aeap, -1);
+		return -1;
+	}
+	sp->aeap = aeap;
+
+	speech->data = sp;
 
 	/* Don't allow unloading of this module while an external application is in use */
 	ast_module_ref(ast_module_info->self);
@@ -399,7 +469,7 @@ static int speech_aeap_engine_create(struct ast_speech *speech, struct ast_forma
 	}
 
 	/* send_request handles json ref */
-	if (speech_aeap_send_request(speech->data, "setup", json, format)) {
+	if (speech_aeap_send_request(aeap, "setup", json, format)) {
 		ast_module_unref(ast_module_info->self);
 		return -1;
 	}
@@ -415,6 +485,15 @@ static int speech_aeap_engine_create(struct ast_speech *speech, struct ast_forma
 
 static int speech_aeap_engine_destroy(struct ast_speech *speech)
 {
+	struct speech_aeap *sp = speech->data;
+
+	if (sp && sp->aeap) {
+		/* Hand the connection back for reuse by the next session */
+		ast_aeap_user_data_unregister(sp->aeap, "speech");
+		ast_aeap_release_by_id(speech->engine->name, &speech_aeap_params, sp->aeap);
+		sp->aeap = NULL;
+	}
+
 	ao2_ref(speech->engine, -1);
 	ao2_cleanup(speech->data);
 
@@ -425,7 +504,50 @@ static int speech_aeap_engine_destroy(struct ast_speech *speech)
 
 static int speech_aeap_engine_write(struct ast_speech *speech, void *data, int len)
 {
-	return ast_aeap_send_binary(speech->data, data, len);
+	struct speech_aeap *sp = speech->data;
+
+	/* Keep the byte based path ordered with any batched audio. */
+	if (speech_aeap_flush_audio(sp)) {
+		return -1;
+	}
+
+	return ast_aeap_send_binary(sp->aeap, data, len);
+}
+
+static int speech_aeap_engine_write_frame(struct ast_speech *speech, struct ast_frame *frame)
+{
+	struct speech_aeap *sp = speech->data;
+	unsigned int rate;
+
+	if (sp->audio_len + frame->datalen > sp->audio_size) {
+		size_t needed = sp->audio_len + frame->datalen;
+		unsigned char *audio;
+
+		audio = ast_realloc(sp->audio, needed);
+		if (!audio) {
+			/* Don't drop audio; deliver what we have plus this frame. */
+			if (speech_aeap_flush_audio(sp)) {
+				return -1;
+			}
+			return ast_aeap_send_binary(sp->aeap, frame->data.ptr, frame->datalen);
+		}
+		sp->audio = audio;
+		sp->audio_size = needed;
+	}
+
+	memcpy(sp->audio + sp->audio_len, frame->data.ptr, frame->datalen);
+	sp->audio_len += frame->datalen;
+
+	rate = ast_format_get_sample_rate(frame->subclass.format);
+	if (rate) {
+		sp->audio_ms += frame->samples * 1000 / rate;
+	}
+
+	if (sp->audio_ms >= AUDIO_BATCH_MS) {
+		return speech_aeap_flush_audio(sp);
+	}
+
+	return 0;
 }
 
 static int speech_aeap_engine_dtmf(struct ast_speech *speech, const char *dtmf)
@@ -507,6 +629,7 @@ static struct ast_speech_engine *speech_engine_alloc(const char *name)
 	engine->create = speech_aeap_engine_create;
 	engine->destroy = speech_aeap_engine_destroy;
 	engine->write = speech_aeap_engine_write;
+	engine->write_frame = speech_aeap_engine_write_frame;
 	engine->dtmf = speech_aeap_engine_dtmf;
 	engine->start = speech_aeap_engine_start;
 	engine->change = speech_aeap_engine_change;
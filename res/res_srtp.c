@@ -89,7 +89,7 @@ static int ast_srtp_add_stream(struct ast_srtp *srtp, struct ast_srtp_policy *po
 static int ast_srtp_change_source(struct ast_srtp *srtp, unsigned int from_ssrc, unsigned int to_ssrc);
 
 static int ast_srtp_unprotect(struct ast_srtp *srtp, void *buf, int *len, int rtcp);
-static int ast_srtp_protect(struct ast_srtp *srtp, void **buf, int *len, int rtcp);
+static int ast_srtp_protect(struct ast_srtp *srtp, void **buf, int *len, int rtcp, size_t avail);
 static void ast_srtp_set_cb(struct ast_srtp *srtp, const struct ast_srtp_cb *cb, void *data);
 static int ast_srtp_get_random(unsigned char *key, size_t len);
 
@@ -485,7 +485,7 @@ tryagain:
 	return *len;
 }
 
-static int ast_srtp_protect(struct ast_srtp *srtp, void **buf, int *len, int rtcp)
+static int ast_srtp_protect(struct ast_srtp *srtp, void **buf, int *len, int rtcp, size_t avail)
 {
 	int res;
 	unsigned char *localbuf;
@@ -496,13 +496,20 @@ static int ast_srtp_protect(struct ast_srtp *srtp, void **buf, int *len, int rtc
 		return -1;
 	}
 
-	if ((*len + SRTP_MAX_TRAILER_LEN) > sizeof(srtp->buf)) {
-		return -1;
-	}
+	if (avail >= (size_t)*len + SRTP_MAX_TRAILER_LEN + (rtcp ? 4 : 0)) {
+		/* The caller composed the packet with enough tail room for the
+		 * authentication trailer, so encrypt it where it sits rather
+		 * than paying for a copy through our own buffer. */
+		localbuf = *buf;
+	} else {
+		if ((*len + SRTP_MAX_TRAILER_LEN) > sizeof(srtp->buf)) {
+			return -1;
+		}
 
-	localbuf = rtcp ? srtp->rtcpbuf : srtp->buf;
+		localbuf = rtcp ? srtp->rtcpbuf : srtp->buf;
 
-	memcpy(localbuf, *buf, *len);
+		memcpy(localbuf, *buf, *len);
+	}
 
 	if ((res = rtcp ? srtp_protect_rtcp(srtp->session, localbuf, len) : srtp_protect(srtp->session, localbuf, len)) != err_status_ok && res != err_status_replay_fail) {
 		ast_log(LOG_WARNING, "SRTP protect: %s\n", srtp_errstr(res));
@@ -2202,6 +2202,8 @@ static int unload_module(void)
 
 	stasis_app_control_shutdown();
 
+	app_talk_coalesce_shutdown();
+
 	ao2_cleanup(apps_registry);
 	apps_registry = NULL;
 
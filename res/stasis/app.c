@@ -31,11 +31,13 @@
 
 #include "asterisk/callerid.h"
 #include "asterisk/cli.h"
+#include "asterisk/sched.h"
 #include "asterisk/stasis_app.h"
 #include "asterisk/stasis_bridges.h"
 #include "asterisk/stasis_channels.h"
 #include "asterisk/stasis_endpoints.h"
 #include "asterisk/stasis_message_router.h"
+#include "asterisk/vector.h"
 
 #define BRIDGE_ALL "__AST_BRIDGE_ALL_TOPIC"
 #define CHANNEL_ALL "__AST_CHANNEL_ALL_TOPIC"
@@ -44,6 +46,10 @@
 /*! Global debug flag.  No need for locking */
 int global_debug;
 
+/*! Scheduler used to flush coalesced talk transitions.  Created on first use. */
+static struct ast_sched_context *talk_sched;
+AST_MUTEX_DEFINE_STATIC(talk_sched_lock);
+
 static int unsubscribe(struct stasis_app *app, const char *kind, const char *id, int terminate);
 
 struct stasis_app {
@@ -69,6 +75,16 @@ struct stasis_app {
 	struct ast_json *events_allowed;
 	/*! An array of disallowed events types for this application */
 	struct ast_json *events_disallowed;
+	/*! Talk detection coalescing window in milliseconds (zero disables) */
+	unsigned int talk_coalesce_window;
+	/*! Per-channel talk transition state used while coalescing */
+	struct ao2_container *talk_states;
+	/*! Lock protecting the compiled route table */
+	ast_rwlock_t route_lock;
+	/*! Sorted hashes of subscribed resource ids, recompiled on (un)subscribe */
+	AST_VECTOR(, unsigned int) route_hashes;
+	/*! Zero if the route table could not be compiled and probes must pass */
+	int route_valid;
 	/*! Name of the Stasis application */
 	char name[];
 };
@@ -95,6 +111,78 @@ struct app_forwards {
 	char id[];
 };
 
+/*! \brief Compare two resource id hashes for the sorted route table. */
+#define route_hash_cmp(a, b) ((a) < (b) ? -1 : (a) > (b))
+
+/*!
+ * \internal
+ * \brief Recompile the flat routing table from the forwards container.
+ *
+ * \pre app->forwards is locked
+ */
+static void app_route_table_rebuild(struct stasis_app *app)
+{
+	struct ao2_iterator iter;
+	struct app_forwards *forwards;
+
+	ast_rwlock_wrlock(&app->route_lock);
+	AST_VECTOR_RESET(&app->route_hashes, AST_VECTOR_ELEM_CLEANUP_NOOP);
+	app->route_valid = 1;
+	iter = ao2_iterator_init(app->forwards, AO2_ITERATOR_DONTLOCK);
+	while ((forwards = ao2_iterator_next(&iter))) {
+		if (AST_VECTOR_ADD_SORTED(&app->route_hashes,
+				ast_str_hash(forwards->id), route_hash_cmp)) {
+			/* Probes must confirm against the container anyway, so an
+			 * incomplete table is marked invalid rather than wrong. */
+			app->route_valid = 0;
+			ao2_ref(forwards, -1);
+			break;
+		}
+		ao2_ref(forwards, -1);
+	}
+	ao2_iterator_destroy(&iter);
+	ast_rwlock_unlock(&app->route_lock);
+}
+
+/*!
+ * \internal
+ * \brief Cheap probe of the compiled routing table.
+ *
+ * \retval 0 The app has no subscription matching the id.
+ * \retval 1 The app may be subscribed.  Hashes can collide, so a hit must
+ *           be confirmed against the forwards container.
+ */
+static int app_route_probe(struct stasis_app *app, const char *id)
+{
+	unsigned int hash = ast_str_hash(id);
+	size_t lo = 0;
+	size_t hi;
+	int found = 0;
+
+	ast_rwlock_rdlock(&app->route_lock);
+	if (!app->route_valid) {
+		ast_rwlock_unlock(&app->route_lock);
+		return 1;
+	}
+	hi = AST_VECTOR_SIZE(&app->route_hashes);
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		unsigned int probe = AST_VECTOR_GET(&app->route_hashes, mid);
+
+		if (probe == hash) {
+			found = 1;
+			break;
+		} else if (probe < hash) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	ast_rwlock_unlock(&app->route_lock);
+
+	return found;
+}
+
 static void forwards_dtor(void *obj)
 {
 #ifdef AST_DEVMODE
@@ -305,6 +393,8 @@ static void app_dtor(void *obj)
 	app->topic = NULL;
 	ao2_cleanup(app->forwards);
 	app->forwards = NULL;
+	ao2_cleanup(app->talk_states);
+	app->talk_states = NULL;
 	ao2_cleanup(app->data);
 	app->data = NULL;
 
@@ -313,6 +403,8 @@ static void app_dtor(void *obj)
 	ast_json_unref(app->events_disallowed);
 	app->events_disallowed = NULL;
 
+	AST_VECTOR_FREE(&app->route_hashes);
+	ast_rwlock_destroy(&app->route_lock);
 }
 
 static void call_forwarded_handler(struct stasis_app *app, struct stasis_message *message)
@@ -367,6 +459,232 @@ static void sub_default_handler(void *data, struct stasis_subscription *sub,
 	ast_json_unref(json);
 }
 
+/*! \brief Per-channel talk transition state for a coalescing application */
+struct app_talk_state {
+	/*! Last talking state delivered to the app, or -1 until one is sent */
+	int last_sent;
+	/*! When the last transition was delivered */
+	struct timeval last_sent_time;
+	/*! Suppressed transition waiting for the window to expire */
+	struct stasis_message *pending;
+	/*! Scheduler id of the pending flush, or -1 */
+	int sched_id;
+	/*! App the state belongs to */
+	struct stasis_app *app;
+	/*! Unique id of the channel */
+	char id[];
+};
+
+static void talk_state_dtor(void *obj)
+{
+	struct app_talk_state *state = obj;
+
+	ast_assert(state->pending == NULL);
+
+	ao2_cleanup(state->app);
+	state->app = NULL;
+}
+
+static int talk_state_sort(const void *obj_left, const void *obj_right, int flags)
+{
+	const struct app_talk_state *object_left = obj_left;
+	const struct app_talk_state *object_right = obj_right;
+	const char *right_key = obj_right;
+	int cmp;
+
+	switch (flags & (OBJ_POINTER | OBJ_KEY | OBJ_PARTIAL_KEY)) {
+	case OBJ_POINTER:
+		right_key = object_right->id;
+		/* Fall through */
+	case OBJ_KEY:
+		cmp = strcmp(object_left->id, right_key);
+		break;
+	case OBJ_PARTIAL_KEY:
+		cmp = strncmp(object_left->id, right_key, strlen(right_key));
+		break;
+	default:
+		/* Sort can only work on something with a full or partial key. */
+		ast_assert(0);
+		cmp = 0;
+		break;
+	}
+	return cmp;
+}
+
+/*! \brief Create the flush scheduler on first use */
+static int talk_sched_start(void)
+{
+	ast_mutex_lock(&talk_sched_lock);
+	if (!talk_sched) {
+		talk_sched = ast_sched_context_create();
+		if (talk_sched && ast_sched_start_thread(talk_sched)) {
+			ast_sched_context_destroy(talk_sched);
+			talk_sched = NULL;
+		}
+	}
+	ast_mutex_unlock(&talk_sched_lock);
+
+	return talk_sched ? 0 : -1;
+}
+
+void app_talk_coalesce_shutdown(void)
+{
+	ast_mutex_lock(&talk_sched_lock);
+	if (talk_sched) {
+		ast_sched_context_destroy(talk_sched);
+		talk_sched = NULL;
+	}
+	ast_mutex_unlock(&talk_sched_lock);
+}
+
+/*!
+ * \internal
+ * \brief Deliver a transition that outlived the coalescing window.
+ *
+ * Runs on the flush scheduler's thread with a reference to the state.
+ */
+static int talk_state_flush(const void *data)
+{
+	struct app_talk_state *state = (struct app_talk_state *) data;
+	struct stasis_message *pending;
+	struct ast_json *json = NULL;
+
+	ao2_lock(state);
+	state->sched_id = -1;
+	pending = state->pending;
+	state->pending = NULL;
+	if (pending) {
+		int talking = stasis_message_type(pending) == ast_channel_talking_start();
+
+		if (talking != state->last_sent) {
+			state->last_sent = talking;
+			state->last_sent_time = ast_tvnow();
+			json = stasis_message_to_json(pending, stasis_app_get_sanitizer());
+		}
+	}
+	ao2_unlock(state);
+
+	if (json) {
+		app_send(state->app, json);
+		ast_json_unref(json);
+	}
+	ao2_cleanup(pending);
+
+	ao2_ref(state, -1);
+	return 0;
+}
+
+/*! \brief Drop any pending transition and cancel the flush for a state */
+static void talk_state_cancel(struct app_talk_state *state)
+{
+	ao2_lock(state);
+	ao2_cleanup(state->pending);
+	state->pending = NULL;
+	if (state->sched_id > -1 && !ast_sched_del(talk_sched, state->sched_id)) {
+		/* We beat the flush to the punch; drop its reference */
+		ao2_ref(state, -1);
+	}
+	state->sched_id = -1;
+	ao2_unlock(state);
+}
+
+static int talk_state_cancel_cb(void *obj, void *arg, int flags)
+{
+	talk_state_cancel(obj);
+	return CMP_MATCH;
+}
+
+/*! \brief Forget coalescing state for a channel that left the system */
+static void talk_state_remove(struct stasis_app *app, const char *id)
+{
+	struct app_talk_state *state;
+
+	state = ao2_find(app->talk_states, id, OBJ_SEARCH_KEY | OBJ_UNLINK);
+	if (!state) {
+		return;
+	}
+
+	talk_state_cancel(state);
+	ao2_ref(state, -1);
+}
+
+/*!
+ * \internal
+ * \brief Coalesce ChannelTalkingStarted/ChannelTalkingFinished transitions.
+ *
+ * func_talkdetect's DSP reports every transition, and in noisy audio that
+ * means storms of starts and stops a few milliseconds apart.  While the
+ * application's coalescing window is set, a transition is delivered
+ * immediately only if the previous delivery is at least a window old;
+ * otherwise it is held back and flushed when the window closes, unless the
+ * channel flaps back to the state the app already believes in the meantime.
+ */
+static void sub_channel_talking_handler(void *data, struct stasis_subscription *sub,
+	struct stasis_message *message)
+{
+	struct stasis_app *app = data;
+	struct ast_channel_blob *blob = stasis_message_data(message);
+	int talking = stasis_message_type(message) == ast_channel_talking_start();
+	unsigned int window = app->talk_coalesce_window;
+	struct app_talk_state *state;
+	struct ast_json *json = NULL;
+	int64_t since;
+
+	if (!window || !blob->snapshot) {
+		sub_default_handler(data, sub, message);
+		return;
+	}
+
+	state = ao2_find(app->talk_states, blob->snapshot->base->uniqueid, OBJ_SEARCH_KEY);
+	if (!state) {
+		state = ao2_alloc(sizeof(*state) + strlen(blob->snapshot->base->uniqueid) + 1,
+			talk_state_dtor);
+		if (!state) {
+			sub_default_handler(data, sub, message);
+			return;
+		}
+		strcpy(state->id, blob->snapshot->base->uniqueid); /* SAFE */
+		state->last_sent = -1;
+		state->sched_id = -1;
+		state->app = ao2_bump(app);
+		ao2_link(app->talk_states, state);
+	}
+
+	ao2_lock(state);
+	since = state->last_sent == -1
+		? -1 : ast_tvdiff_ms(ast_tvnow(), state->last_sent_time);
+	if (talking == state->last_sent) {
+		/* Flapped back to the reported state; forget the rebound */
+		ao2_cleanup(state->pending);
+		state->pending = NULL;
+	} else if (state->last_sent == -1 || since >= window) {
+		state->last_sent = talking;
+		state->last_sent_time = ast_tvnow();
+		ao2_cleanup(state->pending);
+		state->pending = NULL;
+		json = stasis_message_to_json(message, stasis_app_get_sanitizer());
+	} else {
+		/* Within the hold-off; keep the newest transition and flush it if
+		 * it is still standing when the window closes. */
+		ao2_replace(state->pending, message);
+		if (state->sched_id == -1 && !talk_sched_start()) {
+			ao2_ref(state, +1);
+			state->sched_id = ast_sched_add(talk_sched, (int) (window - since),
+				talk_state_flush, state);
+			if (state->sched_id == -1) {
+				ao2_ref(state, -1);
+			}
+		}
+	}
+	ao2_unlock(state);
+
+	if (json) {
+		app_send(app, json);
+		ast_json_unref(json);
+	}
+	ao2_ref(state, -1);
+}
+
 /*! \brief Typedef for callbacks that get called on channel snapshot updates */
 typedef struct ast_json *(*channel_snapshot_monitor)(
 	struct ast_channel_snapshot *old_snapshot,
@@ -560,6 +878,7 @@ static void sub_channel_update_handler(void *data,
 	}
 
 	if (ast_test_flag(&update->new_snapshot->flags, AST_FLAG_DEAD)) {
+		talk_state_remove(app, update->new_snapshot->base->uniqueid);
 		unsubscribe(app, "channel", update->new_snapshot->base->uniqueid, 1);
 	}
 }
@@ -721,6 +1040,10 @@ static int bridge_app_subscribed(struct stasis_app *app, const char *uniqueid)
 {
 	struct app_forwards *forwards = NULL;
 
+	if (!app_route_probe(app, uniqueid)) {
+		return 0;
+	}
+
 	forwards = ao2_find(app->forwards, uniqueid, OBJ_SEARCH_KEY);
 	if (!forwards) {
 		return 0;
@@ -860,6 +1183,32 @@ void stasis_app_set_debug_by_name(const char *app_name, int debug)
 	ao2_cleanup(app);
 }
 
+void stasis_app_set_talk_coalesce(struct stasis_app *app, unsigned int window_ms)
+{
+	if (!app) {
+		return;
+	}
+
+	app->talk_coalesce_window = window_ms;
+}
+
+void stasis_app_set_talk_coalesce_by_name(const char *app_name, unsigned int window_ms)
+{
+	struct stasis_app *app = stasis_app_get_by_name(app_name);
+
+	if (!app) {
+		return;
+	}
+
+	app->talk_coalesce_window = window_ms;
+	ao2_cleanup(app);
+}
+
+unsigned int stasis_app_get_talk_coalesce(struct stasis_app *app)
+{
+	return app ? app->talk_coalesce_window : 0;
+}
+
 int stasis_app_get_debug(struct stasis_app *app)
 {
 	return (app ? app->debug : 0) || global_debug;
@@ -941,6 +1290,19 @@ struct stasis_app *app_create(const char *name, stasis_app_cb handler, void *dat
 		return NULL;
 	}
 
+	app->talk_states = ao2_container_alloc_rbtree(AO2_ALLOC_OPT_LOCK_MUTEX,
+		AO2_CONTAINER_ALLOC_OPT_DUPS_REJECT,
+		talk_state_sort, NULL);
+	if (!app->talk_states) {
+		return NULL;
+	}
+
+	ast_rwlock_init(&app->route_lock);
+	if (AST_VECTOR_INIT(&app->route_hashes, 0)) {
+		return NULL;
+	}
+	app->route_valid = 1;
+
 	ret = ast_asprintf(&topic_name, "ari:application/%s", name);
 	if (ret < 0) {
 		return NULL;
@@ -986,6 +1348,12 @@ struct stasis_app *app_create(const char *name, stasis_app_cb handler, void *dat
 	res |= stasis_message_router_add(app->router,
 		ast_channel_snapshot_type(), sub_channel_update_handler, app);
 
+	res |= stasis_message_router_add(app->router,
+		ast_channel_talking_start(), sub_channel_talking_handler, app);
+
+	res |= stasis_message_router_add(app->router,
+		ast_channel_talking_stop(), sub_channel_talking_handler, app);
+
 	res |= stasis_message_router_add_cache_update(app->router,
 		ast_endpoint_snapshot_type(), sub_endpoint_update_handler, app);
 
@@ -1084,6 +1452,11 @@ void app_shutdown(struct stasis_app *app)
 	app->endpoint_router = NULL;
 
 	ao2_unlock(app);
+
+	/* Cancel pending talk transition flushes; the states hold app
+	 * references that would otherwise keep the app alive. */
+	ao2_callback(app->talk_states, OBJ_UNLINK | OBJ_NODATA | OBJ_MULTIPLE,
+		talk_state_cancel_cb, NULL);
 }
 
 int app_is_active(struct stasis_app *app)
@@ -1175,9 +1548,11 @@ void stasis_app_to_cli(const struct stasis_app *app, struct ast_cli_args *a)
 
 	ast_cli(a->fd, "Name: %s\n"
 		"  Debug: %s\n"
+		"  Talk coalescing window: %u ms\n"
 		"  Subscription Model: %s\n",
 		app->name,
 		app->debug ? "Yes" : "No",
+		app->talk_coalesce_window,
 		app->subscription_model == STASIS_APP_SUBSCRIBE_ALL ?
 			"Global Resource Subscription" :
 			"Application/Explicit Resource Subscription");
@@ -1312,6 +1687,8 @@ int app_subscribe_channel(struct stasis_app *app, struct ast_channel *chan)
 
 			return -1;
 		}
+
+		app_route_table_rebuild(app);
 	}
 
 	++forwards->interested;
@@ -1365,6 +1742,7 @@ static int unsubscribe(struct stasis_app *app, const char *kind, const char *id,
 		ao2_find(app->forwards, forwards,
 			OBJ_POINTER | OBJ_NOLOCK | OBJ_UNLINK |
 			OBJ_NODATA);
+		app_route_table_rebuild(app);
 
 		if (!strcmp(kind, "endpoint")) {
 			messaging_app_unsubscribe_endpoint(app->name, id);
@@ -1401,6 +1779,10 @@ int app_is_subscribed_channel_id(struct stasis_app *app, const char *channel_id)
 	if (ast_strlen_zero(channel_id)) {
 		channel_id = CHANNEL_ALL;
 	}
+
+	if (!app_route_probe(app, channel_id)) {
+		return 0;
+	}
 	forwards = ao2_find(app->forwards, channel_id, OBJ_SEARCH_KEY);
 	ao2_cleanup(forwards);
 
@@ -1459,6 +1841,8 @@ int app_subscribe_bridge(struct stasis_app *app, struct ast_bridge *bridge)
 
 			return -1;
 		}
+
+		app_route_table_rebuild(app);
 	}
 
 	++forwards->interested;
@@ -1504,6 +1888,10 @@ int app_is_subscribed_bridge_id(struct stasis_app *app, const char *bridge_id)
 		bridge_id = BRIDGE_ALL;
 	}
 
+	if (!app_route_probe(app, bridge_id)) {
+		return 0;
+	}
+
 	forwards = ao2_find(app->forwards, bridge_id, OBJ_SEARCH_KEY);
 	ao2_cleanup(forwards);
 
@@ -1563,6 +1951,8 @@ int app_subscribe_endpoint(struct stasis_app *app, struct ast_endpoint *endpoint
 			return -1;
 		}
 
+		app_route_table_rebuild(app);
+
 		/* Subscribe for messages */
 		messaging_app_subscribe_endpoint(app->name, endpoint, &message_received_handler, app);
 	}
@@ -1600,6 +1990,10 @@ int app_is_subscribed_endpoint_id(struct stasis_app *app, const char *endpoint_i
 	if (ast_strlen_zero(endpoint_id)) {
 		endpoint_id = ENDPOINT_ALL;
 	}
+
+	if (!app_route_probe(app, endpoint_id)) {
+		return 0;
+	}
 	forwards = ao2_find(app->forwards, endpoint_id, OBJ_SEARCH_KEY);
 	ao2_cleanup(forwards);
 
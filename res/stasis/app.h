@@ -70,6 +70,13 @@ struct stasis_app *app_create(const char *name, stasis_app_cb handler, void *dat
  */
 void app_shutdown(struct stasis_app *app);
 
+/*!
+ * \brief Shuts down the talk transition flush scheduler.
+ *
+ * Called when res_stasis unloads, after every app has been shut down.
+ */
+void app_talk_coalesce_shutdown(void);
+
 /*!
  * \brief Deactivates an application.
  *
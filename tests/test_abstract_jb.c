@@ -22,8 +22,8 @@
  *
  * \author \verbatim Matt Jordan <mjordan@digium.com> \endverbatim
  *
- * Tests the abstract jitter buffer API.  This tests both adaptive and fixed
- * jitter buffers.  Functions defined in abstract_jb that are not part of the
+ * Tests the abstract jitter buffer API.  This tests the adaptive, fixed, and
+ * ring jitter buffers.  Functions defined in abstract_jb that are not part of the
  * abstract jitter buffer API are not tested by this unit test.
  *
  * \ingroup tests
@@ -530,6 +530,16 @@ test_put_overflow(AST_JB_FIXED, "fixed", 12)
 
 test_put_out_of_order(AST_JB_FIXED, "fixed", DEFAULT_CONFIG_RESYNC_THRESHOLD)
 
+test_create_nominal(AST_JB_RING, "ring")
+
+test_put_first(AST_JB_RING, "ring")
+
+test_put(AST_JB_RING, "ring")
+
+test_put_overflow(AST_JB_RING, "ring", 12)
+
+test_put_out_of_order(AST_JB_RING, "ring", DEFAULT_CONFIG_RESYNC_THRESHOLD)
+
 static int unload_module(void)
 {
 	AST_TEST_UNREGISTER(TEST_NAME(AST_JB_ADAPTIVE, create));
@@ -544,6 +554,12 @@ static int unload_module(void)
 	AST_TEST_UNREGISTER(TEST_NAME(AST_JB_FIXED, put_overflow));
 	AST_TEST_UNREGISTER(TEST_NAME(AST_JB_FIXED, put_out_of_order));
 
+	AST_TEST_UNREGISTER(TEST_NAME(AST_JB_RING, create));
+	AST_TEST_UNREGISTER(TEST_NAME(AST_JB_RING, put_first));
+	AST_TEST_UNREGISTER(TEST_NAME(AST_JB_RING, put));
+	AST_TEST_UNREGISTER(TEST_NAME(AST_JB_RING, put_overflow));
+	AST_TEST_UNREGISTER(TEST_NAME(AST_JB_RING, put_out_of_order));
+
 	return 0;
 }
 
@@ -561,6 +577,12 @@ static int load_module(void)
 	AST_TEST_REGISTER(TEST_NAME(AST_JB_FIXED, put_overflow));
 	AST_TEST_REGISTER(TEST_NAME(AST_JB_FIXED, put_out_of_order));
 
+	AST_TEST_REGISTER(TEST_NAME(AST_JB_RING, create));
+	AST_TEST_REGISTER(TEST_NAME(AST_JB_RING, put_first));
+	AST_TEST_REGISTER(TEST_NAME(AST_JB_RING, put));
+	AST_TEST_REGISTER(TEST_NAME(AST_JB_RING, put_overflow));
+	AST_TEST_REGISTER(TEST_NAME(AST_JB_RING, put_out_of_order));
+
 	return AST_MODULE_LOAD_SUCCESS;
 }
 
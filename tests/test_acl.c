@@ -433,10 +433,194 @@ acl_cleanup:
 	return res;
 }
 
+AST_TEST_DEFINE(acl_index)
+{
+	struct acl overlap_acl[] = {
+		{ "10.0.0.0/8", "deny" },
+		{ "10.1.0.0/16", "permit" },
+		{ "10.1.2.0/24", "deny" },
+		{ "192.168.1.0/24", "permit" },
+		{ "192.168.0.0/16", "deny" },
+	};
+
+	struct acl v6_acl[] = {
+		{ "::/0", "deny" },
+		{ "fe80::/64", "permit" },
+		{ "fe80::ffff:0:0:0/80", "deny" },
+	};
+
+	/* The non-contiguous netmask cannot be expressed as an address
+	 * range, so this list must refuse to compile even though its other
+	 * rule is indexable, leaving the caller on the linear walk. */
+	struct acl fallback_acl[] = {
+		{ "10.0.0.0/8", "deny" },
+		{ "10.0.0.0/255.0.255.0", "permit" },
+	};
+
+	struct {
+		const char *test_address;
+		int overlap_result;
+		int v6_result;
+	} index_tests[] = {
+		/* Deny nested in a permit nested in a deny: the innermost rule wins */
+		{ "10.1.2.3",                  TACL_D, TACL_A },
+		{ "10.1.5.1",                  TACL_A, TACL_A },
+		{ "10.200.0.1",                TACL_D, TACL_A },
+		/* Covered by no rule at all */
+		{ "172.16.0.1",                TACL_A, TACL_A },
+		/* The later, wider deny outranks the earlier nested permit */
+		{ "192.168.1.5",               TACL_D, TACL_A },
+		{ "192.168.200.1",             TACL_D, TACL_A },
+		/* IPv4-mapped IPv6 addresses must hit the IPv4 rules */
+		{ "::ffff:10.1.2.3",           TACL_D, TACL_A },
+		{ "::ffff:10.1.5.1",           TACL_A, TACL_A },
+		{ "::ffff:172.16.0.1",         TACL_A, TACL_A },
+		{ "fe80::1234",                TACL_A, TACL_A },
+		{ "fe80::ffff:1213:dead:beef", TACL_A, TACL_D },
+		{ "2001:db8::1",               TACL_A, TACL_D },
+	};
+
+	struct {
+		const char *test_address;
+		int fallback_result;
+	} fallback_tests[] = {
+		{ "10.77.0.5", TACL_A },
+		{ "10.77.3.5", TACL_D },
+	};
+
+	struct ast_ha *overlap_ha = NULL;
+	struct ast_ha *v6_ha = NULL;
+	struct ast_ha *fallback_ha = NULL;
+	struct ast_ha_index *overlap_index = NULL;
+	struct ast_ha_index *v6_index = NULL;
+	struct ast_ha_index *fallback_index = NULL;
+	enum ast_test_result_state res = AST_TEST_PASS;
+	int err = 0;
+	int i;
+
+	switch (cmd) {
+	case TEST_INIT:
+		info->name = "acl_index";
+		info->category = "/main/acl/";
+		info->summary = "ACL compiled index unit test";
+		info->description =
+			"Tests that a compiled rule index gives the same verdicts as the "
+			"linear rule walk, and that rule lists the index cannot represent "
+			"refuse to compile";
+		return AST_TEST_NOT_RUN;
+	case TEST_EXECUTE:
+		break;
+	}
+
+	if (build_ha(overlap_acl, ARRAY_LEN(overlap_acl), &overlap_ha, "overlap_ha", &err, test, &res) != 0) {
+		goto acl_index_cleanup;
+	}
+
+	if (build_ha(v6_acl, ARRAY_LEN(v6_acl), &v6_ha, "v6_ha", &err, test, &res) != 0) {
+		goto acl_index_cleanup;
+	}
+
+	if (build_ha(fallback_acl, ARRAY_LEN(fallback_acl), &fallback_ha, "fallback_ha", &err, test, &res) != 0) {
+		goto acl_index_cleanup;
+	}
+
+	if (!(overlap_index = ast_ha_index_compile(overlap_ha))) {
+		ast_test_status_update(test, "Failed to compile index for overlap_ha\n");
+		res = AST_TEST_FAIL;
+		goto acl_index_cleanup;
+	}
+
+	if (!(v6_index = ast_ha_index_compile(v6_ha))) {
+		ast_test_status_update(test, "Failed to compile index for v6_ha\n");
+		res = AST_TEST_FAIL;
+		goto acl_index_cleanup;
+	}
+
+	if ((fallback_index = ast_ha_index_compile(fallback_ha))) {
+		ast_test_status_update(test, "Compiled an index for fallback_ha even though "
+				"its netmask is not representable\n");
+		res = AST_TEST_FAIL;
+		goto acl_index_cleanup;
+	}
+
+	for (i = 0; i < ARRAY_LEN(index_tests); ++i) {
+		struct ast_sockaddr addr;
+		int overlap_res;
+		int v6_res;
+
+		ast_sockaddr_parse(&addr, index_tests[i].test_address, PARSE_PORT_FORBID);
+
+		overlap_res = ast_ha_index_apply(overlap_index, &addr);
+		v6_res = ast_ha_index_apply(v6_index, &addr);
+
+		if (overlap_res != index_tests[i].overlap_result) {
+			ast_test_status_update(test, "Access not as expected to %s on overlap_index. "
+					"Expected %d but got %d instead\n",
+					index_tests[i].test_address, index_tests[i].overlap_result, overlap_res);
+			res = AST_TEST_FAIL;
+			goto acl_index_cleanup;
+		}
+
+		if (overlap_res != ast_apply_ha(overlap_ha, &addr)) {
+			ast_test_status_update(test, "overlap_index and overlap_ha disagree on %s\n",
+					index_tests[i].test_address);
+			res = AST_TEST_FAIL;
+			goto acl_index_cleanup;
+		}
+
+		if (v6_res != index_tests[i].v6_result) {
+			ast_test_status_update(test, "Access not as expected to %s on v6_index. "
+					"Expected %d but got %d instead\n",
+					index_tests[i].test_address, index_tests[i].v6_result, v6_res);
+			res = AST_TEST_FAIL;
+			goto acl_index_cleanup;
+		}
+
+		if (v6_res != ast_apply_ha(v6_ha, &addr)) {
+			ast_test_status_update(test, "v6_index and v6_ha disagree on %s\n",
+					index_tests[i].test_address);
+			res = AST_TEST_FAIL;
+			goto acl_index_cleanup;
+		}
+	}
+
+	for (i = 0; i < ARRAY_LEN(fallback_tests); ++i) {
+		struct ast_sockaddr addr;
+		int fallback_res;
+
+		ast_sockaddr_parse(&addr, fallback_tests[i].test_address, PARSE_PORT_FORBID);
+
+		fallback_res = ast_apply_ha(fallback_ha, &addr);
+		if (fallback_res != fallback_tests[i].fallback_result) {
+			ast_test_status_update(test, "Access not as expected to %s on fallback_ha. "
+					"Expected %d but got %d instead\n",
+					fallback_tests[i].test_address, fallback_tests[i].fallback_result, fallback_res);
+			res = AST_TEST_FAIL;
+			goto acl_index_cleanup;
+		}
+	}
+
+acl_index_cleanup:
+	if (overlap_ha) {
+		ast_free_ha(overlap_ha);
+	}
+	if (v6_ha) {
+		ast_free_ha(v6_ha);
+	}
+	if (fallback_ha) {
+		ast_free_ha(fallback_ha);
+	}
+	ast_ha_index_free(overlap_index);
+	ast_ha_index_free(v6_index);
+	ast_ha_index_free(fallback_index);
+	return res;
+}
+
 static int unload_module(void)
 {
 	AST_TEST_UNREGISTER(invalid_acl);
 	AST_TEST_UNREGISTER(acl);
+	AST_TEST_UNREGISTER(acl_index);
 	return 0;
 }
 
@@ -444,6 +628,7 @@ static int load_module(void)
 {
 	AST_TEST_REGISTER(invalid_acl);
 	AST_TEST_REGISTER(acl);
+	AST_TEST_REGISTER(acl_index);
 	return AST_MODULE_LOAD_SUCCESS;
 }
 
@@ -2049,6 +2049,131 @@ AST_TEST_DEFINE(astobj2_test_perf)
 	return res;
 }
 
+AST_TEST_DEFINE(astobj2_test_compact)
+{
+	int res = AST_TEST_PASS;
+	int compact_destructor_count = 1;
+	int full_destructor_count = 1;
+	struct test_obj *obj = NULL;
+	struct test_obj *full = NULL;
+	struct test_obj *found;
+	struct ao2_container *c1 = NULL;
+	struct ao2_weakproxy *weakproxy = NULL;
+
+	switch (cmd) {
+	case TEST_INIT:
+		info->name = "astobj2_test_compact";
+		info->category = "/main/astobj2/";
+		info->summary = "Test compact header object allocation";
+		info->description =
+			"This test allocates an object with AO2_ALLOC_OPT_COMPACT and checks "
+			"that reference counting, container membership, and the destructor all "
+			"work, and that a compact object refuses to become the target of a "
+			"weakproxy while a full header object accepts it.";
+		return AST_TEST_NOT_RUN;
+	case TEST_EXECUTE:
+		break;
+	}
+
+	obj = ao2_t_alloc_options(sizeof(*obj), test_obj_destructor,
+		AO2_ALLOC_OPT_LOCK_NOLOCK | AO2_ALLOC_OPT_COMPACT, "compact object");
+	if (!obj) {
+		ast_test_status_update(test, "Compact object creation failed.\n");
+		return AST_TEST_FAIL;
+	}
+	obj->destructor_count = &compact_destructor_count;
+	obj->i = 1;
+
+	ao2_t_ref(obj, +1, "bump compact object");
+	if (ao2_ref(obj, 0) != 2) {
+		ast_test_status_update(test, "Compact object ref count %d does not match expected 2.\n",
+			ao2_ref(obj, 0));
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+	ao2_t_ref(obj, -1, "undo bump");
+
+	c1 = ao2_container_alloc_hash(AO2_ALLOC_OPT_LOCK_MUTEX, 0, 17,
+		test_hash_cb, NULL, test_cmp_cb);
+	if (!c1) {
+		ast_test_status_update(test, "Container c1 creation failed.\n");
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+
+	ao2_link(c1, obj);
+	found = ao2_find(c1, &obj->i, OBJ_KEY | OBJ_UNLINK);
+	if (found != obj) {
+		ast_test_status_update(test, "Did not find the compact object in the container.\n");
+		ao2_cleanup(found);
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+	ao2_t_ref(found, -1, "drop find result");
+
+	weakproxy = ao2_t_weakproxy_alloc(sizeof(*weakproxy), NULL, "weakproxy");
+	if (!weakproxy) {
+		ast_test_status_update(test, "Weakproxy creation failed.\n");
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+
+#if !defined(AO2_DEBUG)
+	/* With AO2_DEBUG object statistics every object gets a full header,
+	 * so the refusal can only be checked in normal builds. */
+	if (!ao2_weakproxy_set_object(weakproxy, obj, 0)) {
+		ast_test_status_update(test, "A compact object must not accept a weakproxy.\n");
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+	if (ao2_ref(obj, 0) != 1) {
+		ast_test_status_update(test, "The weakproxy refusal leaked a reference.\n");
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+#endif	/* !defined(AO2_DEBUG) */
+
+	ao2_t_ref(obj, -1, "drop compact object");
+	obj = NULL;
+	if (compact_destructor_count) {
+		ast_test_status_update(test, "The compact object's destructor was not run.\n");
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+
+	full = ao2_t_alloc_options(sizeof(*full), test_obj_destructor,
+		AO2_ALLOC_OPT_LOCK_NOLOCK, "full header object");
+	if (!full) {
+		ast_test_status_update(test, "Full header object creation failed.\n");
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+	full->destructor_count = &full_destructor_count;
+
+	if (ao2_weakproxy_set_object(weakproxy, full, 0)) {
+		ast_test_status_update(test, "A full header object must accept a weakproxy.\n");
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+
+	/* Dropping the last strong reference destroys the object through
+	 * the weakproxy unlink path. */
+	ao2_t_ref(full, -1, "drop full header object");
+	full = NULL;
+	if (full_destructor_count) {
+		ast_test_status_update(test, "The weakproxy target's destructor was not run.\n");
+		res = AST_TEST_FAIL;
+		goto test_cleanup;
+	}
+
+test_cleanup:
+	ao2_cleanup(obj);
+	ao2_cleanup(full);
+	ao2_cleanup(c1);
+	ao2_cleanup(weakproxy);
+	return res;
+}
+
 static int unload_module(void)
 {
 	AST_TEST_UNREGISTER(astobj2_test_1);
@@ -2056,6 +2181,7 @@ static int unload_module(void)
 	AST_TEST_UNREGISTER(astobj2_test_3);
 	AST_TEST_UNREGISTER(astobj2_test_4);
 	AST_TEST_UNREGISTER(astobj2_test_perf);
+	AST_TEST_UNREGISTER(astobj2_test_compact);
 	return 0;
 }
 
@@ -2066,6 +2192,7 @@ static int load_module(void)
 	AST_TEST_REGISTER(astobj2_test_3);
 	AST_TEST_REGISTER(astobj2_test_4);
 	AST_TEST_REGISTER(astobj2_test_perf);
+	AST_TEST_REGISTER(astobj2_test_compact);
 	return AST_MODULE_LOAD_SUCCESS;
 }
 
@@ -181,10 +181,84 @@ AST_TEST_DEFINE(split_hostport)
 	return res;
 }
 
+AST_TEST_DEFINE(address_key)
+{
+	int res = AST_TEST_PASS;
+	struct {
+		const char *left;
+		const char *right;
+		int equal;
+	} test_vals[] = {
+		{ "192.168.1.1:5060", "192.168.1.1:5060", 1 },
+		{ "192.168.1.1:5060", "192.168.1.1:5061", 0 },
+		{ "192.168.1.1:5060", "192.168.1.2:5060", 0 },
+		{ "192.168.1.1:5060", "[::ffff:192.168.1.1]:5060", 1 }, /* IPv4-mapped form */
+		{ "192.168.1.1:5060", "[::ffff:192.168.1.2]:5060", 0 },
+		{ "[2001:db8:8:4::2]:5060", "[2001:db8:8:4::2]:5060", 1 },
+		{ "[2001:db8:8:4::2]:5060", "[2001:db8:8:4::3]:5060", 0 },
+		{ "[2001:db8:8:4::2]:5060", "[2001:db8:8:4::2]:5061", 0 },
+		{ "[2001:db8:8:4::2]:5060", "192.168.1.1:5060", 0 },
+	};
+
+	size_t x;
+
+	switch (cmd) {
+	case TEST_INIT:
+		info->name = "address_key";
+		info->category = "/main/netsock2/";
+		info->summary = "netsock2 ast_sockaddr_to_key() unit test";
+		info->description =
+			"Test that address comparison keys match exactly when "
+			"ast_sockaddr_cmp() considers the addresses equal";
+		return AST_TEST_NOT_RUN;
+	case TEST_EXECUTE:
+		break;
+	}
+
+	for (x = 0; x < ARRAY_LEN(test_vals); x++) {
+		struct ast_sockaddr left;
+		struct ast_sockaddr right;
+		struct ast_sockaddr_key left_key;
+		struct ast_sockaddr_key right_key;
+
+		if (!ast_sockaddr_parse(&left, test_vals[x].left, 0)
+			|| !ast_sockaddr_parse(&right, test_vals[x].right, 0)) {
+			ast_test_status_update(test, "Failed to parse '%s' or '%s'\n",
+				test_vals[x].left, test_vals[x].right);
+			res = AST_TEST_FAIL;
+			continue;
+		}
+
+		if (ast_sockaddr_to_key(&left, &left_key)
+			|| ast_sockaddr_to_key(&right, &right_key)) {
+			ast_test_status_update(test, "Failed to extract a key from '%s' or '%s'\n",
+				test_vals[x].left, test_vals[x].right);
+			res = AST_TEST_FAIL;
+			continue;
+		}
+
+		if ((ast_sockaddr_key_cmp(&left_key, &right_key) == 0) != test_vals[x].equal) {
+			ast_test_status_update(test, "Keys of '%s' and '%s' unexpectedly compared %sequal\n",
+				test_vals[x].left, test_vals[x].right, test_vals[x].equal ? "un" : "");
+			res = AST_TEST_FAIL;
+		}
+
+		/* Keys must agree with ast_sockaddr_cmp() on these addresses */
+		if ((ast_sockaddr_cmp(&left, &right) == 0) != test_vals[x].equal) {
+			ast_test_status_update(test, "ast_sockaddr_cmp() of '%s' and '%s' disagrees with the expected key result\n",
+				test_vals[x].left, test_vals[x].right);
+			res = AST_TEST_FAIL;
+		}
+	}
+
+	return res;
+}
+
 static int unload_module(void)
 {
 	AST_TEST_UNREGISTER(parsing);
 	AST_TEST_UNREGISTER(split_hostport);
+	AST_TEST_UNREGISTER(address_key);
 	return 0;
 }
 
@@ -192,6 +266,7 @@ static int load_module(void)
 {
 	AST_TEST_REGISTER(parsing);
 	AST_TEST_REGISTER(split_hostport);
+	AST_TEST_REGISTER(address_key);
 	return AST_MODULE_LOAD_SUCCESS;
 }
 
@@ -263,6 +263,69 @@ return_cleanup:
 	return res;
 }
 
+static int busy_cb(const void *data)
+{
+	usleep(2000);
+	return 0;
+}
+
+AST_TEST_DEFINE(sched_test_exec_stats)
+{
+	struct ast_sched_context *con;
+	struct ast_str *buf = NULL;
+	enum ast_test_result_state res = AST_TEST_FAIL;
+	int i;
+
+	switch (cmd) {
+	case TEST_INIT:
+		info->name = "sched_test_exec_stats";
+		info->category = "/main/sched/";
+		info->summary = "Test scheduler execution statistics";
+		info->description =
+			"Runs a handful of scheduled callbacks and checks that the "
+			"execution report accounts for all of them.";
+		return AST_TEST_NOT_RUN;
+	case TEST_EXECUTE:
+		break;
+	}
+
+	if (!(con = ast_sched_context_create())) {
+		ast_test_status_update(test,
+				"Test failed - could not create scheduler context\n");
+		return AST_TEST_FAIL;
+	}
+
+	for (i = 0; i < 5; i++) {
+		ast_test_validate_cleanup(test, -1 < ast_sched_add(con, 0, busy_cb, NULL),
+			res, return_cleanup);
+	}
+
+	usleep(50 * 1000);/* Ensure that all the entries are ready to expire */
+	ast_test_validate_cleanup(test, 5 == ast_sched_runq(con), res, return_cleanup);
+
+	if (!(buf = ast_str_create(256))) {
+		ast_test_status_update(test, "Test failed - memory allocation failure\n");
+		goto return_cleanup;
+	}
+
+	ast_sched_exec_report(con, &buf);
+	ast_test_status_update(test, "Execution report:\n%s", ast_str_buffer(buf));
+	ast_test_validate_cleanup(test, strstr(ast_str_buffer(buf), "Executed = 5"),
+		res, return_cleanup);
+	ast_test_validate_cleanup(test, strstr(ast_str_buffer(buf), "Callback (ms):"),
+		res, return_cleanup);
+	ast_test_validate_cleanup(test, strstr(ast_str_buffer(buf), "Late fire (ms):"),
+		res, return_cleanup);
+
+	res = AST_TEST_PASS;
+
+return_cleanup:
+	ast_free(buf);
+	ast_sched_context_destroy(con);
+
+	return res;
+}
+
 static char *handle_cli_sched_bench(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
 {
 	struct ast_sched_context *con;
@@ -337,6 +400,117 @@ return_cleanup:
 	return CLI_SUCCESS;
 }
 
+struct contention_worker {
+	pthread_t thread;
+	struct ast_sched_context *con;
+	unsigned int ops;
+};
+
+static void *contention_worker_run(void *data)
+{
+	struct contention_worker *worker = data;
+	unsigned int i;
+
+	for (i = 0; i < worker->ops; i++) {
+		long when = labs(ast_random()) % 100;
+		int id = ast_sched_add(worker->con, when, sched_cb, NULL);
+
+		if (id > -1 && (i & 1)
+			&& ast_sched_del(worker->con, id)) {
+			/* The entry already ran; nothing to delete. */
+		}
+	}
+
+	return NULL;
+}
+
+static char *handle_cli_sched_bench_contention(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
+{
+	struct ast_sched_context *con;
+	struct contention_worker *workers = NULL;
+	struct ast_str *buf;
+	struct timeval start;
+	unsigned int nthreads, num, i;
+	int64_t elapsed_us;
+
+	switch (cmd) {
+	case CLI_INIT:
+		e->command = "sched benchmark contention";
+		e->usage = ""
+			"Usage: sched benchmark contention <threads> <num>\n"
+			"       Time <threads> threads each adding (and deleting half of)\n"
+			"       <num> entries on one scheduler context while its scheduler\n"
+			"       thread concurrently runs the expiring entries.\n"
+			"";
+		return NULL;
+	case CLI_GENERATE:
+		return NULL;
+	}
+
+	if (a->argc != e->args + 2) {
+		return CLI_SHOWUSAGE;
+	}
+
+	if (sscanf(a->argv[e->args], "%u", &nthreads) != 1 || !nthreads
+		|| sscanf(a->argv[e->args + 1], "%u", &num) != 1) {
+		return CLI_SHOWUSAGE;
+	}
+
+	if (!(con = ast_sched_context_create())) {
+		ast_cli(a->fd, "Test failed - could not create scheduler context\n");
+		return CLI_FAILURE;
+	}
+
+	if (ast_sched_start_thread(con)) {
+		ast_cli(a->fd, "Test failed - could not start scheduler thread\n");
+		goto return_cleanup;
+	}
+
+	if (!(workers = ast_calloc(nthreads, sizeof(*workers)))) {
+		ast_cli(a->fd, "Test failed - memory allocation failure\n");
+		goto return_cleanup;
+	}
+
+	ast_cli(a->fd, "Testing scheduler contention - %u threads each adding %u "
+			"entries at random time intervals from 0 to 100 ms\n", nthreads, num);
+
+	start = ast_tvnow();
+
+	for (i = 0; i < nthreads; i++) {
+		workers[i].con = con;
+		workers[i].ops = num;
+		if (ast_pthread_create(&workers[i].thread, NULL, contention_worker_run,
+				&workers[i])) {
+			ast_cli(a->fd, "Test failed - could not create worker thread\n");
+			nthreads = i;
+			break;
+		}
+	}
+
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+
+	elapsed_us = ast_tvdiff_us(ast_tvnow(), start);
+	ast_cli(a->fd, "Test complete - %" PRIi64 " us (%.0f adds/sec)\n", elapsed_us,
+		elapsed_us ? (double) nthreads * num * 1000000 / elapsed_us : 0.0);
+
+	/* Let the context drain so the execution report covers the run. */
+	usleep(200 * 1000);
+
+	if ((buf = ast_str_create(256))) {
+		ast_sched_exec_report(con, &buf);
+		ast_cli(a->fd, "%s", ast_str_buffer(buf));
+		ast_free(buf);
+	}
+
+return_cleanup:
+	ast_sched_context_destroy(con);
+	ast_free(workers);
+
+	return CLI_SUCCESS;
+}
+
 struct test_obj {
 	ast_mutex_t lock;
 	ast_cond_t cond;
@@ -465,11 +639,13 @@ AST_TEST_DEFINE(sched_test_freebird)
 
 static struct ast_cli_entry cli_sched[] = {
 	AST_CLI_DEFINE(handle_cli_sched_bench, "Benchmark ast_sched add/del performance"),
+	AST_CLI_DEFINE(handle_cli_sched_bench_contention, "Benchmark ast_sched under thread contention"),
 };
 
 static int unload_module(void)
 {
 	AST_TEST_UNREGISTER(sched_test_order);
+	AST_TEST_UNREGISTER(sched_test_exec_stats);
 	AST_TEST_UNREGISTER(sched_test_freebird);
 	ast_cli_unregister_multiple(cli_sched, ARRAY_LEN(cli_sched));
 	return 0;
@@ -478,6 +654,7 @@ static int unload_module(void)
 static int load_module(void)
 {
 	AST_TEST_REGISTER(sched_test_order);
+	AST_TEST_REGISTER(sched_test_exec_stats);
 	AST_TEST_REGISTER(sched_test_freebird);
 	ast_cli_register_multiple(cli_sched, ARRAY_LEN(cli_sched));
 	return AST_MODULE_LOAD_SUCCESS;
@@ -162,6 +162,9 @@ struct sorcery_test_observer {
 
 	/*! \brief Whether the type has been loaded */
 	unsigned int loaded:1;
+
+	/*! \brief Copy of the change set from an update notification */
+	struct ast_variable *changes;
 };
 
 /*! \brief Global scope apply handler integer to make sure it executed */
@@ -280,6 +283,19 @@ static const struct ast_sorcery_observer test_observer = {
 	.loaded = sorcery_observer_loaded,
 };
 
+static void sorcery_observer_updated_with_changes(const void *object, const struct ast_variable *changes)
+{
+	SCOPED_MUTEX(lock, &observer.lock);
+	observer.updated = object;
+	observer.changes = ast_variables_dup((struct ast_variable *)changes);
+	ast_cond_signal(&observer.cond);
+}
+
+/*! \brief Test sorcery observer implementation which is interested in field-level change sets */
+static const struct ast_sorcery_observer test_observer_changes = {
+	.updated_with_changes = sorcery_observer_updated_with_changes,
+};
+
 /*  This handler takes a simple value and creates new list entry for it*/
 static int jim_handler(const struct aco_option *opt, struct ast_variable *var, void *obj)
 {
@@ -2567,6 +2583,104 @@ end:
 	return res;
 }
 
+AST_TEST_DEFINE(observer_update_changes)
+{
+	RAII_VAR(struct ast_sorcery *, sorcery, NULL, ast_sorcery_unref);
+	RAII_VAR(struct test_sorcery_object *, obj, NULL, ao2_cleanup);
+	RAII_VAR(struct test_sorcery_object *, copy, NULL, ao2_cleanup);
+	const struct ast_variable *change;
+	int res = AST_TEST_FAIL, found = 0;
+
+	switch (cmd) {
+	case TEST_INIT:
+		info->name = "observer_update_changes";
+		info->category = "/main/sorcery/";
+		info->summary = "sorcery observer field-level change set unit test";
+		info->description =
+			"Test that an observer interested in field-level change sets receives the fields which changed on update";
+		return AST_TEST_NOT_RUN;
+	case TEST_EXECUTE:
+		break;
+	}
+
+	if (!(sorcery = alloc_and_initialize_sorcery())) {
+		ast_test_status_update(test, "Failed to open sorcery structure\n");
+		return AST_TEST_FAIL;
+	}
+
+	if (ast_sorcery_observer_add(sorcery, "test", &test_observer_changes)) {
+		ast_test_status_update(test, "Failed to add a proper observer\n");
+		return AST_TEST_FAIL;
+	}
+
+	if (!(obj = ast_sorcery_alloc(sorcery, "test", "blah"))) {
+		ast_test_status_update(test, "Failed to allocate a known object type\n");
+		return AST_TEST_FAIL;
+	}
+
+	ast_mutex_init(&observer.lock);
+	ast_cond_init(&observer.cond, NULL);
+	observer.updated = NULL;
+	observer.changes = NULL;
+
+	if (ast_sorcery_create(sorcery, obj)) {
+		ast_test_status_update(test, "Failed to create object using in-memory wizard\n");
+		goto end;
+	}
+
+	if (!(copy = ast_sorcery_copy(sorcery, obj))) {
+		ast_test_status_update(test, "Failed to create a copy of the object\n");
+		goto end;
+	}
+
+	copy->bob = 1000;
+
+	if (ast_sorcery_update(sorcery, copy)) {
+		ast_test_status_update(test, "Failed to update object using in-memory wizard\n");
+		goto end;
+	}
+
+	ast_mutex_lock(&observer.lock);
+	while (!observer.updated) {
+        struct timeval start = ast_tvnow();
+        struct timespec end = {
+                .tv_sec = start.tv_sec + 10,
+                .tv_nsec = start.tv_usec * 1000,
+        };
+		if (ast_cond_timedwait(&observer.cond, &observer.lock, &end) == ETIMEDOUT) {
+			break;
+		}
+	}
+	ast_mutex_unlock(&observer.lock);
+
+	if (!observer.updated) {
+		ast_test_status_update(test, "Failed to receive observer notification for object updating within suitable timeframe\n");
+		goto end;
+	}
+
+	for (change = observer.changes; change; change = change->next) {
+		if (!strcmp(change->name, "bob")) {
+			found = 1;
+		}
+	}
+
+	if (!found) {
+		ast_test_status_update(test, "Change set did not contain the field which was modified\n");
+		goto end;
+	}
+
+	res = AST_TEST_PASS;
+
+end:
+	ast_variables_destroy(observer.changes);
+	observer.changes = NULL;
+	observer.updated = NULL;
+	ast_mutex_destroy(&observer.lock);
+	ast_cond_destroy(&observer.cond);
+
+	return res;
+}
+
 AST_TEST_DEFINE(configuration_file_wizard)
 {
 	struct ast_flags flags = { CONFIG_FLAG_NOCACHE };
@@ -3668,6 +3782,7 @@ static int unload_module(void)
 	AST_TEST_UNREGISTER(object_is_stale);
 	AST_TEST_UNREGISTER(caching_wizard_behavior);
 	AST_TEST_UNREGISTER(object_type_observer);
+	AST_TEST_UNREGISTER(observer_update_changes);
 	AST_TEST_UNREGISTER(configuration_file_wizard);
 	AST_TEST_UNREGISTER(configuration_file_wizard_with_file_integrity);
 	AST_TEST_UNREGISTER(configuration_file_wizard_with_criteria);
@@ -3726,6 +3841,7 @@ static int load_module(void)
 	AST_TEST_REGISTER(object_is_stale);
 	AST_TEST_REGISTER(caching_wizard_behavior);
 	AST_TEST_REGISTER(object_type_observer);
+	AST_TEST_REGISTER(observer_update_changes);
 	AST_TEST_REGISTER(configuration_file_wizard);
 	AST_TEST_REGISTER(configuration_file_wizard_with_file_integrity);
 	AST_TEST_REGISTER(configuration_file_wizard_with_criteria);
@@ -439,6 +439,75 @@ AST_TEST_DEFINE(stream_topology_clone)
 	return AST_TEST_PASS;
 }
 
+AST_TEST_DEFINE(stream_topology_hash)
+{
+	RAII_VAR(struct ast_stream_topology *, topology, NULL, ast_stream_topology_free);
+	RAII_VAR(struct ast_stream_topology *, cloned, NULL, ast_stream_topology_free);
+	struct ast_stream *audio_stream, *video_stream;
+
+	switch (cmd) {
+	case TEST_INIT:
+		info->name = "stream_topology_hash";
+		info->category = "/main/stream/";
+		info->summary = "stream topology hashing unit test";
+		info->description =
+			"Test that equal stream topologies hash to the same value and that changing a stream changes the hash";
+		return AST_TEST_NOT_RUN;
+	case TEST_EXECUTE:
+		break;
+	}
+
+	topology = ast_stream_topology_alloc();
+	if (!topology) {
+		ast_test_status_update(test, "Failed to create media stream topology\n");
+		return AST_TEST_FAIL;
+	}
+
+	audio_stream = ast_stream_alloc("audio", AST_MEDIA_TYPE_AUDIO);
+	if (!audio_stream) {
+		ast_test_status_update(test, "Failed to create an audio stream for testing stream topology\n");
+		return AST_TEST_FAIL;
+	}
+
+	if (ast_stream_topology_append_stream(topology, audio_stream) == -1) {
+		ast_test_status_update(test, "Failed to append valid audio stream to stream topology\n");
+		ast_stream_free(audio_stream);
+		return AST_TEST_FAIL;
+	}
+
+	video_stream = ast_stream_alloc("video", AST_MEDIA_TYPE_VIDEO);
+	if (!video_stream) {
+		ast_test_status_update(test, "Failed to create a video stream for testing stream topology\n");
+		return AST_TEST_FAIL;
+	}
+
+	if (ast_stream_topology_append_stream(topology, video_stream) == -1) {
+		ast_test_status_update(test, "Failed to append valid video stream to stream topology\n");
+		ast_stream_free(video_stream);
+		return AST_TEST_FAIL;
+	}
+
+	cloned = ast_stream_topology_clone(topology);
+	if (!cloned) {
+		ast_test_status_update(test, "Failed to clone a perfectly good stream topology\n");
+		return AST_TEST_FAIL;
+	}
+
+	if (ast_stream_topology_hash(cloned) != ast_stream_topology_hash(topology)) {
+		ast_test_status_update(test, "Cloned stream topology does not hash the same as the original\n");
+		return AST_TEST_FAIL;
+	}
+
+	ast_stream_set_state(ast_stream_topology_get_stream(cloned, 1), AST_STREAM_STATE_REMOVED);
+
+	if (ast_stream_topology_hash(cloned) == ast_stream_topology_hash(topology)) {
+		ast_test_status_update(test, "Changed stream topology still hashes the same as the original\n");
+		return AST_TEST_FAIL;
+	}
+
+	return AST_TEST_PASS;
+}
+
 AST_TEST_DEFINE(stream_topology_append_stream)
 {
 	RAII_VAR(struct ast_stream_topology *, topology, NULL, ast_stream_topology_free);
@@ -2261,6 +2330,7 @@ static int unload_module(void)
 	AST_TEST_UNREGISTER(stream_topology_create);
 	AST_TEST_UNREGISTER(stream_topology_clone);
 	AST_TEST_UNREGISTER(stream_topology_clone);
+	AST_TEST_UNREGISTER(stream_topology_hash);
 	AST_TEST_UNREGISTER(stream_topology_append_stream);
 	AST_TEST_UNREGISTER(stream_topology_set_stream);
 	AST_TEST_UNREGISTER(stream_topology_del_stream);
@@ -2291,6 +2361,7 @@ static int load_module(void)
 	AST_TEST_REGISTER(stream_metadata);
 	AST_TEST_REGISTER(stream_topology_create);
 	AST_TEST_REGISTER(stream_topology_clone);
+	AST_TEST_REGISTER(stream_topology_hash);
 	AST_TEST_REGISTER(stream_topology_append_stream);
 	AST_TEST_REGISTER(stream_topology_set_stream);
 	AST_TEST_REGISTER(stream_topology_del_stream);